@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+// This program measures the cost of the transport endpoint lookups
+// done by Ipv4EndPointDemux on a busy server.
+//
+// The demux holds a listening endpoint on port 80, a number of
+// connections accepted on this port (10000 by default) and as many
+// endpoints bound to their own port, as UDP sockets would be. The
+// program then looks up the endpoint of a random connection for every
+// simulated segment, and once per connection it also sets up and
+// tears down a connection, as a forked TCP socket would.
+//
+// The program prints the wall clock time of the lookups and of the
+// connection churn.
+//
+
+#include "ns3/core-module.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/private/ipv4-end-point.h"
+#include "ns3/private/ipv4-end-point-demux.h"
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+int main (int argc, char *argv[])
+{
+  uint32_t nEndPoints = 10000;
+  uint32_t nLookups = 1000000;
+
+  CommandLine cmd;
+  cmd.AddValue ("nEndPoints", "Number of connections and of bound endpoints", nEndPoints);
+  cmd.AddValue ("nLookups", "Number of lookups", nLookups);
+  cmd.Parse (argc, argv);
+
+  Ipv4Address server ("10.0.0.1");
+  Ptr<Ipv4Interface> interface = CreateObject<Ipv4Interface> ();
+  interface->AddAddress (Ipv4InterfaceAddress (server, Ipv4Mask ("255.0.0.0")));
+
+  Ipv4EndPointDemux demux;
+  demux.Allocate (80);
+  std::vector<Ipv4Address> clients;
+  std::vector<uint16_t> clientPorts;
+  for (uint32_t i = 0; i < nEndPoints; i++)
+    {
+      Ipv4Address client (0x0a010000 + i / 100);
+      uint16_t clientPort = 1024 + i % 100;
+      demux.Allocate (server, 80, client, clientPort);
+      clients.push_back (client);
+      clientPorts.push_back (clientPort);
+      demux.Allocate (server, 1024 + i);
+    }
+
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  SystemWallClockMs clock;
+  clock.Start ();
+  uint32_t found = 0;
+  for (uint32_t i = 0; i < nLookups; i++)
+    {
+      uint32_t connection = random->GetInteger (0, nEndPoints - 1);
+      Ipv4EndPointDemux::EndPoints endPoints =
+        demux.Lookup (server, 80, clients[connection], clientPorts[connection], interface);
+      found += endPoints.size ();
+    }
+  int64_t lookups = clock.End ();
+
+  clock.Start ();
+  for (uint32_t i = 0; i < nEndPoints; i++)
+    {
+      Ipv4EndPoint *endPoint = demux.Allocate (server, 80, Ipv4Address ("10.2.0.1"), 1024);
+      demux.DeAllocate (endPoint);
+    }
+  int64_t churn = clock.End ();
+
+  std::cout << "endpoints=" << 2 * nEndPoints + 1
+            << " lookups=" << nLookups
+            << " matches=" << found
+            << " lookup wall clock=" << lookups << "ms"
+            << " churn wall clock=" << churn << "ms" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,114 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+// This program measures the cost of computing the global routes of a
+// large topology, and of updating them after link failures.
+//
+// The routers (1000 by default) are split in areas (10 by default)
+// which are only connected through area 0, as the autonomous systems
+// of a generated topology would be.  Each area is a ring of routers
+// with random chords; every other area has one router linked to a
+// router of area 0.  The program populates the routing tables, then
+// takes down and restores random links of the areas, recomputing the
+// routing tables after every change.
+//
+// The program prints the wall clock time of the first computation and
+// the mean wall clock time of the recomputations.
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+int main (int argc, char *argv[])
+{
+  uint32_t nRouters = 1000;
+  uint32_t nAreas = 10;
+  uint32_t nChanges = 10;
+
+  CommandLine cmd;
+  cmd.AddValue ("nRouters", "Number of routers", nRouters);
+  cmd.AddValue ("nAreas", "Number of areas", nAreas);
+  cmd.AddValue ("nChanges", "Number of link failures and repairs", nChanges);
+  cmd.Parse (argc, argv);
+
+  NodeContainer routers;
+  routers.Create (nRouters);
+  InternetStackHelper internet;
+  internet.Install (routers);
+
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  SimpleNetDeviceHelper devices;
+  devices.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper addresses;
+  addresses.SetBase ("10.0.0.0", "255.255.255.252");
+  std::vector<std::pair<Ptr<Ipv4>, uint32_t> > links;
+
+  uint32_t areaSize = nRouters / nAreas;
+  for (uint32_t area = 0; area < nAreas; area++)
+    {
+      uint32_t first = area * areaSize;
+      uint32_t size = area + 1 < nAreas ? areaSize : nRouters - first;
+      for (uint32_t i = 0; i < 2 * size; i++)
+        {
+          uint32_t a = i < size ? i : random->GetInteger (0, size - 1);
+          uint32_t b = i < size ? (i + 1) % size : random->GetInteger (0, size - 1);
+          if (a == b)
+            {
+              continue;
+            }
+          Ipv4InterfaceContainer interfaces =
+            addresses.Assign (devices.Install (NodeContainer (routers.Get (first + a), routers.Get (first + b))));
+          addresses.NewNetwork ();
+          links.push_back (interfaces.Get (0));
+        }
+      if (area > 0)
+        {
+          addresses.Assign (devices.Install (NodeContainer (routers.Get (first), routers.Get (random->GetInteger (0, areaSize - 1)))));
+          addresses.NewNetwork ();
+        }
+    }
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  int64_t populate = clock.End ();
+
+  clock.Start ();
+  for (uint32_t i = 0; i < nChanges; i++)
+    {
+      std::pair<Ptr<Ipv4>, uint32_t> link = links[random->GetInteger (0, links.size () - 1)];
+      link.first->SetDown (link.second);
+      Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+      link.first->SetUp (link.second);
+      Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+    }
+  int64_t recompute = clock.End ();
+
+  std::cout << "routers=" << nRouters
+            << " links=" << links.size ()
+            << " populate wall clock=" << populate << "ms"
+            << " recompute wall clock=" << (nChanges > 0 ? recompute / (2 * nChanges) : 0) << "ms"
+            << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
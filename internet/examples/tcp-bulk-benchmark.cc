@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+// This program measures how fast a bulk TCP transfer over a high
+// bandwidth-delay product path is simulated.
+//
+// A BulkSendApplication sends data in small writes (512 bytes by
+// default) over a point to point link of 10 Gbps and 10 ms of delay to
+// a PacketSink. The socket buffers are large (8 MB by default), so
+// that the transmit buffer holds many writes and the window is wide
+// enough for the losses at the queue of the link (2000 packets by
+// default) to leave a lot of out of order data in the receive buffer.
+//
+// Random losses (errorRate, per packet) can be added at the receiver, to
+// compare the loss recovery with and without selective acknowledgments
+// (sack).
+//
+// The program prints the simulated goodput, the wall clock time, and
+// the number of simulated gigabits transferred per wall clock second.
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include <iostream>
+
+using namespace ns3;
+
+int main (int argc, char *argv[])
+{
+  std::string dataRate = "10Gbps";
+  std::string delay = "10ms";
+  uint32_t bufferSize = 8 << 20;
+  uint32_t sendSize = 512;
+  uint32_t queueSize = 2000;
+  double duration = 1.0;
+  double errorRate = 0;
+  bool sack = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("dataRate", "Data rate of the link", dataRate);
+  cmd.AddValue ("delay", "Delay of the link", delay);
+  cmd.AddValue ("bufferSize", "Size of the socket buffers (bytes)", bufferSize);
+  cmd.AddValue ("sendSize", "Size of the writes of the application (bytes)", sendSize);
+  cmd.AddValue ("queueSize", "Size of the queue of the link (packets)", queueSize);
+  cmd.AddValue ("duration", "Duration of the transfer (simulated seconds)", duration);
+  cmd.AddValue ("errorRate", "Rate of the packets lost at the receiver", errorRate);
+  cmd.AddValue ("sack", "Enable the selective acknowledgments", sack);
+  cmd.Parse (argc, argv);
+
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (1448));
+  Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (bufferSize));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (bufferSize));
+  Config::SetDefault ("ns3::TcpSocketBase::Sack", BooleanValue (sack));
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  PointToPointHelper link;
+  link.SetDeviceAttribute ("DataRate", StringValue (dataRate));
+  link.SetChannelAttribute ("Delay", StringValue (delay));
+  link.SetQueue ("ns3::DropTailQueue", "MaxPackets", UintegerValue (queueSize));
+  NetDeviceContainer devices = link.Install (nodes);
+  if (errorRate > 0)
+    {
+      Ptr<RateErrorModel> errors = CreateObject<RateErrorModel> ();
+      errors->SetUnit (RateErrorModel::ERROR_UNIT_PACKET);
+      errors->SetRate (errorRate);
+      devices.Get (1)->SetAttribute ("ReceiveErrorModel", PointerValue (errors));
+    }
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper addresses;
+  addresses.SetBase ("10.0.0.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = addresses.Assign (devices);
+
+  uint16_t port = 9;
+  BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (interfaces.GetAddress (1), port));
+  source.SetAttribute ("SendSize", UintegerValue (sendSize));
+  ApplicationContainer sourceApps = source.Install (nodes.Get (0));
+  sourceApps.Start (Seconds (0));
+  sourceApps.Stop (Seconds (duration));
+
+  PacketSinkHelper sink ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+  ApplicationContainer sinkApps = sink.Install (nodes.Get (1));
+  sinkApps.Start (Seconds (0));
+
+  Simulator::Stop (Seconds (duration));
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  int64_t wall = clock.End ();
+
+  uint64_t received = DynamicCast<PacketSink> (sinkApps.Get (0))->GetTotalRx ();
+  double gigabits = received * 8 / 1e9;
+  std::cout << "received=" << received << " bytes"
+            << " goodput=" << gigabits / duration << "Gbps"
+            << " wall clock=" << wall << "ms"
+            << " simulated=" << (wall > 0 ? gigabits * 1000 / wall : 0) << "Gb per wall clock second"
+            << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
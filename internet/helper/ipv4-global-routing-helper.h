@@ -80,6 +80,10 @@ public:
    * Users must first call PopulateRoutingTables() and then may subsequently
    * call RecomputeRoutingTables() at any later time in the simulation.
    *
+   * Only the routers whose routes depend on a part of the topology that
+   * changed since the previous computation run their SPF calculation
+   * again; the other routers keep their routes.
+   *
    */
   static void RecomputeRoutingTables (void);
 private:
@@ -27,7 +27,10 @@
 #include "ns3/ipv4-interface.h"
 #include "ns3/arp-cache.h"
 #include "ns3/names.h"
+#include "ns3/channel.h"
 #include "ipv4-routing-helper.h"
+#include <map>
+#include <vector>
 
 namespace ns3 {
 
@@ -124,6 +127,71 @@ Ipv4RoutingHelper::PrintNeighborCacheEvery (Time printInterval,Ptr<Node> node, P
   Simulator::Schedule (printInterval, &Ipv4RoutingHelper::PrintArpCacheEvery, printInterval, node, stream);
 }
 
+void
+Ipv4RoutingHelper::PopulateNeighborCaches (void)
+{
+  typedef std::vector<std::pair<Ipv4Address, Address> > Neighbors;
+  std::map<Ptr<Channel>, Neighbors> channels;
+  for (uint32_t i = 0; i < NodeList::GetNNodes (); i++)
+    {
+      Ptr<Ipv4L3Protocol> ipv4 = NodeList::GetNode (i)->GetObject<Ipv4L3Protocol> ();
+      if (ipv4 == 0)
+        {
+          continue;
+        }
+      for (uint32_t j = 0; j < ipv4->GetNInterfaces (); j++)
+        {
+          Ptr<Ipv4Interface> interface = ipv4->GetInterface (j);
+          Ptr<NetDevice> device = interface->GetDevice ();
+          if (interface->GetArpCache () == 0 || device->GetChannel () == 0)
+            {
+              continue;
+            }
+          Neighbors &neighbors = channels[device->GetChannel ()];
+          for (uint32_t k = 0; k < interface->GetNAddresses (); k++)
+            {
+              neighbors.push_back (std::make_pair (interface->GetAddress (k).GetLocal (), device->GetAddress ()));
+            }
+        }
+    }
+
+  for (uint32_t i = 0; i < NodeList::GetNNodes (); i++)
+    {
+      Ptr<Ipv4L3Protocol> ipv4 = NodeList::GetNode (i)->GetObject<Ipv4L3Protocol> ();
+      if (ipv4 == 0)
+        {
+          continue;
+        }
+      for (uint32_t j = 0; j < ipv4->GetNInterfaces (); j++)
+        {
+          Ptr<Ipv4Interface> interface = ipv4->GetInterface (j);
+          Ptr<NetDevice> device = interface->GetDevice ();
+          Ptr<ArpCache> arpCache = interface->GetArpCache ();
+          if (arpCache == 0 || device->GetChannel () == 0)
+            {
+              continue;
+            }
+          const Neighbors &neighbors = channels[device->GetChannel ()];
+          for (Neighbors::const_iterator n = neighbors.begin (); n != neighbors.end (); n++)
+            {
+              if (n->second == device->GetAddress ())
+                {
+                  continue;
+                }
+              for (uint32_t k = 0; k < interface->GetNAddresses (); k++)
+                {
+                  Ipv4InterfaceAddress address = interface->GetAddress (k);
+                  if (address.GetMask ().IsMatch (address.GetLocal (), n->first))
+                    {
+                      arpCache->AddPermanent (n->first, n->second);
+                      break;
+                    }
+                }
+            }
+        }
+    }
+}
+
 void
 Ipv4RoutingHelper::PrintArpCache (Ptr<Node> node, Ptr<OutputStreamWrapper> stream)
 {
@@ -171,6 +171,20 @@ public:
    */
   static void PrintNeighborCacheEvery (Time printInterval, Ptr<Node> node, Ptr<OutputStreamWrapper> stream);
 
+  /**
+   * \brief fills the neighbor caches of all nodes with permanent entries.
+   *
+   * For each IPv4 interface which needs ARP, this method adds a
+   * permanent entry to its ArpCache for every address of the other
+   * interfaces attached to the same channel and in one of its subnets.
+   * The nodes then never send an ARP request to each other, which
+   * avoids the ARP traffic at the start of large scenarios.
+   *
+   * It should be called after the addresses have been assigned. Nodes
+   * which are only reachable through a bridge are not added.
+   */
+  static void PopulateNeighborCaches (void);
+
   /**
    * \brief Request a specified routing protocol &lt;T&gt; from Ipv4RoutingProtocol protocol
    *
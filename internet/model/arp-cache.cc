@@ -74,6 +74,13 @@ ArpCache::GetTypeId (void)
                    UintegerValue (3),
                    MakeUintegerAccessor (&ArpCache::m_pendingQueueSize),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("PendingQueueMaxBytes",
+                   "The maximum number of bytes queued for each entry "
+                   "pending an arp reply, 0 for no limit. The first "
+                   "packet is always queued.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&ArpCache::m_pendingQueueMaxBytes),
+                   MakeUintegerChecker<uint32_t> ())
     .AddTraceSource ("Drop",
                      "Packet dropped due to ArpCache entry "
                      "in WaitReply expiring.",
@@ -99,13 +106,15 @@ void
 ArpCache::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
-  Flush ();
-  m_device = 0;
-  m_interface = 0;
-  if (!m_waitReplyTimer.IsRunning ())
+  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
     {
-      Simulator::Remove (m_waitReplyTimer);
+      delete (*i).second;
     }
+  m_arpCache.clear ();
+  m_waitReplyEntries.clear ();
+  m_waitReplyTimer.Cancel ();
+  m_device = 0;
+  m_interface = 0;
   Object::DoDispose ();
 }
 
@@ -194,40 +203,37 @@ void
 ArpCache::HandleWaitReplyTimeout (void)
 {
   NS_LOG_FUNCTION (this);
-  ArpCache::Entry* entry;
   bool restartWaitReplyTimer = false;
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++) 
+  std::list<ArpCache::Entry *>::iterator i = m_waitReplyEntries.begin ();
+  while (i != m_waitReplyEntries.end ())
     {
-      entry = (*i).second;
-      if (entry != 0 && entry->IsWaitReply ())
+      // marking the entry dead removes it from the list
+      ArpCache::Entry *entry = *i++;
+      if (entry->GetRetries () < m_maxRetries)
         {
-          if (entry->GetRetries () < m_maxRetries)
-            {
-              NS_LOG_LOGIC ("node="<< m_device->GetNode ()->GetId () <<
-                            ", ArpWaitTimeout for " << entry->GetIpv4Address () <<
-                            " expired -- retransmitting arp request since retries = " <<
-                            entry->GetRetries ());
-              m_arpRequestCallback (this, entry->GetIpv4Address ());
-              restartWaitReplyTimer = true;
-              entry->IncrementRetries ();
-            }
-          else
+          NS_LOG_LOGIC ("node="<< m_device->GetNode ()->GetId () <<
+                        ", ArpWaitTimeout for " << entry->GetIpv4Address () <<
+                        " expired -- retransmitting arp request since retries = " <<
+                        entry->GetRetries ());
+          m_arpRequestCallback (this, entry->GetIpv4Address ());
+          restartWaitReplyTimer = true;
+          entry->IncrementRetries ();
+        }
+      else
+        {
+          NS_LOG_LOGIC ("node="<<m_device->GetNode ()->GetId () <<
+                        ", wait reply for " << entry->GetIpv4Address () <<
+                        " expired -- drop since max retries exceeded: " <<
+                        entry->GetRetries ());
+          entry->MarkDead ();
+          entry->ClearRetries ();
+          Ptr<Packet> pending = entry->DequeuePending ();
+          while (pending != 0)
             {
-              NS_LOG_LOGIC ("node="<<m_device->GetNode ()->GetId () <<
-                            ", wait reply for " << entry->GetIpv4Address () <<
-                            " expired -- drop since max retries exceeded: " <<
-                            entry->GetRetries ());
-              entry->MarkDead ();
-              entry->ClearRetries ();
-              Ptr<Packet> pending = entry->DequeuePending ();
-              while (pending != 0)
-                {
-                  m_dropTrace (pending);
-                  pending = entry->DequeuePending ();
-                }
+              m_dropTrace (pending);
+              pending = entry->DequeuePending ();
             }
         }
-
     }
   if (restartWaitReplyTimer)
     {
@@ -241,11 +247,18 @@ void
 ArpCache::Flush (void)
 {
   NS_LOG_FUNCTION (this);
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++) 
+  CacheI i = m_arpCache.begin ();
+  while (i != m_arpCache.end ())
     {
+      if ((*i).second->IsPermanent ())
+        {
+          i++;
+          continue;
+        }
       delete (*i).second;
+      m_arpCache.erase (i++);
     }
-  m_arpCache.erase (m_arpCache.begin (), m_arpCache.end ());
+  m_waitReplyEntries.clear ();
   if (m_waitReplyTimer.IsRunning ())
     {
       NS_LOG_LOGIC ("Stopping WaitReplyTimer at " << Simulator::Now ().GetSeconds () << " due to ArpCache flush");
@@ -297,10 +310,10 @@ ArpCache::Entry *
 ArpCache::Lookup (Ipv4Address to)
 {
   NS_LOG_FUNCTION (this << to);
-  if (m_arpCache.find (to) != m_arpCache.end ()) 
+  CacheI it = m_arpCache.find (to);
+  if (it != m_arpCache.end ())
     {
-      ArpCache::Entry *entry = m_arpCache[to];
-      return entry;
+      return it->second;
     }
   return 0;
 }
@@ -317,20 +330,39 @@ ArpCache::Add (Ipv4Address to)
   return entry;
 }
 
+ArpCache::Entry *
+ArpCache::AddPermanent (Ipv4Address to, Address macAddress)
+{
+  NS_LOG_FUNCTION (this << to << macAddress);
+  ArpCache::Entry *entry = Lookup (to);
+  if (entry == 0)
+    {
+      entry = Add (to);
+    }
+  Ptr<Packet> pending = entry->DequeuePending ();
+  while (pending != 0)
+    {
+      m_dropTrace (pending);
+      pending = entry->DequeuePending ();
+    }
+  entry->SetMacAddresss (macAddress);
+  entry->MarkPermanent ();
+  return entry;
+}
+
 void
 ArpCache::Remove (ArpCache::Entry *entry)
 {
   NS_LOG_FUNCTION (this << entry);
   
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
+  CacheI i = m_arpCache.find (entry->GetIpv4Address ());
+  if (i != m_arpCache.end () && (*i).second == entry)
     {
-      if ((*i).second == entry)
-        {
-          m_arpCache.erase (i);
-          entry->ClearPendingPacket (); //clear the pending packets for entry's ipaddress
-          delete entry;
-          return;
-        }
+      m_arpCache.erase (i);
+      entry->LeaveWaitReply ();
+      entry->ClearPendingPacket (); //clear the pending packets for entry's ipaddress
+      delete entry;
+      return;
     }
   NS_LOG_WARN ("Entry not found in this ARP Cache");
 }
@@ -338,6 +370,7 @@ ArpCache::Remove (ArpCache::Entry *entry)
 ArpCache::Entry::Entry (ArpCache *arp)
   : m_arp (arp),
     m_state (ALIVE),
+    m_pendingBytes (0),
     m_retries (0)
 {
   NS_LOG_FUNCTION (this << arp);
@@ -375,6 +408,7 @@ ArpCache::Entry::MarkDead (void)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (m_state == ALIVE || m_state == WAIT_REPLY || m_state == DEAD);
+  LeaveWaitReply ();
   m_state = DEAD;
   ClearRetries ();
   UpdateSeen ();
@@ -384,6 +418,7 @@ ArpCache::Entry::MarkAlive (Address macAddress)
 {
   NS_LOG_FUNCTION (this << macAddress);
   NS_ASSERT (m_state == WAIT_REPLY);
+  LeaveWaitReply ();
   m_macAddress = macAddress;
   m_state = ALIVE;
   ClearRetries ();
@@ -394,6 +429,7 @@ ArpCache::Entry::MarkPermanent (void)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (!m_macAddress.IsInvalid ());
+  LeaveWaitReply ();
   m_state = PERMANENT;
   ClearRetries ();
   UpdateSeen ();
@@ -411,7 +447,13 @@ ArpCache::Entry::UpdateWaitReply (Ptr<Packet> waiting)
     {
       return false;
     }
+  if (m_arp->m_pendingQueueMaxBytes != 0
+      && m_pendingBytes + waiting->GetSize () > m_arp->m_pendingQueueMaxBytes)
+    {
+      return false;
+    }
   m_pending.push_back (waiting);
+  m_pendingBytes += waiting->GetSize ();
   return true;
 }
 void 
@@ -421,7 +463,12 @@ ArpCache::Entry::MarkWaitReply (Ptr<Packet> waiting)
   NS_ASSERT (m_state == ALIVE || m_state == DEAD);
   NS_ASSERT (m_pending.empty ());
   m_state = WAIT_REPLY;
-  m_pending.push_back (waiting);
+  m_waitReplyIter = m_arp->m_waitReplyEntries.insert (m_arp->m_waitReplyEntries.end (), this);
+  if (waiting != 0)
+    {
+      m_pending.push_back (waiting);
+      m_pendingBytes = waiting->GetSize ();
+    }
   UpdateSeen ();
   m_arp->StartWaitReplyTimer ();
 }
@@ -494,14 +541,33 @@ ArpCache::Entry::DequeuePending (void)
     {
       Ptr<Packet> p = m_pending.front ();
       m_pending.pop_front ();
+      m_pendingBytes -= p->GetSize ();
       return p;
     }
 }
+void
+ArpCache::Entry::DequeueAllPending (std::list<Ptr<Packet> > &pending)
+{
+  NS_LOG_FUNCTION (this);
+  pending.clear ();
+  pending.swap (m_pending);
+  m_pendingBytes = 0;
+}
 void 
 ArpCache::Entry::ClearPendingPacket (void)
 {
   NS_LOG_FUNCTION (this);
   m_pending.clear ();
+  m_pendingBytes = 0;
+}
+void
+ArpCache::Entry::LeaveWaitReply (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_state == WAIT_REPLY)
+    {
+      m_arp->m_waitReplyEntries.erase (m_waitReplyIter);
+    }
 }
 void 
 ArpCache::Entry::UpdateSeen (void)
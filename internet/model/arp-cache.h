@@ -137,6 +137,9 @@ public:
    * This method will schedule a timeout at WaitReplyTimeout interval
    * in the future, unless a timer is already running for the cache,
    * in which case this method does nothing.
+   *
+   * A single timer serves all the entries of the cache: when it
+   * expires, only the entries in WAIT_REPLY state are visited.
    */
   void StartWaitReplyTimer (void);
   /**
@@ -150,13 +153,26 @@ public:
    * \brief Add an Ipv4Address to this ARP cache
    */
   ArpCache::Entry *Add (Ipv4Address to);
+  /**
+   * \brief Add a permanent entry to this ARP cache, or make an existing
+   * entry permanent.
+   *
+   * Permanent entries are never refreshed, so a scenario which fills
+   * the caches up front does not send any ARP request. Packets waiting
+   * for a reply to the address are dropped.
+   *
+   * \param to the Ipv4Address of the entry
+   * \param macAddress the MAC address of the entry
+   * \returns the entry
+   */
+  ArpCache::Entry *AddPermanent (Ipv4Address to, Address macAddress);
   /**
    * \brief Remove an entry.
    * \param entry pointer to delete it from the list
    */
   void Remove (ArpCache::Entry *entry);
   /**
-   * \brief Clear the ArpCache of all entries
+   * \brief Clear the ArpCache of all entries but the permanent ones
    */
   void Flush (void);
 
@@ -245,6 +261,12 @@ public:
      *            packets are pending.
      */
     Ptr<Packet> DequeuePending (void);
+    /**
+     * \brief Dequeue all the pending packets at once.
+     * \param pending the list to which the pending packets are moved,
+     *        in arrival order. The list is cleared first.
+     */
+    void DequeueAllPending (std::list<Ptr<Packet> > &pending);
     /**
      * \brief Clear the pending packet list
      */
@@ -264,6 +286,8 @@ public:
     void ClearRetries (void);
 
 private:
+    friend class ArpCache;
+
     /**
      * \brief ARP cache entry states
      */
@@ -285,13 +309,20 @@ private:
      */
     Time GetTimeout (void) const;
 
+    /**
+     * \brief Leave the WAIT_REPLY state, if the entry is in it.
+     */
+    void LeaveWaitReply (void);
+
     ArpCache *m_arp; //!< pointer to the ARP cache owning the entry
     ArpCacheEntryState_e m_state; //!< state of the entry
     Time m_lastSeen; //!< last moment a packet from that address has been seen
     Address m_macAddress; //!< entry's MAC address
     Ipv4Address m_ipv4Address; //!< entry's IP address
     std::list<Ptr<Packet> > m_pending; //!< list of pending packets for the entry's IP
+    uint32_t m_pendingBytes; //!< size of the pending packets
     uint32_t m_retries; //!< rerty counter
+    std::list<Entry *>::iterator m_waitReplyIter; //!< position in the entries waiting for a reply
   };
 
 private:
@@ -322,7 +353,9 @@ private:
    */
   void HandleWaitReplyTimeout (void);
   uint32_t m_pendingQueueSize; //!< number of packets waiting for a resolution
+  uint32_t m_pendingQueueMaxBytes; //!< size of the packets waiting for a resolution
   Cache m_arpCache; //!< the ARP cache
+  std::list<Entry *> m_waitReplyEntries; //!< the entries in WAIT_REPLY state
   TracedCallback<Ptr<const Packet> > m_dropTrace; //!< trace for packets dropped by the ARP cache queue
 };
 
@@ -229,12 +229,17 @@ ArpL3Protocol::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t pro
                                        << " for waiting entry -- flush");
                   Address from_mac = arp.GetSourceHardwareAddress ();
                   entry->MarkAlive (from_mac);
-                  Ptr<Packet> pending = entry->DequeuePending ();
-                  while (pending != 0)
+                  // the pending packets were already checked to need
+                  // this address: hand them to the device at once
+                  // instead of resolving it again for each of them
+                  std::list<Ptr<Packet> > pending;
+                  entry->DequeueAllPending (pending);
+                  if (cache->GetInterface ()->IsUp ())
                     {
-                      cache->GetInterface ()->Send (pending,
-                                                    arp.GetSourceIpv4Address ());
-                      pending = entry->DequeuePending ();
+                      for (std::list<Ptr<Packet> >::const_iterator j = pending.begin (); j != pending.end (); j++)
+                        {
+                          device->Send (*j, from_mac, Ipv4L3Protocol::PROT_NUMBER);
+                        }
                     }
                 } 
               else 
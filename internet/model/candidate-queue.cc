@@ -51,22 +51,30 @@ operator<< (std::ostream& os, const CandidateQueue& q)
 {
   typedef CandidateQueue::CandidateList_t List_t;
   typedef List_t::const_iterator CIter_t;
-  const CandidateQueue::CandidateList_t& list = q.m_candidates;
+  List_t list = q.m_candidates;
+  std::sort (list.begin (), list.end (), &CandidateQueue::Before);
 
   os << "*** CandidateQueue Begin (<id, distance, LSA-type>) ***" << std::endl;
   for (CIter_t iter = list.begin (); iter != list.end (); iter++)
     {
       os << "<" 
-      << (*iter)->GetVertexId () << ", "
-      << (*iter)->GetDistanceFromRoot () << ", "
-      << (*iter)->GetVertexType () << ">" << std::endl;
+      << iter->vertex->GetVertexId () << ", "
+      << iter->vertex->GetDistanceFromRoot () << ", "
+      << iter->vertex->GetVertexType () << ">" << std::endl;
     }
   os << "*** CandidateQueue End ***";
   return os;
 }
 
+size_t
+CandidateQueue::VertexHash::operator () (const SPFVertex *v) const
+{
+  return reinterpret_cast<size_t> (v) >> 3;
+}
+
 CandidateQueue::CandidateQueue()
-  : m_candidates ()
+  : m_candidates (),
+    m_sequence (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -89,16 +97,119 @@ CandidateQueue::Clear (void)
     }
 }
 
+CandidateQueue::Candidate
+CandidateQueue::MakeCandidate (SPFVertex *v)
+{
+  Candidate c;
+  c.vertex = v;
+  c.distance = v->GetDistanceFromRoot ();
+  c.rank = v->GetVertexType () == SPFVertex::VertexNetwork ? 0 : 1;
+  c.sequence = m_sequence++;
+  return c;
+}
+
+void
+CandidateQueue::Place (uint32_t position, const Candidate &c)
+{
+  m_candidates[position] = c;
+  m_positions[c.vertex] = position;
+}
+
+void
+CandidateQueue::SiftUp (uint32_t position)
+{
+  Candidate c = m_candidates[position];
+  while (position > 0)
+    {
+      uint32_t parent = (position - 1) / 2;
+      if (!Before (c, m_candidates[parent]))
+        {
+          break;
+        }
+      Place (position, m_candidates[parent]);
+      position = parent;
+    }
+  Place (position, c);
+}
+
+void
+CandidateQueue::SiftDown (uint32_t position)
+{
+  Candidate c = m_candidates[position];
+  uint32_t size = m_candidates.size ();
+  while (true)
+    {
+      uint32_t child = 2 * position + 1;
+      if (child >= size)
+        {
+          break;
+        }
+      if (child + 1 < size && Before (m_candidates[child + 1], m_candidates[child]))
+        {
+          child++;
+        }
+      if (!Before (m_candidates[child], c))
+        {
+          break;
+        }
+      Place (position, m_candidates[child]);
+      position = child;
+    }
+  Place (position, c);
+}
+
 void
 CandidateQueue::Push (SPFVertex *vNew)
 {
   NS_LOG_FUNCTION (this << vNew);
 
-  CandidateList_t::iterator i = std::upper_bound (
-      m_candidates.begin (), m_candidates.end (), vNew,
-      &CandidateQueue::CompareSPFVertex
-      );
-  m_candidates.insert (i, vNew);
+  Candidate c = MakeCandidate (vNew);
+  m_candidates.push_back (c);
+  SiftUp (m_candidates.size () - 1);
+
+  sgi::hash_map<Ipv4Address, Id, Ipv4AddressHash>::iterator i = m_ids.find (vNew->GetVertexId ());
+  if (i == m_ids.end ())
+    {
+      Id id;
+      id.first = vNew;
+      id.count = 1;
+      m_ids[vNew->GetVertexId ()] = id;
+    }
+  else
+    {
+      i->second.count++;
+      if (Before (c, m_candidates[m_positions[i->second.first]]))
+        {
+          i->second.first = vNew;
+        }
+    }
+}
+
+void
+CandidateQueue::ForgetId (SPFVertex *v)
+{
+  sgi::hash_map<Ipv4Address, Id, Ipv4AddressHash>::iterator i = m_ids.find (v->GetVertexId ());
+  NS_ASSERT (i != m_ids.end ());
+  if (--i->second.count == 0)
+    {
+      m_ids.erase (i);
+      return;
+    }
+  if (i->second.first != v)
+    {
+      return;
+    }
+  // look for the next vertex with the same id
+  const Candidate *first = 0;
+  for (CandidateList_t::const_iterator j = m_candidates.begin (); j != m_candidates.end (); j++)
+    {
+      if (j->vertex->GetVertexId () == v->GetVertexId () && (first == 0 || Before (*j, *first)))
+        {
+          first = &*j;
+        }
+    }
+  NS_ASSERT (first != 0);
+  i->second.first = first->vertex;
 }
 
 SPFVertex *
@@ -110,8 +221,16 @@ CandidateQueue::Pop (void)
       return 0;
     }
 
-  SPFVertex *v = m_candidates.front ();
-  m_candidates.pop_front ();
+  SPFVertex *v = m_candidates.front ().vertex;
+  Candidate last = m_candidates.back ();
+  m_candidates.pop_back ();
+  m_positions.erase (v);
+  if (!m_candidates.empty ())
+    {
+      Place (0, last);
+      SiftDown (0);
+    }
+  ForgetId (v);
   return v;
 }
 
@@ -124,7 +243,7 @@ CandidateQueue::Top (void) const
       return 0;
     }
 
-  return m_candidates.front ();
+  return m_candidates.front ().vertex;
 }
 
 bool
@@ -145,18 +264,12 @@ SPFVertex *
 CandidateQueue::Find (const Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this);
-  CandidateList_t::const_iterator i = m_candidates.begin ();
-
-  for (; i != m_candidates.end (); i++)
+  sgi::hash_map<Ipv4Address, Id, Ipv4AddressHash>::const_iterator i = m_ids.find (addr);
+  if (i == m_ids.end ())
     {
-      SPFVertex *v = *i;
-      if (v->GetVertexId () == addr)
-        {
-          return v;
-        }
+      return 0;
     }
-
-  return 0;
+  return i->second.first;
 }
 
 void
@@ -164,37 +277,68 @@ CandidateQueue::Reorder (void)
 {
   NS_LOG_FUNCTION (this);
 
-  m_candidates.sort (&CandidateQueue::CompareSPFVertex);
+  // Sort the candidates in their current order, then stable sort them
+  // by their new distances, so that equal vertices keep their order.
+  std::sort (m_candidates.begin (), m_candidates.end (), &CandidateQueue::Before);
+  for (CandidateList_t::iterator i = m_candidates.begin (); i != m_candidates.end (); i++)
+    {
+      *i = MakeCandidate (i->vertex);
+    }
+  std::sort (m_candidates.begin (), m_candidates.end (), &CandidateQueue::Before);
+
+  // A sorted vector is a heap
+  for (uint32_t i = 0; i < m_candidates.size (); i++)
+    {
+      Place (i, MakeCandidate (m_candidates[i].vertex));
+    }
+  for (uint32_t i = m_candidates.size (); i > 0; i--)
+    {
+      m_ids[m_candidates[i - 1].vertex->GetVertexId ()].first = m_candidates[i - 1].vertex;
+    }
   NS_LOG_LOGIC ("After reordering the CandidateQueue");
   NS_LOG_LOGIC (*this);
 }
 
+void
+CandidateQueue::Update (SPFVertex *v)
+{
+  NS_LOG_FUNCTION (this << v);
+  sgi::hash_map<SPFVertex *, uint32_t, VertexHash>::iterator i = m_positions.find (v);
+  NS_ASSERT_MSG (i != m_positions.end (), "Vertex " << v->GetVertexId () << " is not a candidate");
+  uint32_t position = i->second;
+  NS_ASSERT (v->GetDistanceFromRoot () <= m_candidates[position].distance);
+  Candidate c = MakeCandidate (v);
+  m_candidates[position] = c;
+  SiftUp (position);
+
+  Id &id = m_ids[v->GetVertexId ()];
+  if (id.first != v && Before (c, m_candidates[m_positions[id.first]]))
+    {
+      id.first = v;
+    }
+}
+
 /*
  * In this implementation, SPFVertex follows the ordering where
  * a vertex is ranked first if its GetDistanceFromRoot () is smaller;
  * In case of a tie, NetworkLSA is always ranked before RouterLSA.
+ * Remaining ties are broken by the order in which the vertices were
+ * queued.
  *
  * This ordering is necessary for implementing ECMP
  */
 bool 
-CandidateQueue::CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2)
+CandidateQueue::Before (const Candidate &a, const Candidate &b)
 {
-  NS_LOG_FUNCTION (&v1 << &v2);
-
-  bool result = false;
-  if (v1->GetDistanceFromRoot () < v2->GetDistanceFromRoot ())
+  if (a.distance != b.distance)
     {
-      result = true;
+      return a.distance < b.distance;
     }
-  else if (v1->GetDistanceFromRoot () == v2->GetDistanceFromRoot ())
+  if (a.rank != b.rank)
     {
-      if (v1->GetVertexType () == SPFVertex::VertexNetwork 
-          && v2->GetVertexType () == SPFVertex::VertexRouter)
-        {
-          result = true;
-        }
+      return a.rank < b.rank;
     }
-  return result;
+  return a.sequence < b.sequence;
 }
 
 } // namespace ns3
@@ -22,8 +22,9 @@
 #define CANDIDATE_QUEUE_H
 
 #include <stdint.h>
-#include <list>
+#include <vector>
 #include "ns3/ipv4-address.h"
+#include "ns3/sgi-hashmap.h"
 
 namespace ns3 {
 
@@ -45,6 +46,12 @@ class SPFVertex;
  * for a Find () operation, the dynamic nature of the data and the derived
  * requirement for a Reorder () operation led us to implement this simple 
  * enhanced priority queue.
+ *
+ * The candidates are kept in a binary heap, indexed by vertex id, so that
+ * Push, Pop, Find and Update do not depend linearly on the number of
+ * candidates.  Vertices of equal distance and type are popped in the
+ * order they were pushed (or last updated), as with the sorted list this
+ * queue used to be.
  */
 class CandidateQueue
 {
@@ -152,6 +159,19 @@ public:
  */
   void Reorder (void);
 
+/**
+ * @brief Restore the priority of a vertex whose distance from the root
+ * has decreased.
+ *
+ * This is the equivalent of Reorder () when only the given vertex has
+ * changed.  The vertex is then ranked after the vertices which already
+ * had its new distance.
+ *
+ * @see SPFVertex
+ * @param v The Shortest Path First Vertex, which must be in the queue.
+ */
+  void Update (SPFVertex *v);
+
 private:
 /**
  * Candidate Queue copy construction is disallowed (not implemented) to 
@@ -169,21 +189,86 @@ private:
  * \return copied object
  */
   CandidateQueue& operator= (CandidateQueue& sr);
-/**
- * \brief return true if v1 < v2
- *
- * SPFVertexes are added into the queue according to the ordering
- * defined by this method. If v1 should be popped before v2, this 
- * method return true; false otherwise
- *
- * \param v1 first operand
- * \param v2 second operand
- * \return True if v1 should be popped before v2; false otherwise
- */
-  static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
 
-  typedef std::list<SPFVertex*> CandidateList_t; //!< container of SPFVertex pointers
-  CandidateList_t m_candidates;  //!< SPFVertex candidates
+  /**
+   * \brief A vertex of the heap, with the priority it was queued with.
+   */
+  struct Candidate
+  {
+    SPFVertex *vertex;  //!< the vertex
+    uint32_t distance;  //!< the distance of the vertex when queued
+    uint8_t rank;       //!< 0 for a network vertex, 1 otherwise
+    uint64_t sequence;  //!< the queuing rank among equal priorities
+  };
+
+  /**
+   * \brief The vertices queued with an id.
+   *
+   * Ids are unique during the SPF calculations, but nothing prevents
+   * queuing anonymous vertices.
+   */
+  struct Id
+  {
+    SPFVertex *first; //!< the vertex with this id which is popped first
+    uint32_t count;   //!< the number of vertices with this id
+  };
+
+  /**
+   * \brief Hash function class for the vertex pointers.
+   */
+  struct VertexHash
+  {
+    /**
+     * \param v the vertex
+     * \returns the hash of the pointer
+     */
+    size_t operator () (const SPFVertex *v) const;
+  };
+
+  /**
+   * \brief return true if a < b
+   *
+   * SPFVertexes are added into the queue according to the ordering
+   * defined by this method. If a should be popped before b, this
+   * method return true; false otherwise
+   *
+   * \param a first operand
+   * \param b second operand
+   * \return True if a should be popped before b; false otherwise
+   */
+  static bool Before (const Candidate &a, const Candidate &b);
+  /**
+   * \param v a vertex
+   * \returns the candidate of the vertex, with a new sequence number
+   */
+  Candidate MakeCandidate (SPFVertex *v);
+  /**
+   * \brief Store a candidate at a position of the heap.
+   * \param position the position
+   * \param c the candidate
+   */
+  void Place (uint32_t position, const Candidate &c);
+  /**
+   * \brief Move a candidate up until its parent is popped before it.
+   * \param position the position of the candidate
+   */
+  void SiftUp (uint32_t position);
+  /**
+   * \brief Move a candidate down until it is popped before its children.
+   * \param position the position of the candidate
+   */
+  void SiftDown (uint32_t position);
+  /**
+   * \brief Rebuild the id index after a vertex has left the queue.
+   * \param v the vertex
+   */
+  void ForgetId (SPFVertex *v);
+
+  typedef std::vector<Candidate> CandidateList_t; //!< container of SPFVertex candidates
+  CandidateList_t m_candidates;  //!< SPFVertex candidates, as a binary heap
+  sgi::hash_map<SPFVertex *, uint32_t, VertexHash> m_positions; //!< heap positions of the vertices
+  sgi::hash_map<Ipv4Address, Id, Ipv4AddressHash> m_ids; //!< vertices by id
+  uint64_t m_sequence; //!< the sequence number of the next candidate
 
   /**
    * \brief Stream insertion operator.
@@ -26,10 +26,12 @@
 #include <list>
 #include <queue>
 #include <map>
+#include <set>
 #include <vector>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/sgi-hashmap.h"
 #include "global-router-interface.h"
 
 namespace ns3 {
@@ -672,13 +674,46 @@ public:
    */
   uint32_t GetNumExtLSAs () const;
 
+  /**
+   * @brief Compare this database with another one.
+   *
+   * @param other the other database
+   * @param changed the ids of the Link State Advertisements which are only
+   * in one of the databases or which differ between them are added to this set
+   * @returns true if the External Link State Advertisements differ
+   */
+  bool GetChangedLSAs (const GlobalRouteManagerLSDB &other, std::set<Ipv4Address> &changed) const;
+
+  /**
+   * @brief Add the vertices from which a set of vertices can be reached.
+   *
+   * The edges of the graph are the links followed by the SPF calculation:
+   * from a router to the routers and transit networks of its link records,
+   * and from a network to its attached routers.  Every vertex from which one
+   * of the given vertices can be reached is added to the set.
+   *
+   * @param vertices the ids of the vertices
+   */
+  void AddUpstreamVertices (std::set<Ipv4Address> &vertices) const;
+
 
 private:
   typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t; //!< container of IPv4 addresses / Link State Advertisements
   typedef std::pair<Ipv4Address, GlobalRoutingLSA*> LSDBPair_t; //!< pair of IPv4 addresses / Link State Advertisements
+  typedef std::pair<Ipv4Address, GlobalRoutingLSA*> LinkDataEntry_t; //!< id and LSA of a TransitNetwork link record owner
+  typedef sgi::hash_map<Ipv4Address, LinkDataEntry_t, Ipv4AddressHash> LinkDataMap_t; //!< container of LSAs by link data
+
+  /**
+   * @brief Compare two Link State Advertisements, except for their status.
+   * @param a a Link State Advertisement
+   * @param b another Link State Advertisement
+   * @returns true if the advertisements are the same
+   */
+  static bool IsSameLSA (const GlobalRoutingLSA *a, const GlobalRoutingLSA *b);
 
   LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
   std::vector<GlobalRoutingLSA*> m_extdatabase; //!< database of External Link State Advertisements
+  LinkDataMap_t m_linkData; //!< the LSA with the lowest id for the link data of each TransitNetwork link record
 
 /**
  * @brief GlobalRouteManagerLSDB copy construction is disallowed.  There's no 
@@ -733,6 +768,21 @@ public:
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Rebuild the routing database and recompute the routes which
+ * depend on the Link State Advertisements that changed.
+ *
+ * The new database is compared with the one the routes were computed
+ * from.  The SPF calculation of a router only reads the advertisements of
+ * the vertices it can reach, so only the routers which can reach a
+ * changed advertisement, in the old or in the new database, have their
+ * routes deleted and computed again.  The other routers keep their
+ * routes, which are the ones a full computation would give them.  If the
+ * External Link State Advertisements changed, or if the routes were not
+ * computed from the current database, all the routes are recomputed.
+ */
+  virtual void UpdateGlobalRoutes ();
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  */
@@ -765,7 +815,31 @@ private:
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
   SPFVertex* m_spfroot; //!< the root node
+  Ptr<Node> m_spfrootNode; //!< the node of the root of the SPF tree
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
+  bool m_routesInitialized; //!< true if the routes were computed from the current LSDB
+  std::map<Ipv4Address, Ptr<Node> > m_routerNodes; //!< the nodes by router ID, while computing the routes
+
+  /**
+   * \brief Find the node of a router.
+   *
+   * \param routerId the router ID
+   * \returns the first node whose GlobalRouter has this ID, or 0
+   */
+  Ptr<Node> FindRouterNode (Ipv4Address routerId);
+
+  /**
+   * \brief Index the nodes by router ID in m_routerNodes.
+   */
+  void IndexRouterNodes (void);
+
+  /**
+   * \brief Delete the routes of a router.
+   *
+   * \param node the node of the router
+   * \param router the GlobalRouter of the node
+   */
+  void DeleteRoutes (Ptr<Node> node, Ptr<GlobalRouter> router);
 
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
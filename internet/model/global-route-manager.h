@@ -62,6 +62,16 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Rebuild the routing database and recompute the routes of the
+ * routers which can reach a Link State Advertisement that changed.
+ *
+ * This gives the routes of DeleteGlobalRoutes (), BuildGlobalRoutingDatabase ()
+ * and InitializeRoutes (), without running the SPF calculation of the
+ * routers which are not affected by the changes.
+ */
+  static void UpdateGlobalRoutes ();
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
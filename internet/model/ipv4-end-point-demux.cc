@@ -21,13 +21,15 @@
 #include "ipv4-end-point-demux.h"
 #include "ipv4-end-point.h"
 #include "ns3/log.h"
+#include <algorithm>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux");
 
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
-  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152)
+  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152),
+    m_sequence (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -41,30 +43,151 @@ Ipv4EndPointDemux::~Ipv4EndPointDemux ()
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_index.clear ();
+  m_ports.clear ();
+  m_infos.clear ();
 }
 
 bool
-Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+Ipv4EndPointDemux::Key::operator == (const Key &o) const
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  return localPort == o.localPort
+         && peerPort == o.peerPort
+         && peerAddress == o.peerAddress;
+}
+
+size_t
+Ipv4EndPointDemux::KeyHash::operator () (const Key &key) const
+{
+  Ipv4AddressHash addressHash;
+  return addressHash (key.peerAddress) ^ (key.localPort * 2654435761U) ^ (key.peerPort << 16);
+}
+
+bool
+Ipv4EndPointDemux::Entry::operator < (const Entry &o) const
+{
+  return sequence < o.sequence;
+}
+
+size_t
+Ipv4EndPointDemux::EndPointHash::operator () (const Ipv4EndPoint *endPoint) const
+{
+  return reinterpret_cast<size_t> (endPoint) >> 3;
+}
+
+Ipv4EndPointDemux::Key
+Ipv4EndPointDemux::MakeKey (uint16_t localPort, Ipv4Address peerAddress, uint16_t peerPort)
+{
+  Key key;
+  key.localPort = localPort;
+  key.peerAddress = peerAddress;
+  key.peerPort = peerPort;
+  return key;
+}
+
+void
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Info info;
+  info.sequence = m_sequence++;
+  info.position = m_endPoints.insert (m_endPoints.end (), endPoint);
+  EndPoints &port = m_ports[endPoint->GetLocalPort ()];
+  info.portPosition = port.insert (port.end (), endPoint);
+  m_infos[endPoint] = info;
+  Entry entry;
+  entry.sequence = info.sequence;
+  entry.endPoint = endPoint;
+  AddToIndex (MakeKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (), endPoint->GetPeerPort ()),
+              entry);
+  endPoint->m_demux = this;
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+}
+
+void
+Ipv4EndPointDemux::Remove (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  sgi::hash_map<Ipv4EndPoint *, Info, EndPointHash>::iterator info = m_infos.find (endPoint);
+  NS_ASSERT (info != m_infos.end ());
+  RemoveFromIndex (MakeKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (), endPoint->GetPeerPort ()),
+                   endPoint);
+  sgi::hash_map<uint16_t, EndPoints>::iterator port = m_ports.find (endPoint->GetLocalPort ());
+  port->second.erase (info->second.portPosition);
+  if (port->second.empty ())
+    {
+      m_ports.erase (port);
+    }
+  m_endPoints.erase (info->second.position);
+  m_infos.erase (info);
+  endPoint->m_demux = 0;
+}
+
+void
+Ipv4EndPointDemux::AddToIndex (const Key &key, const Entry &entry)
+{
+  Entries &entries = m_index[key];
+  // new endpoints have the highest rank: only a change of peer inserts
+  // before the end
+  entries.insert (std::upper_bound (entries.begin (), entries.end (), entry), entry);
+}
+
+void
+Ipv4EndPointDemux::RemoveFromIndex (const Key &key, Ipv4EndPoint *endPoint)
+{
+  sgi::hash_map<Key, Entries, KeyHash>::iterator bucket = m_index.find (key);
+  NS_ASSERT (bucket != m_index.end ());
+  Entries &entries = bucket->second;
+  for (Entries::iterator i = entries.begin (); i != entries.end (); i++)
     {
-      if ((*i)->GetLocalPort  () == port) 
+      if (i->endPoint == endPoint)
         {
-          return true;
+          entries.erase (i);
+          break;
         }
     }
-  return false;
+  if (entries.empty ())
+    {
+      m_index.erase (bucket);
+    }
+}
+
+void
+Ipv4EndPointDemux::PeerChanged (Ipv4EndPoint *endPoint, Ipv4Address address, uint16_t port)
+{
+  NS_LOG_FUNCTION (this << endPoint << address << port);
+  Key previous = MakeKey (endPoint->GetLocalPort (), address, port);
+  Key current = MakeKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+  if (previous == current)
+    {
+      return;
+    }
+  RemoveFromIndex (previous, endPoint);
+  Entry entry;
+  entry.sequence = m_infos[endPoint].sequence;
+  entry.endPoint = endPoint;
+  AddToIndex (current, entry);
+}
+
+bool
+Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  sgi::hash_map<uint16_t, EndPoints>::iterator endPoints = m_ports.find (port);
+  if (endPoints == m_ports.end ())
+    {
+      return false;
+    }
+  for (EndPointsI i = endPoints->second.begin (); i != endPoints->second.end (); i++) 
     {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr) 
+      if ((*i)->GetLocalAddress () == addr) 
         {
           return true;
         }
@@ -83,8 +206,7 @@ Ipv4EndPointDemux::Allocate (void)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -99,8 +221,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -122,8 +243,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address, uint16_t port)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -132,23 +252,23 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  sgi::hash_map<Key, Entries, KeyHash>::iterator bucket =
+    m_index.find (MakeKey (localPort, peerAddress, peerPort));
+  if (bucket != m_index.end ())
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress) 
+      for (Entries::iterator i = bucket->second.begin (); i != bucket->second.end (); i++)
         {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
+          if (i->endPoint->GetLocalAddress () == localAddress)
+            {
+              NS_LOG_WARN ("No way we can allocate this end-point.");
+              /* no way we can allocate this end-point. */
+              return 0;
+            }
         }
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
 
   return endPoint;
 }
@@ -157,14 +277,10 @@ void
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this << endPoint);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  if (m_infos.find (endPoint) != m_infos.end ())
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      Remove (endPoint);
+      delete endPoint;
     }
 }
 
@@ -204,9 +320,33 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
   EndPoints retval4; // Exact match on all 4
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  // Only the endpoints of the destination port whose peer is the source
+  // or a wildcard can match: gather them in allocation order.
+  Entries candidates;
+  Key keys[4] = { MakeKey (dport, saddr, sport),
+                  MakeKey (dport, saddr, 0),
+                  MakeKey (dport, Ipv4Address::GetAny (), sport),
+                  MakeKey (dport, Ipv4Address::GetAny (), 0) };
+  for (uint32_t k = 0; k < 4; k++)
     {
-      Ipv4EndPoint* endP = *i;
+      if ((sport == 0 && (k == 1 || k == 3)) || (saddr == Ipv4Address::GetAny () && k >= 2))
+        {
+          continue; // same key as a previous one
+        }
+      sgi::hash_map<Key, Entries, KeyHash>::iterator bucket = m_index.find (keys[k]);
+      if (bucket != m_index.end ())
+        {
+          candidates.insert (candidates.end (), bucket->second.begin (), bucket->second.end ());
+        }
+    }
+  std::sort (candidates.begin (), candidates.end ());
+
+  bool broadcastChecked = false;
+  bool subnetDirected = false;
+  Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
+  for (Entries::const_iterator i = candidates.begin (); i != candidates.end (); i++) 
+    {
+      Ipv4EndPoint* endP = i->endPoint;
 
       NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
                                                  << " daddr=" << endP->GetLocalAddress ()
@@ -239,17 +379,20 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
               continue;
             }
         }
-      bool subnetDirected = false;
-      Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
-      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
+      if (!broadcastChecked)
         {
-          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
-              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+          // this only depends on the packet: do it once
+          for (uint32_t j = 0; j < incomingInterface->GetNAddresses (); j++)
             {
-              subnetDirected = true;
-              incomingInterfaceAddr = addr.GetLocal ();
+              Ipv4InterfaceAddress addr = incomingInterface->GetAddress (j);
+              if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+                  daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+                {
+                  subnetDirected = true;
+                  incomingInterfaceAddr = addr.GetLocal ();
+                }
             }
+          broadcastChecked = true;
         }
       bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
       NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
@@ -324,23 +467,32 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 {
   NS_LOG_FUNCTION (this << daddr << dport << saddr << sport);
 
+  // an exact match is in the bucket of the source
+  sgi::hash_map<Key, Entries, KeyHash>::iterator bucket =
+    m_index.find (MakeKey (dport, saddr, sport));
+  if (bucket != m_index.end ())
+    {
+      for (Entries::iterator i = bucket->second.begin (); i != bucket->second.end (); i++)
+        {
+          if (i->endPoint->GetLocalAddress () == daddr)
+            {
+              /* this is an exact match. */
+              return i->endPoint;
+            }
+        }
+    }
+
   // this code is a copy/paste version of an old BSD ip stack lookup
   // function.
+  sgi::hash_map<uint16_t, EndPoints>::iterator endPoints = m_ports.find (dport);
+  if (endPoints == m_ports.end ())
+    {
+      return 0;
+    }
   uint32_t genericity = 3;
   Ipv4EndPoint *generic = 0;
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (EndPointsI i = endPoints->second.begin (); i != endPoints->second.end (); i++) 
     {
-      if ((*i)->GetLocalPort () != dport) 
-        {
-          continue;
-        }
-      if ((*i)->GetLocalAddress () == daddr &&
-          (*i)->GetPeerPort () == sport &&
-          (*i)->GetPeerAddress () == saddr) 
-        {
-          /* this is an exact match. */
-          return *i;
-        }
       uint32_t tmp = 0;
       if ((*i)->GetLocalAddress () == Ipv4Address::GetAny ()) 
         {
@@ -23,8 +23,10 @@
 
 #include <stdint.h>
 #include <list>
+#include <vector>
 #include "ns3/ipv4-address.h"
-#include "ipv4-interface.h"
+#include "ns3/sgi-hashmap.h"
+#include "ns3/ipv4-interface.h"
 
 namespace ns3 {
 
@@ -38,6 +40,14 @@ class Ipv4EndPoint;
  * of endpoints, and has APIs to add and find endpoints in this demux.  This
  * code is shared in common to TCP and UDP protocols in ns3.  This demux
  * sits between ns3's layer four and the socket layer
+ *
+ * Besides the list of endpoints, which keeps their allocation order,
+ * the endpoints are indexed by local port and by (local port, peer
+ * address, peer port).  A lookup only visits the endpoints registered
+ * under the exact peer and under the three peer wildcard combinations
+ * of the destination port, instead of every endpoint of the node.  The
+ * endpoints notify the demux when their peer changes, so that they are
+ * always indexed under their current peer.
  */
 
 class Ipv4EndPointDemux {
@@ -161,6 +171,121 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
+
+  /**
+   * \brief The local port and the peer of an endpoint, which index it.
+   */
+  struct Key
+  {
+    uint16_t localPort;      //!< local port
+    Ipv4Address peerAddress; //!< peer address, may be the wildcard
+    uint16_t peerPort;       //!< peer port, may be the wildcard
+    /**
+     * \param o the other key
+     * \returns true if both keys are equal
+     */
+    bool operator == (const Key &o) const;
+  };
+
+  /**
+   * \brief Hash function class for the keys.
+   */
+  struct KeyHash
+  {
+    /**
+     * \param key the key
+     * \returns the hash of the key
+     */
+    size_t operator () (const Key &key) const;
+  };
+
+  /**
+   * \brief An endpoint and its allocation rank.
+   */
+  struct Entry
+  {
+    uint64_t sequence;      //!< allocation rank of the endpoint
+    Ipv4EndPoint *endPoint; //!< the endpoint
+    /**
+     * \param o the other entry
+     * \returns true if this entry was allocated before the other one
+     */
+    bool operator < (const Entry &o) const;
+  };
+
+  /**
+   * \brief Where an endpoint is stored in the containers of the demux.
+   */
+  struct Info
+  {
+    uint64_t sequence;       //!< allocation rank of the endpoint
+    EndPointsI position;     //!< position in m_endPoints
+    EndPointsI portPosition; //!< position in the list of its local port
+  };
+
+  /**
+   * \brief Hash function class for the endpoint pointers.
+   */
+  struct EndPointHash
+  {
+    /**
+     * \param endPoint the endpoint
+     * \returns the hash of the pointer
+     */
+    size_t operator () (const Ipv4EndPoint *endPoint) const;
+  };
+
+  /**
+   * \brief Endpoints sharing a key, sorted by allocation rank.
+   */
+  typedef std::vector<Entry> Entries;
+
+  /**
+   * \brief Register a new endpoint.
+   * \param endPoint the endpoint
+   */
+  void Insert (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Unregister an endpoint before it is deleted.
+   * \param endPoint the endpoint
+   */
+  void Remove (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Add an endpoint to the bucket of a key.
+   * \param key the key
+   * \param entry the endpoint and its allocation rank
+   */
+  void AddToIndex (const Key &key, const Entry &entry);
+
+  /**
+   * \brief Remove an endpoint from the bucket of a key.
+   * \param key the key
+   * \param endPoint the endpoint
+   */
+  void RemoveFromIndex (const Key &key, Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Move an endpoint to the bucket of its new peer.
+   *
+   * Called by Ipv4EndPoint::SetPeer.
+   *
+   * \param endPoint the endpoint
+   * \param address the previous peer address
+   * \param port the previous peer port
+   */
+  void PeerChanged (Ipv4EndPoint *endPoint, Ipv4Address address, uint16_t port);
+
+  /**
+   * \param localPort the local port
+   * \param peerAddress the peer address
+   * \param peerPort the peer port
+   * \returns the index key
+   */
+  static Key MakeKey (uint16_t localPort, Ipv4Address peerAddress, uint16_t peerPort);
+
 
   /**
    * \brief Allocate an ephemeral port.
@@ -187,6 +312,26 @@ private:
    * \brief A list of IPv4 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The end points, indexed by local port and peer.
+   */
+  sgi::hash_map<Key, Entries, KeyHash> m_index;
+
+  /**
+   * \brief The end points of each local port, in allocation order.
+   */
+  sgi::hash_map<uint16_t, EndPoints> m_ports;
+
+  /**
+   * \brief The position of each end point in the containers.
+   */
+  sgi::hash_map<Ipv4EndPoint *, Info, EndPointHash> m_infos;
+
+  /**
+   * \brief The allocation rank of the next end point.
+   */
+  uint64_t m_sequence;
 };
 
 } // namespace ns3
@@ -32,6 +32,7 @@ namespace ns3 {
 
 class Header;
 class Packet;
+class Ipv4EndPointDemux;
 
 /**
  * \brief A representation of an internet endpoint/connection
@@ -181,6 +182,8 @@ public:
   bool IsRxEnabled (void);
 
 private:
+  friend class Ipv4EndPointDemux;
+
   /**
    * \brief ForwardUp wrapper.
    * \param p packet
@@ -246,6 +249,13 @@ private:
    * \brief true if the endpoint can receive packets.
    */
   bool m_rxEnabled;
+
+  /**
+   * \brief The demultiplexer which indexes this endpoint, if any.
+   *
+   * It is notified when the peer of this endpoint changes.
+   */
+  Ipv4EndPointDemux *m_demux;
 };
 
 } // namespace ns3
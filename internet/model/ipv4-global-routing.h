@@ -28,6 +28,7 @@
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-route-trie.h"
 
 namespace ns3 {
 
@@ -263,6 +264,9 @@ private:
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
+  Ipv4RouteTrie m_hostRouteIndex;       //!< Index of m_hostRoutes
+  Ipv4RouteTrie m_networkRouteIndex;    //!< Index of m_networkRoutes
+  Ipv4RouteTrie m_ASexternalRouteIndex; //!< Index of m_ASexternalRoutes
 
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
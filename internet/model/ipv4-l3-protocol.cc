@@ -32,6 +32,7 @@
 #include "ns3/ipv4-header.h"
 #include "ns3/boolean.h"
 #include "ns3/ipv4-routing-table-entry.h"
+#include <algorithm>
 
 #include "loopback-net-device.h"
 #include "arp-l3-protocol.h"
@@ -240,17 +241,13 @@ Ipv4L3Protocol::DoDispose (void)
       it->second = 0;
     }
 
-  for (MapFragmentsTimers_t::iterator it = m_fragmentsTimers.begin (); it != m_fragmentsTimers.end (); it++)
+  m_fragments.clear ();
+  m_timeoutEventList.clear ();
+  if (m_timeoutEvent.IsRunning ())
     {
-      if (it->second.IsRunning ())
-        {
-          it->second.Cancel ();
-        }
+      m_timeoutEvent.Cancel ();
     }
 
-  m_fragments.clear ();
-  m_fragmentsTimers.clear ();
-
   Object::DoDispose ();
 }
 
@@ -761,7 +758,7 @@ Ipv4L3Protocol::BuildHeader (
   uint64_t src = source.Get ();
   uint64_t dst = destination.Get ();
   uint64_t srcDst = dst | (src << 32);
-  std::pair<uint64_t, uint8_t> key = std::make_pair (srcDst, protocol);
+  IdentificationKey_t key = std::make_pair (srcDst, protocol);
 
   if (mayFragment == true)
     {
@@ -1349,7 +1346,7 @@ Ipv4L3Protocol::ProcessFragment (Ptr<Packet>& packet, Ipv4Header& ipHeader, uint
 
   uint64_t addressCombination = uint64_t (ipHeader.GetSource ().Get ()) << 32 | uint64_t (ipHeader.GetDestination ().Get ());
   uint32_t idProto = uint32_t (ipHeader.GetIdentification ()) << 16 | uint32_t (ipHeader.GetProtocol ());
-  std::pair<uint64_t, uint32_t> key;
+  FragmentKey_t key;
   bool ret = false;
   Ptr<Packet> p = packet->Copy ();
 
@@ -1363,9 +1360,7 @@ Ipv4L3Protocol::ProcessFragment (Ptr<Packet>& packet, Ipv4Header& ipHeader, uint
     {
       fragments = Create<Fragments> ();
       m_fragments.insert (std::make_pair (key, fragments));
-      m_fragmentsTimers[key] = Simulator::Schedule (m_fragmentExpirationTimeout,
-                                                    &Ipv4L3Protocol::HandleFragmentsTimeout, this,
-                                                    key, ipHeader, iif);
+      fragments->SetTimeoutIter (SetTimeout (key, ipHeader, iif));
     }
   else
     {
@@ -1379,22 +1374,29 @@ Ipv4L3Protocol::ProcessFragment (Ptr<Packet>& packet, Ipv4Header& ipHeader, uint
   if ( fragments->IsEntire () )
     {
       packet = fragments->GetPacket ();
+      NS_LOG_LOGIC ("Removing the expiration of the fragments at " << Simulator::Now ().GetSeconds () << " due to complete packet");
+      // the expiration event is left alone: it will find the next
+      // expiration when it fires
+      m_timeoutEventList.erase (fragments->GetTimeoutIter ());
       fragments = 0;
       m_fragments.erase (key);
-      if (m_fragmentsTimers[key].IsRunning ())
-        {
-          NS_LOG_LOGIC ("Stopping WaitFragmentsTimer at " << Simulator::Now ().GetSeconds () << " due to complete packet");
-          m_fragmentsTimers[key].Cancel ();
-        }
-      m_fragmentsTimers.erase (key);
       ret = true;
     }
 
   return ret;
 }
 
+size_t
+Ipv4L3Protocol::KeyHash::operator () (const std::pair<uint64_t, uint32_t> &key) const
+{
+  uint64_t hash = key.first * 0x9e3779b97f4a7c15ULL ^ key.second;
+  return hash ^ (hash >> 32);
+}
+
 Ipv4L3Protocol::Fragments::Fragments ()
-  : m_moreFragment (0)
+  : m_moreFragment (0),
+    m_firstUncovered (m_fragments.end ()),
+    m_coveredEnd (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -1409,22 +1411,33 @@ Ipv4L3Protocol::Fragments::AddFragment (Ptr<Packet> fragment, uint16_t fragmentO
 {
   NS_LOG_FUNCTION (this << fragment << fragmentOffset << moreFragment);
 
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::iterator it;
+  std::multimap<uint16_t, Ptr<Packet> >::iterator it =
+    m_fragments.insert (std::make_pair (fragmentOffset, fragment));
+
+  std::multimap<uint16_t, Ptr<Packet> >::iterator next = it;
+  if (++next == m_fragments.end ())
+    {
+      m_moreFragment = moreFragment;
+    }
 
-  for (it = m_fragments.begin (); it != m_fragments.end (); it++)
+  if (m_firstUncovered == m_fragments.end () || fragmentOffset < m_firstUncovered->first)
     {
-      if (it->second > fragmentOffset)
+      if (fragmentOffset <= m_coveredEnd)
         {
-          break;
+          // the fragment starts in the covered part, which it may extend
+          m_coveredEnd = std::max (m_coveredEnd, fragment->GetSize () + fragmentOffset);
+        }
+      else
+        {
+          m_firstUncovered = it;
         }
     }
-
-  if (it == m_fragments.end ())
+  // fragments might overlap in strange ways
+  while (m_firstUncovered != m_fragments.end () && m_firstUncovered->first <= m_coveredEnd)
     {
-      m_moreFragment = moreFragment;
+      m_coveredEnd = std::max (m_coveredEnd, m_firstUncovered->second->GetSize () + m_firstUncovered->first);
+      m_firstUncovered++;
     }
-
-  m_fragments.insert (it, std::pair<Ptr<Packet>, uint16_t> (fragment, fragmentOffset));
 }
 
 bool
@@ -1432,29 +1445,7 @@ Ipv4L3Protocol::Fragments::IsEntire () const
 {
   NS_LOG_FUNCTION (this);
 
-  bool ret = !m_moreFragment && m_fragments.size () > 0;
-
-  if (ret)
-    {
-      uint16_t lastEndOffset = 0;
-
-      for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin (); it != m_fragments.end (); it++)
-        {
-          // overlapping fragments do exist
-          NS_LOG_LOGIC ("Checking overlaps " << lastEndOffset << " - " << it->second );
-
-          if (lastEndOffset < it->second)
-            {
-              ret = false;
-              break;
-            }
-          // fragments might overlap in strange ways
-          uint16_t fragmentEnd = it->first->GetSize () + it->second;
-          lastEndOffset = std::max ( lastEndOffset, fragmentEnd );
-        }
-    }
-
-  return ret;
+  return !m_moreFragment && m_fragments.size () > 0 && m_firstUncovered == m_fragments.end ();
 }
 
 Ptr<Packet>
@@ -1462,32 +1453,32 @@ Ipv4L3Protocol::Fragments::GetPacket () const
 {
   NS_LOG_FUNCTION (this);
 
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin ();
+  std::multimap<uint16_t, Ptr<Packet> >::const_iterator it = m_fragments.begin ();
 
-  Ptr<Packet> p = it->first->Copy ();
+  Ptr<Packet> p = it->second->Copy ();
   uint16_t lastEndOffset = p->GetSize ();
   it++;
 
   for ( ; it != m_fragments.end (); it++)
     {
-      if ( lastEndOffset > it->second )
+      if ( lastEndOffset > it->first )
         {
           // The fragments are overlapping.
           // We do not overwrite the "old" with the "new" because we do not know when each arrived.
           // This is different from what Linux does.
           // It is not possible to emulate a fragmentation attack.
-          uint32_t newStart = lastEndOffset - it->second;
-          if ( it->first->GetSize () > newStart )
+          uint32_t newStart = lastEndOffset - it->first;
+          if ( it->second->GetSize () > newStart )
             {
-              uint32_t newSize = it->first->GetSize () - newStart;
-              Ptr<Packet> tempFragment = it->first->CreateFragment (newStart, newSize);
+              uint32_t newSize = it->second->GetSize () - newStart;
+              Ptr<Packet> tempFragment = it->second->CreateFragment (newStart, newSize);
               p->AddAtEnd (tempFragment);
             }
         }
       else
         {
-          NS_LOG_LOGIC ("Adding: " << *(it->first) );
-          p->AddAtEnd (it->first);
+          NS_LOG_LOGIC ("Adding: " << *(it->second) );
+          p->AddAtEnd (it->second);
         }
       lastEndOffset = p->GetSize ();
     }
@@ -1500,29 +1491,29 @@ Ipv4L3Protocol::Fragments::GetPartialPacket () const
 {
   NS_LOG_FUNCTION (this);
   
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin ();
+  std::multimap<uint16_t, Ptr<Packet> >::const_iterator it = m_fragments.begin ();
 
   Ptr<Packet> p = Create<Packet> ();
   uint16_t lastEndOffset = 0;
 
-  if ( m_fragments.begin ()->second > 0 )
+  if ( m_fragments.begin ()->first > 0 )
     {
       return p;
     }
 
   for ( it = m_fragments.begin (); it != m_fragments.end (); it++)
     {
-      if ( lastEndOffset > it->second )
+      if ( lastEndOffset > it->first )
         {
-          uint32_t newStart = lastEndOffset - it->second;
-          uint32_t newSize = it->first->GetSize () - newStart;
-          Ptr<Packet> tempFragment = it->first->CreateFragment (newStart, newSize);
+          uint32_t newStart = lastEndOffset - it->first;
+          uint32_t newSize = it->second->GetSize () - newStart;
+          Ptr<Packet> tempFragment = it->second->CreateFragment (newStart, newSize);
           p->AddAtEnd (tempFragment);
         }
-      else if ( lastEndOffset == it->second )
+      else if ( lastEndOffset == it->first )
         {
-          NS_LOG_LOGIC ("Adding: " << *(it->first) );
-          p->AddAtEnd (it->first);
+          NS_LOG_LOGIC ("Adding: " << *(it->second) );
+          p->AddAtEnd (it->second);
         }
       lastEndOffset = p->GetSize ();
     }
@@ -1531,7 +1522,19 @@ Ipv4L3Protocol::Fragments::GetPartialPacket () const
 }
 
 void
-Ipv4L3Protocol::HandleFragmentsTimeout (std::pair<uint64_t, uint32_t> key, Ipv4Header & ipHeader, uint32_t iif)
+Ipv4L3Protocol::Fragments::SetTimeoutIter (FragmentsTimeoutsListI_t iter)
+{
+  m_timeoutIter = iter;
+}
+
+Ipv4L3Protocol::FragmentsTimeoutsListI_t
+Ipv4L3Protocol::Fragments::GetTimeoutIter () const
+{
+  return m_timeoutIter;
+}
+
+void
+Ipv4L3Protocol::HandleFragmentsTimeout (FragmentKey_t key, Ipv4Header & ipHeader, uint32_t iif)
 {
   NS_LOG_FUNCTION (this << &key << &ipHeader << iif);
 
@@ -1550,6 +1553,61 @@ Ipv4L3Protocol::HandleFragmentsTimeout (std::pair<uint64_t, uint32_t> key, Ipv4H
   it->second = 0;
 
   m_fragments.erase (key);
-  m_fragmentsTimers.erase (key);
 }
+
+Ipv4L3Protocol::FragmentsTimeoutsListI_t
+Ipv4L3Protocol::SetTimeout (FragmentKey_t key, Ipv4Header ipHeader, uint32_t iif)
+{
+  NS_LOG_FUNCTION (this << &ipHeader << iif);
+
+  FragmentsTimeout timeout;
+  timeout.expiration = Simulator::Now () + m_fragmentExpirationTimeout;
+  timeout.key = key;
+  timeout.ipHeader = ipHeader;
+  timeout.iif = iif;
+
+  // all the fragmented packets get the same timeout, so that the new
+  // one is normally the last to expire
+  FragmentsTimeoutsListI_t iter = m_timeoutEventList.end ();
+  while (iter != m_timeoutEventList.begin ())
+    {
+      FragmentsTimeoutsListI_t previous = iter;
+      previous--;
+      if (previous->expiration <= timeout.expiration)
+        {
+          break;
+        }
+      iter = previous;
+    }
+  iter = m_timeoutEventList.insert (iter, timeout);
+
+  if (iter == m_timeoutEventList.begin ()
+      && (!m_timeoutEvent.IsRunning () || Simulator::GetDelayLeft (m_timeoutEvent) > m_fragmentExpirationTimeout))
+    {
+      m_timeoutEvent.Cancel ();
+      m_timeoutEvent = Simulator::Schedule (m_fragmentExpirationTimeout, &Ipv4L3Protocol::HandleTimeout, this);
+    }
+  return iter;
+}
+
+void
+Ipv4L3Protocol::HandleTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time now = Simulator::Now ();
+  while (!m_timeoutEventList.empty () && m_timeoutEventList.front ().expiration <= now)
+    {
+      FragmentsTimeout timeout = m_timeoutEventList.front ();
+      m_timeoutEventList.pop_front ();
+      HandleFragmentsTimeout (timeout.key, timeout.ipHeader, timeout.iif);
+    }
+
+  if (!m_timeoutEventList.empty ())
+    {
+      m_timeoutEvent = Simulator::Schedule (m_timeoutEventList.front ().expiration - now,
+                                            &Ipv4L3Protocol::HandleTimeout, this);
+    }
+}
+
 } // namespace ns3
@@ -34,6 +34,7 @@
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/nstime.h"
 #include "ns3/simulator.h"
+#include "ns3/sgi-hashmap.h"
 
 class Ipv4L3ProtocolTestCase;
 
@@ -419,14 +420,32 @@ private:
    */
   bool ProcessFragment (Ptr<Packet>& packet, Ipv4Header & ipHeader, uint32_t iif);
 
+  /// Key identifying a fragmented packet: (src+dst addr, identification+proto)
+  typedef std::pair<uint64_t, uint32_t> FragmentKey_t;
+
   /**
    * \brief Process the timeout for packet fragments
    * \param key representing the packet fragments
    * \param ipHeader the IP header of the original packet
    * \param iif Input Interface
    */
-  void HandleFragmentsTimeout ( std::pair<uint64_t, uint32_t> key, Ipv4Header & ipHeader, uint32_t iif);
-  
+  void HandleFragmentsTimeout (FragmentKey_t key, Ipv4Header & ipHeader, uint32_t iif);
+
+  /// Key of the identification counters: (src+dst addr, proto)
+  typedef std::pair<uint64_t, uint32_t> IdentificationKey_t;
+
+  /**
+   * \brief Hash function class for the fragment and identification keys.
+   */
+  struct KeyHash
+  {
+    /**
+     * \param key the key
+     * \returns the hash of the key
+     */
+    size_t operator () (const std::pair<uint64_t, uint32_t> &key) const;
+  };
+
   /**
    * \brief Container of the IPv4 Interfaces.
    */
@@ -446,7 +465,7 @@ private:
   Ipv4InterfaceList m_interfaces; //!< List of IPv4 interfaces.
   uint8_t m_defaultTos;  //!< Default TOS
   uint8_t m_defaultTtl;  //!< Default TTL
-  std::map<std::pair<uint64_t, uint8_t>, uint16_t> m_identification; //!< Identification (for each {src, dst, proto} tuple)
+  sgi::hash_map<IdentificationKey_t, uint16_t, KeyHash> m_identification; //!< Identification (for each {src, dst, proto} tuple)
   Ptr<Node> m_node; //!< Node attached to stack.
 
   /// Trace of sent packets
@@ -475,6 +494,37 @@ private:
 
   SocketList m_sockets; //!< List of IPv4 raw sockets.
 
+  /**
+   * \brief The expiration of a fragmented packet.
+   */
+  struct FragmentsTimeout
+  {
+    Time expiration;     //!< expiration time
+    FragmentKey_t key;   //!< the key of the packet fragments
+    Ipv4Header ipHeader; //!< the IP header of the first received fragment
+    uint32_t iif;        //!< input interface of the first received fragment
+  };
+
+  /// Container of the fragment expirations, sorted by expiration time
+  typedef std::list<FragmentsTimeout> FragmentsTimeoutsList_t;
+  /// Iterator of the fragment expirations
+  typedef FragmentsTimeoutsList_t::iterator FragmentsTimeoutsListI_t;
+
+  /**
+   * \brief Set a new timeout for a fragmented packet.
+   * \param key the key of the packet fragments
+   * \param ipHeader the IP header of the first received fragment
+   * \param iif input interface of the first received fragment
+   * \returns an iterator to the expiration
+   */
+  FragmentsTimeoutsListI_t SetTimeout (FragmentKey_t key, Ipv4Header ipHeader, uint32_t iif);
+
+  /**
+   * \brief Expire the fragmented packets whose timeout is reached,
+   * and schedule the next expiration.
+   */
+  void HandleTimeout (void);
+
   /**
    * \class Fragments
    * \brief A Set of Fragment belonging to the same packet (src, dst, identification and proto)
@@ -518,6 +568,18 @@ public:
      */
     Ptr<Packet> GetPartialPacket () const;
 
+    /**
+     * \brief Set the expiration of the fragmented packet.
+     * \param iter an iterator to the expiration
+     */
+    void SetTimeoutIter (FragmentsTimeoutsListI_t iter);
+
+    /**
+     * \brief Get the expiration of the fragmented packet.
+     * \returns an iterator to the expiration
+     */
+    FragmentsTimeoutsListI_t GetTimeoutIter () const;
+
 private:
     /**
      * \brief True if other fragments will be sent.
@@ -525,20 +587,36 @@ private:
     bool m_moreFragment;
 
     /**
-     * \brief The current fragments.
+     * \brief The current fragments, by offset.
+     *
+     * Fragments with the same offset are kept in arrival order.
      */
-    std::list<std::pair<Ptr<Packet>, uint16_t> > m_fragments;
+    std::multimap<uint16_t, Ptr<Packet> > m_fragments;
 
+    /**
+     * \brief The first fragment which does not extend the part of the
+     * packet covered from offset 0 without holes.
+     */
+    std::multimap<uint16_t, Ptr<Packet> >::iterator m_firstUncovered;
+
+    /**
+     * \brief The end offset of the part covered by these fragments.
+     */
+    uint32_t m_coveredEnd;
+
+    /**
+     * \brief The expiration of the fragmented packet.
+     */
+    FragmentsTimeoutsListI_t m_timeoutIter;
   };
 
-  /// Container of fragments, stored as pairs(src+dst addr, src+dst port) / fragment
-  typedef std::map< std::pair<uint64_t, uint32_t>, Ptr<Fragments> > MapFragments_t;
-  /// Container of fragment timeout event, stored as pairs(src+dst addr, src+dst port) / EventId
-  typedef std::map< std::pair<uint64_t, uint32_t>, EventId > MapFragmentsTimers_t;
+  /// Container of fragments, stored as pairs(src+dst addr, identification+proto) / fragment
+  typedef sgi::hash_map<FragmentKey_t, Ptr<Fragments>, KeyHash> MapFragments_t;
 
   MapFragments_t       m_fragments; //!< Fragmented packets.
   Time                 m_fragmentExpirationTimeout; //!< Expiration timeout
-  MapFragmentsTimers_t m_fragmentsTimers; //!< Expiration events.
+  FragmentsTimeoutsList_t m_timeoutEventList; //!< Fragment expirations, sorted by time.
+  EventId              m_timeoutEvent; //!< Event of the earliest fragment expiration.
 
 };
 
@@ -0,0 +1,271 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ipv4-route-trie.h"
+#include "ipv4-routing-table-entry.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include <algorithm>
+
+namespace {
+
+/**
+ * \param a a route
+ * \param b another route
+ * \returns true if a was inserted before b
+ */
+bool
+InsertedBefore (const ns3::Ipv4RouteTrie::Route &a, const ns3::Ipv4RouteTrie::Route &b)
+{
+  return a.sequence < b.sequence;
+}
+
+} // anonymous namespace
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4RouteTrie");
+
+Ipv4RouteTrie::Ipv4RouteTrie ()
+  : m_root (0),
+    m_sequence (0),
+    m_nRoutes (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Ipv4RouteTrie::~Ipv4RouteTrie ()
+{
+  NS_LOG_FUNCTION (this);
+  Clear ();
+}
+
+uint32_t
+Ipv4RouteTrie::GetMask (uint8_t length)
+{
+  return length == 0 ? 0 : 0xffffffff << (32 - length);
+}
+
+uint32_t
+Ipv4RouteTrie::GetBit (uint32_t address, uint8_t bit)
+{
+  return (address >> (31 - bit)) & 1;
+}
+
+bool
+Ipv4RouteTrie::GetPrefixLength (Ipv4Mask mask, uint8_t &length)
+{
+  length = mask.GetPrefixLength ();
+  return mask.Get () == GetMask (length);
+}
+
+void
+Ipv4RouteTrie::Delete (Node *node)
+{
+  if (node != 0)
+    {
+      Delete (node->children[0]);
+      Delete (node->children[1]);
+      delete node;
+    }
+}
+
+void
+Ipv4RouteTrie::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  Delete (m_root);
+  m_root = 0;
+  m_irregular.clear ();
+  m_nRoutes = 0;
+}
+
+uint32_t
+Ipv4RouteTrie::GetNRoutes (void) const
+{
+  return m_nRoutes;
+}
+
+Ipv4RouteTrie::Node *
+Ipv4RouteTrie::FindOrCreate (uint32_t prefix, uint8_t length)
+{
+  Node **link = &m_root;
+  while (true)
+    {
+      Node *node = *link;
+      if (node == 0)
+        {
+          node = new Node;
+          node->prefix = prefix;
+          node->length = length;
+          node->children[0] = 0;
+          node->children[1] = 0;
+          *link = node;
+          return node;
+        }
+      // the length of the prefix shared by the node and the new prefix
+      uint8_t common = std::min (node->length, length);
+      uint32_t difference = (node->prefix ^ prefix) & GetMask (common);
+      if (difference != 0)
+        {
+          common = 0;
+          while (GetBit (difference, common) == 0)
+            {
+              common++;
+            }
+        }
+      if (common < node->length)
+        {
+          // the node is not a prefix of the new prefix: insert a
+          // node for their common prefix above it
+          Node *parent = new Node;
+          parent->prefix = prefix & GetMask (common);
+          parent->length = common;
+          parent->children[0] = 0;
+          parent->children[1] = 0;
+          parent->children[GetBit (node->prefix, common)] = node;
+          *link = parent;
+          if (common == length)
+            {
+              return parent;
+            }
+          link = &parent->children[GetBit (prefix, common)];
+          continue;
+        }
+      if (node->length == length)
+        {
+          return node;
+        }
+      link = &node->children[GetBit (prefix, node->length)];
+    }
+}
+
+void
+Ipv4RouteTrie::Insert (Ipv4RoutingTableEntry *entry, uint32_t metric)
+{
+  NS_LOG_FUNCTION (this << entry << metric);
+  Route route;
+  route.entry = entry;
+  route.metric = metric;
+  route.sequence = m_sequence++;
+  uint8_t length;
+  if (GetPrefixLength (entry->GetDestNetworkMask (), length))
+    {
+      uint32_t prefix = entry->GetDestNetwork ().Get () & GetMask (length);
+      FindOrCreate (prefix, length)->routes.push_back (route);
+    }
+  else
+    {
+      m_irregular.push_back (route);
+    }
+  m_nRoutes++;
+}
+
+void
+Ipv4RouteTrie::Remove (Ipv4RoutingTableEntry *entry)
+{
+  NS_LOG_FUNCTION (this << entry);
+  uint8_t length;
+  if (!GetPrefixLength (entry->GetDestNetworkMask (), length))
+    {
+      for (std::vector<Route>::iterator i = m_irregular.begin (); i != m_irregular.end (); i++)
+        {
+          if (i->entry == entry)
+            {
+              m_irregular.erase (i);
+              m_nRoutes--;
+              return;
+            }
+        }
+      NS_ASSERT_MSG (false, "Route " << entry << " is not in the index");
+      return;
+    }
+
+  uint32_t prefix = entry->GetDestNetwork ().Get () & GetMask (length);
+  // the links followed from the root to the node of the prefix, whose
+  // lengths are all different
+  Node **path[33];
+  uint32_t depth = 0;
+  Node **link = &m_root;
+  while (*link != 0 && (*link)->length < length)
+    {
+      path[depth++] = link;
+      link = &(*link)->children[GetBit (prefix, (*link)->length)];
+    }
+  Node *node = *link;
+  NS_ASSERT_MSG (node != 0 && node->length == length && node->prefix == prefix,
+                 "Route " << entry << " is not in the index");
+  for (std::vector<Route>::iterator i = node->routes.begin (); i != node->routes.end (); i++)
+    {
+      if (i->entry == entry)
+        {
+          node->routes.erase (i);
+          m_nRoutes--;
+          break;
+        }
+    }
+
+  // remove the nodes which do not hold routes nor split the trie
+  while (node->routes.empty () && (node->children[0] == 0 || node->children[1] == 0))
+    {
+      *link = node->children[0] != 0 ? node->children[0] : node->children[1];
+      delete node;
+      if (depth == 0)
+        {
+          break;
+        }
+      link = path[--depth];
+      node = *link;
+    }
+}
+
+void
+Ipv4RouteTrie::Lookup (Ipv4Address dest, std::vector<Route> &routes) const
+{
+  NS_LOG_FUNCTION (this << dest);
+  routes.clear ();
+  uint32_t address = dest.Get ();
+  bool sorted = true;
+  const Node *node = m_root;
+  while (node != 0 && (address & GetMask (node->length)) == node->prefix)
+    {
+      if (!node->routes.empty ())
+        {
+          sorted = sorted && (routes.empty () || routes.back ().sequence < node->routes.front ().sequence);
+          routes.insert (routes.end (), node->routes.begin (), node->routes.end ());
+        }
+      if (node->length == 32)
+        {
+          break;
+        }
+      node = node->children[GetBit (address, node->length)];
+    }
+  for (std::vector<Route>::const_iterator i = m_irregular.begin (); i != m_irregular.end (); i++)
+    {
+      Ipv4Mask mask = i->entry->GetDestNetworkMask ();
+      if (mask.IsMatch (dest, i->entry->GetDestNetwork ()))
+        {
+          sorted = false;
+          routes.push_back (*i);
+        }
+    }
+  if (!sorted)
+    {
+      std::sort (routes.begin (), routes.end (), &InsertedBefore);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef IPV4_ROUTE_TRIE_H
+#define IPV4_ROUTE_TRIE_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+class Ipv4RoutingTableEntry;
+
+/**
+ * \ingroup internet
+ *
+ * \brief A longest prefix match index of IPv4 routing table entries
+ *
+ * Ipv4StaticRouting and Ipv4GlobalRouting keep their routes in lists,
+ * which define the route indexes and the order in which the routes are
+ * considered. This index maps the destination of each route to a node
+ * of a path-compressed binary trie, so that the routes which match an
+ * address are found by walking at most 33 nodes instead of checking
+ * every route of the table. The routing protocols then apply their own
+ * selection rules (longest prefix, metric, ECMP) to the matching
+ * routes only.
+ *
+ * Routes are expected to be inserted in the order of their table, and
+ * Lookup returns them in this order. Routes whose network mask is not
+ * contiguous cannot be represented in the trie: they are kept aside
+ * and checked one by one.
+ *
+ * This is not a reference counted object, and it does not own the
+ * routing table entries.
+ */
+class Ipv4RouteTrie
+{
+public:
+  /**
+   * \brief A route of the index.
+   */
+  struct Route
+  {
+    Ipv4RoutingTableEntry *entry; //!< the routing table entry
+    uint32_t metric;              //!< the metric of the route
+    uint64_t sequence;            //!< the insertion rank of the route
+  };
+
+  Ipv4RouteTrie ();
+  ~Ipv4RouteTrie ();
+
+  /**
+   * \brief Add a route after all the routes of the index.
+   * \param entry the routing table entry
+   * \param metric the metric of the route
+   */
+  void Insert (Ipv4RoutingTableEntry *entry, uint32_t metric = 0);
+  /**
+   * \brief Remove a route.
+   *
+   * The entry must not have been modified since it was inserted.
+   *
+   * \param entry the routing table entry
+   */
+  void Remove (Ipv4RoutingTableEntry *entry);
+  /**
+   * \brief Remove all the routes.
+   */
+  void Clear (void);
+  /**
+   * \param dest a destination address
+   * \param routes the routes whose destination matches dest, in
+   *        insertion order. The vector is cleared first.
+   */
+  void Lookup (Ipv4Address dest, std::vector<Route> &routes) const;
+  /**
+   * \returns the number of routes in the index
+   */
+  uint32_t GetNRoutes (void) const;
+
+private:
+  /**
+   * \brief A node of the trie: a prefix and the routes to this prefix.
+   */
+  struct Node
+  {
+    uint32_t prefix;           //!< the prefix, host bits cleared
+    uint8_t length;            //!< the length of the prefix
+    Node *children[2];         //!< the longer prefixes, by the next bit
+    std::vector<Route> routes; //!< the routes to this prefix
+  };
+
+  /// Disallow copy
+  Ipv4RouteTrie (const Ipv4RouteTrie &);
+  /// Disallow assignment
+  Ipv4RouteTrie &operator = (const Ipv4RouteTrie &);
+
+  /**
+   * \param length a prefix length
+   * \returns the network mask of this length
+   */
+  static uint32_t GetMask (uint8_t length);
+  /**
+   * \param address an address
+   * \param bit the index of a bit, from the most significant one
+   * \returns the value of the bit
+   */
+  static uint32_t GetBit (uint32_t address, uint8_t bit);
+  /**
+   * \param mask a network mask
+   * \param length the prefix length of the mask, if it is contiguous
+   * \returns true if the mask is contiguous
+   */
+  static bool GetPrefixLength (Ipv4Mask mask, uint8_t &length);
+  /**
+   * \brief Find or create the node of a prefix.
+   * \param prefix the prefix, host bits cleared
+   * \param length the length of the prefix
+   * \returns the node of the prefix
+   */
+  Node *FindOrCreate (uint32_t prefix, uint8_t length);
+  /**
+   * \brief Delete a node and its descendants.
+   * \param node the node
+   */
+  static void Delete (Node *node);
+
+  Node *m_root;                   //!< the shortest prefix
+  std::vector<Route> m_irregular; //!< the routes with a non contiguous mask
+  uint64_t m_sequence;            //!< the rank of the next route
+  uint32_t m_nRoutes;             //!< the number of routes
+};
+
+} // namespace ns3
+
+#endif /* IPV4_ROUTE_TRIE_H */
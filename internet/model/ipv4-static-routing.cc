@@ -73,6 +73,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_networkRouteIndex.Insert (route, metric);
 }
 
 void 
@@ -87,6 +88,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_networkRouteIndex.Insert (route, metric);
 }
 
 void 
@@ -144,6 +146,7 @@ Ipv4StaticRouting::SetDefaultMulticastRoute (uint32_t outputInterface)
                                                         networkMask,
                                                         outputInterface);
   m_networkRoutes.push_back (make_pair (route,0));
+  m_networkRouteIndex.Insert (route, 0);
 }
 
 uint32_t 
@@ -240,12 +243,16 @@ Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
     }
 
 
-  for (NetworkRoutesI i = m_networkRoutes.begin (); 
-       i != m_networkRoutes.end (); 
+  // only the routes whose destination matches are considered, in the
+  // order of the table
+  std::vector<Ipv4RouteTrie::Route> routes;
+  m_networkRouteIndex.Lookup (dest, routes);
+  for (std::vector<Ipv4RouteTrie::Route>::const_iterator i = routes.begin (); 
+       i != routes.end (); 
        i++) 
     {
-      Ipv4RoutingTableEntry *j=i->first;
-      uint32_t metric =i->second;
+      Ipv4RoutingTableEntry *j=i->entry;
+      uint32_t metric =i->metric;
       Ipv4Mask mask = (j)->GetDestNetworkMask ();
       uint16_t masklen = mask.GetPrefixLength ();
       Ipv4Address entry = (j)->GetDestNetwork ();
@@ -443,6 +450,7 @@ Ipv4StaticRouting::RemoveRoute (uint32_t index)
     {
       if (tmp == index)
         {
+          m_networkRouteIndex.Remove (j->first);
           delete j->first;
           m_networkRoutes.erase (j);
           return;
@@ -593,6 +601,7 @@ Ipv4StaticRouting::DoDispose (void)
     {
       delete (j->first);
     }
+  m_networkRouteIndex.Clear ();
   for (MulticastRoutesI i = m_multicastRoutes.begin (); 
        i != m_multicastRoutes.end (); 
        i = m_multicastRoutes.erase (i)) 
@@ -631,6 +640,7 @@ Ipv4StaticRouting::NotifyInterfaceDown (uint32_t i)
     {
       if (it->first->GetInterface () == i)
         {
+          m_networkRouteIndex.Remove (it->first);
           delete it->first;
           it = m_networkRoutes.erase (it);
         }
@@ -678,6 +688,7 @@ Ipv4StaticRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
           && it->first->GetDestNetwork () == networkAddress
           && it->first->GetDestNetworkMask () == networkMask)
         {
+          m_networkRouteIndex.Remove (it->first);
           delete it->first;
           it = m_networkRoutes.erase (it);
         }
@@ -31,6 +31,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-route-trie.h"
 
 namespace ns3 {
 
@@ -430,6 +431,11 @@ private:
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief the longest prefix match index of m_networkRoutes.
+   */
+  Ipv4RouteTrie m_networkRouteIndex;
+
   /**
    * \brief the forwarding table for multicast.
    */
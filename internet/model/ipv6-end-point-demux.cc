@@ -21,6 +21,7 @@
 #include "ipv6-end-point-demux.h"
 #include "ipv6-end-point.h"
 #include "ns3/log.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -29,7 +30,8 @@ NS_LOG_COMPONENT_DEFINE ("Ipv6EndPointDemux");
 Ipv6EndPointDemux::Ipv6EndPointDemux ()
   : m_ephemeral (49152),
     m_portFirst (49152),
-    m_portLast (65535)
+    m_portLast (65535),
+    m_sequence (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -43,28 +45,166 @@ Ipv6EndPointDemux::~Ipv6EndPointDemux ()
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_index.clear ();
+  m_ports.clear ();
+  m_infos.clear ();
 }
 
-bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+bool Ipv6EndPointDemux::Key::operator == (const Key &o) const
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  return localPort == o.localPort
+         && peerPort == o.peerPort
+         && peerAddress == o.peerAddress;
+}
+
+size_t Ipv6EndPointDemux::KeyHash::operator () (const Key &key) const
+{
+  Ipv6AddressHash addressHash;
+  return addressHash (key.peerAddress) ^ (key.localPort * 2654435761U) ^ (key.peerPort << 16);
+}
+
+bool Ipv6EndPointDemux::Entry::operator < (const Entry &o) const
+{
+  return sequence < o.sequence;
+}
+
+size_t Ipv6EndPointDemux::EndPointHash::operator () (const Ipv6EndPoint *endPoint) const
+{
+  return reinterpret_cast<size_t> (endPoint) >> 3;
+}
+
+Ipv6EndPointDemux::Key Ipv6EndPointDemux::MakeKey (uint16_t localPort, Ipv6Address peerAddress, uint16_t peerPort)
+{
+  Key key;
+  key.localPort = localPort;
+  key.peerAddress = peerAddress;
+  key.peerPort = peerPort;
+  return key;
+}
+
+void Ipv6EndPointDemux::Insert (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Info info;
+  info.sequence = m_sequence++;
+  info.position = m_endPoints.insert (m_endPoints.end (), endPoint);
+  AddToPort (endPoint, info);
+  m_infos[endPoint] = info;
+  Entry entry;
+  entry.sequence = info.sequence;
+  entry.endPoint = endPoint;
+  AddToIndex (MakeKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (), endPoint->GetPeerPort ()),
+              entry);
+  endPoint->m_demux = this;
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+}
+
+void Ipv6EndPointDemux::Remove (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  sgi::hash_map<Ipv6EndPoint *, Info, EndPointHash>::iterator info = m_infos.find (endPoint);
+  NS_ASSERT (info != m_infos.end ());
+  RemoveFromIndex (MakeKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (), endPoint->GetPeerPort ()),
+                   endPoint);
+  sgi::hash_map<uint16_t, EndPoints>::iterator port = m_ports.find (endPoint->GetLocalPort ());
+  port->second.erase (info->second.portPosition);
+  if (port->second.empty ())
+    {
+      m_ports.erase (port);
+    }
+  m_endPoints.erase (info->second.position);
+  m_infos.erase (info);
+  endPoint->m_demux = 0;
+}
+
+void Ipv6EndPointDemux::AddToPort (Ipv6EndPoint *endPoint, Info &info)
+{
+  /* keep the allocation order: only a change of port inserts before the end */
+  EndPoints &endPoints = m_ports[endPoint->GetLocalPort ()];
+  EndPointsI position = endPoints.end ();
+  while (position != endPoints.begin ())
     {
-      if ((*i)->GetLocalPort  () == port)
+      EndPointsI previous = position;
+      previous--;
+      if (m_infos[*previous].sequence < info.sequence)
         {
-          return true;
+          break;
         }
+      position = previous;
     }
-  return false;
+  info.portPosition = endPoints.insert (position, endPoint);
+}
+
+void Ipv6EndPointDemux::AddToIndex (const Key &key, const Entry &entry)
+{
+  Entries &entries = m_index[key];
+  /* new end points have the highest rank: only a change inserts before the end */
+  entries.insert (std::upper_bound (entries.begin (), entries.end (), entry), entry);
+}
+
+void Ipv6EndPointDemux::RemoveFromIndex (const Key &key, Ipv6EndPoint *endPoint)
+{
+  sgi::hash_map<Key, Entries, KeyHash>::iterator bucket = m_index.find (key);
+  NS_ASSERT (bucket != m_index.end ());
+  Entries &entries = bucket->second;
+  for (Entries::iterator i = entries.begin (); i != entries.end (); i++)
+    {
+      if (i->endPoint == endPoint)
+        {
+          entries.erase (i);
+          break;
+        }
+    }
+  if (entries.empty ())
+    {
+      m_index.erase (bucket);
+    }
+}
+
+void Ipv6EndPointDemux::EndPointChanged (Ipv6EndPoint *endPoint, uint16_t localPort, Ipv6Address peerAddress, uint16_t peerPort)
+{
+  NS_LOG_FUNCTION (this << endPoint << localPort << peerAddress << peerPort);
+  Key previous = MakeKey (localPort, peerAddress, peerPort);
+  Key current = MakeKey (endPoint->GetLocalPort (), endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+  if (previous == current)
+    {
+      return;
+    }
+  Info &info = m_infos[endPoint];
+  if (localPort != endPoint->GetLocalPort ())
+    {
+      sgi::hash_map<uint16_t, EndPoints>::iterator port = m_ports.find (localPort);
+      port->second.erase (info.portPosition);
+      if (port->second.empty ())
+        {
+          m_ports.erase (port);
+        }
+      AddToPort (endPoint, info);
+    }
+  RemoveFromIndex (previous, endPoint);
+  Entry entry;
+  entry.sequence = info.sequence;
+  entry.endPoint = endPoint;
+  AddToIndex (current, entry);
+}
+
+bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool Ipv6EndPointDemux::LookupLocal (Ipv6Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  sgi::hash_map<uint16_t, EndPoints>::iterator endPoints = m_ports.find (port);
+  if (endPoints == m_ports.end ())
+    {
+      return false;
+    }
+  for (EndPointsI i = endPoints->second.begin (); i != endPoints->second.end (); i++)
     {
-      if ((*i)->GetLocalPort () == port
-          && (*i)->GetLocalAddress () == addr)
+      if ((*i)->GetLocalAddress () == addr)
         {
           return true;
         }
@@ -82,8 +222,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -97,8 +236,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -118,8 +256,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address, uint16_t port)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -127,23 +264,22 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t lo
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  sgi::hash_map<Key, Entries, KeyHash>::iterator bucket = m_index.find (MakeKey (localPort, peerAddress, peerPort));
+  if (bucket != m_index.end ())
     {
-      if ((*i)->GetLocalPort () == localPort
-          && (*i)->GetLocalAddress () == localAddress
-          && (*i)->GetPeerPort () == peerPort
-          && (*i)->GetPeerAddress () == peerAddress)
+      for (Entries::iterator i = bucket->second.begin (); i != bucket->second.end (); i++)
         {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
+          if (i->endPoint->GetLocalAddress () == localAddress)
+            {
+              NS_LOG_WARN ("No way we can allocate this end-point.");
+              /* no way we can allocate this end-point. */
+              return 0;
+            }
         }
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
 
   return endPoint;
 }
@@ -151,14 +287,10 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t lo
 void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  if (m_infos.find (endPoint) != m_infos.end ())
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      Remove (endPoint);
+      delete endPoint;
     }
 }
 
@@ -179,9 +311,30 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
   EndPoints retval4; /* Exact match on all 4 */
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  /* Only the end points of the destination port whose peer is the source
+     or a wildcard can match: gather them in allocation order. */
+  Entries candidates;
+  Key keys[4] = { MakeKey (dport, saddr, sport),
+                  MakeKey (dport, saddr, 0),
+                  MakeKey (dport, Ipv6Address::GetAny (), sport),
+                  MakeKey (dport, Ipv6Address::GetAny (), 0) };
+  for (uint32_t k = 0; k < 4; k++)
     {
-      Ipv6EndPoint* endP = *i;
+      if ((sport == 0 && (k == 1 || k == 3)) || (saddr == Ipv6Address::GetAny () && k >= 2))
+        {
+          continue; /* same key as a previous one */
+        }
+      sgi::hash_map<Key, Entries, KeyHash>::iterator bucket = m_index.find (keys[k]);
+      if (bucket != m_index.end ())
+        {
+          candidates.insert (candidates.end (), bucket->second.begin (), bucket->second.end ());
+        }
+    }
+  std::sort (candidates.begin (), candidates.end ());
+
+  for (Entries::const_iterator i = candidates.begin (); i != candidates.end (); i++)
+    {
+      Ipv6EndPoint* endP = i->endPoint;
 
       NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
                                                  << " daddr=" << endP->GetLocalAddress ()
@@ -293,25 +446,32 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
 
 Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport, Ipv6Address src, uint16_t sport)
 {
+  /* an exact match is in the bucket of the source */
+  sgi::hash_map<Key, Entries, KeyHash>::iterator bucket = m_index.find (MakeKey (dport, src, sport));
+  if (bucket != m_index.end ())
+    {
+      for (Entries::iterator i = bucket->second.begin (); i != bucket->second.end (); i++)
+        {
+          if (i->endPoint->GetLocalAddress () == dst)
+            {
+              /* this is an exact match. */
+              return i->endPoint;
+            }
+        }
+    }
+
+  sgi::hash_map<uint16_t, EndPoints>::iterator endPoints = m_ports.find (dport);
+  if (endPoints == m_ports.end ())
+    {
+      return 0;
+    }
   uint32_t genericity = 3;
   Ipv6EndPoint *generic = 0;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (EndPointsI i = endPoints->second.begin (); i != endPoints->second.end (); i++)
     {
       uint32_t tmp = 0;
 
-      if ((*i)->GetLocalPort () != dport)
-        {
-          continue;
-        }
-
-      if ((*i)->GetLocalAddress () == dst && (*i)->GetPeerPort () == sport
-          && (*i)->GetPeerAddress () == src)
-        {
-          /* this is an exact match. */
-          return *i;
-        }
-
       if ((*i)->GetLocalAddress () == Ipv6Address::GetAny ())
         {
           tmp++;
@@ -23,8 +23,10 @@
 
 #include <stdint.h>
 #include <list>
+#include <vector>
 #include "ns3/ipv6-address.h"
-#include "ipv6-interface.h"
+#include "ns3/sgi-hashmap.h"
+#include "ns3/ipv6-interface.h"
 
 namespace ns3 {
 
@@ -33,6 +35,11 @@ class Ipv6EndPoint;
 /**
  * \class Ipv6EndPointDemux
  * \brief Demultiplexor for end points.
+ *
+ * The end points are indexed by local port and by (local port, peer
+ * address, peer port), so that a lookup only visits the end points of
+ * the exact peer and of the peer wildcards. The end points notify the
+ * demultiplexor when their local port or their peer changes.
  */
 class Ipv6EndPointDemux
 {
@@ -146,6 +153,129 @@ public:
   EndPoints GetEndPoints () const;
 
 private:
+  friend class Ipv6EndPoint;
+
+  /**
+   * \brief The local port and the peer of an end point, which index it.
+   */
+  struct Key
+  {
+    uint16_t localPort;      /**< local port */
+    Ipv6Address peerAddress; /**< peer address, may be the wildcard */
+    uint16_t peerPort;       /**< peer port, may be the wildcard */
+    /**
+     * \param o the other key
+     * \return true if both keys are equal
+     */
+    bool operator == (const Key &o) const;
+  };
+
+  /**
+   * \brief Hash function class for the keys.
+   */
+  struct KeyHash
+  {
+    /**
+     * \param key the key
+     * \return the hash of the key
+     */
+    size_t operator () (const Key &key) const;
+  };
+
+  /**
+   * \brief An end point and its allocation rank.
+   */
+  struct Entry
+  {
+    uint64_t sequence;      /**< allocation rank of the end point */
+    Ipv6EndPoint *endPoint; /**< the end point */
+    /**
+     * \param o the other entry
+     * \return true if this entry was allocated before the other one
+     */
+    bool operator < (const Entry &o) const;
+  };
+
+  /**
+   * \brief Where an end point is stored in the containers.
+   */
+  struct Info
+  {
+    uint64_t sequence;       /**< allocation rank of the end point */
+    EndPointsI position;     /**< position in m_endPoints */
+    EndPointsI portPosition; /**< position in the list of its local port */
+  };
+
+  /**
+   * \brief Hash function class for the end point pointers.
+   */
+  struct EndPointHash
+  {
+    /**
+     * \param endPoint the end point
+     * \return the hash of the pointer
+     */
+    size_t operator () (const Ipv6EndPoint *endPoint) const;
+  };
+
+  /**
+   * \brief End points sharing a key, sorted by allocation rank.
+   */
+  typedef std::vector<Entry> Entries;
+
+  /**
+   * \brief Register a new end point.
+   * \param endPoint the end point
+   */
+  void Insert (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Unregister an end point before it is deleted.
+   * \param endPoint the end point
+   */
+  void Remove (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Add an end point to the list of its local port.
+   * \param endPoint the end point
+   * \param info where the end point is stored
+   */
+  void AddToPort (Ipv6EndPoint *endPoint, Info &info);
+
+  /**
+   * \brief Add an end point to the bucket of a key.
+   * \param key the key
+   * \param entry the end point and its allocation rank
+   */
+  void AddToIndex (const Key &key, const Entry &entry);
+
+  /**
+   * \brief Remove an end point from the bucket of a key.
+   * \param key the key
+   * \param endPoint the end point
+   */
+  void RemoveFromIndex (const Key &key, Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Move an end point to the buckets of its new port and peer.
+   *
+   * Called by Ipv6EndPoint::SetLocalPort and Ipv6EndPoint::SetPeer.
+   *
+   * \param endPoint the end point
+   * \param localPort the previous local port
+   * \param peerAddress the previous peer address
+   * \param peerPort the previous peer port
+   */
+  void EndPointChanged (Ipv6EndPoint *endPoint, uint16_t localPort, Ipv6Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \param localPort the local port
+   * \param peerAddress the peer address
+   * \param peerPort the peer port
+   * \return the index key
+   */
+  static Key MakeKey (uint16_t localPort, Ipv6Address peerAddress, uint16_t peerPort);
+
   /**
    * \brief Allocate a ephemeral port.
    * \return a port
@@ -171,6 +301,26 @@ private:
    * \brief A list of IPv6 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The end points, indexed by local port and peer.
+   */
+  sgi::hash_map<Key, Entries, KeyHash> m_index;
+
+  /**
+   * \brief The end points of each local port, in allocation order.
+   */
+  sgi::hash_map<uint16_t, EndPoints> m_ports;
+
+  /**
+   * \brief The position of each end point in the containers.
+   */
+  sgi::hash_map<Ipv6EndPoint *, Info, EndPointHash> m_infos;
+
+  /**
+   * \brief The allocation rank of the next end point.
+   */
+  uint64_t m_sequence;
 };
 
 } /* namespace ns3 */
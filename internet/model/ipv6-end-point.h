@@ -34,6 +34,7 @@ namespace ns3
 
 class Header;
 class Packet;
+class Ipv6EndPointDemux;
 
 /**
  * \brief A representation of an internet IPv6 endpoint/connection
@@ -190,6 +191,8 @@ public:
   bool IsRxEnabled (void);
 
 private:
+  friend class Ipv6EndPointDemux;
+
   /**
    * \brief ForwardUp wrapper.
    * \param p packet
@@ -254,6 +257,13 @@ private:
    * \brief true if the endpoint can receive packets.
    */
   bool m_rxEnabled;
+
+  /**
+   * \brief The demultiplexer which indexes this endpoint, if any.
+   *
+   * It is notified when the peer of this endpoint changes.
+   */
+  Ipv6EndPointDemux *m_demux;
 };
 
 } /* namespace ns3 */
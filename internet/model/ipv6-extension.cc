@@ -339,6 +339,11 @@ void Ipv6ExtensionFragment::DoDispose ()
     }
 
   m_fragments.clear ();
+  m_timeoutEventList.clear ();
+  if (m_timeoutEvent.IsRunning ())
+    {
+      m_timeoutEvent.Cancel ();
+    }
   Ipv6Extension::DoDispose ();
 }
 
@@ -376,7 +381,7 @@ uint8_t Ipv6ExtensionFragment::Process (Ptr<Packet>& packet,
   uint32_t identification = fragmentHeader.GetIdentification ();
   Ipv6Address src = ipv6Header.GetSourceAddress ();
 
-  std::pair<Ipv6Address, uint32_t> fragmentsId = std::pair<Ipv6Address, uint32_t> (src, identification);
+  FragmentKey_t fragmentsId = FragmentKey_t (src, identification);
   Ptr<Fragments> fragments;
 
   Ipv6Header ipHeader = ipv6Header;
@@ -387,10 +392,7 @@ uint8_t Ipv6ExtensionFragment::Process (Ptr<Packet>& packet,
     {
       fragments = Create<Fragments> ();
       m_fragments.insert (std::make_pair (fragmentsId, fragments));
-      EventId timeout = Simulator::Schedule (Seconds (60),
-                                             &Ipv6ExtensionFragment::HandleFragmentsTimeout, this,
-                                             fragmentsId, ipHeader);
-      fragments->SetTimeoutEventId (timeout);
+      fragments->SetTimeoutIter (SetTimeout (fragmentsId, ipHeader));
     }
   else
     {
@@ -409,7 +411,9 @@ uint8_t Ipv6ExtensionFragment::Process (Ptr<Packet>& packet,
   if (fragments->IsEntire ())
     {
       packet = fragments->GetPacket ();
-      fragments->CancelTimeout ();
+      // the expiration event is left alone: it will find the next
+      // expiration when it fires
+      m_timeoutEventList.erase (fragments->GetTimeoutIter ());
       m_fragments.erase (fragmentsId);
       stopProcessing = false;
     }
@@ -596,7 +600,7 @@ void Ipv6ExtensionFragment::GetFragments (Ptr<Packet> packet, uint32_t maxFragme
 }
 
 
-void Ipv6ExtensionFragment::HandleFragmentsTimeout (std::pair<Ipv6Address, uint32_t> fragmentsId,
+void Ipv6ExtensionFragment::HandleFragmentsTimeout (FragmentKey_t fragmentsId,
                                                     Ipv6Header ipHeader)
 {
   Ptr<Fragments> fragments;
@@ -623,8 +627,53 @@ void Ipv6ExtensionFragment::HandleFragmentsTimeout (std::pair<Ipv6Address, uint3
   m_fragments.erase (fragmentsId);
 }
 
+Ipv6ExtensionFragment::FragmentsTimeoutsListI_t Ipv6ExtensionFragment::SetTimeout (FragmentKey_t key, Ipv6Header ipHeader)
+{
+  Time timeout = Seconds (60);
+
+  FragmentsTimeout expiration;
+  expiration.expiration = Simulator::Now () + timeout;
+  expiration.key = key;
+  expiration.ipHeader = ipHeader;
+
+  // all the fragmented packets get the same timeout, so that the new
+  // one is the last to expire
+  FragmentsTimeoutsListI_t iter = m_timeoutEventList.insert (m_timeoutEventList.end (), expiration);
+
+  if (!m_timeoutEvent.IsRunning ())
+    {
+      m_timeoutEvent = Simulator::Schedule (timeout, &Ipv6ExtensionFragment::HandleTimeout, this);
+    }
+  return iter;
+}
+
+void Ipv6ExtensionFragment::HandleTimeout (void)
+{
+  Time now = Simulator::Now ();
+  while (!m_timeoutEventList.empty () && m_timeoutEventList.front ().expiration <= now)
+    {
+      FragmentsTimeout expiration = m_timeoutEventList.front ();
+      m_timeoutEventList.pop_front ();
+      HandleFragmentsTimeout (expiration.key, expiration.ipHeader);
+    }
+
+  if (!m_timeoutEventList.empty ())
+    {
+      m_timeoutEvent = Simulator::Schedule (m_timeoutEventList.front ().expiration - now,
+                                            &Ipv6ExtensionFragment::HandleTimeout, this);
+    }
+}
+
+size_t Ipv6ExtensionFragment::FragmentKeyHash::operator () (const FragmentKey_t &key) const
+{
+  Ipv6AddressHash addressHash;
+  return addressHash (key.first) ^ (key.second * 2654435761U);
+}
+
 Ipv6ExtensionFragment::Fragments::Fragments ()
-  : m_moreFragment (0)
+  : m_moreFragment (0),
+    m_firstNonContiguous (m_packetFragments.end ()),
+    m_contiguousEnd (0)
 {
 }
 
@@ -634,22 +683,30 @@ Ipv6ExtensionFragment::Fragments::~Fragments ()
 
 void Ipv6ExtensionFragment::Fragments::AddFragment (Ptr<Packet> fragment, uint16_t fragmentOffset, bool moreFragment)
 {
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::iterator it;
+  std::multimap<uint16_t, Ptr<Packet> >::iterator it =
+    m_packetFragments.insert (std::make_pair (fragmentOffset, fragment));
+
+  std::multimap<uint16_t, Ptr<Packet> >::iterator next = it;
+  if (++next == m_packetFragments.end ())
+    {
+      m_moreFragment = moreFragment;
+    }
 
-  for (it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
+  if (m_firstNonContiguous == m_packetFragments.end () || fragmentOffset < m_firstNonContiguous->first)
     {
-      if (it->second > fragmentOffset)
+      if (next != m_firstNonContiguous)
         {
-          break;
+          // the fragment overlaps the contiguous part, which now ends
+          // where the fragment following it starts
+          m_contiguousEnd = next->first;
         }
+      m_firstNonContiguous = it;
     }
-
-  if (it == m_packetFragments.end ())
+  while (m_firstNonContiguous != m_packetFragments.end () && m_firstNonContiguous->first == m_contiguousEnd)
     {
-      m_moreFragment = moreFragment;
+      m_contiguousEnd += m_firstNonContiguous->second->GetSize ();
+      m_firstNonContiguous++;
     }
-
-  m_packetFragments.insert (it, std::pair<Ptr<Packet>, uint16_t> (fragment, fragmentOffset));
 }
 
 void Ipv6ExtensionFragment::Fragments::SetUnfragmentablePart (Ptr<Packet> unfragmentablePart)
@@ -659,34 +716,17 @@ void Ipv6ExtensionFragment::Fragments::SetUnfragmentablePart (Ptr<Packet> unfrag
 
 bool Ipv6ExtensionFragment::Fragments::IsEntire () const
 {
-  bool ret = !m_moreFragment && m_packetFragments.size () > 0;
-
-  if (ret)
-    {
-      uint16_t lastEndOffset = 0;
-
-      for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
-        {
-          if (lastEndOffset != it->second)
-            {
-              ret = false;
-              break;
-            }
-
-          lastEndOffset += it->first->GetSize ();
-        }
-    }
-
-  return ret;
+  return !m_moreFragment && m_packetFragments.size () > 0
+         && m_firstNonContiguous == m_packetFragments.end ();
 }
 
 Ptr<Packet> Ipv6ExtensionFragment::Fragments::GetPacket () const
 {
   Ptr<Packet> p =  m_unfragmentable->Copy ();
 
-  for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
+  for (std::multimap<uint16_t, Ptr<Packet> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
     {
-      p->AddAtEnd (it->first);
+      p->AddAtEnd (it->second);
     }
 
   return p;
@@ -702,34 +742,33 @@ Ptr<Packet> Ipv6ExtensionFragment::Fragments::GetPartialPacket () const
     }
   else
     {
-      return p;
+      // the first fragment is missing: nothing can be sent back
+      return Create<Packet> ();
     }
 
   uint16_t lastEndOffset = 0;
 
-  for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
+  for (std::multimap<uint16_t, Ptr<Packet> >::const_iterator it = m_packetFragments.begin (); it != m_packetFragments.end (); it++)
     {
-      if (lastEndOffset != it->second)
+      if (lastEndOffset != it->first)
         {
           break;
         }
-      p->AddAtEnd (it->first);
-      lastEndOffset += it->first->GetSize ();
+      p->AddAtEnd (it->second);
+      lastEndOffset += it->second->GetSize ();
     }
 
   return p;
 }
 
-void Ipv6ExtensionFragment::Fragments::SetTimeoutEventId (EventId event)
+void Ipv6ExtensionFragment::Fragments::SetTimeoutIter (FragmentsTimeoutsListI_t iter)
 {
-  m_timeoutEventId = event;
-  return;
+  m_timeoutIter = iter;
 }
 
-void Ipv6ExtensionFragment::Fragments::CancelTimeout ()
+Ipv6ExtensionFragment::FragmentsTimeoutsListI_t Ipv6ExtensionFragment::Fragments::GetTimeoutIter () const
 {
-  m_timeoutEventId.Cancel ();
-  return;
+  return m_timeoutIter;
 }
 
 
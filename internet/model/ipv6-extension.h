@@ -35,6 +35,7 @@
 #include "ns3/ipv6-address.h"
 #include "ns3/ipv6-l3-protocol.h"
 #include "ns3/traced-callback.h"
+#include "ns3/sgi-hashmap.h"
 
 
 namespace ns3 {
@@ -300,6 +301,43 @@ protected:
   virtual void DoDispose ();
 
 private:
+  /**
+   * \brief Key identifying a fragmented packet: (source address, identification)
+   */
+  typedef std::pair<Ipv6Address, uint32_t> FragmentKey_t;
+
+  /**
+   * \brief Hash function class for the fragment keys.
+   */
+  struct FragmentKeyHash
+  {
+    /**
+     * \param key the key
+     * \returns the hash of the key
+     */
+    size_t operator () (const FragmentKey_t &key) const;
+  };
+
+  /**
+   * \brief The expiration of a fragmented packet.
+   */
+  struct FragmentsTimeout
+  {
+    Time expiration;     //!< expiration time
+    FragmentKey_t key;   //!< the key of the packet fragments
+    Ipv6Header ipHeader; //!< the IP header of the first received fragment
+  };
+
+  /**
+   * \brief Container of the fragment expirations, sorted by expiration time.
+   */
+  typedef std::list<FragmentsTimeout> FragmentsTimeoutsList_t;
+
+  /**
+   * \brief Iterator of the fragment expirations.
+   */
+  typedef FragmentsTimeoutsList_t::iterator FragmentsTimeoutsListI_t;
+
   /**
    * \class Fragments
    * \brief A Set of Fragment
@@ -350,14 +388,16 @@ public:
     Ptr<Packet> GetPartialPacket () const;
 
     /**
-     * \brief Set the Timeout EventId.
+     * \brief Set the expiration of the fragmented packet.
+     * \param iter an iterator to the expiration
      */
-    void SetTimeoutEventId (EventId event);
+    void SetTimeoutIter (FragmentsTimeoutsListI_t iter);
 
     /**
-     * \brief Cancel the timeout event
+     * \brief Get the expiration of the fragmented packet.
+     * \returns an iterator to the expiration
      */
-    void CancelTimeout ();
+    FragmentsTimeoutsListI_t GetTimeoutIter () const;
 
 private:
     /**
@@ -366,9 +406,22 @@ private:
     bool m_moreFragment;
 
     /**
-     * \brief The current fragments.
+     * \brief The current fragments, by offset.
+     *
+     * Fragments with the same offset are kept in arrival order.
+     */
+    std::multimap<uint16_t, Ptr<Packet> > m_packetFragments;
+
+    /**
+     * \brief The first fragment which does not follow the fragments
+     * contiguous from offset 0.
+     */
+    std::multimap<uint16_t, Ptr<Packet> >::iterator m_firstNonContiguous;
+
+    /**
+     * \brief The end offset of these contiguous fragments.
      */
-    std::list<std::pair<Ptr<Packet>, uint16_t> > m_packetFragments;
+    uint32_t m_contiguousEnd;
 
     /**
      * \brief The unfragmentable part.
@@ -376,9 +429,9 @@ private:
     Ptr<Packet> m_unfragmentable;
 
     /**
-     * \brief Timeout handler event
+     * \brief The expiration of the fragmented packet.
      */
-    EventId m_timeoutEventId;
+    FragmentsTimeoutsListI_t m_timeoutIter;
   };
 
   /**
@@ -386,7 +439,21 @@ private:
    * \param key representing the packet fragments
    * \param ipHeader the IP header of the original packet
    */
-  void HandleFragmentsTimeout (std::pair<Ipv6Address, uint32_t> key, Ipv6Header ipHeader);
+  void HandleFragmentsTimeout (FragmentKey_t key, Ipv6Header ipHeader);
+
+  /**
+   * \brief Set a new timeout for a fragmented packet.
+   * \param key the key of the packet fragments
+   * \param ipHeader the IP header of the first received fragment
+   * \returns an iterator to the expiration
+   */
+  FragmentsTimeoutsListI_t SetTimeout (FragmentKey_t key, Ipv6Header ipHeader);
+
+  /**
+   * \brief Expire the fragmented packets whose timeout is reached,
+   * and schedule the next expiration.
+   */
+  void HandleTimeout (void);
 
   /**
    * \brief Get the packet parts so far received.
@@ -407,12 +474,22 @@ private:
   /**
    * \brief Container for the packet fragments.
    */
-  typedef std::map<std::pair<Ipv6Address, uint32_t>, Ptr<Fragments> > MapFragments_t;
+  typedef sgi::hash_map<FragmentKey_t, Ptr<Fragments>, FragmentKeyHash> MapFragments_t;
 
   /**
    * \brief The hash of fragmented packets.
    */
   MapFragments_t m_fragments;
+
+  /**
+   * \brief The fragment expirations, sorted by time.
+   */
+  FragmentsTimeoutsList_t m_timeoutEventList;
+
+  /**
+   * \brief Event of the earliest fragment expiration.
+   */
+  EventId m_timeoutEvent;
 };
 
 /**
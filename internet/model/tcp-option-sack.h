@@ -0,0 +1,90 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_OPTION_SACK_H
+#define TCP_OPTION_SACK_H
+
+#include "ns3/tcp-option.h"
+#include "ns3/sequence-number.h"
+#include <list>
+
+namespace ns3 {
+
+/**
+ * \brief Defines the TCP option of kind 5 (selective acknowledgment option)
+ * as in \RFC{2018}
+ *
+ * The option lists the blocks of data the receiver holds beyond the
+ * cumulative acknowledgment. Each block is given by the sequence number of
+ * its first byte (left edge) and the sequence number following its last
+ * byte (right edge). The option space limits a segment to four blocks, or
+ * three next to a timestamp option.
+ */
+class TcpOptionSack : public TcpOption
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  /// A block of data received out of order: left and right edges
+  typedef std::pair<SequenceNumber32, SequenceNumber32> SackBlock;
+  /// A list of blocks, the most recently received first
+  typedef std::list<SackBlock> SackList;
+
+  TcpOptionSack ();
+  virtual ~TcpOptionSack ();
+
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+  virtual uint8_t GetKind (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+
+  /**
+   * \brief Append a block to the option
+   * \param block the block
+   */
+  void AddSackBlock (SackBlock block);
+
+  /**
+   * \brief Get the number of blocks in the option
+   * \return the number of blocks
+   */
+  uint32_t GetNumSackBlocks (void) const;
+
+  /**
+   * \brief Remove all the blocks
+   */
+  void ClearSackList (void);
+
+  /**
+   * \brief Get the blocks of the option
+   * \return the blocks, in the order of the option
+   */
+  const SackList &GetSackList (void) const;
+
+protected:
+  SackList m_sackList; //!< the blocks
+};
+
+} // namespace ns3
+
+#endif /* TCP_OPTION_SACK_H */
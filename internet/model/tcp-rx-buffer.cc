@@ -23,6 +23,8 @@
 #include "ns3/log.h"
 #include "tcp-rx-buffer.h"
 
+#include <algorithm>
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("TcpRxBuffer");
@@ -114,11 +116,28 @@ TcpRxBuffer::MaxRxSequence (void) const
     { // No data allowed beyond FIN
       return m_finSeq;
     }
+  // No data allowed beyond Rx window allowed
+  return HeadSequence () + SequenceNumber32 (m_maxBuffer);
+}
+
+SequenceNumber32
+TcpRxBuffer::HeadSequence (void) const
+{
+  if (m_availBytes > 0)
+    {
+      // the available data ends at RCV.NXT, or before the FIN
+      SequenceNumber32 end = m_nextRxSeq;
+      if (m_gotFin && m_finSeq < end)
+        {
+          end = m_finSeq;
+        }
+      return SequenceNumber32 (end.GetValue () - m_availBytes);
+    }
   else if (m_data.size ())
-    { // No data allowed beyond Rx window allowed
-      return m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+    {
+      return m_data.begin ()->first;
     }
-  return m_nextRxSeq + SequenceNumber32 (m_maxBuffer);
+  return m_nextRxSeq;
 }
 
 void
@@ -150,14 +169,20 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
 
   // Trim packet to fit Rx window specification
   if (headSeq < m_nextRxSeq) headSeq = m_nextRxSeq;
-  if (m_data.size ())
+  if (m_size > 0)
     {
-      SequenceNumber32 maxSeq = m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      SequenceNumber32 maxSeq = HeadSequence () + SequenceNumber32 (m_maxBuffer);
       if (maxSeq < tailSeq) tailSeq = maxSeq;
       if (tailSeq < headSeq) headSeq = tailSeq;
     }
-  // Remove overlapped bytes from packet
-  BufIterator i = m_data.begin ();
+  // Remove overlapped bytes from packet. The buffered data does not
+  // overlap itself: only the interval starting before headSeq, if any,
+  // and the following ones can overlap the packet.
+  BufIterator i = m_data.upper_bound (headSeq);
+  if (i != m_data.begin ())
+    {
+      --i;
+    }
   while (i != m_data.end () && i->first <= tailSeq)
     {
       SequenceNumber32 lastByteSeq = i->first + SequenceNumber32 (i->second->GetSize ());
@@ -193,24 +218,22 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
       p = p->CreateFragment (start, length);
       NS_ASSERT (length == p->GetSize ());
     }
-  // Insert packet into buffer
-  NS_ASSERT (m_data.find (headSeq) == m_data.end ()); // Shouldn't be there yet
-  m_data [ headSeq ] = p;
-  NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
-  // Update variables
   m_size += p->GetSize ();      // Occupancy
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  if (headSeq == m_nextRxSeq)
+    { // In sequence: the packet and the data it joins can be read
+      m_available.push_back (p);
+      m_availBytes += p->GetSize ();
+      m_nextRxSeq = tailSeq;
+      MergeOutOfOrder ();
+      RemoveSackBlocks ();
+      NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize () << " in sequence");
+    }
+  else
     {
-      if (i->first < m_nextRxSeq)
-        {
-          continue;
-        }
-      else if (i->first > m_nextRxSeq)
-        {
-          break;
-        };
-      m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      m_availBytes += i->second->GetSize ();
+      NS_ASSERT (m_data.find (headSeq) == m_data.end ()); // Shouldn't be there yet
+      m_data.insert (std::make_pair (headSeq, p));
+      AddSackBlock (headSeq, tailSeq);
+      NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize () << " out of sequence");
     }
   NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
   if (m_gotFin && m_nextRxSeq == m_finSeq)
@@ -220,6 +243,19 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
   return true;
 }
 
+void
+TcpRxBuffer::MergeOutOfOrder (void)
+{
+  BufIterator i = m_data.begin ();
+  while (i != m_data.end () && i->first == m_nextRxSeq)
+    {
+      m_available.push_back (i->second);
+      m_availBytes += i->second->GetSize ();
+      m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
+      m_data.erase (i++);
+    }
+}
+
 Ptr<Packet>
 TcpRxBuffer::Extract (uint32_t maxSize)
 {
@@ -228,32 +264,34 @@ TcpRxBuffer::Extract (uint32_t maxSize)
   uint32_t extractSize = std::min (maxSize, m_availBytes);
   NS_LOG_LOGIC ("Requested to extract " << extractSize << " bytes from TcpRxBuffer of size=" << m_size);
   if (extractSize == 0) return 0;  // No contiguous block to return
-  NS_ASSERT (m_data.size ()); // At least we have something to extract
-  Ptr<Packet> outPkt = Create<Packet> (); // The packet that contains all the data to return
-  BufIterator i;
+  NS_ASSERT (m_available.size ()); // At least we have something to extract
+  Ptr<Packet> outPkt; // The packet that contains all the data to return
   while (extractSize)
     { // Check the buffered data for delivery
-      i = m_data.begin ();
-      NS_ASSERT (i->first <= m_nextRxSeq); // in-sequence data expected
       // Check if we send the whole pkt or just a partial
-      uint32_t pktSize = i->second->GetSize ();
+      Ptr<Packet> next = m_available.front ();
+      uint32_t pktSize = next->GetSize ();
       if (pktSize <= extractSize)
         { // Whole packet is extracted
-          outPkt->AddAtEnd (i->second);
-          m_data.erase (i);
-          m_size -= pktSize;
-          m_availBytes -= pktSize;
-          extractSize -= pktSize;
+          m_available.pop_front ();
         }
       else
         { // Partial is extracted and done
-          outPkt->AddAtEnd (i->second->CreateFragment (0, extractSize));
-          m_data[i->first + SequenceNumber32 (extractSize)] = i->second->CreateFragment (extractSize, pktSize - extractSize);
-          m_data.erase (i);
-          m_size -= extractSize;
-          m_availBytes -= extractSize;
-          extractSize = 0;
+          m_available.front () = next->CreateFragment (extractSize, pktSize - extractSize);
+          next = next->CreateFragment (0, extractSize);
+          pktSize = extractSize;
+        }
+      if (outPkt == 0)
+        { // The segments were created by Add: nobody else holds them
+          outPkt = next;
         }
+      else
+        {
+          outPkt->AddAtEnd (next);
+        }
+      m_size -= pktSize;
+      m_availBytes -= pktSize;
+      extractSize -= pktSize;
     }
   if (outPkt->GetSize () == 0)
     {
@@ -261,8 +299,82 @@ TcpRxBuffer::Extract (uint32_t maxSize)
       return 0;
     }
   NS_LOG_LOGIC ("Extracted " << outPkt->GetSize ( ) << " bytes, bufsize=" << m_size
-                             << ", num pkts in buffer=" << m_data.size ());
+                             << ", num pkts in buffer=" << m_available.size () + m_data.size ());
   return outPkt;
 }
 
+void
+TcpRxBuffer::AddSackBlock (SequenceNumber32 head, SequenceNumber32 tail)
+{
+  NS_LOG_FUNCTION (this << head << tail);
+  // Merge the interval with the blocks it touches
+  std::map<SequenceNumber32, SequenceNumber32>::iterator i = m_blocks.upper_bound (head);
+  if (i != m_blocks.begin ())
+    {
+      --i;
+      if (i->second >= head)
+        {
+          head = i->first;
+          tail = std::max (tail, i->second);
+          m_blocks.erase (i++);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+  while (i != m_blocks.end () && i->first <= tail)
+    {
+      tail = std::max (tail, i->second);
+      m_blocks.erase (i++);
+    }
+  m_blocks.insert (std::make_pair (head, tail));
+
+  // The merged block comes first, and replaces the blocks it covers
+  TcpOptionSack::SackList::iterator j = m_sackList.begin ();
+  while (j != m_sackList.end ())
+    {
+      if (j->first < tail && head < j->second)
+        {
+          j = m_sackList.erase (j);
+        }
+      else
+        {
+          ++j;
+        }
+    }
+  m_sackList.push_front (std::make_pair (head, tail));
+  if (m_sackList.size () > 4)
+    {
+      m_sackList.pop_back ();
+    }
+}
+
+void
+TcpRxBuffer::RemoveSackBlocks (void)
+{
+  while (!m_blocks.empty () && m_blocks.begin ()->second <= m_nextRxSeq)
+    {
+      m_blocks.erase (m_blocks.begin ());
+    }
+  TcpOptionSack::SackList::iterator j = m_sackList.begin ();
+  while (j != m_sackList.end ())
+    {
+      if (j->second <= m_nextRxSeq)
+        {
+          j = m_sackList.erase (j);
+        }
+      else
+        {
+          ++j;
+        }
+    }
+}
+
+const TcpOptionSack::SackList &
+TcpRxBuffer::GetSackList (void) const
+{
+  return m_sackList;
+}
+
 } //namepsace ns3
@@ -22,11 +22,13 @@
 #define TCP_RX_BUFFER_H
 
 #include <map>
+#include <deque>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/sequence-number.h"
 #include "ns3/ptr.h"
 #include "ns3/tcp-header.h"
+#include "ns3/tcp-option-sack.h"
 
 namespace ns3 {
 class Packet;
@@ -36,6 +38,18 @@ class Packet;
  *
  * \brief class for the reordering buffer that keeps the data from lower layer, i.e.
  *        TcpL4Protocol, sent to the application
+ *
+ * The data which can be read by the application is kept apart from the
+ * data received out of order. The former is a queue of segments which
+ * is only appended to and extracted from its ends. The latter is a
+ * map of disjoint intervals keyed by their first sequence number, so
+ * that the overlaps of a new segment are found in logarithmic time, and
+ * the holes, which selective acknowledgments report, can be walked
+ * directly.
+ *
+ * The out of order data is also kept as merged blocks, the ones updated
+ * most recently first, from which the selective acknowledgments of
+ * \RFC{2018} are built.
  */
 class TcpRxBuffer : public Object
 {
@@ -124,6 +138,38 @@ public:
    * \returns a packet
    */
   Ptr<Packet> Extract (uint32_t maxSize);
+
+  /**
+   * \brief Get the blocks of data received out of order
+   *
+   * The block holding the last segment received out of order comes
+   * first, followed by the other blocks in the order they were last
+   * updated (\RFC{2018}, section 4).
+   *
+   * \returns the blocks, at most four of them
+   */
+  const TcpOptionSack::SackList &GetSackList (void) const;
+private:
+  /**
+   * \returns the sequence number of the first byte in the buffer
+   */
+  SequenceNumber32 HeadSequence (void) const;
+  /**
+   * \brief Move the out of order data which now follows the available
+   * data to the available data.
+   */
+  void MergeOutOfOrder (void);
+  /**
+   * \brief Add an interval of data received out of order to the blocks
+   * \param head the sequence number of the first byte
+   * \param tail the sequence number following the last byte
+   */
+  void AddSackBlock (SequenceNumber32 head, SequenceNumber32 tail);
+  /**
+   * \brief Remove the blocks which are now below RCV.NXT
+   */
+  void RemoveSackBlocks (void);
+
 public:
   /// container for data stored in the buffer
   typedef std::map<SequenceNumber32, Ptr<Packet> >::iterator BufIterator;
@@ -133,7 +179,10 @@ public:
   uint32_t m_size;                           //!< Number of total data bytes in the buffer, not necessarily contiguous
   uint32_t m_maxBuffer;                      //!< Upper bound of the number of data bytes in buffer (RCV.WND)
   uint32_t m_availBytes;                     //!< Number of bytes available to read, i.e. contiguous block at head
-  std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Corresponding data (may be null)
+  std::deque<Ptr<Packet> > m_available;      //!< Data available to read, in order
+  std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Data received out of order, beyond RCV.NXT
+  std::map<SequenceNumber32, SequenceNumber32> m_blocks; //!< Merged intervals of m_data: first byte to next byte
+  TcpOptionSack::SackList m_sackList;        //!< The blocks most recently updated, most recent first
 };
 
 } //namepsace ns3
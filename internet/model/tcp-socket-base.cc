@@ -49,6 +49,8 @@
 #include "tcp-header.h"
 #include "tcp-option-winscale.h"
 #include "tcp-option-ts.h"
+#include "tcp-option-sack-permitted.h"
+#include "tcp-option-sack.h"
 #include "rtt-estimator.h"
 
 #include <math.h>
@@ -60,6 +62,9 @@ NS_LOG_COMPONENT_DEFINE ("TcpSocketBase");
 
 NS_OBJECT_ENSURE_REGISTERED (TcpSocketBase);
 
+/// The DupThresh of RFC 6675: the duplicate ACKs which reveal a loss
+static const uint32_t SACK_DUP_THRESHOLD = 3;
+
 TypeId
 TcpSocketBase::GetTypeId (void)
 {
@@ -96,6 +101,12 @@ TcpSocketBase::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&TcpSocketBase::m_timestampEnabled),
                    MakeBooleanChecker ())
+    .AddAttribute ("Sack",
+                   "Enable or disable the selective acknowledgments (RFC 2018) "
+                   "and the SACK based loss recovery (RFC 6675)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_sackEnabled),
+                   MakeBooleanChecker ())
     .AddAttribute ("MinRto",
                    "Minimum retransmit timeout value",
                    TimeValue (Seconds (1.0)), // RFC 6298 says min RTO=1 sec, but Linux uses 200ms. See http://www.postel.org/pipermail/end2end-interest/2004-November/004402.html
@@ -190,7 +201,11 @@ TcpSocketBase::TcpSocketBase (void)
     m_sndScaleFactor (0),
     m_rcvScaleFactor (0),
     m_timestampEnabled (true),
-    m_timestampToEcho (0)
+    m_timestampToEcho (0),
+    m_sackEnabled (false),
+    m_inSackRecovery (false),
+    m_recoveryPoint (0),
+    m_highRxt (0)
 
 {
   NS_LOG_FUNCTION (this);
@@ -237,7 +252,11 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_sndScaleFactor (sock.m_sndScaleFactor),
     m_rcvScaleFactor (sock.m_rcvScaleFactor),
     m_timestampEnabled (sock.m_timestampEnabled),
-    m_timestampToEcho (sock.m_timestampToEcho)
+    m_timestampToEcho (sock.m_timestampToEcho),
+    m_sackEnabled (sock.m_sackEnabled),
+    m_inSackRecovery (false),
+    m_recoveryPoint (0),
+    m_highRxt (0)
 
 {
   NS_LOG_FUNCTION (this);
@@ -1172,7 +1191,14 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
       if (tcpHeader.GetAckNumber () < m_nextTxSequence && packet->GetSize() == 0)
         {
           NS_LOG_LOGIC ("Dupack of " << tcpHeader.GetAckNumber ());
-          DupAck (tcpHeader, ++m_dupAckCount);
+          if (m_sackEnabled)
+            {
+              SackDupAck (++m_dupAckCount);
+            }
+          else
+            {
+              DupAck (tcpHeader, ++m_dupAckCount);
+            }
         }
       // otherwise, the ACK is precisely equal to the nextTxSequence
       NS_ASSERT (tcpHeader.GetAckNumber () <= m_nextTxSequence);
@@ -1180,7 +1206,20 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
   else if (tcpHeader.GetAckNumber () > m_txBuffer->HeadSequence ())
     { // Case 3: New ACK, reset m_dupAckCount and update m_txBuffer
       NS_LOG_LOGIC ("New ack of " << tcpHeader.GetAckNumber ());
-      NewAck (tcpHeader.GetAckNumber ());
+      if (m_inSackRecovery && tcpHeader.GetAckNumber () < m_recoveryPoint)
+        { // Partial ACK: the window does not grow during the recovery
+          TcpSocketBase::NewAck (tcpHeader.GetAckNumber ());
+        }
+      else
+        {
+          if (m_inSackRecovery)
+            { // RFC 6675, section 5, step (A)
+              m_inSackRecovery = false;
+              m_cWnd = m_ssThresh;
+              NS_LOG_INFO ("Leaving SACK recovery with cwnd set to " << m_cWnd);
+            }
+          NewAck (tcpHeader.GetAckNumber ());
+        }
       m_dupAckCount = 0;
     }
   // If there is any data piggybacked, store it into m_rxBuffer
@@ -1888,7 +1927,7 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
   NS_LOG_FUNCTION (this << seq << maxSize << withAck);
 
   bool isRetransmission = false;
-  if ( seq == m_txBuffer->HeadSequence () )
+  if ( seq == m_txBuffer->HeadSequence () || (m_inSackRecovery && seq < m_highTxMark))
     {
       isRetransmission = true;
     }
@@ -2039,6 +2078,10 @@ TcpSocketBase::SendPendingData (bool withAck)
       NS_LOG_INFO ("TcpSocketBase::SendPendingData: No endpoint; m_shutdownSend=" << m_shutdownSend);
       return false; // Is this the right way to handle this condition?
     }
+  if (m_inSackRecovery)
+    {
+      return SendSackPendingData (withAck);
+    }
   uint32_t nPacketsSent = 0;
   while (m_txBuffer->SizeFromSequence (m_nextTxSequence))
     {
@@ -2074,6 +2117,52 @@ TcpSocketBase::SendPendingData (bool withAck)
   return (nPacketsSent > 0);
 }
 
+/* Send what the pipe allows during a SACK based loss recovery, i.e. the
+ * step (C) of RFC 6675 section 5
+ */
+bool
+TcpSocketBase::SendSackPendingData (bool withAck)
+{
+  NS_LOG_FUNCTION (this << withAck);
+  uint32_t nPacketsSent = 0;
+  while (true)
+    {
+      uint32_t pipe = m_txBuffer->BytesInFlight (m_highTxMark, m_highRxt, SACK_DUP_THRESHOLD, m_segmentSize);
+      if (m_cWnd.Get () < pipe + m_segmentSize)
+        {
+          NS_LOG_LOGIC ("Pipe " << pipe << " fills cwnd " << m_cWnd);
+          break;
+        }
+      // NextSeg (): a lost segment, new data, or a segment below the
+      // highest block acknowledged, in this order
+      SequenceNumber32 seq;
+      uint32_t length;
+      uint32_t inWindow = m_nextTxSequence.Get () - m_txBuffer->HeadSequence ();
+      uint32_t newData = std::min (m_txBuffer->SizeFromSequence (m_nextTxSequence),
+                                   m_rWnd.Get () > inWindow ? m_rWnd.Get () - inWindow : 0);
+      if (m_txBuffer->NextSeg (m_highRxt, true, SACK_DUP_THRESHOLD, m_segmentSize, seq, length)
+          || (newData == 0
+              && m_txBuffer->NextSeg (m_highRxt, false, SACK_DUP_THRESHOLD, m_segmentSize, seq, length)))
+        {
+          NS_LOG_LOGIC ("Retransmit " << length << " bytes at " << seq << " in SACK recovery");
+          uint32_t sz = SendDataPacket (seq, length, withAck);
+          m_highRxt = seq + SequenceNumber32 (sz);
+        }
+      else if (newData > 0)
+        {
+          uint32_t sz = SendDataPacket (m_nextTxSequence, std::min (newData, m_segmentSize), withAck);
+          m_nextTxSequence += sz;
+        }
+      else
+        {
+          break;
+        }
+      nPacketsSent++;
+    }
+  NS_LOG_LOGIC ("SendSackPendingData sent " << nPacketsSent << " packets");
+  return (nPacketsSent > 0);
+}
+
 uint32_t
 TcpSocketBase::UnAckDataCount ()
 {
@@ -2305,6 +2394,11 @@ TcpSocketBase::ReTxTimeout ()
     {
       return;
     }
+  if (m_sackEnabled)
+    { // The receiver may have dropped the data it acknowledged selectively
+      m_inSackRecovery = false;
+      m_txBuffer->ResetScoreboard ();
+    }
 
   Retransmit ();
 }
@@ -2581,6 +2675,10 @@ TcpSocketBase::ReadOptions (const TcpHeader& header)
               ScaleSsThresh (m_sndScaleFactor);
             }
         }
+      if (m_sackEnabled)
+        {
+          m_sackEnabled = header.HasOption (TcpOption::SACKPERMITTED);
+        }
     }
 
   bool timestampAttribute = m_timestampEnabled;
@@ -2591,6 +2689,11 @@ TcpSocketBase::ReadOptions (const TcpHeader& header)
       m_timestampEnabled = true;
       ProcessOptionTimestamp (header.GetOption (TcpOption::TS));
     }
+
+  if (m_sackEnabled && (header.GetFlags () & TcpHeader::ACK) && header.HasOption (TcpOption::SACK))
+    {
+      ProcessOptionSack (header.GetOption (TcpOption::SACK));
+    }
 }
 
 void
@@ -2604,10 +2707,21 @@ TcpSocketBase::AddOptions (TcpHeader& header)
       AddOptionWScale (header);
     }
 
+  if (m_sackEnabled && (header.GetFlags () & TcpHeader::SYN))
+    {
+      header.AppendOption (CreateObject<TcpOptionSackPermitted> ());
+    }
+
   if (m_timestampEnabled)
     {
       AddOptionTimestamp (header);
     }
+
+  // The SACK option takes the space left by the others
+  if (m_sackEnabled && !(header.GetFlags () & TcpHeader::SYN))
+    {
+      AddOptionSack (header);
+    }
 }
 
 void
@@ -2702,6 +2816,81 @@ TcpSocketBase::AddOptionTimestamp (TcpHeader& header)
                option->GetTimestamp () << " echo=" << m_timestampToEcho);
 }
 
+void
+TcpSocketBase::ProcessOptionSack (const Ptr<const TcpOption> option)
+{
+  NS_LOG_FUNCTION (this << option);
+
+  Ptr<const TcpOptionSack> sack = DynamicCast<const TcpOptionSack> (option);
+  if (m_txBuffer->UpdateScoreboard (sack->GetSackList ()))
+    {
+      NS_LOG_INFO (m_node->GetId () << " Got " << sack->GetNumSackBlocks () << " SACK blocks, "
+                                    << m_txBuffer->GetSacked () << " bytes acknowledged selectively");
+    }
+}
+
+void
+TcpSocketBase::AddOptionSack (TcpHeader& header)
+{
+  NS_LOG_FUNCTION (this << header);
+
+  const TcpOptionSack::SackList &list = m_rxBuffer->GetSackList ();
+  if (list.empty ())
+    {
+      return;
+    }
+  // The header length is in words, and includes the padding of the options
+  uint32_t space = 40 - (header.GetLength () * 4 - 20);
+  if (space < 10)
+    {
+      return;
+    }
+  Ptr<TcpOptionSack> option = CreateObject<TcpOptionSack> ();
+  for (TcpOptionSack::SackList::const_iterator i = list.begin ();
+       i != list.end () && option->GetSerializedSize () + 8 <= space; ++i)
+    {
+      option->AddSackBlock (*i);
+    }
+  header.AppendOption (option);
+  NS_LOG_INFO (m_node->GetId () << " Add option SACK, " << option->GetNumSackBlocks () << " blocks");
+}
+
+void
+TcpSocketBase::SackDupAck (uint32_t count)
+{
+  NS_LOG_FUNCTION (this << count);
+  if (m_inSackRecovery)
+    { // RFC 6675, section 5, step (C)
+      if (!m_sendPendingDataEvent.IsRunning ())
+        {
+          SendPendingData (m_connected);
+        }
+      return;
+    }
+  if (count < SACK_DUP_THRESHOLD
+      && !m_txBuffer->IsLost (m_txBuffer->HeadSequence (), SACK_DUP_THRESHOLD, m_segmentSize))
+    {
+      return;
+    }
+  // RFC 6675, section 5, step (4): enter the recovery, retransmit the
+  // first segment and send what the pipe allows
+  m_recoveryPoint = m_highTxMark;
+  m_ssThresh = std::max (2 * m_segmentSize, BytesInFlight () / 2);
+  m_cWnd = m_ssThresh;
+  m_inSackRecovery = true;
+  NS_LOG_INFO ("Enter SACK recovery up to " << m_recoveryPoint << ". Reset cwnd to " << m_cWnd);
+  SequenceNumber32 head = m_txBuffer->HeadSequence ();
+  SequenceNumber32 seq;
+  uint32_t length;
+  if (!m_txBuffer->NextSeg (head, false, SACK_DUP_THRESHOLD, m_segmentSize, seq, length))
+    {
+      length = m_segmentSize;
+    }
+  uint32_t sz = SendDataPacket (head, length, true);
+  m_highRxt = head + SequenceNumber32 (sz);
+  SendPendingData (m_connected);
+}
+
 void TcpSocketBase::UpdateWindowSize (const TcpHeader &header)
 {
   NS_LOG_FUNCTION (this << header);
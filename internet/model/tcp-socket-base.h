@@ -339,6 +339,18 @@ protected:
    */
   bool SendPendingData (bool withAck = false);
 
+  /**
+   * \brief Send what the pipe allows during a SACK based loss recovery
+   *
+   * This is the step (C) of \RFC{6675} section 5: the lost segments are
+   * retransmitted first, then new data is sent, then the other segments
+   * below the highest block acknowledged are retransmitted.
+   *
+   * \param withAck forces an ACK to be sent
+   * \returns true if some data have been sent
+   */
+  bool SendSackPendingData (bool withAck);
+
   /**
    * \brief Extract at most maxSize bytes from the TxBuffer at sequence seq, add the
    *        TCP header, and send to TcpL4Protocol
@@ -584,6 +596,18 @@ protected:
    */
   virtual void DupAck (const TcpHeader& tcpHeader, uint32_t count) = 0;
 
+  /**
+   * \brief Received dupack when SACK is enabled
+   *
+   * Enter the SACK based loss recovery of \RFC{6675} on the third
+   * duplicate ACK, or when the scoreboard shows the first segment is lost,
+   * instead of the fast retransmit of DupAck (). In the recovery, send
+   * what the pipe allows.
+   *
+   * \param count counter of duplicate ACKs
+   */
+  void SackDupAck (uint32_t count);
+
   /**
    * \brief Call Retransmit() upon RTO event
    */
@@ -685,6 +709,22 @@ protected:
    */
   void AddOptionTimestamp (TcpHeader& header);
 
+  /**
+   * \brief Update the scoreboard with the SACK option from the other side
+   *
+   * \param option SACK option from the packet
+   */
+  void ProcessOptionSack (const Ptr<const TcpOption> option);
+  /**
+   * \brief Add the SACK option to the header
+   *
+   * Add the blocks of data received out of order, the most recent first,
+   * as many as the space left by the other options allows.
+   *
+   * \param header TcpHeader to which add the option to
+   */
+  void AddOptionSack (TcpHeader& header);
+
   /**
    * \brief Scale the initial SsThresh value to the correct one
    *
@@ -773,6 +813,11 @@ protected:
   bool     m_timestampEnabled;    //!< Timestamp option enabled
   uint32_t m_timestampToEcho;     //!< Timestamp to echo
 
+  bool             m_sackEnabled;    //!< SACK option enabled
+  bool             m_inSackRecovery; //!< SACK based loss recovery in progress
+  SequenceNumber32 m_recoveryPoint;  //!< Highest sequence number sent when the recovery started (RecoveryPoint)
+  SequenceNumber32 m_highRxt;        //!< Sequence number following the highest byte retransmitted (HighRxt)
+
   EventId m_sendPendingDataEvent; //!< micro-delay event to send pending data
 };
 
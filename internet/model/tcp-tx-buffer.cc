@@ -57,7 +57,7 @@ TcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpTxBuffer::TcpTxBuffer (uint32_t n)
-  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_data (0)
+  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_firstByteOffset (0), m_sackedBytes (0)
 {
 }
 
@@ -111,7 +111,10 @@ TcpTxBuffer::Add (Ptr<Packet> p)
     {
       if (p->GetSize () > 0)
         {
-          m_data.push_back (p);
+          Chunk chunk;
+          chunk.offset = m_firstByteOffset + m_size;
+          chunk.packet = p;
+          m_data.push_back (chunk);
           m_size += p->GetSize ();
           NS_LOG_LOGIC ("Updated size=" << m_size << ", lastSeq=" << m_firstByteSeq + SequenceNumber32 (m_size));
         }
@@ -133,6 +136,12 @@ TcpTxBuffer::SizeFromSequence (const SequenceNumber32& seq) const
   return lastSeq - seq;
 }
 
+bool
+TcpTxBuffer::OffsetBefore (uint64_t offset, const Chunk &chunk)
+{
+  return offset < chunk.offset;
+}
+
 Ptr<Packet>
 TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
 {
@@ -148,55 +157,33 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
     }
 
   // Extract data from the buffer and return
-  uint32_t offset = seq - m_firstByteSeq.Get ();
-  uint32_t count = 0;      // Offset of the first byte of a packet in the buffer
-  uint32_t pktSize = 0;
-  bool beginFound = false;
-  int pktCount = 0;
-  Ptr<Packet> outPacket;
-  NS_LOG_LOGIC ("There are " << m_data.size () << " number of packets in buffer");
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  NS_ASSERT (seq >= m_firstByteSeq);
+  uint64_t offset = m_firstByteOffset + (seq - m_firstByteSeq.Get ());
+  // The last packet which starts at or before the first byte to copy
+  BufIterator i = std::upper_bound (m_data.begin (), m_data.end (), offset, &OffsetBefore) - 1;
+  uint32_t packetOffset = offset - i->offset;
+  uint32_t pktSize = i->packet->GetSize ();
+  NS_LOG_LOGIC ("First byte found in packet #" << i - m_data.begin () << " at offset " << packetOffset
+                                               << ", packet len=" << pktSize);
+  if (pktSize - packetOffset >= s)
+    { // Data to be copied falls entirely in this packet
+      return i->packet->CreateFragment (packetOffset, s);
+    }
+  // This packet only fulfills part of the request
+  Ptr<Packet> outPacket = i->packet->CreateFragment (packetOffset, pktSize - packetOffset);
+  uint32_t remaining = s - outPacket->GetSize ();
+  for (++i; remaining > 0; ++i)
     {
-      pktCount++;
-      pktSize = (*i)->GetSize ();
-      if (!beginFound)
-        { // Look for first fragment
-          if (count + pktSize > offset)
-            {
-              NS_LOG_LOGIC ("First byte found in packet #" << pktCount << " at buffer offset " << count
-                                                           << ", packet len=" << pktSize);
-              beginFound = true;
-              uint32_t packetOffset = offset - count;
-              uint32_t fragmentLength = count + pktSize - offset;
-              if (fragmentLength >= s)
-                { // Data to be copied falls entirely in this packet
-                  return (*i)->CreateFragment (packetOffset, s);
-                }
-              else
-                { // This packet only fulfills part of the request
-                  outPacket = (*i)->CreateFragment (packetOffset, fragmentLength);
-                }
-              NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-            }
-        }
-      else if (count + pktSize >= offset + s)
+      pktSize = i->packet->GetSize ();
+      if (pktSize >= remaining)
         { // Last packet fragment found
-          NS_LOG_LOGIC ("Last byte found in packet #" << pktCount << " at buffer offset " << count
-                                                      << ", packet len=" << pktSize);
-          uint32_t fragmentLength = offset + s - count;
-          Ptr<Packet> endFragment = (*i)->CreateFragment (0, fragmentLength);
-          outPacket->AddAtEnd (endFragment);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
+          outPacket->AddAtEnd (i->packet->CreateFragment (0, remaining));
           break;
         }
-      else
-        {
-          NS_LOG_LOGIC ("Appending to output the packet #" << pktCount << " of offset " << count << " len=" << pktSize);
-          outPacket->AddAtEnd (*i);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-        }
-      count += pktSize;
+      outPacket->AddAtEnd (i->packet);
+      remaining -= pktSize;
     }
+  NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
   NS_ASSERT (outPacket->GetSize () == s);
   return outPacket;
 }
@@ -217,40 +204,205 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
   // Cases do not need to scan the buffer
   if (m_firstByteSeq >= seq) return;
 
-  // Scan the buffer and discard packets
-  uint32_t offset = seq - m_firstByteSeq.Get ();  // Number of bytes to remove
-  uint32_t pktSize;
+  // Discard the packets entirely behind the seqnum. The first packet
+  // left may start before it: its acknowledged bytes are skipped when
+  // segments are copied.
+  uint32_t offset = std::min<uint32_t> (seq - m_firstByteSeq.Get (), m_size);  // Number of bytes to remove
   NS_LOG_LOGIC ("Offset=" << offset);
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end ())
+  m_firstByteOffset += offset;
+  m_firstByteSeq += offset;
+  m_size -= offset;
+  while (!m_data.empty ()
+         && m_data.front ().offset + m_data.front ().packet->GetSize () <= m_firstByteOffset)
     {
-      if (offset > (*i)->GetSize ())
-        { // This packet is behind the seqnum. Remove this packet from the buffer
-          pktSize = (*i)->GetSize ();
-          m_size -= pktSize;
-          offset -= pktSize;
-          m_firstByteSeq += pktSize;
-          i = m_data.erase (i);
-          NS_LOG_LOGIC ("Removed one packet of size " << pktSize << ", offset=" << offset);
-        }
-      else if (offset > 0)
-        { // Part of the packet is behind the seqnum. Fragment
-          pktSize = (*i)->GetSize () - offset;
-          *i = (*i)->CreateFragment (offset, pktSize);
-          m_size -= offset;
-          m_firstByteSeq += offset;
-          NS_LOG_LOGIC ("Fragmented one packet by size " << offset << ", new size=" << pktSize);
-          break;
-        }
+      NS_LOG_LOGIC ("Removed one packet of size " << m_data.front ().packet->GetSize ());
+      m_data.pop_front ();
     }
   // Catching the case of ACKing a FIN
   if (m_size == 0)
     {
       m_firstByteSeq = seq;
     }
+  // Drop the blocks acknowledged, and cut the one which straddles the head
+  while (!m_sacked.empty () && m_sacked.begin ()->first < m_firstByteSeq)
+    {
+      Scoreboard::iterator i = m_sacked.begin ();
+      SequenceNumber32 tail = i->second;
+      m_sackedBytes -= tail - i->first;
+      m_sacked.erase (i);
+      if (tail > m_firstByteSeq)
+        {
+          m_sacked.insert (std::make_pair (m_firstByteSeq.Get (), tail));
+          m_sackedBytes += tail - m_firstByteSeq.Get ();
+        }
+    }
   NS_LOG_LOGIC ("size=" << m_size << " headSeq=" << m_firstByteSeq << " maxBuffer=" << m_maxBuffer
                         <<" numPkts="<< m_data.size ());
   NS_ASSERT (m_firstByteSeq == seq);
 }
 
+bool
+TcpTxBuffer::UpdateScoreboard (const TcpOptionSack::SackList &list)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t sacked = m_sackedBytes;
+  SequenceNumber32 tailSeq = TailSequence ();
+  for (TcpOptionSack::SackList::const_iterator j = list.begin (); j != list.end (); ++j)
+    {
+      SequenceNumber32 head = std::max (j->first, m_firstByteSeq.Get ());
+      SequenceNumber32 tail = std::min (j->second, tailSeq);
+      if (head >= tail)
+        {
+          NS_LOG_LOGIC ("Ignored block [" << j->first << ";" << j->second << ")");
+          continue;
+        }
+      // Merge the block with the ones it touches
+      Scoreboard::iterator i = m_sacked.upper_bound (head);
+      if (i != m_sacked.begin ())
+        {
+          --i;
+          if (i->second >= head)
+            {
+              head = i->first;
+              tail = std::max (tail, i->second);
+              m_sackedBytes -= i->second - i->first;
+              m_sacked.erase (i++);
+            }
+          else
+            {
+              ++i;
+            }
+        }
+      while (i != m_sacked.end () && i->first <= tail)
+        {
+          tail = std::max (tail, i->second);
+          m_sackedBytes -= i->second - i->first;
+          m_sacked.erase (i++);
+        }
+      m_sacked.insert (std::make_pair (head, tail));
+      m_sackedBytes += tail - head;
+    }
+  NS_LOG_LOGIC ("Blocks=" << m_sacked.size () << " sacked bytes=" << m_sackedBytes);
+  return m_sackedBytes > sacked;
+}
+
+void
+TcpTxBuffer::ResetScoreboard (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_sacked.clear ();
+  m_sackedBytes = 0;
+}
+
+uint32_t
+TcpTxBuffer::GetSacked (void) const
+{
+  return m_sackedBytes;
+}
+
+bool
+TcpTxBuffer::IsSacked (const SequenceNumber32& seq) const
+{
+  Scoreboard::const_iterator i = m_sacked.upper_bound (seq);
+  if (i == m_sacked.begin ())
+    {
+      return false;
+    }
+  --i;
+  return seq < i->second;
+}
+
+SequenceNumber32
+TcpTxBuffer::LostBoundary (uint32_t dupThresh, uint32_t segmentSize) const
+{
+  // Walk the blocks down from the highest one, until enough of them are
+  // above the bytes below
+  uint32_t blocks = 0;
+  uint32_t bytes = 0;
+  for (Scoreboard::const_reverse_iterator i = m_sacked.rbegin (); i != m_sacked.rend (); ++i)
+    {
+      blocks++;
+      bytes += i->second - i->first;
+      if (blocks >= dupThresh || bytes > (dupThresh - 1) * segmentSize)
+        {
+          return i->first;
+        }
+    }
+  return m_firstByteSeq;
+}
+
+uint32_t
+TcpTxBuffer::SackedBytes (const SequenceNumber32& head, const SequenceNumber32& tail) const
+{
+  uint32_t bytes = 0;
+  Scoreboard::const_iterator i = m_sacked.upper_bound (head);
+  if (i != m_sacked.begin ())
+    {
+      --i;
+    }
+  for (; i != m_sacked.end () && i->first < tail; ++i)
+    {
+      SequenceNumber32 first = std::max (i->first, head);
+      SequenceNumber32 last = std::min (i->second, tail);
+      if (first < last)
+        {
+          bytes += last - first;
+        }
+    }
+  return bytes;
+}
+
+bool
+TcpTxBuffer::IsLost (const SequenceNumber32& seq, uint32_t dupThresh, uint32_t segmentSize) const
+{
+  return seq < LostBoundary (dupThresh, segmentSize) && !IsSacked (seq);
+}
+
+uint32_t
+TcpTxBuffer::BytesInFlight (const SequenceNumber32& highData, const SequenceNumber32& highRxt,
+                            uint32_t dupThresh, uint32_t segmentSize) const
+{
+  SequenceNumber32 head = m_firstByteSeq;
+  if (highData <= head)
+    {
+      return 0;
+    }
+  // The bytes not acknowledged above the lost ones, and the bytes
+  // not acknowledged which were retransmitted
+  SequenceNumber32 lost = std::min (LostBoundary (dupThresh, segmentSize), highData);
+  SequenceNumber32 retransmitted = std::min (std::max (highRxt, head), highData);
+  uint32_t pipe = (highData - lost) - SackedBytes (lost, highData);
+  pipe += (retransmitted - head) - SackedBytes (head, retransmitted);
+  NS_LOG_LOGIC ("Pipe=" << pipe << " lost below " << lost << " retransmitted below " << retransmitted);
+  return pipe;
+}
+
+bool
+TcpTxBuffer::NextSeg (const SequenceNumber32& highRxt, bool lostOnly, uint32_t dupThresh,
+                      uint32_t segmentSize, SequenceNumber32 &seq, uint32_t &length) const
+{
+  if (m_sacked.empty ())
+    {
+      return false;
+    }
+  SequenceNumber32 limit = lostOnly ? LostBoundary (dupThresh, segmentSize) : m_sacked.rbegin ()->first;
+  // The first byte above highRxt which was not acknowledged
+  SequenceNumber32 first = std::max (highRxt, m_firstByteSeq.Get ());
+  Scoreboard::const_iterator next = m_sacked.upper_bound (first);
+  if (next != m_sacked.begin ())
+    {
+      Scoreboard::const_iterator previous = next;
+      --previous;
+      first = std::max (first, previous->second);
+    }
+  if (first >= limit)
+    {
+      return false;
+    }
+  NS_ASSERT (next != m_sacked.end ());
+  seq = first;
+  length = std::min<uint32_t> (segmentSize, next->first - first);
+  return true;
+}
+
 } // namepsace ns3
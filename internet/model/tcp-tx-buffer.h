@@ -21,12 +21,14 @@
 #ifndef TCP_TX_BUFFER_H
 #define TCP_TX_BUFFER_H
 
-#include <list>
+#include <deque>
+#include <map>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/object.h"
 #include "ns3/sequence-number.h"
 #include "ns3/ptr.h"
+#include "ns3/tcp-option-sack.h"
 
 namespace ns3 {
 class Packet;
@@ -36,6 +38,18 @@ class Packet;
  *
  * \brief class for keeping the data sent by the application to the TCP socket, i.e.
  *        the sending buffer.
+ *
+ * The buffer is a queue of the packets written by the application,
+ * each stored with the offset of its first byte in the stream. The
+ * packet holding a sequence number is found by a binary search, and
+ * segments are cut from the packets without modifying them: the
+ * acknowledged bytes of the first packet are skipped rather than
+ * trimmed off.
+ *
+ * The buffer also keeps the scoreboard of the selective acknowledgments
+ * (\RFC{2018}) received from the peer, as a map of the disjoint blocks of
+ * data it holds, and answers the queries of the SACK based loss recovery
+ * of \RFC{6675} from it.
  */
 class TcpTxBuffer : public Object
 {
@@ -127,14 +141,125 @@ public:
    */
   void DiscardUpTo (const SequenceNumber32& seq);
 
+  /**
+   * \brief Mark the blocks of a SACK option as received by the peer
+   *
+   * The parts of the blocks outside of the buffer are ignored.
+   *
+   * \param list the blocks of the option
+   * \returns true if some bytes were not marked yet
+   */
+  bool UpdateScoreboard (const TcpOptionSack::SackList &list);
+
+  /**
+   * \brief Forget the blocks received by the peer, e.g. after a retransmission
+   * timeout (\RFC{2018}, section 8)
+   */
+  void ResetScoreboard (void);
+
+  /**
+   * \returns the number of bytes selectively acknowledged by the peer
+   */
+  uint32_t GetSacked (void) const;
+
+  /**
+   * \param seq a sequence number
+   * \returns true if the byte was selectively acknowledged by the peer
+   */
+  bool IsSacked (const SequenceNumber32& seq) const;
+
+  /**
+   * \brief The IsLost () function of \RFC{6675}
+   *
+   * A byte which is not selectively acknowledged is lost when dupThresh
+   * blocks, or more than (dupThresh - 1) segments, above it are.
+   *
+   * \param seq a sequence number
+   * \param dupThresh the number of duplicate acknowledgments of a loss
+   * \param segmentSize the segment size
+   * \returns true if the byte is deemed lost
+   */
+  bool IsLost (const SequenceNumber32& seq, uint32_t dupThresh, uint32_t segmentSize) const;
+
+  /**
+   * \brief The SetPipe () function of \RFC{6675}
+   *
+   * The bytes in flight are the bytes not acknowledged and not deemed
+   * lost, plus the bytes retransmitted.
+   *
+   * \param highData the sequence number following the highest byte sent
+   * \param highRxt the sequence number following the highest byte retransmitted
+   * \param dupThresh the number of duplicate acknowledgments of a loss
+   * \param segmentSize the segment size
+   * \returns the number of bytes in flight
+   */
+  uint32_t BytesInFlight (const SequenceNumber32& highData, const SequenceNumber32& highRxt,
+                          uint32_t dupThresh, uint32_t segmentSize) const;
+
+  /**
+   * \brief The retransmissions of the NextSeg () function of \RFC{6675}
+   *
+   * Find the first byte above highRxt which was not selectively
+   * acknowledged and is lost (rule 1), or is below the highest byte
+   * selectively acknowledged (rule 3). The segment stops at the next
+   * block acknowledged.
+   *
+   * \param highRxt the sequence number following the highest byte retransmitted
+   * \param lostOnly true to apply rule 1, false to apply rule 3
+   * \param dupThresh the number of duplicate acknowledgments of a loss
+   * \param segmentSize the segment size
+   * \param seq the sequence number of the segment to retransmit
+   * \param length the length of the segment to retransmit
+   * \returns true if there is a segment to retransmit
+   */
+  bool NextSeg (const SequenceNumber32& highRxt, bool lostOnly, uint32_t dupThresh,
+                uint32_t segmentSize, SequenceNumber32 &seq, uint32_t &length) const;
+
 private:
+  /**
+   * \brief A packet written by the application.
+   */
+  struct Chunk
+  {
+    uint64_t offset;     //!< Offset of the first byte of the packet in the stream
+    Ptr<Packet> packet;  //!< The packet
+  };
+
+  /**
+   * \param offset an offset in the stream
+   * \param chunk a chunk
+   * \returns true if the offset is before the first byte of the chunk
+   */
+  static bool OffsetBefore (uint64_t offset, const Chunk &chunk);
+
+  /**
+   * \param dupThresh the number of duplicate acknowledgments of a loss
+   * \param segmentSize the segment size
+   * \returns the sequence number below which the bytes not selectively
+   * acknowledged are lost
+   */
+  SequenceNumber32 LostBoundary (uint32_t dupThresh, uint32_t segmentSize) const;
+
+  /**
+   * \param head the first sequence number of an interval
+   * \param tail the sequence number following the interval
+   * \returns the number of bytes of the interval selectively acknowledged
+   */
+  uint32_t SackedBytes (const SequenceNumber32& head, const SequenceNumber32& tail) const;
+
+  /// the blocks selectively acknowledged: first byte to next byte
+  typedef std::map<SequenceNumber32, SequenceNumber32> Scoreboard;
+
   /// container for data stored in the buffer
-  typedef std::list<Ptr<Packet> >::iterator BufIterator;
+  typedef std::deque<Chunk>::const_iterator BufIterator;
 
   TracedValue<SequenceNumber32> m_firstByteSeq; //!< Sequence number of the first byte in data (SND.UNA)
   uint32_t m_size;                              //!< Number of data bytes
   uint32_t m_maxBuffer;                         //!< Max number of data bytes in buffer (SND.WND)
-  std::list<Ptr<Packet> > m_data;               //!< Corresponding data (may be null)
+  uint64_t m_firstByteOffset;                   //!< Offset of the first byte of data in the stream
+  std::deque<Chunk> m_data;                     //!< Corresponding data
+  Scoreboard m_sacked;                          //!< Blocks selectively acknowledged by the peer
+  uint32_t m_sackedBytes;                       //!< Number of bytes in m_sacked
 };
 
 } // namepsace ns3
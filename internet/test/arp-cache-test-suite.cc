@@ -0,0 +1,294 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-interface-container.h"
+#include "ns3/ipv4-routing-helper.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/arp-cache.h"
+#include "ns3/arp-l3-protocol.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/socket.h"
+#include "ns3/inet-socket-address.h"
+
+using namespace ns3;
+
+/**
+ * \brief A few nodes on a simple channel, which count the UDP packets
+ * and the ARP packets they receive.
+ */
+class ArpCacheTestBase : public TestCase
+{
+public:
+  /**
+   * \param name the name of the test case
+   */
+  ArpCacheTestBase (std::string name);
+
+protected:
+  /**
+   * \brief Create the nodes and assign them the addresses 10.0.0.1 and up.
+   * \param nNodes the number of nodes
+   */
+  void Setup (uint32_t nNodes);
+  /**
+   * \brief Send UDP packets from the first node.
+   * \param destination the destination address
+   * \param nPackets the number of packets
+   * \param size the payload size of each packet
+   */
+  void Send (Ipv4Address destination, uint32_t nPackets, uint32_t size);
+  /**
+   * \returns the ARP cache of the interface of a node
+   * \param node the index of the node
+   */
+  Ptr<ArpCache> GetArpCache (uint32_t node);
+
+  NodeContainer m_nodes; //!< the nodes
+  NetDeviceContainer m_devices; //!< the devices of the nodes
+  Ipv4InterfaceContainer m_interfaces; //!< the interfaces of the nodes
+  uint32_t m_received; //!< number of UDP packets received
+  uint32_t m_arpReceived; //!< number of ARP packets received
+  uint32_t m_arpDropped; //!< number of packets dropped by ArpL3Protocol
+  uint32_t m_cacheDropped; //!< number of packets dropped by the caches
+
+private:
+  /// Count a received UDP packet
+  void LocalDeliver (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t iif);
+  /// Count a received ARP packet
+  void ArpReceive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                   const Address &from, const Address &to, NetDevice::PacketType type);
+  /// Count a packet dropped by ArpL3Protocol
+  void ArpDrop (Ptr<const Packet> packet);
+  /// Count a packet dropped by an ArpCache
+  void CacheDrop (Ptr<const Packet> packet);
+};
+
+ArpCacheTestBase::ArpCacheTestBase (std::string name)
+  : TestCase (name),
+    m_received (0),
+    m_arpReceived (0),
+    m_arpDropped (0),
+    m_cacheDropped (0)
+{
+}
+
+void
+ArpCacheTestBase::Setup (uint32_t nNodes)
+{
+  m_nodes.Create (nNodes);
+  InternetStackHelper internet;
+  internet.Install (m_nodes);
+  SimpleNetDeviceHelper devices;
+  m_devices = devices.Install (m_nodes);
+  Ipv4AddressHelper addresses;
+  addresses.SetBase ("10.0.0.0", "255.255.255.0");
+  m_interfaces = addresses.Assign (m_devices);
+
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      Ptr<Node> node = m_nodes.Get (i);
+      node->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext
+        ("LocalDeliver", MakeCallback (&ArpCacheTestBase::LocalDeliver, this));
+      node->GetObject<ArpL3Protocol> ()->TraceConnectWithoutContext
+        ("Drop", MakeCallback (&ArpCacheTestBase::ArpDrop, this));
+      node->RegisterProtocolHandler (MakeCallback (&ArpCacheTestBase::ArpReceive, this),
+                                     ArpL3Protocol::PROT_NUMBER, m_devices.Get (i));
+      GetArpCache (i)->TraceConnectWithoutContext ("Drop", MakeCallback (&ArpCacheTestBase::CacheDrop, this));
+      // a sink, so that the packets received do not trigger ICMP errors
+      Ptr<Socket> sink = Socket::CreateSocket (node, UdpSocketFactory::GetTypeId ());
+      sink->Bind (InetSocketAddress (Ipv4Address::GetAny (), 9));
+    }
+}
+
+void
+ArpCacheTestBase::Send (Ipv4Address destination, uint32_t nPackets, uint32_t size)
+{
+  Ptr<Socket> socket = Socket::CreateSocket (m_nodes.Get (0), UdpSocketFactory::GetTypeId ());
+  socket->Bind ();
+  for (uint32_t i = 0; i < nPackets; i++)
+    {
+      socket->SendTo (Create<Packet> (size), 0, InetSocketAddress (destination, 9));
+    }
+  socket->Close ();
+}
+
+Ptr<ArpCache>
+ArpCacheTestBase::GetArpCache (uint32_t node)
+{
+  Ptr<Ipv4L3Protocol> ipv4 = m_nodes.Get (node)->GetObject<Ipv4L3Protocol> ();
+  return ipv4->GetInterface (m_interfaces.Get (node).second)->GetArpCache ();
+}
+
+void
+ArpCacheTestBase::LocalDeliver (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t iif)
+{
+  if (header.GetProtocol () == 17)
+    {
+      m_received++;
+    }
+}
+
+void
+ArpCacheTestBase::ArpReceive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                              const Address &from, const Address &to, NetDevice::PacketType type)
+{
+  m_arpReceived++;
+}
+
+void
+ArpCacheTestBase::ArpDrop (Ptr<const Packet> packet)
+{
+  m_arpDropped++;
+}
+
+void
+ArpCacheTestBase::CacheDrop (Ptr<const Packet> packet)
+{
+  m_cacheDropped++;
+}
+
+//-----------------------------------------------------------------------------
+// The packets waiting for a reply are limited in number and in bytes,
+// and are all sent when the reply arrives
+//-----------------------------------------------------------------------------
+class ArpCachePendingTest : public ArpCacheTestBase
+{
+public:
+  ArpCachePendingTest ();
+  virtual void DoRun (void);
+private:
+  /// Check the state of the caches once the replies have arrived
+  void CheckReplies (void);
+};
+
+ArpCachePendingTest::ArpCachePendingTest ()
+  : ArpCacheTestBase ("Check the pending queue limits of the ARP cache")
+{
+}
+
+void
+ArpCachePendingTest::CheckReplies (void)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_received, 7, "Pending packets not sent on reply");
+  NS_TEST_EXPECT_MSG_EQ (GetArpCache (0)->Lookup (Ipv4Address ("10.0.0.2"))->IsAlive (), true,
+                         "Entry not alive after the reply");
+  NS_TEST_EXPECT_MSG_EQ (GetArpCache (0)->Lookup (Ipv4Address ("10.0.0.9"))->IsWaitReply (), true,
+                         "Entry of an absent node not waiting for a reply");
+}
+
+void
+ArpCachePendingTest::DoRun (void)
+{
+  Setup (3);
+  GetArpCache (0)->SetAttribute ("PendingQueueSize", UintegerValue (5));
+  GetArpCache (0)->SetAttribute ("PendingQueueMaxBytes", UintegerValue (500));
+
+  // 200 bytes of payload, 228 bytes with the headers: two packets fit
+  Simulator::Schedule (Seconds (1), &ArpCachePendingTest::Send, this, Ipv4Address ("10.0.0.2"), 4, 200);
+  // 10 bytes of payload: the five packets allowed fit
+  Simulator::Schedule (Seconds (1), &ArpCachePendingTest::Send, this, Ipv4Address ("10.0.0.3"), 6, 10);
+  // nobody answers for this address
+  Simulator::Schedule (Seconds (1), &ArpCachePendingTest::Send, this, Ipv4Address ("10.0.0.9"), 3, 10);
+  Simulator::Schedule (Seconds (1.5), &ArpCachePendingTest::CheckReplies, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_received, 7, "Bad number of packets received");
+  NS_TEST_EXPECT_MSG_EQ (m_arpDropped, 2 + 1, "Bad number of packets over the limits");
+  NS_TEST_EXPECT_MSG_EQ (m_cacheDropped, 3, "Bad number of packets without a reply");
+  // a request to 10.0.0.2 and to 10.0.0.3, seen by two nodes, and their
+  // replies; the first request to 10.0.0.9 and its three retries
+  NS_TEST_EXPECT_MSG_EQ (m_arpReceived, (2 + 1) * 2 + 4 * 2, "Bad number of ARP packets");
+}
+
+//-----------------------------------------------------------------------------
+// Populated caches skip ARP entirely, and keep their entries on a flush
+//-----------------------------------------------------------------------------
+class ArpCachePopulateTest : public ArpCacheTestBase
+{
+public:
+  ArpCachePopulateTest ();
+  virtual void DoRun (void);
+};
+
+ArpCachePopulateTest::ArpCachePopulateTest ()
+  : ArpCacheTestBase ("Check the static population of the ARP caches")
+{
+}
+
+void
+ArpCachePopulateTest::DoRun (void)
+{
+  Setup (4);
+  Ipv4RoutingHelper::PopulateNeighborCaches ();
+
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      Ptr<ArpCache> cache = GetArpCache (i);
+      for (uint32_t j = 0; j < 4; j++)
+        {
+          ArpCache::Entry *entry = cache->Lookup (m_interfaces.GetAddress (j));
+          if (i == j)
+            {
+              NS_TEST_EXPECT_MSG_EQ (entry, 0, "Node " << i << " has an entry for itself");
+              continue;
+            }
+          NS_TEST_ASSERT_MSG_NE (entry, 0, "Node " << i << " has no entry for node " << j);
+          NS_TEST_EXPECT_MSG_EQ (entry->IsPermanent (), true, "Entry not permanent");
+          NS_TEST_EXPECT_MSG_EQ (entry->GetMacAddress (), m_devices.Get (j)->GetAddress (),
+                                 "Bad MAC address");
+        }
+    }
+
+  GetArpCache (0)->Flush ();
+  NS_TEST_EXPECT_MSG_NE (GetArpCache (0)->Lookup (Ipv4Address ("10.0.0.2")), 0,
+                         "Permanent entry removed by a flush");
+
+  Simulator::Schedule (Seconds (1), &ArpCachePopulateTest::Send, this, Ipv4Address ("10.0.0.2"), 10, 100);
+  Simulator::Schedule (Seconds (1), &ArpCachePopulateTest::Send, this, Ipv4Address ("10.0.0.4"), 10, 100);
+  Simulator::Stop (Seconds (300));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_received, 20, "Bad number of packets received");
+  NS_TEST_EXPECT_MSG_EQ (m_arpDropped, 0, "Packets dropped");
+  NS_TEST_EXPECT_MSG_EQ (m_arpReceived, 0, "ARP packets sent");
+}
+
+//-----------------------------------------------------------------------------
+class ArpCacheTestSuite : public TestSuite
+{
+public:
+  ArpCacheTestSuite ();
+};
+
+ArpCacheTestSuite::ArpCacheTestSuite ()
+  : TestSuite ("arp-cache", UNIT)
+{
+  AddTestCase (new ArpCachePendingTest, TestCase::QUICK);
+  AddTestCase (new ArpCachePopulateTest, TestCase::QUICK);
+}
+
+static ArpCacheTestSuite g_arpCacheTestSuite;
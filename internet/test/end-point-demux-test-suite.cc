@@ -0,0 +1,547 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv6-interface.h"
+#include "ns3/private/ipv4-end-point.h"
+#include "ns3/private/ipv4-end-point-demux.h"
+#include "ns3/private/ipv6-end-point.h"
+#include "ns3/private/ipv6-end-point-demux.h"
+#include <vector>
+#include <list>
+#include <algorithm>
+
+using namespace ns3;
+
+// The demuxes index their endpoints: these tests check their results
+// against a linear scan of the endpoints in allocation order, which is
+// how the demuxes used to look them up.
+
+//-----------------------------------------------------------------------------
+class Ipv4EndPointDemuxTest : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTest ();
+  virtual void DoRun (void);
+private:
+  typedef std::list<Ipv4EndPoint *> EndPoints;
+  EndPoints Lookup (Ipv4Address daddr, uint16_t dport, Ipv4Address saddr, uint16_t sport,
+                    Ptr<Ipv4Interface> incomingInterface);
+  Ipv4EndPoint *SimpleLookup (Ipv4Address daddr, uint16_t dport, Ipv4Address saddr, uint16_t sport);
+  bool LookupLocal (Ipv4Address addr, uint16_t port);
+  bool Exists (Ipv4Address localAddress, uint16_t localPort, Ipv4Address peerAddress, uint16_t peerPort);
+  Ipv4Address GetAddress (uint32_t i);
+
+  EndPoints m_reference;
+  Ptr<UniformRandomVariable> m_random;
+};
+
+Ipv4EndPointDemuxTest::Ipv4EndPointDemuxTest ()
+  : TestCase ("Check the IPv4 demux against a linear lookup")
+{
+}
+
+Ipv4EndPointDemuxTest::EndPoints
+Ipv4EndPointDemuxTest::Lookup (Ipv4Address daddr, uint16_t dport, Ipv4Address saddr, uint16_t sport,
+                               Ptr<Ipv4Interface> incomingInterface)
+{
+  EndPoints retval1, retval2, retval3, retval4;
+  for (EndPoints::iterator i = m_reference.begin (); i != m_reference.end (); i++)
+    {
+      Ipv4EndPoint *endP = *i;
+      if (!endP->IsRxEnabled () || endP->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      bool subnetDirected = false;
+      Ipv4Address incomingInterfaceAddr = daddr;
+      for (uint32_t j = 0; j < incomingInterface->GetNAddresses (); j++)
+        {
+          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (j);
+          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+            {
+              subnetDirected = true;
+              incomingInterfaceAddr = addr.GetLocal ();
+            }
+        }
+      bool isBroadcast = daddr.IsBroadcast () || subnetDirected;
+      bool localAddressMatchesWildCard = endP->GetLocalAddress () == Ipv4Address::GetAny ();
+      bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
+      if (isBroadcast && !localAddressMatchesWildCard)
+        {
+          localAddressMatchesExact = endP->GetLocalAddress () == incomingInterfaceAddr;
+        }
+      if (!(localAddressMatchesExact || localAddressMatchesWildCard))
+        {
+          continue;
+        }
+      bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
+      bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
+      bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
+      bool remoteAddressMatchesWildCard = endP->GetPeerAddress () == Ipv4Address::GetAny ();
+      if (!(remotePeerMatchesExact || remotePeerMatchesWildCard)
+          || !(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
+        {
+          continue;
+        }
+      if (localAddressMatchesWildCard && remotePeerMatchesWildCard && remoteAddressMatchesWildCard)
+        {
+          retval1.push_back (endP);
+        }
+      if ((localAddressMatchesExact || (isBroadcast && localAddressMatchesWildCard))
+          && remotePeerMatchesWildCard && remoteAddressMatchesWildCard)
+        {
+          retval2.push_back (endP);
+        }
+      if (localAddressMatchesWildCard && remotePeerMatchesExact && remoteAddressMatchesExact)
+        {
+          retval3.push_back (endP);
+        }
+      if (localAddressMatchesExact && remotePeerMatchesExact && remoteAddressMatchesExact)
+        {
+          retval4.push_back (endP);
+        }
+    }
+  if (!retval4.empty ())
+    {
+      return retval4;
+    }
+  if (!retval3.empty ())
+    {
+      return retval3;
+    }
+  if (!retval2.empty ())
+    {
+      return retval2;
+    }
+  return retval1;
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemuxTest::SimpleLookup (Ipv4Address daddr, uint16_t dport, Ipv4Address saddr, uint16_t sport)
+{
+  uint32_t genericity = 3;
+  Ipv4EndPoint *generic = 0;
+  for (EndPoints::iterator i = m_reference.begin (); i != m_reference.end (); i++)
+    {
+      if ((*i)->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      if ((*i)->GetLocalAddress () == daddr && (*i)->GetPeerPort () == sport
+          && (*i)->GetPeerAddress () == saddr)
+        {
+          return *i;
+        }
+      uint32_t tmp = ((*i)->GetLocalAddress () == Ipv4Address::GetAny ())
+        + ((*i)->GetPeerAddress () == Ipv4Address::GetAny ());
+      if (tmp < genericity)
+        {
+          generic = *i;
+          genericity = tmp;
+        }
+    }
+  return generic;
+}
+
+bool
+Ipv4EndPointDemuxTest::LookupLocal (Ipv4Address addr, uint16_t port)
+{
+  for (EndPoints::iterator i = m_reference.begin (); i != m_reference.end (); i++)
+    {
+      if ((*i)->GetLocalPort () == port && (*i)->GetLocalAddress () == addr)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+bool
+Ipv4EndPointDemuxTest::Exists (Ipv4Address localAddress, uint16_t localPort,
+                               Ipv4Address peerAddress, uint16_t peerPort)
+{
+  for (EndPoints::iterator i = m_reference.begin (); i != m_reference.end (); i++)
+    {
+      if ((*i)->GetLocalPort () == localPort && (*i)->GetLocalAddress () == localAddress
+          && (*i)->GetPeerPort () == peerPort && (*i)->GetPeerAddress () == peerAddress)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+Ipv4Address
+Ipv4EndPointDemuxTest::GetAddress (uint32_t i)
+{
+  // the wildcard, the interface address, a neighbour, the subnet
+  // broadcast, the limited broadcast and a remote address
+  static const char *addresses[] = { "0.0.0.0", "10.0.0.1", "10.0.0.2", "10.0.0.255",
+                                     "255.255.255.255", "10.1.0.1" };
+  return Ipv4Address (addresses[i % 6]);
+}
+
+void
+Ipv4EndPointDemuxTest::DoRun (void)
+{
+  m_random = CreateObject<UniformRandomVariable> ();
+  m_random->SetStream (1);
+  Ptr<Ipv4Interface> interface = CreateObject<Ipv4Interface> ();
+  interface->AddAddress (Ipv4InterfaceAddress (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.255.255.0")));
+
+  Ipv4EndPointDemux demux;
+  for (uint32_t step = 0; step < 20000; step++)
+    {
+      // a few ports and addresses, so that the endpoints collide
+      uint16_t localPort = 1 + m_random->GetInteger (0, 3);
+      uint16_t peerPort = m_random->GetInteger (0, 3);
+      Ipv4Address localAddress = GetAddress (m_random->GetInteger (0, 5));
+      Ipv4Address peerAddress = GetAddress (m_random->GetInteger (0, 5));
+      switch (m_random->GetInteger (0, 5))
+        {
+        case 0:
+          {
+            bool expected = !LookupLocal (localAddress, localPort);
+            Ipv4EndPoint *endPoint = demux.Allocate (localAddress, localPort);
+            NS_TEST_ASSERT_MSG_EQ ((endPoint != 0), expected, "Allocate (address, port) disagrees");
+            if (endPoint != 0)
+              {
+                m_reference.push_back (endPoint);
+              }
+            break;
+          }
+        case 1:
+          {
+            bool expected = !Exists (localAddress, localPort, peerAddress, peerPort);
+            Ipv4EndPoint *endPoint = demux.Allocate (localAddress, localPort, peerAddress, peerPort);
+            NS_TEST_ASSERT_MSG_EQ ((endPoint != 0), expected, "Allocate (four-tuple) disagrees");
+            if (endPoint != 0)
+              {
+                m_reference.push_back (endPoint);
+              }
+            break;
+          }
+        case 2:
+          if (!m_reference.empty ())
+            {
+              EndPoints::iterator i = m_reference.begin ();
+              std::advance (i, m_random->GetInteger (0, m_reference.size () - 1));
+              demux.DeAllocate (*i);
+              m_reference.erase (i);
+            }
+          break;
+        case 3:
+          if (!m_reference.empty ())
+            {
+              EndPoints::iterator i = m_reference.begin ();
+              std::advance (i, m_random->GetInteger (0, m_reference.size () - 1));
+              (*i)->SetPeer (peerAddress, peerPort);
+              (*i)->SetRxEnabled (m_random->GetInteger (0, 7) != 0);
+            }
+          break;
+        default:
+          {
+            EndPoints expected = Lookup (localAddress, localPort, peerAddress, peerPort, interface);
+            EndPoints found = demux.Lookup (localAddress, localPort, peerAddress, peerPort, interface);
+            NS_TEST_ASSERT_MSG_EQ ((found == expected), true, "Lookup disagrees at step " << step);
+            NS_TEST_ASSERT_MSG_EQ (demux.SimpleLookup (localAddress, localPort, peerAddress, peerPort),
+                                   SimpleLookup (localAddress, localPort, peerAddress, peerPort),
+                                   "SimpleLookup disagrees at step " << step);
+            NS_TEST_ASSERT_MSG_EQ (demux.LookupLocal (localAddress, localPort),
+                                   LookupLocal (localAddress, localPort),
+                                   "LookupLocal disagrees at step " << step);
+            break;
+          }
+        }
+      if (m_reference.size () > 60)
+        {
+          demux.DeAllocate (m_reference.front ());
+          m_reference.pop_front ();
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ ((demux.GetAllEndPoints () == m_reference), true, "Allocation order not kept");
+  for (uint16_t port = 0; port < 6; port++)
+    {
+      bool expected = false;
+      for (EndPoints::iterator i = m_reference.begin (); i != m_reference.end (); i++)
+        {
+          expected |= (*i)->GetLocalPort () == port;
+        }
+      NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (port), expected, "LookupPortLocal disagrees");
+    }
+  m_reference.clear ();
+}
+
+//-----------------------------------------------------------------------------
+class Ipv6EndPointDemuxTest : public TestCase
+{
+public:
+  Ipv6EndPointDemuxTest ();
+  virtual void DoRun (void);
+private:
+  typedef std::list<Ipv6EndPoint *> EndPoints;
+  EndPoints Lookup (Ipv6Address daddr, uint16_t dport, Ipv6Address saddr, uint16_t sport);
+  Ipv6EndPoint *SimpleLookup (Ipv6Address daddr, uint16_t dport, Ipv6Address saddr, uint16_t sport);
+  bool LookupLocal (Ipv6Address addr, uint16_t port);
+  bool Exists (Ipv6Address localAddress, uint16_t localPort, Ipv6Address peerAddress, uint16_t peerPort);
+  Ipv6Address GetAddress (uint32_t i);
+
+  EndPoints m_reference;
+  Ptr<UniformRandomVariable> m_random;
+};
+
+Ipv6EndPointDemuxTest::Ipv6EndPointDemuxTest ()
+  : TestCase ("Check the IPv6 demux against a linear lookup")
+{
+}
+
+Ipv6EndPointDemuxTest::EndPoints
+Ipv6EndPointDemuxTest::Lookup (Ipv6Address daddr, uint16_t dport, Ipv6Address saddr, uint16_t sport)
+{
+  EndPoints retval1, retval2, retval3, retval4;
+  for (EndPoints::iterator i = m_reference.begin (); i != m_reference.end (); i++)
+    {
+      Ipv6EndPoint *endP = *i;
+      if (!endP->IsRxEnabled () || endP->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      bool localAddressMatchesWildCard = endP->GetLocalAddress () == Ipv6Address::GetAny ();
+      bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
+      bool localAddressMatchesAllRouters = endP->GetLocalAddress () == Ipv6Address::GetAllRoutersMulticast ();
+      if (!(localAddressMatchesExact || localAddressMatchesWildCard))
+        {
+          continue;
+        }
+      bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
+      bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
+      bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
+      bool remoteAddressMatchesWildCard = endP->GetPeerAddress () == Ipv6Address::GetAny ();
+      if (!(remotePeerMatchesExact || remotePeerMatchesWildCard)
+          || !(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
+        {
+          continue;
+        }
+      if (localAddressMatchesWildCard && remotePeerMatchesWildCard && remoteAddressMatchesWildCard)
+        {
+          retval1.push_back (endP);
+        }
+      if ((localAddressMatchesExact || localAddressMatchesAllRouters)
+          && remotePeerMatchesWildCard && remoteAddressMatchesWildCard)
+        {
+          retval2.push_back (endP);
+        }
+      if (localAddressMatchesWildCard && remotePeerMatchesExact && remoteAddressMatchesExact)
+        {
+          retval3.push_back (endP);
+        }
+      if (localAddressMatchesExact && remotePeerMatchesExact && remoteAddressMatchesExact)
+        {
+          retval4.push_back (endP);
+        }
+    }
+  if (!retval4.empty ())
+    {
+      return retval4;
+    }
+  if (!retval3.empty ())
+    {
+      return retval3;
+    }
+  if (!retval2.empty ())
+    {
+      return retval2;
+    }
+  return retval1;
+}
+
+Ipv6EndPoint *
+Ipv6EndPointDemuxTest::SimpleLookup (Ipv6Address daddr, uint16_t dport, Ipv6Address saddr, uint16_t sport)
+{
+  uint32_t genericity = 3;
+  Ipv6EndPoint *generic = 0;
+  for (EndPoints::iterator i = m_reference.begin (); i != m_reference.end (); i++)
+    {
+      if ((*i)->GetLocalPort () != dport)
+        {
+          continue;
+        }
+      if ((*i)->GetLocalAddress () == daddr && (*i)->GetPeerPort () == sport
+          && (*i)->GetPeerAddress () == saddr)
+        {
+          return *i;
+        }
+      uint32_t tmp = ((*i)->GetLocalAddress () == Ipv6Address::GetAny ())
+        + ((*i)->GetPeerAddress () == Ipv6Address::GetAny ());
+      if (tmp < genericity)
+        {
+          generic = *i;
+          genericity = tmp;
+        }
+    }
+  return generic;
+}
+
+bool
+Ipv6EndPointDemuxTest::LookupLocal (Ipv6Address addr, uint16_t port)
+{
+  for (EndPoints::iterator i = m_reference.begin (); i != m_reference.end (); i++)
+    {
+      if ((*i)->GetLocalPort () == port && (*i)->GetLocalAddress () == addr)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+bool
+Ipv6EndPointDemuxTest::Exists (Ipv6Address localAddress, uint16_t localPort,
+                               Ipv6Address peerAddress, uint16_t peerPort)
+{
+  for (EndPoints::iterator i = m_reference.begin (); i != m_reference.end (); i++)
+    {
+      if ((*i)->GetLocalPort () == localPort && (*i)->GetLocalAddress () == localAddress
+          && (*i)->GetPeerPort () == peerPort && (*i)->GetPeerAddress () == peerAddress)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+Ipv6Address
+Ipv6EndPointDemuxTest::GetAddress (uint32_t i)
+{
+  static const char *addresses[] = { "::", "2001:db8::1", "2001:db8::2", "ff02::2", "2001:db8:1::1" };
+  return Ipv6Address (addresses[i % 5]);
+}
+
+void
+Ipv6EndPointDemuxTest::DoRun (void)
+{
+  m_random = CreateObject<UniformRandomVariable> ();
+  m_random->SetStream (2);
+
+  Ipv6EndPointDemux demux;
+  for (uint32_t step = 0; step < 20000; step++)
+    {
+      uint16_t localPort = 1 + m_random->GetInteger (0, 3);
+      uint16_t peerPort = m_random->GetInteger (0, 3);
+      Ipv6Address localAddress = GetAddress (m_random->GetInteger (0, 4));
+      Ipv6Address peerAddress = GetAddress (m_random->GetInteger (0, 4));
+      switch (m_random->GetInteger (0, 6))
+        {
+        case 0:
+          {
+            bool expected = !LookupLocal (localAddress, localPort);
+            Ipv6EndPoint *endPoint = demux.Allocate (localAddress, localPort);
+            NS_TEST_ASSERT_MSG_EQ ((endPoint != 0), expected, "Allocate (address, port) disagrees");
+            if (endPoint != 0)
+              {
+                m_reference.push_back (endPoint);
+              }
+            break;
+          }
+        case 1:
+          {
+            bool expected = !Exists (localAddress, localPort, peerAddress, peerPort);
+            Ipv6EndPoint *endPoint = demux.Allocate (localAddress, localPort, peerAddress, peerPort);
+            NS_TEST_ASSERT_MSG_EQ ((endPoint != 0), expected, "Allocate (four-tuple) disagrees");
+            if (endPoint != 0)
+              {
+                m_reference.push_back (endPoint);
+              }
+            break;
+          }
+        case 2:
+          if (!m_reference.empty ())
+            {
+              EndPoints::iterator i = m_reference.begin ();
+              std::advance (i, m_random->GetInteger (0, m_reference.size () - 1));
+              demux.DeAllocate (*i);
+              m_reference.erase (i);
+            }
+          break;
+        case 3:
+          if (!m_reference.empty ())
+            {
+              EndPoints::iterator i = m_reference.begin ();
+              std::advance (i, m_random->GetInteger (0, m_reference.size () - 1));
+              (*i)->SetPeer (peerAddress, peerPort);
+              (*i)->SetRxEnabled (m_random->GetInteger (0, 7) != 0);
+            }
+          break;
+        case 4:
+          if (!m_reference.empty ())
+            {
+              EndPoints::iterator i = m_reference.begin ();
+              std::advance (i, m_random->GetInteger (0, m_reference.size () - 1));
+              (*i)->SetLocalPort (localPort);
+            }
+          break;
+        default:
+          {
+            EndPoints expected = Lookup (localAddress, localPort, peerAddress, peerPort);
+            EndPoints found = demux.Lookup (localAddress, localPort, peerAddress, peerPort, 0);
+            NS_TEST_ASSERT_MSG_EQ ((found == expected), true, "Lookup disagrees at step " << step);
+            NS_TEST_ASSERT_MSG_EQ (demux.SimpleLookup (localAddress, localPort, peerAddress, peerPort),
+                                   SimpleLookup (localAddress, localPort, peerAddress, peerPort),
+                                   "SimpleLookup disagrees at step " << step);
+            NS_TEST_ASSERT_MSG_EQ (demux.LookupLocal (localAddress, localPort),
+                                   LookupLocal (localAddress, localPort),
+                                   "LookupLocal disagrees at step " << step);
+            break;
+          }
+        }
+      if (m_reference.size () > 60)
+        {
+          demux.DeAllocate (m_reference.front ());
+          m_reference.pop_front ();
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ ((demux.GetEndPoints () == m_reference), true, "Allocation order not kept");
+  for (uint16_t port = 0; port < 6; port++)
+    {
+      bool expected = false;
+      for (EndPoints::iterator i = m_reference.begin (); i != m_reference.end (); i++)
+        {
+          expected |= (*i)->GetLocalPort () == port;
+        }
+      NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (port), expected, "LookupPortLocal disagrees");
+    }
+  m_reference.clear ();
+}
+
+//-----------------------------------------------------------------------------
+class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite ();
+};
+
+EndPointDemuxTestSuite::EndPointDemuxTestSuite ()
+  : TestSuite ("end-point-demux", UNIT)
+{
+  AddTestCase (new Ipv4EndPointDemuxTest, TestCase::QUICK);
+  AddTestCase (new Ipv6EndPointDemuxTest, TestCase::QUICK);
+}
+
+static EndPointDemuxTestSuite g_endPointDemuxTestSuite;
@@ -26,7 +26,10 @@
 #include "ns3/global-route-manager-impl.h"
 #include "ns3/candidate-queue.h"
 #include "ns3/simulator.h"
+#include "ns3/random-variable-stream.h"
+#include <algorithm>
 #include <cstdlib> // for rand()
+#include <list>
 
 using namespace ns3;
 
@@ -214,6 +217,115 @@ GlobalRouteManagerImplTestCase::DoRun (void)
 }
 
 
+/**
+ * \brief Check the candidate queue against a sorted list, which keeps the
+ * vertices of equal distance and type in the order they were queued
+ */
+class CandidateQueueTestCase : public TestCase
+{
+public:
+  CandidateQueueTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * \param a a vertex
+   * \param b another vertex
+   * \returns true if a should be popped before b
+   */
+  static bool Compare (const SPFVertex *a, const SPFVertex *b);
+};
+
+CandidateQueueTestCase::CandidateQueueTestCase ()
+  : TestCase ("Check the candidate queue against a sorted list")
+{
+}
+
+bool
+CandidateQueueTestCase::Compare (const SPFVertex *a, const SPFVertex *b)
+{
+  if (a->GetDistanceFromRoot () != b->GetDistanceFromRoot ())
+    {
+      return a->GetDistanceFromRoot () < b->GetDistanceFromRoot ();
+    }
+  return a->GetVertexType () == SPFVertex::VertexNetwork && b->GetVertexType () == SPFVertex::VertexRouter;
+}
+
+void
+CandidateQueueTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+
+  CandidateQueue candidate;
+  std::list<SPFVertex *> expected;
+  uint32_t id = 0;
+  for (uint32_t step = 0; step < 20000; step++)
+    {
+      uint32_t action = random->GetInteger (0, 4);
+      if (action <= 1 && expected.size () < 100)
+        {
+          SPFVertex *v = new SPFVertex;
+          v->SetVertexId (Ipv4Address (++id));
+          v->SetVertexType (random->GetInteger (0, 1) ? SPFVertex::VertexRouter : SPFVertex::VertexNetwork);
+          v->SetDistanceFromRoot (random->GetInteger (0, 20));
+          candidate.Push (v);
+          expected.insert (std::upper_bound (expected.begin (), expected.end (), v, &Compare), v);
+        }
+      else if (action == 2 && !expected.empty ())
+        {
+          // decrease the distance of a vertex, as SPFNext does
+          std::list<SPFVertex *>::iterator i = expected.begin ();
+          std::advance (i, random->GetInteger (0, expected.size () - 1));
+          SPFVertex *v = *i;
+          if (v->GetDistanceFromRoot () > 0)
+            {
+              v->SetDistanceFromRoot (random->GetInteger (0, v->GetDistanceFromRoot () - 1));
+              if (random->GetInteger (0, 1))
+                {
+                  candidate.Update (v);
+                }
+              else
+                {
+                  candidate.Reorder ();
+                }
+              expected.sort (&Compare);
+            }
+        }
+      else if (action == 3 && id > 0)
+        {
+          Ipv4Address addr (random->GetInteger (1, id));
+          SPFVertex *found = 0;
+          for (std::list<SPFVertex *>::iterator i = expected.begin (); i != expected.end (); i++)
+            {
+              if ((*i)->GetVertexId () == addr)
+                {
+                  found = *i;
+                  break;
+                }
+            }
+          NS_TEST_ASSERT_MSG_EQ (candidate.Find (addr), found, "Bad vertex for " << addr);
+        }
+      else if (!expected.empty ())
+        {
+          NS_TEST_ASSERT_MSG_EQ (candidate.Top (), expected.front (), "Bad top vertex");
+          SPFVertex *v = candidate.Pop ();
+          NS_TEST_ASSERT_MSG_EQ (v, expected.front (), "Bad popped vertex");
+          expected.pop_front ();
+          delete v;
+        }
+      NS_TEST_ASSERT_MSG_EQ (candidate.Size (), expected.size (), "Bad number of candidates");
+    }
+
+  while (!expected.empty ())
+    {
+      SPFVertex *v = candidate.Pop ();
+      NS_TEST_ASSERT_MSG_EQ (v, expected.front (), "Bad popped vertex");
+      expected.pop_front ();
+      delete v;
+    }
+  NS_TEST_EXPECT_MSG_EQ (candidate.Empty (), true, "Vertices left in the queue");
+}
+
 static class GlobalRouteManagerImplTestSuite : public TestSuite
 {
 public:
@@ -221,5 +333,6 @@ public:
     : TestSuite ("global-route-manager-impl", UNIT)
   {
     AddTestCase (new GlobalRouteManagerImplTestCase (), TestCase::QUICK);
+    AddTestCase (new CandidateQueueTestCase (), TestCase::QUICK);
   }
 } g_globalRoutingManagerImplTestSuite;
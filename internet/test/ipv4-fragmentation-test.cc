@@ -47,9 +47,13 @@
 #include "ns3/ipv4-static-routing.h"
 #include "ns3/udp-l4-protocol.h"
 #include "ns3/internet-stack-helper.h"
+#include "ns3/simple-channel.h"
+#include "ns3/random-variable-stream.h"
 
 #include <string>
 #include <limits>
+#include <vector>
+#include <algorithm>
 #include <netinet/in.h>
 
 using namespace ns3;
@@ -452,6 +456,250 @@ Ipv4FragmentationTest::DoRun (void)
 
   Simulator::Destroy ();
 }
+
+/* ----------------------------------------------------------------------------------
+ * Reassembly of many interleaved datagrams, whose fragments arrive out of
+ * order, overlap and are duplicated. Some datagrams miss a fragment and
+ * must expire FragmentExpirationTimeout after their first fragment.
+ --------------------------------------------------------------------------------- */
+class Ipv4ReassemblyTest : public TestCase
+{
+public:
+  Ipv4ReassemblyTest ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief A fragment to deliver.
+   */
+  struct Fragment
+  {
+    Time time;       //!< arrival time
+    uint32_t id;     //!< datagram index
+    uint16_t offset; //!< offset of the fragment
+    uint16_t size;   //!< size of the fragment
+    bool last;       //!< true if the More Fragments flag is clear
+  };
+  /**
+   * \brief A datagram and its expected fate.
+   */
+  struct Datagram
+  {
+    Ipv4Address source;        //!< source address
+    std::vector<uint8_t> data; //!< payload
+    bool complete;             //!< true if all the fragments are sent
+    Time first;                //!< arrival time of the first fragment
+    uint32_t delivered;        //!< number of deliveries
+    uint32_t expired;          //!< number of expirations
+  };
+  static bool ArrivesBefore (const Fragment &a, const Fragment &b);
+  void Deliver (Fragment fragment);
+  void LocalDeliver (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t iif);
+  void Drop (const Ipv4Header &header, Ptr<const Packet> packet,
+             Ipv4L3Protocol::DropReason reason, Ptr<Ipv4> ipv4, uint32_t iif);
+
+  Ptr<Ipv4L3Protocol> m_ipv4;
+  Ptr<NetDevice> m_device;
+  std::vector<Datagram> m_datagrams;
+};
+
+Ipv4ReassemblyTest::Ipv4ReassemblyTest ()
+  : TestCase ("Verify the IPv4 reassembly of overlapping, duplicate and missing fragments")
+{
+}
+
+bool
+Ipv4ReassemblyTest::ArrivesBefore (const Fragment &a, const Fragment &b)
+{
+  return a.time < b.time;
+}
+
+void
+Ipv4ReassemblyTest::Deliver (Fragment fragment)
+{
+  Datagram &datagram = m_datagrams[fragment.id];
+  Ptr<Packet> packet = Create<Packet> (&datagram.data[fragment.offset], fragment.size);
+  Ipv4Header header;
+  header.SetSource (datagram.source);
+  header.SetDestination (Ipv4Address ("10.0.0.1"));
+  header.SetProtocol (200);
+  header.SetTtl (64);
+  header.SetIdentification (fragment.id);
+  header.SetPayloadSize (fragment.size);
+  header.SetFragmentOffset (fragment.offset);
+  if (fragment.last)
+    {
+      header.SetLastFragment ();
+    }
+  else
+    {
+      header.SetMoreFragments ();
+    }
+  packet->AddHeader (header);
+  m_ipv4->Receive (m_device, packet, Ipv4L3Protocol::PROT_NUMBER, Mac48Address ("00:00:00:00:00:02"),
+                   m_device->GetAddress (), NetDevice::PACKET_HOST);
+}
+
+void
+Ipv4ReassemblyTest::LocalDeliver (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t iif)
+{
+  Datagram &datagram = m_datagrams[header.GetIdentification ()];
+  datagram.delivered++;
+  NS_TEST_ASSERT_MSG_EQ (datagram.complete, true, "Delivered an incomplete datagram " << header.GetIdentification ());
+  NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), datagram.data.size (), "Bad size of datagram " << header.GetIdentification ());
+  std::vector<uint8_t> data (packet->GetSize ());
+  packet->CopyData (&data[0], data.size ());
+  NS_TEST_EXPECT_MSG_EQ ((data == datagram.data), true, "Bad content of datagram " << header.GetIdentification ());
+}
+
+void
+Ipv4ReassemblyTest::Drop (const Ipv4Header &header, Ptr<const Packet> packet,
+                          Ipv4L3Protocol::DropReason reason, Ptr<Ipv4> ipv4, uint32_t iif)
+{
+  if (reason != Ipv4L3Protocol::DROP_FRAGMENT_TIMEOUT)
+    {
+      return;
+    }
+  Datagram &datagram = m_datagrams[header.GetIdentification ()];
+  datagram.expired++;
+  NS_TEST_EXPECT_MSG_EQ (datagram.complete, false, "Expired a complete datagram " << header.GetIdentification ());
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), datagram.first + Seconds (30),
+                         "Bad expiration time of datagram " << header.GetIdentification ());
+}
+
+void
+Ipv4ReassemblyTest::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAddress (Mac48Address ("00:00:00:00:00:01"));
+  device->SetChannel (CreateObject<SimpleChannel> ());
+  device->SetMtu (1500);
+  node->AddDevice (device);
+  m_device = device;
+  m_ipv4 = node->GetObject<Ipv4L3Protocol> ();
+  uint32_t interface = m_ipv4->AddInterface (device);
+  m_ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.255.255.0")));
+  m_ipv4->SetUp (interface);
+  m_ipv4->TraceConnectWithoutContext ("LocalDeliver", MakeCallback (&Ipv4ReassemblyTest::LocalDeliver, this));
+  m_ipv4->TraceConnectWithoutContext ("Drop", MakeCallback (&Ipv4ReassemblyTest::Drop, this));
+
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+
+  std::vector<Fragment> fragments;
+  for (uint32_t id = 0; id < 200; id++)
+    {
+      Datagram datagram;
+      datagram.source = Ipv4Address (0x0a000002 + id % 4);
+      datagram.data.resize (8 * random->GetInteger (2, 500) + random->GetInteger (0, 7));
+      for (uint32_t i = 0; i < datagram.data.size (); i++)
+        {
+          datagram.data[i] = random->GetInteger (0, 255);
+        }
+      datagram.complete = random->GetInteger (0, 3) != 0;
+      datagram.delivered = 0;
+      datagram.expired = 0;
+      uint32_t size = datagram.data.size ();
+
+      // cut the datagram in pieces of multiples of 8 bytes
+      std::vector<Fragment> pieces;
+      uint32_t offset = 0;
+      while (offset < size)
+        {
+          Fragment piece;
+          piece.id = id;
+          piece.offset = offset;
+          piece.size = std::min<uint32_t> (8 * random->GetInteger (1, 40), size - offset);
+          piece.last = offset + piece.size == size;
+          pieces.push_back (piece);
+          offset += piece.size;
+        }
+      if (pieces.size () < 2)
+        {
+          datagram.complete = true;
+        }
+      uint16_t lastOffset = pieces.back ().offset;
+      if (datagram.complete)
+        {
+          // overlapping pieces and duplicates, which all start before the
+          // last piece: the datagram is only complete once the last piece
+          // has arrived
+          uint32_t extras = random->GetInteger (0, 4);
+          for (uint32_t i = 0; i < extras && lastOffset > 0; i++)
+            {
+              Fragment piece;
+              piece.id = id;
+              piece.offset = 8 * random->GetInteger (0, lastOffset / 8 - 1);
+              piece.size = random->GetInteger (1, size - 1 - piece.offset);
+              piece.last = false;
+              pieces.push_back (piece);
+            }
+          uint32_t duplicates = random->GetInteger (0, 2);
+          for (uint32_t i = 0; i < duplicates; i++)
+            {
+              Fragment piece = pieces[random->GetInteger (0, pieces.size () - 1)];
+              if (!piece.last)
+                {
+                  pieces.push_back (piece);
+                }
+            }
+        }
+      else
+        {
+          pieces.erase (pieces.begin () + random->GetInteger (0, pieces.size () - 1));
+        }
+
+      // random arrival times; a complete datagram gets its last piece last
+      std::vector<Time> times;
+      for (uint32_t i = 0; i < pieces.size (); i++)
+        {
+          times.push_back (MilliSeconds (random->GetInteger (0, 10000)));
+        }
+      std::sort (times.begin (), times.end ());
+      for (uint32_t i = 0; i < pieces.size (); i++)
+        {
+          uint32_t j = random->GetInteger (i, pieces.size () - 1);
+          std::swap (pieces[i], pieces[j]);
+        }
+      for (uint32_t i = 0; i < pieces.size (); i++)
+        {
+          if (pieces[i].last)
+            {
+              std::swap (pieces[i], pieces.back ());
+            }
+        }
+      for (uint32_t i = 0; i < pieces.size (); i++)
+        {
+          pieces[i].time = times[i];
+          fragments.push_back (pieces[i]);
+        }
+      datagram.first = times.front ();
+      m_datagrams.push_back (datagram);
+    }
+
+  std::stable_sort (fragments.begin (), fragments.end (), &Ipv4ReassemblyTest::ArrivesBefore);
+  for (uint32_t i = 0; i < fragments.size (); i++)
+    {
+      Simulator::Schedule (fragments[i].time, &Ipv4ReassemblyTest::Deliver, this, fragments[i]);
+    }
+  Simulator::Run ();
+
+  for (uint32_t id = 0; id < m_datagrams.size (); id++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_datagrams[id].delivered, (m_datagrams[id].complete ? 1 : 0),
+                             "Bad number of deliveries of datagram " << id);
+      NS_TEST_EXPECT_MSG_EQ (m_datagrams[id].expired, (m_datagrams[id].complete ? 0 : 1),
+                             "Bad number of expirations of datagram " << id);
+    }
+
+  m_ipv4 = 0;
+  m_device = 0;
+  Simulator::Destroy ();
+}
+
 //-----------------------------------------------------------------------------
 class Ipv4FragmentationTestSuite : public TestSuite
 {
@@ -459,5 +707,6 @@ public:
   Ipv4FragmentationTestSuite () : TestSuite ("ipv4-fragmentation", UNIT)
   {
     AddTestCase (new Ipv4FragmentationTest, TestCase::QUICK);
+    AddTestCase (new Ipv4ReassemblyTest, TestCase::QUICK);
   }
 } g_ipv4fragmentationTestSuite;
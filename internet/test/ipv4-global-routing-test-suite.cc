@@ -36,6 +36,12 @@
 #include "ns3/simple-channel.h"
 #include "ns3/socket-factory.h"
 #include "ns3/udp-socket-factory.h"
+#include "ns3/global-router-interface.h"
+#include "ns3/global-route-manager.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/random-variable-stream.h"
+#include <sstream>
 
 using namespace ns3;
 
@@ -420,6 +426,136 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
 }
 
 
+// Check that the routes updated after a topology change are the
+// routes computed from scratch
+class Ipv4GlobalRoutingUpdateTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingUpdateTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param nodes the nodes
+   * \returns the routing tables of the nodes
+   */
+  std::vector<std::string> GetRoutes (NodeContainer nodes);
+};
+
+Ipv4GlobalRoutingUpdateTestCase::Ipv4GlobalRoutingUpdateTestCase ()
+  : TestCase ("Incremental update of the global routes")
+{
+}
+
+std::vector<std::string>
+Ipv4GlobalRoutingUpdateTestCase::GetRoutes (NodeContainer nodes)
+{
+  std::vector<std::string> tables;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<Ipv4GlobalRouting> routing = nodes.Get (i)->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+      std::ostringstream oss;
+      for (uint32_t j = 0; j < routing->GetNRoutes (); j++)
+        {
+          oss << *routing->GetRoute (j) << std::endl;
+        }
+      tables.push_back (oss.str ());
+    }
+  return tables;
+}
+
+void
+Ipv4GlobalRoutingUpdateTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+
+  // two separate networks: a ring of 12 routers with chords, and a
+  // line of 3 routers which also share a segment.  The segment keeps
+  // its metric, as the SPF calculation does not support several equal
+  // cost paths to a network which is not adjacent to the root.
+  NodeContainer c;
+  c.Create (15);
+  InternetStackHelper internet;
+  internet.Install (c);
+
+  SimpleNetDeviceHelper devHelper;
+  devHelper.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.0.0", "255.255.255.252");
+  std::vector<std::pair<Ptr<Ipv4>, uint32_t> > interfaces;
+  for (uint32_t i = 0; i < 12 + 8 + 2; i++)
+    {
+      Ptr<Node> a;
+      Ptr<Node> b;
+      if (i < 12)
+        {
+          a = c.Get (i);
+          b = c.Get ((i + 1) % 12);
+        }
+      else if (i < 20)
+        {
+          a = c.Get (random->GetInteger (0, 11));
+          b = c.Get ((a->GetId () - c.Get (0)->GetId () + random->GetInteger (2, 10)) % 12);
+        }
+      else
+        {
+          a = c.Get (12 + i - 20);
+          b = c.Get (13 + i - 20);
+        }
+      NetDeviceContainer d = devHelper.Install (NodeContainer (a, b));
+      Ipv4InterfaceContainer ifs = ipv4.Assign (d);
+      ipv4.NewNetwork ();
+      for (uint32_t j = 0; j < 2; j++)
+        {
+          interfaces.push_back (ifs.Get (j));
+          ifs.Get (j).first->SetMetric (ifs.Get (j).second, random->GetInteger (1, 3));
+        }
+    }
+  devHelper.SetNetDevicePointToPointMode (false);
+  ipv4.SetBase ("10.2.0.0", "255.255.255.0");
+  Ipv4InterfaceContainer segment = ipv4.Assign (devHelper.Install (NodeContainer (c.Get (12), c.Get (13), c.Get (14))));
+  uint32_t nLinkInterfaces = interfaces.size ();
+  for (uint32_t j = 0; j < segment.GetN (); j++)
+    {
+      interfaces.push_back (segment.Get (j));
+    }
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  for (uint32_t step = 0; step < 40; step++)
+    {
+      // take a link down or up, or change its cost
+      uint32_t index = random->GetInteger (0, interfaces.size () - 1);
+      std::pair<Ptr<Ipv4>, uint32_t> interface = interfaces[index];
+      uint32_t action = random->GetInteger (0, index < nLinkInterfaces ? 2 : 1);
+      if (action == 0)
+        {
+          interface.first->SetDown (interface.second);
+        }
+      else if (action == 1)
+        {
+          interface.first->SetUp (interface.second);
+        }
+      else
+        {
+          interface.first->SetMetric (interface.second, random->GetInteger (1, 3));
+        }
+
+      Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+      std::vector<std::string> updated = GetRoutes (c);
+      GlobalRouteManager::DeleteGlobalRoutes ();
+      GlobalRouteManager::BuildGlobalRoutingDatabase ();
+      GlobalRouteManager::InitializeRoutes ();
+      std::vector<std::string> expected = GetRoutes (c);
+      for (uint32_t i = 0; i < c.GetN (); i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (updated[i], expected[i], "Bad routes for node " << i << " at step " << step);
+        }
+    }
+
+  Simulator::Destroy ();
+}
+
 class Ipv4GlobalRoutingTestSuite : public TestSuite
 {
 public:
@@ -431,6 +567,7 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
 {
   AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
   AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingUpdateTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -0,0 +1,135 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-route-trie.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include <list>
+#include <vector>
+
+using namespace ns3;
+
+//-----------------------------------------------------------------------------
+// The trie returns the routes matching an address in insertion order
+//-----------------------------------------------------------------------------
+class Ipv4RouteTrieTest : public TestCase
+{
+public:
+  Ipv4RouteTrieTest ();
+  virtual void DoRun (void);
+private:
+  Ipv4Address GetAddress (void);
+  Ipv4Mask GetMask (void);
+  Ptr<UniformRandomVariable> m_random;
+};
+
+Ipv4RouteTrieTest::Ipv4RouteTrieTest ()
+  : TestCase ("Check the route trie against a linear search")
+{
+}
+
+Ipv4Address
+Ipv4RouteTrieTest::GetAddress (void)
+{
+  // a few networks, so that the prefixes nest and collide
+  return Ipv4Address (0x0a000000 | (m_random->GetInteger (0, 3) << 16)
+                      | (m_random->GetInteger (0, 3) << 8) | m_random->GetInteger (0, 3));
+}
+
+Ipv4Mask
+Ipv4RouteTrieTest::GetMask (void)
+{
+  static const char *masks[] = { "0.0.0.0", "255.0.0.0", "255.254.0.0", "255.255.0.0",
+                                 "255.255.255.0", "255.255.255.252", "255.255.255.255",
+                                 "255.0.255.0" };
+  return Ipv4Mask (masks[m_random->GetInteger (0, 7)]);
+}
+
+void
+Ipv4RouteTrieTest::DoRun (void)
+{
+  m_random = CreateObject<UniformRandomVariable> ();
+  m_random->SetStream (1);
+
+  Ipv4RouteTrie trie;
+  std::list<Ipv4RoutingTableEntry *> table;
+  for (uint32_t step = 0; step < 20000; step++)
+    {
+      uint32_t action = m_random->GetInteger (0, 3);
+      if (action == 0 && table.size () < 200)
+        {
+          Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
+          *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo (GetAddress (), GetMask (), step);
+          table.push_back (route);
+          trie.Insert (route, step);
+        }
+      else if (action == 1 && !table.empty ())
+        {
+          std::list<Ipv4RoutingTableEntry *>::iterator i = table.begin ();
+          std::advance (i, m_random->GetInteger (0, table.size () - 1));
+          trie.Remove (*i);
+          delete *i;
+          table.erase (i);
+        }
+      else
+        {
+          Ipv4Address dest = GetAddress ();
+          std::vector<Ipv4RoutingTableEntry *> expected;
+          for (std::list<Ipv4RoutingTableEntry *>::iterator i = table.begin (); i != table.end (); i++)
+            {
+              if ((*i)->GetDestNetworkMask ().IsMatch (dest, (*i)->GetDestNetwork ()))
+                {
+                  expected.push_back (*i);
+                }
+            }
+          std::vector<Ipv4RouteTrie::Route> routes;
+          trie.Lookup (dest, routes);
+          NS_TEST_ASSERT_MSG_EQ (routes.size (), expected.size (), "Bad number of routes to " << dest);
+          for (uint32_t i = 0; i < routes.size (); i++)
+            {
+              NS_TEST_ASSERT_MSG_EQ (routes[i].entry, expected[i], "Bad route to " << dest);
+              NS_TEST_ASSERT_MSG_EQ (routes[i].metric, routes[i].entry->GetInterface (), "Bad metric");
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (trie.GetNRoutes (), table.size (), "Bad number of routes");
+    }
+
+  for (std::list<Ipv4RoutingTableEntry *>::iterator i = table.begin (); i != table.end (); i++)
+    {
+      trie.Remove (*i);
+      delete *i;
+    }
+  NS_TEST_EXPECT_MSG_EQ (trie.GetNRoutes (), 0, "Routes left in the trie");
+  std::vector<Ipv4RouteTrie::Route> routes;
+  trie.Lookup (Ipv4Address ("10.0.0.1"), routes);
+  NS_TEST_EXPECT_MSG_EQ (routes.size (), 0, "Routes left in the trie");
+}
+
+//-----------------------------------------------------------------------------
+class Ipv4RouteTrieTestSuite : public TestSuite
+{
+public:
+  Ipv4RouteTrieTestSuite ();
+};
+
+Ipv4RouteTrieTestSuite::Ipv4RouteTrieTestSuite ()
+  : TestSuite ("ipv4-route-trie", UNIT)
+{
+  AddTestCase (new Ipv4RouteTrieTest, TestCase::QUICK);
+}
+
+static Ipv4RouteTrieTestSuite g_ipv4RouteTrieTestSuite;
@@ -55,9 +55,14 @@
 
 #include "ns3/ipv6-l3-protocol.h"
 #include "ns3/icmpv6-l4-protocol.h"
+#include "ns3/ipv6-extension-header.h"
+#include "ns3/simple-channel.h"
+#include "ns3/random-variable-stream.h"
 
 #include <string>
 #include <limits>
+#include <vector>
+#include <algorithm>
 #include <netinet/in.h>
 
 using namespace ns3;
@@ -484,6 +489,269 @@ Ipv6FragmentationTest::DoRun (void)
 
   Simulator::Destroy ();
 }
+
+/* ----------------------------------------------------------------------------------
+ * Reassembly of many interleaved datagrams, whose fragments arrive out of
+ * order. Some datagrams miss a fragment, or get duplicate or overlapping
+ * fragments, which IPv6 does not reassemble: they must expire 60 seconds
+ * after their first fragment.
+ --------------------------------------------------------------------------------- */
+class Ipv6ReassemblyTest : public TestCase
+{
+public:
+  Ipv6ReassemblyTest ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief A fragment to deliver.
+   */
+  struct Fragment
+  {
+    Time time;       //!< arrival time
+    uint32_t id;     //!< datagram index
+    uint16_t offset; //!< offset of the fragment
+    uint16_t size;   //!< size of the fragment
+    bool last;       //!< true if the More Fragments flag is clear
+  };
+  /**
+   * \brief A datagram and its expected fate.
+   */
+  struct Datagram
+  {
+    std::vector<uint8_t> data; //!< payload
+    bool complete;             //!< true if the datagram can be reassembled
+    Time first;                //!< arrival time of the first fragment
+    uint32_t delivered;        //!< number of deliveries
+    uint32_t expired;          //!< number of expirations
+  };
+  /**
+   * \param id a datagram index
+   * \returns the source address of the datagram, which identifies it in the traces
+   */
+  static Ipv6Address GetSource (uint32_t id);
+  /**
+   * \param source the source address of a datagram
+   * \returns the datagram index
+   */
+  static uint32_t GetId (Ipv6Address source);
+  static bool ArrivesBefore (const Fragment &a, const Fragment &b);
+  void Deliver (Fragment fragment);
+  void LocalDeliver (const Ipv6Header &header, Ptr<const Packet> packet, uint32_t iif);
+  void Drop (const Ipv6Header &header, Ptr<const Packet> packet,
+             Ipv6L3Protocol::DropReason reason, Ptr<Ipv6> ipv6, uint32_t iif);
+
+  Ptr<Ipv6L3Protocol> m_ipv6;
+  Ptr<NetDevice> m_device;
+  std::vector<Datagram> m_datagrams;
+};
+
+Ipv6ReassemblyTest::Ipv6ReassemblyTest ()
+  : TestCase ("Verify the IPv6 reassembly of reordered, overlapping and missing fragments")
+{
+}
+
+Ipv6Address
+Ipv6ReassemblyTest::GetSource (uint32_t id)
+{
+  uint8_t address[16] = { 0x20, 0x01, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2 };
+  address[13] = id >> 8;
+  address[14] = id;
+  return Ipv6Address (address);
+}
+
+uint32_t
+Ipv6ReassemblyTest::GetId (Ipv6Address source)
+{
+  uint8_t address[16];
+  source.GetBytes (address);
+  return (address[13] << 8) | address[14];
+}
+
+bool
+Ipv6ReassemblyTest::ArrivesBefore (const Fragment &a, const Fragment &b)
+{
+  return a.time < b.time;
+}
+
+void
+Ipv6ReassemblyTest::Deliver (Fragment fragment)
+{
+  Datagram &datagram = m_datagrams[fragment.id];
+  Ptr<Packet> packet = Create<Packet> (&datagram.data[fragment.offset], fragment.size);
+  Ipv6ExtensionFragmentHeader fragmentHeader;
+  fragmentHeader.SetNextHeader (UdpL4Protocol::PROT_NUMBER);
+  fragmentHeader.SetIdentification (fragment.id);
+  fragmentHeader.SetOffset (fragment.offset);
+  fragmentHeader.SetMoreFragment (!fragment.last);
+  packet->AddHeader (fragmentHeader);
+  Ipv6Header header;
+  header.SetSourceAddress (GetSource (fragment.id));
+  header.SetDestinationAddress (Ipv6Address ("2001::1"));
+  header.SetNextHeader (Ipv6Header::IPV6_EXT_FRAGMENTATION);
+  header.SetHopLimit (64);
+  header.SetPayloadLength (packet->GetSize ());
+  packet->AddHeader (header);
+  m_ipv6->Receive (m_device, packet, Ipv6L3Protocol::PROT_NUMBER, Mac48Address ("00:00:00:00:00:02"),
+                   m_device->GetAddress (), NetDevice::PACKET_HOST);
+}
+
+void
+Ipv6ReassemblyTest::LocalDeliver (const Ipv6Header &header, Ptr<const Packet> packet, uint32_t iif)
+{
+  if (header.GetNextHeader () != Ipv6Header::IPV6_EXT_FRAGMENTATION)
+    {
+      // not a reassembled datagram
+      return;
+    }
+  uint32_t id = GetId (header.GetSourceAddress ());
+  Datagram &datagram = m_datagrams[id];
+  datagram.delivered++;
+  NS_TEST_ASSERT_MSG_EQ (datagram.complete, true, "Delivered an incomplete datagram " << id);
+  NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), datagram.data.size (), "Bad size of datagram " << id);
+  std::vector<uint8_t> data (packet->GetSize ());
+  packet->CopyData (&data[0], data.size ());
+  NS_TEST_EXPECT_MSG_EQ ((data == datagram.data), true, "Bad content of datagram " << id);
+}
+
+void
+Ipv6ReassemblyTest::Drop (const Ipv6Header &header, Ptr<const Packet> packet,
+                          Ipv6L3Protocol::DropReason reason, Ptr<Ipv6> ipv6, uint32_t iif)
+{
+  if (reason != Ipv6L3Protocol::DROP_FRAGMENT_TIMEOUT)
+    {
+      return;
+    }
+  uint32_t id = GetId (header.GetSourceAddress ());
+  Datagram &datagram = m_datagrams[id];
+  datagram.expired++;
+  NS_TEST_EXPECT_MSG_EQ (datagram.complete, false, "Expired a complete datagram " << id);
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), datagram.first + Seconds (60),
+                         "Bad expiration time of datagram " << id);
+}
+
+void
+Ipv6ReassemblyTest::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  AddInternetStack (node);
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAddress (Mac48Address ("00:00:00:00:00:01"));
+  device->SetChannel (CreateObject<SimpleChannel> ());
+  device->SetMtu (1500);
+  node->AddDevice (device);
+  m_device = device;
+  m_ipv6 = node->GetObject<Ipv6L3Protocol> ();
+  uint32_t interface = m_ipv6->AddInterface (device);
+  m_ipv6->AddAddress (interface, Ipv6InterfaceAddress (Ipv6Address ("2001::1"), Ipv6Prefix (64)));
+  m_ipv6->SetUp (interface);
+  m_ipv6->TraceConnectWithoutContext ("LocalDeliver", MakeCallback (&Ipv6ReassemblyTest::LocalDeliver, this));
+  m_ipv6->TraceConnectWithoutContext ("Drop", MakeCallback (&Ipv6ReassemblyTest::Drop, this));
+
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+
+  std::vector<Fragment> fragments;
+  for (uint32_t id = 0; id < 200; id++)
+    {
+      Datagram datagram;
+      datagram.data.resize (8 * random->GetInteger (2, 500) + random->GetInteger (0, 7));
+      for (uint32_t i = 0; i < datagram.data.size (); i++)
+        {
+          datagram.data[i] = random->GetInteger (0, 255);
+        }
+      datagram.complete = random->GetInteger (0, 3) != 0;
+      datagram.delivered = 0;
+      datagram.expired = 0;
+      uint32_t size = datagram.data.size ();
+
+      // cut the datagram in pieces of multiples of 8 bytes
+      std::vector<Fragment> pieces;
+      uint32_t offset = 0;
+      while (offset < size)
+        {
+          Fragment piece;
+          piece.id = id;
+          piece.offset = offset;
+          piece.size = std::min<uint32_t> (8 * random->GetInteger (1, 40), size - offset);
+          piece.last = offset + piece.size == size;
+          pieces.push_back (piece);
+          offset += piece.size;
+        }
+      if (pieces.size () < 2)
+        {
+          datagram.complete = true;
+        }
+      for (uint32_t i = 0; i < pieces.size (); i++)
+        {
+          uint32_t j = random->GetInteger (i, pieces.size () - 1);
+          std::swap (pieces[i], pieces[j]);
+        }
+      if (!datagram.complete)
+        {
+          if (random->GetInteger (0, 1) == 0)
+            {
+              pieces.erase (pieces.begin () + random->GetInteger (0, pieces.size () - 1));
+            }
+          else
+            {
+              // a duplicate of a piece, or a piece overlapping it. The
+              // last piece arrives after both, so that the datagram is
+              // never reassembled before they are received
+              for (uint32_t i = 0; i < pieces.size (); i++)
+                {
+                  if (pieces[i].last)
+                    {
+                      std::swap (pieces[i], pieces.back ());
+                    }
+                }
+              Fragment piece = pieces[random->GetInteger (0, pieces.size () - 2)];
+              if (random->GetInteger (0, 1) == 0)
+                {
+                  uint32_t end = piece.offset + piece.size - 1;
+                  piece.offset = 8 * random->GetInteger (piece.offset / 8, end / 8);
+                  piece.size = random->GetInteger (1, size - 1 - piece.offset);
+                }
+              pieces.insert (pieces.begin () + random->GetInteger (0, pieces.size () - 1), piece);
+            }
+        }
+
+      // random arrival times
+      std::vector<Time> times;
+      for (uint32_t i = 0; i < pieces.size (); i++)
+        {
+          times.push_back (MilliSeconds (random->GetInteger (0, 10000)));
+        }
+      std::sort (times.begin (), times.end ());
+      for (uint32_t i = 0; i < pieces.size (); i++)
+        {
+          pieces[i].time = times[i];
+          fragments.push_back (pieces[i]);
+        }
+      datagram.first = times.front ();
+      m_datagrams.push_back (datagram);
+    }
+
+  std::stable_sort (fragments.begin (), fragments.end (), &Ipv6ReassemblyTest::ArrivesBefore);
+  for (uint32_t i = 0; i < fragments.size (); i++)
+    {
+      Simulator::Schedule (fragments[i].time, &Ipv6ReassemblyTest::Deliver, this, fragments[i]);
+    }
+  Simulator::Run ();
+
+  for (uint32_t id = 0; id < m_datagrams.size (); id++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_datagrams[id].delivered, (m_datagrams[id].complete ? 1 : 0),
+                             "Bad number of deliveries of datagram " << id);
+      NS_TEST_EXPECT_MSG_EQ (m_datagrams[id].expired, (m_datagrams[id].complete ? 0 : 1),
+                             "Bad number of expirations of datagram " << id);
+    }
+
+  m_ipv6 = 0;
+  m_device = 0;
+  Simulator::Destroy ();
+}
+
 //-----------------------------------------------------------------------------
 class Ipv6FragmentationTestSuite : public TestSuite
 {
@@ -491,5 +759,6 @@ public:
   Ipv6FragmentationTestSuite () : TestSuite ("ipv6-fragmentation", UNIT)
   {
     AddTestCase (new Ipv6FragmentationTest, TestCase::QUICK);
+    AddTestCase (new Ipv6ReassemblyTest, TestCase::QUICK);
   }
 } g_ipv6fragmentationTestSuite;
@@ -0,0 +1,230 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-rx-buffer.h"
+#include "ns3/tcp-tx-buffer.h"
+#include <algorithm>
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * \param seq a sequence number
+ * \returns the byte carried at this sequence number in the tests
+ */
+uint8_t
+ByteAt (uint32_t seq)
+{
+  return (seq * 7 + (seq >> 8)) & 0xff;
+}
+
+/**
+ * \param seq the sequence number of the first byte
+ * \param size the size of the packet
+ * \returns a packet carrying the bytes of the tests
+ */
+Ptr<Packet>
+CreatePacket (uint32_t seq, uint32_t size)
+{
+  std::vector<uint8_t> data (size);
+  for (uint32_t i = 0; i < size; i++)
+    {
+      data[i] = ByteAt (seq + i);
+    }
+  return Create<Packet> (size > 0 ? &data[0] : 0, size);
+}
+
+/**
+ * \param p a packet
+ * \param seq the sequence number of its first byte
+ * \returns true if the packet carries the bytes of the tests
+ */
+bool
+CheckPacket (Ptr<Packet> p, uint32_t seq)
+{
+  std::vector<uint8_t> data (p->GetSize ());
+  if (data.empty ())
+    {
+      return true;
+    }
+  p->CopyData (&data[0], data.size ());
+  for (uint32_t i = 0; i < data.size (); i++)
+    {
+      if (data[i] != ByteAt (seq + i))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+} // anonymous namespace
+
+//-----------------------------------------------------------------------------
+// The receive buffer reassembles overlapping segments in any order
+//-----------------------------------------------------------------------------
+class TcpRxBufferTest : public TestCase
+{
+public:
+  TcpRxBufferTest ();
+  virtual void DoRun (void);
+};
+
+TcpRxBufferTest::TcpRxBufferTest ()
+  : TestCase ("Check the TCP receive buffer against a byte map")
+{
+}
+
+void
+TcpRxBufferTest::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+
+  const uint32_t start = 0xfffff000; // the sequence numbers wrap around
+  TcpRxBuffer buffer (start);
+  buffer.SetMaxBufferSize (1 << 20);
+  std::vector<bool> received;
+  uint32_t extracted = 0;
+  uint32_t next = 0;
+  for (uint32_t step = 0; step < 20000; step++)
+    {
+      if (random->GetInteger (0, 3) > 0)
+        {
+          // a segment around the first missing byte, within the window
+          uint32_t offset = random->GetInteger (0, 20000);
+          uint32_t first = next + offset > 2000 ? next + offset - 2000 : 0;
+          uint32_t size = random->GetInteger (1, 1500);
+          TcpHeader header;
+          header.SetSequenceNumber (SequenceNumber32 (start + first));
+          bool added = buffer.Add (CreatePacket (start + first, size), header);
+          bool fresh = false;
+          if (received.size () < first + size)
+            {
+              received.resize (first + size, false);
+            }
+          for (uint32_t i = first; i < first + size; i++)
+            {
+              fresh = fresh || (i >= extracted && !received[i]);
+              received[i] = received[i] || i >= extracted;
+            }
+          NS_TEST_ASSERT_MSG_EQ (added, fresh, "Bad result of Add at step " << step);
+          while (next < received.size () && received[next])
+            {
+              next++;
+            }
+        }
+      else
+        {
+          uint32_t maxSize = random->GetInteger (1, 10000);
+          Ptr<Packet> p = buffer.Extract (maxSize);
+          uint32_t expected = std::min (maxSize, next - extracted);
+          NS_TEST_ASSERT_MSG_EQ ((p == 0 ? 0 : p->GetSize ()), expected, "Bad extracted size at step " << step);
+          if (p != 0)
+            {
+              NS_TEST_ASSERT_MSG_EQ (CheckPacket (p, start + extracted), true, "Bad data extracted at step " << step);
+            }
+          extracted += expected;
+        }
+      uint32_t size = 0;
+      for (uint32_t i = extracted; i < received.size (); i++)
+        {
+          size += received[i];
+        }
+      NS_TEST_ASSERT_MSG_EQ (buffer.NextRxSequence (), SequenceNumber32 (start + next), "Bad next sequence");
+      NS_TEST_ASSERT_MSG_EQ (buffer.Available (), next - extracted, "Bad available size");
+      NS_TEST_ASSERT_MSG_EQ (buffer.Size (), size, "Bad buffer size");
+    }
+}
+
+//-----------------------------------------------------------------------------
+// The transmit buffer returns any range of the data not yet acknowledged
+//-----------------------------------------------------------------------------
+class TcpTxBufferTest : public TestCase
+{
+public:
+  TcpTxBufferTest ();
+  virtual void DoRun (void);
+};
+
+TcpTxBufferTest::TcpTxBufferTest ()
+  : TestCase ("Check the TCP transmit buffer against a byte range")
+{
+}
+
+void
+TcpTxBufferTest::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (2);
+
+  const uint32_t start = 0xfffff000; // the sequence numbers wrap around
+  TcpTxBuffer buffer (start);
+  buffer.SetMaxBufferSize (100000);
+  uint32_t head = 0; // the first byte not acknowledged
+  uint32_t tail = 0; // the first byte not written
+  for (uint32_t step = 0; step < 20000; step++)
+    {
+      uint32_t action = random->GetInteger (0, 2);
+      if (action == 0)
+        {
+          uint32_t size = random->GetInteger (0, 3000);
+          bool added = buffer.Add (CreatePacket (start + tail, size));
+          NS_TEST_ASSERT_MSG_EQ (added, (tail - head + size <= 100000), "Bad result of Add at step " << step);
+          tail += added ? size : 0;
+        }
+      else if (action == 1 && tail > head)
+        {
+          uint32_t seq = random->GetInteger (head, tail - 1);
+          uint32_t size = random->GetInteger (1, 5000);
+          NS_TEST_ASSERT_MSG_EQ (buffer.SizeFromSequence (SequenceNumber32 (start + seq)), tail - seq,
+                                 "Bad size from sequence at step " << step);
+          Ptr<Packet> p = buffer.CopyFromSequence (size, SequenceNumber32 (start + seq));
+          NS_TEST_ASSERT_MSG_EQ (p->GetSize (), std::min (size, tail - seq), "Bad copied size at step " << step);
+          NS_TEST_ASSERT_MSG_EQ (CheckPacket (p, start + seq), true, "Bad data copied at step " << step);
+        }
+      else if (action == 2)
+        {
+          head = random->GetInteger (head, tail);
+          buffer.DiscardUpTo (SequenceNumber32 (start + head));
+        }
+      NS_TEST_ASSERT_MSG_EQ (buffer.HeadSequence (), SequenceNumber32 (start + head), "Bad head sequence");
+      NS_TEST_ASSERT_MSG_EQ (buffer.TailSequence (), SequenceNumber32 (start + tail), "Bad tail sequence");
+      NS_TEST_ASSERT_MSG_EQ (buffer.Size (), tail - head, "Bad buffer size");
+    }
+}
+
+//-----------------------------------------------------------------------------
+class TcpBufferTestSuite : public TestSuite
+{
+public:
+  TcpBufferTestSuite ();
+};
+
+TcpBufferTestSuite::TcpBufferTestSuite ()
+  : TestSuite ("tcp-buffers", UNIT)
+{
+  AddTestCase (new TcpRxBufferTest, TestCase::QUICK);
+  AddTestCase (new TcpTxBufferTest, TestCase::QUICK);
+}
+
+static TcpBufferTestSuite g_tcpBufferTestSuite;
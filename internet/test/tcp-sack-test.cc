@@ -0,0 +1,433 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
+#include "ns3/packet.h"
+#include "ns3/error-model.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-interface-container.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/socket.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-option-sack.h"
+#include "ns3/tcp-option-sack-permitted.h"
+#include "ns3/tcp-rx-buffer.h"
+#include "ns3/tcp-tx-buffer.h"
+#include <set>
+
+using namespace ns3;
+
+namespace {
+
+/**
+ * \brief An error model which drops the packets received at given ranks
+ */
+class IndexErrorModel : public ErrorModel
+{
+public:
+  /**
+   * \param drops the ranks of the packets to drop, starting from 0
+   */
+  IndexErrorModel (const std::set<uint32_t> &drops)
+    : m_drops (drops),
+      m_count (0)
+  {
+  }
+
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p)
+  {
+    return m_drops.count (m_count++) > 0;
+  }
+  virtual void DoReset (void)
+  {
+    m_count = 0;
+  }
+
+  std::set<uint32_t> m_drops; //!< the ranks of the packets to drop
+  uint32_t m_count; //!< number of packets seen
+};
+
+/**
+ * \param head the first sequence number
+ * \param tail the sequence number after the last one
+ * \returns the block
+ */
+TcpOptionSack::SackBlock
+Block (uint32_t head, uint32_t tail)
+{
+  return TcpOptionSack::SackBlock (SequenceNumber32 (head), SequenceNumber32 (tail));
+}
+
+} // anonymous namespace
+
+//-----------------------------------------------------------------------------
+// The options go through a TCP header unchanged
+//-----------------------------------------------------------------------------
+class TcpSackOptionTest : public TestCase
+{
+public:
+  TcpSackOptionTest ();
+  virtual void DoRun (void);
+};
+
+TcpSackOptionTest::TcpSackOptionTest ()
+  : TestCase ("Check the serialization of the SACK options")
+{
+}
+
+void
+TcpSackOptionTest::DoRun (void)
+{
+  TcpHeader syn;
+  syn.SetFlags (TcpHeader::SYN);
+  syn.AppendOption (CreateObject<TcpOptionSackPermitted> ());
+  Ptr<Packet> p = Create<Packet> ();
+  p->AddHeader (syn);
+  TcpHeader synCopy;
+  p->RemoveHeader (synCopy);
+  NS_TEST_EXPECT_MSG_EQ (synCopy.HasOption (TcpOption::SACKPERMITTED), true, "SACK permitted option lost");
+
+  for (uint32_t n = 1; n <= 4; n++)
+    {
+      Ptr<TcpOptionSack> option = CreateObject<TcpOptionSack> ();
+      for (uint32_t i = 0; i < n; i++)
+        {
+          option->AddSackBlock (Block (0xffffff00 + 1000 * i, 0xffffff00 + 1000 * i + 500));
+        }
+      NS_TEST_EXPECT_MSG_EQ (option->GetSerializedSize (), 2 + 8 * n, "Bad size of the option");
+      TcpHeader ack;
+      ack.SetFlags (TcpHeader::ACK);
+      ack.AppendOption (option);
+      p = Create<Packet> ();
+      p->AddHeader (ack);
+      TcpHeader ackCopy;
+      p->RemoveHeader (ackCopy);
+      NS_TEST_ASSERT_MSG_EQ (ackCopy.HasOption (TcpOption::SACK), true, "SACK option lost");
+      Ptr<const TcpOptionSack> copy = DynamicCast<const TcpOptionSack> (ackCopy.GetOption (TcpOption::SACK));
+      NS_TEST_EXPECT_MSG_EQ ((copy->GetSackList () == option->GetSackList ()), true,
+                             "Bad blocks with " << n << " blocks");
+    }
+}
+
+//-----------------------------------------------------------------------------
+// The receiver reports its out of order blocks, the most recent first
+//-----------------------------------------------------------------------------
+class TcpSackRxBlocksTest : public TestCase
+{
+public:
+  TcpSackRxBlocksTest ();
+  virtual void DoRun (void);
+private:
+  /**
+   * \brief Add a segment to the buffer
+   * \param buffer the buffer
+   * \param head the first sequence number of the segment
+   * \param tail the sequence number after its last one
+   */
+  void Add (TcpRxBuffer &buffer, uint32_t head, uint32_t tail);
+};
+
+TcpSackRxBlocksTest::TcpSackRxBlocksTest ()
+  : TestCase ("Check the SACK blocks of the TCP receive buffer")
+{
+}
+
+void
+TcpSackRxBlocksTest::Add (TcpRxBuffer &buffer, uint32_t head, uint32_t tail)
+{
+  TcpHeader header;
+  header.SetSequenceNumber (SequenceNumber32 (head));
+  buffer.Add (Create<Packet> (tail - head), header);
+}
+
+void
+TcpSackRxBlocksTest::DoRun (void)
+{
+  TcpRxBuffer buffer (0);
+  buffer.SetMaxBufferSize (100000);
+  TcpOptionSack::SackList expected;
+
+  Add (buffer, 1000, 2000);
+  Add (buffer, 3000, 4000);
+  expected.push_back (Block (3000, 4000));
+  expected.push_back (Block (1000, 2000));
+  NS_TEST_EXPECT_MSG_EQ ((buffer.GetSackList () == expected), true, "Blocks not in the order of arrival");
+
+  // filling the hole between them merges the blocks
+  Add (buffer, 2000, 3000);
+  expected.clear ();
+  expected.push_back (Block (1000, 4000));
+  NS_TEST_EXPECT_MSG_EQ ((buffer.GetSackList () == expected), true, "Blocks not merged");
+
+  // an old block comes first again when it grows
+  Add (buffer, 5000, 6000);
+  Add (buffer, 4500, 4600);
+  expected.clear ();
+  expected.push_back (Block (4500, 4600));
+  expected.push_back (Block (5000, 6000));
+  expected.push_back (Block (1000, 4000));
+  NS_TEST_EXPECT_MSG_EQ ((buffer.GetSackList () == expected), true, "Bad blocks after a new one");
+  Add (buffer, 3500, 4200);
+  expected.clear ();
+  expected.push_back (Block (1000, 4200));
+  expected.push_back (Block (4500, 4600));
+  expected.push_back (Block (5000, 6000));
+  NS_TEST_EXPECT_MSG_EQ ((buffer.GetSackList () == expected), true, "Grown block not first");
+
+  // the data received in order removes the blocks it reaches
+  Add (buffer, 0, 1000);
+  expected.clear ();
+  expected.push_back (Block (4500, 4600));
+  expected.push_back (Block (5000, 6000));
+  NS_TEST_EXPECT_MSG_EQ (buffer.NextRxSequence (), SequenceNumber32 (4200), "Bad next sequence");
+  NS_TEST_EXPECT_MSG_EQ ((buffer.GetSackList () == expected), true, "Acknowledged blocks kept");
+
+  // only the four most recent blocks are kept
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      Add (buffer, 10000 + 1000 * i, 10500 + 1000 * i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (buffer.GetSackList ().size (), 4, "Bad number of blocks");
+  NS_TEST_EXPECT_MSG_EQ ((buffer.GetSackList ().front () == Block (15000, 15500)), true, "Bad first block");
+}
+
+//-----------------------------------------------------------------------------
+// The scoreboard of the sender follows RFC 6675
+//-----------------------------------------------------------------------------
+class TcpSackScoreboardTest : public TestCase
+{
+public:
+  TcpSackScoreboardTest ();
+  virtual void DoRun (void);
+};
+
+TcpSackScoreboardTest::TcpSackScoreboardTest ()
+  : TestCase ("Check the SACK scoreboard of the TCP transmit buffer")
+{
+}
+
+void
+TcpSackScoreboardTest::DoRun (void)
+{
+  const uint32_t seg = 1000;
+  const uint32_t dupThresh = 3;
+  TcpTxBuffer buffer (0);
+  buffer.SetMaxBufferSize (100000);
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      buffer.Add (Create<Packet> (seg));
+    }
+
+  TcpOptionSack::SackList list;
+  list.push_back (Block (4000, 9000));
+  list.push_back (Block (2000, 3000));
+  list.push_back (Block (20000, 30000)); // beyond the data sent
+  NS_TEST_EXPECT_MSG_EQ (buffer.UpdateScoreboard (list), true, "New blocks not reported");
+  NS_TEST_EXPECT_MSG_EQ (buffer.UpdateScoreboard (list), false, "Old blocks reported");
+  NS_TEST_EXPECT_MSG_EQ (buffer.GetSacked (), 6000, "Bad number of bytes acknowledged");
+  NS_TEST_EXPECT_MSG_EQ (buffer.IsSacked (SequenceNumber32 (2500)), true, "Byte not acknowledged");
+  NS_TEST_EXPECT_MSG_EQ (buffer.IsSacked (SequenceNumber32 (3500)), false, "Byte acknowledged");
+
+  // more than (dupThresh - 1) segments are acknowledged above 3000
+  NS_TEST_EXPECT_MSG_EQ (buffer.IsLost (SequenceNumber32 (0), dupThresh, seg), true, "First byte not lost");
+  NS_TEST_EXPECT_MSG_EQ (buffer.IsLost (SequenceNumber32 (3000), dupThresh, seg), true, "Hole not lost");
+  NS_TEST_EXPECT_MSG_EQ (buffer.IsLost (SequenceNumber32 (9000), dupThresh, seg), false, "Last byte lost");
+
+  // only the last segment is in flight, and the first one once retransmitted
+  SequenceNumber32 highData (10000);
+  NS_TEST_EXPECT_MSG_EQ (buffer.BytesInFlight (highData, SequenceNumber32 (0), dupThresh, seg), 1000,
+                         "Bad pipe");
+  NS_TEST_EXPECT_MSG_EQ (buffer.BytesInFlight (highData, SequenceNumber32 (1000), dupThresh, seg), 2000,
+                         "Bad pipe after a retransmission");
+
+  // the lost segments are retransmitted in order, skipping the acknowledged ones
+  SequenceNumber32 seq;
+  uint32_t length;
+  NS_TEST_ASSERT_MSG_EQ (buffer.NextSeg (SequenceNumber32 (0), true, dupThresh, seg, seq, length), true,
+                         "No segment to retransmit");
+  NS_TEST_EXPECT_MSG_EQ (seq, SequenceNumber32 (0), "Bad segment");
+  NS_TEST_EXPECT_MSG_EQ (length, seg, "Bad segment length");
+  NS_TEST_ASSERT_MSG_EQ (buffer.NextSeg (SequenceNumber32 (2000), true, dupThresh, seg, seq, length), true,
+                         "No segment to retransmit");
+  NS_TEST_EXPECT_MSG_EQ (seq, SequenceNumber32 (3000), "Acknowledged segment retransmitted");
+  NS_TEST_EXPECT_MSG_EQ (buffer.NextSeg (SequenceNumber32 (4000), true, dupThresh, seg, seq, length), false,
+                         "Segment above the acknowledged data retransmitted");
+
+  // the cumulative acknowledgment removes the blocks below it
+  buffer.DiscardUpTo (SequenceNumber32 (2500));
+  NS_TEST_EXPECT_MSG_EQ (buffer.GetSacked (), 5500, "Bad number of bytes after a partial ACK");
+  buffer.ResetScoreboard ();
+  NS_TEST_EXPECT_MSG_EQ (buffer.GetSacked (), 0, "Scoreboard not reset");
+  NS_TEST_EXPECT_MSG_EQ (buffer.NextSeg (SequenceNumber32 (0), true, dupThresh, seg, seq, length), false,
+                         "Segment to retransmit without a scoreboard");
+}
+
+//-----------------------------------------------------------------------------
+// Several losses in a window are recovered in a single round trip
+//-----------------------------------------------------------------------------
+class TcpSackTransferTest : public TestCase
+{
+public:
+  TcpSackTransferTest ();
+  virtual void DoRun (void);
+private:
+  /**
+   * \brief Transfer data over a link which loses several segments of a window
+   * \param sack whether the selective acknowledgments are enabled
+   * \returns the time at which the data of the window was received
+   */
+  Time Transfer (bool sack);
+  /// Fill the transmit buffer of the sender
+  void SendData (Ptr<Socket> socket, uint32_t available);
+  /// Accept the connection of the sender
+  void Accept (Ptr<Socket> socket, const Address &from);
+  /// Read the data received
+  void ReceiveData (Ptr<Socket> socket);
+
+  uint32_t m_sent; //!< number of bytes sent
+  uint32_t m_received; //!< number of bytes received
+  Time m_recovered; //!< time at which the data of the window was received
+};
+
+/// Size of the transfer (bytes)
+static const uint32_t TRANSFER_SIZE = 200000;
+/// Data sent up to the window of the losses (bytes)
+static const uint32_t RECOVERED_SIZE = 30000;
+
+TcpSackTransferTest::TcpSackTransferTest ()
+  : TestCase ("Check a transfer with several losses in a window")
+{
+}
+
+void
+TcpSackTransferTest::SendData (Ptr<Socket> socket, uint32_t available)
+{
+  while (m_sent < TRANSFER_SIZE && socket->GetTxAvailable () > 0)
+    {
+      uint32_t size = std::min (socket->GetTxAvailable (), std::min (TRANSFER_SIZE - m_sent, 1000u));
+      int sent = socket->Send (Create<Packet> (size));
+      if (sent <= 0)
+        {
+          break;
+        }
+      m_sent += sent;
+    }
+}
+
+void
+TcpSackTransferTest::Accept (Ptr<Socket> socket, const Address &from)
+{
+  socket->SetRecvCallback (MakeCallback (&TcpSackTransferTest::ReceiveData, this));
+}
+
+void
+TcpSackTransferTest::ReceiveData (Ptr<Socket> socket)
+{
+  Ptr<Packet> p;
+  while ((p = socket->Recv ()) != 0)
+    {
+      m_received += p->GetSize ();
+    }
+  if (m_received >= RECOVERED_SIZE && m_recovered.IsZero ())
+    {
+      m_recovered = Simulator::Now ();
+    }
+}
+
+Time
+TcpSackTransferTest::Transfer (bool sack)
+{
+  m_sent = 0;
+  m_received = 0;
+  m_recovered = Seconds (0);
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  SimpleNetDeviceHelper link;
+  link.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  link.SetChannelAttribute ("Delay", StringValue ("20ms"));
+  NetDeviceContainer devices = link.Install (nodes);
+  Ipv4AddressHelper addresses;
+  addresses.SetBase ("10.0.0.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = addresses.Assign (devices);
+
+  // four segments of the same window are lost on their way to the receiver
+  std::set<uint32_t> drops;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      drops.insert (40 + 3 * i);
+    }
+  devices.Get (1)->SetAttribute ("ReceiveErrorModel", PointerValue (Create<IndexErrorModel> (drops)));
+
+  Ptr<Socket> server = Socket::CreateSocket (nodes.Get (1), TcpSocketFactory::GetTypeId ());
+  server->SetAttribute ("Sack", BooleanValue (sack));
+  server->Bind (InetSocketAddress (Ipv4Address::GetAny (), 9));
+  server->Listen ();
+  server->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                             MakeCallback (&TcpSackTransferTest::Accept, this));
+
+  Ptr<Socket> source = Socket::CreateSocket (nodes.Get (0), TcpSocketFactory::GetTypeId ());
+  source->SetAttribute ("Sack", BooleanValue (sack));
+  source->Bind ();
+  source->SetSendCallback (MakeCallback (&TcpSackTransferTest::SendData, this));
+  source->Connect (InetSocketAddress (interfaces.GetAddress (1), 9));
+
+  Simulator::Stop (Seconds (60));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_received, TRANSFER_SIZE, "Transfer not complete with sack=" << sack);
+  return m_recovered;
+}
+
+void
+TcpSackTransferTest::DoRun (void)
+{
+  Time withoutSack = Transfer (false);
+  Time withSack = Transfer (true);
+  // NewReno retransmits one lost segment per round trip of 40 ms, and SACK
+  // all four in the first one
+  NS_TEST_EXPECT_MSG_LT (withSack + MilliSeconds (2 * 40), withoutSack, "SACK recovery not faster");
+}
+
+//-----------------------------------------------------------------------------
+class TcpSackTestSuite : public TestSuite
+{
+public:
+  TcpSackTestSuite ();
+};
+
+TcpSackTestSuite::TcpSackTestSuite ()
+  : TestSuite ("tcp-sack", UNIT)
+{
+  AddTestCase (new TcpSackOptionTest, TestCase::QUICK);
+  AddTestCase (new TcpSackRxBlocksTest, TestCase::QUICK);
+  AddTestCase (new TcpSackScoreboardTest, TestCase::QUICK);
+  AddTestCase (new TcpSackTransferTest, TestCase::QUICK);
+}
+
+static TcpSackTestSuite g_tcpSackTestSuite;
@@ -70,6 +70,12 @@ public:
    * \param vel Velocity vector
    */
   void SetVelocity (const Vector &vel);
+  /**
+   * Set new velocity vector, as if it was done at the given time
+   * \param vel Velocity vector
+   * \param now time at which the velocity changes; not before the last update
+   */
+  void SetVelocity (const Vector &vel, Time now);
   /**
    * Pause mobility at current position
    */
@@ -89,10 +95,28 @@ public:
    * \param bounds 3D bounding box for resulting position; object will not move outside the box 
    */
   void UpdateWithBounds (const Box &bounds) const;
+  /**
+   * Update position up to the given time, within a rectangle
+   * \param rectangle 2D bounding rectangle for resulting position
+   * \param now time of the update; not before the last update
+   */
+  void UpdateWithBounds (const Rectangle &rectangle, Time now) const;
+  /**
+   * Update position up to the given time, within a box
+   * \param bounds 3D bounding box for resulting position
+   * \param now time of the update; not before the last update
+   */
+  void UpdateWithBounds (const Box &bounds, Time now) const;
   /**
    * Update position, if not paused, from last position and time of last update
    */
   void Update (void) const;
+  /**
+   * Update position, if not paused, up to the given time.  This lets
+   * models which are evaluated lazily replay past course changes.
+   * \param now time of the update; not before the last update
+   */
+  void Update (Time now) const;
 private:
   mutable Time m_lastUpdate; //!< time of last update
   mutable Vector m_position; //!< state variable for current position
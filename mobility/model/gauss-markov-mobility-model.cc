@@ -20,6 +20,7 @@
 #include <cmath>
 #include "ns3/simulator.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
 #include "ns3/pointer.h"
 #include "ns3/string.h"
 #include "gauss-markov-mobility-model.h"
@@ -80,7 +81,14 @@ GaussMarkovMobilityModel::GetTypeId (void)
                    "A gaussian random variable used to calculate the next pitch value.",
                    StringValue ("ns3::NormalRandomVariable[Mean=0.0|Variance=1.0|Bound=10.0]"),
                    MakePointerAccessor (&GaussMarkovMobilityModel::m_normalPitch),
-                   MakePointerChecker<NormalRandomVariable> ());
+                   MakePointerChecker<NormalRandomVariable> ())
+    .AddAttribute ("Lazy",
+                   "If true, no event is scheduled for each TimeStep: the steps are "
+                   "replayed, with the same random draws, when the position or "
+                   "velocity is queried.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&GaussMarkovMobilityModel::m_lazy),
+                   MakeBooleanChecker ());
 
   return tid;
 }
@@ -90,12 +98,20 @@ GaussMarkovMobilityModel::GaussMarkovMobilityModel ()
   m_meanVelocity = 0.0;
   m_meanDirection = 0.0;
   m_meanPitch = 0.0;
+  m_lazy = false;
+  m_stepPending = false;
   m_event = Simulator::ScheduleNow (&GaussMarkovMobilityModel::Start, this);
   m_helper.Unpause ();
 }
 
 void
 GaussMarkovMobilityModel::Start (void)
+{
+  Step (Simulator::Now ());
+}
+
+void
+GaussMarkovMobilityModel::Step (Time now)
 {
   if (m_meanVelocity == 0.0)
     {
@@ -112,9 +128,9 @@ GaussMarkovMobilityModel::Start (void)
       m_Direction = m_meanDirection;
       m_Pitch = m_meanPitch;
       //Set the velocity vector to give to the constant velocity helper
-      m_helper.SetVelocity (Vector (m_Velocity*cosD*cosP, m_Velocity*sinD*cosP, m_Velocity*sinP));
+      m_helper.SetVelocity (Vector (m_Velocity*cosD*cosP, m_Velocity*sinD*cosP, m_Velocity*sinP), now);
     }
-  m_helper.Update ();
+  m_helper.Update (now);
 
   //Get the next values from the gaussian distributions for velocity, direction, and pitch
   double rv = m_normalVelocity->GetValue ();
@@ -138,17 +154,17 @@ GaussMarkovMobilityModel::Start (void)
   double vx = m_Velocity * cosDir * cosPit;
   double vy = m_Velocity * sinDir * cosPit;
   double vz = m_Velocity * sinPit;
-  m_helper.SetVelocity (Vector (vx, vy, vz));
+  m_helper.SetVelocity (Vector (vx, vy, vz), now);
 
   m_helper.Unpause ();
 
-  DoWalk (m_timeStep);
+  DoWalk (m_timeStep, now);
 }
 
 void
-GaussMarkovMobilityModel::DoWalk (Time delayLeft)
+GaussMarkovMobilityModel::DoWalk (Time delayLeft, Time now)
 {
-  m_helper.UpdateWithBounds (m_bounds);
+  m_helper.UpdateWithBounds (m_bounds, now);
   Vector position = m_helper.GetCurrentPosition ();
   Vector speed = m_helper.GetVelocity ();
   Vector nextPosition = position;
@@ -161,7 +177,7 @@ GaussMarkovMobilityModel::DoWalk (Time delayLeft)
   // If out of bounds, then alter the velocity vector and average direction to keep the position in bounds
   if (m_bounds.IsInside (nextPosition))
     {
-      m_event = Simulator::Schedule (delayLeft, &GaussMarkovMobilityModel::Start, this);
+      ScheduleStep (delayLeft, now);
     }
   else
     {
@@ -185,13 +201,38 @@ GaussMarkovMobilityModel::DoWalk (Time delayLeft)
 
       m_Direction = m_meanDirection;
       m_Pitch = m_meanPitch;
-      m_helper.SetVelocity (speed);
+      m_helper.SetVelocity (speed, now);
       m_helper.Unpause ();
-      m_event = Simulator::Schedule (delayLeft, &GaussMarkovMobilityModel::Start, this);
+      ScheduleStep (delayLeft, now);
     }
   NotifyCourseChange ();
 }
 
+void
+GaussMarkovMobilityModel::ScheduleStep (Time delay, Time now)
+{
+  if (m_lazy)
+    {
+      m_stepPending = true;
+      m_nextStep = now + delay;
+    }
+  else
+    {
+      m_event = Simulator::Schedule (delay, &GaussMarkovMobilityModel::Start, this);
+    }
+}
+
+void
+GaussMarkovMobilityModel::Advance (void)
+{
+  Time now = Simulator::Now ();
+  while (m_stepPending && m_nextStep <= now)
+    {
+      m_stepPending = false;
+      Step (m_nextStep);
+    }
+}
+
 void
 GaussMarkovMobilityModel::DoDispose (void)
 {
@@ -202,19 +243,23 @@ GaussMarkovMobilityModel::DoDispose (void)
 Vector
 GaussMarkovMobilityModel::DoGetPosition (void) const
 {
+  const_cast<GaussMarkovMobilityModel *> (this)->Advance ();
   m_helper.Update ();
   return m_helper.GetCurrentPosition ();
 }
 void 
 GaussMarkovMobilityModel::DoSetPosition (const Vector &position)
 {
+  Advance ();
   m_helper.SetPosition (position);
   Simulator::Remove (m_event);
-  m_event = Simulator::ScheduleNow (&GaussMarkovMobilityModel::Start, this);
+  m_stepPending = false;
+  ScheduleStep (Seconds (0), Simulator::Now ());
 }
 Vector
 GaussMarkovMobilityModel::DoGetVelocity (void) const
 {
+  const_cast<GaussMarkovMobilityModel *> (this)->Advance ();
   return m_helper.GetVelocity ();
 }
 
@@ -73,6 +73,14 @@ namespace ns3 {
  
     mobility.Install (wifiStaNodes);
  * \endcode
+ *
+ * When the Lazy attribute is set, no event is scheduled for each TimeStep:
+ * the steps are replayed up to the current time, in order and with the
+ * same random draws, whenever the position or the velocity is queried.
+ * The trajectory is the same as in the default mode, but the CourseChange
+ * trace fires when the model is queried rather than at each step, and a
+ * query made at the exact time of a step already sees the new velocity.
+ *
  * [1] Tracy Camp, Jeff Boleng, Vanessa Davies, "A Survey of Mobility Models
  * for Ad Hoc Network Research", Wireless Communications and Mobile Computing,
  * Wiley, vol.2 iss.5, September 2002, pp.483-502
@@ -91,11 +99,28 @@ private:
    * Initialize the model and calculate new velocity, direction, and pitch
    */
   void Start (void);
+  /**
+   * Calculate new velocity, direction, and pitch at the given time
+   * \param now the time of the step
+   */
+  void Step (Time now);
   /**
    * Perform a walk operation
    * \param timeLeft time until Start method is called again
+   * \param now the current time of the walk
+   */
+  void DoWalk (Time timeLeft, Time now);
+  /**
+   * Arrange for the next step to happen after the given delay, either
+   * by scheduling an event or, for a lazy model, by recording it
+   * \param delay the delay until the next step
+   * \param now the current time of the walk
+   */
+  void ScheduleStep (Time delay, Time now);
+  /**
+   * Perform the steps of a lazy model up to now
    */
-  void DoWalk (Time timeLeft);
+  void Advance (void);
   virtual void DoDispose (void);
   virtual Vector DoGetPosition (void) const;
   virtual void DoSetPosition (const Vector &position);
@@ -118,6 +143,9 @@ private:
   Ptr<NormalRandomVariable> m_normalPitch; //!< Gaussian rv for next pitch
   EventId m_event; //!< event id of scheduled start
   Box m_bounds; //!< bounding box
+  bool m_lazy; //!< replay steps on demand instead of scheduling them
+  bool m_stepPending; //!< true if a lazy model has a step at m_nextStep
+  Time m_nextStep; //!< time of the next step of a lazy model
 };
 
 } // namespace ns3
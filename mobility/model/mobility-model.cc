@@ -53,7 +53,10 @@ MobilityModel::GetTypeId (void)
 }
 
 MobilityModel::MobilityModel ()
+  : m_positionEpoch (0)
 {
+  static uint32_t nextId = 0;
+  m_id = nextId++;
 }
 
 MobilityModel::~MobilityModel ()
@@ -94,9 +97,22 @@ MobilityModel::GetRelativeSpeed (Ptr<const MobilityModel> other) const
   return sqrt( (x*x) + (y*y) + (z*z) );
 }
 
+uint32_t
+MobilityModel::GetId (void) const
+{
+  return m_id;
+}
+
+uint32_t
+MobilityModel::GetPositionEpoch (void) const
+{
+  return m_positionEpoch;
+}
+
 void
 MobilityModel::NotifyCourseChange (void) const
 {
+  m_positionEpoch++;
   m_courseChangeTrace (this);
 }
 
@@ -78,6 +78,21 @@ public:
    * \return the number of stream indices assigned by this model
    */
   int64_t AssignStreams (int64_t stream);
+  /**
+   * \return a small integer which uniquely identifies this mobility
+   *         model instance within the simulation.
+   */
+  uint32_t GetId (void) const;
+  /**
+   * \return the number of course changes notified so far by this model.
+   *
+   * The counter is incremented by NotifyCourseChange, so that two equal
+   * values guarantee that neither the position, nor the velocity, has
+   * been changed in-between other than by the current velocity vector.
+   * Clients such as propagation loss caches use it to decide whether a
+   * value computed from the position of this model is still valid.
+   */
+  uint32_t GetPositionEpoch (void) const;
 
   /**
    *  TracedCallback signature.
@@ -129,6 +144,8 @@ private:
    */
   ns3::TracedCallback<Ptr<const MobilityModel> > m_courseChangeTrace;
 
+  uint32_t m_id; //!< unique identifier of this model
+  mutable uint32_t m_positionEpoch; //!< number of course changes so far
 };
 
 } // namespace ns3
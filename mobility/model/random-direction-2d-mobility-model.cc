@@ -22,6 +22,7 @@
 #include <cmath>
 #include "ns3/log.h"
 #include "ns3/string.h"
+#include "ns3/boolean.h"
 #include "ns3/pointer.h"
 #include "random-direction-2d-mobility-model.h"
 
@@ -51,11 +52,20 @@ RandomDirection2dMobilityModel::GetTypeId (void)
                    StringValue ("ns3::ConstantRandomVariable[Constant=2.0]"),
                    MakePointerAccessor (&RandomDirection2dMobilityModel::m_pause),
                    MakePointerChecker<RandomVariableStream> ())
+    .AddAttribute ("Lazy",
+                   "If true, no event is scheduled for the pauses and changes of "
+                   "direction: they are replayed, with the same random draws, when "
+                   "the position or velocity is queried.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RandomDirection2dMobilityModel::m_lazy),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
 
 RandomDirection2dMobilityModel::RandomDirection2dMobilityModel ()
+  : m_lazy (false),
+    m_nextStep (STEP_NONE)
 {
   m_direction = CreateObject <UniformRandomVariable> ();
 }
@@ -75,47 +85,71 @@ RandomDirection2dMobilityModel::DoInitialize (void)
 
 void
 RandomDirection2dMobilityModel::DoInitializePrivate (void)
+{
+  ChooseDirection (Simulator::Now ());
+}
+
+void
+RandomDirection2dMobilityModel::ChooseDirection (Time now)
 {
   double direction = m_direction->GetValue (0, 2 * M_PI);
-  SetDirectionAndSpeed (direction);
+  SetDirectionAndSpeed (direction, now);
 }
 
 void
-RandomDirection2dMobilityModel::BeginPause (void)
+RandomDirection2dMobilityModel::BeginPause (Time now)
 {
-  m_helper.Update ();
+  m_helper.Update (now);
   m_helper.Pause ();
   Time pause = Seconds (m_pause->GetValue ());
   m_event.Cancel ();
-  m_event = Simulator::Schedule (pause, &RandomDirection2dMobilityModel::ResetDirectionAndSpeed, this);
+  if (m_lazy)
+    {
+      m_nextStep = STEP_RESET;
+      m_nextTime = now + pause;
+    }
+  else
+    {
+      m_event = Simulator::Schedule (pause, &RandomDirection2dMobilityModel::ResetDirectionAndSpeed, this,
+                                     now + pause);
+    }
   NotifyCourseChange ();
 }
 
 void
-RandomDirection2dMobilityModel::SetDirectionAndSpeed (double direction)
+RandomDirection2dMobilityModel::SetDirectionAndSpeed (double direction, Time now)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  m_helper.UpdateWithBounds (m_bounds);
+  m_helper.UpdateWithBounds (m_bounds, now);
   Vector position = m_helper.GetCurrentPosition ();
   double speed = m_speed->GetValue ();
   const Vector vector (std::cos (direction) * speed,
                        std::sin (direction) * speed,
                        0.0);
-  m_helper.SetVelocity (vector);
+  m_helper.SetVelocity (vector, now);
   m_helper.Unpause ();
   Vector next = m_bounds.CalculateIntersection (position, vector);
   Time delay = Seconds (CalculateDistance (position, next) / speed);
   m_event.Cancel ();
-  m_event = Simulator::Schedule (delay,
-                                 &RandomDirection2dMobilityModel::BeginPause, this);
+  if (m_lazy)
+    {
+      m_nextStep = STEP_PAUSE;
+      m_nextTime = now + delay;
+    }
+  else
+    {
+      m_event = Simulator::Schedule (delay,
+                                     &RandomDirection2dMobilityModel::BeginPause, this,
+                                     now + delay);
+    }
   NotifyCourseChange ();
 }
 void
-RandomDirection2dMobilityModel::ResetDirectionAndSpeed (void)
+RandomDirection2dMobilityModel::ResetDirectionAndSpeed (Time now)
 {
   double direction = m_direction->GetValue (0, M_PI);
 
-  m_helper.UpdateWithBounds (m_bounds);
+  m_helper.UpdateWithBounds (m_bounds, now);
   Vector position = m_helper.GetCurrentPosition ();
   switch (m_bounds.GetClosestSide (position))
     {
@@ -132,25 +166,58 @@ RandomDirection2dMobilityModel::ResetDirectionAndSpeed (void)
       direction += 0.0;
       break;
     }
-  SetDirectionAndSpeed (direction);
+  SetDirectionAndSpeed (direction, now);
+}
+void
+RandomDirection2dMobilityModel::Advance (void)
+{
+  Time now = Simulator::Now ();
+  while (m_nextStep != STEP_NONE && m_nextTime <= now)
+    {
+      enum Step step = m_nextStep;
+      m_nextStep = STEP_NONE;
+      switch (step)
+        {
+        case STEP_PAUSE:
+          BeginPause (m_nextTime);
+          break;
+        case STEP_RESET:
+          ResetDirectionAndSpeed (m_nextTime);
+          break;
+        default:
+          ChooseDirection (m_nextTime);
+          break;
+        }
+    }
 }
 Vector
 RandomDirection2dMobilityModel::DoGetPosition (void) const
 {
+  const_cast<RandomDirection2dMobilityModel *> (this)->Advance ();
   m_helper.UpdateWithBounds (m_bounds);
   return m_helper.GetCurrentPosition ();
 }
 void
 RandomDirection2dMobilityModel::DoSetPosition (const Vector &position)
 {
+  Advance ();
   m_helper.SetPosition (position);
   Simulator::Remove (m_event);
   m_event.Cancel ();
-  m_event = Simulator::ScheduleNow (&RandomDirection2dMobilityModel::DoInitializePrivate, this);
+  if (m_lazy)
+    {
+      m_nextStep = STEP_CHOOSE;
+      m_nextTime = Simulator::Now ();
+    }
+  else
+    {
+      m_event = Simulator::ScheduleNow (&RandomDirection2dMobilityModel::DoInitializePrivate, this);
+    }
 }
 Vector
 RandomDirection2dMobilityModel::DoGetVelocity (void) const
 {
+  const_cast<RandomDirection2dMobilityModel *> (this)->Advance ();
   return m_helper.GetVelocity ();
 }
 int64_t
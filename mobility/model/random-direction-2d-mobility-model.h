@@ -40,6 +40,13 @@ namespace ns3 {
  * then travels in the specific direction until it reaches one of
  * the boundaries of the model. When it reaches the boundary, it pauses,
  * selects a new direction and speed, aso.
+ *
+ * When the Lazy attribute is set, the pauses and changes of direction
+ * are not scheduled: they are replayed up to the current time, in order
+ * and with the same random draws, whenever the position or the velocity
+ * is queried.  The trajectory is the same as in the default mode, but the
+ * CourseChange trace fires when the model is queried rather than at the
+ * time of each change.
  */
 class RandomDirection2dMobilityModel : public MobilityModel
 {
@@ -52,21 +59,41 @@ public:
   RandomDirection2dMobilityModel ();
 
 private:
+  /** The next change of course of a lazy model. */
+  enum Step {
+    STEP_NONE,
+    STEP_PAUSE,
+    STEP_RESET,
+    STEP_CHOOSE
+  };
+
   /**
    * Set a new direction and speed
+   * \param now the time of the change
    */
-  void ResetDirectionAndSpeed (void);
+  void ResetDirectionAndSpeed (Time now);
   /**
    * Pause, cancel currently scheduled event, schedule end of pause event
+   * \param now the time of the pause
    */
-  void BeginPause (void);
+  void BeginPause (Time now);
   /**
    * Set new velocity and direction, and schedule next pause event  
    * \param direction (radians)
+   * \param now the time of the change
    */
-  void SetDirectionAndSpeed (double direction);
+  void SetDirectionAndSpeed (double direction, Time now);
   /**
    * Sets a new random direction and calls SetDirectionAndSpeed
+   * \param now the time of the change
+   */
+  void ChooseDirection (Time now);
+  /**
+   * Perform the changes of course of a lazy model up to now
+   */
+  void Advance (void);
+  /**
+   * Sets a new random direction now
    */
   void DoInitializePrivate (void);
   virtual void DoDispose (void);
@@ -82,6 +109,9 @@ private:
   Ptr<RandomVariableStream> m_pause; //!< a random variable to control pause 
   EventId m_event; //!< event ID of next scheduled event
   ConstantVelocityHelper m_helper; //!< helper for velocity computations
+  bool m_lazy; //!< replay changes of course on demand instead of scheduling them
+  enum Step m_nextStep; //!< next change of course of a lazy model
+  Time m_nextTime; //!< time of the next change of course of a lazy model
 };
 
 } // namespace ns3
@@ -19,6 +19,7 @@
  */
 #include "random-walk-2d-mobility-model.h"
 #include "ns3/enum.h"
+#include "ns3/boolean.h"
 #include "ns3/double.h"
 #include "ns3/string.h"
 #include "ns3/pointer.h"
@@ -70,10 +71,23 @@ RandomWalk2dMobilityModel::GetTypeId (void)
                    "A random variable used to pick the speed (m/s).",
                    StringValue ("ns3::UniformRandomVariable[Min=2.0|Max=4.0]"),
                    MakePointerAccessor (&RandomWalk2dMobilityModel::m_speed),
-                   MakePointerChecker<RandomVariableStream> ());
+                   MakePointerChecker<RandomVariableStream> ())
+    .AddAttribute ("Lazy",
+                   "If true, no event is scheduled for the changes of direction and "
+                   "speed: they are replayed, with the same random draws, when the "
+                   "position or velocity is queried.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RandomWalk2dMobilityModel::m_lazy),
+                   MakeBooleanChecker ());
   return tid;
 }
 
+RandomWalk2dMobilityModel::RandomWalk2dMobilityModel ()
+  : m_lazy (false),
+    m_nextStep (STEP_NONE)
+{
+}
+
 void
 RandomWalk2dMobilityModel::DoInitialize (void)
 {
@@ -84,13 +98,19 @@ RandomWalk2dMobilityModel::DoInitialize (void)
 void
 RandomWalk2dMobilityModel::DoInitializePrivate (void)
 {
-  m_helper.Update ();
+  ChangeVelocity (Simulator::Now ());
+}
+
+void
+RandomWalk2dMobilityModel::ChangeVelocity (Time now)
+{
+  m_helper.Update (now);
   double speed = m_speed->GetValue ();
   double direction = m_direction->GetValue ();
   Vector vector (std::cos (direction) * speed,
                  std::sin (direction) * speed,
                  0.0);
-  m_helper.SetVelocity (vector);
+  m_helper.SetVelocity (vector, now);
   m_helper.Unpause ();
 
   Time delayLeft;
@@ -102,11 +122,11 @@ RandomWalk2dMobilityModel::DoInitializePrivate (void)
     {
       delayLeft = Seconds (m_modeDistance / speed); 
     }
-  DoWalk (delayLeft);
+  DoWalk (delayLeft, now);
 }
 
 void
-RandomWalk2dMobilityModel::DoWalk (Time delayLeft)
+RandomWalk2dMobilityModel::DoWalk (Time delayLeft, Time now)
 {
   Vector position = m_helper.GetCurrentPosition ();
   Vector speed = m_helper.GetVelocity ();
@@ -116,22 +136,39 @@ RandomWalk2dMobilityModel::DoWalk (Time delayLeft)
   m_event.Cancel ();
   if (m_bounds.IsInside (nextPosition))
     {
-      m_event = Simulator::Schedule (delayLeft, &RandomWalk2dMobilityModel::DoInitializePrivate, this);
+      if (m_lazy)
+        {
+          m_nextStep = STEP_WALK;
+          m_nextTime = now + delayLeft;
+        }
+      else
+        {
+          m_event = Simulator::Schedule (delayLeft, &RandomWalk2dMobilityModel::DoInitializePrivate, this);
+        }
     }
   else
     {
       nextPosition = m_bounds.CalculateIntersection (position, speed);
       Time delay = Seconds ((nextPosition.x - position.x) / speed.x);
-      m_event = Simulator::Schedule (delay, &RandomWalk2dMobilityModel::Rebound, this,
-                                     delayLeft - delay);
+      if (m_lazy)
+        {
+          m_nextStep = STEP_REBOUND;
+          m_nextTime = now + delay;
+          m_nextDelayLeft = delayLeft - delay;
+        }
+      else
+        {
+          m_event = Simulator::Schedule (delay, &RandomWalk2dMobilityModel::Rebound, this,
+                                         delayLeft - delay, now + delay);
+        }
     }
   NotifyCourseChange ();
 }
 
 void
-RandomWalk2dMobilityModel::Rebound (Time delayLeft)
+RandomWalk2dMobilityModel::Rebound (Time delayLeft, Time now)
 {
-  m_helper.UpdateWithBounds (m_bounds);
+  m_helper.UpdateWithBounds (m_bounds, now);
   Vector position = m_helper.GetCurrentPosition ();
   Vector speed = m_helper.GetVelocity ();
   switch (m_bounds.GetClosestSide (position))
@@ -145,9 +182,28 @@ RandomWalk2dMobilityModel::Rebound (Time delayLeft)
       speed.y = -speed.y;
       break;
     }
-  m_helper.SetVelocity (speed);
+  m_helper.SetVelocity (speed, now);
   m_helper.Unpause ();
-  DoWalk (delayLeft);
+  DoWalk (delayLeft, now);
+}
+
+void
+RandomWalk2dMobilityModel::Advance (void)
+{
+  Time now = Simulator::Now ();
+  while (m_nextStep != STEP_NONE && m_nextTime <= now)
+    {
+      enum Step step = m_nextStep;
+      m_nextStep = STEP_NONE;
+      if (step == STEP_WALK)
+        {
+          ChangeVelocity (m_nextTime);
+        }
+      else
+        {
+          Rebound (m_nextDelayLeft, m_nextTime);
+        }
+    }
 }
 
 void
@@ -159,6 +215,7 @@ RandomWalk2dMobilityModel::DoDispose (void)
 Vector
 RandomWalk2dMobilityModel::DoGetPosition (void) const
 {
+  const_cast<RandomWalk2dMobilityModel *> (this)->Advance ();
   m_helper.UpdateWithBounds (m_bounds);
   return m_helper.GetCurrentPosition ();
 }
@@ -166,13 +223,23 @@ void
 RandomWalk2dMobilityModel::DoSetPosition (const Vector &position)
 {
   NS_ASSERT (m_bounds.IsInside (position));
+  Advance ();
   m_helper.SetPosition (position);
   Simulator::Remove (m_event);
-  m_event = Simulator::ScheduleNow (&RandomWalk2dMobilityModel::DoInitializePrivate, this);
+  if (m_lazy)
+    {
+      m_nextStep = STEP_WALK;
+      m_nextTime = Simulator::Now ();
+    }
+  else
+    {
+      m_event = Simulator::ScheduleNow (&RandomWalk2dMobilityModel::DoInitializePrivate, this);
+    }
 }
 Vector
 RandomWalk2dMobilityModel::DoGetVelocity (void) const
 {
+  const_cast<RandomWalk2dMobilityModel *> (this)->Advance ();
   return m_helper.GetVelocity ();
 }
 int64_t
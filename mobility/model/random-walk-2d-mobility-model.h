@@ -42,6 +42,13 @@ namespace ns3 {
  * of the model, we rebound on the boundary with a reflexive angle
  * and speed. This model is often identified as a brownian motion
  * model.
+ *
+ * When the Lazy attribute is set, the changes of direction and speed
+ * are not scheduled: they are replayed up to the current time, in
+ * order and with the same random draws, whenever the position or the
+ * velocity is queried.  The trajectory is the same as in the default
+ * mode, but the CourseChange trace fires when the model is queried
+ * rather than at the time of each change.
  */
 class RandomWalk2dMobilityModel : public MobilityModel 
 {
@@ -57,17 +64,38 @@ public:
     MODE_TIME
   };
 
+  RandomWalk2dMobilityModel ();
+
 private:
+  /** The next change of course of a lazy model. */
+  enum Step {
+    STEP_NONE,
+    STEP_WALK,
+    STEP_REBOUND
+  };
+
   /**
    * \brief Performs the rebound of the node if it reaches a boundary
    * \param timeLeft The remaining time of the walk
+   * \param now The time of the rebound
    */
-  void Rebound (Time timeLeft);
+  void Rebound (Time timeLeft, Time now);
   /**
    * Walk according to position and velocity, until distance is reached,
    * time is reached, or intersection with the bounding box
+   * \param timeLeft The remaining time of the walk
+   * \param now The current time of the walk
+   */
+  void DoWalk (Time timeLeft, Time now);
+  /**
+   * Pick a new direction and speed and start walking
+   * \param now The time of the change
+   */
+  void ChangeVelocity (Time now);
+  /**
+   * Perform the changes of course of a lazy model up to now
    */
-  void DoWalk (Time timeLeft);
+  void Advance (void);
   /**
    * Perform initialization of the object before MobilityModel::DoInitialize ()
    */
@@ -87,6 +115,10 @@ private:
   Ptr<RandomVariableStream> m_speed; //!< rv for picking speed
   Ptr<RandomVariableStream> m_direction; //!< rv for picking direction
   Rectangle m_bounds; //!< Bounds of the area to cruise
+  bool m_lazy; //!< replay changes of course on demand instead of scheduling them
+  enum Step m_nextStep; //!< next change of course of a lazy model
+  Time m_nextTime; //!< time of the next change of course of a lazy model
+  Time m_nextDelayLeft; //!< remaining walk time after the next rebound
 };
 
 
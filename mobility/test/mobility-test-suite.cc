@@ -31,6 +31,9 @@
 #include "ns3/mobility-model.h"
 #include "ns3/waypoint-mobility-model.h"
 #include "ns3/mobility-helper.h"
+#include "ns3/object-factory.h"
+#include "ns3/double.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -354,6 +357,90 @@ WaypointMobilityModelViaHelper::DoRun (void)
   Simulator::Destroy ();
 }
 
+// Test that the Lazy mode of the random mobility models follows the
+// same trajectory as the event driven mode, without scheduling events
+class LazyRandomMobilityModel : public TestCase
+{
+public:
+  LazyRandomMobilityModel (std::string model, double alpha, Vector position);
+  virtual ~LazyRandomMobilityModel ();
+
+private:
+  void Sample (Ptr<MobilityModel> mob, bool last);
+  void Walk (bool lazy);
+  virtual void DoRun (void);
+  ObjectFactory m_factory;
+  Vector m_initialPosition;
+  bool m_lazy;
+  std::vector<Vector> m_positions;
+  std::vector<Vector> m_velocities;
+};
+
+LazyRandomMobilityModel::LazyRandomMobilityModel (std::string model, double alpha, Vector position)
+  : TestCase ("Test that " + model + " gives the same trajectory when Lazy is true"),
+    m_initialPosition (position),
+    m_lazy (false)
+{
+  m_factory.SetTypeId (model);
+  if (alpha >= 0)
+    {
+      m_factory.Set ("Alpha", DoubleValue (alpha));
+    }
+}
+
+LazyRandomMobilityModel::~LazyRandomMobilityModel ()
+{
+}
+
+void
+LazyRandomMobilityModel::Sample (Ptr<MobilityModel> mob, bool last)
+{
+  m_positions.push_back (mob->GetPosition ());
+  m_velocities.push_back (mob->GetVelocity ());
+  if (last)
+    {
+      if (m_lazy)
+        {
+          NS_TEST_EXPECT_MSG_EQ (Simulator::IsFinished (), true, "A lazy model should not schedule events");
+        }
+      Simulator::Stop ();
+    }
+}
+
+void
+LazyRandomMobilityModel::Walk (bool lazy)
+{
+  m_lazy = lazy;
+  m_factory.Set ("Lazy", BooleanValue (lazy));
+  Ptr<MobilityModel> mob = m_factory.Create<MobilityModel> ();
+  mob->AssignStreams (10);
+  mob->SetPosition (m_initialPosition);
+  mob->Initialize ();
+  for (uint32_t i = 1; i <= 300; i++)
+    {
+      Simulator::Schedule (Seconds (0.373 * i), &LazyRandomMobilityModel::Sample, this, mob, i == 300);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+LazyRandomMobilityModel::DoRun (void)
+{
+  Walk (false);
+  std::vector<Vector> positions = m_positions;
+  std::vector<Vector> velocities = m_velocities;
+  m_positions.clear ();
+  m_velocities.clear ();
+  Walk (true);
+  NS_TEST_ASSERT_MSG_EQ (m_positions.size (), positions.size (), "Missing samples");
+  for (uint32_t i = 0; i < positions.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ_TOL (CalculateDistance (m_positions[i], positions[i]), 0, 1e-9, "Position differs in sample " << i);
+      NS_TEST_EXPECT_MSG_EQ_TOL (CalculateDistance (m_velocities[i], velocities[i]), 0, 1e-9, "Velocity differs in sample " << i);
+    }
+}
+
 class MobilityTestSuite : public TestSuite
 {
 public:
@@ -367,6 +454,9 @@ MobilityTestSuite::MobilityTestSuite ()
   AddTestCase (new WaypointLazyNotifyTrue, TestCase::QUICK);
   AddTestCase (new WaypointInitialPositionIsWaypoint, TestCase::QUICK);
   AddTestCase (new WaypointMobilityModelViaHelper, TestCase::QUICK);
+  AddTestCase (new LazyRandomMobilityModel ("ns3::RandomWalk2dMobilityModel", -1, Vector (50.0, 50.0, 0.0)), TestCase::QUICK);
+  AddTestCase (new LazyRandomMobilityModel ("ns3::RandomDirection2dMobilityModel", -1, Vector (0.0, 0.0, 0.0)), TestCase::QUICK);
+  AddTestCase (new LazyRandomMobilityModel ("ns3::GaussMarkovMobilityModel", 0.85, Vector (0.0, 0.0, 50.0)), TestCase::QUICK);
 }
 
 static MobilityTestSuite mobilityTestSuite;
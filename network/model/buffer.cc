@@ -20,11 +20,13 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include "slab-allocator.h"
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
                 ", zero end="<<m_zeroAreaEnd<<", count="<<m_data->m_count<<", size="<<m_data->m_size<<   \
-                ", dirty start="<<m_data->m_dirtyStart<<", dirty end="<<m_data->m_dirtyEnd)
+                ", dirty start="<<m_data->m_dirtyStart<<", dirty end="<<m_data->m_dirtyEnd<<              \
+                ", extra zero areas="<<GetNZeroAreas ())
 
 namespace {
 
@@ -51,98 +53,22 @@ NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
 uint32_t Buffer::g_recommendedStart = 0;
-#ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use 
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy 
- * constructor orderings.
- */
-#define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
-
-Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
-{
-  NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
-    {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
-        {
-          Buffer::Deallocate (*i);
-        }
-      delete g_freeList;
-      g_freeList = DESTROYED;
-    }
-}
+uint32_t Buffer::g_minSharedSize = 0;
 
 void
-Buffer::Recycle (struct Buffer::Data *data)
+Buffer::EnableSharing (uint32_t minSize)
 {
-  NS_LOG_FUNCTION (data);
-  NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
-    {
-      Buffer::Deallocate (data);
-    }
-  else
-    {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
-    }
+  NS_LOG_FUNCTION (minSize);
+  g_minSharedSize = std::max (minSize, static_cast<uint32_t> (1));
 }
 
-Buffer::Data *
-Buffer::Create (uint32_t dataSize)
+void
+Buffer::DisableSharing (void)
 {
-  NS_LOG_FUNCTION (dataSize);
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
-    {
-      g_freeList = new Buffer::FreeList ();
-    }
-  else if (IS_INITIALIZED (g_freeList))
-    {
-      while (!g_freeList->empty ()) 
-        {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
-        }
-    }
-  struct Buffer::Data *data = Buffer::Allocate (dataSize);
-  NS_ASSERT (data->m_count == 1);
-  return data;
+  NS_LOG_FUNCTION_NOARGS ();
+  g_minSharedSize = 0;
 }
-#else /* BUFFER_FREE_LIST */
+
 void
 Buffer::Recycle (struct Buffer::Data *data)
 {
@@ -157,7 +83,6 @@ Buffer::Create (uint32_t size)
   NS_LOG_FUNCTION (size);
   return Allocate (size);
 }
-#endif /* BUFFER_FREE_LIST */
 
 struct Buffer::Data *
 Buffer::Allocate (uint32_t reqSize)
@@ -169,9 +94,10 @@ Buffer::Allocate (uint32_t reqSize)
     }
   NS_ASSERT (reqSize >= 1);
   uint32_t size = reqSize - 1 + sizeof (struct Buffer::Data);
-  uint8_t *b = new uint8_t [size];
+  uint8_t *b = SlabAllocator::Allocate (size);
   struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data*>(b);
-  data->m_size = reqSize;
+  // use the whole block returned by the allocator
+  data->m_size = size + 1 - sizeof (struct Buffer::Data);
   data->m_count = 1;
   return data;
 }
@@ -182,22 +108,243 @@ Buffer::Deallocate (struct Buffer::Data *data)
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
   uint8_t *buf = reinterpret_cast<uint8_t *> (data);
-  delete [] buf;
+  SlabAllocator::Deallocate (buf, data->m_size - 1 + sizeof (struct Buffer::Data));
+}
+
+void
+Buffer::ReleaseZeroAreas (struct Buffer::ZeroAreas *areas)
+{
+  NS_LOG_FUNCTION (areas);
+  if (areas == 0)
+    {
+      return;
+    }
+  areas->m_count--;
+  if (areas->m_count == 0)
+    {
+      for (uint32_t i = 0; i < areas->m_size; i++)
+        {
+          ReleaseOwner (areas->m_owners[i]);
+        }
+      SlabAllocator::Deallocate (reinterpret_cast<uint8_t *> (areas), areas->m_blockSize);
+    }
+}
+
+void
+Buffer::ReleaseOwner (struct Buffer::Data *owner)
+{
+  NS_LOG_FUNCTION (owner);
+  if (owner == 0)
+    {
+      return;
+    }
+  owner->m_count--;
+  if (owner->m_count == 0)
+    {
+      Recycle (owner);
+    }
+}
+
+void
+Buffer::SetZeroAreas (uint32_t first, uint32_t last, uint32_t capacity)
+{
+  NS_LOG_FUNCTION (this << first << last << capacity);
+  uint32_t size = last - first;
+  capacity = std::max (capacity, size);
+  if (capacity == 0)
+    {
+      ReleaseZeroAreas (m_zeroAreas);
+      m_zeroAreas = 0;
+      return;
+    }
+  struct ZeroAreas *areas = m_zeroAreas;
+  if (areas == 0 || areas->m_count > 1 || areas->m_capacity < capacity)
+    {
+      // the shared bytes of each area are stored after the offsets
+      uint32_t ownersOffset = sizeof (struct ZeroAreas) + (capacity - 1) * 2 * sizeof (uint32_t);
+      ownersOffset = (ownersOffset + sizeof (void *) - 1) & ~(sizeof (void *) - 1);
+      uint32_t bytesOffset = ownersOffset + capacity * sizeof (struct Data *);
+      uint32_t blockSize = bytesOffset + capacity * sizeof (uint8_t const *);
+      uint8_t *block = SlabAllocator::Allocate (blockSize);
+      areas = reinterpret_cast<struct ZeroAreas *> (block);
+      areas->m_count = 1;
+      areas->m_blockSize = blockSize;
+      areas->m_capacity = capacity;
+      areas->m_owners = reinterpret_cast<struct Data **> (block + ownersOffset);
+      areas->m_bytes = reinterpret_cast<uint8_t const **> (block + bytesOffset);
+      if (m_zeroAreas != 0)
+        {
+          // the new instance holds its own references to the shared bytes
+          for (uint32_t i = first; i < last; i++)
+            {
+              if (m_zeroAreas->m_owners[i] != 0)
+                {
+                  m_zeroAreas->m_owners[i]->m_count++;
+                }
+            }
+        }
+    }
+  else
+    {
+      // release the shared bytes of the areas which are removed
+      for (uint32_t i = 0; i < areas->m_size; i++)
+        {
+          if (i < first || i >= last)
+            {
+              ReleaseOwner (areas->m_owners[i]);
+            }
+        }
+    }
+  if (m_zeroAreas != 0 && size > 0)
+    {
+      memmove (areas->m_areas, m_zeroAreas->m_areas + 2 * first, size * 2 * sizeof (uint32_t));
+      memmove (areas->m_owners, m_zeroAreas->m_owners + first, size * sizeof (struct Data *));
+      memmove (areas->m_bytes, m_zeroAreas->m_bytes + first, size * sizeof (uint8_t const *));
+    }
+  if (areas != m_zeroAreas)
+    {
+      ReleaseZeroAreas (m_zeroAreas);
+      m_zeroAreas = areas;
+    }
+  areas->m_size = size;
+  areas->m_zeroSize = 0;
+  for (uint32_t i = 0; i < size; i++)
+    {
+      areas->m_zeroSize += areas->m_areas[2 * i + 1] - areas->m_areas[2 * i];
+    }
+}
+
+void
+Buffer::ShiftZeroAreas (int32_t delta)
+{
+  NS_LOG_FUNCTION (this << delta);
+  if (m_zeroAreas == 0)
+    {
+      return;
+    }
+  uint32_t size = m_zeroAreas->m_size;
+  SetZeroAreas (0, size, size);
+  for (uint32_t i = 0; i < 2 * size; i++)
+    {
+      m_zeroAreas->m_areas[i] += delta;
+    }
+}
+
+void
+Buffer::PromoteZeroArea (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_zeroAreas != 0 && m_zeroAreaStart == m_zeroAreaEnd);
+  NS_ASSERT (m_zeroAreas->m_owners[0] == 0);
+  m_zeroAreaStart = m_zeroAreas->m_areas[0];
+  m_zeroAreaEnd = m_zeroAreas->m_areas[1];
+  SetZeroAreas (1, m_zeroAreas->m_size, 0);
+}
+
+void
+Buffer::AddZeroArea (uint32_t start, uint32_t size,
+                     uint8_t const *bytes, struct Data *owner)
+{
+  NS_LOG_FUNCTION (this << start << size << static_cast<const void *> (bytes) << owner);
+  NS_ASSERT (start <= m_end);
+  if (size == 0)
+    {
+      return;
+    }
+  m_end += size;
+  if (m_zeroAreas == 0 && owner == 0)
+    {
+      NS_ASSERT (start >= m_zeroAreaEnd);
+      if (start == m_zeroAreaEnd)
+        {
+          // extend the main zero area
+          m_zeroAreaEnd += size;
+          return;
+        }
+      else if (m_zeroAreaStart == m_zeroAreaEnd)
+        {
+          // an empty zero area can be moved anywhere
+          m_zeroAreaStart = start;
+          m_zeroAreaEnd = start + size;
+          return;
+        }
+    }
+  uint32_t n = GetNZeroAreas ();
+  if (owner == 0 && n > 0 && m_zeroAreas->m_areas[2 * n - 1] == start
+      && m_zeroAreas->m_owners[n - 1] == 0)
+    {
+      // extend the last extra zero area
+      SetZeroAreas (0, n, n);
+      m_zeroAreas->m_areas[2 * n - 1] += size;
+      m_zeroAreas->m_zeroSize += size;
+      return;
+    }
+  NS_ASSERT (start >= (n == 0 ? m_zeroAreaEnd : m_zeroAreas->m_areas[2 * n - 1]));
+  SetZeroAreas (0, n, std::max (2 * n, n + 1));
+  m_zeroAreas->m_areas[2 * n] = start;
+  m_zeroAreas->m_areas[2 * n + 1] = start + size;
+  m_zeroAreas->m_bytes[n] = bytes;
+  m_zeroAreas->m_owners[n] = owner;
+  if (owner != 0)
+    {
+      owner->m_count++;
+    }
+  m_zeroAreas->m_size++;
+  m_zeroAreas->m_zeroSize += size;
+}
+
+void
+Buffer::GetZeroArea (uint32_t i, uint32_t &start, uint32_t &end) const
+{
+  if (i == 0)
+    {
+      start = m_zeroAreaStart;
+      end = m_zeroAreaEnd;
+    }
+  else if (i <= GetNZeroAreas ())
+    {
+      start = m_zeroAreas->m_areas[2 * (i - 1)];
+      end = m_zeroAreas->m_areas[2 * (i - 1) + 1];
+    }
+  else
+    {
+      start = m_end;
+      end = m_end;
+    }
+}
+
+uint8_t const *
+Buffer::GetZeroAreaData (uint32_t i) const
+{
+  if (i == 0 || i > GetNZeroAreas ())
+    {
+      return 0;
+    }
+  return m_zeroAreas->m_bytes[i - 1];
+}
+
+uint32_t
+Buffer::GetNZeroAreas (void) const
+{
+  return m_zeroAreas == 0 ? 0 : m_zeroAreas->m_size;
 }
 
 Buffer::Buffer ()
+  : m_zeroAreas (0)
 {
   NS_LOG_FUNCTION (this);
   Initialize (0);
 }
 
 Buffer::Buffer (uint32_t dataSize)
+  : m_zeroAreas (0)
 {
   NS_LOG_FUNCTION (this << dataSize);
   Initialize (dataSize);
 }
 
 Buffer::Buffer (uint32_t dataSize, bool initialize)
+  : m_zeroAreas (0)
 {
   NS_LOG_FUNCTION (this << dataSize << initialize);
   if (initialize == true)
@@ -222,9 +369,19 @@ Buffer::CheckInternalState (void) const
   bool dirtyOk =
     m_start >= m_data->m_dirtyStart &&
     m_end <= m_data->m_dirtyEnd;
-  bool internalSizeOk = m_end - (m_zeroAreaEnd - m_zeroAreaStart) <= m_data->m_size &&
+  bool internalSizeOk = GetInternalEnd () <= m_data->m_size &&
     m_start <= m_data->m_size &&
     m_zeroAreaStart <= m_data->m_size;
+  uint32_t previousEnd = m_zeroAreaEnd;
+  for (uint32_t i = 1; i <= GetNZeroAreas (); i++)
+    {
+      uint32_t start, end;
+      GetZeroArea (i, start, end);
+      bool touchOk = previousEnd < start || GetZeroAreaData (i) != 0 ||
+        (i > 1 && GetZeroAreaData (i - 1) != 0);
+      offsetsOk = offsetsOk && previousEnd <= start && touchOk && start < end && end <= m_end;
+      previousEnd = end;
+    }
 
   bool ok = m_data->m_count > 0 && offsetsOk && dirtyOk && internalSizeOk;
   if (!ok)
@@ -244,6 +401,8 @@ void
 Buffer::Initialize (uint32_t zeroSize)
 {
   NS_LOG_FUNCTION (this << zeroSize);
+  ReleaseZeroAreas (m_zeroAreas);
+  m_zeroAreas = 0;
   m_data = Buffer::Create (0);
   m_start = std::min (m_data->m_size, g_recommendedStart);
   m_maxZeroAreaStart = m_start;
@@ -270,6 +429,15 @@ Buffer::operator = (Buffer const&o)
       m_data = o.m_data;
       m_data->m_count++;
     }
+  if (m_zeroAreas != o.m_zeroAreas)
+    {
+      ReleaseZeroAreas (m_zeroAreas);
+      m_zeroAreas = o.m_zeroAreas;
+      if (m_zeroAreas != 0)
+        {
+          m_zeroAreas->m_count++;
+        }
+    }
   g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
   m_maxZeroAreaStart = o.m_maxZeroAreaStart;
   m_zeroAreaStart = o.m_zeroAreaStart;
@@ -290,19 +458,30 @@ Buffer::~Buffer ()
     {
       Recycle (m_data);
     }
+  ReleaseZeroAreas (m_zeroAreas);
 }
 
 uint32_t
 Buffer::GetInternalSize (void) const
 {
   NS_LOG_FUNCTION (this);
-  return m_zeroAreaStart - m_start + m_end - m_zeroAreaEnd;
+  uint32_t size = m_zeroAreaStart - m_start + m_end - m_zeroAreaEnd;
+  if (m_zeroAreas != 0)
+    {
+      size -= m_zeroAreas->m_zeroSize;
+    }
+  return size;
 }
 uint32_t
 Buffer::GetInternalEnd (void) const
 {
   NS_LOG_FUNCTION (this);
-  return m_end - (m_zeroAreaEnd - m_zeroAreaStart);
+  uint32_t end = m_end - (m_zeroAreaEnd - m_zeroAreaStart);
+  if (m_zeroAreas != 0)
+    {
+      end -= m_zeroAreas->m_zeroSize;
+    }
+  return end;
 }
 
 void
@@ -341,6 +520,7 @@ Buffer::AddAtStart (uint32_t start)
       m_zeroAreaEnd += delta;
       m_end += delta;
       m_start -= start;
+      ShiftZeroAreas (delta);
 
       // update dirty area
       m_data->m_dirtyStart = m_start;
@@ -386,6 +566,7 @@ Buffer::AddAtEnd (uint32_t end)
       m_end += delta;
       m_start += delta;
       m_end += end;
+      ShiftZeroAreas (delta);
 
       // update dirty area
       m_data->m_dirtyStart = m_start;
@@ -400,40 +581,61 @@ void
 Buffer::AddAtEnd (const Buffer &o)
 {
   NS_LOG_FUNCTION (this << &o);
-  if (m_data->m_count == 1 &&
-      m_end == m_zeroAreaEnd &&
-      m_end == m_data->m_dirtyEnd &&
-      o.m_start == o.m_zeroAreaStart &&
-      o.m_zeroAreaEnd - o.m_zeroAreaStart > 0)
-    {
-      /**
-       * This is an optimization which kicks in when
-       * we attempt to aggregate two buffers which contain
-       * adjacent zero areas.
-       */
-      uint32_t zeroSize = o.m_zeroAreaEnd - o.m_zeroAreaStart;
-      m_zeroAreaEnd += zeroSize;
-      m_end = m_zeroAreaEnd;
-      m_data->m_dirtyEnd = m_zeroAreaEnd;
-      uint32_t endData = o.m_end - o.m_zeroAreaEnd;
-      AddAtEnd (endData);
-      Buffer::Iterator dst = End ();
-      dst.Prev (endData);
-      Buffer::Iterator src = o.End ();
-      src.Prev (endData);
-      dst.Write (src, o.End ());
-      NS_ASSERT (CheckInternalState ());
-      return;
+  NS_ASSERT (CheckInternalState ());
+  // o might be this buffer, or share its data: keep a reference to
+  // its data until it has been copied.
+  Buffer src = o;
+
+  /* copy only the real bytes of o, then insert its zero areas:
+   * Before: |xxx000...|  and  |yyy000...000..|
+   * After:  |xxx000...yyy000...000..|
+   * The runs of real bytes which are large enough to be shared are
+   * inserted as zero areas which reference the data of o.
+   */
+  uint32_t nAreas = src.GetNZeroAreas ();
+  uint32_t copySize = 0;
+  uint32_t current = src.m_start;
+  for (uint32_t i = 0; i <= nAreas + 1; i++)
+    {
+      uint32_t zeroStart, zeroEnd;
+      src.GetZeroArea (i, zeroStart, zeroEnd);
+      if (g_minSharedSize == 0 || zeroStart - current < g_minSharedSize)
+        {
+          copySize += zeroStart - current;
+        }
+      current = zeroEnd;
     }
-
-  Buffer dst = CreateFullCopy ();
-  Buffer src = o.CreateFullCopy ();
-
-  dst.AddAtEnd (src.GetSize ());
-  Buffer::Iterator destStart = dst.End ();
-  destStart.Prev (src.GetSize ());
-  destStart.Write (src.Begin (), src.End ());
-  *this = dst;
+  AddAtEnd (copySize);
+  uint8_t *to = m_data->m_data + GetInternalEnd () - copySize;
+  uint32_t end = m_end - copySize;
+  current = src.m_start;
+  uint32_t shift = 0;
+  for (uint32_t i = 0; i <= nAreas + 1; i++)
+    {
+      uint32_t zeroStart, zeroEnd;
+      src.GetZeroArea (i, zeroStart, zeroEnd);
+      uint32_t size = zeroStart - current;
+      uint8_t const *from = src.m_data->m_data + current - shift;
+      if (g_minSharedSize == 0 || size < g_minSharedSize)
+        {
+          memcpy (to, from, size);
+          to += size;
+        }
+      else
+        {
+          AddZeroArea (end, size, from, src.m_data);
+        }
+      end += size;
+      uint8_t const *bytes = src.GetZeroAreaData (i);
+      AddZeroArea (end, zeroEnd - zeroStart, bytes,
+                   bytes == 0 ? 0 : src.m_zeroAreas->m_owners[i - 1]);
+      end += zeroEnd - zeroStart;
+      shift += zeroEnd - zeroStart;
+      current = zeroEnd;
+    }
+  // the bytes up to the new end belong to this buffer.
+  m_data->m_dirtyEnd = m_end;
+  LOG_INTERNAL_STATE ("add buffer=" << src.GetSize () << ", ");
   NS_ASSERT (CheckInternalState ());
 }
 
@@ -443,6 +645,56 @@ Buffer::RemoveAtStart (uint32_t start)
   NS_LOG_FUNCTION (this << start);
   NS_ASSERT (CheckInternalState ());
   uint32_t newStart = m_start + start;
+  while (m_zeroAreas != 0 && newStart > m_zeroAreaEnd)
+    {
+      /* remove start of buffer and complete zero area: the next
+       * zero area becomes the main zero area
+       */
+      uint32_t zeroSize = m_zeroAreaEnd - m_zeroAreaStart;
+      newStart -= zeroSize;
+      m_end -= zeroSize;
+      ShiftZeroAreas (-static_cast<int32_t> (zeroSize));
+      m_start = m_zeroAreaStart;
+      m_zeroAreaEnd = m_zeroAreaStart;
+      if (m_zeroAreas->m_owners[0] == 0)
+        {
+          PromoteZeroArea ();
+          continue;
+        }
+      /* the next zero area shares bytes and cannot become the main
+       * zero area: remove its start, and leave an empty main zero
+       * area in front of it.
+       */
+      uint32_t sharedStart = m_zeroAreas->m_areas[0];
+      if (newStart <= sharedStart)
+        {
+          m_zeroAreaStart = newStart;
+          m_zeroAreaEnd = newStart;
+          break;
+        }
+      uint32_t n = m_zeroAreas->m_size;
+      uint32_t delta = std::min (newStart, m_zeroAreas->m_areas[1]) - sharedStart;
+      SetZeroAreas (0, n, n);
+      for (uint32_t i = 1; i < 2 * n; i++)
+        {
+          m_zeroAreas->m_areas[i] -= delta;
+        }
+      m_zeroAreas->m_bytes[0] += delta;
+      m_zeroAreas->m_zeroSize -= delta;
+      newStart -= delta;
+      m_end -= delta;
+      m_start = sharedStart;
+      m_zeroAreaStart = sharedStart;
+      m_zeroAreaEnd = sharedStart;
+      if (m_zeroAreas->m_areas[0] == m_zeroAreas->m_areas[1])
+        {
+          SetZeroAreas (1, n, 0);
+          if (m_zeroAreas != 0 && m_zeroAreas->m_owners[0] == 0)
+            {
+              PromoteZeroArea ();
+            }
+        }
+    }
   if (newStart <= m_zeroAreaStart)
     {
       /* only remove start of buffer 
@@ -457,13 +709,19 @@ Buffer::RemoveAtStart (uint32_t start)
       m_start = m_zeroAreaStart;
       m_zeroAreaEnd -= delta;
       m_end -= delta;
+      ShiftZeroAreas (-static_cast<int32_t> (delta));
+      if (m_zeroAreaStart == m_zeroAreaEnd && m_zeroAreas != 0
+          && m_zeroAreas->m_owners[0] == 0)
+        {
+          PromoteZeroArea ();
+        }
     } 
   else if (newStart <= m_end)
     {
       /* remove start of buffer, complete zero area, and part
        * of end of buffer 
        */
-      NS_ASSERT (m_end >= start);
+      NS_ASSERT (m_end >= newStart);
       uint32_t zeroSize = m_zeroAreaEnd - m_zeroAreaStart;
       m_start = newStart - zeroSize;
       m_end -= zeroSize;
@@ -488,7 +746,34 @@ Buffer::RemoveAtEnd (uint32_t end)
   NS_LOG_FUNCTION (this << end);
   NS_ASSERT (CheckInternalState ());
   uint32_t newEnd = m_end - std::min (end, m_end - m_start);
-  if (newEnd > m_zeroAreaEnd)
+  if (m_zeroAreas != 0)
+    {
+      /* remove the extra zero areas which start after the new end */
+      uint32_t n = m_zeroAreas->m_size;
+      while (n > 0 && m_zeroAreas->m_areas[2 * (n - 1)] >= newEnd)
+        {
+          n--;
+        }
+      if (n < m_zeroAreas->m_size)
+        {
+          SetZeroAreas (0, n, 0);
+        }
+    }
+  if (m_zeroAreas != 0)
+    {
+      /* remove part of end of buffer, and maybe part of the last
+       * extra zero area
+       */
+      uint32_t n = m_zeroAreas->m_size;
+      if (m_zeroAreas->m_areas[2 * n - 1] > newEnd)
+        {
+          SetZeroAreas (0, n, n);
+          m_zeroAreas->m_zeroSize -= m_zeroAreas->m_areas[2 * n - 1] - newEnd;
+          m_zeroAreas->m_areas[2 * n - 1] = newEnd;
+        }
+      m_end = newEnd;
+    }
+  else if (newEnd > m_zeroAreaEnd)
     {
       /* remove part of end of buffer */
       m_end = newEnd;
@@ -535,6 +820,14 @@ Buffer::CreateFullCopy (void) const
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (CheckInternalState ());
+  if (m_zeroAreas != 0)
+    {
+      Buffer tmp;
+      tmp.AddAtStart (GetSize ());
+      CopyData (tmp.m_data->m_data + tmp.m_start, GetSize ());
+      NS_ASSERT (tmp.CheckInternalState ());
+      return tmp;
+    }
   if (m_zeroAreaEnd - m_zeroAreaStart != 0) 
     {
       Buffer tmp;
@@ -555,10 +848,30 @@ Buffer::CreateFullCopy (void) const
   return *this;
 }
 
+Buffer
+Buffer::CreateMainZeroAreaCopy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (CheckInternalState ());
+  uint32_t mainSize = m_zeroAreaEnd - m_start;
+  uint32_t size = GetSize () - mainSize;
+  Buffer tmp = CreateFragment (0, mainSize);
+  // copy the bytes after the main zero area, which may be shared
+  tmp.AddAtEnd (size);
+  CreateFragment (mainSize, size).CopyData (tmp.m_data->m_data + tmp.GetInternalEnd () - size, size);
+  NS_ASSERT (tmp.m_zeroAreas == 0);
+  return tmp;
+}
+
 uint32_t 
 Buffer::GetSerializedSize (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_zeroAreas != 0)
+    {
+      // the serialized format holds only one zero area
+      return CreateMainZeroAreaCopy ().GetSerializedSize ();
+    }
   uint32_t dataStart = (m_zeroAreaStart - m_start + 3) & (~0x3);
   uint32_t dataEnd = (m_end - m_zeroAreaEnd + 3) & (~0x3);
 
@@ -579,6 +892,10 @@ uint32_t
 Buffer::Serialize (uint8_t* buffer, uint32_t maxSize) const
 {
   NS_LOG_FUNCTION (this << &buffer << maxSize);
+  if (m_zeroAreas != 0)
+    {
+      return CreateMainZeroAreaCopy ().Serialize (buffer, maxSize);
+    }
   uint32_t* p = reinterpret_cast<uint32_t *> (buffer);
   uint32_t size = 0;
 
@@ -715,28 +1032,31 @@ void
 Buffer::CopyData (std::ostream *os, uint32_t size) const
 {
   NS_LOG_FUNCTION (this << &os << size);
-  if (size > 0)
-    {
-      uint32_t tmpsize = std::min (m_zeroAreaStart-m_start, size);
-      os->write ((const char*)(m_data->m_data + m_start), tmpsize);
-      if (size > tmpsize) 
-        { 
-          size -= m_zeroAreaStart-m_start;
-          tmpsize = std::min (m_zeroAreaEnd - m_zeroAreaStart, size);
-          uint32_t left = tmpsize;
-          while (left > 0)
-            {
-              uint32_t toWrite = std::min (left, g_zeroes.size);
-              os->write (g_zeroes.buffer, toWrite);
-              left -= toWrite;
-            }
-          if (size > tmpsize)
-            {
-              size -= tmpsize;
-              tmpsize = std::min (m_end - m_zeroAreaEnd, size);
-              os->write ((const char*)(m_data->m_data + m_zeroAreaStart), tmpsize); 
-            }
+  uint32_t current = m_start;
+  uint32_t shift = 0;
+  for (uint32_t i = 0; i <= GetNZeroAreas () + 1 && size > 0; i++)
+    {
+      uint32_t zeroStart, zeroEnd;
+      GetZeroArea (i, zeroStart, zeroEnd);
+      uint32_t tmpsize = std::min (zeroStart - current, size);
+      os->write ((const char*)(m_data->m_data + current - shift), tmpsize);
+      size -= tmpsize;
+      tmpsize = std::min (zeroEnd - zeroStart, size);
+      uint8_t const *bytes = GetZeroAreaData (i);
+      uint32_t left = bytes == 0 ? tmpsize : 0;
+      if (bytes != 0)
+        {
+          os->write ((const char*)bytes, tmpsize);
         }
+      while (left > 0)
+        {
+          uint32_t toWrite = std::min (left, g_zeroes.size);
+          os->write (g_zeroes.buffer, toWrite);
+          left -= toWrite;
+        }
+      size -= tmpsize;
+      shift += zeroEnd - zeroStart;
+      current = zeroEnd;
     }
 }
 
@@ -745,31 +1065,30 @@ Buffer::CopyData (uint8_t *buffer, uint32_t size) const
 {
   NS_LOG_FUNCTION (this << &buffer << size);
   uint32_t originalSize = size;
-  if (size > 0)
+  uint32_t current = m_start;
+  uint32_t shift = 0;
+  for (uint32_t i = 0; i <= GetNZeroAreas () + 1 && size > 0; i++)
     {
-      uint32_t tmpsize = std::min (m_zeroAreaStart-m_start, size);
-      memcpy (buffer, (const char*)(m_data->m_data + m_start), tmpsize);
+      uint32_t zeroStart, zeroEnd;
+      GetZeroArea (i, zeroStart, zeroEnd);
+      uint32_t tmpsize = std::min (zeroStart - current, size);
+      memcpy (buffer, (const char*)(m_data->m_data + current - shift), tmpsize);
       buffer += tmpsize;
       size -= tmpsize;
-      if (size > 0) 
-        { 
-          tmpsize = std::min (m_zeroAreaEnd - m_zeroAreaStart, size);
-          uint32_t left = tmpsize;
-          while (left > 0)
-            {
-              uint32_t toWrite = std::min (left, g_zeroes.size);
-              memcpy (buffer, g_zeroes.buffer, toWrite);
-              left -= toWrite;
-              buffer += toWrite;
-            }
-          size -= tmpsize;
-          if (size > 0)
-            {
-              tmpsize = std::min (m_end - m_zeroAreaEnd, size);
-              memcpy (buffer, (const char*)(m_data->m_data + m_zeroAreaStart), tmpsize);
-              size -= tmpsize;
-            }
+      tmpsize = std::min (zeroEnd - zeroStart, size);
+      uint8_t const *bytes = GetZeroAreaData (i);
+      if (bytes == 0)
+        {
+          memset (buffer, 0, tmpsize);
         }
+      else
+        {
+          memcpy (buffer, bytes, tmpsize);
+        }
+      buffer += tmpsize;
+      size -= tmpsize;
+      shift += zeroEnd - zeroStart;
+      current = zeroEnd;
     }
   return originalSize - size;
 }
@@ -825,9 +1144,46 @@ bool
 Buffer::Iterator::Check (uint32_t i) const
 {
   NS_LOG_FUNCTION (this << &i);
-  return i >= m_dataStart && 
-         !(i >= m_zeroStart && i < m_zeroEnd) &&
-         i <= m_dataEnd;
+  if (i < m_dataStart || i > m_dataEnd ||
+      (i >= m_mainZeroStart && i < m_mainZeroEnd))
+    {
+      return false;
+    }
+  for (uint32_t k = 0; k < m_nExtraZero; k++)
+    {
+      if (i >= m_extraZero[2 * k] && i < m_extraZero[2 * k + 1])
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+Buffer::Iterator::SelectWindow (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t zeroStart = m_mainZeroStart;
+  uint32_t zeroEnd = m_mainZeroEnd;
+  uint32_t windowStart = 0;
+  uint32_t shift = 0;
+  uint8_t const *zeroData = 0;
+  uint32_t k = 0;
+  while (zeroEnd <= m_current && k < m_nExtraZero)
+    {
+      shift += zeroEnd - zeroStart;
+      windowStart = zeroEnd;
+      zeroStart = m_extraZero[2 * k];
+      zeroEnd = m_extraZero[2 * k + 1];
+      zeroData = m_extraData[k];
+      k++;
+    }
+  m_zeroData = zeroData;
+  m_zeroStart = zeroStart;
+  m_zeroEnd = zeroEnd;
+  m_shift = shift;
+  m_windowStart = windowStart;
+  m_windowEnd = k < m_nExtraZero ? m_extraZero[2 * k] : 0xffffffff;
 }
 
 
@@ -837,33 +1193,59 @@ Buffer::Iterator::Write (Iterator start, Iterator end)
   NS_LOG_FUNCTION (this << &start << &end);
   NS_ASSERT (start.m_data == end.m_data);
   NS_ASSERT (start.m_current <= end.m_current);
-  NS_ASSERT (start.m_zeroStart == end.m_zeroStart);
-  NS_ASSERT (start.m_zeroEnd == end.m_zeroEnd);
+  NS_ASSERT (start.m_mainZeroStart == end.m_mainZeroStart);
+  NS_ASSERT (start.m_mainZeroEnd == end.m_mainZeroEnd);
   NS_ASSERT (m_data != start.m_data);
   uint32_t size = end.m_current - start.m_current;
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + size),
                  GetWriteErrorMessage ());
-  if (start.m_current <= start.m_zeroStart)
+  if (m_current < m_windowStart || m_current + size > m_windowEnd)
     {
-      uint32_t toCopy = std::min (size, start.m_zeroStart - start.m_current);
-      memcpy (&m_data[m_current], &start.m_data[start.m_current], toCopy);
-      start.m_current += toCopy;
-      m_current += toCopy;
-      size -= toCopy;
+      SelectWindow ();
+    }
+  uint8_t *to;
+  if (m_current <= m_zeroStart)
+    {
+      to = &m_data[m_current - m_shift];
+    }
+  else
+    {
+      to = &m_data[m_current - m_shift - (m_zeroEnd - m_zeroStart)];
     }
-  if (start.m_current <= start.m_zeroEnd)
+  m_current += size;
+  while (size > 0)
     {
-      uint32_t toCopy = std::min (size, start.m_zeroEnd - start.m_current);
-      memset (&m_data[m_current], 0, toCopy);
+      if (start.m_current < start.m_windowStart || start.m_current >= start.m_windowEnd)
+        {
+          start.SelectWindow ();
+        }
+      uint32_t toCopy;
+      if (start.m_current < start.m_zeroStart)
+        {
+          toCopy = std::min (size, start.m_zeroStart - start.m_current);
+          memcpy (to, &start.m_data[start.m_current - start.m_shift], toCopy);
+        }
+      else if (start.m_current < start.m_zeroEnd)
+        {
+          toCopy = std::min (size, start.m_zeroEnd - start.m_current);
+          if (start.m_zeroData == 0)
+            {
+              memset (to, 0, toCopy);
+            }
+          else
+            {
+              memcpy (to, &start.m_zeroData[start.m_current - start.m_zeroStart], toCopy);
+            }
+        }
+      else
+        {
+          toCopy = std::min (size, start.m_windowEnd - start.m_current);
+          memcpy (to, &start.m_data[start.m_current - start.m_shift - (start.m_zeroEnd - start.m_zeroStart)], toCopy);
+        }
       start.m_current += toCopy;
-      m_current += toCopy;
+      to += toCopy;
       size -= toCopy;
     }
-  uint32_t toCopy = std::min (size, start.m_dataEnd - start.m_current);
-  uint8_t *from = &start.m_data[start.m_current - (start.m_zeroEnd-start.m_zeroStart)];
-  uint8_t *to = &m_data[m_current];
-  memcpy (to, from, toCopy);
-  m_current += toCopy;
 }
 
 void 
@@ -953,16 +1335,20 @@ void
 Buffer::Iterator::Write (uint8_t const*buffer, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &buffer << size);
-  NS_ASSERT_MSG (CheckNoZero (m_current, size),
+  NS_ASSERT_MSG (CheckNoZero (m_current, m_current + size),
                  GetWriteErrorMessage ());
+  if (m_current < m_windowStart || m_current + size > m_windowEnd)
+    {
+      SelectWindow ();
+    }
   uint8_t *to;
   if (m_current <= m_zeroStart)
     {
-      to = &m_data[m_current];
+      to = &m_data[m_current - m_shift];
     }
   else
     {
-      to = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
+      to = &m_data[m_current - m_shift - (m_zeroEnd - m_zeroStart)];
     }
   memcpy (to, buffer, size);
   m_current += size;
@@ -1196,7 +1582,7 @@ Buffer::Iterator::GetWriteErrorMessage (void) const
     }
   else
     {
-      NS_ASSERT (m_current >= m_zeroStart && m_current < m_zeroEnd);
+      NS_ASSERT (!Check (m_current));
       str = "You have attempted to write inside the payload area of the "
         "buffer. This usually indicates that your Serialize method uses more "
         "buffer space than what your GetSerialized method returned.";
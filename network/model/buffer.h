@@ -25,8 +25,6 @@
 #include <ostream>
 #include "ns3/assert.h"
 
-#define BUFFER_FREE_LIST 1
-
 namespace ns3 {
 
 /**
@@ -88,6 +86,34 @@ namespace ns3 {
  * \endverbatim
  *
  * A simple state invariant is that m_start <= m_zeroStart <= m_zeroEnd <= m_end
+ *
+ * When a Buffer is appended to another one (Buffer::AddAtEnd (const Buffer &)),
+ * for example to build an aggregate frame or to reassemble fragments, only
+ * the real bytes of the appended buffer are copied: its virtual zero areas
+ * are kept as "extra zero areas" which follow the main zero area, so that
+ * a buffer made of the concatenation of n packets is made of n zero areas
+ * separated by their headers and trailers:
+ *
+ * \verbatim
+ * Virtual byte buffer:   |xxxx0000000000....xxxx000000000000...xx000000...|
+ *                            ^ main zero area  ^ extra zero areas
+ * \endverbatim
+ *
+ * The extra zero areas are stored in a ZeroAreas instance shared with
+ * a reference count and copied on write, like the BufferData. They are
+ * removed by RemoveAtStart and RemoveAtEnd (the first extra zero area
+ * becomes the main zero area when the main zero area is removed),
+ * and materialized only by CreateFullCopy. An Iterator works on the
+ * zero area closest to its position and looks for another one only
+ * when it moves across a zero area, so that buffers without extra zero
+ * areas are read and written as fast as before.
+ *
+ * When Buffer::EnableSharing has been called, the large runs of real
+ * bytes of an appended buffer are not copied either: they become extra
+ * areas which reference the BufferData of the appended buffer, so that
+ * an aggregate is a chain of reference-counted segments. These shared
+ * areas are read-only, like the zero areas, and they are materialized
+ * by CreateFullCopy.
  */
 class Buffer 
 {
@@ -432,6 +458,15 @@ private:
      * \warning this is the slow version, please use ReadNtohU32 (void)
      */
     uint32_t SlowReadNtohU32 (void);
+    /**
+     * Select the zero area and the window which contain m_current.
+     *
+     * The window of a zero area extends from the end of the previous
+     * zero area to the start of the next one. Positions outside of the
+     * window of the current zero area are mapped to the underlying byte
+     * buffer by selecting another zero area first.
+     */
+    void SelectWindow (void);
     /**
      * \brief Returns an appropriate message indicating a read error
      * \returns the error message
@@ -476,6 +511,47 @@ private:
      * to this pointer.
      */
     uint8_t *m_data;
+    /**
+     * offset in virtual bytes from the start of the data buffer to the
+     * start of the window in which m_zeroStart and m_zeroEnd are valid.
+     */
+    uint32_t m_windowStart;
+    /**
+     * offset in virtual bytes from the start of the data buffer to the
+     * end of the window in which m_zeroStart and m_zeroEnd are valid.
+     */
+    uint32_t m_windowEnd;
+    /**
+     * number of virtual zero bytes located before m_windowStart
+     */
+    uint32_t m_shift;
+    /**
+     * offset in virtual bytes from the start of the data buffer to the
+     * start of the main "virtual zero area".
+     */
+    uint32_t m_mainZeroStart;
+    /**
+     * offset in virtual bytes from the start of the data buffer to the
+     * end of the main "virtual zero area".
+     */
+    uint32_t m_mainZeroEnd;
+    /**
+     * the start and end offsets of the extra zero areas, or zero
+     */
+    uint32_t const *m_extraZero;
+    /**
+     * the bytes shared by each extra zero area, or zero
+     */
+    uint8_t const * const *m_extraData;
+    /**
+     * the number of extra zero areas
+     */
+    uint32_t m_nExtraZero;
+    /**
+     * the bytes of the zero area between m_zeroStart and m_zeroEnd
+     * when it is shared with another buffer, or zero.
+     */
+    uint8_t const *m_zeroData;
   };
 
   /**
@@ -518,7 +594,10 @@ private:
   /**
    * \param o the buffer to append to the end of this buffer.
    *
-   * Add bytes at the end of the Buffer.
+   * Add bytes at the end of the Buffer. The runs of real bytes of o
+   * which are at least as large as the size given to EnableSharing
+   * are shared with o instead of being copied, and cannot be written
+   * through this Buffer.
    * Any call to this method invalidates any Iterator
    * pointing to this Buffer.
    */
@@ -636,6 +715,23 @@ private:
    */
   Buffer (uint32_t dataSize, bool initialize);
   ~Buffer ();
+
+  /**
+   * \param minSize the minimum number of contiguous real bytes which
+   *        are shared instead of being copied.
+   *
+   * Enable the sharing of the real bytes of the buffers given to
+   * AddAtEnd (const Buffer &), which is disabled by default. Bytes
+   * added afterwards to the shared buffers are not affected, but the
+   * shared bytes themselves must not be written through an Iterator
+   * once they have been appended.
+   */
+  static void EnableSharing (uint32_t minSize);
+  /**
+   * Disable the sharing of the real bytes of appended buffers.
+   * The buffers which already share bytes keep them.
+   */
+  static void DisableSharing (void);
 private:
   /**
    * This data structure is variable-sized through its last member whose size
@@ -679,6 +775,60 @@ private:
     uint8_t m_data[1];
   };
 
+  /**
+   * This data structure holds the extra zero areas of a buffer, that
+   * is, the zero areas located after the main zero area. It is
+   * variable-sized through its last member, whose capacity is stored
+   * in the m_capacity field, and it is shared among the Buffer
+   * instances which reference it until one of them modifies it.
+   *
+   * An extra zero area may hold the bytes of another BufferData
+   * instead of zero bytes: it then holds a reference to that
+   * BufferData in the m_owners array, which is stored in the same
+   * memory block, after the m_areas field.
+   */
+  struct ZeroAreas
+  {
+    /**
+     * The reference count of an instance of this data structure.
+     * Each buffer which references an instance holds a count.
+     */
+    uint32_t m_count;
+    /**
+     * the size of the memory block which holds this instance
+     */
+    uint32_t m_blockSize;
+    /**
+     * the number of zero areas which fit in the m_areas field below.
+     */
+    uint32_t m_capacity;
+    /**
+     * the number of zero areas stored in the m_areas field below.
+     */
+    uint32_t m_size;
+    /**
+     * the total number of virtual bytes of these zero areas, that is,
+     * of the bytes which are not stored in the BufferData.
+     */
+    uint32_t m_zeroSize;
+    /**
+     * For each zero area, the bytes it shares with another buffer,
+     * or zero for virtual zero bytes.
+     */
+    uint8_t const **m_bytes;
+    /**
+     * For each zero area, the BufferData which holds the bytes it
+     * shares, or zero.
+     */
+    struct Data **m_owners;
+    /**
+     * The start and end offsets of each zero area, in increasing
+     * order. Zero areas do not overlap, and only an area which shares
+     * bytes may touch another one.
+     */
+    uint32_t m_areas[2];
+  };
+
   /**
    * \brief Create a full copy of the buffer, including
    * all the internal structures.
@@ -743,7 +893,76 @@ private:
    */
   static void Deallocate (struct Buffer::Data *data);
 
+  /**
+   * \brief Release a reference to a set of extra zero areas
+   * \param areas the extra zero areas, or zero
+   */
+  static void ReleaseZeroAreas (struct Buffer::ZeroAreas *areas);
+  /**
+   * \brief Release the reference held by a zero area which shares bytes
+   * \param owner the buffer data storage of the shared bytes, or zero
+   */
+  static void ReleaseOwner (struct Buffer::Data *owner);
+  /**
+   * \brief Keep only some of the extra zero areas
+   *
+   * Make sure that the extra zero areas of this buffer are not
+   * shared with another buffer before they are modified.
+   *
+   * \param first the index of the first extra zero area to keep
+   * \param last the index after the last extra zero area to keep
+   * \param capacity the minimum number of zero areas which must fit
+   *        in the storage, to be able to add zero areas.
+   */
+  void SetZeroAreas (uint32_t first, uint32_t last, uint32_t capacity);
+  /**
+   * \brief Move all the extra zero areas
+   * \param delta the number of bytes to add to their offsets
+   */
+  void ShiftZeroAreas (int32_t delta);
+  /**
+   * \brief Make the first extra zero area the main zero area
+   *
+   * The main zero area must be empty, and the first extra zero area
+   * must not share bytes.
+   */
+  void PromoteZeroArea (void);
+  /**
+   * \brief Insert virtual bytes after the last zero area
+   * \param start the offset of the new bytes, which must be
+   *        located after the last zero area.
+   * \param size the number of bytes to insert
+   * \param bytes the bytes to share, or zero to insert zero bytes
+   * \param owner the BufferData which holds the shared bytes, or zero
+   */
+  void AddZeroArea (uint32_t start, uint32_t size,
+                    uint8_t const *bytes, struct Data *owner);
+  /**
+   * \param i the index of a zero area: 0 is the main zero area, 1 is
+   *        the first extra zero area. The zero area after the last one
+   *        is an empty zero area at the end of the buffer.
+   * \param start the offset of the start of the zero area
+   * \param end the offset of the end of the zero area
+   */
+  void GetZeroArea (uint32_t i, uint32_t &start, uint32_t &end) const;
+  /**
+   * \param i the index of a zero area, as in GetZeroArea
+   * \returns the bytes shared by the zero area, or zero if it holds
+   *          zero bytes.
+   */
+  uint8_t const *GetZeroAreaData (uint32_t i) const;
+  /**
+   * \returns the number of extra zero areas
+   */
+  uint32_t GetNZeroAreas (void) const;
+  /**
+   * \returns a copy of this buffer in which the extra zero areas are
+   *          replaced by real bytes.
+   */
+  Buffer CreateMainZeroAreaCopy (void) const;
+
   struct Data *m_data; //!< the buffer data storage
+  struct ZeroAreas *m_zeroAreas; //!< the extra zero areas, or zero
 
   /**
    * keep track of the maximum value of m_zeroAreaStart across
@@ -762,6 +981,12 @@ private:
    * value.
    */
   static uint32_t g_recommendedStart;
+  /**
+   * the minimum number of contiguous real bytes which AddAtEnd
+   * (const Buffer &) shares instead of copying them, or zero if
+   * the sharing is disabled.
+   */
+  static uint32_t g_minSharedSize;
 
   /**
    * offset to the start of the virtual zero area from the start
@@ -783,19 +1008,6 @@ private:
    * instance from the start of m_data->m_data
    */
   uint32_t m_end;
-
-#ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  /// Local static destructor structure
-  struct LocalStaticDestructor 
-  {
-    ~LocalStaticDestructor ();
-  };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
-#endif
 };
 
 } // namespace ns3
@@ -811,7 +1023,16 @@ Buffer::Iterator::Iterator ()
     m_dataStart (0),
     m_dataEnd (0),
     m_current (0),
-    m_data (0)
+    m_data (0),
+    m_windowStart (0),
+    m_windowEnd (0xffffffff),
+    m_shift (0),
+    m_mainZeroStart (0),
+    m_mainZeroEnd (0),
+    m_extraZero (0),
+    m_extraData (0),
+    m_nExtraZero (0),
+    m_zeroData (0)
 {
 }
 Buffer::Iterator::Iterator (Buffer const*buffer)
@@ -823,6 +1044,10 @@ Buffer::Iterator::Iterator (Buffer const*buffer, bool dummy)
 {
   Construct (buffer);
   m_current = m_dataEnd;
+  if (m_extraZero != 0)
+    {
+      SelectWindow ();
+    }
 }
 
 void
@@ -833,6 +1058,25 @@ Buffer::Iterator::Construct (const Buffer *buffer)
   m_dataStart = buffer->m_start;
   m_dataEnd = buffer->m_end;
   m_data = buffer->m_data->m_data;
+  m_windowStart = 0;
+  m_shift = 0;
+  m_mainZeroStart = m_zeroStart;
+  m_mainZeroEnd = m_zeroEnd;
+  m_zeroData = 0;
+  if (buffer->m_zeroAreas == 0)
+    {
+      m_windowEnd = 0xffffffff;
+      m_extraZero = 0;
+      m_extraData = 0;
+      m_nExtraZero = 0;
+    }
+  else
+    {
+      m_extraZero = buffer->m_zeroAreas->m_areas;
+      m_extraData = buffer->m_zeroAreas->m_bytes;
+      m_nExtraZero = buffer->m_zeroAreas->m_size;
+      m_windowEnd = m_extraZero[0];
+    }
 }
 
 void 
@@ -865,14 +1109,18 @@ Buffer::Iterator::WriteU8 (uint8_t data)
   NS_ASSERT_MSG (Check (m_current),
                  GetWriteErrorMessage ());
 
+  if (m_current < m_windowStart || m_current >= m_windowEnd)
+    {
+      SelectWindow ();
+    }
   if (m_current < m_zeroStart)
     {
-      m_data[m_current] = data;
+      m_data[m_current - m_shift] = data;
       m_current++;
     }
   else
     {
-      m_data[m_current - (m_zeroEnd-m_zeroStart)] = data;
+      m_data[m_current - m_shift - (m_zeroEnd-m_zeroStart)] = data;
       m_current++;
     }
 }
@@ -882,14 +1130,18 @@ Buffer::Iterator::WriteU8 (uint8_t  data, uint32_t len)
 {
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + len),
                  GetWriteErrorMessage ());
+  if (m_current < m_windowStart || m_current + len > m_windowEnd)
+    {
+      SelectWindow ();
+    }
   if (m_current <= m_zeroStart)
     {
-      std::memset (&(m_data[m_current]), data, len);
+      std::memset (&(m_data[m_current - m_shift]), data, len);
       m_current += len;
     }
   else
     {
-      uint8_t *buffer = &m_data[m_current - (m_zeroEnd-m_zeroStart)];
+      uint8_t *buffer = &m_data[m_current - m_shift - (m_zeroEnd-m_zeroStart)];
       std::memset (buffer, data, len);
       m_current += len;
     }
@@ -900,14 +1152,18 @@ Buffer::Iterator::WriteHtonU16 (uint16_t data)
 {
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + 2),
                  GetWriteErrorMessage ());
+  if (m_current < m_windowStart || m_current + 2 > m_windowEnd)
+    {
+      SelectWindow ();
+    }
   uint8_t *buffer;
   if (m_current + 2 <= m_zeroStart)
     {
-      buffer = &m_data[m_current];
+      buffer = &m_data[m_current - m_shift];
     }
   else
     {
-      buffer = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
+      buffer = &m_data[m_current - m_shift - (m_zeroEnd - m_zeroStart)];
     }
   buffer[0] = (data >> 8)& 0xff;
   buffer[1] = (data >> 0)& 0xff;
@@ -919,15 +1175,19 @@ Buffer::Iterator::WriteHtonU32 (uint32_t data)
 {
   NS_ASSERT_MSG (CheckNoZero (m_current, m_current + 4),
                  GetWriteErrorMessage ());
+  if (m_current < m_windowStart || m_current + 4 > m_windowEnd)
+    {
+      SelectWindow ();
+    }
 
   uint8_t *buffer;
   if (m_current + 4 <= m_zeroStart)
     {
-      buffer = &m_data[m_current];
+      buffer = &m_data[m_current - m_shift];
     }
   else
     {
-      buffer = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
+      buffer = &m_data[m_current - m_shift - (m_zeroEnd - m_zeroStart)];
     }
   buffer[0] = (data >> 24)& 0xff;
   buffer[1] = (data >> 16)& 0xff;
@@ -940,13 +1200,13 @@ uint16_t
 Buffer::Iterator::ReadNtohU16 (void)
 {
   uint8_t *buffer;
-  if (m_current + 2 <= m_zeroStart)
+  if (m_current + 2 <= m_zeroStart && m_current >= m_windowStart)
     {
-      buffer = &m_data[m_current];
+      buffer = &m_data[m_current - m_shift];
     }
-  else if (m_current >= m_zeroEnd)
+  else if (m_current >= m_zeroEnd && m_current + 2 <= m_windowEnd)
     {
-      buffer = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
+      buffer = &m_data[m_current - m_shift - (m_zeroEnd - m_zeroStart)];
     }
   else
     {
@@ -964,13 +1224,13 @@ uint32_t
 Buffer::Iterator::ReadNtohU32 (void)
 {
   uint8_t *buffer;
-  if (m_current + 4 <= m_zeroStart)
+  if (m_current + 4 <= m_zeroStart && m_current >= m_windowStart)
     {
-      buffer = &m_data[m_current];
+      buffer = &m_data[m_current - m_shift];
     }
-  else if (m_current >= m_zeroEnd)
+  else if (m_current >= m_zeroEnd && m_current + 4 <= m_windowEnd)
     {
-      buffer = &m_data[m_current - (m_zeroEnd - m_zeroStart)];
+      buffer = &m_data[m_current - m_shift - (m_zeroEnd - m_zeroStart)];
     }
   else
     {
@@ -995,18 +1255,22 @@ Buffer::Iterator::PeekU8 (void)
                  m_current < m_dataEnd,
                  GetReadErrorMessage ());
 
+  if (m_current < m_windowStart || m_current >= m_windowEnd)
+    {
+      SelectWindow ();
+    }
   if (m_current < m_zeroStart)
     {
-      uint8_t data = m_data[m_current];
+      uint8_t data = m_data[m_current - m_shift];
       return data;
     }
   else if (m_current < m_zeroEnd)
     {
-      return 0;
+      return m_zeroData == 0 ? 0 : m_zeroData[m_current - m_zeroStart];
     }
   else
     {
-      uint8_t data = m_data[m_current - (m_zeroEnd-m_zeroStart)];
+      uint8_t data = m_data[m_current - m_shift - (m_zeroEnd-m_zeroStart)];
       return data;
     }
 }
@@ -1043,6 +1307,7 @@ Buffer::Iterator::Read (Buffer::Iterator start, uint32_t size)
 
 Buffer::Buffer (Buffer const&o)
   : m_data (o.m_data),
+    m_zeroAreas (o.m_zeroAreas),
     m_maxZeroAreaStart (o.m_zeroAreaStart),
     m_zeroAreaStart (o.m_zeroAreaStart),
     m_zeroAreaEnd (o.m_zeroAreaEnd),
@@ -1050,6 +1315,10 @@ Buffer::Buffer (Buffer const&o)
     m_end (o.m_end)
 {
   m_data->m_count++;
+  if (m_zeroAreas != 0)
+    {
+      m_zeroAreas->m_count++;
+    }
   NS_ASSERT (CheckInternalState ());
 }
 
@@ -20,269 +20,222 @@
 
 /**
 \file   packet-tag-list.cc
-\brief  Implements a linked list of Packet tags, including copy-on-write semantics.
+\brief  Implements a list of Packet tags, including copy-on-write semantics.
 */
 
+
 #include "packet-tag-list.h"
 #include "tag-buffer.h"
 #include "tag.h"
+#include "slab-allocator.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
 #include <cstring>
+#include <new>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
-bool
-PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
+uint64_t
+PacketTagList::GetMaskBit (TypeId tid)
 {
-  TypeId tid = tag.GetInstanceTypeId ();
-  NS_LOG_FUNCTION (this << tid);
-  NS_LOG_INFO     ("looking for " << tid);
+  return ((uint64_t)1) << (tid.GetUid () & 63);
+}
 
-  // trivial case when list is empty
-  if (m_next == 0)
+uint32_t
+PacketTagList::Find (TypeId tid) const
+{
+  uint32_t n = GetNTags ();
+  if ((m_mask & GetMaskBit (tid)) == 0)
     {
-      return false;
+      return n;
     }
-
-  bool found = false;
-
-  struct TagData ** prevNext = &m_next; // previous node's next pointer
-  struct TagData  * cur      =  m_next; // cursor to current node
-  struct TagData  * it = 0;             // utility
-
-  // Search from the head of the list until we find tid or a merge
-  while (cur != 0)
+  for (uint32_t i = 0; i < n; i++)
     {
-      if (cur->count > 1)
-        {
-          // found merge
-          NS_LOG_INFO ("found initial merge before tid");
-          break;
-        }
-      else if (cur->tid == tid)
-        {
-          NS_LOG_INFO ("found tid before initial merge, calling writer");
-          found = (this->*Writer)(tag, true, cur, prevNext);
-          break;
-        }
-      else
+      if (GetTag (i)->tid == tid)
         {
-          // no merge or tid found yet, move on
-          prevNext = &cur->next;
-          cur      =  cur->next;
+          return i;
         }
-    }  // while !found && !cow
-
-  // did we find it or run out of tags?
-  if (cur == 0 || found)
-    {
-      NS_LOG_INFO ("returning after header with found: " << found);
-      return found;
     }
+  return n;
+}
 
-  // From here on out, we have to copy the list
-  // until we find tid, then link past it
-
-  // Before we do all that work, let's make sure tid really exists
-  for (it = cur; it != 0; it = it->next)
+void
+PacketTagList::PrepareOverflow (uint32_t extra)
+{
+  NS_LOG_FUNCTION (this << extra);
+  uint32_t size = 0;
+  uint32_t capacity = INLINE_SIZE;
+  if (m_overflow != 0)
     {
-      if (it->tid == tid)
+      size = m_overflow->size;
+      capacity = m_overflow->capacity;
+      if (m_overflow->count == 1 && capacity >= size + extra)
         {
-          break;
+          return;
         }
     }
-  if (it == 0)
+  while (capacity < size + extra)
     {
-      // got to end of list without finding tid
-      NS_LOG_INFO ("tid not found after first merge");
-      return found;
+      capacity *= 2;
     }
-
-  // At this point cur is a merge, but untested for tid
-  NS_ASSERT (cur != 0);
-  NS_ASSERT (cur->count > 1);
-
-  /*
-     Walk the remainder of the list, copying, until we find tid
-     As we put a copy of the cur node onto our list,
-     we move the merge point down the list.
-
-     Starting position                  End position
-       T1 is a merge                     T1.count decremented
-                                         T2 is a merge
-                                         T1' is a copy of T1
-
-          other                             other
-               \                                 \
-      Prev  ->  T1  ->  T2  -> ...                T1  ->  T2  -> ...
-           /   /                                         /|
-      pNext cur                         Prev  ->  T1' --/ |
-                                                     /    |
-                                                pNext   cur
-
-     When we reach tid, we link past it, decrement count, and we're done.
-  */
-
-  // Should normally check for null cur pointer,
-  // but since we know tid exists, we'll skip this test
-  while ( /* cur && */ cur->tid != tid)
+  uint32_t blockSize = sizeof (struct TagOverflow) + (capacity - 1) * sizeof (struct TagData);
+  uint8_t *buffer = SlabAllocator::Allocate (blockSize);
+  struct TagOverflow *overflow = reinterpret_cast<struct TagOverflow *> (buffer);
+  overflow->count = 1;
+  overflow->size = size;
+  // use the whole block returned by the allocator
+  overflow->capacity = (blockSize - sizeof (struct TagOverflow)) / sizeof (struct TagData) + 1;
+  overflow->blockSize = blockSize;
+  for (uint32_t i = 0; i < overflow->capacity; i++)
     {
-      NS_ASSERT (cur != 0);
-      NS_ASSERT (cur->count > 1);
-      cur->count--;                       // unmerge cur
-      struct TagData * copy = new struct TagData ();
-      copy->tid = cur->tid;
-      copy->count = 1;
-      memcpy (copy->data, cur->data, TagData::MAX_SIZE);
-      copy->next = cur->next;             // merge into tail
-      copy->next->count++;                // mark new merge
-      *prevNext = copy;                   // point prior list at copy
-      prevNext = &copy->next;             // advance
-      cur      =  copy->next;
+      new (&overflow->tags[i]) TagData ();
     }
-  // Sanity check:
-  NS_ASSERT (cur != 0);                 // cur should be non-zero
-  NS_ASSERT (cur->tid == tid);          // cur->tid should be tid
-  NS_ASSERT (cur->count > 1);           // cur should be a merge
-
-  // link around tid, removing it from our list
-  found = (this->*Writer)(tag, false, cur, prevNext);
-  return found;
-
+  for (uint32_t i = 0; i < size; i++)
+    {
+      overflow->tags[i] = m_overflow->tags[i];
+    }
+  if (m_overflow != 0)
+    {
+      ReleaseOverflow ();
+    }
+  m_overflow = overflow;
 }
 
-bool
-PacketTagList::Remove (Tag & tag)
+void
+PacketTagList::ReleaseOverflow (void)
 {
-  return COWTraverse (tag, &PacketTagList::RemoveWriter);
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_overflow != 0);
+  m_overflow->count--;
+  if (m_overflow->count == 0)
+    {
+      SlabAllocator::Deallocate (reinterpret_cast<uint8_t *> (m_overflow),
+                                 m_overflow->blockSize);
+    }
+  m_overflow = 0;
 }
 
-// COWWriter implementing Remove
-bool
-PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
-                             struct PacketTagList::TagData  * cur,
-                             struct PacketTagList::TagData ** prevNext)
+void
+PacketTagList::UpdateMask (void)
 {
-  NS_LOG_FUNCTION_NOARGS ();
+  m_mask = 0;
+  uint32_t n = GetNTags ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      m_mask |= GetMaskBit (GetTag (i)->tid);
+    }
+}
 
-  // found tid
-  bool found = true;
-  tag.Deserialize (TagBuffer (cur->data,
-                              cur->data + TagData::MAX_SIZE));
-  *prevNext = cur->next;            // link around cur
+void 
+PacketTagList::Add (const Tag &tag) const
+{
+  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
+  TypeId tid = tag.GetInstanceTypeId ();
+  // ensure this id was not yet added
+  NS_ASSERT (Find (tid) == GetNTags ());
+  NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
 
-  if (preMerge)
+  // adding a tag does not change the value of the other tags
+  PacketTagList *self = const_cast<PacketTagList *> (this);
+  struct TagData *data;
+  if (m_overflow == 0 && m_size < INLINE_SIZE)
     {
-      // found tid before first merge, so delete cur
-      delete cur;
+      data = &self->m_tags[m_size];
+      self->m_size++;
     }
   else
     {
-      // cur is always a merge at this point
-      // unmerge cur, since we linked around it already
-      cur->count--;
-      if (cur->next != 0)
-        {
-          // there's a next, so make it a merge
-          cur->next->count++;
-        }
+      self->PrepareOverflow (1);
+      data = &m_overflow->tags[m_overflow->size];
+      m_overflow->size++;
     }
-  return found;
+  data->tid = tid;
+  tag.Serialize (TagBuffer (data->data, data->data + tag.GetSerializedSize ()));
+  self->m_mask |= GetMaskBit (tid);
 }
 
 bool
-PacketTagList::Replace (Tag & tag)
+PacketTagList::Remove (Tag & tag)
 {
-  bool found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
-  if (!found)
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  uint32_t i = Find (tid);
+  if (i == GetNTags ())
     {
-      Add (tag);
+      return false;
     }
-  return found;
-}
-
-// COWWriter implementing Replace
-bool
-PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
-                              struct PacketTagList::TagData  * cur,
-                              struct PacketTagList::TagData ** prevNext)
-{
-  NS_LOG_FUNCTION_NOARGS ();
-
-  // found tid
-  bool found = true;
-  if (preMerge)
+  const struct TagData *data = GetTag (i);
+  tag.Deserialize (TagBuffer (const_cast<uint8_t *> (data->data),
+                              const_cast<uint8_t *> (data->data) + TagData::MAX_SIZE));
+  if (i < m_size)
     {
-      // found tid before first merge, so just rewrite
-      tag.Serialize (TagBuffer (cur->data,
-                                cur->data + tag.GetSerializedSize ()));
+      for (uint32_t j = i + 1; j < m_size; j++)
+        {
+          m_tags[j - 1] = m_tags[j];
+        }
+      m_size--;
     }
   else
     {
-      // cur is always a merge at this point
-      // need to copy, replace, and link past cur
-      cur->count--;                     // unmerge cur
-      struct TagData * copy = new struct TagData ();
-      copy->tid = tag.GetInstanceTypeId ();
-      copy->count = 1;
-      tag.Serialize (TagBuffer (copy->data,
-                                copy->data + tag.GetSerializedSize ()));
-      copy->next = cur->next;           // merge into tail
-      if (copy->next != 0)
+      PrepareOverflow (0);
+      for (uint32_t j = i - m_size + 1; j < m_overflow->size; j++)
         {
-          copy->next->count++;          // mark new merge
+          m_overflow->tags[j - 1] = m_overflow->tags[j];
+        }
+      m_overflow->size--;
+      if (m_overflow->size == 0)
+        {
+          ReleaseOverflow ();
         }
-      *prevNext = copy;                 // point prior list at copy
     }
-  return found;
+  UpdateMask ();
+  return true;
 }
 
-void 
-PacketTagList::Add (const Tag &tag) const
+bool
+PacketTagList::Replace (Tag & tag)
 {
-  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
-  // ensure this id was not yet added
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  uint32_t i = Find (tid);
+  if (i == GetNTags ())
     {
-      NS_ASSERT (cur->tid != tag.GetInstanceTypeId ());
+      Add (tag);
+      return false;
     }
-  struct TagData * head = new struct TagData ();
-  head->count = 1;
-  head->next = 0;
-  head->tid = tag.GetInstanceTypeId ();
-  head->next = m_next;
   NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
-  tag.Serialize (TagBuffer (head->data, head->data + tag.GetSerializedSize ()));
-
-  const_cast<PacketTagList *> (this)->m_next = head;
+  struct TagData *data;
+  if (i < m_size)
+    {
+      data = &m_tags[i];
+    }
+  else
+    {
+      PrepareOverflow (0);
+      data = &m_overflow->tags[i - m_size];
+    }
+  tag.Serialize (TagBuffer (data->data, data->data + tag.GetSerializedSize ()));
+  return true;
 }
 
 bool
 PacketTagList::Peek (Tag &tag) const
 {
-  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  NS_LOG_FUNCTION (this << tid);
+  uint32_t i = Find (tid);
+  if (i == GetNTags ())
     {
-      if (cur->tid == tid) 
-        {
-          /* found tag */
-          tag.Deserialize (TagBuffer (cur->data, cur->data + TagData::MAX_SIZE));
-          return true;
-        }
+      /* no tag found */
+      return false;
     }
-  /* no tag found */
-  return false;
-}
-
-const struct PacketTagList::TagData *
-PacketTagList::Head (void) const
-{
-  return m_next;
+  /* found tag */
+  const struct TagData *data = GetTag (i);
+  tag.Deserialize (TagBuffer (const_cast<uint8_t *> (data->data),
+                              const_cast<uint8_t *> (data->data) + TagData::MAX_SIZE));
+  return true;
 }
 
 } /* namespace ns3 */
-
@@ -22,7 +22,7 @@
 
 /**
 \file   packet-tag-list.h
-\brief  Defines a linked list of Packet tags, including copy-on-write semantics.
+\brief  Defines a list of Packet tags, including copy-on-write semantics.
 */
 
 #include <stdint.h>
@@ -43,82 +43,33 @@ class Tag;
  *
  * \internal
  *
- * The implementation of this class is a bit tricky.  Refer to this
- * diagram in the discussion that follows.
+ * Packets usually carry only a few packet tags, which are added,
+ * looked up and removed at every layer for every packet, so the list
+ * is optimized for this case:
  *
- * \dot
- *    digraph {
- *        rankdir = "LR";
- *        clusterrank = local;
- *        node [ shape = record, fontname="FreeSans", fontsize="10" ];
- *        oth  [ label="<l> Other branch | <n> next | <c> ..." ];
- *        PTL1 [ label="<l> PacketTagList A | <n> m_next" , shape=Mrecord];
- *        PTL2 [ label="<l> PacketTagList B | <n> m_next" , shape=Mrecord];
- *        oth:n  -> T7:l ;
- *        PTL2:n -> T6:l ;
- *        PTL1:n -> T5:l ;
- *        T1   [ label="<l> T1  | <n> next | <c> count = 1" ];
- *        T2   [ label="<l> T2  | <n> next | <c> count = 1" ];
- *        T3   [ label="<l> T3  | <n> next | <c> count = 2" ];
- *        T4   [ label="<l> T4  | <n> next | <c> count = 1" ];
- *        T5   [ label="<l> T5  | <n> next | <c> count = 2" ];
- *        T6   [ label="<l> T6  | <n> next | <c> count = 1" ];
- *        T7   [ label="<l> T7  | <n> next | <c> count = 1" ];
- *        NULL [ label="0", shape = ellipse ];
- *        subgraph cluster_list {
- *          penwidth = 0;
- *          T6:n -> T5:l ;
- *          T5:n -> T4:l ;
- *          T4:n -> T3:l ;
- *          T7:n -> T3:l ;
- *          T3:n -> T2:l ;
- *          T2:n -> T1:l ;
- *          T1:n -> NULL ;
- *        };
- *      };
- * \enddot
+ *   - Tags are stored in serialized form in TagData structures.
  *
- *   - Tags are stored in serialized form in a tree of TagData
- *     structures. (<tt>T1-T7</tt> in the diagram)
+ *   - The first #INLINE_SIZE tags are stored in an array inside the
+ *     PacketTagList itself, hence inside the Packet: adding them does
+ *     not allocate any memory.  Copying a PacketTagList copies the
+ *     tags stored inline.
  *
- *   - Each TagData points (\c next pointers in the diagram)
- *     toward the root of the tree, which is a null pointer.
+ *   - The following tags are stored in an overflow block allocated
+ *     from the SlabAllocator.  The overflow block is shared by the
+ *     copies of a PacketTagList, and is reference counted: it is
+ *     copied before a tag is added, removed or replaced in a list
+ *     which shares it with other lists (copy-on-write).
  *
- *   - \c count is the number of incoming pointers to this
- *     TagData.  Branch points, where branches merge or join, have
- *     <tt>count \> 1</tt> (\c T3, \c T5); successive links along
- *     a branch have <tt>count = 1</tt> (\c T1, \c T2, \c T4, \c T6, \c T7).
+ *   - The list keeps a 64-bit mask of the tags it holds, indexed by
+ *     the low bits of the TypeId uid of the tags.  #Peek, #Remove and
+ *     #Replace of a tag which is not in the list, by far the most
+ *     common case, are answered from this mask in constant time.
+ *     Otherwise, the small arrays of tags are searched.
  *
- *   - Each PacketTagList points to a specific TagData,
- *     which is the most recent Tag added to the packet. (<tt>T5-T7</tt>)
- *
- *   - Conceptually, therefore, each Packet has a PacketTagList which
- *     points to a singly-linked list of TagData.
- *
- * \par <b> Copy-on-write </b> is implemented as follows:
- *
- *   - #Add prepends the new tag to the list (growing that branch of the tree,
- *     as \c T6). This is a constant time operation, and does not affect
- *     any other #PacketTagList's, hence this is a \c const function.
- *
- *   - Copy constructor (PacketTagList(const PacketTagList & o))
- *     and assignment (#operator=(const PacketTagList & o)
- *     simply join the tree at the same place as the original
- *     PacketTagList \c o, incrementing the \c count.
- *     For assignment, the old branch is deleted, up to
- *     the first branch point, which has its \c count decremented.
- *     (PacketTagList \c B started as a copy of PacketTagList \c A,
- *     before \c T6 was added to \c B).
- *
- *   - #Remove and #Replace are a little tricky, depending on where the
- *     target tag is found relative to the first branch point:
- *     - \e Target before <em> the first branch point: </em> \n
- *       The target is just dealt with in place (linked around and deleted,
- *       in the case of #Remove; rewritten in the case of #Replace).
- *     - \e Target at or after <em> the first branch point: </em> \n
- *       The portion of the list between the first branch and the target is
- *       shared. This portion is copied before the #Remove or #Replace is
- *       performed.
+ *   - The tags are kept in the order in which they were added: the
+ *     inline tags come first, followed by the tags of the overflow
+ *     block.  Once the list has an overflow block, new tags are
+ *     appended to it until it becomes empty.
  *
  * \par <b> Memory Management: </b>
  * \n
@@ -130,9 +81,7 @@ class PacketTagList
 {
 public:
   /**
-   * Tree node for sharing serialized tags.
-   *
-   * See PacketTagList for a discussion of the data structure.
+   * Serialized tag.
    *
    * See TagData::TagData_e for a discussion of the size limit on
    * tag serialization.
@@ -146,15 +95,10 @@ public:
      * in this constant.
      *
      * \internal
-     * Ideally, TagData would be 32 bytes in size, so they require
-     * no padding on 64-bit architectures.  (The architecture
-     * affects the size because of the \c #next pointer.)
-     * This would leave 18 bytes for \c #data.  However,
-     * ns3:Ipv6PacketInfoTag needs 19 bytes!  The current
-     * implementation allows 20 bytes, which gives TagData
-     * a size of 30 bytes on 32-byte machines (which gets
-     * padded with 2 bytes), and 34 bytes on 64-bit machines, which
-     * gets padded to 40 bytes.
+     * ns3:Ipv6PacketInfoTag needs 19 bytes.  The current
+     * implementation allows 21 bytes which, with the 2 bytes of
+     * the TypeId and 1 byte of padding, gives TagData a size of
+     * 24 bytes on every architecture.
      */
     enum TagData_e
     {
@@ -162,11 +106,17 @@ public:
   };
 
     uint8_t data[MAX_SIZE];   /**< Serialization buffer */
-    struct TagData * next;   /**< Pointer to next in list */
     TypeId tid;               /**< Type of the tag serialized into #data */
-    uint32_t count;           /**< Number of incoming links */
   };  /* struct TagData */
 
+  /**
+   * Number of tags stored inside the PacketTagList.
+   */
+  enum
+  {
+    INLINE_SIZE = 4
+  };
+
   /**
    * Create a new PacketTagList.
    */
@@ -176,8 +126,8 @@ public:
    *
    * \param [in] o The PacketTagList to copy.
    *
-   * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * This copies the inline tags of \pname{o} and shares its
+   * overflow block.
    */
   inline PacketTagList (PacketTagList const &o);
   /**
@@ -187,18 +137,19 @@ public:
    * \returns the copied object
    *
    * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * copying the inline tags of \pname{o} and sharing its
+   * overflow block.
    */
   inline PacketTagList &operator = (PacketTagList const &o);
   /**
    * Destructor
    *
-   * #RemoveAll's the tags up to the first merge.
+   * #RemoveAll's the tags.
    */
   inline ~PacketTagList ();
 
   /**
-   * Add a tag to the head of this branch.
+   * Add a tag at the end of the list.
    *
    * \param [in] tag The tag to add
    */
@@ -230,67 +181,66 @@ public:
    */
   bool Peek (Tag &tag) const;
   /**
-   * Remove all tags from this list (up to the first merge).
+   * Remove all tags from this list.
    */
   inline void RemoveAll (void);
   /**
-   * \returns pointer to head of tag list
+   * \returns the number of tags in the list
+   */
+  inline uint32_t GetNTags (void) const;
+  /**
+   * \param [in] i The index of the tag, in the order in which the
+   *        tags were added, smaller than #GetNTags.
+   * \returns the tag
    */
-  const struct PacketTagList::TagData *Head (void) const;
+  inline const struct PacketTagList::TagData *GetTag (uint32_t i) const;
 
 private:
   /**
-   * Typedef of method function pointer for copy-on-write operations
-   *
-   * \param [in] tag The tag type to operate on.
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *             false otherwise.
-   * \param [in] cur Pointer to the tag.
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True if operation successful, false otherwise
+   * Overflow block, shared by copy-on-write.
    */
-  typedef bool (PacketTagList::*COWWriter)
-    (Tag       & tag, bool         preMerge,
-    struct TagData * cur, struct TagData ** prevNext);
+  struct TagOverflow
+  {
+    uint32_t count;           /**< Number of lists sharing this block */
+    uint32_t size;            /**< Number of tags in #tags */
+    uint32_t capacity;        /**< Number of tags which fit in #tags */
+    uint32_t blockSize;       /**< Size of the block, for the SlabAllocator */
+    struct TagData tags[1];   /**< The tags */
+  };
+
   /**
-   * Traverse the list implementing copy-on-write, using \pname{Writer}.
-   *
-   * \param [in] tag The tag type to operate on.
-   * \param [in] Writer The copy-on-write function to use.
-   * \returns True if \pname{tag} found, false otherwise.
+   * \param [in] tid The TypeId of a tag.
+   * \returns the bit of #m_mask associated to \pname{tid}.
    */
-  bool COWTraverse   (Tag & tag, PacketTagList::COWWriter Writer);
+  static uint64_t GetMaskBit (TypeId tid);
   /**
-   * Copy-on-write implementing Remove.
+   * Find a tag.
    *
-   * \param [in] tag The target tag type to remove.
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *             false otherwise.
-   * \param [in] cur Pointer to the tag.
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True, since tag will definitely be removed.
+   * \param [in] tid The TypeId of the tag.
+   * \returns the index of the tag in the list, or #GetNTags if
+   *          the tag is not in the list.
    */
-  bool RemoveWriter  (Tag       & tag, bool         preMerge,
-                      struct TagData * cur, struct TagData ** prevNext);
+  uint32_t Find (TypeId tid) const;
   /**
-   * Copy-on-write implementing Replace
+   * Make sure that the overflow block is not shared and has room
+   * for more tags, copying it if needed.
    *
-   * \param [in] tag The target tag type to replace
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *          false otherwise.
-   * \param [in] cur Pointer to the tag
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True, since tag value will definitely be replaced.
+   * \param [in] extra The number of tags which will be appended.
    */
-  bool ReplaceWriter (Tag & tag, bool preMerge, struct TagData * cur, struct TagData ** prevNext);
-
+  void PrepareOverflow (uint32_t extra);
   /**
-   * Pointer to first \ref TagData on the list
+   * Drop this list's reference to its overflow block.
    */
-  struct TagData *m_next;
+  void ReleaseOverflow (void);
+  /**
+   * Recompute #m_mask from the tags in the list.
+   */
+  void UpdateMask (void);
+
+  struct TagData m_tags[INLINE_SIZE];  //!< The first tags of the list
+  struct TagOverflow *m_overflow;      //!< The other tags, or 0
+  uint32_t m_size;                     //!< Number of tags in #m_tags
+  uint64_t m_mask;                     //!< Mask of the tags in the list
 };
 
 } // namespace ns3
@@ -302,16 +252,24 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_overflow (0),
+    m_size (0),
+    m_mask (0)
 {
 }
 
 PacketTagList::PacketTagList (PacketTagList const &o)
-  : m_next (o.m_next)
+  : m_overflow (o.m_overflow),
+    m_size (o.m_size),
+    m_mask (o.m_mask)
 {
-  if (m_next != 0)
+  for (uint32_t i = 0; i < m_size; i++)
     {
-      m_next->count++;
+      m_tags[i] = o.m_tags[i];
+    }
+  if (m_overflow != 0)
+    {
+      m_overflow->count++;
     }
 }
 
@@ -319,15 +277,21 @@ PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (this == &o) 
     {
       return *this;
     }
   RemoveAll ();
-  m_next = o.m_next;
-  if (m_next != 0) 
+  m_size = o.m_size;
+  m_mask = o.m_mask;
+  for (uint32_t i = 0; i < m_size; i++)
+    {
+      m_tags[i] = o.m_tags[i];
+    }
+  m_overflow = o.m_overflow;
+  if (m_overflow != 0) 
     {
-      m_next->count++;
+      m_overflow->count++;
     }
   return *this;
 }
@@ -340,25 +304,32 @@ PacketTagList::~PacketTagList ()
 void
 PacketTagList::RemoveAll (void)
 {
-  struct TagData *prev = 0;
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+  m_size = 0;
+  m_mask = 0;
+  if (m_overflow != 0)
     {
-      cur->count--;
-      if (cur->count > 0) 
-        {
-          break;
-        }
-      if (prev != 0) 
-        {
-	  delete prev;
-        }
-      prev = cur;
+      ReleaseOverflow ();
     }
-  if (prev != 0) 
+}
+
+uint32_t
+PacketTagList::GetNTags (void) const
+{
+  if (m_overflow != 0)
+    {
+      return m_size + m_overflow->size;
+    }
+  return m_size;
+}
+
+const struct PacketTagList::TagData *
+PacketTagList::GetTag (uint32_t i) const
+{
+  if (i < m_size)
     {
-      delete prev;
+      return &m_tags[i];
     }
-  m_next = 0;
+  return &m_overflow->tags[i - m_size];
 }
 
 } // namespace ns3
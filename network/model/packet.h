@@ -169,10 +169,11 @@ private:
   friend class Packet;
   /**
    * Constructor
-   * \param head head of the items
+   * \param list the list of the items
    */
-  PacketTagIterator (const struct PacketTagList::TagData *head);
-  const struct PacketTagList::TagData *m_current;  //!< actual position over the set of tags in a packet
+  PacketTagIterator (const PacketTagList *list);
+  const PacketTagList *m_list;  //!< the set of tags in a packet
+  uint32_t m_current;  //!< number of tags not visited yet
 };
 
 /**
@@ -0,0 +1,318 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "slab-allocator.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
+
+namespace {
+
+/**
+ * \ingroup packet
+ *
+ * \brief A block in the free list of a size class
+ */
+struct FreeBlock
+{
+  struct FreeBlock *next; //!< next free block of the same class
+};
+
+/**
+ * \ingroup packet
+ *
+ * \brief The free list and the statistics of a size class
+ *
+ * This is a POD type so that the size classes are initialized before
+ * any constructor runs: buffers can be created and destroyed from the
+ * constructors and destructors of static objects.
+ */
+struct SlabClass
+{
+  struct FreeBlock *head; //!< first free block
+  uint32_t cached;        //!< number of free blocks
+  uint32_t limit;         //!< maximum number of free blocks
+  uint32_t inUse;         //!< number of allocated blocks
+  uint32_t highWater;     //!< maximum number of allocated blocks
+  uint64_t hits;          //!< allocations served from the free list
+  uint64_t misses;        //!< allocations served by the system
+};
+
+/// Default maximum number of bytes kept in the free list of each size class
+#define SLAB_DEFAULT_BYTES (256 * 1024)
+/// Default maximum number of free blocks of each size class
+#define SLAB_DEFAULT_BLOCKS 1000
+/// Default maximum number of free blocks of the size class of this size
+#define SLAB_DEFAULT_LIMIT(size) \
+  (SLAB_DEFAULT_BYTES / (size) < SLAB_DEFAULT_BLOCKS ? SLAB_DEFAULT_BYTES / (size) : SLAB_DEFAULT_BLOCKS)
+
+/// The size classes
+struct SlabClass g_classes[ns3::SlabAllocator::N_CLASSES] = {
+  { 0, 0, SLAB_DEFAULT_LIMIT (32), 0, 0, 0, 0 },
+  { 0, 0, SLAB_DEFAULT_LIMIT (64), 0, 0, 0, 0 },
+  { 0, 0, SLAB_DEFAULT_LIMIT (128), 0, 0, 0, 0 },
+  { 0, 0, SLAB_DEFAULT_LIMIT (256), 0, 0, 0, 0 },
+  { 0, 0, SLAB_DEFAULT_LIMIT (512), 0, 0, 0, 0 },
+  { 0, 0, SLAB_DEFAULT_LIMIT (1024), 0, 0, 0, 0 },
+  { 0, 0, SLAB_DEFAULT_LIMIT (2048), 0, 0, 0, 0 },
+  { 0, 0, SLAB_DEFAULT_LIMIT (4096), 0, 0, 0, 0 },
+  { 0, 0, SLAB_DEFAULT_LIMIT (8192), 0, 0, 0, 0 },
+  { 0, 0, SLAB_DEFAULT_LIMIT (16384), 0, 0, 0, 0 },
+  { 0, 0, SLAB_DEFAULT_LIMIT (32768), 0, 0, 0, 0 },
+  { 0, 0, SLAB_DEFAULT_LIMIT (65536), 0, 0, 0, 0 },
+};
+
+/**
+ * The caching state. As for the size classes, zero (the value of
+ * static memory before any constructor runs) means that the global
+ * value has not been read yet.
+ */
+enum SlabState
+{
+  SLAB_UNKNOWN = 0, //!< the global value has not been read yet
+  SLAB_ENABLED,     //!< released blocks are cached
+  SLAB_DISABLED,    //!< released blocks are given back to the system
+  SLAB_DESTROYED    //!< the static destructors of this file have run
+};
+enum SlabState g_state = SLAB_UNKNOWN; //!< the caching state
+
+} // anonymous namespace
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SlabAllocator");
+
+static GlobalValue g_slabAllocatorEnabled = GlobalValue ("SlabAllocatorEnabled",
+                                                         "A global switch to cache the memory released by packets in size classes, "
+                                                         "off by default. "
+                                                         "It is read when the first packet is released: use "
+                                                         "SlabAllocator::Enable and SlabAllocator::Disable afterwards.",
+                                                         BooleanValue (false),
+                                                         MakeBooleanChecker ());
+
+/**
+ * \ingroup packet
+ *
+ * \brief Give the cached blocks back to the system on exit
+ *
+ * Blocks released after this destructor has run are not cached anymore.
+ * It is defined after the log component so that it runs before the
+ * log component is destroyed.
+ */
+static struct SlabLocalStaticDestructor
+{
+  ~SlabLocalStaticDestructor ();
+} g_slabLocalStaticDestructor; //!< Local static destructor
+
+SlabLocalStaticDestructor::~SlabLocalStaticDestructor ()
+{
+  SlabAllocator::Flush ();
+  g_state = SLAB_DESTROYED;
+}
+
+uint32_t
+SlabAllocator::GetClass (uint32_t size)
+{
+  uint32_t sizeClass = 0;
+  uint32_t classSize = MIN_SIZE;
+  while (classSize < size)
+    {
+      classSize <<= 1;
+      sizeClass++;
+    }
+  NS_ASSERT (sizeClass < N_CLASSES);
+  return sizeClass;
+}
+
+uint32_t
+SlabAllocator::GetSize (uint32_t size)
+{
+  if (size > MAX_SIZE)
+    {
+      return size;
+    }
+  return MIN_SIZE << GetClass (size);
+}
+
+bool
+SlabAllocator::IsEnabled (void)
+{
+  if (g_state == SLAB_UNKNOWN)
+    {
+      BooleanValue enabled;
+      if (!GlobalValue::GetValueByNameFailSafe ("SlabAllocatorEnabled", enabled))
+        {
+          // the global value is not constructed yet: use its default value
+          return false;
+        }
+      g_state = enabled.Get () ? SLAB_ENABLED : SLAB_DISABLED;
+    }
+  return g_state == SLAB_ENABLED;
+}
+
+void
+SlabAllocator::Enable (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  if (g_state != SLAB_DESTROYED)
+    {
+      g_state = SLAB_ENABLED;
+    }
+}
+
+void
+SlabAllocator::Disable (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  if (g_state != SLAB_DESTROYED)
+    {
+      g_state = SLAB_DISABLED;
+    }
+  Flush ();
+}
+
+uint8_t *
+SlabAllocator::Allocate (uint32_t &size)
+{
+  if (size > MAX_SIZE)
+    {
+      return new uint8_t [size];
+    }
+  uint32_t sizeClass = GetClass (size);
+  size = MIN_SIZE << sizeClass;
+  struct SlabClass *slab = &g_classes[sizeClass];
+  uint8_t *buffer;
+  if (slab->head != 0)
+    {
+      struct FreeBlock *block = slab->head;
+      slab->head = block->next;
+      slab->cached--;
+      slab->hits++;
+      buffer = reinterpret_cast<uint8_t *> (block);
+    }
+  else
+    {
+      slab->misses++;
+      buffer = new uint8_t [size];
+    }
+  slab->inUse++;
+  if (slab->inUse > slab->highWater)
+    {
+      slab->highWater = slab->inUse;
+    }
+  return buffer;
+}
+
+void
+SlabAllocator::Deallocate (uint8_t *buffer, uint32_t size)
+{
+  if (size > MAX_SIZE)
+    {
+      delete [] buffer;
+      return;
+    }
+  uint32_t sizeClass = GetClass (size);
+  NS_ASSERT_MSG (size == (uint32_t)MIN_SIZE << sizeClass,
+                 "Size " << size << " was not returned by SlabAllocator::Allocate");
+  struct SlabClass *slab = &g_classes[sizeClass];
+  NS_ASSERT (slab->inUse > 0);
+  slab->inUse--;
+  if (slab->cached < slab->limit && IsEnabled ())
+    {
+      struct FreeBlock *block = reinterpret_cast<struct FreeBlock *> (buffer);
+      block->next = slab->head;
+      slab->head = block;
+      slab->cached++;
+    }
+  else
+    {
+      delete [] buffer;
+    }
+}
+
+void
+SlabAllocator::SetCacheLimit (uint32_t size, uint32_t limit)
+{
+  NS_LOG_FUNCTION (size << limit);
+  NS_ASSERT (size <= MAX_SIZE);
+  struct SlabClass *slab = &g_classes[GetClass (size)];
+  slab->limit = limit;
+  while (slab->cached > slab->limit)
+    {
+      struct FreeBlock *block = slab->head;
+      slab->head = block->next;
+      slab->cached--;
+      delete [] reinterpret_cast<uint8_t *> (block);
+    }
+}
+
+void
+SlabAllocator::SetCacheLimit (uint32_t limit)
+{
+  NS_LOG_FUNCTION (limit);
+  for (uint32_t i = 0; i < N_CLASSES; i++)
+    {
+      SetCacheLimit (MIN_SIZE << i, limit);
+    }
+}
+
+void
+SlabAllocator::Flush (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  for (uint32_t i = 0; i < N_CLASSES; i++)
+    {
+      struct SlabClass *slab = &g_classes[i];
+      while (slab->head != 0)
+        {
+          struct FreeBlock *block = slab->head;
+          slab->head = block->next;
+          delete [] reinterpret_cast<uint8_t *> (block);
+        }
+      slab->cached = 0;
+    }
+}
+
+struct SlabAllocator::Stats
+SlabAllocator::GetStats (uint32_t sizeClass)
+{
+  NS_LOG_FUNCTION (sizeClass);
+  NS_ASSERT (sizeClass < N_CLASSES);
+  const struct SlabClass *slab = &g_classes[sizeClass];
+  struct Stats stats;
+  stats.size = MIN_SIZE << sizeClass;
+  stats.hits = slab->hits;
+  stats.misses = slab->misses;
+  stats.inUse = slab->inUse;
+  stats.highWater = slab->highWater;
+  stats.cached = slab->cached;
+  stats.limit = slab->limit;
+  return stats;
+}
+
+void
+SlabAllocator::ResetStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  for (uint32_t i = 0; i < N_CLASSES; i++)
+    {
+      g_classes[i].hits = 0;
+      g_classes[i].misses = 0;
+      g_classes[i].highWater = g_classes[i].inUse;
+    }
+}
+
+} // namespace ns3
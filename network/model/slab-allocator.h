@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef SLAB_ALLOCATOR_H
+#define SLAB_ALLOCATOR_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief size-class allocator for the packet internal storage
+ *
+ * Buffer, PacketMetadata, ByteTagList and PacketTagList allocate and
+ * release small blocks of memory at a very high rate. This allocator
+ * rounds every request up to a power of two size class (from
+ * SlabAllocator::MIN_SIZE to SlabAllocator::MAX_SIZE bytes) and keeps
+ * the released blocks of each class in a free list, so that most
+ * allocations are served without calling the system allocator.
+ * Larger requests are forwarded to the system allocator.
+ *
+ * Each size class caches at most a configurable number of blocks (see
+ * SetCacheLimit) and maintains hit, miss and high-water statistics
+ * (see GetStats). By default, each class keeps at most 1000 blocks and
+ * 256 KiB, so that the large classes do not hold on to much memory.
+ *
+ * Caching is disabled by default. It is controlled by the
+ * "SlabAllocatorEnabled" global value, or at any time with
+ * SlabAllocator::Enable and SlabAllocator::Disable.
+ * The global value is read only once, when the first block is released,
+ * so that the releases do not pay for its lookup: setting it afterwards,
+ * with GlobalValue::Bind or on the command line once packets exist, has
+ * no effect, and SlabAllocator::Enable and SlabAllocator::Disable must be
+ * used instead. When caching is disabled, the blocks are still rounded
+ * to their size class but every release goes back to the system
+ * allocator.
+ *
+ * The caller must remember the size returned by Allocate and give it
+ * back to Deallocate: blocks carry no header.
+ */
+class SlabAllocator
+{
+public:
+  /// the size classes range
+  enum
+  {
+    MIN_SIZE = 32,     //!< size of the smallest size class
+    MAX_SIZE = 65536,  //!< size of the largest size class
+    N_CLASSES = 12     //!< number of size classes
+  };
+
+  /**
+   * \brief Statistics of a size class
+   */
+  struct Stats
+  {
+    uint32_t size;      //!< size of the blocks of this class
+    uint64_t hits;      //!< number of allocations served from the cache
+    uint64_t misses;    //!< number of allocations forwarded to the system
+    uint32_t inUse;     //!< number of blocks currently allocated
+    uint32_t highWater; //!< maximum value reached by inUse
+    uint32_t cached;    //!< number of blocks currently in the free list
+    uint32_t limit;     //!< maximum number of blocks in the free list
+  };
+
+  /**
+   * \brief Allocate a block of memory
+   * \param size the minimum size of the block
+   * \returns a block of at least size bytes. On return, size holds the
+   *          real size of the block, which must be given back to
+   *          Deallocate.
+   */
+  static uint8_t *Allocate (uint32_t &size);
+  /**
+   * \brief Release a block of memory
+   * \param buffer the block returned by Allocate
+   * \param size the real size of the block, as returned by Allocate
+   */
+  static void Deallocate (uint8_t *buffer, uint32_t size);
+  /**
+   * \param size a block size
+   * \returns the size of the block which Allocate returns for this size
+   */
+  static uint32_t GetSize (uint32_t size);
+
+  /**
+   * \brief Enable caching of the released blocks
+   */
+  static void Enable (void);
+  /**
+   * \brief Disable caching of the released blocks and empty the caches
+   */
+  static void Disable (void);
+  /**
+   * \returns true if the released blocks are cached
+   *
+   * The first call reads the "SlabAllocatorEnabled" global value; the
+   * later calls ignore it.
+   */
+  static bool IsEnabled (void);
+
+  /**
+   * \brief Set the maximum number of blocks cached by size classes
+   * \param size a block size: the limit applies to the size class of
+   *        the blocks of this size
+   * \param limit the maximum number of free blocks kept in the class
+   */
+  static void SetCacheLimit (uint32_t size, uint32_t limit);
+  /**
+   * \brief Set the maximum number of blocks cached by every size class
+   * \param limit the maximum number of free blocks kept in each class
+   */
+  static void SetCacheLimit (uint32_t limit);
+  /**
+   * \brief Give all the cached blocks back to the system allocator
+   */
+  static void Flush (void);
+
+  /**
+   * \param sizeClass the index of a size class, smaller than N_CLASSES
+   * \returns the statistics of this size class
+   */
+  static struct Stats GetStats (uint32_t sizeClass);
+  /**
+   * \brief Reset the hit, miss and high-water statistics
+   */
+  static void ResetStats (void);
+
+private:
+  /**
+   * \param size a block size
+   * \returns the index of the smallest size class which holds size bytes
+   */
+  static uint32_t GetClass (uint32_t size);
+};
+
+} // namespace ns3
+
+#endif /* SLAB_ALLOCATOR_H */
@@ -19,6 +19,7 @@
  */
 
 #include "ns3/buffer.h"
+#include "ns3/slab-allocator.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/double.h"
 #include "ns3/test.h"
@@ -360,6 +361,341 @@ BufferTest::DoRun (void)
   val2 |= i.ReadU8 ();
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
+//-----------------------------------------------------------------------------
+// Aggregation of buffers with virtual zero areas
+//-----------------------------------------------------------------------------
+class BufferAggregationTest : public TestCase {
+protected:
+  Buffer CreateFrame (uint8_t id, uint32_t zeroSize);
+  std::vector<uint8_t> CreateFrameBytes (uint8_t id, uint32_t zeroSize);
+  void CheckBytes (Buffer b, std::vector<uint8_t> expected, std::string msg);
+  uint64_t GetAllocatedBytes (void);
+  BufferAggregationTest (std::string name);
+public:
+  virtual void DoRun (void);
+  BufferAggregationTest ();
+};
+
+BufferAggregationTest::BufferAggregationTest ()
+  : TestCase ("Check that aggregated buffers keep their zero areas")
+{
+}
+
+BufferAggregationTest::BufferAggregationTest (std::string name)
+  : TestCase (name)
+{
+}
+
+// a 4 bytes header, zeroSize zero bytes and a 2 bytes trailer
+Buffer
+BufferAggregationTest::CreateFrame (uint8_t id, uint32_t zeroSize)
+{
+  Buffer b (zeroSize);
+  b.AddAtStart (4);
+  b.Begin ().WriteHtonU32 (0xa0b0c000 | id);
+  b.AddAtEnd (2);
+  Buffer::Iterator i = b.End ();
+  i.Prev (2);
+  i.WriteU8 (0xe0 | id);
+  i.WriteU8 (0xf0 | id);
+  return b;
+}
+
+std::vector<uint8_t>
+BufferAggregationTest::CreateFrameBytes (uint8_t id, uint32_t zeroSize)
+{
+  std::vector<uint8_t> bytes;
+  bytes.push_back (0xa0);
+  bytes.push_back (0xb0);
+  bytes.push_back (0xc0);
+  bytes.push_back (id);
+  bytes.resize (4 + zeroSize, 0);
+  bytes.push_back (0xe0 | id);
+  bytes.push_back (0xf0 | id);
+  return bytes;
+}
+
+void
+BufferAggregationTest::CheckBytes (Buffer b, std::vector<uint8_t> expected, std::string msg)
+{
+  NS_TEST_ASSERT_MSG_EQ (b.GetSize (), expected.size (), msg << ": bad size");
+  std::vector<uint8_t> copied (b.GetSize () + 1, 0x55);
+  NS_TEST_EXPECT_MSG_EQ (b.CopyData (&copied[0], b.GetSize () + 1), b.GetSize (), msg << ": bad CopyData size");
+  NS_TEST_EXPECT_MSG_EQ ((copied[b.GetSize ()] == 0x55), true, msg << ": CopyData wrote too much");
+  Buffer::Iterator i = b.Begin ();
+  for (uint32_t j = 0; j < expected.size (); j++)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((uint32_t)copied[j], (uint32_t)expected[j], msg << ": bad copied byte " << j);
+      NS_TEST_EXPECT_MSG_EQ ((uint32_t)i.ReadU8 (), (uint32_t)expected[j], msg << ": bad read byte " << j);
+    }
+  i = b.End ();
+  for (uint32_t j = expected.size (); j > 0; j--)
+    {
+      i.Prev ();
+      NS_TEST_EXPECT_MSG_EQ ((uint32_t)i.PeekU8 (), (uint32_t)expected[j - 1], msg << ": bad peeked byte " << j - 1);
+    }
+  Buffer full = b;
+  NS_TEST_EXPECT_MSG_EQ (memcmp (full.PeekData (), &expected[0], expected.size ()), 0, msg << ": bad real buffer");
+}
+
+uint64_t
+BufferAggregationTest::GetAllocatedBytes (void)
+{
+  uint64_t bytes = 0;
+  for (uint32_t i = 0; i < SlabAllocator::N_CLASSES; i++)
+    {
+      struct SlabAllocator::Stats stats = SlabAllocator::GetStats (i);
+      bytes += stats.inUse * stats.size;
+    }
+  return bytes;
+}
+
+void
+BufferAggregationTest::DoRun (void)
+{
+  const uint32_t nFrames = 5;
+  const uint32_t zeroSize = 10000;
+
+  uint64_t allocated = GetAllocatedBytes ();
+  std::vector<Buffer> frames;
+  for (uint8_t id = 0; id < nFrames; id++)
+    {
+      frames.push_back (CreateFrame (id, zeroSize + id));
+    }
+  Buffer aggregate;
+  std::vector<uint8_t> expected;
+  for (uint8_t id = 0; id < nFrames; id++)
+    {
+      aggregate.AddAtEnd (frames[id]);
+      std::vector<uint8_t> bytes = CreateFrameBytes (id, zeroSize + id);
+      expected.insert (expected.end (), bytes.begin (), bytes.end ());
+    }
+  NS_TEST_EXPECT_MSG_LT (GetAllocatedBytes () - allocated, zeroSize,
+                         "The zero bytes of the aggregate should not be allocated");
+  NS_TEST_EXPECT_MSG_EQ (aggregate.GetSize (), expected.size (), "Bad aggregate size");
+
+  // read the headers and trailers in place
+  Buffer::Iterator i = aggregate.Begin ();
+  for (uint8_t id = 0; id < nFrames; id++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (i.ReadNtohU32 (), (0xa0b0c000 | id), "Bad header");
+      i.Next (zeroSize + id);
+      NS_TEST_EXPECT_MSG_EQ (i.ReadNtohU16 (), (((0xe0 | id) << 8) | (0xf0 | id)), "Bad trailer");
+    }
+  NS_TEST_EXPECT_MSG_EQ (i.IsEnd (), true, "Bad aggregate end");
+
+  // write in a header located after the zero areas
+  i = aggregate.Begin ();
+  i.Next (3 * (zeroSize + 6) + 3);
+  i.WriteHtonU32 (0xa0b0c0d3);
+  expected[3 * (zeroSize + 6) + 6] = 0xd3;
+
+  // split the aggregate back into frames
+  Buffer remaining = aggregate;
+  for (uint8_t id = 0; id < nFrames; id++)
+    {
+      uint32_t size = zeroSize + id + 6;
+      Buffer frame = remaining.CreateFragment (0, size);
+      remaining.RemoveAtStart (size);
+      std::vector<uint8_t> bytes = CreateFrameBytes (id, zeroSize + id);
+      if (id == 3)
+        {
+          bytes[3] = 0xd3;
+        }
+      CheckBytes (frame, bytes, "Bad extracted frame");
+    }
+  NS_TEST_EXPECT_MSG_EQ (remaining.GetSize (), 0, "Bad remaining size");
+
+  // fragments which start and end in the middle of zero areas
+  Buffer fragment = aggregate.CreateFragment (zeroSize / 2, 2 * zeroSize);
+  CheckBytes (fragment, std::vector<uint8_t> (expected.begin () + zeroSize / 2,
+                                              expected.begin () + zeroSize / 2 + 2 * zeroSize),
+              "Bad fragment");
+  Buffer reassembled = aggregate.CreateFragment (0, zeroSize / 2);
+  reassembled.AddAtEnd (fragment);
+  reassembled.AddAtEnd (aggregate.CreateFragment (zeroSize / 2 + 2 * zeroSize,
+                                                  aggregate.GetSize () - zeroSize / 2 - 2 * zeroSize));
+  CheckBytes (reassembled, expected, "Bad reassembled aggregate");
+
+  // headers added in front of a shared aggregate
+  Buffer copy = aggregate;
+  copy.AddAtStart (2);
+  copy.Begin ().WriteHtonU16 (0x1234);
+  expected.insert (expected.begin (), 0x34);
+  expected.insert (expected.begin (), 0x12);
+  CheckBytes (copy, expected, "Bad aggregate after AddAtStart");
+  expected.erase (expected.begin (), expected.begin () + 2);
+
+  // append a buffer to itself
+  copy = aggregate;
+  copy.AddAtEnd (copy);
+  std::vector<uint8_t> doubled = expected;
+  doubled.insert (doubled.end (), expected.begin (), expected.end ());
+  CheckBytes (copy, doubled, "Bad aggregate appended to itself");
+
+  // serialization keeps the content
+  std::vector<uint8_t> serialized (aggregate.GetSerializedSize ());
+  NS_TEST_EXPECT_MSG_EQ (aggregate.Serialize (&serialized[0], serialized.size ()), 1, "Serialization failed");
+  Buffer deserialized (0, false);
+  // the size given to Deserialize includes the size field of Packet::Serialize
+  NS_TEST_EXPECT_MSG_EQ (deserialized.Deserialize (&serialized[0], serialized.size () + 4), 1, "Deserialization failed");
+  CheckBytes (deserialized, expected, "Bad deserialized aggregate");
+
+  CheckBytes (aggregate, expected, "Bad aggregate");
+}
+
+//-----------------------------------------------------------------------------
+// Aggregation of buffers which share their real bytes
+//-----------------------------------------------------------------------------
+class BufferSharingTest : public BufferAggregationTest {
+private:
+  Buffer CreatePayloadFrame (uint8_t id, uint32_t payloadSize, uint32_t zeroSize);
+  std::vector<uint8_t> CreatePayloadFrameBytes (uint8_t id, uint32_t payloadSize, uint32_t zeroSize);
+public:
+  virtual void DoRun (void);
+  BufferSharingTest ();
+};
+
+BufferSharingTest::BufferSharingTest ()
+  : BufferAggregationTest ("Check that aggregated buffers share their real bytes")
+{
+}
+
+// a frame whose zero area is preceded by payloadSize real bytes
+Buffer
+BufferSharingTest::CreatePayloadFrame (uint8_t id, uint32_t payloadSize, uint32_t zeroSize)
+{
+  Buffer b = CreateFrame (id, zeroSize);
+  b.RemoveAtStart (4);
+  b.AddAtStart (4 + payloadSize);
+  Buffer::Iterator i = b.Begin ();
+  i.WriteHtonU32 (0xa0b0c000 | id);
+  for (uint32_t j = 0; j < payloadSize; j++)
+    {
+      i.WriteU8 (id + j);
+    }
+  return b;
+}
+
+std::vector<uint8_t>
+BufferSharingTest::CreatePayloadFrameBytes (uint8_t id, uint32_t payloadSize, uint32_t zeroSize)
+{
+  std::vector<uint8_t> bytes = CreateFrameBytes (id, zeroSize);
+  for (uint32_t j = payloadSize; j > 0; j--)
+    {
+      bytes.insert (bytes.begin () + 4, id + j - 1);
+    }
+  return bytes;
+}
+
+void
+BufferSharingTest::DoRun (void)
+{
+  const uint32_t nFrames = 4;
+  const uint32_t payloadSize = 1000;
+  const uint32_t zeroSize = 500;
+  const uint32_t frameSize = 4 + payloadSize + zeroSize + 2;
+
+  Buffer::EnableSharing (64);
+  std::vector<Buffer> frames;
+  std::vector<uint8_t> expected;
+  for (uint8_t id = 0; id < nFrames; id++)
+    {
+      frames.push_back (CreatePayloadFrame (id, payloadSize, zeroSize));
+      std::vector<uint8_t> bytes = CreatePayloadFrameBytes (id, payloadSize, zeroSize);
+      expected.insert (expected.end (), bytes.begin (), bytes.end ());
+    }
+  uint64_t allocated = GetAllocatedBytes ();
+  Buffer aggregate;
+  for (uint8_t id = 0; id < nFrames; id++)
+    {
+      aggregate.AddAtEnd (frames[id]);
+    }
+  NS_TEST_EXPECT_MSG_LT (GetAllocatedBytes () - allocated, payloadSize,
+                         "The payload bytes of the aggregate should not be copied");
+  CheckBytes (aggregate, expected, "Bad aggregate");
+
+  // the frames can be modified or released without changing the aggregate
+  frames[0] = Buffer ();
+  frames[1].RemoveAtEnd (2 + zeroSize + payloadSize / 2);
+  frames[1].AddAtEnd (4);
+  Buffer::Iterator i = frames[1].End ();
+  i.Prev (4);
+  i.WriteHtonU32 (0x55555555);
+  frames[1].AddAtStart (2);
+  frames[1].Begin ().WriteHtonU16 (0x5555);
+  CheckBytes (aggregate, expected, "Bad aggregate after changing the frames");
+
+  // headers and trailers which are not shared can still be written
+  i = aggregate.Begin ();
+  i.Next (2 * frameSize - 2);
+  i.WriteU8 (0xd1);
+  expected[2 * frameSize - 2] = 0xd1;
+  aggregate.AddAtStart (2);
+  aggregate.Begin ().WriteHtonU16 (0x1234);
+  aggregate.AddAtEnd (1);
+  i = aggregate.End ();
+  i.Prev ();
+  i.WriteU8 (0x56);
+  expected.insert (expected.begin (), 0x34);
+  expected.insert (expected.begin (), 0x12);
+  expected.push_back (0x56);
+  CheckBytes (aggregate, expected, "Bad aggregate after adding bytes");
+  aggregate.RemoveAtStart (2);
+  aggregate.RemoveAtEnd (1);
+  expected.erase (expected.begin (), expected.begin () + 2);
+  expected.pop_back ();
+
+  // split the aggregate back into frames, and cut it in the middle of
+  // its shared areas
+  Buffer remaining = aggregate;
+  for (uint8_t id = 0; id < nFrames; id++)
+    {
+      Buffer frame = remaining.CreateFragment (0, frameSize);
+      remaining.RemoveAtStart (frameSize);
+      CheckBytes (frame, std::vector<uint8_t> (expected.begin () + id * frameSize,
+                                               expected.begin () + (id + 1) * frameSize),
+                  "Bad extracted frame");
+    }
+  NS_TEST_EXPECT_MSG_EQ (remaining.GetSize (), 0, "Bad remaining size");
+  for (uint32_t start = 0; start < 2 * frameSize; start += 251)
+    {
+      uint32_t length = std::min (frameSize + 333, aggregate.GetSize () - start);
+      CheckBytes (aggregate.CreateFragment (start, length),
+                  std::vector<uint8_t> (expected.begin () + start, expected.begin () + start + length),
+                  "Bad fragment");
+    }
+
+  // aggregates of aggregates share the same bytes
+  Buffer copy = aggregate.CreateFragment (payloadSize / 2, 3 * frameSize);
+  copy.AddAtEnd (aggregate);
+  copy.AddAtEnd (copy);
+  std::vector<uint8_t> doubled (expected.begin () + payloadSize / 2,
+                                expected.begin () + payloadSize / 2 + 3 * frameSize);
+  doubled.insert (doubled.end (), expected.begin (), expected.end ());
+  doubled.insert (doubled.end (), doubled.begin (), doubled.end ());
+  CheckBytes (copy, doubled, "Bad aggregate of aggregates");
+
+  // serialization keeps the content
+  std::vector<uint8_t> serialized (aggregate.GetSerializedSize ());
+  NS_TEST_EXPECT_MSG_EQ (aggregate.Serialize (&serialized[0], serialized.size ()), 1, "Serialization failed");
+  Buffer deserialized (0, false);
+  NS_TEST_EXPECT_MSG_EQ (deserialized.Deserialize (&serialized[0], serialized.size () + 4), 1, "Deserialization failed");
+  CheckBytes (deserialized, expected, "Bad deserialized aggregate");
+
+  // the bytes appended after sharing is disabled are copied
+  Buffer::DisableSharing ();
+  allocated = GetAllocatedBytes ();
+  Buffer copied;
+  copied.AddAtEnd (frames[2]);
+  NS_TEST_EXPECT_MSG_GT (GetAllocatedBytes () - allocated, payloadSize,
+                         "The payload bytes should be copied");
+  CheckBytes (copied, std::vector<uint8_t> (expected.begin () + 2 * frameSize,
+                                            expected.begin () + 3 * frameSize),
+              "Bad copied frame");
+  CheckBytes (aggregate, expected, "Bad aggregate");
+}
+
 //-----------------------------------------------------------------------------
 class BufferTestSuite : public TestSuite
 {
@@ -371,6 +707,8 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferAggregationTest, TestCase::QUICK);
+  AddTestCase (new BufferSharingTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite;
@@ -805,6 +805,23 @@ PacketTagListTest::DoRun (void)
     ReplaceCheck (6);
     ReplaceCheck (7);
   }
+
+  { // Add to a copy
+    std::cout << GetName () << "check adding to a copy" << std::endl;
+    PacketTagList ptl = ref;
+    ATestTag<8> t8 (1);
+    ptl.Add (t8);
+    CheckRefList (ref, "add to copy, orig");
+    CheckRefList (ptl, "add to copy, copy");
+    CheckRef (ref, t8, "add to copy, orig", true);
+    CheckRef (ptl, t8, "add to copy, copy", false);
+    NS_TEST_EXPECT_MSG_EQ (ref.GetNTags (), (uint32_t)tagLast, "add to copy, orig size");
+    NS_TEST_EXPECT_MSG_EQ (ptl.GetNTags (), (uint32_t)tagLast + 1, "add to copy, copy size");
+    NS_TEST_EXPECT_MSG_EQ (ptl.GetTag (tagLast)->tid, t8.GetTypeId (), "add to copy, order");
+    ptl.RemoveAll ();
+    NS_TEST_EXPECT_MSG_EQ (ptl.GetNTags (), 0, "remove all");
+    CheckRefList (ref, "remove all, orig");
+  }
   
   { // Timing
     std::cout << GetName () << "add+remove timing" << std::endl;
@@ -0,0 +1,184 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/slab-allocator.h"
+#include "ns3/packet.h"
+#include "ns3/test.h"
+#include <vector>
+
+using namespace ns3;
+
+//-----------------------------------------------------------------------------
+// Size classes, cache limits and statistics
+//-----------------------------------------------------------------------------
+class SlabAllocatorTest : public TestCase
+{
+public:
+  SlabAllocatorTest ();
+  virtual void DoRun (void);
+};
+
+SlabAllocatorTest::SlabAllocatorTest ()
+  : TestCase ("Check the size classes, the cache limits and the statistics")
+{
+}
+
+void
+SlabAllocatorTest::DoRun (void)
+{
+  bool enabled = SlabAllocator::IsEnabled ();
+  SlabAllocator::Enable ();
+  std::vector<uint32_t> limits;
+  for (uint32_t i = 0; i < SlabAllocator::N_CLASSES; i++)
+    {
+      limits.push_back (SlabAllocator::GetStats (i).limit);
+    }
+  NS_TEST_EXPECT_MSG_EQ (limits[0], 1000, "Bad default limit of the small blocks");
+  NS_TEST_EXPECT_MSG_EQ (limits[SlabAllocator::N_CLASSES - 1], 4, "Bad default limit of the large blocks");
+
+  NS_TEST_EXPECT_MSG_EQ (SlabAllocator::GetSize (1), 32, "Bad smallest class");
+  NS_TEST_EXPECT_MSG_EQ (SlabAllocator::GetSize (33), 64, "Bad rounding");
+  NS_TEST_EXPECT_MSG_EQ (SlabAllocator::GetSize (4096), 4096, "Bad rounding");
+  NS_TEST_EXPECT_MSG_EQ (SlabAllocator::GetSize (70000), 70000, "Large blocks are not rounded");
+
+  // class 5 holds blocks of 1024 bytes
+  const uint32_t sizeClass = 5;
+  SlabAllocator::SetCacheLimit (1000, 2);
+  SlabAllocator::Flush ();
+  SlabAllocator::ResetStats ();
+  struct SlabAllocator::Stats start = SlabAllocator::GetStats (sizeClass);
+  NS_TEST_ASSERT_MSG_EQ (start.size, 1024, "Bad class size");
+  NS_TEST_EXPECT_MSG_EQ (start.limit, 2, "Limit not set");
+  NS_TEST_EXPECT_MSG_EQ (start.cached, 0, "Cache not flushed");
+
+  std::vector<uint8_t *> blocks;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      uint32_t size = 1000;
+      blocks.push_back (SlabAllocator::Allocate (size));
+      NS_TEST_EXPECT_MSG_EQ (size, 1024, "Allocate should return the class size");
+    }
+  struct SlabAllocator::Stats stats = SlabAllocator::GetStats (sizeClass);
+  NS_TEST_EXPECT_MSG_EQ (stats.misses - start.misses, 3, "Empty cache should miss");
+  NS_TEST_EXPECT_MSG_EQ (stats.inUse - start.inUse, 3, "Bad use count");
+  NS_TEST_EXPECT_MSG_EQ (stats.highWater, stats.inUse, "Bad high-water mark");
+
+  for (uint32_t i = 0; i < blocks.size (); i++)
+    {
+      SlabAllocator::Deallocate (blocks[i], 1024);
+    }
+  stats = SlabAllocator::GetStats (sizeClass);
+  NS_TEST_EXPECT_MSG_EQ (stats.cached, 2, "The cache should be limited to 2 blocks");
+  NS_TEST_EXPECT_MSG_EQ (stats.inUse, start.inUse, "Bad use count");
+  NS_TEST_EXPECT_MSG_EQ (stats.highWater, start.inUse + 3, "High-water mark should be kept");
+
+  uint32_t size = 1024;
+  uint8_t *block = SlabAllocator::Allocate (size);
+  stats = SlabAllocator::GetStats (sizeClass);
+  NS_TEST_EXPECT_MSG_EQ (stats.hits - start.hits, 1, "Cached block should be reused");
+  NS_TEST_EXPECT_MSG_EQ (stats.cached, 1, "Bad cache size");
+
+  // a disabled allocator does not cache anything
+  SlabAllocator::Disable ();
+  NS_TEST_EXPECT_MSG_EQ (SlabAllocator::GetStats (sizeClass).cached, 0, "Disable should flush the cache");
+  SlabAllocator::Deallocate (block, size);
+  NS_TEST_EXPECT_MSG_EQ (SlabAllocator::GetStats (sizeClass).cached, 0, "Disabled allocator should not cache");
+
+  for (uint32_t i = 0; i < SlabAllocator::N_CLASSES; i++)
+    {
+      SlabAllocator::SetCacheLimit (SlabAllocator::MIN_SIZE << i, limits[i]);
+    }
+  if (enabled)
+    {
+      SlabAllocator::Enable ();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Packets recycle their storage through the allocator
+//-----------------------------------------------------------------------------
+class SlabAllocatorPacketTest : public TestCase
+{
+public:
+  SlabAllocatorPacketTest ();
+  virtual void DoRun (void);
+private:
+  void CreatePackets (uint32_t n);
+};
+
+SlabAllocatorPacketTest::SlabAllocatorPacketTest ()
+  : TestCase ("Check that packets reuse the blocks of destroyed packets")
+{
+}
+
+void
+SlabAllocatorPacketTest::CreatePackets (uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (1500);
+      p->AddPaddingAtEnd (100);
+      Ptr<Packet> fragment = p->CreateFragment (0, 500);
+    }
+}
+
+void
+SlabAllocatorPacketTest::DoRun (void)
+{
+  bool enabled = SlabAllocator::IsEnabled ();
+  SlabAllocator::Enable ();
+
+  // warm the caches, then count the system allocations
+  CreatePackets (1);
+  std::vector<struct SlabAllocator::Stats> start;
+  for (uint32_t i = 0; i < SlabAllocator::N_CLASSES; i++)
+    {
+      start.push_back (SlabAllocator::GetStats (i));
+    }
+  CreatePackets (100);
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  for (uint32_t i = 0; i < SlabAllocator::N_CLASSES; i++)
+    {
+      struct SlabAllocator::Stats stats = SlabAllocator::GetStats (i);
+      hits += stats.hits - start[i].hits;
+      misses += stats.misses - start[i].misses;
+      NS_TEST_EXPECT_MSG_EQ (stats.inUse, start[i].inUse, "Leaked blocks of " << stats.size << " bytes");
+    }
+  NS_TEST_EXPECT_MSG_GT (hits, 0, "Packets should reuse cached blocks");
+  NS_TEST_EXPECT_MSG_EQ (misses, 0, "Warm caches should serve every packet");
+
+  if (!enabled)
+    {
+      SlabAllocator::Disable ();
+    }
+}
+
+//-----------------------------------------------------------------------------
+class SlabAllocatorTestSuite : public TestSuite
+{
+public:
+  SlabAllocatorTestSuite ();
+};
+
+SlabAllocatorTestSuite::SlabAllocatorTestSuite ()
+  : TestSuite ("slab-allocator", UNIT)
+{
+  AddTestCase (new SlabAllocatorTest, TestCase::QUICK);
+  AddTestCase (new SlabAllocatorPacketTest, TestCase::QUICK);
+}
+
+static SlabAllocatorTestSuite g_slabAllocatorTestSuite;
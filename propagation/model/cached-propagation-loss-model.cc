@@ -0,0 +1,201 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "cached-propagation-loss-model.h"
+#include "ns3/log.h"
+#include "ns3/pointer.h"
+#include "ns3/uinteger.h"
+#include "ns3/mobility-model.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CachedPropagationLossModel");
+
+NS_OBJECT_ENSURE_REGISTERED (CachedPropagationLossModel);
+
+TypeId
+CachedPropagationLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CachedPropagationLossModel")
+    .SetParent<PropagationLossModel> ()
+    .SetGroupName ("Propagation")
+    .AddConstructor<CachedPropagationLossModel> ()
+    .AddAttribute ("Model",
+                   "The loss model whose results are cached.",
+                   PointerValue (),
+                   MakePointerAccessor (&CachedPropagationLossModel::SetModel,
+                                        &CachedPropagationLossModel::GetModel),
+                   MakePointerChecker<PropagationLossModel> ())
+    .AddAttribute ("MaxAge",
+                   "How long a value may be reused after one of the endpoints "
+                   "moved, as long as neither of them changed course. Zero "
+                   "means it is only reused while both endpoints stay at the "
+                   "same positions.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&CachedPropagationLossModel::m_maxAge),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxEntries",
+                   "The maximum number of cached values. When the cache is "
+                   "full, all the values are discarded before the next one "
+                   "is stored.",
+                   UintegerValue (65536),
+                   MakeUintegerAccessor (&CachedPropagationLossModel::m_maxEntries),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+CachedPropagationLossModel::CachedPropagationLossModel ()
+  : m_model (0),
+    m_modelVersion (0)
+{
+}
+
+CachedPropagationLossModel::~CachedPropagationLossModel ()
+{
+}
+
+void
+CachedPropagationLossModel::DoDispose (void)
+{
+  m_cache.clear ();
+  m_model = 0;
+  PropagationLossModel::DoDispose ();
+}
+
+void
+CachedPropagationLossModel::SetModel (Ptr<PropagationLossModel> model)
+{
+  m_model = model;
+  m_cache.clear ();
+  m_modelVersion = model != 0 ? model->GetVersion () : 0;
+  NotifyChange ();
+}
+
+Ptr<PropagationLossModel>
+CachedPropagationLossModel::GetModel (void) const
+{
+  return m_model;
+}
+
+void
+CachedPropagationLossModel::Flush (void)
+{
+  m_cache.clear ();
+}
+
+/**
+ * \param a a position
+ * \param b another position
+ * \returns true if both positions are exactly the same
+ */
+static bool
+SamePosition (const Vector &a, const Vector &b)
+{
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+size_t
+CachedPropagationLossModel::KeyHash::operator() (uint64_t key) const
+{
+  return static_cast<size_t> (key ^ ((key >> 32) * 0x9e3779b9U));
+}
+
+double
+CachedPropagationLossModel::DoCalcRxPower (double txPowerDbm,
+                                           Ptr<MobilityModel> a,
+                                           Ptr<MobilityModel> b) const
+{
+  NS_ASSERT_MSG (m_model != 0, "No loss model to cache");
+  if (!m_model->IsDeterministic ())
+    {
+      return m_model->CalcRxPower (txPowerDbm, a, b);
+    }
+
+  uint64_t version = m_model->GetVersion ();
+  if (version != m_modelVersion)
+    {
+      NS_LOG_LOGIC ("model reconfigured, flushing the cache");
+      m_cache.clear ();
+      m_modelVersion = version;
+    }
+
+  uint64_t key = (static_cast<uint64_t> (a->GetId ()) << 32) | b->GetId ();
+  // The positions are queried before the epochs: the models which update
+  // their course only when polled change their epoch then.
+  Vector positionA = a->GetPosition ();
+  Vector positionB = b->GetPosition ();
+  uint32_t epochA = a->GetPositionEpoch ();
+  uint32_t epochB = b->GetPositionEpoch ();
+  Time now = Simulator::Now ();
+  Cache::iterator i = m_cache.find (key);
+  if (i != m_cache.end ())
+    {
+      Entry &entry = i->second;
+      bool unmoved = SamePosition (entry.m_positionA, positionA)
+        && SamePosition (entry.m_positionB, positionB);
+      bool fresh = entry.m_epochA == epochA && entry.m_epochB == epochB
+        && now - entry.m_time <= m_maxAge;
+      if (entry.m_txPowerDbm == txPowerDbm && (unmoved || fresh))
+        {
+          NS_LOG_LOGIC ("hit a=" << a->GetId () << " b=" << b->GetId ());
+          return entry.m_rxPowerDbm;
+        }
+    }
+
+  Entry entry;
+  entry.m_positionA = positionA;
+  entry.m_positionB = positionB;
+  entry.m_epochA = epochA;
+  entry.m_epochB = epochB;
+  entry.m_time = now;
+  entry.m_txPowerDbm = txPowerDbm;
+  entry.m_rxPowerDbm = m_model->CalcRxPower (txPowerDbm, a, b);
+  NS_LOG_LOGIC ("miss a=" << a->GetId () << " b=" << b->GetId () << " rx=" << entry.m_rxPowerDbm);
+  if (i != m_cache.end ())
+    {
+      i->second = entry;
+    }
+  else
+    {
+      if (m_cache.size () >= m_maxEntries)
+        {
+          NS_LOG_LOGIC ("cache full, flushing it");
+          m_cache.clear ();
+        }
+      m_cache[key] = entry;
+    }
+  return entry.m_rxPowerDbm;
+}
+
+int64_t
+CachedPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  if (m_model != 0)
+    {
+      return m_model->AssignStreams (stream);
+    }
+  return 0;
+}
+
+bool
+CachedPropagationLossModel::DoIsDeterministic (void) const
+{
+  return m_model != 0 && m_model->IsDeterministic ();
+}
+
+} // namespace ns3
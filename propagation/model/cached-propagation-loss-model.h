@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef CACHED_PROPAGATION_LOSS_MODEL_H
+#define CACHED_PROPAGATION_LOSS_MODEL_H
+
+#include "ns3/propagation-loss-model.h"
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
+#include "ns3/sgi-hashmap.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup propagation
+ *
+ * \brief Memoizes the result of another (deterministic) loss model.
+ *
+ * The wrapped model, together with the models chained to it, is evaluated
+ * once per (source, destination) pair and the result is reused as long as
+ * both endpoints stay at the positions the value was computed for. The
+ * positions are queried on every call, which also lets the mobility
+ * models that only update their course when polled do so. The MaxAge
+ * attribute allows a bounded staleness: a value may then be reused for
+ * endpoints which moved, as long as neither of them changed course (see
+ * MobilityModel::GetPositionEpoch) and the value is not older than MaxAge.
+ *
+ * All the cached values are discarded when the wrapped chain is
+ * reconfigured through its setters (see PropagationLossModel::GetVersion).
+ * Flush must be called after changing an attribute of the chain which is
+ * bound directly to a member, for example through Config::Set.
+ *
+ * The cache holds at most MaxEntries values: when it is full, all of them
+ * are discarded before the next one is stored.
+ *
+ * When the wrapped model is not deterministic (see
+ * PropagationLossModel::IsDeterministic) the cache is bypassed.
+ */
+class CachedPropagationLossModel : public PropagationLossModel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  CachedPropagationLossModel ();
+  virtual ~CachedPropagationLossModel ();
+
+  /**
+   * \param model the loss model whose results should be cached
+   */
+  void SetModel (Ptr<PropagationLossModel> model);
+  /**
+   * \returns the loss model whose results are cached
+   */
+  Ptr<PropagationLossModel> GetModel (void) const;
+  /**
+   * Forget all cached values. Required after changing an attribute of
+   * the wrapped chain which does not go through a setter.
+   */
+  void Flush (void);
+
+private:
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   */
+  CachedPropagationLossModel (const CachedPropagationLossModel &);
+  /**
+   * \brief Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  CachedPropagationLossModel & operator = (const CachedPropagationLossModel &);
+
+  virtual void DoDispose (void);
+  virtual double DoCalcRxPower (double txPowerDbm,
+                                Ptr<MobilityModel> a,
+                                Ptr<MobilityModel> b) const;
+  virtual int64_t DoAssignStreams (int64_t stream);
+  virtual bool DoIsDeterministic (void) const;
+
+  /// A cached result for one directed path
+  struct Entry
+  {
+    Vector m_positionA; //!< position of the source
+    Vector m_positionB; //!< position of the destination
+    uint32_t m_epochA;  //!< position epoch of the source
+    uint32_t m_epochB;  //!< position epoch of the destination
+    Time m_time;        //!< time at which the value was computed
+    double m_txPowerDbm; //!< tx power used to compute the value
+    double m_rxPowerDbm; //!< cached result
+  };
+
+  /// Hash functor for the 64 bit path key
+  struct KeyHash
+  {
+    /**
+     * \param key the path key
+     * \returns the hash of the key
+     */
+    size_t operator() (uint64_t key) const;
+  };
+
+  /// Container for the cached entries, keyed by source and destination ids
+  typedef sgi::hash_map<uint64_t, Entry, KeyHash> Cache;
+
+  Ptr<PropagationLossModel> m_model; //!< the model whose results are cached
+  Time m_maxAge; //!< how long values for moving endpoints may be reused
+  uint32_t m_maxEntries; //!< the maximum number of cached values
+  mutable Cache m_cache; //!< the cached values
+  mutable uint64_t m_modelVersion; //!< version of m_model when the values were cached
+};
+
+} // namespace ns3
+
+#endif /* CACHED_PROPAGATION_LOSS_MODEL_H */
@@ -78,6 +78,7 @@ Cost231PropagationLossModel::SetLambda (double frequency, double speed)
 {
   m_lambda = speed / frequency;
   m_frequency = frequency;
+  NotifyChange ();
 }
 
 double
@@ -89,6 +90,7 @@ void
 Cost231PropagationLossModel::SetShadowing (double shadowing)
 {
   m_shadowing = shadowing;
+  NotifyChange ();
 }
 
 void
@@ -96,6 +98,7 @@ Cost231PropagationLossModel::SetLambda (double lambda)
 {
   m_lambda = lambda;
   m_frequency = 300000000 / lambda;
+  NotifyChange ();
 }
 
 double
@@ -108,6 +111,7 @@ void
 Cost231PropagationLossModel::SetMinDistance (double minDistance)
 {
   m_minDistance = minDistance;
+  NotifyChange ();
 }
 double
 Cost231PropagationLossModel::GetMinDistance (void) const
@@ -119,6 +123,7 @@ void
 Cost231PropagationLossModel::SetBSAntennaHeight (double height)
 {
   m_BSAntennaHeight = height;
+  NotifyChange ();
 }
 
 double
@@ -131,6 +136,7 @@ void
 Cost231PropagationLossModel::SetSSAntennaHeight (double height)
 {
   m_SSAntennaHeight = height;
+  NotifyChange ();
 }
 
 double
@@ -180,4 +186,10 @@ Cost231PropagationLossModel::DoAssignStreams (int64_t stream)
   return 0;
 }
 
+bool
+Cost231PropagationLossModel::DoIsDeterministic (void) const
+{
+  return true;
+}
+
 }
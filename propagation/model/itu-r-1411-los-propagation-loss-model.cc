@@ -91,6 +91,7 @@ ItuR1411LosPropagationLossModel::SetFrequency (double freq)
 {
   NS_ASSERT (freq > 0.0);
   m_lambda = 299792458.0 / freq;
+  NotifyChange ();
 }
 
 
@@ -107,4 +108,11 @@ ItuR1411LosPropagationLossModel::DoAssignStreams (int64_t stream)
 {
   return 0;
 }
+
+bool
+ItuR1411LosPropagationLossModel::DoIsDeterministic (void) const
+{
+  return true;
+}
+
 } // namespace ns3
@@ -209,6 +209,7 @@ ItuR1411NlosOverRooftopPropagationLossModel::SetFrequency (double freq)
 {
   m_frequency = freq;
   m_lambda = 299792458.0 / freq;
+  NotifyChange ();
 }
 
 
@@ -226,5 +227,11 @@ ItuR1411NlosOverRooftopPropagationLossModel::DoAssignStreams (int64_t stream)
   return 0;
 }
 
+bool
+ItuR1411NlosOverRooftopPropagationLossModel::DoIsDeterministic (void) const
+{
+  return true;
+}
+
 
 } // namespace ns3
@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "propagation-batch.h"
+#include "ns3/mobility-model.h"
+#include "ns3/assert.h"
+#include <cmath>
+
+namespace ns3 {
+
+PropagationBatch::PropagationBatch ()
+  : m_distanceValid (false)
+{
+}
+
+void
+PropagationBatch::Clear (void)
+{
+  m_mobility.clear ();
+  m_x.clear ();
+  m_y.clear ();
+  m_z.clear ();
+  m_distanceValid = false;
+}
+
+void
+PropagationBatch::Add (Ptr<MobilityModel> mobility)
+{
+  Add (mobility, mobility->GetPosition ());
+}
+
+void
+PropagationBatch::Add (Ptr<MobilityModel> mobility, const Vector &position)
+{
+  m_mobility.push_back (mobility);
+  m_x.push_back (position.x);
+  m_y.push_back (position.y);
+  m_z.push_back (position.z);
+  m_distanceValid = false;
+}
+
+uint32_t
+PropagationBatch::GetN (void) const
+{
+  return m_mobility.size ();
+}
+
+Ptr<MobilityModel>
+PropagationBatch::Get (uint32_t i) const
+{
+  NS_ASSERT (i < m_mobility.size ());
+  return m_mobility[i];
+}
+
+const double *
+PropagationBatch::GetX (void) const
+{
+  return m_x.empty () ? 0 : &m_x[0];
+}
+
+const double *
+PropagationBatch::GetY (void) const
+{
+  return m_y.empty () ? 0 : &m_y[0];
+}
+
+const double *
+PropagationBatch::GetZ (void) const
+{
+  return m_z.empty () ? 0 : &m_z[0];
+}
+
+const double *
+PropagationBatch::GetDistances (const Vector &from) const
+{
+  uint32_t n = m_mobility.size ();
+  if (n == 0)
+    {
+      return 0;
+    }
+  if (m_distanceValid
+      && m_from.x == from.x && m_from.y == from.y && m_from.z == from.z)
+    {
+      return &m_distance[0];
+    }
+  m_distance.resize (n);
+  const double *x = &m_x[0];
+  const double *y = &m_y[0];
+  const double *z = &m_z[0];
+  double *d = &m_distance[0];
+  // kept branch-free so that the compiler can vectorize it
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double dx = x[i] - from.x;
+      double dy = y[i] - from.y;
+      double dz = z[i] - from.z;
+      d[i] = std::sqrt (dx * dx + dy * dy + dz * dz);
+    }
+  m_from = from;
+  m_distanceValid = true;
+  return d;
+}
+
+} // namespace ns3
@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef PROPAGATION_BATCH_H
+#define PROPAGATION_BATCH_H
+
+#include "ns3/ptr.h"
+#include "ns3/vector.h"
+#include <vector>
+
+namespace ns3 {
+
+class MobilityModel;
+
+/**
+ * \ingroup propagation
+ *
+ * \brief A set of receivers evaluated together by the batch methods of
+ * PropagationLossModel and PropagationDelayModel.
+ *
+ * The position of each receiver is sampled once, when it is added, and
+ * stored as a structure of arrays so that the geometric models can run
+ * tight loops over the receivers without going through the MobilityModel
+ * of each of them. The distances from the last queried source position
+ * are kept so that chained models and delay models share them.
+ *
+ * A batch is meant to be filled, evaluated and cleared within a single
+ * transmission; it is not updated when the receivers move.
+ */
+class PropagationBatch
+{
+public:
+  PropagationBatch ();
+
+  /**
+   * Remove all receivers, keeping the allocated storage.
+   */
+  void Clear (void);
+  /**
+   * \param mobility the mobility model of the receiver to add
+   *
+   * The current position of the receiver is sampled.
+   */
+  void Add (Ptr<MobilityModel> mobility);
+  /**
+   * \param mobility the mobility model of the receiver to add
+   * \param position the current position of the receiver, already
+   *        sampled by the caller
+   */
+  void Add (Ptr<MobilityModel> mobility, const Vector &position);
+  /**
+   * \returns the number of receivers in this batch
+   */
+  uint32_t GetN (void) const;
+  /**
+   * \param i the index of a receiver
+   * \returns the mobility model of the receiver
+   */
+  Ptr<MobilityModel> Get (uint32_t i) const;
+  /**
+   * \returns the x coordinates of the receivers
+   */
+  const double * GetX (void) const;
+  /**
+   * \returns the y coordinates of the receivers
+   */
+  const double * GetY (void) const;
+  /**
+   * \returns the z coordinates of the receivers
+   */
+  const double * GetZ (void) const;
+  /**
+   * \param from the position of the source
+   * \returns the distance (m) from the source to each receiver
+   *
+   * The returned array remains valid until the batch is modified or
+   * queried with another source position.
+   */
+  const double * GetDistances (const Vector &from) const;
+
+private:
+  std::vector<Ptr<MobilityModel> > m_mobility; //!< receivers
+  std::vector<double> m_x; //!< x coordinate of each receiver
+  std::vector<double> m_y; //!< y coordinate of each receiver
+  std::vector<double> m_z; //!< z coordinate of each receiver
+  mutable std::vector<double> m_distance; //!< distance to the last source
+  mutable Vector m_from; //!< last source position
+  mutable bool m_distanceValid; //!< true if m_distance matches m_from
+};
+
+} // namespace ns3
+
+#endif /* PROPAGATION_BATCH_H */
@@ -47,6 +47,21 @@ PropagationDelayModel::AssignStreams (int64_t stream)
   return DoAssignStreams (stream);
 }
 
+void
+PropagationDelayModel::GetDelayBatch (Ptr<MobilityModel> a, const PropagationBatch &receivers, Time *delay) const
+{
+  DoGetDelayBatch (a, receivers, delay);
+}
+
+void
+PropagationDelayModel::DoGetDelayBatch (Ptr<MobilityModel> a, const PropagationBatch &receivers, Time *delay) const
+{
+  for (uint32_t i = 0; i < receivers.GetN (); i++)
+    {
+      delay[i] = GetDelay (a, receivers.Get (i));
+    }
+}
+
 // ------------------------------------------------------------------------- //
 
 NS_OBJECT_ENSURE_REGISTERED (RandomPropagationDelayModel);
@@ -114,6 +129,16 @@ ConstantSpeedPropagationDelayModel::GetDelay (Ptr<MobilityModel> a, Ptr<Mobility
   return Seconds (seconds);
 }
 void
+ConstantSpeedPropagationDelayModel::DoGetDelayBatch (Ptr<MobilityModel> a, const PropagationBatch &receivers, Time *delay) const
+{
+  uint32_t n = receivers.GetN ();
+  const double *distance = receivers.GetDistances (a->GetPosition ());
+  for (uint32_t i = 0; i < n; i++)
+    {
+      delay[i] = Seconds (distance[i] / m_speed);
+    }
+}
+void
 ConstantSpeedPropagationDelayModel::SetSpeed (double speed)
 {
   m_speed = speed;
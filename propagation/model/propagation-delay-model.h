@@ -24,6 +24,7 @@
 #include "ns3/object.h"
 #include "ns3/nstime.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/propagation-batch.h"
 
 namespace ns3 {
 
@@ -52,6 +53,15 @@ public:
    * source and destination.
    */
   virtual Time GetDelay (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const = 0;
+  /**
+   * \param a the source
+   * \param receivers the destinations
+   * \param delay an array of receivers.GetN () elements filled with the
+   *        propagation delay to each destination
+   *
+   * Batch version of GetDelay.
+   */
+  void GetDelayBatch (Ptr<MobilityModel> a, const PropagationBatch &receivers, Time *delay) const;
   /**
    * If this delay model uses objects of type RandomVariableStream,
    * set the stream numbers to the integers starting with the offset
@@ -68,6 +78,15 @@ private:
    * can return zero
    */
   virtual int64_t DoAssignStreams (int64_t stream) = 0;
+  /**
+   * The default implementation invokes GetDelay for each receiver;
+   * subclasses may override it with a faster loop.
+   *
+   * \param a the source
+   * \param receivers the destinations
+   * \param delay the delay to each destination
+   */
+  virtual void DoGetDelayBatch (Ptr<MobilityModel> a, const PropagationBatch &receivers, Time *delay) const;
 };
 
 /**
@@ -124,6 +143,7 @@ public:
   double GetSpeed (void) const;
 private:
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual void DoGetDelayBatch (Ptr<MobilityModel> a, const PropagationBatch &receivers, Time *delay) const;
   double m_speed; //!< speed
 };
 
@@ -29,6 +29,7 @@
 #include "ns3/string.h"
 #include "ns3/pointer.h"
 #include <cmath>
+#include <algorithm>
 
 namespace ns3 {
 
@@ -38,6 +39,8 @@ NS_LOG_COMPONENT_DEFINE ("PropagationLossModel");
 
 NS_OBJECT_ENSURE_REGISTERED (PropagationLossModel);
 
+uint64_t PropagationLossModel::s_changes = 0;
+
 TypeId 
 PropagationLossModel::GetTypeId (void)
 {
@@ -48,7 +51,8 @@ PropagationLossModel::GetTypeId (void)
 }
 
 PropagationLossModel::PropagationLossModel ()
-  : m_next (0)
+  : m_next (0),
+    m_version (0)
 {
 }
 
@@ -60,6 +64,7 @@ void
 PropagationLossModel::SetNext (Ptr<PropagationLossModel> next)
 {
   m_next = next;
+  NotifyChange ();
 }
 
 Ptr<PropagationLossModel>
@@ -81,6 +86,39 @@ PropagationLossModel::CalcRxPower (double txPowerDbm,
   return self;
 }
 
+void
+PropagationLossModel::CalcRxPowerBatch (double txPowerDbm,
+                                        Ptr<MobilityModel> a,
+                                        const PropagationBatch &receivers,
+                                        double *rxPowerDbm) const
+{
+  std::fill (rxPowerDbm, rxPowerDbm + receivers.GetN (), txPowerDbm);
+  ApplyBatch (a, receivers, rxPowerDbm);
+}
+
+void
+PropagationLossModel::ApplyBatch (Ptr<MobilityModel> a,
+                                  const PropagationBatch &receivers,
+                                  double *powerDbm) const
+{
+  DoCalcRxPowerBatch (a, receivers, powerDbm);
+  if (m_next != 0)
+    {
+      m_next->ApplyBatch (a, receivers, powerDbm);
+    }
+}
+
+void
+PropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                          const PropagationBatch &receivers,
+                                          double *powerDbm) const
+{
+  for (uint32_t i = 0; i < receivers.GetN (); i++)
+    {
+      powerDbm[i] = DoCalcRxPower (powerDbm[i], a, receivers.Get (i));
+    }
+}
+
 int64_t
 PropagationLossModel::AssignStreams (int64_t stream)
 {
@@ -93,6 +131,45 @@ PropagationLossModel::AssignStreams (int64_t stream)
   return (currentStream - stream);
 }
 
+bool
+PropagationLossModel::IsDeterministic (void) const
+{
+  if (!DoIsDeterministic ())
+    {
+      return false;
+    }
+  if (m_next != 0)
+    {
+      return m_next->IsDeterministic ();
+    }
+  return true;
+}
+
+bool
+PropagationLossModel::DoIsDeterministic (void) const
+{
+  return false;
+}
+
+uint64_t
+PropagationLossModel::GetVersion (void) const
+{
+  // every change takes a stamp larger than all the previous ones, so the
+  // largest stamp along the chain grows with any change of the chain
+  uint64_t version = m_version;
+  if (m_next != 0)
+    {
+      version = std::max (version, m_next->GetVersion ());
+    }
+  return version;
+}
+
+void
+PropagationLossModel::NotifyChange (void)
+{
+  m_version = ++s_changes;
+}
+
 // ------------------------------------------------------------------------- //
 
 NS_OBJECT_ENSURE_REGISTERED (RandomPropagationLossModel);
@@ -174,6 +251,7 @@ void
 FriisPropagationLossModel::SetSystemLoss (double systemLoss)
 {
   m_systemLoss = systemLoss;
+  NotifyChange ();
 }
 double
 FriisPropagationLossModel::GetSystemLoss (void) const
@@ -184,6 +262,7 @@ void
 FriisPropagationLossModel::SetMinLoss (double minLoss)
 {
   m_minLoss = minLoss;
+  NotifyChange ();
 }
 double
 FriisPropagationLossModel::GetMinLoss (void) const
@@ -197,6 +276,7 @@ FriisPropagationLossModel::SetFrequency (double frequency)
   m_frequency = frequency;
   static const double C = 299792458.0; // speed of light in vacuum
   m_lambda = C / frequency;
+  NotifyChange ();
 }
 
 double
@@ -269,12 +349,38 @@ FriisPropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return txPowerDbm - std::max (lossDb, m_minLoss);
 }
 
+void
+FriisPropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                               const PropagationBatch &receivers,
+                                               double *powerDbm) const
+{
+  uint32_t n = receivers.GetN ();
+  const double *distance = receivers.GetDistances (a->GetPosition ());
+  // Same equation as DoCalcRxPower, with the distance-independent terms
+  // hoisted out of the loop:
+  //   loss = 20 log10 (d) + 10 log10 (16 * pi^2 * L / lambda^2)
+  // A null distance gives an infinitely negative loss, hence m_minLoss.
+  const double offsetDb = 10 * std::log10 (16 * M_PI * M_PI * m_systemLoss / (m_lambda * m_lambda));
+  const double minLoss = m_minLoss;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double lossDb = 20 * std::log10 (distance[i]) + offsetDb;
+      powerDbm[i] -= lossDb > minLoss ? lossDb : minLoss;
+    }
+}
+
 int64_t
 FriisPropagationLossModel::DoAssignStreams (int64_t stream)
 {
   return 0;
 }
 
+bool
+FriisPropagationLossModel::DoIsDeterministic (void) const
+{
+  return true;
+}
+
 // ------------------------------------------------------------------------- //
 // -- Two-Ray Ground Model ported from NS-2 -- tomhewer@mac.com -- Nov09 //
 
@@ -318,6 +424,7 @@ void
 TwoRayGroundPropagationLossModel::SetSystemLoss (double systemLoss)
 {
   m_systemLoss = systemLoss;
+  NotifyChange ();
 }
 double
 TwoRayGroundPropagationLossModel::GetSystemLoss (void) const
@@ -328,6 +435,7 @@ void
 TwoRayGroundPropagationLossModel::SetMinDistance (double minDistance)
 {
   m_minDistance = minDistance;
+  NotifyChange ();
 }
 double
 TwoRayGroundPropagationLossModel::GetMinDistance (void) const
@@ -338,6 +446,7 @@ void
 TwoRayGroundPropagationLossModel::SetHeightAboveZ (double heightAboveZ)
 {
   m_heightAboveZ = heightAboveZ;
+  NotifyChange ();
 }
 
 void
@@ -346,6 +455,7 @@ TwoRayGroundPropagationLossModel::SetFrequency (double frequency)
   m_frequency = frequency;
   static const double C = 299792458.0; // speed of light in vacuum
   m_lambda = C / frequency;
+  NotifyChange ();
 }
 
 double
@@ -442,12 +552,49 @@ TwoRayGroundPropagationLossModel::DoCalcRxPower (double txPowerDbm,
     }
 }
 
+void
+TwoRayGroundPropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                                      const PropagationBatch &receivers,
+                                                      double *powerDbm) const
+{
+  uint32_t n = receivers.GetN ();
+  Vector position = a->GetPosition ();
+  const double *distance = receivers.GetDistances (position);
+  const double *z = receivers.GetZ ();
+  // See DoCalcRxPower for the equations.
+  const double lambda = m_lambda;
+  const double systemLoss = m_systemLoss;
+  const double minDistance = m_minDistance;
+  const double heightAboveZ = m_heightAboveZ;
+  const double txAntHeight = position.z + heightAboveZ;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double d = distance[i];
+      double rxAntHeight = z[i] + heightAboveZ;
+      double dCross = (4 * M_PI * txAntHeight * rxAntHeight) / lambda;
+      double tmp = M_PI * d;
+      double friis = (lambda * lambda) / (16 * tmp * tmp * systemLoss);
+      tmp = txAntHeight * rxAntHeight;
+      double rayNumerator = tmp * tmp;
+      tmp = d * d;
+      double ray = rayNumerator / (tmp * tmp * systemLoss);
+      double pr = 10 * std::log10 (d <= dCross ? friis : ray);
+      powerDbm[i] += d <= minDistance ? 0 : pr;
+    }
+}
+
 int64_t
 TwoRayGroundPropagationLossModel::DoAssignStreams (int64_t stream)
 {
   return 0;
 }
 
+bool
+TwoRayGroundPropagationLossModel::DoIsDeterministic (void) const
+{
+  return true;
+}
+
 // ------------------------------------------------------------------------- //
 
 NS_OBJECT_ENSURE_REGISTERED (LogDistancePropagationLossModel);
@@ -487,12 +634,14 @@ void
 LogDistancePropagationLossModel::SetPathLossExponent (double n)
 {
   m_exponent = n;
+  NotifyChange ();
 }
 void
 LogDistancePropagationLossModel::SetReference (double referenceDistance, double referenceLoss)
 {
   m_referenceDistance = referenceDistance;
   m_referenceLoss = referenceLoss;
+  NotifyChange ();
 }
 double
 LogDistancePropagationLossModel::GetPathLossExponent (void) const
@@ -531,12 +680,36 @@ LogDistancePropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return txPowerDbm + rxc;
 }
 
+void
+LogDistancePropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                                     const PropagationBatch &receivers,
+                                                     double *powerDbm) const
+{
+  uint32_t n = receivers.GetN ();
+  const double *distance = receivers.GetDistances (a->GetPosition ());
+  const double referenceDistance = m_referenceDistance;
+  const double referenceLoss = m_referenceLoss;
+  const double exponent = m_exponent;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double d = distance[i];
+      double lossDb = referenceLoss + 10 * exponent * std::log10 (d / referenceDistance);
+      powerDbm[i] -= d <= referenceDistance ? 0 : lossDb;
+    }
+}
+
 int64_t
 LogDistancePropagationLossModel::DoAssignStreams (int64_t stream)
 {
   return 0;
 }
 
+bool
+LogDistancePropagationLossModel::DoIsDeterministic (void) const
+{
+  return true;
+}
+
 // ------------------------------------------------------------------------- //
 
 NS_OBJECT_ENSURE_REGISTERED (ThreeLogDistancePropagationLossModel);
@@ -632,12 +805,47 @@ ThreeLogDistancePropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return txPowerDbm - pathLossDb;
 }
 
+void
+ThreeLogDistancePropagationLossModel::DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                                          const PropagationBatch &receivers,
+                                                          double *powerDbm) const
+{
+  uint32_t n = receivers.GetN ();
+  const double *distance = receivers.GetDistances (a->GetPosition ());
+  // The loss at the beginning of each field does not depend on the
+  // receiver; within a field the loss is base + 10 * n * log10 (d / start).
+  const double d0 = m_distance0;
+  const double d1 = m_distance1;
+  const double d2 = m_distance2;
+  const double base1 = m_referenceLoss;
+  const double base2 = base1 + 10 * m_exponent0 * std::log10 (d1 / d0);
+  const double base3 = base2 + 10 * m_exponent1 * std::log10 (d2 / d1);
+  const double n0 = m_exponent0;
+  const double n1 = m_exponent1;
+  const double n2 = m_exponent2;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double d = distance[i];
+      double start = d < d1 ? d0 : (d < d2 ? d1 : d2);
+      double base = d < d1 ? base1 : (d < d2 ? base2 : base3);
+      double exponent = d < d1 ? n0 : (d < d2 ? n1 : n2);
+      double pathLossDb = base + 10 * exponent * std::log10 (d / start);
+      powerDbm[i] -= d < d0 ? 0 : pathLossDb;
+    }
+}
+
 int64_t
 ThreeLogDistancePropagationLossModel::DoAssignStreams (int64_t stream)
 {
   return 0;
 }
 
+bool
+ThreeLogDistancePropagationLossModel::DoIsDeterministic (void) const
+{
+  return true;
+}
+
 // ------------------------------------------------------------------------- //
 
 NS_OBJECT_ENSURE_REGISTERED (NakagamiPropagationLossModel);
@@ -784,6 +992,7 @@ void
 FixedRssLossModel::SetRss (double rss)
 {
   m_rss = rss;
+  NotifyChange ();
 }
 
 double
@@ -800,6 +1009,12 @@ FixedRssLossModel::DoAssignStreams (int64_t stream)
   return 0;
 }
 
+bool
+FixedRssLossModel::DoIsDeterministic (void) const
+{
+  return true;
+}
+
 // ------------------------------------------------------------------------- //
 
 NS_OBJECT_ENSURE_REGISTERED (MatrixPropagationLossModel);
@@ -832,6 +1047,7 @@ void
 MatrixPropagationLossModel::SetDefaultLoss (double loss)
 {
   m_default = loss;
+  NotifyChange ();
 }
 
 void
@@ -855,6 +1071,7 @@ MatrixPropagationLossModel::SetLoss (Ptr<MobilityModel> ma, Ptr<MobilityModel> m
     {
       SetLoss (mb, ma, loss, false);
     }
+  NotifyChange ();
 }
 
 double 
@@ -880,6 +1097,12 @@ MatrixPropagationLossModel::DoAssignStreams (int64_t stream)
   return 0;
 }
 
+bool
+MatrixPropagationLossModel::DoIsDeterministic (void) const
+{
+  return true;
+}
+
 // ------------------------------------------------------------------------- //
 
 NS_OBJECT_ENSURE_REGISTERED (RangePropagationLossModel);
@@ -925,6 +1148,12 @@ RangePropagationLossModel::DoAssignStreams (int64_t stream)
   return 0;
 }
 
+bool
+RangePropagationLossModel::DoIsDeterministic (void) const
+{
+  return true;
+}
+
 // ------------------------------------------------------------------------- //
 
 } // namespace ns3
@@ -27,6 +27,7 @@
 
 #include "ns3/object.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/propagation-batch.h"
 #include <map>
 
 namespace ns3 {
@@ -93,6 +94,22 @@ public:
                       Ptr<MobilityModel> a,
                       Ptr<MobilityModel> b) const;
 
+  /**
+   * Batch version of CalcRxPower: returns the Rx Power at each receiver of
+   * a batch, taking into account all the PropagationLossModel(s) chained
+   * to the current one.
+   *
+   * \param txPowerDbm current transmission power (in dBm)
+   * \param a the mobility model of the source
+   * \param receivers the receivers
+   * \param rxPowerDbm an array of receivers.GetN () elements filled with
+   *        the reception power at each receiver (in dBm)
+   */
+  void CalcRxPowerBatch (double txPowerDbm,
+                         Ptr<MobilityModel> a,
+                         const PropagationBatch &receivers,
+                         double *rxPowerDbm) const;
+
   /**
    * If this loss model uses objects of type RandomVariableStream,
    * set the stream numbers to the integers starting with the offset
@@ -106,6 +123,39 @@ public:
    */
   int64_t AssignStreams (int64_t stream);
 
+  /**
+   * \returns true if this model and all the models chained to it always
+   *          return the same value for the same transmit power and the
+   *          same positions of the source and destination.
+   *
+   * Loss models whose result depends on random variables or on the
+   * simulation time (fading) are not deterministic and must not be cached.
+   */
+  bool IsDeterministic (void) const;
+
+  /**
+   * \returns a number which grows whenever this model or one of the
+   *          models chained to it is reconfigured through its setters
+   *          (SetNext included), so that the users caching the results
+   *          of a deterministic chain know when to discard them.
+   *
+   * Each change stamps the model with the next value of a counter
+   * shared by all the models, and the version of a chain is the latest
+   * stamp along it. A chain made of other models therefore has another
+   * version, even if each of them changed as many times.
+   *
+   * Attributes bound directly to a member, rather than through a
+   * setter, do not change this number when they are set.
+   */
+  uint64_t GetVersion (void) const;
+
+protected:
+  /**
+   * To be called by the setters of the subclasses whenever the result
+   * of the model may change.
+   */
+  void NotifyChange (void);
+
 private:
   /**
    * \brief Copy constructor
@@ -134,13 +184,52 @@ private:
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const = 0;
 
+  /**
+   * Applies this model and the models chained to it to a batch.
+   *
+   * \param a the mobility model of the source
+   * \param receivers the receivers
+   * \param powerDbm the power reaching each receiver, updated in place
+   */
+  void ApplyBatch (Ptr<MobilityModel> a,
+                   const PropagationBatch &receivers,
+                   double *powerDbm) const;
+
+  /**
+   * Applies only this particular PropagationLossModel to a batch.
+   *
+   * The default implementation invokes DoCalcRxPower for each receiver.
+   * Geometric models override it with loops over the positions of the
+   * batch which the compiler is able to vectorize.
+   *
+   * \param a the mobility model of the source
+   * \param receivers the receivers
+   * \param powerDbm on input, the power of the signal before this model
+   *        for each receiver (in dBm); on output, the power after this model
+   */
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   const PropagationBatch &receivers,
+                                   double *powerDbm) const;
+
   /**
    * Subclasses must implement this; those not using random variables
    * can return zero
    */
   virtual int64_t DoAssignStreams (int64_t stream) = 0;
 
+  /**
+   * Subclasses whose DoCalcRxPower is a pure function of the transmit
+   * power and of the positions should override this to return true.
+   * The default implementation conservatively returns false.
+   *
+   * \returns true if this particular model is deterministic
+   */
+  virtual bool DoIsDeterministic (void) const;
+
   Ptr<PropagationLossModel> m_next; //!< Next propagation loss model in the list
+  uint64_t m_version; //!< Value of s_changes at the last change of this model
+
+  static uint64_t s_changes; //!< Number of changes of all the models
 };
 
 /**
@@ -321,7 +410,11 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   const PropagationBatch &receivers,
+                                   double *powerDbm) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual bool DoIsDeterministic (void) const;
 
   /**
    * Transforms a Dbm value to Watt
@@ -441,7 +534,11 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   const PropagationBatch &receivers,
+                                   double *powerDbm) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual bool DoIsDeterministic (void) const;
 
   /**
    * Transforms a Dbm value to Watt
@@ -529,7 +626,11 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   const PropagationBatch &receivers,
+                                   double *powerDbm) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual bool DoIsDeterministic (void) const;
 
   /**
    *  Creates a default reference loss model
@@ -612,7 +713,11 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowerBatch (Ptr<MobilityModel> a,
+                                   const PropagationBatch &receivers,
+                                   double *powerDbm) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual bool DoIsDeterministic (void) const;
 
   double m_distance0; //!< Beginning of the first (near) distance field
   double m_distance1; //!< Beginning of the second (middle) distance field.
@@ -740,6 +845,7 @@ private:
                                 Ptr<MobilityModel> b) const;
 
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual bool DoIsDeterministic (void) const;
   double m_rss; //!< the received signal strength
 };
 
@@ -799,6 +905,7 @@ private:
                                 Ptr<MobilityModel> b) const;
 
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual bool DoIsDeterministic (void) const;
 private:
   double m_default; //!< default loss
 
@@ -845,6 +952,7 @@ private:
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
   virtual int64_t DoAssignStreams (int64_t stream);
+  virtual bool DoIsDeterministic (void) const;
 private:
   double m_range; //!< Maximum Transmission Range (meters)
 };
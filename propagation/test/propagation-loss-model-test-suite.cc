@@ -21,9 +21,16 @@
 #include "ns3/test.h"
 #include "ns3/config.h"
 #include "ns3/double.h"
+#include "ns3/uinteger.h"
 #include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/propagation-batch.h"
+#include "ns3/cached-propagation-loss-model.h"
 #include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-acceleration-mobility-model.h"
 #include "ns3/simulator.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
 
 using namespace ns3;
 
@@ -436,6 +443,254 @@ RangePropagationLossModelTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * A deterministic loss model counting its evaluations
+ */
+class CountingPropagationLossModel : public PropagationLossModel
+{
+public:
+  CountingPropagationLossModel ();
+
+  mutable uint32_t m_calls; //!< number of evaluations
+
+private:
+  virtual double DoCalcRxPower (double txPowerDbm,
+                                Ptr<MobilityModel> a,
+                                Ptr<MobilityModel> b) const;
+  virtual int64_t DoAssignStreams (int64_t stream);
+  virtual bool DoIsDeterministic (void) const;
+};
+
+CountingPropagationLossModel::CountingPropagationLossModel ()
+  : m_calls (0)
+{
+}
+
+double
+CountingPropagationLossModel::DoCalcRxPower (double txPowerDbm,
+                                             Ptr<MobilityModel> a,
+                                             Ptr<MobilityModel> b) const
+{
+  m_calls++;
+  return txPowerDbm - 10;
+}
+
+int64_t
+CountingPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  return 0;
+}
+
+bool
+CountingPropagationLossModel::DoIsDeterministic (void) const
+{
+  return true;
+}
+
+class CachedPropagationLossModelTestCase : public TestCase
+{
+public:
+  CachedPropagationLossModelTestCase ();
+  virtual ~CachedPropagationLossModelTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+CachedPropagationLossModelTestCase::CachedPropagationLossModelTestCase ()
+  : TestCase ("Test CachedPropagationLossModel")
+{
+}
+
+CachedPropagationLossModelTestCase::~CachedPropagationLossModelTestCase ()
+{
+}
+
+void
+CachedPropagationLossModelTestCase::DoRun (void)
+{
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<MobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<MobilityModel> c = CreateObject<ConstantPositionMobilityModel> ();
+  b->SetPosition (Vector (100, 0, 0));
+  c->SetPosition (Vector (0, 100, 0));
+
+  // The matrix model is reconfigured through its setters, which the
+  // cache notices, and through its DefaultLoss attribute, which it does not.
+  Ptr<MatrixPropagationLossModel> matrix = CreateObject<MatrixPropagationLossModel> ();
+  matrix->SetDefaultLoss (0);
+  matrix->SetLoss (a, b, 10);
+  Ptr<CachedPropagationLossModel> cached = CreateObject<CachedPropagationLossModel> ();
+  cached->SetModel (matrix);
+  NS_TEST_ASSERT_MSG_EQ (cached->IsDeterministic (), true, "Matrix model is deterministic");
+
+  NS_TEST_ASSERT_MSG_EQ (cached->CalcRxPower (0, a, b), -10, "Loss a -> b incorrect");
+  NS_TEST_ASSERT_MSG_EQ (cached->CalcRxPower (0, a, c), 0, "Loss a -> c incorrect");
+  matrix->SetLoss (a, b, 20);
+  NS_TEST_ASSERT_MSG_EQ (cached->CalcRxPower (0, a, b), -20, "SetLoss should invalidate the cache");
+  NS_TEST_ASSERT_MSG_EQ (cached->CalcRxPower (3, a, b), -17, "Tx power change should bypass the cache");
+  NS_TEST_ASSERT_MSG_EQ (cached->CalcRxPower (0, b, a), -20, "Paths are directed");
+  matrix->SetAttribute ("DefaultLoss", DoubleValue (50));
+  cached->Flush ();
+  NS_TEST_ASSERT_MSG_EQ (cached->CalcRxPower (0, a, c), -50, "Flush should invalidate the cache");
+
+  // Whether a value is served from the cache is told by the number of
+  // evaluations of the wrapped model
+  Ptr<CountingPropagationLossModel> counting = CreateObject<CountingPropagationLossModel> ();
+  cached->SetModel (counting);
+  cached->CalcRxPower (0, a, b);
+  cached->CalcRxPower (0, a, b);
+  NS_TEST_ASSERT_MSG_EQ (counting->m_calls, 1, "Loss a -> b should be cached");
+  b->SetPosition (Vector (200, 0, 0));
+  cached->CalcRxPower (0, a, b);
+  NS_TEST_ASSERT_MSG_EQ (counting->m_calls, 2, "Course change should invalidate the cache");
+  a->SetPosition (Vector (1, 0, 0));
+  cached->CalcRxPower (0, a, b);
+  NS_TEST_ASSERT_MSG_EQ (counting->m_calls, 3, "Course change should invalidate the cache");
+
+  // Replacing a model of the chain invalidates the cache, even though
+  // the new chain has seen as many changes as the old one
+  Ptr<MatrixPropagationLossModel> second = CreateObject<MatrixPropagationLossModel> ();
+  second->SetDefaultLoss (5);
+  counting->SetNext (second);
+  cached->SetModel (counting);
+  NS_TEST_ASSERT_MSG_EQ (cached->CalcRxPower (0, a, b), -15, "Loss of the chain incorrect");
+  Ptr<MatrixPropagationLossModel> replacement = CreateObject<MatrixPropagationLossModel> ();
+  replacement->SetAttribute ("DefaultLoss", DoubleValue (0));
+  counting->SetNext (replacement);
+  NS_TEST_ASSERT_MSG_EQ (cached->CalcRxPower (0, a, b), -10, "SetNext should invalidate the cache");
+  counting->SetNext (0);
+
+  // The cache is flushed when full
+  cached->SetAttribute ("MaxEntries", UintegerValue (2));
+  cached->Flush ();
+  uint32_t calls = counting->m_calls;
+  cached->CalcRxPower (0, a, b);
+  cached->CalcRxPower (0, a, c);
+  cached->CalcRxPower (0, a, b);
+  NS_TEST_ASSERT_MSG_EQ (counting->m_calls, calls + 2, "Loss a -> b should be cached");
+  cached->CalcRxPower (0, b, c);
+  cached->CalcRxPower (0, a, b);
+  NS_TEST_ASSERT_MSG_EQ (counting->m_calls, calls + 4, "Full cache should have been flushed");
+
+  // An endpoint at rest which starts moving without a course change
+  Ptr<ConstantAccelerationMobilityModel> accelerating = CreateObject<ConstantAccelerationMobilityModel> ();
+  accelerating->SetVelocityAndAcceleration (Vector (0, 0, 0), Vector (1, 0, 0));
+  Ptr<LogDistancePropagationLossModel> logDistance = CreateObject<LogDistancePropagationLossModel> ();
+  cached->SetModel (logDistance);
+  NS_TEST_ASSERT_MSG_EQ (cached->CalcRxPower (0, b, accelerating), logDistance->CalcRxPower (0, b, accelerating),
+                         "Loss b -> accelerating incorrect");
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (cached->CalcRxPower (0, b, accelerating), logDistance->CalcRxPower (0, b, accelerating),
+                         "Movement without course change should invalidate the cache");
+
+  // A chain containing a stochastic model must never be cached
+  Ptr<RandomPropagationLossModel> random = CreateObject<RandomPropagationLossModel> ();
+  random->SetAttribute ("Variable", StringValue ("ns3::UniformRandomVariable[Min=0.0|Max=10.0]"));
+  logDistance->SetNext (random);
+  cached->SetModel (logDistance);
+  NS_TEST_ASSERT_MSG_EQ (cached->IsDeterministic (), false, "Random model is not deterministic");
+  double first = cached->CalcRxPower (0, a, b);
+  bool differs = false;
+  for (uint32_t i = 0; i < 10 && !differs; ++i)
+    {
+      differs = cached->CalcRxPower (0, a, b) != first;
+    }
+  NS_TEST_ASSERT_MSG_EQ (differs, true, "Stochastic model should bypass the cache");
+
+  Simulator::Destroy ();
+}
+
+class PropagationBatchTestCase : public TestCase
+{
+public:
+  PropagationBatchTestCase ();
+  virtual ~PropagationBatchTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Compare the batch and the scalar results of a loss model
+   * \param model the loss model
+   * \param a the source
+   * \param receivers the destinations
+   */
+  void CheckLoss (Ptr<PropagationLossModel> model, Ptr<MobilityModel> a, const PropagationBatch &receivers);
+};
+
+PropagationBatchTestCase::PropagationBatchTestCase ()
+  : TestCase ("Check that batch evaluation of loss and delay models matches the scalar one")
+{
+}
+
+PropagationBatchTestCase::~PropagationBatchTestCase ()
+{
+}
+
+void
+PropagationBatchTestCase::CheckLoss (Ptr<PropagationLossModel> model, Ptr<MobilityModel> a, const PropagationBatch &receivers)
+{
+  std::vector<double> rxPowerDbm (receivers.GetN ());
+  model->CalcRxPowerBatch (16.0, a, receivers, &rxPowerDbm[0]);
+  for (uint32_t i = 0; i < receivers.GetN (); ++i)
+    {
+      double expected = model->CalcRxPower (16.0, a, receivers.Get (i));
+      NS_TEST_EXPECT_MSG_EQ_TOL (rxPowerDbm[i], expected, 1e-9,
+                                 model->GetInstanceTypeId ().GetName () << " receiver " << i);
+    }
+}
+
+void
+PropagationBatchTestCase::DoRun (void)
+{
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (0, 0, 1.5));
+
+  // receivers at, before and beyond the boundaries of the models
+  double distances[] = { 0, 0.3, 1, 1.5, 10, 80, 199.9, 200, 350, 500, 800, 2000, 10000 };
+  PropagationBatch receivers;
+  for (uint32_t i = 0; i < sizeof (distances) / sizeof (distances[0]); ++i)
+    {
+      Ptr<MobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+      b->SetPosition (Vector (distances[i], 0, 1.5 + i % 3));
+      receivers.Add (b);
+    }
+  NS_TEST_ASSERT_MSG_EQ (receivers.GetN (), 13, "Unexpected number of receivers");
+
+  CheckLoss (CreateObject<FriisPropagationLossModel> (), a, receivers);
+  Ptr<FriisPropagationLossModel> friis = CreateObject<FriisPropagationLossModel> ();
+  friis->SetMinLoss (30);
+  CheckLoss (friis, a, receivers);
+  CheckLoss (CreateObject<TwoRayGroundPropagationLossModel> (), a, receivers);
+  Ptr<TwoRayGroundPropagationLossModel> twoRay = CreateObject<TwoRayGroundPropagationLossModel> ();
+  twoRay->SetHeightAboveZ (10);
+  CheckLoss (twoRay, a, receivers);
+  CheckLoss (CreateObject<LogDistancePropagationLossModel> (), a, receivers);
+  CheckLoss (CreateObject<ThreeLogDistancePropagationLossModel> (), a, receivers);
+  CheckLoss (CreateObject<RangePropagationLossModel> (), a, receivers);
+
+  // chains mixing batch kernels and the per-receiver fallback
+  Ptr<LogDistancePropagationLossModel> logDistance = CreateObject<LogDistancePropagationLossModel> ();
+  Ptr<RangePropagationLossModel> range = CreateObject<RangePropagationLossModel> ();
+  Ptr<FriisPropagationLossModel> last = CreateObject<FriisPropagationLossModel> ();
+  logDistance->SetNext (range);
+  range->SetNext (last);
+  CheckLoss (logDistance, a, receivers);
+
+  Ptr<ConstantSpeedPropagationDelayModel> delayModel = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  std::vector<Time> delays (receivers.GetN ());
+  delayModel->GetDelayBatch (a, receivers, &delays[0]);
+  for (uint32_t i = 0; i < receivers.GetN (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (delays[i], delayModel->GetDelay (a, receivers.Get (i)), "receiver " << i);
+    }
+
+  receivers.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (receivers.GetN (), 0, "Batch should be empty");
+  Simulator::Destroy ();
+}
+
 class PropagationLossModelsTestSuite : public TestSuite
 {
 public:
@@ -450,6 +705,8 @@ PropagationLossModelsTestSuite::PropagationLossModelsTestSuite ()
   AddTestCase (new LogDistancePropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new MatrixPropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new RangePropagationLossModelTestCase, TestCase::QUICK);
+  AddTestCase (new CachedPropagationLossModelTestCase, TestCase::QUICK);
+  AddTestCase (new PropagationBatchTestCase, TestCase::QUICK);
 }
 
 static PropagationLossModelsTestSuite propagationLossModelsTestSuite;
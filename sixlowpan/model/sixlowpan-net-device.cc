@@ -39,6 +39,7 @@
 #include "ns3/udp-l4-protocol.h"
 #include "sixlowpan-net-device.h"
 #include "sixlowpan-header.h"
+#include <algorithm>
 
 NS_LOG_COMPONENT_DEFINE ("SixLowPanNetDevice");
 
@@ -151,11 +152,8 @@ void SixLowPanNetDevice::DoDispose ()
   m_netDevice = 0;
   m_node = 0;
 
-  for (MapFragmentsTimersI_t iter = m_fragmentsTimers.begin (); iter != m_fragmentsTimers.end (); iter++)
-    {
-      iter->second.Cancel ();
-    }
-  m_fragmentsTimers.clear ();
+  m_timeoutEvent.Cancel ();
+  m_timeoutEventList.clear ();
 
   for (MapFragmentsI_t iter = m_fragments.begin (); iter != m_fragments.end (); iter++)
     {
@@ -1865,37 +1863,27 @@ bool SixLowPanNetDevice::ProcessFragment (Ptr<Packet>& packet, Address const &sr
       // erase the oldest packet.
       if ( m_fragmentReassemblyListSize && (m_fragments.size () >= m_fragmentReassemblyListSize) )
         {
-          MapFragmentsTimers_t::iterator iter;
-          MapFragmentsTimers_t::iterator iterFound = m_fragmentsTimers.begin ();
-          for ( iter = m_fragmentsTimers.begin (); iter != m_fragmentsTimers.end (); iter++)
-            {
-              if ( iter->second.GetTs () < iterFound->second.GetTs () )
-                {
-                  iterFound = iter;
-                }
-            }
-          FragmentKey oldestKey = iterFound->first;
+          // the expirations are sorted: the oldest packet is the first
+          FragmentKey oldestKey = m_timeoutEventList.front ().key;
+          m_timeoutEventList.pop_front ();
 
-          std::list< Ptr<Packet> > storedFragments = m_fragments[oldestKey]->GetFraments ();
+          MapFragments_t::iterator oldest = m_fragments.find (oldestKey);
+          std::list< Ptr<Packet> > storedFragments = oldest->second->GetFraments ();
           for (std::list< Ptr<Packet> >::iterator fragIter = storedFragments.begin ();
                fragIter != storedFragments.end (); fragIter++)
             {
               m_dropTrace (DROP_FRAGMENT_BUFFER_FULL, *fragIter, m_node->GetObject<SixLowPanNetDevice> (), GetIfIndex ());
             }
 
-          m_fragmentsTimers[oldestKey].Cancel ();
-          m_fragmentsTimers.erase (oldestKey);
-          m_fragments[oldestKey] = 0;
-          m_fragments.erase (oldestKey);
+          oldest->second = 0;
+          m_fragments.erase (oldest);
 
         }
       fragments = Create<Fragments> ();
       fragments->SetPacketSize (packetSize);
       m_fragments.insert (std::make_pair (key, fragments));
       uint32_t ifIndex = GetIfIndex ();
-      m_fragmentsTimers[key] = Simulator::Schedule (m_fragmentExpirationTimeout,
-                                                    &SixLowPanNetDevice::HandleFragmentsTimeout, this,
-                                                    key, ifIndex);
+      fragments->SetTimeoutIter (SetTimeout (key, ifIndex));
     }
   else
     {
@@ -1920,14 +1908,12 @@ bool SixLowPanNetDevice::ProcessFragment (Ptr<Packet>& packet, Address const &sr
       packet->RemoveHeader (frag1Header);
 
       NS_LOG_LOGIC ("Rebuilt packet. Size " << packet->GetSize () << " - " << *packet);
+      NS_LOG_LOGIC ("Removing the 6LoWPAN fragments expiration at " << Simulator::Now ().GetSeconds () << " due to complete packet");
+      // the expiration event is left alone: it will find the next
+      // expiration when it fires
+      m_timeoutEventList.erase (fragments->GetTimeoutIter ());
       fragments = 0;
       m_fragments.erase (key);
-      if (m_fragmentsTimers[key].IsRunning ())
-        {
-          NS_LOG_LOGIC ("Stopping 6LoWPAN WaitFragmentsTimer at " << Simulator::Now ().GetSeconds () << " due to complete packet");
-          m_fragmentsTimers[key].Cancel ();
-        }
-      m_fragmentsTimers.erase (key);
       return true;
     }
 
@@ -1938,6 +1924,8 @@ SixLowPanNetDevice::Fragments::Fragments ()
 {
   NS_LOG_FUNCTION (this);
   m_packetSize = 0;
+  m_firstUncovered = m_fragments.end ();
+  m_coveredEnd = 0;
 }
 
 SixLowPanNetDevice::Fragments::~Fragments ()
@@ -1949,25 +1937,32 @@ void SixLowPanNetDevice::Fragments::AddFragment (Ptr<Packet> fragment, uint16_t
 {
   NS_LOG_FUNCTION (this << fragmentOffset << *fragment);
 
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::iterator it;
-  bool duplicate = false;
+  std::pair<std::map<uint16_t, Ptr<Packet> >::iterator, bool> inserted =
+    m_fragments.insert (std::make_pair (fragmentOffset, fragment));
+  std::map<uint16_t, Ptr<Packet> >::iterator it = inserted.first;
+  if (!inserted.second)
+    {
+      NS_ASSERT_MSG (fragment->GetSize () == it->second->GetSize (), "Duplicate fragment size differs. Aborting.");
+      return;
+    }
 
-  for (it = m_fragments.begin (); it != m_fragments.end (); it++)
+  if (m_firstUncovered == m_fragments.end () || fragmentOffset < m_firstUncovered->first)
     {
-      if (it->second > fragmentOffset)
+      if (fragmentOffset <= m_coveredEnd)
         {
-          break;
+          // the fragment starts in the covered part, which it may extend
+          m_coveredEnd = std::max (m_coveredEnd, fragment->GetSize () + fragmentOffset);
         }
-      if (it->second == fragmentOffset)
+      else
         {
-          duplicate = true;
-          NS_ASSERT_MSG (fragment->GetSize () == it->first->GetSize (), "Duplicate fragment size differs. Aborting.");
-          break;
+          m_firstUncovered = it;
         }
     }
-  if (!duplicate)
+  // fragments might overlap in strange ways
+  while (m_firstUncovered != m_fragments.end () && m_firstUncovered->first <= m_coveredEnd)
     {
-      m_fragments.insert (it, std::make_pair (fragment, fragmentOffset));
+      m_coveredEnd = std::max (m_coveredEnd, m_firstUncovered->second->GetSize () + m_firstUncovered->first);
+      m_firstUncovered++;
     }
 }
 
@@ -1982,59 +1977,35 @@ bool SixLowPanNetDevice::Fragments::IsEntire () const
 {
   NS_LOG_FUNCTION (this);
 
-  bool ret = m_fragments.size () > 0;
-  uint16_t lastEndOffset = 0;
-
-  if (ret)
-    {
-      for (std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin (); it != m_fragments.end (); it++)
-        {
-          // overlapping fragments should not exist
-          NS_LOG_LOGIC ("Checking overlaps " << lastEndOffset << " - " << it->second );
-
-          if (lastEndOffset < it->second)
-            {
-              ret = false;
-              break;
-            }
-          // fragments might overlap in strange ways
-          uint16_t fragmentEnd = it->first->GetSize () + it->second;
-          lastEndOffset = std::max ( lastEndOffset, fragmentEnd );
-        }
-    }
-
-  if ( ret && (lastEndOffset == m_packetSize))
-    {
-      return true;
-    }
-  return false;
+  return m_fragments.size () > 0 && m_firstUncovered == m_fragments.end ()
+         && m_coveredEnd == m_packetSize;
 }
 
 Ptr<Packet> SixLowPanNetDevice::Fragments::GetPacket () const
 {
   NS_LOG_FUNCTION (this);
 
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator it = m_fragments.begin ();
+  std::map<uint16_t, Ptr<Packet> >::const_iterator it = m_fragments.begin ();
 
   Ptr<Packet> p = Create<Packet> ();
   uint16_t lastEndOffset = 0;
 
   p->AddAtEnd (m_firstFragment);
   it = m_fragments.begin ();
-  lastEndOffset = it->first->GetSize ();
+  lastEndOffset = it->second->GetSize ();
 
   for ( it++; it != m_fragments.end (); it++)
     {
-      if ( lastEndOffset > it->second )
+      if ( lastEndOffset > it->first )
         {
           NS_ABORT_MSG ("Overlapping fragments found, forbidden condition");
         }
       else
         {
-          NS_LOG_LOGIC ("Adding: " << *(it->first) );
-          p->AddAtEnd (it->first);
+          NS_LOG_LOGIC ("Adding: " << *(it->second) );
+          p->AddAtEnd (it->second);
         }
-      lastEndOffset += it->first->GetSize ();
+      lastEndOffset += it->second->GetSize ();
     }
 
   return p;
@@ -2049,14 +2020,24 @@ void SixLowPanNetDevice::Fragments::SetPacketSize (uint32_t packetSize)
 std::list< Ptr<Packet> > SixLowPanNetDevice::Fragments::GetFraments () const
 {
   std::list< Ptr<Packet> > fragments;
-  std::list<std::pair<Ptr<Packet>, uint16_t> >::const_iterator iter;
+  std::map<uint16_t, Ptr<Packet> >::const_iterator iter;
   for ( iter = m_fragments.begin (); iter != m_fragments.end (); iter ++)
     {
-      fragments.push_back (iter->first);
+      fragments.push_back (iter->second);
     }
   return fragments;
 }
 
+void SixLowPanNetDevice::Fragments::SetTimeoutIter (FragmentsTimeoutsListI_t iter)
+{
+  m_timeoutIter = iter;
+}
+
+SixLowPanNetDevice::FragmentsTimeoutsListI_t SixLowPanNetDevice::Fragments::GetTimeoutIter () const
+{
+  return m_timeoutIter;
+}
+
 void SixLowPanNetDevice::HandleFragmentsTimeout (FragmentKey key, uint32_t iif)
 {
   NS_LOG_FUNCTION (this);
@@ -2071,8 +2052,76 @@ void SixLowPanNetDevice::HandleFragmentsTimeout (FragmentKey key, uint32_t iif)
   // clear the buffers
   it->second = 0;
 
-  m_fragments.erase (key);
-  m_fragmentsTimers.erase (key);
+  m_fragments.erase (it);
+}
+
+SixLowPanNetDevice::FragmentsTimeoutsListI_t SixLowPanNetDevice::SetTimeout (FragmentKey key, uint32_t iif)
+{
+  NS_LOG_FUNCTION (this << iif);
+
+  FragmentsTimeout timeout;
+  timeout.expiration = Simulator::Now () + m_fragmentExpirationTimeout;
+  timeout.key = key;
+  timeout.iif = iif;
+
+  // all the fragmented packets get the same timeout, so that the new
+  // one is normally the last to expire
+  FragmentsTimeoutsListI_t iter = m_timeoutEventList.end ();
+  while (iter != m_timeoutEventList.begin ())
+    {
+      FragmentsTimeoutsListI_t previous = iter;
+      previous--;
+      if (previous->expiration <= timeout.expiration)
+        {
+          break;
+        }
+      iter = previous;
+    }
+  iter = m_timeoutEventList.insert (iter, timeout);
+
+  if (iter == m_timeoutEventList.begin ()
+      && (!m_timeoutEvent.IsRunning () || Simulator::GetDelayLeft (m_timeoutEvent) > m_fragmentExpirationTimeout))
+    {
+      m_timeoutEvent.Cancel ();
+      m_timeoutEvent = Simulator::Schedule (m_fragmentExpirationTimeout, &SixLowPanNetDevice::HandleTimeout, this);
+    }
+  return iter;
+}
+
+void SixLowPanNetDevice::HandleTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time now = Simulator::Now ();
+  while (!m_timeoutEventList.empty () && m_timeoutEventList.front ().expiration <= now)
+    {
+      FragmentsTimeout timeout = m_timeoutEventList.front ();
+      m_timeoutEventList.pop_front ();
+      HandleFragmentsTimeout (timeout.key, timeout.iif);
+    }
+
+  if (!m_timeoutEventList.empty ())
+    {
+      m_timeoutEvent = Simulator::Schedule (m_timeoutEventList.front ().expiration - now,
+                                            &SixLowPanNetDevice::HandleTimeout, this);
+    }
+}
+
+size_t SixLowPanNetDevice::FragmentKeyHash::operator () (const FragmentKey &key) const
+{
+  uint8_t buffer[Address::MAX_SIZE];
+  size_t hash = (key.second.first * 2654435761U) ^ key.second.second;
+  uint32_t length = key.first.first.CopyTo (buffer);
+  for (uint32_t i = 0; i < length; i++)
+    {
+      hash = hash * 31 + buffer[i];
+    }
+  length = key.first.second.CopyTo (buffer);
+  for (uint32_t i = 0; i < length; i++)
+    {
+      hash = hash * 31 + buffer[i];
+    }
+  return hash;
 }
 
 Ipv6Address SixLowPanNetDevice::MakeLinkLocalAddressFromMac (Address const &addr)
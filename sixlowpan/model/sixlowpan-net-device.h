@@ -25,6 +25,7 @@
 #include <stdint.h>
 #include <string>
 #include <map>
+#include <list>
 #include "ns3/traced-callback.h"
 #include "ns3/event-id.h"
 #include "ns3/nstime.h"
@@ -32,6 +33,7 @@
 #include "ns3/packet.h"
 #include "sixlowpan-header.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/sgi-hashmap.h"
 
 namespace ns3 {
 
@@ -370,6 +372,37 @@ private:
    */
   typedef std::pair< std::pair<Address, Address>, std::pair<uint16_t, uint16_t> > FragmentKey;
 
+  /**
+   * \brief Hash function class for the fragment identifiers.
+   */
+  struct FragmentKeyHash
+  {
+    /**
+     * \param [in] key The fragment identifier.
+     * \returns The hash of the identifier.
+     */
+    size_t operator () (const FragmentKey &key) const;
+  };
+
+  /**
+   * \brief The expiration of a fragmented packet.
+   */
+  struct FragmentsTimeout
+  {
+    Time expiration;  //!< Expiration time.
+    FragmentKey key;  //!< Identifier of the packet fragments.
+    uint32_t iif;     //!< Input Interface.
+  };
+
+  /**
+   * Container of the fragment expirations, sorted by expiration time.
+   */
+  typedef std::list<FragmentsTimeout> FragmentsTimeoutsList_t;
+  /**
+   * Container Iterator of the fragment expirations.
+   */
+  typedef std::list<FragmentsTimeout>::iterator FragmentsTimeoutsListI_t;
+
   /**
    * \class Fragments
    * \brief A Set of Fragment.
@@ -424,6 +457,18 @@ public:
      */
     std::list< Ptr<Packet> > GetFraments () const;
 
+    /**
+     * \brief Set the expiration of the fragmented packet.
+     * \param [in] iter An iterator to the expiration.
+     */
+    void SetTimeoutIter (FragmentsTimeoutsListI_t iter);
+
+    /**
+     * \brief Get the expiration of the fragmented packet.
+     * \returns An iterator to the expiration.
+     */
+    FragmentsTimeoutsListI_t GetTimeoutIter () const;
+
 private:
     /**
      * \brief The size of the reconstructed packet (bytes).
@@ -431,9 +476,25 @@ private:
     uint32_t m_packetSize;
 
     /**
-     * \brief The current fragments.
+     * \brief The current fragments, by offset.
+     */
+    std::map<uint16_t, Ptr<Packet> > m_fragments;
+
+    /**
+     * \brief The first fragment which does not extend the part of the
+     * packet covered from offset 0 without holes.
      */
-    std::list<std::pair<Ptr<Packet>, uint16_t> > m_fragments;
+    std::map<uint16_t, Ptr<Packet> >::iterator m_firstUncovered;
+
+    /**
+     * \brief The end offset of the part covered by these fragments.
+     */
+    uint32_t m_coveredEnd;
+
+    /**
+     * \brief The expiration of the fragmented packet.
+     */
+    FragmentsTimeoutsListI_t m_timeoutIter;
 
     /**
      * \brief The very first fragment.
@@ -470,29 +531,36 @@ private:
   void HandleFragmentsTimeout ( FragmentKey key, uint32_t iif);
 
   /**
-   * \brief Drops the oldest fragment set.
+   * \brief Set a new timeout for a fragmented packet.
+   * \param [in] key A key representing the packet fragments.
+   * \param [in] iif Input Interface.
+   * \returns An iterator to the expiration.
    */
-  void DropOldestFragmentSet ();
+  FragmentsTimeoutsListI_t SetTimeout (FragmentKey key, uint32_t iif);
 
   /**
-   * Container for fragment key -> fragments.
+   * \brief Expire the fragmented packets whose timeout is reached,
+   * and schedule the next expiration.
    */
-  typedef std::map< FragmentKey, Ptr<Fragments> > MapFragments_t;
+  void HandleTimeout (void);
+
   /**
-   * Container Iterator for fragment key -> fragments.
+   * \brief Drops the oldest fragment set.
    */
-  typedef std::map< FragmentKey, Ptr<Fragments> >::iterator MapFragmentsI_t;
+  void DropOldestFragmentSet ();
+
   /**
-   * Container for fragment key -> expiration event.
+   * Container for fragment key -> fragments.
    */
-  typedef std::map< FragmentKey, EventId > MapFragmentsTimers_t;
+  typedef sgi::hash_map< FragmentKey, Ptr<Fragments>, FragmentKeyHash > MapFragments_t;
   /**
-   * Container Iterator for fragment key -> expiration event.
+   * Container Iterator for fragment key -> fragments.
    */
-  typedef std::map< FragmentKey, EventId >::iterator MapFragmentsTimersI_t;
+  typedef MapFragments_t::iterator MapFragmentsI_t;
 
   MapFragments_t       m_fragments; //!< Fragments hold to be rebuilt.
-  MapFragmentsTimers_t m_fragmentsTimers; //!< Timers related to fragment rebuilding.
+  FragmentsTimeoutsList_t m_timeoutEventList; //!< Expirations of the fragments hold, sorted by time.
+  EventId              m_timeoutEvent; //!< Event of the earliest fragment expiration.
   Time                 m_fragmentExpirationTimeout; //!< Time limit for fragment rebuilding.
 
   /**
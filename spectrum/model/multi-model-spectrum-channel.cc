@@ -34,6 +34,7 @@
 #include <ns3/propagation-delay-model.h>
 #include <ns3/antenna-model.h>
 #include <ns3/angles.h>
+#include <algorithm>
 #include <iostream>
 #include <utility>
 #include "multi-model-spectrum-channel.h"
@@ -76,6 +77,8 @@ RxSpectrumModelInfo::RxSpectrumModelInfo (Ptr<const SpectrumModel> rxSpectrumMod
 
 
 MultiModelSpectrumChannel::MultiModelSpectrumChannel ()
+  : m_numDevices (0),
+    m_psdPoolNext (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -89,6 +92,8 @@ MultiModelSpectrumChannel::DoDispose ()
   m_spectrumPropagationLoss = 0;
   m_txSpectrumModelInfoMap.clear ();
   m_rxSpectrumModelInfoMap.clear ();
+  m_psdPool.clear ();
+  m_receivers.Clear ();
   SpectrumChannel::DoDispose ();
 }
 
@@ -113,6 +118,18 @@ MultiModelSpectrumChannel::GetTypeId (void)
                    DoubleValue (1.0e9),
                    MakeDoubleAccessor (&MultiModelSpectrumChannel::m_maxLossDb),
                    MakeDoubleChecker<double> ())
+    .AddAttribute ("MaxRange",
+                   "If the transmitter and the receivers have a MobilityModel, "
+                   "this value represents the maximum distance in meters "
+                   "at which transmissions will be passed to the receiving "
+                   "PHYs. The receivers farther away are skipped before the "
+                   "propagation models are evaluated, and no PathLoss trace "
+                   "is fired for them. Like MaxLossDb, this parameter is to "
+                   "be used to reduce the computational load; the default "
+                   "value corresponds to considering all signals for reception.",
+                   DoubleValue (1.0e9),
+                   MakeDoubleAccessor (&MultiModelSpectrumChannel::m_maxRange),
+                   MakeDoubleChecker<double> (0.0))
     .AddTraceSource ("PathLoss",
                      "This trace is fired whenever a new path loss value "
                      "is calculated. The first and second parameters "
@@ -201,7 +218,7 @@ MultiModelSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
 }
 
 
-TxSpectrumModelInfoMap_t::const_iterator
+TxSpectrumModelInfoMap_t::iterator
 MultiModelSpectrumChannel::FindAndEventuallyAddTxSpectrumModel (Ptr<const SpectrumModel> txSpectrumModel)
 {
   NS_LOG_FUNCTION (this << txSpectrumModel);
@@ -245,6 +262,64 @@ MultiModelSpectrumChannel::FindAndEventuallyAddTxSpectrumModel (Ptr<const Spectr
 
     
 
+Ptr<const SpectrumValue>
+MultiModelSpectrumChannel::ConvertTxPsd (TxSpectrumModelInfo &txInfo,
+                                         Ptr<const SpectrumValue> txPsd,
+                                         SpectrumModelUid_t rxSpectrumModelUid)
+{
+  NS_LOG_FUNCTION (this << txPsd << rxSpectrumModelUid);
+  ConvertedPsd &converted = txInfo.m_convertedPsdMap[rxSpectrumModelUid];
+  if (converted.rxPsd != 0
+      && std::equal (txPsd->ConstValuesBegin (), txPsd->ConstValuesEnd (),
+                     converted.txPsd->ConstValuesBegin ()))
+    {
+      NS_LOG_LOGIC ("txPowerSpectrum unchanged, reusing the previous conversion");
+      return converted.rxPsd;
+    }
+  SpectrumConverterMap_t::const_iterator rxConverterIterator = txInfo.m_spectrumConverterMap.find (rxSpectrumModelUid);
+  NS_ASSERT (rxConverterIterator != txInfo.m_spectrumConverterMap.end ());
+  if (converted.txPsd == 0)
+    {
+      converted.txPsd = Copy<SpectrumValue> (txPsd);
+    }
+  else
+    {
+      *converted.txPsd = *txPsd;
+    }
+  converted.rxPsd = rxConverterIterator->second.Convert (txPsd);
+  return converted.rxPsd;
+}
+
+Ptr<SpectrumValue>
+MultiModelSpectrumChannel::CopyPsd (Ptr<const SpectrumValue> psd)
+{
+  // The receivers release the power spectral densities roughly in the
+  // order in which they got them: the buffers following the last one
+  // handed out are the most likely to be free.
+  uint32_t nProbes = std::min<uint32_t> (m_psdPool.size (), 4);
+  for (uint32_t i = 0; i < nProbes; i++)
+    {
+      m_psdPoolNext = (m_psdPoolNext + 1) % m_psdPool.size ();
+      if (m_psdPool[m_psdPoolNext]->GetReferenceCount () == 1)
+        {
+          *m_psdPool[m_psdPoolNext] = *psd;
+          return m_psdPool[m_psdPoolNext];
+        }
+    }
+  Ptr<SpectrumValue> copy = Copy<SpectrumValue> (psd);
+  if (m_psdPool.size () < 4 * m_numDevices)
+    {
+      m_psdPool.push_back (copy);
+      m_psdPoolNext = m_psdPool.size () - 1;
+    }
+  else if (nProbes > 0)
+    {
+      // the probed buffer is still held by its receiver, which keeps it alive
+      m_psdPool[m_psdPoolNext] = copy;
+    }
+  return copy;
+}
+
 void
 MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
 {
@@ -259,13 +334,56 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
   NS_LOG_LOGIC (" txSpectrumModelUid " << txSpectrumModelUid);
 
   //
-  TxSpectrumModelInfoMap_t::const_iterator txInfoIteratorerator = FindAndEventuallyAddTxSpectrumModel (txParams->psd->GetSpectrumModel ());
+  TxSpectrumModelInfoMap_t::iterator txInfoIteratorerator = FindAndEventuallyAddTxSpectrumModel (txParams->psd->GetSpectrumModel ());
   NS_ASSERT (txInfoIteratorerator != m_txSpectrumModelInfoMap.end ());
 
   NS_LOG_LOGIC ("converter map for TX SpectrumModel with Uid " << txInfoIteratorerator->first);
   NS_LOG_LOGIC ("converter map size: " << txInfoIteratorerator->second.m_spectrumConverterMap.size ());
   NS_LOG_LOGIC ("converter map first element: " << txInfoIteratorerator->second.m_spectrumConverterMap.begin ()->first);
 
+  // Evaluate the propagation models for all the receivers having a
+  // mobility model and within MaxRange in a single pass.
+  m_receivers.Clear ();
+  m_inRange.clear ();
+  if (txMobility)
+    {
+      Vector txPosition = txMobility->GetPosition ();
+      for (RxSpectrumModelInfoMap_t::const_iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
+           rxInfoIterator != m_rxSpectrumModelInfoMap.end ();
+           ++rxInfoIterator)
+        {
+          for (std::set<Ptr<SpectrumPhy> >::const_iterator rxPhyIterator = rxInfoIterator->second.m_rxPhySet.begin ();
+               rxPhyIterator != rxInfoIterator->second.m_rxPhySet.end ();
+               ++rxPhyIterator)
+            {
+              Ptr<MobilityModel> receiverMobility = (*rxPhyIterator)->GetMobility ();
+              if ((*rxPhyIterator) != txParams->txPhy && receiverMobility)
+                {
+                  Vector rxPosition = receiverMobility->GetPosition ();
+                  bool inRange = CalculateDistance (txPosition, rxPosition) <= m_maxRange;
+                  m_inRange.push_back (inRange);
+                  if (inRange)
+                    {
+                      m_receivers.Add (receiverMobility, rxPosition);
+                    }
+                }
+            }
+        }
+    }
+  uint32_t nReceivers = m_receivers.GetN ();
+  m_propagationGainDb.assign (nReceivers, 0);
+  m_propagationDelays.assign (nReceivers, MicroSeconds (0));
+  if (nReceivers > 0 && m_propagationLoss)
+    {
+      m_propagationLoss->CalcRxPowerBatch (0, txMobility, m_receivers, &m_propagationGainDb[0]);
+    }
+  if (nReceivers > 0 && m_propagationDelay)
+    {
+      m_propagationDelay->GetDelayBatch (txMobility, m_receivers, &m_propagationDelays[0]);
+    }
+  uint32_t rxIndex = 0;
+  uint32_t candidateIndex = 0;
+
   for (RxSpectrumModelInfoMap_t::const_iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
        rxInfoIterator != m_rxSpectrumModelInfoMap.end ();
        ++rxInfoIterator)
@@ -273,20 +391,8 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
       SpectrumModelUid_t rxSpectrumModelUid = rxInfoIterator->second.m_rxSpectrumModel->GetUid ();
       NS_LOG_LOGIC (" rxSpectrumModelUids " << rxSpectrumModelUid);
 
-      Ptr <SpectrumValue> convertedTxPowerSpectrum;
-      if (txSpectrumModelUid == rxSpectrumModelUid)
-        {
-          NS_LOG_LOGIC ("no spectrum conversion needed");
-          convertedTxPowerSpectrum = txParams->psd;
-        }
-      else
-        {
-          NS_LOG_LOGIC (" converting txPowerSpectrum SpectrumModelUids" << txSpectrumModelUid << " --> " << rxSpectrumModelUid);
-          SpectrumConverterMap_t::const_iterator rxConverterIterator = txInfoIteratorerator->second.m_spectrumConverterMap.find (rxSpectrumModelUid);
-          NS_ASSERT (rxConverterIterator != txInfoIteratorerator->second.m_spectrumConverterMap.end ());
-          convertedTxPowerSpectrum = rxConverterIterator->second.Convert (txParams->psd);
-        }
-
+      // converted when the first receiver of this SpectrumModel is found in range
+      Ptr<const SpectrumValue> convertedTxPowerSpectrum;
 
       for (std::set<Ptr<SpectrumPhy> >::const_iterator rxPhyIterator = rxInfoIterator->second.m_rxPhySet.begin ();
            rxPhyIterator != rxInfoIterator->second.m_rxPhySet.end ();
@@ -297,20 +403,25 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
 
           if ((*rxPhyIterator) != txParams->txPhy)
             {
-              NS_LOG_LOGIC (" copying signal parameters " << txParams);
-              Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
-              rxParams->psd = Copy<SpectrumValue> (convertedTxPowerSpectrum);
               Time delay = MicroSeconds (0);
+              double pathGainLinear = 1;
 
               Ptr<MobilityModel> receiverMobility = (*rxPhyIterator)->GetMobility ();
+              bool evaluatePropagation = txMobility && receiverMobility;
 
-              if (txMobility && receiverMobility)
+              if (evaluatePropagation)
                 {
+                  if (!m_inRange[candidateIndex++])
+                    {
+                      NS_LOG_LOGIC ("receiver beyond MaxRange");
+                      continue;
+                    }
+                  uint32_t k = rxIndex++;
                   double pathLossDb = 0;
-                  if (rxParams->txAntenna != 0)
+                  if (txParams->txAntenna != 0)
                     {
                       Angles txAngles (receiverMobility->GetPosition (), txMobility->GetPosition ());
-                      double txAntennaGain = rxParams->txAntenna->GetGainDb (txAngles);
+                      double txAntennaGain = txParams->txAntenna->GetGainDb (txAngles);
                       NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
                       pathLossDb -= txAntennaGain;
                     }
@@ -324,7 +435,7 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
                     }
                   if (m_propagationLoss)
                     {
-                      double propagationGainDb = m_propagationLoss->CalcRxPower (0, txMobility, receiverMobility);
+                      double propagationGainDb = m_propagationGainDb[k];
                       NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
                       pathLossDb -= propagationGainDb;
                     }                    
@@ -335,17 +446,35 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
                       // beyond range
                       continue;
                     }
-                  double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
-                  *(rxParams->psd) *= pathGainLinear;              
+                  pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
+                  delay = m_propagationDelays[k];
+                }
 
-                  if (m_spectrumPropagationLoss)
+              if (convertedTxPowerSpectrum == 0)
+                {
+                  if (txSpectrumModelUid == rxSpectrumModelUid)
                     {
-                      rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, txMobility, receiverMobility);
+                      NS_LOG_LOGIC ("no spectrum conversion needed");
+                      convertedTxPowerSpectrum = txParams->psd;
+                    }
+                  else
+                    {
+                      NS_LOG_LOGIC (" converting txPowerSpectrum SpectrumModelUids" << txSpectrumModelUid << " --> " << rxSpectrumModelUid);
+                      convertedTxPowerSpectrum = ConvertTxPsd (txInfoIteratorerator->second, txParams->psd, rxSpectrumModelUid);
                     }
+                }
 
-                  if (m_propagationDelay)
+              NS_LOG_LOGIC (" copying signal parameters " << txParams);
+              Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
+              rxParams->psd = CopyPsd (convertedTxPowerSpectrum);
+
+              if (evaluatePropagation)
+                {
+                  *(rxParams->psd) *= pathGainLinear;              
+
+                  if (m_spectrumPropagationLoss)
                     {
-                      delay = m_propagationDelay->GetDelay (txMobility, receiverMobility);
+                      rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, txMobility, receiverMobility);
                     }
                 }
 
@@ -27,8 +27,10 @@
 #include <ns3/spectrum-channel.h>
 #include <ns3/spectrum-propagation-loss-model.h>
 #include <ns3/propagation-delay-model.h>
+#include <ns3/propagation-batch.h>
 #include <map>
 #include <set>
+#include <vector>
 
 namespace ns3 {
 
@@ -36,6 +38,22 @@ namespace ns3 {
 typedef std::map<SpectrumModelUid_t, SpectrumConverter> SpectrumConverterMap_t;
 
 
+/**
+ * \ingroup spectrum
+ *
+ * The last TX power spectral density converted to a RX SpectrumModel.
+ * Transmitters usually send many signals with the same power spectral
+ * density, which is then converted only once.
+ */
+struct ConvertedPsd
+{
+  Ptr<SpectrumValue> txPsd;  //!< copy of the values of the TX power spectral density
+  Ptr<SpectrumValue> rxPsd;  //!< txPsd converted to the RX SpectrumModel
+};
+
+typedef std::map<SpectrumModelUid_t, ConvertedPsd> ConvertedPsdMap_t;
+
+
 /**
  * \ingroup spectrum
  *
@@ -47,6 +65,7 @@ public:
 
   Ptr<const SpectrumModel> m_txSpectrumModel;
   SpectrumConverterMap_t m_spectrumConverterMap;
+  ConvertedPsdMap_t m_convertedPsdMap;  //!< last conversion to each RX SpectrumModel
 };
 
 typedef std::map<SpectrumModelUid_t, TxSpectrumModelInfo> TxSpectrumModelInfoMap_t;
@@ -77,6 +96,14 @@ typedef std::map<SpectrumModelUid_t, RxSpectrumModelInfo> RxSpectrumModelInfoMap
  * SpectrumPhy instances which can use
  * different spectrum models, i.e.,  different SpectrumModel. 
  *
+ * The conversion of the power spectral density of a transmission to
+ * the SpectrumModel of each group of receivers is skipped when the
+ * values are the same as in the previous transmission with the same
+ * SpectrumModel, and the power spectral densities handed to the
+ * receivers are taken from a pool of buffers which the receivers have
+ * released. The MaxRange attribute keeps the receivers too far away
+ * from the transmitter out of the evaluation of the propagation models.
+ *
  * \note It is allowed for a receiving SpectrumPhy to switch to a
  * different SpectrumModel during the simulation. The requirement
  * for this to work is that, after the SpectrumPhy switched its
@@ -122,7 +149,31 @@ private:
    *
    * @return an iterator pointing to the corresponding entry in m_txSpectrumModelInfoMap
    */
-  TxSpectrumModelInfoMap_t::const_iterator FindAndEventuallyAddTxSpectrumModel (Ptr<const SpectrumModel> txSpectrumModel);
+  TxSpectrumModelInfoMap_t::iterator FindAndEventuallyAddTxSpectrumModel (Ptr<const SpectrumModel> txSpectrumModel);
+
+  /**
+   * Convert a TX power spectral density to a RX SpectrumModel, reusing
+   * the previous conversion if the values did not change.
+   *
+   * @param txInfo the entry of m_txSpectrumModelInfoMap of the TX SpectrumModel
+   * @param txPsd the TX power spectral density
+   * @param rxSpectrumModelUid the RX SpectrumModel
+   *
+   * @return the converted power spectral density, which must not be modified
+   */
+  Ptr<const SpectrumValue> ConvertTxPsd (TxSpectrumModelInfo &txInfo,
+                                         Ptr<const SpectrumValue> txPsd,
+                                         SpectrumModelUid_t rxSpectrumModelUid);
+
+  /**
+   * @param psd a power spectral density
+   *
+   * @return a copy of psd for a receiver, in a buffer of the pool if
+   * one of the buffers probed is no longer referenced by a receiver
+   *
+   * The pool holds at most four buffers per receiver.
+   */
+  Ptr<SpectrumValue> CopyPsd (Ptr<const SpectrumValue> psd);
 
   /**
    * used internally to reschedule transmission after the propagation delay
@@ -173,6 +224,16 @@ private:
 
   double m_maxLossDb;
 
+  double m_maxRange;  //!< distance beyond which the receivers are ignored
+
+  std::vector<Ptr<SpectrumValue> > m_psdPool;  //!< buffers handed to the receivers
+  uint32_t m_psdPoolNext;                      //!< last buffer of the pool handed out
+
+  PropagationBatch m_receivers;              //!< receivers of the current transmission
+  std::vector<bool> m_inRange;              //!< whether each receiver with a mobility model is within MaxRange
+  std::vector<double> m_propagationGainDb;  //!< propagation gain to each receiver
+  std::vector<Time> m_propagationDelays;    //!< propagation delay to each receiver
+
   /**
    * \deprecated The non-const \c Ptr<SpectrumPhy> argument
    * is deprecated and will be changed to \c Ptr<const SpectrumPhy>
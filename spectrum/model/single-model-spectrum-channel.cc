@@ -134,6 +134,35 @@ SingleModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
 
   Ptr<MobilityModel> senderMobility = txParams->txPhy->GetMobility ();
 
+  // Evaluate the propagation models for all the receivers having a
+  // mobility model in a single pass.
+  m_receivers.Clear ();
+  if (senderMobility)
+    {
+      for (PhyList::const_iterator rxPhyIterator = m_phyList.begin ();
+           rxPhyIterator != m_phyList.end ();
+           ++rxPhyIterator)
+        {
+          Ptr<MobilityModel> receiverMobility = (*rxPhyIterator)->GetMobility ();
+          if ((*rxPhyIterator) != txParams->txPhy && receiverMobility)
+            {
+              m_receivers.Add (receiverMobility);
+            }
+        }
+    }
+  uint32_t nReceivers = m_receivers.GetN ();
+  m_propagationGainDb.assign (nReceivers, 0);
+  m_propagationDelays.assign (nReceivers, MicroSeconds (0));
+  if (nReceivers > 0 && m_propagationLoss)
+    {
+      m_propagationLoss->CalcRxPowerBatch (0, senderMobility, m_receivers, &m_propagationGainDb[0]);
+    }
+  if (nReceivers > 0 && m_propagationDelay)
+    {
+      m_propagationDelay->GetDelayBatch (senderMobility, m_receivers, &m_propagationDelays[0]);
+    }
+  uint32_t rxIndex = 0;
+
   for (PhyList::const_iterator rxPhyIterator = m_phyList.begin ();
        rxPhyIterator != m_phyList.end ();
        ++rxPhyIterator)
@@ -148,6 +177,7 @@ SingleModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
 
           if (senderMobility && receiverMobility)
             {
+              uint32_t k = rxIndex++;
               double pathLossDb = 0;
               if (rxParams->txAntenna != 0)
                 {
@@ -166,7 +196,7 @@ SingleModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
                 }
               if (m_propagationLoss)
                 {
-                  double propagationGainDb = m_propagationLoss->CalcRxPower (0, senderMobility, receiverMobility);
+                  double propagationGainDb = m_propagationGainDb[k];
                   NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
                   pathLossDb -= propagationGainDb;
                 }                    
@@ -185,10 +215,7 @@ SingleModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
                   rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, senderMobility, receiverMobility);
                 }
 
-              if (m_propagationDelay)
-                {
-                  delay = m_propagationDelay->GetDelay (senderMobility, receiverMobility);
-                }
+              delay = m_propagationDelays[k];
             }
 
 
@@ -25,6 +25,7 @@
 #include <ns3/spectrum-channel.h>
 #include <ns3/spectrum-model.h>
 #include <ns3/traced-callback.h>
+#include <ns3/propagation-batch.h>
 
 namespace ns3 {
 
@@ -109,6 +110,10 @@ private:
 
   double m_maxLossDb;
 
+  PropagationBatch m_receivers;              //!< receivers of the current transmission
+  std::vector<double> m_propagationGainDb;  //!< propagation gain to each receiver
+  std::vector<Time> m_propagationDelays;    //!< propagation delay to each receiver
+
   /**
    * \deprecated The non-const \c Ptr<SpectrumPhy> argument
    * is deprecated and will be changed to \c Ptr<const SpectrumPhy>
@@ -22,18 +22,26 @@
 #include <ns3/spectrum-value.h>
 #include <ns3/math.h>
 #include <ns3/log.h>
+#include <algorithm>
+#include <cmath>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("SpectrumValue");
 
 SpectrumValue::SpectrumValue ()
+  : m_bandStart (0),
+    m_bandEnd (0),
+    m_bandKnown (true)
 {
 }
 
 SpectrumValue::SpectrumValue (Ptr<const SpectrumModel> sof)
   : m_spectrumModel (sof),
-    m_values (sof->GetNumBands ())
+    m_values (sof->GetNumBands ()),
+    m_bandStart (0),
+    m_bandEnd (0),
+    m_bandKnown (true)
 {
 
 }
@@ -41,6 +49,7 @@ SpectrumValue::SpectrumValue (Ptr<const SpectrumModel> sof)
 double&
 SpectrumValue::operator[] (size_t index)
 {
+  m_bandKnown = false;
   return m_values.at (index);
 }
 
@@ -81,12 +90,14 @@ SpectrumValue::ConstValuesEnd () const
 Values::iterator
 SpectrumValue::ValuesBegin ()
 {
+  m_bandKnown = false;
   return m_values.begin ();
 }
 
 Values::iterator
 SpectrumValue::ValuesEnd ()
 {
+  m_bandKnown = false;
   return m_values.end ();
 }
 
@@ -104,19 +115,67 @@ SpectrumValue::ConstBandsEnd () const
 
 
 void
-SpectrumValue::Add (const SpectrumValue& x)
+SpectrumValue::FindBand () const
 {
-  Values::iterator it1 = m_values.begin ();
-  Values::const_iterator it2 = x.m_values.begin ();
+  if (m_bandKnown)
+    {
+      return;
+    }
+  size_t n = m_values.size ();
+  size_t start = 0;
+  while (start < n && m_values[start] == 0)
+    {
+      start++;
+    }
+  size_t end = n;
+  while (end > start && m_values[end - 1] == 0)
+    {
+      end--;
+    }
+  m_bandStart = start;
+  m_bandEnd = end;
+  m_bandKnown = true;
+}
+
+void
+SpectrumValue::SetDense ()
+{
+  m_bandStart = 0;
+  m_bandEnd = m_values.size ();
+  m_bandKnown = true;
+}
+
+// The operations below run over raw arrays, restricted to the band of
+// the values which may be non-zero, so that the compiler can vectorize
+// them; the values outside of the band are left untouched, being zero.
 
+void
+SpectrumValue::Add (const SpectrumValue& x)
+{
   NS_ASSERT (m_spectrumModel == x.m_spectrumModel);
+  NS_ASSERT (m_values.size () == x.m_values.size ());
 
-  while (it1 != m_values.end ())
+  FindBand ();
+  x.FindBand ();
+  if (x.m_bandStart == x.m_bandEnd)
     {
-      NS_ASSERT ( it2 != x.m_values.end ());
-      *it1 += *it2;
-      ++it1;
-      ++it2;
+      return;
+    }
+  double *v = &m_values[0];
+  const double *xv = &x.m_values[0];
+  for (size_t i = x.m_bandStart; i < x.m_bandEnd; i++)
+    {
+      v[i] += xv[i];
+    }
+  if (m_bandStart == m_bandEnd)
+    {
+      m_bandStart = x.m_bandStart;
+      m_bandEnd = x.m_bandEnd;
+    }
+  else
+    {
+      m_bandStart = std::min (m_bandStart, x.m_bandStart);
+      m_bandEnd = std::max (m_bandEnd, x.m_bandEnd);
     }
 }
 
@@ -131,6 +190,7 @@ SpectrumValue::Add (double s)
       *it1 += s;
       ++it1;
     }
+  SetDense ();
 }
 
 
@@ -138,17 +198,30 @@ SpectrumValue::Add (double s)
 void
 SpectrumValue::Subtract (const SpectrumValue& x)
 {
-  Values::iterator it1 = m_values.begin ();
-  Values::const_iterator it2 = x.m_values.begin ();
-
   NS_ASSERT (m_spectrumModel == x.m_spectrumModel);
+  NS_ASSERT (m_values.size () == x.m_values.size ());
 
-  while (it1 != m_values.end ())
+  FindBand ();
+  x.FindBand ();
+  if (x.m_bandStart == x.m_bandEnd)
     {
-      NS_ASSERT ( it2 != x.m_values.end ());
-      *it1 -= *it2;
-      ++it1;
-      ++it2;
+      return;
+    }
+  double *v = &m_values[0];
+  const double *xv = &x.m_values[0];
+  for (size_t i = x.m_bandStart; i < x.m_bandEnd; i++)
+    {
+      v[i] -= xv[i];
+    }
+  if (m_bandStart == m_bandEnd)
+    {
+      m_bandStart = x.m_bandStart;
+      m_bandEnd = x.m_bandEnd;
+    }
+  else
+    {
+      m_bandStart = std::min (m_bandStart, x.m_bandStart);
+      m_bandEnd = std::max (m_bandEnd, x.m_bandEnd);
     }
 }
 
@@ -164,30 +237,72 @@ SpectrumValue::Subtract (double s)
 void
 SpectrumValue::Multiply (const SpectrumValue& x)
 {
-  Values::iterator it1 = m_values.begin ();
-  Values::const_iterator it2 = x.m_values.begin ();
-
   NS_ASSERT (m_spectrumModel == x.m_spectrumModel);
-
-  while (it1 != m_values.end ())
+  NS_ASSERT (m_values.size () == x.m_values.size ());
+
+  FindBand ();
+  x.FindBand ();
+  //the product is zero outside of the union of the two bands. It is
+  //usually zero outside of their intersection too, but zero times an
+  //infinity or a NaN is not zero, so the whole union is multiplied and
+  //the band is then narrowed to the values which are still non-zero.
+  size_t start;
+  size_t end;
+  if (m_bandStart == m_bandEnd)
     {
-      NS_ASSERT ( it2 != x.m_values.end ());
-      *it1 *= *it2;
-      ++it1;
-      ++it2;
+      start = x.m_bandStart;
+      end = x.m_bandEnd;
+    }
+  else if (x.m_bandStart == x.m_bandEnd)
+    {
+      start = m_bandStart;
+      end = m_bandEnd;
+    }
+  else
+    {
+      start = std::min (m_bandStart, x.m_bandStart);
+      end = std::max (m_bandEnd, x.m_bandEnd);
+    }
+  if (start == end)
+    {
+      return;
+    }
+  double *v = &m_values[0];
+  const double *xv = &x.m_values[0];
+  for (size_t i = start; i < end; i++)
+    {
+      v[i] *= xv[i];
+    }
+  while (start < end && v[start] == 0)
+    {
+      start++;
     }
+  while (end > start && v[end - 1] == 0)
+    {
+      end--;
+    }
+  m_bandStart = start;
+  m_bandEnd = end;
 }
 
 
 void
 SpectrumValue::Multiply (double s)
 {
-  Values::iterator it1 = m_values.begin ();
-
-  while (it1 != m_values.end ())
+  if (std::isinf (s) || std::isnan (s))
     {
-      *it1 *= s;
-      ++it1;
+      //zero times infinity is not zero
+      SetDense ();
+    }
+  FindBand ();
+  if (m_bandStart == m_bandEnd)
+    {
+      return;
+    }
+  double *v = &m_values[0];
+  for (size_t i = m_bandStart; i < m_bandEnd; i++)
+    {
+      v[i] *= s;
     }
 }
 
@@ -209,6 +324,8 @@ SpectrumValue::Divide (const SpectrumValue& x)
       ++it1;
       ++it2;
     }
+  //zero divided by zero is not zero
+  m_bandKnown = false;
 }
 
 
@@ -216,12 +333,19 @@ void
 SpectrumValue::Divide (double s)
 {
   NS_LOG_FUNCTION (this << s);
-  Values::iterator it1 = m_values.begin ();
-
-  while (it1 != m_values.end ())
+  if (s == 0 || std::isnan (s))
     {
-      *it1 /= s;
-      ++it1;
+      SetDense ();
+    }
+  FindBand ();
+  if (m_bandStart == m_bandEnd)
+    {
+      return;
+    }
+  double *v = &m_values[0];
+  for (size_t i = m_bandStart; i < m_bandEnd; i++)
+    {
+      v[i] /= s;
     }
 }
 
@@ -231,12 +355,15 @@ SpectrumValue::Divide (double s)
 void
 SpectrumValue::ChangeSign ()
 {
-  Values::iterator it1 = m_values.begin ();
-
-  while (it1 != m_values.end ())
+  FindBand ();
+  if (m_bandStart == m_bandEnd)
     {
-      *it1 = -(*it1);
-      ++it1;
+      return;
+    }
+  double *v = &m_values[0];
+  for (size_t i = m_bandStart; i < m_bandEnd; i++)
+    {
+      v[i] = -v[i];
     }
 }
 
@@ -255,6 +382,7 @@ SpectrumValue::ShiftLeft (int n)
       m_values.at (i) = 0;
       i++;
     }
+  m_bandKnown = false;
 }
 
 
@@ -272,6 +400,7 @@ SpectrumValue::ShiftRight (int n)
       m_values.at (i) = 0;
       --i;
     }
+  m_bandKnown = false;
 }
 
 
@@ -287,6 +416,7 @@ SpectrumValue::Pow (double exp)
       *it1 = std::pow (*it1, exp);
       ++it1;
     }
+  m_bandKnown = false;
 }
 
 
@@ -301,6 +431,7 @@ SpectrumValue::Exp (double base)
       *it1 = std::pow (base, *it1);
       ++it1;
     }
+  SetDense ();
 }
 
 
@@ -315,6 +446,7 @@ SpectrumValue::Log10 ()
       *it1 = std::log10 (*it1);
       ++it1;
     }
+  SetDense ();
 }
 
 void
@@ -328,6 +460,7 @@ SpectrumValue::Log2 ()
       *it1 = log2 (*it1);
       ++it1;
     }
+  SetDense ();
 }
 
 
@@ -342,17 +475,17 @@ SpectrumValue::Log ()
       *it1 = std::log (*it1);
       ++it1;
     }
+  SetDense ();
 }
 
 double
 Norm (const SpectrumValue& x)
 {
   double s = 0;
-  Values::const_iterator it1 = x.ConstValuesBegin ();
-  while (it1 != x.ConstValuesEnd ())
+  x.FindBand ();
+  for (size_t i = x.m_bandStart; i < x.m_bandEnd; i++)
     {
-      s += (*it1) * (*it1);
-      ++it1;
+      s += x.m_values[i] * x.m_values[i];
     }
   return std::sqrt (s);
 }
@@ -362,11 +495,10 @@ double
 Sum (const SpectrumValue& x)
 {
   double s = 0;
-  Values::const_iterator it1 = x.ConstValuesBegin ();
-  while (it1 != x.ConstValuesEnd ())
+  x.FindBand ();
+  for (size_t i = x.m_bandStart; i < x.m_bandEnd; i++)
     {
-      s += (*it1);
-      ++it1;
+      s += x.m_values[i];
     }
   return s;
 }
@@ -390,16 +522,13 @@ double
 Integral (const SpectrumValue& arg)
 {
   double i = 0;
-  Values::const_iterator vit = arg.ConstValuesBegin ();
-  Bands::const_iterator bit = arg.ConstBandsBegin ();
-  while (vit != arg.ConstValuesEnd ())
+  NS_ASSERT (arg.m_values.size () == arg.m_spectrumModel->GetNumBands ());
+  arg.FindBand ();
+  Bands::const_iterator bit = arg.ConstBandsBegin () + arg.m_bandStart;
+  for (size_t j = arg.m_bandStart; j < arg.m_bandEnd; j++, bit++)
     {
-      NS_ASSERT (bit != arg.ConstBandsEnd ());
-      i += (*vit) * (bit->fh - bit->fl);
-      ++vit;
-      ++bit;
+      i += arg.m_values[j] * (bit->fh - bit->fl);
     }
-  NS_ASSERT (bit == arg.ConstBandsEnd ());
   return i;
 }
 
@@ -434,6 +563,7 @@ operator << (std::ostream& os, const SpectrumValue& pvf)
 SpectrumValue
 operator+ (const SpectrumValue& lhs, const SpectrumValue& rhs)
 {
+  lhs.FindBand ();
   SpectrumValue res = lhs;
   res.Add (rhs);
   return res;
@@ -461,6 +591,7 @@ operator+ (double lhs, const SpectrumValue& rhs)
 SpectrumValue
 operator- (const SpectrumValue& lhs, const SpectrumValue& rhs)
 {
+  rhs.FindBand ();
   SpectrumValue res = rhs;
   res.ChangeSign ();
   res.Add (lhs);
@@ -489,6 +620,7 @@ operator- (double lhs, const SpectrumValue& rhs)
 SpectrumValue
 operator* (const SpectrumValue& lhs, const SpectrumValue& rhs)
 {
+  lhs.FindBand ();
   SpectrumValue res = lhs;
   res.Multiply (rhs);
   return res;
@@ -665,6 +797,16 @@ SpectrumValue::operator= (double rhs)
       *it1 = rhs;
       ++it1;
     }
+  if (rhs == 0)
+    {
+      m_bandStart = 0;
+      m_bandEnd = 0;
+      m_bandKnown = true;
+    }
+  else
+    {
+      SetDense ();
+    }
   return *this;
 }
 
@@ -53,6 +53,17 @@ typedef std::vector<double> Values;
  * The intended use of this class is to represent frequency-dependent
  * things, such as power spectral densities, frequency-dependent
  * propagation losses, spectral masks, etc.
+ *
+ * A power spectral density is often zero outside of a few contiguous
+ * bands of a wide SpectrumModel. The values are stored for all the
+ * bands, but the band of the values which may be non-zero is also kept,
+ * and the operations only process the values of this band: adding a
+ * narrow signal to a wide one, or integrating it, costs as many
+ * operations as it has non-zero values. The band is computed from the
+ * values when an operation needs it, after the values were accessed
+ * through a non-const accessor; the references and iterators returned
+ * by these accessors should thus not be used to modify the values once
+ * an operation was applied to them.
  */
 class SpectrumValue : public SimpleRefCount<SpectrumValue>
 {
@@ -532,6 +543,15 @@ private:
   void Log2 ();
   void Log ();
 
+  /**
+   * Compute the band of the values which may be non-zero, if it is not known.
+   */
+  void FindBand () const;
+  /**
+   * Set the band of the values which may be non-zero to all the values.
+   */
+  void SetDense ();
+
   Ptr<const SpectrumModel> m_spectrumModel;
 
 
@@ -544,7 +564,9 @@ private:
  */
   Values m_values;
 
-
+  mutable size_t m_bandStart;  //!< the index of the first value which may be non-zero
+  mutable size_t m_bandEnd;    //!< the index after the last value which may be non-zero
+  mutable bool m_bandKnown;    //!< whether the band of the values which may be non-zero is known
 };
 
 std::ostream& operator << (std::ostream& os, const SpectrumValue& pvf);
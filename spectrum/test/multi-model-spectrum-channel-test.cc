@@ -0,0 +1,228 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/double.h>
+#include <ns3/net-device.h>
+#include <ns3/antenna-model.h>
+#include <ns3/constant-position-mobility-model.h>
+#include <ns3/multi-model-spectrum-channel.h>
+#include <ns3/spectrum-phy.h>
+#include <ns3/spectrum-signal-parameters.h>
+#include <ns3/spectrum-converter.h>
+#include <ns3/spectrum-value.h>
+#include "spectrum-test.h"
+#include <vector>
+
+using namespace ns3;
+
+
+/**
+ * A SpectrumPhy which keeps the power spectral densities it receives
+ */
+class MultiModelTestPhy : public SpectrumPhy
+{
+public:
+  MultiModelTestPhy (Ptr<const SpectrumModel> rxSpectrumModel, Vector position, bool keepPsds);
+
+  virtual void SetDevice (Ptr<NetDevice> d);
+  virtual Ptr<NetDevice> GetDevice () const;
+  virtual void SetMobility (Ptr<MobilityModel> m);
+  virtual Ptr<MobilityModel> GetMobility ();
+  virtual void SetChannel (Ptr<SpectrumChannel> c);
+  virtual Ptr<const SpectrumModel> GetRxSpectrumModel () const;
+  virtual Ptr<AntennaModel> GetRxAntenna ();
+  virtual void StartRx (Ptr<SpectrumSignalParameters> params);
+
+  /// the power spectral densities received, as handed by the channel, if kept
+  std::vector<Ptr<SpectrumValue> > m_rxPsds;
+  /// a copy of each power spectral density, taken at reception
+  std::vector<SpectrumValue> m_rxValues;
+
+private:
+  Ptr<const SpectrumModel> m_rxSpectrumModel;
+  Ptr<MobilityModel> m_mobility;
+  bool m_keepPsds;
+};
+
+MultiModelTestPhy::MultiModelTestPhy (Ptr<const SpectrumModel> rxSpectrumModel, Vector position, bool keepPsds)
+  : m_rxSpectrumModel (rxSpectrumModel),
+    m_keepPsds (keepPsds)
+{
+  m_mobility = CreateObject<ConstantPositionMobilityModel> ();
+  m_mobility->SetPosition (position);
+}
+
+void
+MultiModelTestPhy::SetDevice (Ptr<NetDevice> d)
+{
+}
+
+Ptr<NetDevice>
+MultiModelTestPhy::GetDevice () const
+{
+  return 0;
+}
+
+void
+MultiModelTestPhy::SetMobility (Ptr<MobilityModel> m)
+{
+  m_mobility = m;
+}
+
+Ptr<MobilityModel>
+MultiModelTestPhy::GetMobility ()
+{
+  return m_mobility;
+}
+
+void
+MultiModelTestPhy::SetChannel (Ptr<SpectrumChannel> c)
+{
+}
+
+Ptr<const SpectrumModel>
+MultiModelTestPhy::GetRxSpectrumModel () const
+{
+  return m_rxSpectrumModel;
+}
+
+Ptr<AntennaModel>
+MultiModelTestPhy::GetRxAntenna ()
+{
+  return 0;
+}
+
+void
+MultiModelTestPhy::StartRx (Ptr<SpectrumSignalParameters> params)
+{
+  if (m_keepPsds)
+    {
+      m_rxPsds.push_back (params->psd);
+    }
+  m_rxValues.push_back (*params->psd);
+}
+
+
+/**
+ * Send the same power spectral density several times, changing its
+ * values in place in between, to receivers using the SpectrumModel of
+ * the transmitter and another one, and check that every receiver gets
+ * the converted values of each transmission, that the buffers kept by
+ * the receivers are not reused, and that the receivers beyond MaxRange
+ * get nothing.
+ */
+class MultiModelSpectrumChannelTestCase : public TestCase
+{
+public:
+  MultiModelSpectrumChannelTestCase ();
+  virtual ~MultiModelSpectrumChannelTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MultiModelSpectrumChannelTestCase::MultiModelSpectrumChannelTestCase ()
+  : TestCase ("conversion cache, buffer pool and MaxRange")
+{
+}
+
+MultiModelSpectrumChannelTestCase::~MultiModelSpectrumChannelTestCase ()
+{
+}
+
+void
+MultiModelSpectrumChannelTestCase::DoRun (void)
+{
+  std::vector<double> txFreqs;
+  for (int i = 1; i <= 4; i++)
+    {
+      txFreqs.push_back (i);
+    }
+  Ptr<SpectrumModel> txModel = Create<SpectrumModel> (txFreqs);
+  std::vector<double> rxFreqs;
+  rxFreqs.push_back (1.5);
+  rxFreqs.push_back (2.5);
+  rxFreqs.push_back (3.5);
+  Ptr<SpectrumModel> rxModel = Create<SpectrumModel> (rxFreqs);
+
+  Ptr<MultiModelSpectrumChannel> channel = CreateObject<MultiModelSpectrumChannel> ();
+  channel->SetAttribute ("MaxRange", DoubleValue (100));
+
+  // only the first receiver keeps the buffers it gets, those of the
+  // second one can be reused by the channel
+  Ptr<MultiModelTestPhy> tx = CreateObject<MultiModelTestPhy> (txModel, Vector (0, 0, 0), false);
+  Ptr<MultiModelTestPhy> sameModelRx = CreateObject<MultiModelTestPhy> (txModel, Vector (10, 0, 0), true);
+  Ptr<MultiModelTestPhy> otherModelRx = CreateObject<MultiModelTestPhy> (rxModel, Vector (0, 20, 0), false);
+  Ptr<MultiModelTestPhy> farRx = CreateObject<MultiModelTestPhy> (rxModel, Vector (1000, 0, 0), false);
+  channel->AddRx (tx);
+  channel->AddRx (sameModelRx);
+  channel->AddRx (otherModelRx);
+  channel->AddRx (farRx);
+
+  SpectrumConverter converter (txModel, rxModel);
+  Ptr<SpectrumValue> psd = Create<SpectrumValue> (txModel);
+  std::vector<SpectrumValue> sent;
+  std::vector<SpectrumValue> converted;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      // the second transmission repeats the first one
+      if (i != 1)
+        {
+          (*psd)[i] = i + 1.0;
+          (*psd)[(i + 2) % 4] = 0.5 * i;
+        }
+      sent.push_back (*psd);
+      converted.push_back (*converter.Convert (psd));
+      Ptr<SpectrumSignalParameters> params = Create<SpectrumSignalParameters> ();
+      params->txPhy = tx;
+      params->psd = psd;
+      params->duration = MilliSeconds (1);
+      channel->StartTx (params);
+      Simulator::Run ();
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (tx->m_rxValues.size (), 0, "the transmitter received its own signal");
+  NS_TEST_ASSERT_MSG_EQ (farRx->m_rxValues.size (), 0, "a receiver beyond MaxRange received a signal");
+  NS_TEST_ASSERT_MSG_EQ (sameModelRx->m_rxValues.size (), sent.size (), "wrong number of receptions");
+  NS_TEST_ASSERT_MSG_EQ (otherModelRx->m_rxValues.size (), sent.size (), "wrong number of receptions");
+  for (uint32_t t = 0; t < sent.size (); t++)
+    {
+      NS_TEST_ASSERT_MSG_SPECTRUM_VALUE_EQ_TOL (sameModelRx->m_rxValues[t], sent[t], 1e-9, "wrong power spectral density received");
+      NS_TEST_ASSERT_MSG_SPECTRUM_VALUE_EQ_TOL (otherModelRx->m_rxValues[t], converted[t], 1e-9, "wrong power spectral density received");
+      // the buffers still held by the receivers must not have been reused
+      NS_TEST_ASSERT_MSG_SPECTRUM_VALUE_EQ_TOL (*sameModelRx->m_rxPsds[t], sent[t], 1e-9, "a buffer held by a receiver was reused");
+    }
+
+  channel->Dispose ();
+  Simulator::Destroy ();
+}
+
+
+class MultiModelSpectrumChannelTestSuite : public TestSuite
+{
+public:
+  MultiModelSpectrumChannelTestSuite ();
+};
+
+MultiModelSpectrumChannelTestSuite::MultiModelSpectrumChannelTestSuite ()
+  : TestSuite ("multi-model-spectrum-channel", UNIT)
+{
+  AddTestCase (new MultiModelSpectrumChannelTestCase, TestCase::QUICK);
+}
+
+static MultiModelSpectrumChannelTestSuite g_multiModelSpectrumChannelTestSuite;
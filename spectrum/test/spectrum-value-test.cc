@@ -25,6 +25,7 @@
 #include <ns3/test.h>
 #include <iostream>
 #include <cmath>
+#include <limits>
 
 #include "spectrum-test.h"
 
@@ -77,6 +78,71 @@ SpectrumValueTestCase::DoRun (void)
 
 
 
+/**
+ * Check that the product of two SpectrumValues is not a number where
+ * zero is multiplied by an infinity or a NaN, including outside of the
+ * bands of the values which are not zero.
+ */
+class SpectrumValueNonFiniteProductTestCase : public TestCase
+{
+public:
+  SpectrumValueNonFiniteProductTestCase ();
+  virtual ~SpectrumValueNonFiniteProductTestCase ();
+  virtual void DoRun (void);
+};
+
+SpectrumValueNonFiniteProductTestCase::SpectrumValueNonFiniteProductTestCase ()
+  : TestCase ("product with infinities and NaNs")
+{
+}
+
+SpectrumValueNonFiniteProductTestCase::~SpectrumValueNonFiniteProductTestCase ()
+{
+}
+
+void
+SpectrumValueNonFiniteProductTestCase::DoRun (void)
+{
+  std::vector<double> freqs;
+  for (int i = 1; i <= 10; i++)
+    {
+      freqs.push_back (i);
+    }
+  Ptr<SpectrumModel> g = Create<SpectrumModel> (freqs);
+  double inf = std::numeric_limits<double>::infinity ();
+
+  // infinity in the other value, outside of the band of this one
+  SpectrumValue a (g), b (g);
+  a[2] = 1.0;
+  a[3] = 2.0;
+  b[3] = 3.0;
+  b[7] = inf;
+  SpectrumValue ab = a * b;
+  NS_TEST_EXPECT_MSG_EQ (ab[2], 0.0, "finite times zero");
+  NS_TEST_EXPECT_MSG_EQ (ab[3], 6.0, "finite times finite");
+  NS_TEST_EXPECT_MSG_EQ (std::isnan (ab[7]), true, "zero times infinity");
+  NS_TEST_EXPECT_MSG_EQ (std::isnan (Sum (ab)), true, "NaN left out of the band");
+  SpectrumValue abPlusA = ab + a;
+  NS_TEST_EXPECT_MSG_EQ (std::isnan (abPlusA[7]), true, "NaN lost by the next operation");
+
+  // infinity in this value, outside of the band of the other one
+  SpectrumValue c (g), d (g);
+  c[2] = inf;
+  d[5] = 3.0;
+  c *= d;
+  NS_TEST_EXPECT_MSG_EQ (std::isnan (c[2]), true, "infinity times zero");
+  NS_TEST_EXPECT_MSG_EQ (c[5], 0.0, "zero times finite");
+
+  // NaN in the other value, this one being zero everywhere
+  SpectrumValue e (g), f (g);
+  f[4] = std::numeric_limits<double>::quiet_NaN ();
+  e *= f;
+  NS_TEST_EXPECT_MSG_EQ (std::isnan (e[4]), true, "zero times NaN");
+  NS_TEST_EXPECT_MSG_EQ (e[5], 0.0, "zero times zero");
+}
+
+
+
 
 
 
@@ -242,6 +308,56 @@ SpectrumValueTestSuite::SpectrumValueTestSuite ()
   AddTestCase (new SpectrumValueTestCase (tv1rs3, v1rs3, "tv1rs3 = v1 >> 3"), TestCase::QUICK);
 
 
+  // values which are zero outside of a few bands
+  std::vector<double> sparseFreqs;
+  for (int i = 1; i <= 10; i++)
+    {
+      sparseFreqs.push_back (i);
+    }
+  Ptr<SpectrumModel> g = Create<SpectrumModel> (sparseFreqs);
+
+  SpectrumValue s1 (g), s2 (g), s3 (g), s4 (g), s5 (g), s6 (g);
+
+  s1[2] = 1.0;
+  s1[3] = 2.0;
+
+  s2[3] = 3.0;
+  s2[4] = 4.0;
+  s2[5] = 5.0;
+
+  s3[2] = 1.0;
+  s3[3] = 5.0;
+  s3[4] = 4.0;
+  s3[5] = 5.0;
+
+  s4[2] = 1.0;
+  s4[3] = -1.0;
+  s4[4] = -4.0;
+  s4[5] = -5.0;
+
+  s5[3] = 6.0;
+
+  s6[2] = 1.0;
+  s6[3] = 8.0;
+  s6[8] = 7.0;
+
+  SpectrumValue ts3 (g), ts4 (g), ts5 (g), ts6 (g);
+  ts3 = s1 + s2;
+  ts4 = s1 - s2;
+  ts5 = s1 * s2;
+  AddTestCase (new SpectrumValueTestCase (ts3, s3, "ts3 = s1 + s2"), TestCase::QUICK);
+  AddTestCase (new SpectrumValueTestCase (ts4, s4, "ts4 = s1 - s2"), TestCase::QUICK);
+  AddTestCase (new SpectrumValueTestCase (ts5, s5, "ts5 = s1 * s2"), TestCase::QUICK);
+
+  // a value written after an operation must be accounted for by the next ones
+  ts6 = s1;
+  ts6 *= s2;
+  ts6[8] = 7.0;
+  ts6 += s1;
+  AddTestCase (new SpectrumValueTestCase (ts6, s6, "ts6 = s1 * s2 + s1, ts6[8] = 7"), TestCase::QUICK);
+  AddTestCase (new SpectrumValueNonFiniteProductTestCase, TestCase::QUICK);
+
+
 }
 
 
@@ -0,0 +1,157 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+// This program measures the cost of the channel access of the
+// DcfManager in a dense ad hoc network where the medium is almost never
+// idle.
+//
+// A number of nodes (50 by default) are placed on a circle and all hear
+// each other. Each node keeps its queue full of unicast frames to its
+// neighbor on the circle, so that all the nodes contend for the medium
+// and their backoffs are frozen and resumed by the transmissions of the
+// others.
+//
+// The program prints the wall clock time needed to simulate the
+// scenario, the number of frames received, and the number of access
+// timeouts scheduled by the DcfManager of all the nodes compared to the
+// number of those which granted the access to the medium.
+//
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include <cmath>
+#include <iostream>
+
+using namespace ns3;
+
+class BackoffBenchmark
+{
+public:
+  BackoffBenchmark ();
+  void Run (uint32_t nNodes, Time duration);
+
+private:
+  void Send (Ptr<NetDevice> device, Address destination);
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  Time m_interval;
+  uint32_t m_packetSize;
+  uint32_t m_received;
+};
+
+BackoffBenchmark::BackoffBenchmark ()
+  : m_interval (MilliSeconds (1)),
+    m_packetSize (1000),
+    m_received (0)
+{
+}
+
+void
+BackoffBenchmark::Send (Ptr<NetDevice> device, Address destination)
+{
+  device->Send (Create<Packet> (m_packetSize), destination, 0x88b5);
+  Simulator::Schedule (m_interval, &BackoffBenchmark::Send, this, device, destination);
+}
+
+bool
+BackoffBenchmark::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  m_received++;
+  return true;
+}
+
+void
+BackoffBenchmark::Run (uint32_t nNodes, Time duration)
+{
+  NodeContainer nodes;
+  nodes.Create (nNodes);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211a);
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode", StringValue ("OfdmRate24Mbps"));
+  YansWifiChannelHelper channel = YansWifiChannelHelper::Default ();
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (channel.Create ());
+  NqosWifiMacHelper mac = NqosWifiMacHelper::Default ();
+  mac.SetType ("ns3::AdhocWifiMac");
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+
+  Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator> ();
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      double angle = 2 * M_PI * i / nNodes;
+      positions->Add (Vector (10 * std::cos (angle), 10 * std::sin (angle), 0));
+    }
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator (positions);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (nodes);
+
+  Ptr<UniformRandomVariable> start = CreateObject<UniformRandomVariable> ();
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      Ptr<NetDevice> device = devices.Get (i);
+      device->SetReceiveCallback (MakeCallback (&BackoffBenchmark::Receive, this));
+      Address destination = devices.Get ((i + 1) % nNodes)->GetAddress ();
+      Simulator::Schedule (MicroSeconds (start->GetInteger (0, 1000)),
+                           &BackoffBenchmark::Send, this, device, destination);
+    }
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Stop (duration);
+  Simulator::Run ();
+  int64_t elapsed = clock.End ();
+
+  uint64_t scheduled = 0;
+  uint64_t useful = 0;
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      Ptr<WifiMac> mac = DynamicCast<WifiNetDevice> (devices.Get (i))->GetMac ();
+      UintegerValue value;
+      mac->GetAttribute ("ScheduledAccessTimeouts", value);
+      scheduled += value.Get ();
+      mac->GetAttribute ("UsefulAccessTimeouts", value);
+      useful += value.Get ();
+    }
+  Simulator::Destroy ();
+
+  std::cout << "nodes=" << nNodes
+            << " received=" << m_received
+            << " scheduled=" << scheduled
+            << " useful=" << useful
+            << " wall clock=" << elapsed << "ms" << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nNodes = 50;
+  double duration = 10;
+
+  CommandLine cmd;
+  cmd.AddValue ("nNodes", "Number of nodes", nNodes);
+  cmd.AddValue ("duration", "Simulated time in seconds", duration);
+  cmd.Parse (argc, argv);
+
+  BackoffBenchmark benchmark;
+  benchmark.Run (nNodes, Seconds (duration));
+
+  return 0;
+}
@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+// This program measures the cost of the noise and interference
+// bookkeeping done by InterferenceHelper in a dense scenario.
+//
+// A number of transmitters (200 by default) are placed on a circle
+// around a single receiver and broadcast frames back to back with a
+// random offset, so that most of their transmissions overlap and the
+// medium never goes idle. Every PHY hears every other PHY, so each
+// frame adds one event to the interference helper of every other PHY.
+//
+// The program prints the wall clock time needed to simulate the
+// scenario and the number of frames received by the receiver.
+//
+
+#include "ns3/core-module.h"
+#include "ns3/yans-wifi-channel.h"
+#include "ns3/yans-wifi-phy.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/nist-error-rate-model.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/packet.h"
+#include "ns3/wifi-tx-vector.h"
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+class InterferenceBenchmark
+{
+public:
+  InterferenceBenchmark ();
+  void Run (uint32_t nTransmitters, Time duration);
+
+private:
+  void Send (Ptr<YansWifiPhy> phy);
+  void Receive (Ptr<Packet> p, double snr, WifiTxVector txVector, enum WifiPreamble preamble);
+
+  Time m_interval;
+  uint32_t m_packetSize;
+  uint32_t m_sent;
+  uint32_t m_received;
+};
+
+InterferenceBenchmark::InterferenceBenchmark ()
+  : m_interval (MicroSeconds (2500)),
+    m_packetSize (1500),
+    m_sent (0),
+    m_received (0)
+{
+}
+
+void
+InterferenceBenchmark::Send (Ptr<YansWifiPhy> phy)
+{
+  Ptr<Packet> p = Create<Packet> (m_packetSize);
+  WifiTxVector txVector;
+  txVector.SetTxPowerLevel (0);
+  txVector.SetMode (WifiPhy::GetOfdmRate6Mbps ());
+  phy->SendPacket (p, txVector, WIFI_PREAMBLE_LONG, 0, 0);
+  m_sent++;
+  Simulator::Schedule (m_interval, &InterferenceBenchmark::Send, this, phy);
+}
+
+void
+InterferenceBenchmark::Receive (Ptr<Packet> p, double snr, WifiTxVector txVector, enum WifiPreamble preamble)
+{
+  m_received++;
+}
+
+void
+InterferenceBenchmark::Run (uint32_t nTransmitters, Time duration)
+{
+  Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel> ();
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  channel->SetPropagationLossModel (CreateObject<LogDistancePropagationLossModel> ());
+  Ptr<ErrorRateModel> error = CreateObject<NistErrorRateModel> ();
+
+  Ptr<MobilityModel> rxPosition = CreateObject<ConstantPositionMobilityModel> ();
+  rxPosition->SetPosition (Vector (0.0, 0.0, 0.0));
+  Ptr<YansWifiPhy> rx = CreateObject<YansWifiPhy> ();
+  rx->SetErrorRateModel (error);
+  rx->SetChannel (channel);
+  rx->SetMobility (rxPosition);
+  rx->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+  rx->SetReceiveOkCallback (MakeCallback (&InterferenceBenchmark::Receive, this));
+
+  Ptr<UniformRandomVariable> offset = CreateObject<UniformRandomVariable> ();
+  offset->SetAttribute ("Max", DoubleValue (m_interval.GetMicroSeconds ()));
+  std::vector<Ptr<YansWifiPhy> > transmitters;
+  for (uint32_t i = 0; i < nTransmitters; i++)
+    {
+      double angle = 2 * M_PI * i / nTransmitters;
+      Ptr<MobilityModel> position = CreateObject<ConstantPositionMobilityModel> ();
+      position->SetPosition (Vector (10.0 * std::cos (angle), 10.0 * std::sin (angle), 0.0));
+      Ptr<YansWifiPhy> tx = CreateObject<YansWifiPhy> ();
+      tx->SetErrorRateModel (error);
+      tx->SetChannel (channel);
+      tx->SetMobility (position);
+      tx->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+      transmitters.push_back (tx);
+      Simulator::Schedule (MicroSeconds (offset->GetInteger ()), &InterferenceBenchmark::Send, this, tx);
+    }
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Stop (duration);
+  Simulator::Run ();
+  int64_t elapsed = clock.End ();
+  Simulator::Destroy ();
+
+  std::cout << "transmitters=" << nTransmitters
+            << " frames sent=" << m_sent
+            << " frames received=" << m_received
+            << " wall clock=" << elapsed << "ms" << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nTransmitters = 200;
+  double duration = 1.0;
+
+  CommandLine cmd;
+  cmd.AddValue ("nTransmitters", "Number of overlapping transmitters", nTransmitters);
+  cmd.AddValue ("duration", "Simulated time in seconds", duration);
+  cmd.Parse (argc, argv);
+
+  InterferenceBenchmark benchmark;
+  benchmark.Run (nTransmitters, Seconds (duration));
+
+  return 0;
+}
@@ -0,0 +1,167 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+// This program measures the cost of the periodic update of the
+// statistics of a MinstrelWifiManager, or of a MinstrelHtWifiManager,
+// which knows many remote stations.
+//
+// A MinstrelWifiManager on an 802.11g ad hoc MAC, or with --ht a
+// MinstrelHtWifiManager on an 802.11n ad hoc MAC using 40 MHz channels
+// and the short guard interval, knows a number of stations (500 by
+// default). Every 100 ms, the statistics update
+// interval of Minstrel, it sends a frame to each station, a third of
+// which fail once before being acknowledged. The scenario is run
+// twice: once with the default update interval, so that the statistics
+// of each station are updated at the first frame of each round, and
+// once without any update.
+//
+// The program prints the wall clock time of both runs, the cost of one
+// update of the statistics of one station, computed from their
+// difference, and the cost of one frame, from the run without updates.
+//
+
+#include "ns3/core-module.h"
+#include "ns3/yans-wifi-phy.h"
+#include "ns3/adhoc-wifi-mac.h"
+#include "ns3/minstrel-wifi-manager.h"
+#include "ns3/minstrel-ht-wifi-manager.h"
+#include "ns3/wifi-mac-header.h"
+#include "ns3/packet.h"
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+class MinstrelBenchmark
+{
+public:
+  int64_t Run (bool ht, uint32_t nStations, uint32_t nRounds, Time updateInterval);
+
+private:
+  void Round (void);
+
+  Ptr<WifiRemoteStationManager> m_manager;
+  std::vector<Mac48Address> m_addresses;
+  Ptr<UniformRandomVariable> m_random;
+};
+
+void
+MinstrelBenchmark::Round (void)
+{
+  WifiMacHeader header;
+  header.SetType (WIFI_MAC_DATA);
+  Ptr<Packet> packet = Create<Packet> (1000);
+  uint32_t size = packet->GetSize () + header.GetSize () + 4;
+  WifiMode ackMode = WifiPhy::GetErpOfdmRate6Mbps ();
+  for (uint32_t i = 0; i < m_addresses.size (); i++)
+    {
+      m_manager->GetDataTxVector (m_addresses[i], &header, packet, size);
+      if (m_random->GetInteger (0, 2) == 0)
+        {
+          m_manager->ReportDataFailed (m_addresses[i], &header);
+        }
+      m_manager->ReportDataOk (m_addresses[i], &header, 100, ackMode, 100);
+    }
+}
+
+int64_t
+MinstrelBenchmark::Run (bool ht, uint32_t nStations, uint32_t nRounds, Time updateInterval)
+{
+  WifiPhyStandard standard = ht ? WIFI_PHY_STANDARD_80211n_5GHZ : WIFI_PHY_STANDARD_80211g;
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  phy->ConfigureStandard (standard);
+  Ptr<AdhocWifiMac> mac = CreateObject<AdhocWifiMac> ();
+  if (ht)
+    {
+      phy->SetAttribute ("ChannelWidth", UintegerValue (40));
+      phy->SetAttribute ("ShortGuardEnabled", BooleanValue (true));
+      mac->SetAttribute ("HtSupported", BooleanValue (true));
+    }
+  mac->SetWifiPhy (phy);
+  mac->ConfigureStandard (standard);
+  m_random = CreateObject<UniformRandomVariable> ();
+  m_random->SetStream (1);
+  if (ht)
+    {
+      Ptr<MinstrelHtWifiManager> manager = CreateObject<MinstrelHtWifiManager> ();
+      manager->AssignStreams (2);
+      m_manager = manager;
+    }
+  else
+    {
+      Ptr<MinstrelWifiManager> manager = CreateObject<MinstrelWifiManager> ();
+      manager->AssignStreams (2);
+      m_manager = manager;
+    }
+  m_manager->SetAttribute ("UpdateStatistics", TimeValue (updateInterval));
+  m_manager->SetupPhy (phy);
+  m_manager->SetupMac (mac);
+  mac->SetWifiRemoteStationManager (m_manager);
+
+  m_addresses.clear ();
+  for (uint32_t i = 0; i < nStations; i++)
+    {
+      Mac48Address address = Mac48Address::Allocate ();
+      m_manager->AddAllSupportedModes (address);
+      if (ht)
+        {
+          m_manager->AddAllSupportedMcs (address);
+        }
+      m_addresses.push_back (address);
+    }
+  for (uint32_t i = 0; i < nRounds; i++)
+    {
+      Simulator::Schedule (MilliSeconds (100 * i + 1), &MinstrelBenchmark::Round, this);
+    }
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  int64_t elapsed = clock.End ();
+  Simulator::Destroy ();
+  mac->Dispose ();
+  m_manager->Dispose ();
+  m_manager = 0;
+  return elapsed;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nStations = 500;
+  uint32_t nRounds = 10000;
+  bool ht = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("nStations", "Number of remote stations", nStations);
+  cmd.AddValue ("nRounds", "Number of statistics update intervals", nRounds);
+  cmd.AddValue ("ht", "Use Minstrel-HT with 802.11n rather than Minstrel with 802.11g", ht);
+  cmd.Parse (argc, argv);
+
+  MinstrelBenchmark benchmark;
+  int64_t withUpdates = benchmark.Run (ht, nStations, nRounds, MilliSeconds (100));
+  int64_t withoutUpdates = benchmark.Run (ht, nStations, nRounds, Seconds (1e6));
+
+  std::cout << (ht ? "minstrel-ht" : "minstrel")
+            << " stations=" << nStations
+            << " rounds=" << nRounds
+            << " with updates=" << withUpdates << "ms"
+            << " without updates=" << withoutUpdates << "ms"
+            << " per update=" << (withUpdates - withoutUpdates) * 1e6 / nStations / nRounds << "ns"
+            << " per frame=" << withoutUpdates * 1e6 / nStations / nRounds << "ns" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,111 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//
+// This program measures the cost of the per-frame calls to a
+// WifiRemoteStationManager when it knows many remote stations, as an
+// access point with hundreds of associated stations or an ad hoc node
+// with hundreds of neighbors does.
+//
+// For a number of stations doubling from 10 up to maxStations (2000 by
+// default), an ArfWifiManager first learns all the stations, then
+// handles a number of frames (1000000 by default) to and from stations
+// picked at random: for each frame, it decides whether to use RTS/CTS,
+// selects the data rate, and records the ACK and a received frame.
+//
+// The program prints the wall clock time per frame for each number of
+// stations.
+//
+
+#include "ns3/core-module.h"
+#include "ns3/yans-wifi-phy.h"
+#include "ns3/arf-wifi-manager.h"
+#include "ns3/wifi-mac-header.h"
+#include "ns3/packet.h"
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+void
+RunBenchmark (uint32_t nStations, uint32_t nFrames)
+{
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  phy->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+  Ptr<WifiRemoteStationManager> manager = CreateObject<ArfWifiManager> ();
+  manager->SetupPhy (phy);
+
+  std::vector<Mac48Address> addresses;
+  for (uint32_t i = 0; i < nStations; i++)
+    {
+      addresses.push_back (Mac48Address::Allocate ());
+    }
+  WifiMacHeader header;
+  header.SetType (WIFI_MAC_DATA);
+  Ptr<Packet> packet = Create<Packet> (1000);
+  uint32_t size = packet->GetSize () + header.GetSize () + 4;
+  WifiMode ackMode = WifiPhy::GetOfdmRate6Mbps ();
+  for (uint32_t i = 0; i < nStations; i++)
+    {
+      manager->ReportRxOk (addresses[i], &header, 100, ackMode);
+    }
+
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  std::vector<uint32_t> order (nFrames);
+  for (uint32_t i = 0; i < nFrames; i++)
+    {
+      order[i] = random->GetInteger (0, nStations - 1);
+    }
+
+  uint32_t rts = 0;
+  SystemWallClockMs clock;
+  clock.Start ();
+  for (uint32_t i = 0; i < nFrames; i++)
+    {
+      Mac48Address address = addresses[order[i]];
+      rts += manager->NeedRts (address, &header, packet);
+      WifiTxVector txVector = manager->GetDataTxVector (address, &header, packet, size);
+      manager->ReportDataOk (address, &header, 100, ackMode, 100);
+      manager->ReportRxOk (address, &header, 100, txVector.GetMode ());
+    }
+  int64_t elapsed = clock.End ();
+  manager->Dispose ();
+
+  std::cout << "stations=" << nStations
+            << " frames=" << nFrames
+            << " rts=" << rts
+            << " wall clock=" << elapsed << "ms"
+            << " per frame=" << elapsed * 1e6 / nFrames << "ns" << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t maxStations = 2000;
+  uint32_t nFrames = 1000000;
+
+  CommandLine cmd;
+  cmd.AddValue ("maxStations", "Largest number of stations", maxStations);
+  cmd.AddValue ("nFrames", "Number of frames for each number of stations", nFrames);
+  cmd.Parse (argc, argv);
+
+  for (uint32_t nStations = 10; nStations < maxStations; nStations *= 2)
+    {
+      RunBenchmark (nStations, nFrames);
+    }
+  RunBenchmark (maxStations, nFrames);
+
+  return 0;
+}
@@ -87,6 +87,10 @@ AdhocWifiMac::Enqueue (Ptr<const Packet> packet, Mac48Address to)
       //In ad hoc mode, we assume that every destination supports all
       //the rates we support.
       m_stationManager->AddAllSupportedModes (to);
+      if (m_htSupported || m_vhtSupported)
+        {
+          m_stationManager->AddAllSupportedMcs (to);
+        }
       m_stationManager->RecordDisassociated (to);
     }
 
@@ -63,6 +63,25 @@ Bar::Bar (Ptr<const Packet> bar, Mac48Address recipient, uint8_t tid, bool immed
   NS_LOG_FUNCTION (this << bar << recipient << static_cast<uint32_t> (tid) << immediate);
 }
 
+BlockAckManager::Slot::Slot ()
+  : nPackets (0),
+    retry (false)
+{
+}
+
+BlockAckManager::AgreementState::AgreementState (const OriginatorBlockAckAgreement &agreement)
+  : agreement (agreement),
+    slots (4096),
+    nBuffered (0)
+{
+}
+
+BlockAckManager::Slot &
+BlockAckManager::AgreementState::GetSlot (uint16_t seq)
+{
+  return slots[seq % 4096];
+}
+
 BlockAckManager::BlockAckManager ()
 {
   NS_LOG_FUNCTION (this);
@@ -72,15 +91,19 @@ BlockAckManager::~BlockAckManager ()
 {
   NS_LOG_FUNCTION (this);
   m_queue = 0;
+  for (AgreementsI it = m_agreements.begin (); it != m_agreements.end (); it++)
+    {
+      delete it->second;
+    }
   m_agreements.clear ();
-  m_retryPackets.clear ();
+  m_retryAgreements.clear ();
 }
 
 bool
 BlockAckManager::ExistsAgreement (Mac48Address recipient, uint8_t tid) const
 {
   NS_LOG_FUNCTION (this << recipient << static_cast<uint32_t> (tid));
-  return (m_agreements.find (std::make_pair (recipient, tid)) != m_agreements.end ());
+  return (m_agreements.find (GetMac48AddressKey (recipient, tid)) != m_agreements.end ());
 }
 
 bool
@@ -89,19 +112,19 @@ BlockAckManager::ExistsAgreementInState (Mac48Address recipient, uint8_t tid,
 {
   NS_LOG_FUNCTION (this << recipient << static_cast<uint32_t> (tid) << state);
   AgreementsCI it;
-  it = m_agreements.find (std::make_pair (recipient, tid));
+  it = m_agreements.find (GetMac48AddressKey (recipient, tid));
   if (it != m_agreements.end ())
     {
       switch (state)
         {
         case OriginatorBlockAckAgreement::INACTIVE:
-          return it->second.first.IsInactive ();
+          return it->second->agreement.IsInactive ();
         case OriginatorBlockAckAgreement::ESTABLISHED:
-          return it->second.first.IsEstablished ();
+          return it->second->agreement.IsEstablished ();
         case OriginatorBlockAckAgreement::PENDING:
-          return it->second.first.IsPending ();
+          return it->second->agreement.IsPending ();
         case OriginatorBlockAckAgreement::UNSUCCESSFUL:
-          return it->second.first.IsUnsuccessful ();
+          return it->second->agreement.IsUnsuccessful ();
         default:
           NS_FATAL_ERROR ("Invalid state for block ack agreement");
         }
@@ -113,7 +136,6 @@ void
 BlockAckManager::CreateAgreement (const MgtAddBaRequestHeader *reqHdr, Mac48Address recipient)
 {
   NS_LOG_FUNCTION (this << reqHdr << recipient);
-  std::pair<Mac48Address, uint8_t> key (recipient, reqHdr->GetTid ());
   OriginatorBlockAckAgreement agreement (recipient, reqHdr->GetTid ());
   agreement.SetStartingSequence (reqHdr->GetStartingSequence ());
   /* For now we assume that originator doesn't use this field. Use of this field
@@ -132,9 +154,11 @@ BlockAckManager::CreateAgreement (const MgtAddBaRequestHeader *reqHdr, Mac48Addr
       agreement.SetDelayedBlockAck ();
     }
   agreement.SetState (OriginatorBlockAckAgreement::PENDING);
-  PacketQueue queue (0);
-  std::pair<OriginatorBlockAckAgreement, PacketQueue> value (agreement, queue);
-  m_agreements.insert (std::make_pair (key, value));
+  uint64_t key = GetMac48AddressKey (recipient, reqHdr->GetTid ());
+  if (m_agreements.find (key) == m_agreements.end ())
+    {
+      m_agreements[key] = new AgreementState (agreement);
+    }
   m_blockPackets (recipient, reqHdr->GetTid ());
 }
 
@@ -142,20 +166,14 @@ void
 BlockAckManager::DestroyAgreement (Mac48Address recipient, uint8_t tid)
 {
   NS_LOG_FUNCTION (this << recipient << static_cast<uint32_t> (tid));
-  AgreementsI it = m_agreements.find (std::make_pair (recipient, tid));
+  AgreementsI it = m_agreements.find (GetMac48AddressKey (recipient, tid));
   if (it != m_agreements.end ())
     {
-      for (std::list<PacketQueueI>::iterator i = m_retryPackets.begin (); i != m_retryPackets.end (); )
+      if (!it->second->retryPackets.empty ())
         {
-          if ((*i)->hdr.GetAddr1 () == recipient && (*i)->hdr.GetQosTid () == tid)
-            {
-              i = m_retryPackets.erase (i);
-            }
-          else
-            {
-              i++;
-            }
+          m_retryAgreements.remove (it->second);
         }
+      delete it->second;
       m_agreements.erase (it);
       //remove scheduled bar
       for (std::list<Bar>::iterator i = m_bars.begin (); i != m_bars.end (); )
@@ -177,10 +195,10 @@ BlockAckManager::UpdateAgreement (const MgtAddBaResponseHeader *respHdr, Mac48Ad
 {
   NS_LOG_FUNCTION (this << respHdr << recipient);
   uint8_t tid = respHdr->GetTid ();
-  AgreementsI it = m_agreements.find (std::make_pair (recipient, tid));
+  AgreementsI it = m_agreements.find (GetMac48AddressKey (recipient, tid));
   if (it != m_agreements.end ())
     {
-      OriginatorBlockAckAgreement& agreement = it->second.first;
+      OriginatorBlockAckAgreement& agreement = it->second->agreement;
       agreement.SetBufferSize (respHdr->GetBufferSize () + 1);
       agreement.SetTimeout (respHdr->GetTimeout ());
       agreement.SetAmsduSupport (respHdr->IsAmsduSupported ());
@@ -215,33 +233,36 @@ BlockAckManager::StorePacket (Ptr<const Packet> packet, const WifiMacHeader &hdr
   Mac48Address recipient = hdr.GetAddr1 ();
 
   Item item (packet, hdr, tStamp);
-  AgreementsI it = m_agreements.find (std::make_pair (recipient, tid));
+  AgreementsI it = m_agreements.find (GetMac48AddressKey (recipient, tid));
   NS_ASSERT (it != m_agreements.end ());
-  PacketQueueI queueIt = it->second.second.begin ();
-  for (; queueIt != it->second.second.end (); )
+  AgreementState *state = it->second;
+  /* packets are mostly stored in the order of their sequence numbers:
+     look for the position of the packet from the end of the buffer */
+  PacketQueueI queueIt = state->packets.end ();
+  while (queueIt != state->packets.begin ())
     {
-      if (((hdr.GetSequenceNumber () - queueIt->hdr.GetSequenceNumber () + 4096) % 4096) > 2047)
+      PacketQueueI prev = queueIt;
+      prev--;
+      if (((hdr.GetSequenceNumber () - prev->hdr.GetSequenceNumber () + 4096) % 4096) <= 2047)
         {
-          queueIt = it->second.second.insert (queueIt, item);
           break;
         }
-      else
-        {
-          queueIt++;
-        }
+      queueIt = prev;
     }
-  if (queueIt == it->second.second.end ())
+  state->packets.insert (queueIt, item);
+  Slot &slot = state->GetSlot (hdr.GetSequenceNumber ());
+  if (slot.nPackets++ == 0)
     {
-      it->second.second.push_back (item);
+      state->nBuffered++;
     }
 }
 
 void
 BlockAckManager::CompleteAmpduExchange (Mac48Address recipient, uint8_t tid)
 {
-  AgreementsI it = m_agreements.find (std::make_pair (recipient, tid));
+  AgreementsI it = m_agreements.find (GetMac48AddressKey (recipient, tid));
   NS_ASSERT (it != m_agreements.end ());
-  OriginatorBlockAckAgreement &agreement = (*it).second.first;
+  OriginatorBlockAckAgreement &agreement = it->second->agreement;
   agreement.CompleteExchange ();
 }
 
@@ -253,71 +274,54 @@ BlockAckManager::GetNextPacket (WifiMacHeader &hdr)
   uint8_t tid;
   Mac48Address recipient;
   CleanupBuffers ();
-  if (!m_retryPackets.empty ())
+  while (!m_retryAgreements.empty ())
     {
-      NS_LOG_DEBUG ("Retry buffer size is " << m_retryPackets.size ());
-      std::list<PacketQueueI>::iterator it = m_retryPackets.begin ();
-      while (it != m_retryPackets.end ())
+      AgreementState *state = m_retryAgreements.front ();
+      NS_LOG_DEBUG ("Retry buffer size is " << state->retryPackets.size ());
+      RetryQueueI it = state->retryPackets.begin ();
+      if (!(*it)->hdr.IsQosData ())
         {
-          if ((*it)->hdr.IsQosData ())
-            {
-              tid = (*it)->hdr.GetQosTid ();
-            }
-          else
-            {
-              NS_FATAL_ERROR ("Packet in blockAck manager retry queue is not Qos Data");
-            }
-          recipient = (*it)->hdr.GetAddr1 ();
-          AgreementsI agreement = m_agreements.find (std::make_pair (recipient, tid));
-          NS_ASSERT (agreement != m_agreements.end ());
-          if (QosUtilsIsOldPacket (agreement->second.first.GetStartingSequence (),(*it)->hdr.GetSequenceNumber ()))
-            {
-              //Standard says the originator should not send a packet with seqnum < winstart
-              NS_LOG_DEBUG ("The Retry packet have sequence number < WinStartO --> Discard " << (*it)->hdr.GetSequenceNumber () << " " << agreement->second.first.GetStartingSequence ());
-              agreement->second.second.erase ((*it));
-              it = m_retryPackets.erase (it);
-              continue;
-            }
-          else if ((*it)->hdr.GetSequenceNumber () > (agreement->second.first.GetStartingSequence () + 63) % 4096)
-            {
-              agreement->second.first.SetStartingSequence ((*it)->hdr.GetSequenceNumber ());
-            }
-          packet = (*it)->packet->Copy ();
-          hdr = (*it)->hdr;
-          hdr.SetRetry ();
-          NS_LOG_INFO ("Retry packet seq = " << hdr.GetSequenceNumber ());
-          if (hdr.IsQosData ())
-            {
-              tid = hdr.GetQosTid ();
-            }
-          else
-            {
-              NS_FATAL_ERROR ("Packet in blockAck manager retry queue is not Qos Data");
-            }
-          recipient = hdr.GetAddr1 ();
-          if (!agreement->second.first.IsHtSupported ()
-              && (ExistsAgreementInState (recipient, tid, OriginatorBlockAckAgreement::ESTABLISHED)
-                  || SwitchToBlockAckIfNeeded (recipient, tid, hdr.GetSequenceNumber ())))
-            {
-              hdr.SetQosAckPolicy (WifiMacHeader::BLOCK_ACK);
-            }
-          else
-            {
-              /* From section 9.10.3 in IEEE802.11e standard:
-               * In order to improve efficiency, originators using the Block Ack facility
-               * may send MPDU frames with the Ack Policy subfield in QoS control frames
-               * set to Normal Ack if only a few MPDUs are available for transmission.[...]
-               * When there are sufficient number of MPDUs, the originator may switch back to
-               * the use of Block Ack.
-               */
-              hdr.SetQosAckPolicy (WifiMacHeader::NORMAL_ACK);
-              AgreementsI i = m_agreements.find (std::make_pair (recipient, tid));
-              i->second.second.erase (*it);
-            }
-          it = m_retryPackets.erase (it);
-          NS_LOG_DEBUG ("Removed one packet, retry buffer size = " << m_retryPackets.size () );
-          break;
+          NS_FATAL_ERROR ("Packet in blockAck manager retry queue is not Qos Data");
+        }
+      OriginatorBlockAckAgreement &agreement = state->agreement;
+      if (QosUtilsIsOldPacket (agreement.GetStartingSequence (), (*it)->hdr.GetSequenceNumber ()))
+        {
+          //Standard says the originator should not send a packet with seqnum < winstart
+          NS_LOG_DEBUG ("The Retry packet have sequence number < WinStartO --> Discard " << (*it)->hdr.GetSequenceNumber () << " " << agreement.GetStartingSequence ());
+          EraseFromBuffer (state, *it);
+          continue;
         }
+      else if ((*it)->hdr.GetSequenceNumber () > (agreement.GetStartingSequence () + 63) % 4096)
+        {
+          agreement.SetStartingSequence ((*it)->hdr.GetSequenceNumber ());
+        }
+      packet = (*it)->packet->Copy ();
+      hdr = (*it)->hdr;
+      hdr.SetRetry ();
+      NS_LOG_INFO ("Retry packet seq = " << hdr.GetSequenceNumber ());
+      tid = hdr.GetQosTid ();
+      recipient = hdr.GetAddr1 ();
+      if (!agreement.IsHtSupported ()
+          && (ExistsAgreementInState (recipient, tid, OriginatorBlockAckAgreement::ESTABLISHED)
+              || SwitchToBlockAckIfNeeded (recipient, tid, hdr.GetSequenceNumber ())))
+        {
+          hdr.SetQosAckPolicy (WifiMacHeader::BLOCK_ACK);
+          EraseFromRetryQueue (state, it);
+        }
+      else
+        {
+          /* From section 9.10.3 in IEEE802.11e standard:
+           * In order to improve efficiency, originators using the Block Ack facility
+           * may send MPDU frames with the Ack Policy subfield in QoS control frames
+           * set to Normal Ack if only a few MPDUs are available for transmission.[...]
+           * When there are sufficient number of MPDUs, the originator may switch back to
+           * the use of Block Ack.
+           */
+          hdr.SetQosAckPolicy (WifiMacHeader::NORMAL_ACK);
+          EraseFromBuffer (state, *it);
+        }
+      NS_LOG_DEBUG ("Removed one packet, retry buffer size = " << state->retryPackets.size ());
+      break;
     }
   return packet;
 }
@@ -329,56 +333,53 @@ BlockAckManager::PeekNextPacket (WifiMacHeader &hdr, Mac48Address recipient, uin
   NS_LOG_FUNCTION (this);
   Ptr<const Packet> packet = 0;
   CleanupBuffers ();
-  AgreementsI agreement = m_agreements.find (std::make_pair (recipient, tid));
+  AgreementsI agreement = m_agreements.find (GetMac48AddressKey (recipient, tid));
   NS_ASSERT (agreement != m_agreements.end ());
-  std::list<PacketQueueI>::iterator it = m_retryPackets.begin ();
-  for (; it != m_retryPackets.end (); it++)
+  AgreementState *state = agreement->second;
+  RetryQueueI it = state->retryPackets.begin ();
+  while (it != state->retryPackets.end ())
     {
       if (!(*it)->hdr.IsQosData ())
         {
           NS_FATAL_ERROR ("Packet in blockAck manager retry queue is not Qos Data");
         }
-      if ((*it)->hdr.GetAddr1 () == recipient && (*it)->hdr.GetQosTid () == tid)
+      if (QosUtilsIsOldPacket (state->agreement.GetStartingSequence (), (*it)->hdr.GetSequenceNumber ()))
         {
-          if (QosUtilsIsOldPacket (agreement->second.first.GetStartingSequence (),(*it)->hdr.GetSequenceNumber ()))
-            {
-              //standard says the originator should not send a packet with seqnum < winstart
-              NS_LOG_DEBUG ("The Retry packet have sequence number < WinStartO --> Discard " << (*it)->hdr.GetSequenceNumber () << " " << agreement->second.first.GetStartingSequence ());
-              agreement->second.second.erase ((*it));
-              it = m_retryPackets.erase (it);
-              it--;
-              continue;
-            }
-          else if ((*it)->hdr.GetSequenceNumber () > (agreement->second.first.GetStartingSequence () + 63) % 4096)
-            {
-              agreement->second.first.SetStartingSequence ((*it)->hdr.GetSequenceNumber ());
-            }
-          packet = (*it)->packet->Copy ();
-          hdr = (*it)->hdr;
-          hdr.SetRetry ();
-          *tstamp = (*it)->timestamp;
-          NS_LOG_INFO ("Retry packet seq = " << hdr.GetSequenceNumber ());
-          Mac48Address recipient = hdr.GetAddr1 ();
-          if (!agreement->second.first.IsHtSupported ()
-              && (ExistsAgreementInState (recipient, tid, OriginatorBlockAckAgreement::ESTABLISHED)
-                  || SwitchToBlockAckIfNeeded (recipient, tid, hdr.GetSequenceNumber ())))
-            {
-              hdr.SetQosAckPolicy (WifiMacHeader::BLOCK_ACK);
-            }
-          else
-            {
-              /* From section 9.10.3 in IEEE802.11e standard:
-               * In order to improve efficiency, originators using the Block Ack facility
-               * may send MPDU frames with the Ack Policy subfield in QoS control frames
-               * set to Normal Ack if only a few MPDUs are available for transmission.[...]
-               * When there are sufficient number of MPDUs, the originator may switch back to
-               * the use of Block Ack.
-               */
-              hdr.SetQosAckPolicy (WifiMacHeader::NORMAL_ACK);
-            }
-          NS_LOG_DEBUG ("Peeked one packet from retry buffer size = " << m_retryPackets.size () );
-          return packet;
+          //standard says the originator should not send a packet with seqnum < winstart
+          NS_LOG_DEBUG ("The Retry packet have sequence number < WinStartO --> Discard " << (*it)->hdr.GetSequenceNumber () << " " << state->agreement.GetStartingSequence ());
+          PacketQueueI item = *it;
+          it++;
+          EraseFromBuffer (state, item);
+          continue;
+        }
+      else if ((*it)->hdr.GetSequenceNumber () > (state->agreement.GetStartingSequence () + 63) % 4096)
+        {
+          state->agreement.SetStartingSequence ((*it)->hdr.GetSequenceNumber ());
+        }
+      packet = (*it)->packet->Copy ();
+      hdr = (*it)->hdr;
+      hdr.SetRetry ();
+      *tstamp = (*it)->timestamp;
+      NS_LOG_INFO ("Retry packet seq = " << hdr.GetSequenceNumber ());
+      if (!state->agreement.IsHtSupported ()
+          && (ExistsAgreementInState (recipient, tid, OriginatorBlockAckAgreement::ESTABLISHED)
+              || SwitchToBlockAckIfNeeded (recipient, tid, hdr.GetSequenceNumber ())))
+        {
+          hdr.SetQosAckPolicy (WifiMacHeader::BLOCK_ACK);
         }
+      else
+        {
+          /* From section 9.10.3 in IEEE802.11e standard:
+           * In order to improve efficiency, originators using the Block Ack facility
+           * may send MPDU frames with the Ack Policy subfield in QoS control frames
+           * set to Normal Ack if only a few MPDUs are available for transmission.[...]
+           * When there are sufficient number of MPDUs, the originator may switch back to
+           * the use of Block Ack.
+           */
+          hdr.SetQosAckPolicy (WifiMacHeader::NORMAL_ACK);
+        }
+      NS_LOG_DEBUG ("Peeked one packet from retry buffer size = " << state->retryPackets.size ());
+      return packet;
     }
   return packet;
 }
@@ -386,29 +387,20 @@ BlockAckManager::PeekNextPacket (WifiMacHeader &hdr, Mac48Address recipient, uin
 bool
 BlockAckManager::RemovePacket (uint8_t tid, Mac48Address recipient, uint16_t seqnumber)
 {
-
-  std::list<PacketQueueI>::iterator it = m_retryPackets.begin ();
-  for (; it != m_retryPackets.end (); it++)
+  AgreementsI agreement = m_agreements.find (GetMac48AddressKey (recipient, tid));
+  if (agreement == m_agreements.end ())
     {
-      if (!(*it)->hdr.IsQosData ())
-        {
-          NS_FATAL_ERROR ("Packet in blockAck manager retry queue is not Qos Data");
-        }
-      if ((*it)->hdr.GetAddr1 () == recipient && (*it)->hdr.GetQosTid () == tid && (*it)->hdr.GetSequenceNumber () == seqnumber)
-        {
-          WifiMacHeader hdr = (*it)->hdr;
-          uint8_t tid = hdr.GetQosTid ();
-          Mac48Address recipient = hdr.GetAddr1 ();
-
-          AgreementsI i = m_agreements.find (std::make_pair (recipient, tid));
-          i->second.second.erase ((*it));
-
-          m_retryPackets.erase (it);
-          NS_LOG_DEBUG ("Removed Packet from retry queue = " << hdr.GetSequenceNumber () << " " << (uint32_t) tid << " " << recipient << " Buffer Size = " << m_retryPackets.size ());
-          return true;
-        }
+      return false;
     }
-  return false;
+  AgreementState *state = agreement->second;
+  Slot &slot = state->GetSlot (seqnumber);
+  if (!slot.retry)
+    {
+      return false;
+    }
+  EraseFromBuffer (state, *slot.retryIt);
+  NS_LOG_DEBUG ("Removed Packet from retry queue = " << seqnumber << " " << (uint32_t) tid << " " << recipient << " Buffer Size = " << state->retryPackets.size ());
+  return true;
 }
 
 bool
@@ -428,30 +420,18 @@ bool
 BlockAckManager::HasPackets (void) const
 {
   NS_LOG_FUNCTION (this);
-  return (m_retryPackets.size () > 0 || m_bars.size () > 0);
+  return (!m_retryAgreements.empty () || !m_bars.empty ());
 }
 
 uint32_t
 BlockAckManager::GetNBufferedPackets (Mac48Address recipient, uint8_t tid) const
 {
   NS_LOG_FUNCTION (this << recipient << static_cast<uint32_t> (tid));
-  uint32_t nPackets = 0;
-  if (ExistsAgreement (recipient, tid))
+  AgreementsCI it = m_agreements.find (GetMac48AddressKey (recipient, tid));
+  if (it != m_agreements.end ())
     {
-      AgreementsCI it = m_agreements.find (std::make_pair (recipient, tid));
-      PacketQueueCI queueIt = (*it).second.second.begin ();
-      uint16_t currentSeq = 0;
-      while (queueIt != (*it).second.second.end ())
-        {
-          currentSeq = (*queueIt).hdr.GetSequenceNumber ();
-          nPackets++;
-          /* a fragmented packet must be counted as one packet */
-          while (queueIt != (*it).second.second.end () && (*queueIt).hdr.GetSequenceNumber () == currentSeq)
-            {
-              queueIt++;
-            }
-        }
-      return nPackets;
+      /* a fragmented packet must be counted as one packet */
+      return it->second->nBuffered;
     }
   return 0;
 }
@@ -460,35 +440,13 @@ uint32_t
 BlockAckManager::GetNRetryNeededPackets (Mac48Address recipient, uint8_t tid) const
 {
   NS_LOG_FUNCTION (this << recipient << static_cast<uint32_t> (tid));
-  uint32_t nPackets = 0;
-  uint16_t currentSeq = 0;
-  if (ExistsAgreement (recipient, tid))
+  AgreementsCI it = m_agreements.find (GetMac48AddressKey (recipient, tid));
+  if (it != m_agreements.end ())
     {
-      std::list<PacketQueueI>::const_iterator it = m_retryPackets.begin ();
-      while (it != m_retryPackets.end ())
-        {
-          if (!(*it)->hdr.IsQosData ())
-            {
-              NS_FATAL_ERROR ("Packet in blockAck manager retry queue is not Qos Data");
-            }
-          if ((*it)->hdr.GetAddr1 () == recipient && (*it)->hdr.GetQosTid () == tid)
-            {
-              currentSeq = (*it)->hdr.GetSequenceNumber ();
-              nPackets++;
-              /* a fragmented packet must be counted as one packet */
-              while (it != m_retryPackets.end () && (*it)->hdr.GetSequenceNumber () == currentSeq)
-                {
-                  it++;
-                }
-            }
-          //go to next packet
-          if (it != m_retryPackets.end ())
-            {
-              it++;
-            }
-        }
+      /* a fragmented packet is only once in the retry queue */
+      return it->second->retryPackets.size ();
     }
-  return nPackets;
+  return 0;
 }
 
 void
@@ -508,19 +466,11 @@ BlockAckManager::SetWifiRemoteStationManager (Ptr<WifiRemoteStationManager> mana
 bool
 BlockAckManager::AlreadyExists (uint16_t currentSeq, Mac48Address recipient, uint8_t tid)
 {
-  std::list<PacketQueueI>::const_iterator it = m_retryPackets.begin ();
-  while (it != m_retryPackets.end ())
+  NS_LOG_FUNCTION (this << currentSeq << recipient << static_cast<uint32_t> (tid));
+  AgreementsI it = m_agreements.find (GetMac48AddressKey (recipient, tid));
+  if (it != m_agreements.end ())
     {
-      NS_LOG_FUNCTION (this << (*it)->hdr.GetType ());
-      if (!(*it)->hdr.IsQosData ())
-        {
-          NS_FATAL_ERROR ("Packet in blockAck manager retry queue is not Qos Data");
-        }
-      if ((*it)->hdr.GetAddr1 () == recipient && (*it)->hdr.GetQosTid () == tid && currentSeq == (*it)->hdr.GetSequenceNumber ())
-        {
-          return true;
-        }
-      it++;
+      return it->second->GetSlot (currentSeq).retry;
     }
   return false;
 }
@@ -536,29 +486,30 @@ BlockAckManager::NotifyGotBlockAck (const CtrlBAckResponseHeader *blockAck, Mac4
       if (ExistsAgreementInState (recipient, tid, OriginatorBlockAckAgreement::ESTABLISHED))
         {
           bool foundFirstLost = false;
-          AgreementsI it = m_agreements.find (std::make_pair (recipient, tid));
-          PacketQueueI queueEnd = it->second.second.end ();
+          AgreementsI it = m_agreements.find (GetMac48AddressKey (recipient, tid));
+          AgreementState *state = it->second;
+          PacketQueueI queueEnd = state->packets.end ();
 
-          if (it->second.first.m_inactivityEvent.IsRunning ())
+          if (state->agreement.m_inactivityEvent.IsRunning ())
             {
               /* Upon reception of a block ack frame, the inactivity timer at the
                  originator must be reset.
                  For more details see section 11.5.3 in IEEE802.11e standard */
-              it->second.first.m_inactivityEvent.Cancel ();
-              Time timeout = MicroSeconds (1024 * it->second.first.GetTimeout ());
-              it->second.first.m_inactivityEvent = Simulator::Schedule (timeout,
+              state->agreement.m_inactivityEvent.Cancel ();
+              Time timeout = MicroSeconds (1024 * state->agreement.GetTimeout ());
+              state->agreement.m_inactivityEvent = Simulator::Schedule (timeout,
                                                                         &BlockAckManager::InactivityTimeout,
                                                                         this,
                                                                         recipient, tid);
             }
           if (blockAck->IsBasic ())
             {
-              for (PacketQueueI queueIt = it->second.second.begin (); queueIt != queueEnd; )
+              for (PacketQueueI queueIt = state->packets.begin (); queueIt != queueEnd; )
                 {
                   if (blockAck->IsFragmentReceived ((*queueIt).hdr.GetSequenceNumber (),
                                                     (*queueIt).hdr.GetFragmentNumber ()))
                     {
-                      queueIt = it->second.second.erase (queueIt);
+                      queueIt = EraseFromBuffer (state, queueIt);
                     }
                   else
                     {
@@ -566,12 +517,12 @@ BlockAckManager::NotifyGotBlockAck (const CtrlBAckResponseHeader *blockAck, Mac4
                         {
                           foundFirstLost = true;
                           sequenceFirstLost = (*queueIt).hdr.GetSequenceNumber ();
-                          (*it).second.first.SetStartingSequence (sequenceFirstLost);
+                          state->agreement.SetStartingSequence (sequenceFirstLost);
                         }
 
-                      if (!AlreadyExists ((*queueIt).hdr.GetSequenceNumber (),recipient,tid))
+                      if (!state->GetSlot ((*queueIt).hdr.GetSequenceNumber ()).retry)
                         {
-                          InsertInRetryQueue (queueIt);
+                          InsertInRetryQueue (state, queueIt);
                         }
 
                       queueIt++;
@@ -580,7 +531,7 @@ BlockAckManager::NotifyGotBlockAck (const CtrlBAckResponseHeader *blockAck, Mac4
             }
           else if (blockAck->IsCompressed ())
             {
-              for (PacketQueueI queueIt = it->second.second.begin (); queueIt != queueEnd; )
+              for (PacketQueueI queueIt = state->packets.begin (); queueIt != queueEnd; )
                 {
                   if (blockAck->IsPacketReceived ((*queueIt).hdr.GetSequenceNumber ()))
                     {
@@ -594,7 +545,7 @@ BlockAckManager::NotifyGotBlockAck (const CtrlBAckResponseHeader *blockAck, Mac4
                             {
                               m_txOkCallback ((*queueIt).hdr);
                             }
-                          queueIt = it->second.second.erase (queueIt);
+                          queueIt = EraseFromBuffer (state, queueIt);
                         }
                     }
                   else
@@ -603,7 +554,7 @@ BlockAckManager::NotifyGotBlockAck (const CtrlBAckResponseHeader *blockAck, Mac4
                         {
                           foundFirstLost = true;
                           sequenceFirstLost = (*queueIt).hdr.GetSequenceNumber ();
-                          (*it).second.first.SetStartingSequence (sequenceFirstLost);
+                          state->agreement.SetStartingSequence (sequenceFirstLost);
                         }
                       //notify remote station of unsuccessful transmission
                       m_stationManager->ReportDataFailed ((*queueIt).hdr.GetAddr1 (), &(*queueIt).hdr);
@@ -611,9 +562,9 @@ BlockAckManager::NotifyGotBlockAck (const CtrlBAckResponseHeader *blockAck, Mac4
                         {
                           m_txFailedCallback ((*queueIt).hdr);
                         }
-                      if (!AlreadyExists ((*queueIt).hdr.GetSequenceNumber (),recipient,tid))
+                      if (!state->GetSlot ((*queueIt).hdr.GetSequenceNumber ()).retry)
                         {
-                          InsertInRetryQueue (queueIt);
+                          InsertInRetryQueue (state, queueIt);
                         }
                       queueIt++;
                     }
@@ -623,7 +574,7 @@ BlockAckManager::NotifyGotBlockAck (const CtrlBAckResponseHeader *blockAck, Mac4
           if ((foundFirstLost && !SwitchToBlockAckIfNeeded (recipient, tid, sequenceFirstLost))
               || (!foundFirstLost && !SwitchToBlockAckIfNeeded (recipient, tid, newSeq)))
             {
-              it->second.first.CompleteExchange ();
+              state->agreement.CompleteExchange ();
             }
         }
     }
@@ -650,14 +601,14 @@ BlockAckManager::ScheduleBlockAckReqIfNeeded (Mac48Address recipient, uint8_t ti
      packets but some of these packets are dropped due to MSDU lifetime expiration.
    */
   NS_LOG_FUNCTION (this << recipient << static_cast<uint32_t> (tid));
-  AgreementsI it = m_agreements.find (std::make_pair (recipient, tid));
+  AgreementsI it = m_agreements.find (GetMac48AddressKey (recipient, tid));
   NS_ASSERT (it != m_agreements.end ());
 
-  if ((*it).second.first.IsBlockAckRequestNeeded ()
+  if (it->second->agreement.IsBlockAckRequestNeeded ()
       || (GetNRetryNeededPackets (recipient, tid) == 0
           && m_queue->GetNPacketsByTidAndAddress (tid, WifiMacHeader::ADDR1, recipient) == 0))
     {
-      OriginatorBlockAckAgreement &agreement = (*it).second.first;
+      OriginatorBlockAckAgreement &agreement = it->second->agreement;
       agreement.CompleteExchange ();
 
       CtrlBAckRequestHeader reqHdr;
@@ -693,22 +644,22 @@ void
 BlockAckManager::NotifyAgreementEstablished (Mac48Address recipient, uint8_t tid, uint16_t startingSeq)
 {
   NS_LOG_FUNCTION (this << recipient << static_cast<uint32_t> (tid) << startingSeq);
-  AgreementsI it = m_agreements.find (std::make_pair (recipient, tid));
+  AgreementsI it = m_agreements.find (GetMac48AddressKey (recipient, tid));
   NS_ASSERT (it != m_agreements.end ());
 
-  it->second.first.SetState (OriginatorBlockAckAgreement::ESTABLISHED);
-  it->second.first.SetStartingSequence (startingSeq);
+  it->second->agreement.SetState (OriginatorBlockAckAgreement::ESTABLISHED);
+  it->second->agreement.SetStartingSequence (startingSeq);
 }
 
 void
 BlockAckManager::NotifyAgreementUnsuccessful (Mac48Address recipient, uint8_t tid)
 {
   NS_LOG_FUNCTION (this << recipient << static_cast<uint32_t> (tid));
-  AgreementsI it = m_agreements.find (std::make_pair (recipient, tid));
+  AgreementsI it = m_agreements.find (GetMac48AddressKey (recipient, tid));
   NS_ASSERT (it != m_agreements.end ());
   if (it != m_agreements.end ())
     {
-      it->second.first.SetState (OriginatorBlockAckAgreement::UNSUCCESSFUL);
+      it->second->agreement.SetState (OriginatorBlockAckAgreement::UNSUCCESSFUL);
     }
 }
 
@@ -717,7 +668,7 @@ BlockAckManager::NotifyMpduTransmission (Mac48Address recipient, uint8_t tid, ui
 {
   NS_LOG_FUNCTION (this << recipient << static_cast<uint32_t> (tid) << nextSeqNumber);
   Ptr<Packet> bar = 0;
-  AgreementsI it = m_agreements.find (std::make_pair (recipient, tid));
+  AgreementsI it = m_agreements.find (GetMac48AddressKey (recipient, tid));
   NS_ASSERT (it != m_agreements.end ());
 
   uint16_t nextSeq;
@@ -729,13 +680,13 @@ BlockAckManager::NotifyMpduTransmission (Mac48Address recipient, uint8_t tid, ui
     {
       nextSeq = nextSeqNumber;
     }
-  it->second.first.NotifyMpduTransmission (nextSeq);
+  it->second->agreement.NotifyMpduTransmission (nextSeq);
   if (policy == WifiMacHeader::BLOCK_ACK)
     {
       bar = ScheduleBlockAckReqIfNeeded (recipient, tid);
       if (bar != 0)
         {
-          Bar request (bar, recipient, tid, it->second.first.IsImmediateBlockAck ());
+          Bar request (bar, recipient, tid, it->second->agreement.IsImmediateBlockAck ());
           m_bars.push_back (request);
         }
     }
@@ -778,9 +729,9 @@ BlockAckManager::HasOtherFragments (uint16_t sequenceNumber) const
 {
   NS_LOG_FUNCTION (this << sequenceNumber);
   bool retVal = false;
-  if (m_retryPackets.size () > 0)
+  if (!m_retryAgreements.empty ())
     {
-      Item next = *(m_retryPackets.front ());
+      const Item &next = *(m_retryAgreements.front ()->retryPackets.front ());
       if (next.hdr.GetSequenceNumber () == sequenceNumber)
         {
           retVal = true;
@@ -794,9 +745,9 @@ BlockAckManager::GetNextPacketSize (void) const
 {
   NS_LOG_FUNCTION (this);
   uint32_t size = 0;
-  if (m_retryPackets.size () > 0)
+  if (!m_retryAgreements.empty ())
     {
-      Item next = *(m_retryPackets.front ());
+      const Item &next = *(m_retryAgreements.front ()->retryPackets.front ());
       size = next.packet->GetSize ();
     }
   return size;
@@ -805,10 +756,10 @@ BlockAckManager::GetNextPacketSize (void) const
 bool BlockAckManager::NeedBarRetransmission (uint8_t tid, uint16_t seqNumber, Mac48Address recipient)
 {
   //The standard says the BAR gets discarded when all MSDUs lifetime expires
-  AgreementsI it = m_agreements.find (std::make_pair (recipient, tid));
+  AgreementsI it = m_agreements.find (GetMac48AddressKey (recipient, tid));
   NS_ASSERT (it != m_agreements.end ());
   CleanupBuffers ();
-  if ((seqNumber + 63) < it->second.first.GetStartingSequence ())
+  if ((seqNumber + 63) < it->second->agreement.GetStartingSequence ())
     {
       return false;
     }
@@ -824,13 +775,14 @@ BlockAckManager::CleanupBuffers (void)
   NS_LOG_FUNCTION (this);
   for (AgreementsI j = m_agreements.begin (); j != m_agreements.end (); j++)
     {
-      if (j->second.second.empty ())
+      AgreementState *state = j->second;
+      if (state->packets.empty ())
         {
           continue;
         }
       Time now = Simulator::Now ();
-      PacketQueueI end = j->second.second.begin ();
-      for (PacketQueueI i = j->second.second.begin (); i != j->second.second.end (); i++)
+      PacketQueueI end = state->packets.begin ();
+      for (PacketQueueI i = state->packets.begin (); i != state->packets.end (); i++)
         {
           if (i->timestamp + m_maxDelay > now)
             {
@@ -840,23 +792,18 @@ BlockAckManager::CleanupBuffers (void)
           else
             {
               /* remove retry packet iterator if it's present in retry queue */
-              for (std::list<PacketQueueI>::iterator it = m_retryPackets.begin (); it != m_retryPackets.end (); )
+              Slot &slot = state->GetSlot (i->hdr.GetSequenceNumber ());
+              if (slot.retry)
                 {
-                  if ((*it)->hdr.GetAddr1 () == j->second.first.GetPeer ()
-                      && (*it)->hdr.GetQosTid () == j->second.first.GetTid ()
-                      && (*it)->hdr.GetSequenceNumber () == i->hdr.GetSequenceNumber ())
-                    {
-                      it = m_retryPackets.erase (it);
-                    }
-                  else
-                    {
-                      it++;
-                    }
+                  EraseFromRetryQueue (state, slot.retryIt);
                 }
             }
         }
-      j->second.second.erase (j->second.second.begin (), end);
-      j->second.first.SetStartingSequence (end->hdr.GetSequenceNumber ());
+      for (PacketQueueI i = state->packets.begin (); i != end; )
+        {
+          i = EraseFromBuffer (state, i);
+        }
+      state->agreement.SetStartingSequence (end->hdr.GetSequenceNumber ());
     }
 }
 
@@ -899,18 +846,15 @@ uint16_t
 BlockAckManager::GetSeqNumOfNextRetryPacket (Mac48Address recipient, uint8_t tid) const
 {
   NS_LOG_FUNCTION (this << recipient << static_cast<uint32_t> (tid));
-  std::list<PacketQueueI>::const_iterator it = m_retryPackets.begin ();
-  while (it != m_retryPackets.end ())
+  AgreementsCI it = m_agreements.find (GetMac48AddressKey (recipient, tid));
+  if (it != m_agreements.end () && !it->second->retryPackets.empty ())
     {
-      if (!(*it)->hdr.IsQosData ())
+      const Item &next = *(it->second->retryPackets.front ());
+      if (!next.hdr.IsQosData ())
         {
           NS_FATAL_ERROR ("Packet in blockAck manager retry queue is not Qos Data");
         }
-      if ((*it)->hdr.GetAddr1 () == recipient && (*it)->hdr.GetQosTid () == tid)
-        {
-          return (*it)->hdr.GetSequenceNumber ();
-        }
-      it++;
+      return next.hdr.GetSequenceNumber ();
     }
   return 4096;
 }
@@ -928,32 +872,51 @@ BlockAckManager::SetTxFailedCallback (TxFailed callback)
 }
 
 void
-BlockAckManager::InsertInRetryQueue (PacketQueueI item)
+BlockAckManager::InsertInRetryQueue (AgreementState *state, PacketQueueI item)
 {
   NS_LOG_INFO ("Adding to retry queue " << (*item).hdr.GetSequenceNumber ());
-  if (m_retryPackets.size () == 0)
+  if (state->retryPackets.empty ())
     {
-      m_retryPackets.push_back (item);
+      m_retryAgreements.push_back (state);
     }
-  else
+  RetryQueueI it = state->retryPackets.begin ();
+  while (it != state->retryPackets.end ()
+         && ((item->hdr.GetSequenceNumber () - (*it)->hdr.GetSequenceNumber () + 4096) % 4096) <= 2047)
     {
-      for (std::list<PacketQueueI>::iterator it = m_retryPackets.begin (); it != m_retryPackets.end (); )
-        {
-          if (((item->hdr.GetSequenceNumber () - (*it)->hdr.GetSequenceNumber () + 4096) % 4096) > 2047)
-            {
-              it = m_retryPackets.insert (it, item);
-              break;
-            }
-          else
-            {
-              it++;
-              if (it == m_retryPackets.end ())
-                {
-                  m_retryPackets.push_back (item);
-                }
-            }
-        }
+      it++;
+    }
+  Slot &slot = state->GetSlot (item->hdr.GetSequenceNumber ());
+  NS_ASSERT (!slot.retry);
+  slot.retry = true;
+  slot.retryIt = state->retryPackets.insert (it, item);
+}
+
+BlockAckManager::RetryQueueI
+BlockAckManager::EraseFromRetryQueue (AgreementState *state, RetryQueueI it)
+{
+  state->GetSlot ((*it)->hdr.GetSequenceNumber ()).retry = false;
+  it = state->retryPackets.erase (it);
+  if (state->retryPackets.empty ())
+    {
+      m_retryAgreements.remove (state);
+    }
+  return it;
+}
+
+BlockAckManager::PacketQueueI
+BlockAckManager::EraseFromBuffer (AgreementState *state, PacketQueueI item)
+{
+  Slot &slot = state->GetSlot (item->hdr.GetSequenceNumber ());
+  if (slot.retry && *slot.retryIt == item)
+    {
+      EraseFromRetryQueue (state, slot.retryIt);
+    }
+  NS_ASSERT (slot.nPackets > 0);
+  if (--slot.nPackets == 0)
+    {
+      state->nBuffered--;
     }
+  return state->packets.erase (item);
 }
 
 } //namespace ns3
@@ -21,10 +21,11 @@
 #ifndef BLOCK_ACK_MANAGER_H
 #define BLOCK_ACK_MANAGER_H
 
-#include <map>
 #include <list>
-#include <deque>
+#include <vector>
 #include "ns3/packet.h"
+#include "ns3/sgi-hashmap.h"
+#include "mac48-address-key.h"
 #include "wifi-mac-header.h"
 #include "originator-block-ack-agreement.h"
 #include "ctrl-headers.h"
@@ -383,20 +384,13 @@ private:
    */
   typedef std::list<Item>::const_iterator PacketQueueCI;
   /**
-   * typedef for a map between MAC address and block ACK agreement.
+   * typedef for a list of iterators to the packets which need retransmission.
    */
-  typedef std::map<std::pair<Mac48Address, uint8_t>,
-                   std::pair<OriginatorBlockAckAgreement, PacketQueue> > Agreements;
+  typedef std::list<PacketQueueI> RetryQueue;
   /**
-   * typedef for an iterator for Agreements.
+   * typedef for an iterator for RetryQueue.
    */
-  typedef std::map<std::pair<Mac48Address, uint8_t>,
-                   std::pair<OriginatorBlockAckAgreement, PacketQueue> >::iterator AgreementsI;
-  /**
-   * typedef for a const iterator for Agreements.
-   */
-  typedef std::map<std::pair<Mac48Address, uint8_t>,
-                   std::pair<OriginatorBlockAckAgreement, PacketQueue> >::const_iterator AgreementsCI;
+  typedef std::list<PacketQueueI>::iterator RetryQueueI;
 
   /**
    * A struct for packet, Wifi header, and timestamp.
@@ -412,13 +406,88 @@ private:
     WifiMacHeader hdr;
     Time timestamp;
   };
+
+  /**
+   * The state of the reorder buffer of an agreement for one sequence number.
+   */
+  struct Slot
+  {
+    Slot ();
+    uint8_t nPackets;    ///< the number of buffered packets (fragments) with this sequence number
+    bool retry;          ///< whether a packet with this sequence number needs retransmission
+    RetryQueueI retryIt; ///< the packet in the retry queue of the agreement, if any
+  };
+
+  /**
+   * A block ack agreement and its reorder buffer.
+   *
+   * The buffer holds the packets sent under the agreement and not yet
+   * acknowledged, in the order of their sequence numbers, and the retry
+   * queue the ones among them which need retransmission, in the same
+   * order. Both are indexed by a ring of 4096 slots, one per sequence
+   * number modulo 4096, so that finding whether a sequence number is
+   * buffered or needs retransmission does not scan the queues.
+   */
+  struct AgreementState
+  {
+    /**
+     * \param agreement the agreement
+     */
+    AgreementState (const OriginatorBlockAckAgreement &agreement);
+    /**
+     * \param seq a sequence number
+     * \returns the slot of the sequence number
+     */
+    Slot & GetSlot (uint16_t seq);
+
+    OriginatorBlockAckAgreement agreement; ///< the agreement
+    PacketQueue packets;                   ///< the buffered packets
+    RetryQueue retryPackets;               ///< the packets which need retransmission
+    std::vector<Slot> slots;               ///< the slots, by sequence number
+    uint32_t nBuffered;                    ///< the number of sequence numbers with buffered packets
+  };
+
   /**
-   * \param item
+   * typedef for a hash map between recipient, Traffic ID, and block ACK agreement.
+   */
+  typedef sgi::hash_map<uint64_t, AgreementState *, Mac48AddressKeyHash> Agreements;
+  /**
+   * typedef for an iterator for Agreements.
+   */
+  typedef Agreements::iterator AgreementsI;
+  /**
+   * typedef for a const iterator for Agreements.
+   */
+  typedef Agreements::const_iterator AgreementsCI;
+
+  /**
+   * \param state the agreement of the packet
+   * \param item the packet
    *
-   * Insert item in retransmission queue.
+   * Insert item in the retransmission queue of its agreement.
    * This method ensures packets are retransmitted in the correct order.
    */
-  void InsertInRetryQueue (PacketQueueI item);
+  void InsertInRetryQueue (AgreementState *state, PacketQueueI item);
+  /**
+   * \param state the agreement of the packet
+   * \param it the packet in the retransmission queue of the agreement
+   *
+   * \return the next packet of the retransmission queue
+   *
+   * Remove a packet from the retransmission queue, the packet staying in
+   * the buffer of the agreement.
+   */
+  RetryQueueI EraseFromRetryQueue (AgreementState *state, RetryQueueI it);
+  /**
+   * \param state the agreement of the packet
+   * \param item the packet
+   *
+   * \return the next packet of the buffer
+   *
+   * Remove a packet from the buffer of its agreement, and from the
+   * retransmission queue if it is there.
+   */
+  PacketQueueI EraseFromBuffer (AgreementState *state, PacketQueueI item);
 
   /**
    * This data structure contains, for each block ack agreement (recipient, tid), a set of packets
@@ -429,11 +498,12 @@ private:
   Agreements m_agreements;
 
   /**
-   * This list contains all iterators to stored packets that need to be retransmitted.
+   * This list contains the agreements which have packets to retransmit, in the order
+   * in which their first packet needed retransmission.
    * A packet needs retransmission if it's indicated as not correctly received in a block ack
    * frame.
    */
-  std::list<PacketQueueI> m_retryPackets;
+  std::list<AgreementState *> m_retryAgreements;
   std::list<Bar> m_bars;
 
   uint8_t m_blockAckThreshold;
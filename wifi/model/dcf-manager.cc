@@ -313,10 +313,14 @@ DcfManager::DcfManager ()
     m_lastSwitchingDuration (MicroSeconds (0)),
     m_rxing (false),
     m_sleeping (false),
+    m_accessGrantStart (MicroSeconds (0)),
+    m_accessTimeoutEnd (MicroSeconds (0)),
     m_slotTimeUs (0),
     m_sifs (Seconds (0.0)),
     m_phyListener (0),
-    m_lowListener (0)
+    m_lowListener (0),
+    m_scheduledAccessTimeouts (0),
+    m_usefulAccessTimeouts (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -377,6 +381,7 @@ DcfManager::SetSifs (Time sifs)
 {
   NS_LOG_FUNCTION (this << sifs);
   m_sifs = sifs;
+  UpdateAccessGrantStart ();
 }
 
 void
@@ -384,6 +389,7 @@ DcfManager::SetEifsNoDifs (Time eifsNoDifs)
 {
   NS_LOG_FUNCTION (this << eifsNoDifs);
   m_eifsNoDifs = eifsNoDifs;
+  UpdateAccessGrantStart ();
 }
 
 Time
@@ -504,16 +510,17 @@ DcfManager::RequestAccess (DcfState *state)
   DoRestartAccessTimeoutIfNeeded ();
 }
 
-void
+bool
 DcfManager::DoGrantAccess (void)
 {
   NS_LOG_FUNCTION (this);
+  Time accessGrantStart = GetAccessGrantStart ();
   uint32_t k = 0;
   for (States::const_iterator i = m_states.begin (); i != m_states.end (); k++)
     {
       DcfState *state = *i;
       if (state->IsAccessRequested ()
-          && GetBackoffEndFor (state) <= Simulator::Now () )
+          && GetBackoffEndFor (state, accessGrantStart) <= Simulator::Now () )
         {
           /**
            * This is the first dcf we find with an expired backoff and which
@@ -527,7 +534,7 @@ DcfManager::DoGrantAccess (void)
             {
               DcfState *otherState = *j;
               if (otherState->IsAccessRequested ()
-                  && GetBackoffEndFor (otherState) <= Simulator::Now ())
+                  && GetBackoffEndFor (otherState, accessGrantStart) <= Simulator::Now ())
                 {
                   MY_DEBUG ("dcf " << k << " needs access. backoff expired. internal collision. slots=" <<
                             otherState->GetBackoffSlots ());
@@ -553,23 +560,44 @@ DcfManager::DoGrantAccess (void)
             {
               (*k)->NotifyInternalCollision ();
             }
-          break;
+          return true;
         }
       i++;
     }
+  return false;
 }
 
 void
 DcfManager::AccessTimeout (void)
 {
   NS_LOG_FUNCTION (this);
+  /**
+   * If the medium became busy after this timeout was scheduled, no
+   * backoff can have ended yet: the backoff slots cannot be updated
+   * and the access cannot be granted, so the timeout only needs to
+   * move to the new expected end of backoff.
+   */
+  if (GetAccessGrantStart () > Simulator::Now ())
+    {
+      DoRestartAccessTimeoutIfNeeded ();
+      return;
+    }
   UpdateBackoff ();
-  DoGrantAccess ();
+  if (DoGrantAccess ())
+    {
+      m_usefulAccessTimeouts++;
+    }
   DoRestartAccessTimeoutIfNeeded ();
 }
 
 Time
 DcfManager::GetAccessGrantStart (void) const
+{
+  return m_accessGrantStart;
+}
+
+void
+DcfManager::UpdateAccessGrantStart (void)
 {
   NS_LOG_FUNCTION (this);
   Time rxAccessStart;
@@ -604,35 +632,36 @@ DcfManager::GetAccessGrantStart (void) const
                ", busy access start=" << busyAccessStart <<
                ", tx access start=" << txAccessStart <<
                ", nav access start=" << navAccessStart);
-  return accessGrantedStart;
+  m_accessGrantStart = accessGrantedStart;
 }
 
 Time
-DcfManager::GetBackoffStartFor (DcfState *state)
+DcfManager::GetBackoffStartFor (DcfState *state, Time accessGrantStart)
 {
-  NS_LOG_FUNCTION (this << state);
+  NS_LOG_FUNCTION (this << state << accessGrantStart);
   Time mostRecentEvent = MostRecent (state->GetBackoffStart (),
-                                     GetAccessGrantStart () + MicroSeconds (state->GetAifsn () * m_slotTimeUs));
+                                     accessGrantStart + MicroSeconds (state->GetAifsn () * m_slotTimeUs));
 
   return mostRecentEvent;
 }
 
 Time
-DcfManager::GetBackoffEndFor (DcfState *state)
+DcfManager::GetBackoffEndFor (DcfState *state, Time accessGrantStart)
 {
-  return GetBackoffStartFor (state) + MicroSeconds (state->GetBackoffSlots () * m_slotTimeUs);
+  return GetBackoffStartFor (state, accessGrantStart) + MicroSeconds (state->GetBackoffSlots () * m_slotTimeUs);
 }
 
 void
 DcfManager::UpdateBackoff (void)
 {
   NS_LOG_FUNCTION (this);
+  Time accessGrantStart = GetAccessGrantStart ();
   uint32_t k = 0;
   for (States::const_iterator i = m_states.begin (); i != m_states.end (); i++, k++)
     {
       DcfState *state = *i;
 
-      Time backoffStart = GetBackoffStartFor (state);
+      Time backoffStart = GetBackoffStartFor (state, accessGrantStart);
       if (backoffStart <= Simulator::Now ())
         {
           uint32_t nus = (Simulator::Now () - backoffStart).GetMicroSeconds ();
@@ -649,18 +678,24 @@ void
 DcfManager::DoRestartAccessTimeoutIfNeeded (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_rxing)
+    {
+      // the end of backoff is not known before the end of the reception
+      return;
+    }
   /**
    * Is there a DcfState which needs to access the medium, and,
    * if there is one, how many slots for AIFS+backoff does it require ?
    */
   bool accessTimeoutNeeded = false;
   Time expectedBackoffEnd = Simulator::GetMaximumSimulationTime ();
+  Time accessGrantStart = GetAccessGrantStart ();
   for (States::const_iterator i = m_states.begin (); i != m_states.end (); i++)
     {
       DcfState *state = *i;
       if (state->IsAccessRequested ())
         {
-          Time tmp = GetBackoffEndFor (state);
+          Time tmp = GetBackoffEndFor (state, accessGrantStart);
           if (tmp > Simulator::Now ())
             {
               accessTimeoutNeeded = true;
@@ -671,20 +706,46 @@ DcfManager::DoRestartAccessTimeoutIfNeeded (void)
   if (accessTimeoutNeeded)
     {
       MY_DEBUG ("expected backoff end=" << expectedBackoffEnd);
-      Time expectedBackoffDelay = expectedBackoffEnd - Simulator::Now ();
-      if (m_accessTimeout.IsRunning ()
-          && Simulator::GetDelayLeft (m_accessTimeout) > expectedBackoffDelay)
-        {
-          m_accessTimeout.Cancel ();
-        }
-      if (m_accessTimeout.IsExpired ())
+      if (m_accessTimeout.IsRunning ())
         {
-          m_accessTimeout = Simulator::Schedule (expectedBackoffDelay,
-                                                 &DcfManager::AccessTimeout, this);
+          if (m_accessTimeoutEnd <= expectedBackoffEnd)
+            {
+              /* the pending timeout expires first, and moves itself
+               * to the expected end of backoff if it is too early.
+               */
+              return;
+            }
+          Simulator::Remove (m_accessTimeout);
         }
+      m_accessTimeoutEnd = expectedBackoffEnd;
+      m_accessTimeout = Simulator::Schedule (expectedBackoffEnd - Simulator::Now (),
+                                             &DcfManager::AccessTimeout, this);
+      m_scheduledAccessTimeouts++;
     }
 }
 
+void
+DcfManager::CancelAccessTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_accessTimeout.IsRunning ())
+    {
+      Simulator::Remove (m_accessTimeout);
+    }
+}
+
+uint64_t
+DcfManager::GetScheduledAccessTimeouts (void) const
+{
+  return m_scheduledAccessTimeouts;
+}
+
+uint64_t
+DcfManager::GetUsefulAccessTimeouts (void) const
+{
+  return m_usefulAccessTimeouts;
+}
+
 void
 DcfManager::NotifyRxStartNow (Time duration)
 {
@@ -694,6 +755,7 @@ DcfManager::NotifyRxStartNow (Time duration)
   m_lastRxStart = Simulator::Now ();
   m_lastRxDuration = duration;
   m_rxing = true;
+  UpdateAccessGrantStart ();
 }
 
 void
@@ -704,6 +766,8 @@ DcfManager::NotifyRxEndOkNow (void)
   m_lastRxEnd = Simulator::Now ();
   m_lastRxReceivedOk = true;
   m_rxing = false;
+  UpdateAccessGrantStart ();
+  DoRestartAccessTimeoutIfNeeded ();
 }
 
 void
@@ -714,12 +778,15 @@ DcfManager::NotifyRxEndErrorNow (void)
   m_lastRxEnd = Simulator::Now ();
   m_lastRxReceivedOk = false;
   m_rxing = false;
+  UpdateAccessGrantStart ();
+  DoRestartAccessTimeoutIfNeeded ();
 }
 
 void
 DcfManager::NotifyTxStartNow (Time duration)
 {
   NS_LOG_FUNCTION (this << duration);
+  bool rxAborted = m_rxing;
   if (m_rxing)
     {
       //this may be caused only if PHY has started to receive a packet
@@ -729,11 +796,17 @@ DcfManager::NotifyTxStartNow (Time duration)
       m_lastRxDuration = m_lastRxEnd - m_lastRxStart;
       m_lastRxReceivedOk = true;
       m_rxing = false;
+      UpdateAccessGrantStart ();
     }
   MY_DEBUG ("tx start for " << duration);
   UpdateBackoff ();
   m_lastTxStart = Simulator::Now ();
   m_lastTxDuration = duration;
+  UpdateAccessGrantStart ();
+  if (rxAborted)
+    {
+      DoRestartAccessTimeoutIfNeeded ();
+    }
 }
 
 void
@@ -744,6 +817,7 @@ DcfManager::NotifyMaybeCcaBusyStartNow (Time duration)
   UpdateBackoff ();
   m_lastBusyStart = Simulator::Now ();
   m_lastBusyDuration = duration;
+  UpdateAccessGrantStart ();
 }
 
 void
@@ -780,10 +854,7 @@ DcfManager::NotifySwitchingStartNow (Time duration)
     }
 
   //Cancel timeout
-  if (m_accessTimeout.IsRunning ())
-    {
-      m_accessTimeout.Cancel ();
-    }
+  CancelAccessTimeout ();
 
   //Reset backoffs
   for (States::iterator i = m_states.begin (); i != m_states.end (); i++)
@@ -803,6 +874,7 @@ DcfManager::NotifySwitchingStartNow (Time duration)
   MY_DEBUG ("switching start for " << duration);
   m_lastSwitchingStart = Simulator::Now ();
   m_lastSwitchingDuration = duration;
+  UpdateAccessGrantStart ();
 
 }
 
@@ -812,10 +884,7 @@ DcfManager::NotifySleepNow (void)
   NS_LOG_FUNCTION (this);
   m_sleeping = true;
   //Cancel timeout
-  if (m_accessTimeout.IsRunning ())
-    {
-      m_accessTimeout.Cancel ();
-    }
+  CancelAccessTimeout ();
 
   //Reset backoffs
   for (States::iterator i = m_states.begin (); i != m_states.end (); i++)
@@ -853,6 +922,7 @@ DcfManager::NotifyNavResetNow (Time duration)
   UpdateBackoff ();
   m_lastNavStart = Simulator::Now ();
   m_lastNavDuration = duration;
+  UpdateAccessGrantStart ();
   UpdateBackoff ();
   /**
    * If the nav reset indicates an end-of-nav which is earlier
@@ -876,6 +946,7 @@ DcfManager::NotifyNavStartNow (Time duration)
     {
       m_lastNavStart = Simulator::Now ();
       m_lastNavDuration = duration;
+      UpdateAccessGrantStart ();
     }
 }
 
@@ -885,6 +956,7 @@ DcfManager::NotifyAckTimeoutStartNow (Time duration)
   NS_LOG_FUNCTION (this << duration);
   NS_ASSERT (m_lastAckTimeoutEnd < Simulator::Now ());
   m_lastAckTimeoutEnd = Simulator::Now () + duration;
+  UpdateAccessGrantStart ();
 }
 
 void
@@ -892,6 +964,7 @@ DcfManager::NotifyAckTimeoutResetNow ()
 {
   NS_LOG_FUNCTION (this);
   m_lastAckTimeoutEnd = Simulator::Now ();
+  UpdateAccessGrantStart ();
   DoRestartAccessTimeoutIfNeeded ();
 }
 
@@ -900,6 +973,7 @@ DcfManager::NotifyCtsTimeoutStartNow (Time duration)
 {
   NS_LOG_FUNCTION (this << duration);
   m_lastCtsTimeoutEnd = Simulator::Now () + duration;
+  UpdateAccessGrantStart ();
 }
 
 void
@@ -907,6 +981,7 @@ DcfManager::NotifyCtsTimeoutResetNow ()
 {
   NS_LOG_FUNCTION (this);
   m_lastCtsTimeoutEnd = Simulator::Now ();
+  UpdateAccessGrantStart ();
   DoRestartAccessTimeoutIfNeeded ();
 }
 } //namespace ns3
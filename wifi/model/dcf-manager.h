@@ -248,6 +248,13 @@ private:
  * medium at the same time, the highest priority local DcfState wins
  * access to the medium and the other DcfState suffers a "internal"
  * collision.
+ *
+ * The time from which the medium can be accessed is computed once
+ * whenever the state of the medium changes, and the end of backoff
+ * of each DcfState is derived from it. A single access timeout is
+ * pending at a time: it is moved only when the earliest end of
+ * backoff moves earlier, and it is removed during receptions, whose
+ * end restarts it.
  */
 class DcfManager
 {
@@ -403,6 +410,16 @@ public:
    */
   void NotifyCtsTimeoutResetNow ();
 
+  /**
+   * \return the number of access timeouts scheduled so far
+   */
+  uint64_t GetScheduledAccessTimeouts (void) const;
+  /**
+   * \return the number of access timeouts which granted the access to
+   *         a DcfState so far
+   */
+  uint64_t GetUsefulAccessTimeouts (void) const;
+
 
 private:
   /**
@@ -473,26 +490,45 @@ private:
    * \returns the absolute time at which access could start to be granted
    */
   Time GetAccessGrantStart (void) const;
+  /**
+   * Compute the time returned by GetAccessGrantStart. This must be
+   * called whenever the state of the medium recorded by this
+   * DcfManager changes.
+   */
+  void UpdateAccessGrantStart (void);
   /**
    * Return the time when the backoff procedure
    * started for the given DcfState.
    *
    * \param state
+   * \param accessGrantStart the time returned by GetAccessGrantStart
    *
    * \return the time when the backoff procedure started
    */
-  Time GetBackoffStartFor (DcfState *state);
+  Time GetBackoffStartFor (DcfState *state, Time accessGrantStart);
   /**
    * Return the time when the backoff procedure
    * ended (or will ended) for the given DcfState.
    *
    * \param state
+   * \param accessGrantStart the time returned by GetAccessGrantStart
    *
    * \return the time when the backoff procedure ended (or will ended)
    */
-  Time GetBackoffEndFor (DcfState *state);
+  Time GetBackoffEndFor (DcfState *state, Time accessGrantStart);
 
+  /**
+   * Schedule the access timeout at the earliest expected end of
+   * backoff of the DcfStates which requested the access. A pending
+   * access timeout is rescheduled only if the expected end of backoff
+   * moved earlier: if it moved later, the pending access timeout
+   * expires first and moves itself to the new expected end of backoff.
+   */
   void DoRestartAccessTimeoutIfNeeded (void);
+  /**
+   * Remove the pending access timeout, if any.
+   */
+  void CancelAccessTimeout (void);
 
   /**
    * Called when access timeout should occur
@@ -501,8 +537,11 @@ private:
   void AccessTimeout (void);
   /**
    * Grant access to DCF
+   *
+   * \return true if the access was granted to a DcfState,
+   *         false otherwise
    */
-  void DoGrantAccess (void);
+  bool DoGrantAccess (void);
   /**
    * Check if the device is busy sending or receiving,
    * or NAV busy.
@@ -536,10 +575,14 @@ private:
   bool m_sleeping;
   Time m_eifsNoDifs;
   EventId m_accessTimeout;
+  Time m_accessGrantStart; //!< the access grant start, see UpdateAccessGrantStart
+  Time m_accessTimeoutEnd; //!< the time at which m_accessTimeout expires
   uint32_t m_slotTimeUs;
   Time m_sifs;
   PhyListener* m_phyListener;
   LowDcfListener* m_lowListener;
+  uint64_t m_scheduledAccessTimeouts; //!< number of access timeouts scheduled
+  uint64_t m_usefulAccessTimeouts; //!< number of access timeouts which granted the access
 };
 
 } //namespace ns3
@@ -106,7 +106,8 @@ InterferenceHelper::Event::GetPreambleType (void) const
 
 InterferenceHelper::NiChange::NiChange (Time time, double delta)
   : m_time (time),
-    m_delta (delta)
+    m_delta (delta),
+    m_power (0.0)
 {
 }
 
@@ -122,6 +123,24 @@ InterferenceHelper::NiChange::GetDelta (void) const
   return m_delta;
 }
 
+double
+InterferenceHelper::NiChange::GetPower (void) const
+{
+  return m_power;
+}
+
+void
+InterferenceHelper::NiChange::SetPower (double power)
+{
+  m_power = power;
+}
+
+void
+InterferenceHelper::NiChange::AddPower (double delta)
+{
+  m_power += delta;
+}
+
 bool
 InterferenceHelper::NiChange::operator < (const InterferenceHelper::NiChange& o) const
 {
@@ -162,6 +181,13 @@ InterferenceHelper::Add (uint32_t size, WifiTxVector txVector,
   return event;
 }
 
+void
+InterferenceHelper::AddForeignSignal (Time duration, double rxPowerW)
+{
+  AppendEvent (Create<InterferenceHelper::Event> (0, WifiTxVector (), WIFI_PREAMBLE_NONE,
+                                                  duration, rxPowerW));
+}
+
 
 void
 InterferenceHelper::SetNoiseFigure (double value)
@@ -191,18 +217,12 @@ Time
 InterferenceHelper::GetEnergyDuration (double energyW)
 {
   Time now = Simulator::Now ();
-  double noiseInterferenceW = 0.0;
   Time end = now;
-  noiseInterferenceW = m_firstPower;
-  for (NiChanges::const_iterator i = m_niChanges.begin (); i != m_niChanges.end (); i++)
+  NiChanges::const_iterator i = std::lower_bound (m_niChanges.begin (), m_niChanges.end (), NiChange (now, 0));
+  for (; i != m_niChanges.end (); i++)
     {
-      noiseInterferenceW += i->GetDelta ();
       end = i->GetTime ();
-      if (end < now)
-        {
-          continue;
-        }
-      if (noiseInterferenceW < energyW)
+      if (i->GetPower () < energyW)
         {
           break;
         }
@@ -216,20 +236,12 @@ InterferenceHelper::AppendEvent (Ptr<InterferenceHelper::Event> event)
   Time now = Simulator::Now ();
   if (!m_rxing)
     {
-      NiChanges::iterator nowIterator = GetPosition (now);
-      for (NiChanges::iterator i = m_niChanges.begin (); i != nowIterator; i++)
-        {
-          m_firstPower += i->GetDelta ();
-        }
-      m_niChanges.erase (m_niChanges.begin (), nowIterator);
-      m_niChanges.insert (m_niChanges.begin (), NiChange (event->GetStartTime (), event->GetRxPowerW ()));
-    }
-  else
-    {
-      AddNiChangeEvent (NiChange (event->GetStartTime (), event->GetRxPowerW ()));
+      //Nothing older than now can be needed anymore: the new event
+      //becomes the first NiChange and may be the next one received.
+      EvictNiChanges (GetPosition (now));
     }
+  AddNiChangeEvent (NiChange (event->GetStartTime (), event->GetRxPowerW ()));
   AddNiChangeEvent (NiChange (event->GetEndTime (), -event->GetRxPowerW ()));
-
 }
 
 
@@ -249,21 +261,11 @@ InterferenceHelper::CalculateSnr (double signal, double noiseInterference, uint3
 }
 
 double
-InterferenceHelper::CalculateNoiseInterferenceW (Ptr<InterferenceHelper::Event> event, NiChanges *ni) const
+InterferenceHelper::CalculateNoiseInterferenceW (Ptr<InterferenceHelper::Event> event) const
 {
-  double noiseInterference = m_firstPower;
   NS_ASSERT (m_rxing);
-  for (NiChanges::const_iterator i = m_niChanges.begin () + 1; i != m_niChanges.end (); i++)
-    {
-      if ((event->GetEndTime () == i->GetTime ()) && event->GetRxPowerW () == -i->GetDelta ())
-        {
-          break;
-        }
-      ni->push_back (*i);
-    }
-  ni->insert (ni->begin (), NiChange (event->GetStartTime (), noiseInterference));
-  ni->push_back (NiChange (event->GetEndTime (), 0));
-  return noiseInterference;
+  NS_ASSERT (!m_niChanges.empty () && m_niChanges.front ().GetTime () == event->GetStartTime ());
+  return m_firstPower;
 }
 
 double
@@ -280,64 +282,61 @@ InterferenceHelper::CalculateChunkSuccessRate (double snir, Time duration, WifiM
 }
 
 double
-InterferenceHelper::CalculatePlcpPayloadPer (Ptr<const InterferenceHelper::Event> event, NiChanges *ni) const
+InterferenceHelper::CalculatePlcpPayloadPer (Ptr<const InterferenceHelper::Event> event) const
 {
   NS_LOG_FUNCTION (this);
   double psr = 1.0; /* Packet Success Rate */
-  NiChanges::iterator j = ni->begin ();
-  Time previous = (*j).GetTime ();
-  WifiMode payloadMode = event->GetPayloadMode ();
   WifiPreamble preamble = event->GetPreambleType ();
-  Time plcpHeaderStart = (*j).GetTime () + WifiPhy::GetPlcpPreambleDuration (event->GetTxVector (), preamble); //packet start time + preamble
+  Time plcpHeaderStart = event->GetStartTime () + WifiPhy::GetPlcpPreambleDuration (event->GetTxVector (), preamble); //packet start time + preamble
   Time plcpHsigHeaderStart = plcpHeaderStart + WifiPhy::GetPlcpHeaderDuration (event->GetTxVector (), preamble); //packet start time + preamble + L-SIG
   Time plcpHtTrainingSymbolsStart = plcpHsigHeaderStart + WifiPhy::GetPlcpHtSigHeaderDuration (preamble) + WifiPhy::GetPlcpVhtSigA1Duration (preamble) + WifiPhy::GetPlcpVhtSigA2Duration (preamble); //packet start time + preamble + L-SIG + HT-SIG or VHT-SIG-A (A1 + A2)
   Time plcpPayloadStart = plcpHtTrainingSymbolsStart + WifiPhy::GetPlcpHtTrainingSymbolDuration (preamble, event->GetTxVector ()) + WifiPhy::GetPlcpVhtSigBDuration (preamble); //packet start time + preamble + L-SIG + HT-SIG or VHT-SIG-A (A1 + A2) + (V)HT Training + VHT-SIG-B
-  double noiseInterferenceW = (*j).GetDelta ();
+  WifiMode payloadMode = event->GetPayloadMode ();
   double powerW = event->GetRxPowerW ();
-  j++;
-  while (ni->end () != j)
+  Time end = event->GetEndTime ();
+  /* The first NiChange is the start of the event itself, so the one
+   * preceding the payload start always exists.  Its cumulative power,
+   * minus our own signal, is the noise and interference at the start
+   * of the payload: there is no need to walk the preamble and header.
+   */
+  NiChanges::const_iterator j = std::upper_bound (m_niChanges.begin (), m_niChanges.end (), NiChange (plcpPayloadStart, 0));
+  NS_ASSERT (j != m_niChanges.begin ());
+  double noiseInterferenceW = (j - 1)->GetPower () - powerW;
+  Time previous = plcpPayloadStart;
+  while (j != m_niChanges.end () && j->GetTime () < end)
     {
-      Time current = (*j).GetTime ();
+      Time current = j->GetTime ();
       NS_LOG_DEBUG ("previous= " << previous << ", current=" << current);
       NS_ASSERT (current >= previous);
-      //Case 1: Both previous and current point to the payload
-      if (previous >= plcpPayloadStart)
-        {
-          psr *= CalculateChunkSuccessRate (CalculateSnr (powerW,
-                                                          noiseInterferenceW,
-                                                          event->GetTxVector ().GetChannelWidth ()),
-                                            current - previous,
-                                            payloadMode, event->GetTxVector ());
-
-          NS_LOG_DEBUG ("Both previous and current point to the payload: mode=" << payloadMode << ", psr=" << psr);
-        }
-      //Case 2: previous is before payload and current is in the payload
-      else if (current >= plcpPayloadStart)
-        {
-          psr *= CalculateChunkSuccessRate (CalculateSnr (powerW,
-                                                          noiseInterferenceW,
-                                                          event->GetTxVector ().GetChannelWidth ()),
-                                            current - plcpPayloadStart,
-                                            payloadMode, event->GetTxVector ());
-          NS_LOG_DEBUG ("previous is before payload and current is in the payload: mode=" << payloadMode << ", psr=" << psr);
-        }
-
-      noiseInterferenceW += (*j).GetDelta ();
-      previous = (*j).GetTime ();
+      psr *= CalculateChunkSuccessRate (CalculateSnr (powerW,
+                                                      noiseInterferenceW,
+                                                      event->GetTxVector ().GetChannelWidth ()),
+                                        current - previous,
+                                        payloadMode, event->GetTxVector ());
+      NS_LOG_DEBUG ("mode=" << payloadMode << ", psr=" << psr);
+      noiseInterferenceW = j->GetPower () - powerW;
+      previous = current;
       j++;
     }
+  psr *= CalculateChunkSuccessRate (CalculateSnr (powerW,
+                                                  noiseInterferenceW,
+                                                  event->GetTxVector ().GetChannelWidth ()),
+                                    end - previous,
+                                    payloadMode, event->GetTxVector ());
+  NS_LOG_DEBUG ("mode=" << payloadMode << ", psr=" << psr);
 
   double per = 1 - psr;
   return per;
 }
 
 double
-InterferenceHelper::CalculatePlcpHeaderPer (Ptr<const InterferenceHelper::Event> event, NiChanges *ni) const
+InterferenceHelper::CalculatePlcpHeaderPer (Ptr<const InterferenceHelper::Event> event) const
 {
   NS_LOG_FUNCTION (this);
   double psr = 1.0; /* Packet Success Rate */
-  NiChanges::iterator j = ni->begin ();
-  Time previous = (*j).GetTime ();
+  /* The first NiChange is the start of the event itself. */
+  NiChanges::const_iterator j = m_niChanges.begin () + 1;
+  Time previous = event->GetStartTime ();
   WifiMode payloadMode = event->GetPayloadMode ();
   WifiPreamble preamble = event->GetPreambleType ();
   WifiMode htHeaderMode;
@@ -352,16 +351,19 @@ InterferenceHelper::CalculatePlcpHeaderPer (Ptr<const InterferenceHelper::Event>
       htHeaderMode = WifiPhy::GetVhtPlcpHeaderMode (payloadMode);
     }
   WifiMode headerMode = WifiPhy::GetPlcpHeaderMode (payloadMode, preamble, event->GetTxVector ());
-  Time plcpHeaderStart = (*j).GetTime () + WifiPhy::GetPlcpPreambleDuration (event->GetTxVector (), preamble); //packet start time + preamble
+  Time plcpHeaderStart = event->GetStartTime () + WifiPhy::GetPlcpPreambleDuration (event->GetTxVector (), preamble); //packet start time + preamble
   Time plcpHsigHeaderStart = plcpHeaderStart + WifiPhy::GetPlcpHeaderDuration (event->GetTxVector (), preamble); //packet start time + preamble + L-SIG
   Time plcpHtTrainingSymbolsStart = plcpHsigHeaderStart + WifiPhy::GetPlcpHtSigHeaderDuration (preamble) + WifiPhy::GetPlcpVhtSigA1Duration (preamble) + WifiPhy::GetPlcpVhtSigA2Duration (preamble); //packet start time + preamble + L-SIG + HT-SIG or VHT-SIG-A (A1 + A2)
   Time plcpPayloadStart = plcpHtTrainingSymbolsStart + WifiPhy::GetPlcpHtTrainingSymbolDuration (preamble, event->GetTxVector ()) + WifiPhy::GetPlcpVhtSigBDuration (preamble); //packet start time + preamble + L-SIG + HT-SIG or VHT-SIG-A (A1 + A2) + (V)HT Training + VHT-SIG-B
-  double noiseInterferenceW = (*j).GetDelta ();
+  double noiseInterferenceW = m_firstPower;
   double powerW = event->GetRxPowerW ();
-  j++;
-  while (ni->end () != j)
+  /* Only the changes before the payload start matter here: the last
+   * chunk is closed at the payload start.
+   */
+  while (true)
     {
-      Time current = (*j).GetTime ();
+      bool last = (j == m_niChanges.end () || j->GetTime () >= plcpPayloadStart);
+      Time current = last ? plcpPayloadStart : j->GetTime ();
       NS_LOG_DEBUG ("previous= " << previous << ", current=" << current);
       NS_ASSERT (current >= previous);
       //Case 1: previous and current after playload start: nothing to do
@@ -776,8 +778,12 @@ InterferenceHelper::CalculatePlcpHeaderPer (Ptr<const InterferenceHelper::Event>
             }
         }
 
-      noiseInterferenceW += (*j).GetDelta ();
-      previous = (*j).GetTime ();
+      if (last)
+        {
+          break;
+        }
+      noiseInterferenceW = j->GetPower () - powerW;
+      previous = current;
       j++;
     }
 
@@ -788,8 +794,7 @@ InterferenceHelper::CalculatePlcpHeaderPer (Ptr<const InterferenceHelper::Event>
 struct InterferenceHelper::SnrPer
 InterferenceHelper::CalculatePlcpPayloadSnrPer (Ptr<InterferenceHelper::Event> event)
 {
-  NiChanges ni;
-  double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni);
+  double noiseInterferenceW = CalculateNoiseInterferenceW (event);
   double snr = CalculateSnr (event->GetRxPowerW (),
                              noiseInterferenceW,
                              event->GetTxVector ().GetChannelWidth ());
@@ -797,7 +802,7 @@ InterferenceHelper::CalculatePlcpPayloadSnrPer (Ptr<InterferenceHelper::Event> e
   /* calculate the SNIR at the start of the packet and accumulate
    * all SNIR changes in the snir vector.
    */
-  double per = CalculatePlcpPayloadPer (event, &ni);
+  double per = CalculatePlcpPayloadPer (event);
 
   struct SnrPer snrPer;
   snrPer.snr = snr;
@@ -808,8 +813,7 @@ InterferenceHelper::CalculatePlcpPayloadSnrPer (Ptr<InterferenceHelper::Event> e
 struct InterferenceHelper::SnrPer
 InterferenceHelper::CalculatePlcpHeaderSnrPer (Ptr<InterferenceHelper::Event> event)
 {
-  NiChanges ni;
-  double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni);
+  double noiseInterferenceW = CalculateNoiseInterferenceW (event);
   double snr = CalculateSnr (event->GetRxPowerW (),
                              noiseInterferenceW,
                              event->GetTxVector ().GetChannelWidth ());
@@ -817,7 +821,7 @@ InterferenceHelper::CalculatePlcpHeaderSnrPer (Ptr<InterferenceHelper::Event> ev
   /* calculate the SNIR at the start of the plcp header and accumulate
    * all SNIR changes in the snir vector.
    */
-  double per = CalculatePlcpHeaderPer (event, &ni);
+  double per = CalculatePlcpHeaderPer (event);
 
   struct SnrPer snrPer;
   snrPer.snr = snr;
@@ -842,7 +846,26 @@ InterferenceHelper::GetPosition (Time moment)
 void
 InterferenceHelper::AddNiChangeEvent (NiChange change)
 {
-  m_niChanges.insert (GetPosition (change.GetTime ()), change);
+  NiChanges::iterator i = GetPosition (change.GetTime ());
+  double previousPower = (i == m_niChanges.begin ()) ? m_firstPower : (i - 1)->GetPower ();
+  change.SetPower (previousPower + change.GetDelta ());
+  i = m_niChanges.insert (i, change);
+  //Changes are nearly always appended close to the back, so this is short
+  for (i++; i != m_niChanges.end (); i++)
+    {
+      i->AddPower (change.GetDelta ());
+    }
+}
+
+void
+InterferenceHelper::EvictNiChanges (NiChanges::iterator last)
+{
+  if (last == m_niChanges.begin ())
+    {
+      return;
+    }
+  m_firstPower = (last - 1)->GetPower ();
+  m_niChanges.erase (m_niChanges.begin (), last);
 }
 
 void
@@ -857,6 +880,9 @@ InterferenceHelper::NotifyRxEnd ()
 {
   NS_LOG_FUNCTION (this);
   m_rxing = false;
+  //The changes which happened before now are not needed anymore by
+  //GetEnergyDuration, and no pending reception can refer to them.
+  EvictNiChanges (std::lower_bound (m_niChanges.begin (), m_niChanges.end (), NiChange (Simulator::Now (), 0)));
 }
 
 } //namespace ns3
@@ -22,7 +22,7 @@
 #define INTERFERENCE_HELPER_H
 
 #include <stdint.h>
-#include <vector>
+#include <deque>
 #include <list>
 #include "wifi-mode.h"
 #include "wifi-preamble.h"
@@ -182,6 +182,14 @@ private:
   Ptr<InterferenceHelper::Event> Add (uint32_t size, WifiTxVector txVector,
                                       enum WifiPreamble preamble,
                                       Time duration, double rxPower);
+  /**
+   * Add a signal which cannot be received, such as a transmission on an
+   * adjacent channel, to the interference.
+   *
+   * \param duration the duration of the signal
+   * \param rxPower receive power (W)
+   */
+  void AddForeignSignal (Time duration, double rxPower);
 
   /**
    * Calculate the SNIR at the start of the plcp payload and accumulate
@@ -242,6 +250,26 @@ public:
      * \return the power
      */
     double GetDelta (void) const;
+    /**
+     * Return the total noise and interference power (w) on the medium
+     * right after this change, i.e. the running sum of all the deltas
+     * up to and including this one.
+     *
+     * \return the cumulative power (w)
+     */
+    double GetPower (void) const;
+    /**
+     * Set the cumulative power right after this change.
+     *
+     * \param power the cumulative power (w)
+     */
+    void SetPower (double power);
+    /**
+     * Add the given delta to the cumulative power of this change.
+     *
+     * \param delta the power (w) to add
+     */
+    void AddPower (double delta);
     /**
      * Compare the event time of two NiChange objects (a < o).
      *
@@ -254,11 +282,14 @@ public:
 private:
     Time m_time;
     double m_delta;
+    double m_power;
   };
   /**
-   * typedef for a vector of NiChanges
+   * typedef for a double-ended queue of NiChanges, sorted by time.
+   * Changes are pruned from the front once they are older than the
+   * oldest event which may still be received.
    */
-  typedef std::vector <NiChange> NiChanges;
+  typedef std::deque <NiChange> NiChanges;
   /**
    * typedef for a list of Events
    */
@@ -271,14 +302,14 @@ private:
    */
   void AppendEvent (Ptr<Event> event);
   /**
-   * Calculate noise and interference power in W.
+   * Calculate noise and interference power in W at the start of the
+   * event being received.
    *
    * \param event
-   * \param ni
    *
    * \return noise and interference power
    */
-  double CalculateNoiseInterferenceW (Ptr<Event> event, NiChanges *ni) const;
+  double CalculateNoiseInterferenceW (Ptr<Event> event) const;
   /**
    * Calculate SNR (linear ratio) from the given signal power and noise+interference power.
    * (Mode is not currently used)
@@ -307,36 +338,42 @@ private:
    * multiple chunks (e.g. due to interference from other transmissions).
    *
    * \param event
-   * \param ni
    *
    * \return the error rate of the packet
    */
-  double CalculatePlcpPayloadPer (Ptr<const Event> event, NiChanges *ni) const;
+  double CalculatePlcpPayloadPer (Ptr<const Event> event) const;
   /**
    * Calculate the error rate of the plcp header. The plcp header can be divided into
    * multiple chunks (e.g. due to interference from other transmissions).
    *
    * \param event
-   * \param ni
    *
    * \return the error rate of the packet
    */
-  double CalculatePlcpHeaderPer (Ptr<const Event> event, NiChanges *ni) const;
+  double CalculatePlcpHeaderPer (Ptr<const Event> event) const;
 
   double m_noiseFigure; /**< noise figure (linear) */
   Ptr<ErrorRateModel> m_errorRateModel;
   /// Experimental: needed for energy duration calculation
   NiChanges m_niChanges;
-  double m_firstPower;
+  double m_firstPower; //!< noise and interference power before the first NiChange
   bool m_rxing;
   /// Returns an iterator to the first nichange, which is later than moment
   NiChanges::iterator GetPosition (Time moment);
   /**
-   * Add NiChange to the list at the appropriate position.
+   * Add NiChange to the list at the appropriate position and update the
+   * cumulative power of the changes which follow it.
    *
    * \param change
    */
   void AddNiChangeEvent (NiChange change);
+  /**
+   * Drop all the NiChanges before the given position, folding their
+   * power into m_firstPower.
+   *
+   * \param last the first NiChange to keep
+   */
+  void EvictNiChanges (NiChanges::iterator last);
 };
 
 } //namespace ns3
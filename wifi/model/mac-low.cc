@@ -347,6 +347,59 @@ private:
   ns3::MacLow *m_macLow;
 };
 
+/**
+ * The header of a control frame, written from the bytes of a template.
+ * It is recorded in the packet metadata as the WifiMacHeader it was
+ * serialized from, so that the frame prints and deserializes as any other.
+ */
+class ControlFrameHeader : public Header
+{
+public:
+  /**
+   * Create a header that writes the given bytes.
+   *
+   * \param bytes the serialized WifiMacHeader
+   * \param size the number of bytes
+   */
+  ControlFrameHeader (uint8_t const *bytes, uint32_t size)
+    : m_bytes (bytes),
+      m_size (size)
+  {
+  }
+  virtual TypeId GetInstanceTypeId (void) const
+  {
+    return WifiMacHeader::GetTypeId ();
+  }
+  virtual uint32_t GetSerializedSize (void) const
+  {
+    return m_size;
+  }
+  virtual void Serialize (Buffer::Iterator start) const
+  {
+    start.Write (m_bytes, m_size);
+  }
+  virtual uint32_t Deserialize (Buffer::Iterator start)
+  {
+    NS_FATAL_ERROR ("a control frame is deserialized as a WifiMacHeader");
+    return 0;
+  }
+  virtual void Print (std::ostream &os) const
+  {
+    Buffer buffer;
+    buffer.AddAtStart (m_size);
+    buffer.Begin ().Write (m_bytes, m_size);
+    WifiMacHeader hdr;
+    hdr.Deserialize (buffer.Begin ());
+    hdr.Print (os);
+  }
+private:
+  uint8_t const *m_bytes; //!< the serialized header
+  uint32_t m_size;        //!< the number of bytes
+};
+
+/// The number of control frame templates above which they are all dropped
+static const uint32_t MAX_CONTROL_FRAMES = 256;
+
 
 MacLow::MacLow ()
   : m_normalAckTimeoutEvent (),
@@ -438,6 +491,7 @@ MacLow::DoDispose (void)
   m_mpduAggregator = 0;
   m_sentMpdus = 0;
   m_aggregateQueue = 0;
+  m_controlFrames.clear ();
   m_ampdu = false;
 }
 
@@ -547,6 +601,7 @@ void
 MacLow::SetAddress (Mac48Address ad)
 {
   m_self = ad;
+  m_controlFrames.clear ();
 }
 
 void
@@ -1673,6 +1728,38 @@ MacLow::SendPacket (Ptr<const Packet> packet, WifiTxVector txVector, WifiPreambl
   m_phy->SendPacket (packet, txVector, preamble, packetType, mpduReferenceNumber);
 }
 
+Ptr<Packet>
+MacLow::GetControlFrame (const WifiMacHeader &hdr)
+{
+  NS_ASSERT (hdr.IsRts () || hdr.IsCts () || hdr.IsAck ());
+  uint64_t key = GetMac48AddressKey (hdr.GetAddr1 (), static_cast<uint8_t> (hdr.GetType ()));
+  ControlFrames::iterator it = m_controlFrames.find (key);
+  if (it == m_controlFrames.end ())
+    {
+      if (m_controlFrames.size () >= MAX_CONTROL_FRAMES)
+        {
+          m_controlFrames.clear ();
+        }
+      ControlFrame frame;
+      frame.size = hdr.GetSerializedSize ();
+      NS_ASSERT (frame.size <= sizeof (frame.bytes));
+      Buffer buffer;
+      buffer.AddAtStart (frame.size);
+      hdr.Serialize (buffer.Begin ());
+      buffer.CopyData (frame.bytes, frame.size);
+      it = m_controlFrames.insert (std::make_pair (key, frame)).first;
+    }
+  //the Duration/ID field follows the two bytes of the Frame Control field
+  uint16_t duration = hdr.GetRawDuration ();
+  it->second.bytes[2] = duration & 0xff;
+  it->second.bytes[3] = (duration >> 8) & 0xff;
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (ControlFrameHeader (it->second.bytes, it->second.size));
+  WifiMacTrailer fcs;
+  packet->AddTrailer (fcs);
+  return packet;
+}
+
 void
 MacLow::CtsTimeout (void)
 {
@@ -1836,10 +1923,7 @@ MacLow::SendRtsForPacket (void)
   NotifyCtsTimeoutStartNow (timerDelay);
   m_ctsTimeoutEvent = Simulator::Schedule (timerDelay, &MacLow::CtsTimeout, this);
 
-  Ptr<Packet> packet = Create<Packet> ();
-  packet->AddHeader (rts);
-  WifiMacTrailer fcs;
-  packet->AddTrailer (fcs);
+  Ptr<Packet> packet = GetControlFrame (rts);
 
   ForwardDown (packet, &rts, rtsTxVector,preamble);
 }
@@ -2089,10 +2173,7 @@ MacLow::SendCtsToSelf (void)
 
   cts.SetDuration (duration);
 
-  Ptr<Packet> packet = Create<Packet> ();
-  packet->AddHeader (cts);
-  WifiMacTrailer fcs;
-  packet->AddTrailer (fcs);
+  Ptr<Packet> packet = GetControlFrame (cts);
 
   ForwardDown (packet, &cts, ctsTxVector,preamble);
 
@@ -2127,10 +2208,7 @@ MacLow::SendCtsAfterRts (Mac48Address source, Time duration, WifiTxVector rtsTxV
   NS_ASSERT (duration >= MicroSeconds (0));
   cts.SetDuration (duration);
 
-  Ptr<Packet> packet = Create<Packet> ();
-  packet->AddHeader (cts);
-  WifiMacTrailer fcs;
-  packet->AddTrailer (fcs);
+  Ptr<Packet> packet = GetControlFrame (cts);
 
   SnrTag tag;
   tag.Set (rtsSnr);
@@ -2280,10 +2358,7 @@ MacLow::SendAckAfterData (Mac48Address source, Time duration, WifiMode dataTxMod
   NS_ASSERT (duration >= MicroSeconds (0));
   ack.SetDuration (duration);
 
-  Ptr<Packet> packet = Create<Packet> ();
-  packet->AddHeader (ack);
-  WifiMacTrailer fcs;
-  packet->AddTrailer (fcs);
+  Ptr<Packet> packet = GetControlFrame (ack);
 
   SnrTag tag;
   tag.Set (dataSnr);
@@ -2877,7 +2952,6 @@ MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHeader hdr)
               uint16_t blockAckSize = 0;
               bool aggregated = false;
               int i = 0;
-              Ptr<Packet> aggPacket = newPacket->Copy ();
 
               if (!hdr.IsBlockAckReq ())
                 {
@@ -2887,18 +2961,16 @@ MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHeader hdr)
                       peekedHdr.SetQosAckPolicy (WifiMacHeader::NORMAL_ACK);
                     }
                   currentSequenceNumber = peekedHdr.GetSequenceNumber ();
-                  newPacket->AddHeader (peekedHdr);
-                  WifiMacTrailer fcs;
-                  newPacket->AddTrailer (fcs);
+                  uint32_t mpduSize = packet->GetSize () + peekedHdr.GetSize () + WIFI_MAC_FCS_LENGTH;
 
-                  aggregated = m_mpduAggregator->Aggregate (newPacket, currentAggregatedPacket);
+                  aggregated = m_mpduAggregator->AggregateSize (mpduSize, currentAggregatedPacket);
 
                   if (aggregated)
                     {
-                      NS_LOG_DEBUG ("Adding packet with Sequence number " << peekedHdr.GetSequenceNumber () << " to A-MPDU, packet size = " << newPacket->GetSize () << ", A-MPDU size = " << currentAggregatedPacket->GetSize ());
+                      NS_LOG_DEBUG ("Adding packet with Sequence number " << peekedHdr.GetSequenceNumber () << " to A-MPDU, packet size = " << mpduSize << ", A-MPDU size = " << currentAggregatedPacket->GetSize ());
                       i++;
                       m_sentMpdus++;
-                      m_aggregateQueue->Enqueue (aggPacket, peekedHdr);
+                      m_aggregateQueue->Enqueue (packet, peekedHdr);
                     }
                 }
               else if (hdr.IsBlockAckReq ())
@@ -2956,16 +3028,11 @@ MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHeader hdr)
                       peekedHdr.SetQosAckPolicy (WifiMacHeader::BLOCK_ACK);
                     }
 
-                  newPacket = peekedPacket->Copy ();
-                  Ptr<Packet> aggPacket = newPacket->Copy ();
-
-                  newPacket->AddHeader (peekedHdr);
-                  WifiMacTrailer fcs;
-                  newPacket->AddTrailer (fcs);
-                  aggregated = m_mpduAggregator->Aggregate (newPacket, currentAggregatedPacket);
+                  uint32_t mpduSize = peekedPacket->GetSize () + peekedHdr.GetSize () + WIFI_MAC_FCS_LENGTH;
+                  aggregated = m_mpduAggregator->AggregateSize (mpduSize, currentAggregatedPacket);
                   if (aggregated)
                     {
-                      m_aggregateQueue->Enqueue (aggPacket, peekedHdr);
+                      m_aggregateQueue->Enqueue (peekedPacket, peekedHdr);
                       if (i == 1 && hdr.IsQosData ())
                         {
                           if (!m_txParams.MustSendRts ())
@@ -2977,7 +3044,7 @@ MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHeader hdr)
                               InsertInTxQueue (packet, hdr, tstamp);
                             }
                         }
-                      NS_LOG_DEBUG ("Adding packet with Sequence number " << peekedHdr.GetSequenceNumber () << " to A-MPDU, packet size = " << newPacket->GetSize () << ", A-MPDU size = " << currentAggregatedPacket->GetSize ());
+                      NS_LOG_DEBUG ("Adding packet with Sequence number " << peekedHdr.GetSequenceNumber () << " to A-MPDU, packet size = " << mpduSize << ", A-MPDU size = " << currentAggregatedPacket->GetSize ());
                       i++;
                       isAmpdu = true;
                       m_sentMpdus++;
@@ -2997,7 +3064,6 @@ MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHeader hdr)
                         {
                           queue->Remove (peekedPacket);
                         }
-                      newPacket = 0;
                     }
                   else
                     {
@@ -3057,14 +3123,8 @@ MacLow::AggregateToAmpdu (Ptr<const Packet> packet, const WifiMacHeader hdr)
                 {
                   if (hdr.IsBlockAckReq ())
                     {
-                      newPacket = packet->Copy ();
-                      peekedHdr = hdr;
-                      Ptr<Packet> aggPacket = newPacket->Copy ();
-                      m_aggregateQueue->Enqueue (aggPacket, peekedHdr);
-                      newPacket->AddHeader (peekedHdr);
-                      WifiMacTrailer fcs;
-                      newPacket->AddTrailer (fcs);
-                      m_mpduAggregator->Aggregate (newPacket, currentAggregatedPacket);
+                      m_aggregateQueue->Enqueue (packet, hdr);
+                      m_mpduAggregator->AggregateSize (packet->GetSize () + hdr.GetSize () + WIFI_MAC_FCS_LENGTH, currentAggregatedPacket);
                     }
                   if (qosPolicy == 0)
                     {
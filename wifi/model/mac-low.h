@@ -39,6 +39,8 @@
 #include "ns3/event-id.h"
 #include "ns3/packet.h"
 #include "ns3/nstime.h"
+#include "ns3/sgi-hashmap.h"
+#include "mac48-address-key.h"
 #include "qos-utils.h"
 #include "block-ack-cache.h"
 #include "wifi-tx-vector.h"
@@ -46,6 +48,7 @@
 #include "msdu-aggregator.h"
 
 class TwoLevelAggregationTest;
+class MacLowControlFrameTest;
 
 namespace ns3 {
 
@@ -487,6 +490,7 @@ class MacLow : public Object
 public:
   // Allow test cases to access private members
   friend class ::TwoLevelAggregationTest;
+  friend class ::MacLowControlFrameTest;
   /**
    * typedef for a callback for MacLowRx
    */
@@ -895,6 +899,19 @@ private:
    * \param mpduReferenceNumber
    */
   void SendPacket (Ptr<const Packet> packet, WifiTxVector txVector, WifiPreamble preamble, uint8_t packetType, uint32_t mpduReferenceNumber);
+  /**
+   * Return an RTS, CTS or ACK frame, made of the given header and of the
+   * FCS. The header of each type of frame sent to each station is
+   * serialized once into a template; the next frames of the same type to
+   * the same station only patch the Duration/ID field of the template in
+   * place and write it as is. The templates are all dropped when there are
+   * too many of them.
+   *
+   * \param hdr the header of the control frame
+   *
+   * \return the control frame
+   */
+  Ptr<Packet> GetControlFrame (const WifiMacHeader &hdr);
   /**
    * Return a TXVECTOR for the RTS frame given the destination.
    * The function consults WifiRemoteStationManager, which controls the rate
@@ -1374,6 +1391,20 @@ private:
   bool m_receivedAtLeastOneMpdu;      //!< Flag whether an MPDU has already been successfully received while receiving an A-MPDU
   std::vector<Item> m_txPackets;      //!< Contain temporary items to be sent with the next A-MPDU transmission, once RTS/CTS exchange has succeeded. It is not used in other cases.
   uint32_t m_mpduReferenceNumber;       //!< A-MPDU reference number to identify all subframes belonging to the same A-MPDU
+
+  /**
+   * The serialized header of the control frames of a type sent to a station.
+   */
+  struct ControlFrame
+  {
+    uint8_t bytes[16];  //!< the header, large enough for an RTS
+    uint32_t size;      //!< the size of the header
+  };
+  /**
+   * typedef for a hash map between the keys and the control frames
+   */
+  typedef sgi::hash_map<uint64_t, ControlFrame, Mac48AddressKeyHash> ControlFrames;
+  ControlFrames m_controlFrames;        //!< Templates of the control frame headers
 };
 
 } //namespace ns3
@@ -202,12 +202,12 @@ MacRxMiddle::Lookup (const WifiMacHeader *hdr)
       && !hdr->GetAddr2 ().IsGroup ())
     {
       /* only for qos data non-broadcast frames */
-      originator = m_qosOriginatorStatus[std::make_pair (source, hdr->GetQosTid ())];
-      if (originator == 0)
+      OriginatorRxStatus *&status = m_qosOriginatorStatus[GetMac48AddressKey (source, hdr->GetQosTid ())];
+      if (status == 0)
         {
-          originator = new OriginatorRxStatus ();
-          m_qosOriginatorStatus[std::make_pair (source, hdr->GetQosTid ())] = originator;
+          status = new OriginatorRxStatus ();
         }
+      originator = status;
     }
   else
     {
@@ -216,12 +216,12 @@ MacRxMiddle::Lookup (const WifiMacHeader *hdr)
        * - nqos data frames
        * see section 7.1.3.4.1
        */
-      originator = m_originatorStatus[source];
-      if (originator == 0)
+      OriginatorRxStatus *&status = m_originatorStatus[GetMac48AddressKey (source, 0)];
+      if (status == 0)
         {
-          originator = new OriginatorRxStatus ();
-          m_originatorStatus[source] = originator;
+          status = new OriginatorRxStatus ();
         }
+      originator = status;
     }
   return originator;
 }
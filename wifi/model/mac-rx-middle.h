@@ -21,11 +21,11 @@
 #ifndef MAC_RX_MIDDLE_H
 #define MAC_RX_MIDDLE_H
 
-#include <map>
-#include <utility>
 #include "ns3/callback.h"
 #include "ns3/mac48-address.h"
 #include "ns3/packet.h"
+#include "ns3/sgi-hashmap.h"
+#include "mac48-address-key.h"
 
 namespace ns3 {
 
@@ -100,21 +100,21 @@ private:
                                OriginatorRxStatus *originator);
 
   /**
-   * typedef for a map between address and OriginatorRxStatus
+   * typedef for a hash map between address and OriginatorRxStatus
    */
-  typedef std::map <Mac48Address, OriginatorRxStatus *, std::less<Mac48Address> > Originators;
+  typedef sgi::hash_map<uint64_t, OriginatorRxStatus *, Mac48AddressKeyHash> Originators;
   /**
-   * typedef for a map between address, OriginatorRxStatus, and Traffic ID
+   * typedef for a hash map between address, OriginatorRxStatus, and Traffic ID
    */
-  typedef std::map <std::pair<Mac48Address, uint8_t>, OriginatorRxStatus *, std::less<std::pair<Mac48Address,uint8_t> > > QosOriginators;
+  typedef sgi::hash_map<uint64_t, OriginatorRxStatus *, Mac48AddressKeyHash> QosOriginators;
   /**
    * typedef for an interator for Originators
    */
-  typedef std::map <Mac48Address, OriginatorRxStatus *, std::less<Mac48Address> >::iterator OriginatorsI;
+  typedef Originators::iterator OriginatorsI;
   /**
    * typedef for an interator for QosOriginators
    */
-  typedef std::map <std::pair<Mac48Address, uint8_t>, OriginatorRxStatus *, std::less<std::pair<Mac48Address,uint8_t> > >::iterator QosOriginatorsI;
+  typedef QosOriginators::iterator QosOriginatorsI;
 
   Originators m_originatorStatus;
   QosOriginators m_qosOriginatorStatus;
@@ -0,0 +1,55 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MAC48_ADDRESS_KEY_H
+#define MAC48_ADDRESS_KEY_H
+
+#include <stdint.h>
+#include <cstddef>
+#include "ns3/mac48-address.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ * Build the key of an address and a one-byte qualifier, such as a TID
+ * or a frame type, to index the per-station tables of the MAC.
+ *
+ * \param address the address
+ * \param qualifier the qualifier
+ * \returns the six bytes of the address followed by the qualifier
+ */
+uint64_t GetMac48AddressKey (Mac48Address address, uint8_t qualifier);
+
+/**
+ * \ingroup wifi
+ * \brief Hash function class for the keys built by GetMac48AddressKey.
+ *
+ * The bytes of an address are not evenly distributed, so the key is
+ * mixed before being used as a hash.
+ */
+struct Mac48AddressKeyHash
+{
+  /**
+   * \param key the key
+   * \returns the hash of the key
+   */
+  size_t operator () (uint64_t key) const;
+};
+
+} // namespace ns3
+
+#endif /* MAC48_ADDRESS_KEY_H */
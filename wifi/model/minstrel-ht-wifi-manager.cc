@@ -0,0 +1,746 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "minstrel-ht-wifi-manager.h"
+#include "wifi-phy.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/assert.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MinstrelHtWifiManager");
+
+/**
+ * \brief hold per-remote-station state for Minstrel-HT Wifi manager.
+ *
+ * This struct extends from WifiRemoteStation struct to hold additional
+ * information required by the Minstrel-HT Wifi manager. The rates are
+ * the indexes of the table, which holds the rates of all the groups
+ * supported by the station, the lowest rate of the most robust group
+ * first.
+ */
+struct MinstrelHtWifiRemoteStation : public WifiRemoteStation
+{
+  Time m_nextStatsUpdate;          ///< 10 times every second
+  const SampleRate *m_sampleTable; ///< the sample table shared by the stations with the same number of rates
+  uint32_t m_col, m_index;         ///< current position in the sample table
+  uint32_t m_maxTpRate;            ///< the current throughput rate
+  uint32_t m_maxTpRate2;           ///< second highest throughput rate
+  uint32_t m_maxProbRate;          ///< rate with highest prob of success
+  uint32_t m_packetCount;          ///< total number of frames or A-MPDUs as of now
+  uint32_t m_sampleCount;          ///< how many of them were sampled so far
+  uint32_t m_sampleRate;           ///< current sample rate
+  uint32_t m_shortRetry;           ///< short retries such as control packts
+  uint32_t m_longRetry;            ///< long retries such as data packets
+  uint32_t m_txrate;               ///< current transmit rate
+  uint32_t m_nSuccess;             ///< MPDUs acknowledged since the last transmission
+  uint32_t m_nFailed;              ///< MPDUs lost since the last transmission
+  bool m_isSampling;               ///< a flag to indicate we are currently sampling
+  bool m_sampleRateSlower;         ///< a flag to indicate sample rate is slower
+  bool m_initialized;              ///< for initializing tables
+  MinstrelRate m_table;            ///< statistics of the rates of the station
+  std::vector<uint16_t> m_rates;   ///< index of each rate in the rates of all the groups
+};
+
+NS_OBJECT_ENSURE_REGISTERED (MinstrelHtWifiManager);
+
+TypeId
+MinstrelHtWifiManager::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MinstrelHtWifiManager")
+    .SetParent<WifiRemoteStationManager> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<MinstrelHtWifiManager> ()
+    .AddAttribute ("UpdateStatistics",
+                   "The interval between updating statistics table ",
+                   TimeValue (Seconds (0.1)),
+                   MakeTimeAccessor (&MinstrelHtWifiManager::m_updateStats),
+                   MakeTimeChecker ())
+    .AddAttribute ("LookAroundRate",
+                   "the percentage to try other rates",
+                   DoubleValue (10),
+                   MakeDoubleAccessor (&MinstrelHtWifiManager::m_lookAroundRate),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("EWMA",
+                   "EWMA level",
+                   DoubleValue (75),
+                   MakeDoubleAccessor (&MinstrelHtWifiManager::m_ewmaLevel),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("SampleColumn",
+                   "The number of columns used for sampling",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&MinstrelHtWifiManager::m_sampleCol),
+                   MakeUintegerChecker <uint32_t> (1))
+    .AddAttribute ("PacketLength",
+                   "The packet length used for calculating mode TxTime",
+                   UintegerValue (1200),
+                   MakeUintegerAccessor (&MinstrelHtWifiManager::m_pktLen),
+                   MakeUintegerChecker <uint32_t> ())
+  ;
+  return tid;
+}
+
+MinstrelHtWifiManager::MinstrelHtWifiManager ()
+{
+  m_uniformRandomVariable = CreateObject<UniformRandomVariable> ();
+}
+
+MinstrelHtWifiManager::~MinstrelHtWifiManager ()
+{
+}
+
+int64_t
+MinstrelHtWifiManager::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_uniformRandomVariable->SetStream (stream);
+  return 1;
+}
+
+bool
+MinstrelHtWifiManager::IsValidVhtMcs (WifiMode mcs, uint32_t channelWidth, uint8_t nss)
+{
+  //the combinations for which the number of data bits per symbol is not
+  //an integer are not allowed
+  switch (channelWidth)
+    {
+    case 20:
+      return mcs.GetMcsValue () != 9 || nss == 3 || nss == 6;
+    case 80:
+      return mcs.GetMcsValue () != 6 || (nss != 3 && nss != 7);
+    case 160:
+      return mcs.GetMcsValue () != 9 || nss != 3;
+    default:
+      return true;
+    }
+}
+
+void
+MinstrelHtWifiManager::AddGroup (McsGroup group, const WifiModeList &modes)
+{
+  Ptr<WifiPhy> phy = GetPhy ();
+  WifiPreamble preamble = WIFI_PREAMBLE_LONG;
+  if (group.modClass == WIFI_MOD_CLASS_HT)
+    {
+      preamble = WIFI_PREAMBLE_HT_MF;
+    }
+  else if (group.modClass == WIFI_MOD_CLASS_VHT)
+    {
+      preamble = WIFI_PREAMBLE_VHT;
+    }
+  m_groups.push_back (group);
+  for (WifiModeListIterator i = modes.begin (); i != modes.end (); i++)
+    {
+      if (group.modClass == WIFI_MOD_CLASS_VHT && !IsValidVhtMcs (*i, group.channelWidth, group.nss))
+        {
+          continue;
+        }
+      McsGroupRate rate;
+      rate.mode = *i;
+      rate.group = m_groups.size () - 1;
+      WifiTxVector txVector (*i, 0, 0, group.shortGuardInterval, group.nss, 0, group.channelWidth, false, false);
+      rate.txTime = phy->CalculateTxDuration (m_pktLen, txVector, preamble, phy->GetFrequency (), 0, 0);
+      NS_LOG_DEBUG ("group " << rate.group << " nss=" << (uint32_t)group.nss << " width=" << group.channelWidth <<
+                    " sgi=" << group.shortGuardInterval << " " << *i << " txTime=" << rate.txTime);
+      m_rates.push_back (rate);
+    }
+}
+
+void
+MinstrelHtWifiManager::BuildGroups (void)
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<WifiPhy> phy = GetPhy ();
+
+  //the legacy rates, for the stations which do not support HT
+  WifiModeList legacy;
+  for (uint32_t i = 0; i < phy->GetNModes (); i++)
+    {
+      legacy.push_back (phy->GetMode (i));
+    }
+  McsGroup group;
+  group.nss = 1;
+  group.channelWidth = phy->GetChannelWidth ();
+  if (group.channelWidth > 20 && group.channelWidth != 22)
+    {
+      group.channelWidth = 20;
+    }
+  group.shortGuardInterval = false;
+  group.modClass = WIFI_MOD_CLASS_UNKNOWN;
+  AddGroup (group, legacy);
+
+  if (!HasHtSupported () && !HasVhtSupported ())
+    {
+      return;
+    }
+  WifiModeList ht, vht;
+  for (uint32_t i = 0; i < phy->GetNMcs (); i++)
+    {
+      WifiMode mcs = phy->GetMcs (i);
+      if (mcs.GetModulationClass () == WIFI_MOD_CLASS_HT)
+        {
+          ht.push_back (mcs);
+        }
+      else if (mcs.GetModulationClass () == WIFI_MOD_CLASS_VHT && HasVhtSupported ())
+        {
+          vht.push_back (mcs);
+        }
+    }
+  //the most robust groups first
+  uint32_t maxNss = phy->GetNumberOfTransmitAntennas ();
+  uint32_t maxSgi = phy->GetGuardInterval () ? 1 : 0;
+  for (uint32_t vhtGroups = 0; vhtGroups < 2; vhtGroups++)
+    {
+      const WifiModeList &modes = vhtGroups ? vht : ht;
+      uint32_t maxWidth = vhtGroups ? phy->GetChannelWidth () : std::min<uint32_t> (phy->GetChannelWidth (), 40);
+      group.modClass = vhtGroups ? WIFI_MOD_CLASS_VHT : WIFI_MOD_CLASS_HT;
+      if (modes.empty ())
+        {
+          continue;
+        }
+      for (uint32_t nss = 1; nss <= maxNss; nss++)
+        {
+          for (uint32_t width = 20; width <= maxWidth; width *= 2)
+            {
+              for (uint32_t sgi = 0; sgi <= maxSgi; sgi++)
+                {
+                  group.nss = nss;
+                  group.channelWidth = width;
+                  group.shortGuardInterval = sgi;
+                  AddGroup (group, modes);
+                }
+            }
+        }
+    }
+}
+
+const MinstrelHtWifiManager::McsGroupRate &
+MinstrelHtWifiManager::GetGroupRate (MinstrelHtWifiRemoteStation *station, uint32_t rate) const
+{
+  NS_ASSERT (rate < station->m_rates.size ());
+  return m_rates[station->m_rates[rate]];
+}
+
+const SampleRate *
+MinstrelHtWifiManager::GetSampleTable (uint32_t nRates)
+{
+  std::map<uint32_t, SampleRate>::iterator it = m_sampleTables.find (nRates);
+  if (it != m_sampleTables.end ())
+    {
+      return &it->second;
+    }
+  //each column is a random permutation of the rates
+  SampleRate &table = m_sampleTables[nRates];
+  table.assign (nRates, std::vector<uint32_t> (m_sampleCol));
+  for (uint32_t col = 0; col < m_sampleCol; col++)
+    {
+      for (uint32_t i = 0; i < nRates; i++)
+        {
+          table[i][col] = i;
+        }
+      for (uint32_t i = nRates - 1; i > 0; i--)
+        {
+          uint32_t j = m_uniformRandomVariable->GetInteger (0, i);
+          std::swap (table[i][col], table[j][col]);
+        }
+    }
+  return &table;
+}
+
+WifiRemoteStation *
+MinstrelHtWifiManager::DoCreateStation (void) const
+{
+  MinstrelHtWifiRemoteStation *station = new MinstrelHtWifiRemoteStation ();
+
+  station->m_nextStatsUpdate = Simulator::Now () + m_updateStats;
+  station->m_sampleTable = 0;
+  station->m_col = 0;
+  station->m_index = 0;
+  station->m_maxTpRate = 0;
+  station->m_maxTpRate2 = 0;
+  station->m_maxProbRate = 0;
+  station->m_packetCount = 0;
+  station->m_sampleCount = 0;
+  station->m_sampleRate = 0;
+  station->m_shortRetry = 0;
+  station->m_longRetry = 0;
+  station->m_txrate = 0;
+  station->m_nSuccess = 0;
+  station->m_nFailed = 0;
+  station->m_isSampling = false;
+  station->m_sampleRateSlower = false;
+  station->m_initialized = false;
+
+  return station;
+}
+
+void
+MinstrelHtWifiManager::CheckInit (MinstrelHtWifiRemoteStation *station)
+{
+  if (station->m_initialized)
+    {
+      return;
+    }
+  //as in Minstrel, the table is initialized late, once the rates
+  //supported by the station are known
+  if (m_groups.empty ())
+    {
+      BuildGroups ();
+    }
+  //every station supports the default MCS
+  bool ht = (HasHtSupported () || HasVhtSupported ()) && GetNMcsSupported (station) > 1;
+  WifiModulationClass modClass = WIFI_MOD_CLASS_UNKNOWN;
+  if (ht)
+    {
+      modClass = WIFI_MOD_CLASS_HT;
+      for (uint32_t i = 0; i < GetNMcsSupported (station); i++)
+        {
+          if (GetMcsSupported (station, i).GetModulationClass () == WIFI_MOD_CLASS_VHT && HasVhtSupported ())
+            {
+              modClass = WIFI_MOD_CLASS_VHT;
+            }
+        }
+    }
+  uint32_t maxNss = std::min (GetNumberOfTransmitAntennas (), GetNumberOfReceiveAntennas (station));
+  uint32_t maxWidth = std::min (GetPhy ()->GetChannelWidth (), GetChannelWidth (station));
+  bool sgi = GetShortGuardInterval (station) && GetPhy ()->GetGuardInterval ();
+
+  std::vector<uint16_t> rates;
+  for (uint32_t i = 0; i < m_rates.size (); i++)
+    {
+      const McsGroup &group = m_groups[m_rates[i].group];
+      if (group.modClass != modClass || group.nss > maxNss
+          || group.channelWidth > maxWidth || (group.shortGuardInterval && !sgi))
+        {
+          continue;
+        }
+      uint32_t n = ht ? GetNMcsSupported (station) : GetNSupported (station);
+      for (uint32_t j = 0; j < n; j++)
+        {
+          if ((ht ? GetMcsSupported (station, j) : GetSupported (station, j)) == m_rates[i].mode)
+            {
+              rates.push_back (i);
+              break;
+            }
+        }
+    }
+  if (rates.size () > 1)
+    {
+      station->m_rates.swap (rates);
+      station->m_table.Resize (station->m_rates.size ());
+      station->m_sampleTable = GetSampleTable (station->m_rates.size ());
+      station->m_col = station->m_index = 0;
+      RateInit (station);
+      station->m_initialized = true;
+    }
+}
+
+void
+MinstrelHtWifiManager::DoReportRxOk (WifiRemoteStation *st,
+                                     double rxSnr, WifiMode txMode)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MinstrelHtWifiManager::DoReportRtsFailed (WifiRemoteStation *st)
+{
+  MinstrelHtWifiRemoteStation *station = (MinstrelHtWifiRemoteStation *)st;
+  NS_LOG_DEBUG ("DoReportRtsFailed m_txrate=" << station->m_txrate);
+
+  station->m_shortRetry++;
+}
+
+void
+MinstrelHtWifiManager::DoReportRtsOk (WifiRemoteStation *st, double ctsSnr, WifiMode ctsMode, double rtsSnr)
+{
+  NS_LOG_DEBUG ("self=" << st << " rts ok");
+}
+
+void
+MinstrelHtWifiManager::DoReportFinalRtsFailed (WifiRemoteStation *st)
+{
+  MinstrelHtWifiRemoteStation *station = (MinstrelHtWifiRemoteStation *)st;
+  UpdateRetry (station);
+}
+
+void
+MinstrelHtWifiManager::DoReportDataFailed (WifiRemoteStation *st)
+{
+  MinstrelHtWifiRemoteStation *station = (MinstrelHtWifiRemoteStation *)st;
+  CheckInit (station);
+  if (!station->m_initialized)
+    {
+      return;
+    }
+  //the MPDUs of an A-MPDU are reported one by one, the retry chain
+  //advances at the next transmission
+  station->m_table.numRateAttempt[station->m_txrate]++;
+  station->m_nFailed++;
+}
+
+void
+MinstrelHtWifiManager::DoReportDataOk (WifiRemoteStation *st,
+                                       double ackSnr, WifiMode ackMode, double dataSnr)
+{
+  NS_LOG_FUNCTION (st << ackSnr << ackMode << dataSnr);
+  MinstrelHtWifiRemoteStation *station = (MinstrelHtWifiRemoteStation *)st;
+  CheckInit (station);
+  if (!station->m_initialized)
+    {
+      return;
+    }
+  station->m_table.numRateAttempt[station->m_txrate]++;
+  station->m_table.numRateSuccess[station->m_txrate]++;
+  station->m_nSuccess++;
+}
+
+void
+MinstrelHtWifiManager::DoReportFinalDataFailed (WifiRemoteStation *st)
+{
+  NS_LOG_FUNCTION (st);
+  MinstrelHtWifiRemoteStation *station = (MinstrelHtWifiRemoteStation *)st;
+  CheckInit (station);
+  if (!station->m_initialized)
+    {
+      return;
+    }
+  UpdateTxStatus (station);
+
+  station->m_isSampling = false;
+  station->m_sampleRateSlower = false;
+  UpdateRetry (station);
+  station->m_txrate = FindRate (station);
+}
+
+void
+MinstrelHtWifiManager::UpdateTxStatus (MinstrelHtWifiRemoteStation *station)
+{
+  if (station->m_nSuccess > 0)
+    {
+      //the frame, or at least one of the MPDUs of the A-MPDU, got through
+      NS_LOG_DEBUG ("Transmission at rate " << station->m_txrate << " ok: " << station->m_nSuccess <<
+                    " MPDUs acknowledged, " << station->m_nFailed << " lost");
+      station->m_isSampling = false;
+      station->m_sampleRateSlower = false;
+      UpdateRetry (station);
+      station->m_packetCount++;
+      station->m_txrate = FindRate (station);
+    }
+  else if (station->m_nFailed > 0)
+    {
+      station->m_longRetry++;
+      station->m_txrate = GetRetryRate (station);
+      NS_LOG_DEBUG ("Transmission failed, longRetry=" << station->m_longRetry << " next rate " << station->m_txrate);
+    }
+  station->m_nSuccess = 0;
+  station->m_nFailed = 0;
+}
+
+void
+MinstrelHtWifiManager::GetChain (MinstrelHtWifiRemoteStation *station, uint32_t *first, uint32_t *second) const
+{
+  /**
+   * Try |         LOOKAROUND RATE              | NORMAL RATE
+   *     | sample slower    | sample faster     |
+   * --------------------------------------------------------------
+   *  1  | Best throughput  | Sample rate       | Best throughput
+   *  2  | Sample rate      | Best throughput   | Next best throughput
+   *  3  | Best probability | Best probability  | Best probability
+   *  4  | Lowest rate      | Lowest rate       | Lowest rate
+   */
+  if (!station->m_isSampling)
+    {
+      *first = station->m_maxTpRate;
+      *second = station->m_maxTpRate2;
+    }
+  else if (station->m_sampleRateSlower)
+    {
+      *first = station->m_maxTpRate;
+      *second = station->m_sampleRate;
+    }
+  else
+    {
+      *first = station->m_sampleRate;
+      *second = station->m_maxTpRate;
+    }
+}
+
+uint32_t
+MinstrelHtWifiManager::GetRetries (MinstrelHtWifiRemoteStation *station, uint32_t rate) const
+{
+  //a sample rate is tried once: an A-MPDU sent at a rate which does not
+  //work wastes much more airtime than a single frame
+  if (station->m_isSampling && rate == station->m_sampleRate)
+    {
+      return 1;
+    }
+  return station->m_table.adjustedRetryCount[rate];
+}
+
+uint32_t
+MinstrelHtWifiManager::GetRetryRate (MinstrelHtWifiRemoteStation *station)
+{
+  uint32_t first, second;
+  GetChain (station, &first, &second);
+  uint32_t retries = GetRetries (station, first);
+  if (station->m_longRetry < retries)
+    {
+      return first;
+    }
+  retries += GetRetries (station, second);
+  if (station->m_longRetry <= retries)
+    {
+      return second;
+    }
+  retries += GetRetries (station, station->m_maxProbRate);
+  if (station->m_longRetry <= retries)
+    {
+      return station->m_maxProbRate;
+    }
+  return 0;
+}
+
+void
+MinstrelHtWifiManager::UpdateRetry (MinstrelHtWifiRemoteStation *station)
+{
+  station->m_shortRetry = 0;
+  station->m_longRetry = 0;
+}
+
+WifiTxVector
+MinstrelHtWifiManager::DoGetDataTxVector (WifiRemoteStation *st,
+                                          uint32_t size)
+{
+  MinstrelHtWifiRemoteStation *station = (MinstrelHtWifiRemoteStation *)st;
+  if (!station->m_initialized)
+    {
+      CheckInit (station);
+      if (!station->m_initialized)
+        {
+          WifiTxVector txVector = DoGetRtsTxVector (station);
+          txVector.SetRetries (GetLongRetryCount (station));
+          return txVector;
+        }
+      //start the rate at half way
+      station->m_txrate = station->m_rates.size () / 2;
+    }
+  UpdateTxStatus (station);
+  UpdateStats (station);
+  const McsGroupRate &rate = GetGroupRate (station, station->m_txrate);
+  const McsGroup &group = m_groups[rate.group];
+  return WifiTxVector (rate.mode, GetDefaultTxPowerLevel (), GetLongRetryCount (station), group.shortGuardInterval,
+                       group.nss, 0, group.channelWidth, GetAggregation (station), false);
+}
+
+WifiTxVector
+MinstrelHtWifiManager::DoGetRtsTxVector (WifiRemoteStation *st)
+{
+  MinstrelHtWifiRemoteStation *station = (MinstrelHtWifiRemoteStation *)st;
+  NS_LOG_DEBUG ("DoGetRtsMode m_txrate=" << station->m_txrate);
+  uint32_t channelWidth = GetChannelWidth (station);
+  if (channelWidth > 20 && channelWidth != 22)
+    {
+      //the control frames are sent at a legacy rate
+      channelWidth = 20;
+    }
+  return WifiTxVector (GetSupported (station, 0), GetDefaultTxPowerLevel (), GetShortRetryCount (station), false, 1, 0, channelWidth, GetAggregation (station), false);
+}
+
+bool
+MinstrelHtWifiManager::DoNeedDataRetransmission (WifiRemoteStation *st, Ptr<const Packet> packet, bool normally)
+{
+  MinstrelHtWifiRemoteStation *station = (MinstrelHtWifiRemoteStation *)st;
+
+  CheckInit (station);
+  if (!station->m_initialized)
+    {
+      return normally;
+    }
+  UpdateTxStatus (station);
+
+  uint32_t first, second;
+  GetChain (station, &first, &second);
+  return station->m_longRetry <= GetRetries (station, first) + GetRetries (station, second)
+         + GetRetries (station, station->m_maxProbRate) + GetRetries (station, 0);
+}
+
+bool
+MinstrelHtWifiManager::IsLowLatency (void) const
+{
+  return true;
+}
+
+uint32_t
+MinstrelHtWifiManager::GetNextSample (MinstrelHtWifiRemoteStation *station)
+{
+  uint32_t rate = (*station->m_sampleTable)[station->m_index][station->m_col];
+  station->m_index++;
+  if (station->m_index >= station->m_rates.size ())
+    {
+      station->m_index = 0;
+      station->m_col++;
+      if (station->m_col >= m_sampleCol)
+        {
+          station->m_col = 0;
+        }
+    }
+  return rate;
+}
+
+uint32_t
+MinstrelHtWifiManager::FindRate (MinstrelHtWifiRemoteStation *station)
+{
+  NS_LOG_FUNCTION (this << station);
+
+  if ((station->m_sampleCount + station->m_packetCount) == 0)
+    {
+      return 0;
+    }
+
+  //for determining when to try a sample rate
+  int coinFlip = m_uniformRandomVariable->GetInteger (0, 100) % 2;
+
+  /**
+   * if we are below the target of look around rate percentage, look around
+   * note: do it randomly by flipping a coin instead sampling
+   * all at once until it reaches the look around rate
+   */
+  if ((((100 * station->m_sampleCount) / (station->m_sampleCount + station->m_packetCount)) < m_lookAroundRate)
+      && (coinFlip == 1))
+    {
+      uint32_t idx = GetNextSample (station);
+      const std::vector<Time> &txTime = station->m_table.perfectTxTime;
+
+      /**
+       * Do not sample the current rates, nor the rates slower than the
+       * rate with the highest probability of success: with the groups
+       * of MCSs, many rates are much slower than the best ones, and
+       * would be sampled for nothing.
+       */
+      if (idx != station->m_maxTpRate && idx != station->m_txrate
+          && txTime[idx] <= txTime[station->m_maxProbRate])
+        {
+          station->m_sampleCount++;
+          station->m_isSampling = true;
+
+          //bookeeping for resetting stuff
+          if (station->m_packetCount >= 10000)
+            {
+              station->m_sampleCount = 0;
+              station->m_packetCount = 0;
+            }
+
+          station->m_sampleRate = idx;
+
+          //a rate slower than the current best rate is only sampled if the
+          //best rate fails
+          station->m_sampleRateSlower = txTime[idx] > txTime[station->m_maxTpRate];
+          if (!station->m_sampleRateSlower)
+            {
+              NS_LOG_DEBUG ("Using look around rate " << idx << " (" << GetGroupRate (station, idx).mode << ")");
+              return idx;
+            }
+        }
+    }
+
+  NS_LOG_DEBUG ("Continue using the maximum throughput rate: " << station->m_maxTpRate <<
+                " (" << GetGroupRate (station, station->m_maxTpRate).mode << ")");
+  return station->m_maxTpRate;
+}
+
+void
+MinstrelHtWifiManager::UpdateStats (MinstrelHtWifiRemoteStation *station)
+{
+  if (Simulator::Now () < station->m_nextStatsUpdate)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  station->m_nextStatsUpdate = Simulator::Now () + m_updateStats;
+
+  station->m_table.UpdateStats (m_ewmaLevel);
+  station->m_table.FindBestRates (&station->m_maxTpRate, &station->m_maxTpRate2, &station->m_maxProbRate);
+
+  //the rates are not sorted by throughput: move to the new best rate,
+  //unless a retry or a sample is in progress
+  if (station->m_longRetry == 0 && !station->m_isSampling)
+    {
+      station->m_txrate = station->m_maxTpRate;
+    }
+
+  NS_LOG_DEBUG ("max throughput=" << station->m_maxTpRate << " (" << GetGroupRate (station, station->m_maxTpRate).mode <<
+                ")\tsecond max throughput=" << station->m_maxTpRate2 << " (" << GetGroupRate (station, station->m_maxTpRate2).mode <<
+                ")\tmax prob=" << station->m_maxProbRate << " (" << GetGroupRate (station, station->m_maxProbRate).mode << ")");
+}
+
+void
+MinstrelHtWifiManager::RateInit (MinstrelHtWifiRemoteStation *station)
+{
+  NS_LOG_FUNCTION (station);
+
+  for (uint32_t i = 0; i < station->m_rates.size (); i++)
+    {
+      station->m_table.SetPerfectTxTime (i, GetGroupRate (station, i).txTime);
+      station->m_table.retryCount[i] = 1;
+      station->m_table.adjustedRetryCount[i] = 1;
+      //as in Minstrel, allow as many retries as fit in 6 ms, from 2 to 10
+      for (uint32_t retries = 2; retries < 11; retries++)
+        {
+          if (CalculateTimeUnicastPacket (station->m_table.perfectTxTime[i], 0, retries) > MilliSeconds (6))
+            {
+              break;
+            }
+          station->m_table.retryCount[i] = retries;
+          station->m_table.adjustedRetryCount[i] = retries;
+        }
+      NS_LOG_DEBUG (i << " (" << GetGroupRate (station, i).mode << "): " << station->m_table.perfectTxTime[i] <<
+                    ", retryCount = " << station->m_table.retryCount[i]);
+    }
+}
+
+Time
+MinstrelHtWifiManager::CalculateTimeUnicastPacket (Time dataTransmissionTime, uint32_t shortRetries, uint32_t longRetries)
+{
+  NS_LOG_FUNCTION (this << dataTransmissionTime << shortRetries << longRetries);
+  //See rc80211_minstrel.c
+
+  //First transmission (DATA + ACK timeout)
+  Time tt = dataTransmissionTime + GetMac ()->GetAckTimeout ();
+
+  uint32_t cwMax = 1023;
+  uint32_t cw = 31;
+  for (uint32_t retry = 0; retry < longRetries; retry++)
+    {
+      //Add one re-transmission (DATA + ACK timeout)
+      tt += dataTransmissionTime + GetMac ()->GetAckTimeout ();
+
+      //Add average back off (half the current contention window)
+      tt += NanoSeconds ((cw / 2) * GetMac ()->GetSlot ());
+
+      //Update contention window
+      cw = std::min (cwMax, (cw + 1) * 2);
+    }
+
+  return tt;
+}
+
+} //namespace ns3
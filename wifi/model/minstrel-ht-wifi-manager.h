@@ -0,0 +1,219 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MINSTREL_HT_WIFI_MANAGER_H
+#define MINSTREL_HT_WIFI_MANAGER_H
+
+#include "minstrel-wifi-manager.h"
+#include "wifi-remote-station-manager.h"
+#include "wifi-mode.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+struct MinstrelHtWifiRemoteStation;
+
+/**
+ * \brief Implementation of the Minstrel-HT rate control algorithm
+ * \ingroup wifi
+ *
+ * Minstrel-HT extends Minstrel to the MCSs of 802.11n and 802.11ac. The
+ * MCSs are arranged in groups of rates which share the number of
+ * spatial streams, the channel width and the guard interval, and the
+ * rates of all the groups supported by a remote station are kept in one
+ * MinstrelRate table, so that the periodic update of the statistics and
+ * the choice of the best rates work as in Minstrel, over the rates of
+ * all the groups at once. The description of the groups and of their
+ * rates, with the perfect transmission time of each rate, is shared by
+ * all the remote stations; the state of a station is its table and the
+ * index of each of its rates in the shared description.
+ *
+ * The probability of success of a rate is computed per MPDU, while the
+ * retry chain and the sampling advance once per transmission: the
+ * outcome of the MPDUs of an A-MPDU, reported one by one when the block
+ * ack is received, is applied at the next transmission to the station,
+ * a transmission being successful if at least one of its MPDUs was
+ * acknowledged. A sample rate is thus used for a whole A-MPDU, and
+ * counts as one sample whatever the number of MPDUs it carries; it is
+ * tried once, the retries falling back to the best rates.
+ *
+ * The remote stations which do not support HT are handled as in
+ * Minstrel, with one group made of the legacy rates.
+ *
+ * See http://wireless.kernel.org/en/developers/Documentation/mac80211/RateControl/minstrel
+ */
+class MinstrelHtWifiManager : public WifiRemoteStationManager
+{
+public:
+  static TypeId GetTypeId (void);
+  MinstrelHtWifiManager ();
+  virtual ~MinstrelHtWifiManager ();
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   *
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
+
+private:
+  //overriden from base class
+  virtual WifiRemoteStation * DoCreateStation (void) const;
+  virtual void DoReportRxOk (WifiRemoteStation *station,
+                             double rxSnr, WifiMode txMode);
+  virtual void DoReportRtsFailed (WifiRemoteStation *station);
+  virtual void DoReportDataFailed (WifiRemoteStation *station);
+  virtual void DoReportRtsOk (WifiRemoteStation *station,
+                              double ctsSnr, WifiMode ctsMode, double rtsSnr);
+  virtual void DoReportDataOk (WifiRemoteStation *station,
+                               double ackSnr, WifiMode ackMode, double dataSnr);
+  virtual void DoReportFinalRtsFailed (WifiRemoteStation *station);
+  virtual void DoReportFinalDataFailed (WifiRemoteStation *station);
+  virtual WifiTxVector DoGetDataTxVector (WifiRemoteStation *station, uint32_t size);
+  virtual WifiTxVector DoGetRtsTxVector (WifiRemoteStation *station);
+
+  virtual bool DoNeedDataRetransmission (WifiRemoteStation *st, Ptr<const Packet> packet, bool normally);
+
+  virtual bool IsLowLatency (void) const;
+
+  /**
+   * A group of rates which share the number of spatial streams, the
+   * channel width and the guard interval.
+   */
+  struct McsGroup
+  {
+    uint8_t nss;                  ///< the number of spatial streams
+    uint32_t channelWidth;        ///< the channel width, in MHz
+    bool shortGuardInterval;      ///< whether the short guard interval is used
+    /// the modulation class of the MCSs of the group, unknown for the legacy rates
+    WifiModulationClass modClass;
+  };
+
+  /// A rate of a group
+  struct McsGroupRate
+  {
+    WifiMode mode;   ///< the mode, or MCS, of the rate
+    uint32_t group;  ///< the index of the group of the rate
+    Time txTime;     ///< the transmission time of a reference packet
+  };
+
+  /**
+   * Build the groups and their rates from the modes and MCSs of the
+   * PHY, the first time a remote station is initialized.
+   */
+  void BuildGroups (void);
+  /**
+   * Add a group and its rates.
+   *
+   * \param group the group
+   * \param modes the modes, or MCSs, of the group
+   */
+  void AddGroup (McsGroup group, const WifiModeList &modes);
+  /**
+   * \param mcs the VHT MCS
+   * \param channelWidth the channel width, in MHz
+   * \param nss the number of spatial streams
+   * \returns true if the VHT MCS is allowed for this channel width and
+   *          number of spatial streams
+   */
+  static bool IsValidVhtMcs (WifiMode mcs, uint32_t channelWidth, uint8_t nss);
+  /**
+   * \param station the remote station
+   * \param rate the index of a rate of the station
+   * \returns the rate of the group
+   */
+  const McsGroupRate & GetGroupRate (MinstrelHtWifiRemoteStation *station, uint32_t rate) const;
+
+  //apply the outcome of the MPDUs reported since the last transmission
+  void UpdateTxStatus (MinstrelHtWifiRemoteStation *station);
+
+  /**
+   * Get the first two rates of the retry chain, which depend on whether
+   * the station is sampling a rate, the last two being the rate with the
+   * highest probability of success and the lowest rate.
+   *
+   * \param station the remote station
+   * \param first the first rate of the chain
+   * \param second the second rate of the chain
+   */
+  void GetChain (MinstrelHtWifiRemoteStation *station, uint32_t *first, uint32_t *second) const;
+
+  /**
+   * \param station the remote station
+   * \param rate a rate of the retry chain
+   * \returns the number of attempts at this rate in the retry chain
+   */
+  uint32_t GetRetries (MinstrelHtWifiRemoteStation *station, uint32_t rate) const;
+
+  //rate of the next retry, from the retry chain
+  uint32_t GetRetryRate (MinstrelHtWifiRemoteStation *station);
+
+  //update the number of retries and reset accordingly
+  void UpdateRetry (MinstrelHtWifiRemoteStation *station);
+
+  //getting the next sample from Sample Table
+  uint32_t GetNextSample (MinstrelHtWifiRemoteStation *station);
+
+  //find a rate to use from the table
+  uint32_t FindRate (MinstrelHtWifiRemoteStation *station);
+
+  //updating the table every 1/10 seconds
+  void UpdateStats (MinstrelHtWifiRemoteStation *station);
+
+  //initialize the table
+  void RateInit (MinstrelHtWifiRemoteStation *station);
+
+  /**
+   * Estimate the time to transmit the given packet with the given number
+   * of retries, as MinstrelWifiManager::CalculateTimeUnicastPacket.
+   */
+  Time CalculateTimeUnicastPacket (Time dataTransmissionTime, uint32_t shortRetries, uint32_t longRetries);
+
+  /**
+   * \param nRates the number of rates
+   * \returns the sample table of the stations with this number of rates,
+   *          created the first time it is needed
+   */
+  const SampleRate * GetSampleTable (uint32_t nRates);
+
+  void CheckInit (MinstrelHtWifiRemoteStation *station);  ///< check for initializations
+
+  std::vector<McsGroup> m_groups;    ///< the groups of rates
+  std::vector<McsGroupRate> m_rates; ///< the rates of all the groups
+  /// The sample tables, shared by the stations with the same number of rates
+  std::map<uint32_t, SampleRate> m_sampleTables;
+
+  Time m_updateStats;       ///< how frequent do we calculate the stats (1/10 seconds)
+  double m_lookAroundRate;  ///< the % to try other rates than our current rate
+  double m_ewmaLevel;       ///< exponential weighted moving average
+  uint32_t m_sampleCol;     ///< number of sample columns
+  uint32_t m_pktLen;        ///< packet length used for calculate mode TxTime
+
+  //Provides uniform random variables.
+  Ptr<UniformRandomVariable> m_uniformRandomVariable;
+};
+
+} //namespace ns3
+
+#endif /* MINSTREL_HT_WIFI_MANAGER_H */
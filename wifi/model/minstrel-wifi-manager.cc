@@ -37,6 +37,7 @@
 #include "ns3/wifi-mac.h"
 #include "ns3/assert.h"
 #include <vector>
+#include <algorithm>
 
 #define Min(a,b) ((a < b) ? a : b)
 
@@ -44,6 +45,127 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("MinstrelWifiManager");
 
+void
+MinstrelRate::Resize (uint32_t nRates)
+{
+  perfectTxTime.assign (nRates, Seconds (0));
+  throughputFactor.assign (nRates, 1);
+  retryCount.assign (nRates, 0);
+  adjustedRetryCount.assign (nRates, 0);
+  numRateAttempt.assign (nRates, 0);
+  numRateSuccess.assign (nRates, 0);
+  prob.assign (nRates, 0);
+  ewmaProb.assign (nRates, 0);
+  throughput.assign (nRates, 0);
+}
+
+uint32_t
+MinstrelRate::GetNRates (void) const
+{
+  return ewmaProb.size ();
+}
+
+void
+MinstrelRate::SetPerfectTxTime (uint32_t rate, Time txTime)
+{
+  perfectTxTime[rate] = txTime;
+  int64_t txTimeUs = txTime.GetMicroSeconds ();
+  //just for initialization
+  if (txTimeUs == 0)
+    {
+      txTimeUs = 1000000;
+    }
+  throughputFactor[rate] = 1000000 / txTimeUs;
+}
+
+void
+MinstrelRate::UpdateStats (double ewmaLevel)
+{
+  uint32_t n = GetNRates ();
+  if (n == 0)
+    {
+      return;
+    }
+  //each loop runs over contiguous arrays, without calls, so that the
+  //compiler can vectorize it
+  const uint32_t *attempts = &numRateAttempt[0];
+  const uint32_t *successes = &numRateSuccess[0];
+  const uint32_t *factors = &throughputFactor[0];
+  const uint32_t *retries = &retryCount[0];
+  uint32_t *probs = &prob[0];
+  uint32_t *ewmaProbs = &ewmaProb[0];
+  uint32_t *throughputs = &throughput[0];
+  uint32_t *adjustedRetries = &adjustedRetryCount[0];
+  double newLevel = 100 - ewmaLevel;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      //if we've attempted something
+      if (attempts[i])
+        {
+          /**
+           * calculate the probability of success
+           * assume probability scales from 0 to 18000
+           */
+          uint32_t tempProb = (successes[i] * 18000) / attempts[i];
+          probs[i] = tempProb;
+          tempProb = static_cast<uint32_t> (((tempProb * newLevel) + (ewmaProbs[i] * ewmaLevel)) / 100);
+          ewmaProbs[i] = tempProb;
+          throughputs[i] = tempProb * factors[i];
+        }
+    }
+  std::fill (numRateAttempt.begin (), numRateAttempt.end (), 0);
+  std::fill (numRateSuccess.begin (), numRateSuccess.end (), 0);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      /**
+       * Sample less often below 10% and above 95% of success
+       *
+       * See: http://wireless.kernel.org/en/developers/Documentation/mac80211/RateControl/minstrel/
+       *
+       * Analysis of information showed that the system was sampling too hard at some rates.
+       * For those rates that never work (54mb, 500m range) there is no point in sending 10 sample packets (< 6 ms time).
+       * Consequently, for the very very low probability rates, we sample at most twice.
+       */
+      bool rare = (ewmaProbs[i] > 17100) | (ewmaProbs[i] < 1800);
+      uint32_t adjusted = (rare && retries[i] > 2) ? 2 : retries[i];
+      //if it's 0 allow one retry limit
+      adjustedRetries[i] = adjusted == 0 ? 1 : adjusted;
+    }
+}
+
+void
+MinstrelRate::FindBestRates (uint32_t *maxTp, uint32_t *maxTp2, uint32_t *maxProb) const
+{
+  uint32_t n = GetNRates ();
+  uint32_t max_prob = 0, index_max_prob = 0, max_tp = 0, index_max_tp = 0, index_max_tp2 = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      if (max_tp < throughput[i])
+        {
+          index_max_tp = i;
+          max_tp = throughput[i];
+        }
+      if (max_prob < ewmaProb[i])
+        {
+          index_max_prob = i;
+          max_prob = ewmaProb[i];
+        }
+    }
+  //find the second highest max
+  max_tp = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      if ((i != index_max_tp) && (max_tp < throughput[i]))
+        {
+          index_max_tp2 = i;
+          max_tp = throughput[i];
+        }
+    }
+  *maxTp = index_max_tp;
+  *maxTp2 = index_max_tp2;
+  *maxProb = index_max_prob;
+}
+
 /**
  * \brief hold per-remote-station state for Minstrel Wifi manager.
  *
@@ -154,22 +276,18 @@ MinstrelWifiManager::AssignStreams (int64_t stream)
 Time
 MinstrelWifiManager::GetCalcTxTime (WifiMode mode) const
 {
-
-  for (TxTime::const_iterator i = m_calcTxTime.begin (); i != m_calcTxTime.end (); i++)
-    {
-      if (mode == i->second)
-        {
-          return i->first;
-        }
-    }
-  NS_ASSERT (false);
-  return Seconds (0);
+  NS_ASSERT (mode.GetUid () < m_calcTxTime.size ());
+  return m_calcTxTime[mode.GetUid ()];
 }
 
 void
 MinstrelWifiManager::AddCalcTxTime (WifiMode mode, Time t)
 {
-  m_calcTxTime.push_back (std::make_pair (t, mode));
+  if (mode.GetUid () >= m_calcTxTime.size ())
+    {
+      m_calcTxTime.resize (mode.GetUid () + 1);
+    }
+  m_calcTxTime[mode.GetUid ()] = t;
 }
 
 WifiRemoteStation *
@@ -207,7 +325,7 @@ MinstrelWifiManager::CheckInit (MinstrelWifiRemoteStation *station)
       //to make sure that the set of supported rates has been initialized
       //before we perform our own initialization.
       m_nsupported = GetNSupported (station);
-      station->m_minstrelTable = MinstrelRate (m_nsupported);
+      station->m_minstrelTable.Resize (m_nsupported);
       station->m_sampleTable = SampleRate (m_nsupported, std::vector<uint32_t> (m_sampleCol));
       InitSampleTable (station);
       RateInit (station);
@@ -275,7 +393,7 @@ MinstrelWifiManager::DoReportDataFailed (WifiRemoteStation *st)
     }
 
   station->m_longRetry++;
-  station->m_minstrelTable[station->m_txrate].numRateAttempt++;
+  station->m_minstrelTable.numRateAttempt[station->m_txrate]++;
 
   PrintTable (station);
 
@@ -286,33 +404,33 @@ MinstrelWifiManager::DoReportDataFailed (WifiRemoteStation *st)
     {
       NS_LOG_DEBUG ("Failed with normal rate: current=" << station->m_txrate << ", sample=" << station->m_sampleRate << ", maxTp=" << station->m_maxTpRate << ", maxTp2=" << station->m_maxTpRate2 << ", maxProb=" << station->m_maxProbRate);
       //use best throughput rate
-      if (station->m_longRetry < station->m_minstrelTable[station->m_maxTpRate].adjustedRetryCount)
+      if (station->m_longRetry < station->m_minstrelTable.adjustedRetryCount[station->m_maxTpRate])
         {
           NS_LOG_DEBUG (" More retries left for the maximum throughput rate.");
           station->m_txrate = station->m_maxTpRate;
         }
 
       //use second best throughput rate
-      else if (station->m_longRetry <= (station->m_minstrelTable[station->m_maxTpRate].adjustedRetryCount +
-                                        station->m_minstrelTable[station->m_maxTpRate2].adjustedRetryCount))
+      else if (station->m_longRetry <= (station->m_minstrelTable.adjustedRetryCount[station->m_maxTpRate] +
+                                        station->m_minstrelTable.adjustedRetryCount[station->m_maxTpRate2]))
         {
           NS_LOG_DEBUG (" More retries left for the second maximum throughput rate.");
           station->m_txrate = station->m_maxTpRate2;
         }
 
       //use best probability rate
-      else if (station->m_longRetry <= (station->m_minstrelTable[station->m_maxTpRate].adjustedRetryCount +
-                                        station->m_minstrelTable[station->m_maxTpRate2].adjustedRetryCount +
-                                        station->m_minstrelTable[station->m_maxProbRate].adjustedRetryCount))
+      else if (station->m_longRetry <= (station->m_minstrelTable.adjustedRetryCount[station->m_maxTpRate] +
+                                        station->m_minstrelTable.adjustedRetryCount[station->m_maxTpRate2] +
+                                        station->m_minstrelTable.adjustedRetryCount[station->m_maxProbRate]))
         {
           NS_LOG_DEBUG (" More retries left for the maximum probability rate.");
           station->m_txrate = station->m_maxProbRate;
         }
 
       //use lowest base rate
-      else if (station->m_longRetry > (station->m_minstrelTable[station->m_maxTpRate].adjustedRetryCount +
-                                       station->m_minstrelTable[station->m_maxTpRate2].adjustedRetryCount +
-                                       station->m_minstrelTable[station->m_maxProbRate].adjustedRetryCount))
+      else if (station->m_longRetry > (station->m_minstrelTable.adjustedRetryCount[station->m_maxTpRate] +
+                                       station->m_minstrelTable.adjustedRetryCount[station->m_maxTpRate2] +
+                                       station->m_minstrelTable.adjustedRetryCount[station->m_maxProbRate]))
         {
           NS_LOG_DEBUG (" More retries left for the base rate.");
           station->m_txrate = 0;
@@ -328,33 +446,33 @@ MinstrelWifiManager::DoReportDataFailed (WifiRemoteStation *st)
         {
           NS_LOG_DEBUG ("Look around rate is slower than the maximum throughput rate.");
           //use best throughput rate
-          if (station->m_longRetry < station->m_minstrelTable[station->m_maxTpRate].adjustedRetryCount)
+          if (station->m_longRetry < station->m_minstrelTable.adjustedRetryCount[station->m_maxTpRate])
             {
               NS_LOG_DEBUG (" More retries left for the maximum throughput rate.");
               station->m_txrate = station->m_maxTpRate;
             }
 
           //use random rate
-          else if (station->m_longRetry <= (station->m_minstrelTable[station->m_maxTpRate].adjustedRetryCount +
-                                            station->m_minstrelTable[station->m_sampleRate].adjustedRetryCount))
+          else if (station->m_longRetry <= (station->m_minstrelTable.adjustedRetryCount[station->m_maxTpRate] +
+                                            station->m_minstrelTable.adjustedRetryCount[station->m_sampleRate]))
             {
               NS_LOG_DEBUG (" More retries left for the sampling rate.");
               station->m_txrate = station->m_sampleRate;
             }
 
           //use max probability rate
-          else if (station->m_longRetry <= (station->m_minstrelTable[station->m_maxTpRate].adjustedRetryCount +
-                                            station->m_minstrelTable[station->m_sampleRate].adjustedRetryCount +
-                                            station->m_minstrelTable[station->m_maxProbRate].adjustedRetryCount ))
+          else if (station->m_longRetry <= (station->m_minstrelTable.adjustedRetryCount[station->m_maxTpRate] +
+                                            station->m_minstrelTable.adjustedRetryCount[station->m_sampleRate] +
+                                            station->m_minstrelTable.adjustedRetryCount[station->m_maxProbRate] ))
             {
               NS_LOG_DEBUG (" More retries left for the maximum probability rate.");
               station->m_txrate = station->m_maxProbRate;
             }
 
           //use lowest base rate
-          else if (station->m_longRetry > (station->m_minstrelTable[station->m_maxTpRate].adjustedRetryCount +
-                                           station->m_minstrelTable[station->m_sampleRate].adjustedRetryCount +
-                                           station->m_minstrelTable[station->m_maxProbRate].adjustedRetryCount))
+          else if (station->m_longRetry > (station->m_minstrelTable.adjustedRetryCount[station->m_maxTpRate] +
+                                           station->m_minstrelTable.adjustedRetryCount[station->m_sampleRate] +
+                                           station->m_minstrelTable.adjustedRetryCount[station->m_maxProbRate]))
             {
               NS_LOG_DEBUG (" More retries left for the base rate.");
               station->m_txrate = 0;
@@ -365,33 +483,33 @@ MinstrelWifiManager::DoReportDataFailed (WifiRemoteStation *st)
         {
           NS_LOG_DEBUG ("Look around rate is faster than the maximum throughput rate.");
           //use random rate
-          if (station->m_longRetry < station->m_minstrelTable[station->m_sampleRate].adjustedRetryCount)
+          if (station->m_longRetry < station->m_minstrelTable.adjustedRetryCount[station->m_sampleRate])
             {
               NS_LOG_DEBUG (" More retries left for the sampling rate.");
               station->m_txrate = station->m_sampleRate;
             }
 
           //use the best throughput rate
-          else if (station->m_longRetry <= (station->m_minstrelTable[station->m_sampleRate].adjustedRetryCount +
-                                            station->m_minstrelTable[station->m_maxTpRate].adjustedRetryCount))
+          else if (station->m_longRetry <= (station->m_minstrelTable.adjustedRetryCount[station->m_sampleRate] +
+                                            station->m_minstrelTable.adjustedRetryCount[station->m_maxTpRate]))
             {
               NS_LOG_DEBUG (" More retries left for the maximum throughput rate.");
               station->m_txrate = station->m_maxTpRate;
             }
 
           //use the best probability rate
-          else if (station->m_longRetry <= (station->m_minstrelTable[station->m_sampleRate].adjustedRetryCount +
-                                            station->m_minstrelTable[station->m_maxTpRate].adjustedRetryCount +
-                                            station->m_minstrelTable[station->m_maxProbRate].adjustedRetryCount))
+          else if (station->m_longRetry <= (station->m_minstrelTable.adjustedRetryCount[station->m_sampleRate] +
+                                            station->m_minstrelTable.adjustedRetryCount[station->m_maxTpRate] +
+                                            station->m_minstrelTable.adjustedRetryCount[station->m_maxProbRate]))
             {
               NS_LOG_DEBUG (" More retries left for the maximum probability rate.");
               station->m_txrate = station->m_maxProbRate;
             }
 
           //use the lowest base rate
-          else if (station->m_longRetry > (station->m_minstrelTable[station->m_sampleRate].adjustedRetryCount +
-                                           station->m_minstrelTable[station->m_maxTpRate].adjustedRetryCount +
-                                           station->m_minstrelTable[station->m_maxProbRate].adjustedRetryCount))
+          else if (station->m_longRetry > (station->m_minstrelTable.adjustedRetryCount[station->m_sampleRate] +
+                                           station->m_minstrelTable.adjustedRetryCount[station->m_maxTpRate] +
+                                           station->m_minstrelTable.adjustedRetryCount[station->m_maxProbRate]))
             {
               NS_LOG_DEBUG (" More retries left for the base rate.");
               station->m_txrate = 0;
@@ -415,12 +533,12 @@ MinstrelWifiManager::DoReportDataOk (WifiRemoteStation *st,
     {
       return;
     }
-  NS_LOG_DEBUG ("DoReportDataOk m_txrate = " << station->m_txrate << ", attempt = " << station->m_minstrelTable[station->m_txrate].numRateAttempt << ", success = " << station->m_minstrelTable[station->m_txrate].numRateSuccess << " (before update).");
+  NS_LOG_DEBUG ("DoReportDataOk m_txrate = " << station->m_txrate << ", attempt = " << station->m_minstrelTable.numRateAttempt[station->m_txrate] << ", success = " << station->m_minstrelTable.numRateSuccess[station->m_txrate] << " (before update).");
 
-  station->m_minstrelTable[station->m_txrate].numRateSuccess++;
-  station->m_minstrelTable[station->m_txrate].numRateAttempt++;
+  station->m_minstrelTable.numRateSuccess[station->m_txrate]++;
+  station->m_minstrelTable.numRateAttempt[station->m_txrate]++;
 
-  NS_LOG_DEBUG ("DoReportDataOk m_txrate = " << station->m_txrate << ", attempt = " << station->m_minstrelTable[station->m_txrate].numRateAttempt << ", success = " << station->m_minstrelTable[station->m_txrate].numRateSuccess << " (after update).");
+  NS_LOG_DEBUG ("DoReportDataOk m_txrate = " << station->m_txrate << ", attempt = " << station->m_minstrelTable.numRateAttempt[station->m_txrate] << ", success = " << station->m_minstrelTable.numRateSuccess[station->m_txrate] << " (after update).");
 
   UpdateRetry (station);
 
@@ -444,7 +562,7 @@ MinstrelWifiManager::DoReportFinalDataFailed (WifiRemoteStation *st)
       return;
     }
 
-  NS_LOG_DEBUG ("DoReportFinalDataFailed m_txrate = " << station->m_txrate << ", attempt = " << station->m_minstrelTable[station->m_txrate].numRateAttempt << ", success = " << station->m_minstrelTable[station->m_txrate].numRateSuccess << " (before update).");
+  NS_LOG_DEBUG ("DoReportFinalDataFailed m_txrate = " << station->m_txrate << ", attempt = " << station->m_minstrelTable.numRateAttempt[station->m_txrate] << ", success = " << station->m_minstrelTable.numRateSuccess[station->m_txrate] << " (before update).");
 
   station->m_isSampling = false;
   station->m_sampleRateSlower = false;
@@ -453,7 +571,7 @@ MinstrelWifiManager::DoReportFinalDataFailed (WifiRemoteStation *st)
 
   station->m_err++;
 
-  NS_LOG_DEBUG ("DoReportFinalDataFailed m_txrate = " << station->m_txrate << ", attempt = " << station->m_minstrelTable[station->m_txrate].numRateAttempt << ", success = " << station->m_minstrelTable[station->m_txrate].numRateSuccess << " (after update).");
+  NS_LOG_DEBUG ("DoReportFinalDataFailed m_txrate = " << station->m_txrate << ", attempt = " << station->m_minstrelTable.numRateAttempt[station->m_txrate] << ", success = " << station->m_minstrelTable.numRateSuccess[station->m_txrate] << " (after update).");
 
   if (m_nsupported >= 1)
     {
@@ -518,10 +636,10 @@ MinstrelWifiManager::DoNeedDataRetransmission (WifiRemoteStation *st, Ptr<const
 
   if (!station->m_isSampling)
     {
-      if (station->m_longRetry > (station->m_minstrelTable[station->m_maxTpRate].adjustedRetryCount +
-                                  station->m_minstrelTable[station->m_maxTpRate2].adjustedRetryCount +
-                                  station->m_minstrelTable[station->m_maxProbRate].adjustedRetryCount +
-                                  station->m_minstrelTable[0].adjustedRetryCount))
+      if (station->m_longRetry > (station->m_minstrelTable.adjustedRetryCount[station->m_maxTpRate] +
+                                  station->m_minstrelTable.adjustedRetryCount[station->m_maxTpRate2] +
+                                  station->m_minstrelTable.adjustedRetryCount[station->m_maxProbRate] +
+                                  station->m_minstrelTable.adjustedRetryCount[0]))
         {
           return false;
         }
@@ -532,10 +650,10 @@ MinstrelWifiManager::DoNeedDataRetransmission (WifiRemoteStation *st, Ptr<const
     }
   else
     {
-      if (station->m_longRetry > (station->m_minstrelTable[station->m_sampleRate].adjustedRetryCount +
-                                  station->m_minstrelTable[station->m_maxTpRate].adjustedRetryCount +
-                                  station->m_minstrelTable[station->m_maxProbRate].adjustedRetryCount +
-                                  station->m_minstrelTable[0].adjustedRetryCount))
+      if (station->m_longRetry > (station->m_minstrelTable.adjustedRetryCount[station->m_sampleRate] +
+                                  station->m_minstrelTable.adjustedRetryCount[station->m_maxTpRate] +
+                                  station->m_minstrelTable.adjustedRetryCount[station->m_maxProbRate] +
+                                  station->m_minstrelTable.adjustedRetryCount[0]))
         {
           return false;
         }
@@ -636,7 +754,7 @@ MinstrelWifiManager::FindRate (MinstrelWifiRemoteStation *station)
 
           //is this rate slower than the current best rate
           station->m_sampleRateSlower =
-            (station->m_minstrelTable[idx].perfectTxTime > station->m_minstrelTable[station->m_maxTpRate].perfectTxTime);
+            (station->m_minstrelTable.perfectTxTime[idx] > station->m_minstrelTable.perfectTxTime[station->m_maxTpRate]);
 
           //using the best rate instead
           if (station->m_sampleRateSlower)
@@ -675,86 +793,19 @@ MinstrelWifiManager::UpdateStats (MinstrelWifiRemoteStation *station)
   NS_LOG_DEBUG ("Next update at " << station->m_nextStatsUpdate);
   NS_LOG_DEBUG ("Currently using rate: " << station->m_txrate << " (" << GetSupported (station, station->m_txrate) << ")");
 
-  Time txTime;
-  uint32_t tempProb;
-
   NS_LOG_DEBUG ("Index-Rate\t\tAttempt\tSuccess");
   for (uint32_t i = 0; i < m_nsupported; i++)
     {
-
-      //calculate the perfect tx time for this rate
-      txTime = station->m_minstrelTable[i].perfectTxTime;
-
-      //just for initialization
-      if (txTime.GetMicroSeconds () == 0)
-        {
-          txTime = Seconds (1);
-        }
-
       NS_LOG_DEBUG (i << " " << GetSupported (station, i) <<
-                    "\t" << station->m_minstrelTable[i].numRateAttempt <<
-                    "\t" << station->m_minstrelTable[i].numRateSuccess);
-
-      //if we've attempted something
-      if (station->m_minstrelTable[i].numRateAttempt)
-        {
-          /**
-           * calculate the probability of success
-           * assume probability scales from 0 to 18000
-           */
-          tempProb = (station->m_minstrelTable[i].numRateSuccess * 18000) / station->m_minstrelTable[i].numRateAttempt;
-
-          //bookeeping
-          station->m_minstrelTable[i].prob = tempProb;
-
-          //ewma probability (cast for gcc 3.4 compatibility)
-          tempProb = static_cast<uint32_t> (((tempProb * (100 - m_ewmaLevel)) + (station->m_minstrelTable[i].ewmaProb * m_ewmaLevel) ) / 100);
-
-          station->m_minstrelTable[i].ewmaProb = tempProb;
-
-          //calculating throughput
-          station->m_minstrelTable[i].throughput = tempProb * (1000000 / txTime.GetMicroSeconds ());
-
-        }
-
-      //bookeeping
-      station->m_minstrelTable[i].numRateSuccess = 0;
-      station->m_minstrelTable[i].numRateAttempt = 0;
-
-      //Sample less often below 10% and  above 95% of success
-      if ((station->m_minstrelTable[i].ewmaProb > 17100) || (station->m_minstrelTable[i].ewmaProb < 1800))
-        {
-          /**
-           * See: http://wireless.kernel.org/en/developers/Documentation/mac80211/RateControl/minstrel/
-           *
-           * Analysis of information showed that the system was sampling too hard at some rates.
-           * For those rates that never work (54mb, 500m range) there is no point in sending 10 sample packets (< 6 ms time).
-           * Consequently, for the very very low probability rates, we sample at most twice.
-           */
-          if (station->m_minstrelTable[i].retryCount > 2)
-            {
-              station->m_minstrelTable[i].adjustedRetryCount = 2;
-            }
-          else
-            {
-              station->m_minstrelTable[i].adjustedRetryCount = station->m_minstrelTable[i].retryCount;
-            }
-        }
-      else
-        {
-          station->m_minstrelTable[i].adjustedRetryCount = station->m_minstrelTable[i].retryCount;
-        }
-
-      //if it's 0 allow one retry limit
-      if (station->m_minstrelTable[i].adjustedRetryCount == 0)
-        {
-          station->m_minstrelTable[i].adjustedRetryCount = 1;
-        }
+                    "\t" << station->m_minstrelTable.numRateAttempt[i] <<
+                    "\t" << station->m_minstrelTable.numRateSuccess[i]);
     }
 
+  station->m_minstrelTable.UpdateStats (m_ewmaLevel);
+
   NS_LOG_DEBUG ("Attempt/success resetted to 0");
 
-  uint32_t max_prob = 0, index_max_prob = 0, max_tp = 0, index_max_tp = 0, index_max_tp2 = 0;
+  uint32_t index_max_prob, index_max_tp, index_max_tp2;
 
   //go find max throughput, second maximum throughput, high probability succ
   NS_LOG_DEBUG ("Finding the maximum throughput, second maximum throughput, and highest probability");
@@ -762,33 +813,10 @@ MinstrelWifiManager::UpdateStats (MinstrelWifiRemoteStation *station)
   for (uint32_t i = 0; i < m_nsupported; i++)
     {
       NS_LOG_DEBUG (i << " " << GetSupported (station, i) <<
-                    "\t" << station->m_minstrelTable[i].throughput <<
-                    "\t" << station->m_minstrelTable[i].ewmaProb);
-
-      if (max_tp < station->m_minstrelTable[i].throughput)
-        {
-          index_max_tp = i;
-          max_tp = station->m_minstrelTable[i].throughput;
-        }
-
-      if (max_prob < station->m_minstrelTable[i].ewmaProb)
-        {
-          index_max_prob = i;
-          max_prob = station->m_minstrelTable[i].ewmaProb;
-        }
-    }
-
-
-  max_tp = 0;
-  //find the second highest max
-  for (uint32_t i = 0; i < m_nsupported; i++)
-    {
-      if ((i != index_max_tp) && (max_tp < station->m_minstrelTable[i].throughput))
-        {
-          index_max_tp2 = i;
-          max_tp = station->m_minstrelTable[i].throughput;
-        }
+                    "\t" << station->m_minstrelTable.throughput[i] <<
+                    "\t" << station->m_minstrelTable.ewmaProb[i]);
     }
+  station->m_minstrelTable.FindBestRates (&index_max_tp, &index_max_tp2, &index_max_prob);
 
   station->m_maxTpRate = index_max_tp;
   station->m_maxTpRate2 = index_max_tp2;
@@ -812,15 +840,15 @@ MinstrelWifiManager::RateInit (MinstrelWifiRemoteStation *station)
   for (uint32_t i = 0; i < m_nsupported; i++)
     {
       NS_LOG_DEBUG ("Initializing rate index " << i << " " << GetSupported (station, i));
-      station->m_minstrelTable[i].numRateAttempt = 0;
-      station->m_minstrelTable[i].numRateSuccess = 0;
-      station->m_minstrelTable[i].prob = 0;
-      station->m_minstrelTable[i].ewmaProb = 0;
-      station->m_minstrelTable[i].throughput = 0;
-      station->m_minstrelTable[i].perfectTxTime = GetCalcTxTime (GetSupported (station, i));
-      NS_LOG_DEBUG (" perfectTxTime = " << station->m_minstrelTable[i].perfectTxTime);
-      station->m_minstrelTable[i].retryCount = 1;
-      station->m_minstrelTable[i].adjustedRetryCount = 1;
+      station->m_minstrelTable.numRateAttempt[i] = 0;
+      station->m_minstrelTable.numRateSuccess[i] = 0;
+      station->m_minstrelTable.prob[i] = 0;
+      station->m_minstrelTable.ewmaProb[i] = 0;
+      station->m_minstrelTable.throughput[i] = 0;
+      station->m_minstrelTable.SetPerfectTxTime (i, GetCalcTxTime (GetSupported (station, i)));
+      NS_LOG_DEBUG (" perfectTxTime = " << station->m_minstrelTable.perfectTxTime[i]);
+      station->m_minstrelTable.retryCount[i] = 1;
+      station->m_minstrelTable.adjustedRetryCount[i] = 1;
       //Emulating minstrel.c::ath_rate_ctl_reset
       //We only check from 2 to 10 retries. This guarantee that
       //at least one retry is permitter.
@@ -829,14 +857,14 @@ MinstrelWifiManager::RateInit (MinstrelWifiRemoteStation *station)
       for (uint32_t retries = 2; retries < 11; retries++)
         {
           NS_LOG_DEBUG ("  Checking " << retries << " retries");
-          totalTxTimeWithGivenRetries = CalculateTimeUnicastPacket (station->m_minstrelTable[i].perfectTxTime, 0, retries);
+          totalTxTimeWithGivenRetries = CalculateTimeUnicastPacket (station->m_minstrelTable.perfectTxTime[i], 0, retries);
           NS_LOG_DEBUG ("   totalTxTimeWithGivenRetries = " << totalTxTimeWithGivenRetries);
           if (totalTxTimeWithGivenRetries > MilliSeconds (6))
             {
               break;
             }
-          station->m_minstrelTable[i].retryCount = retries;
-          station->m_minstrelTable[i].adjustedRetryCount = retries;
+          station->m_minstrelTable.retryCount[i] = retries;
+          station->m_minstrelTable.adjustedRetryCount[i] = retries;
         }
     }
 }
@@ -924,7 +952,7 @@ MinstrelWifiManager::PrintTable (MinstrelWifiRemoteStation *station)
 
   for (uint32_t i = 0; i < m_nsupported; i++)
     {
-      NS_LOG_DEBUG (i << " (" << GetSupported (station, i) << "): "  << station->m_minstrelTable[i].perfectTxTime << ", retryCount = " << station->m_minstrelTable[i].retryCount << ", adjustedRetryCount = " << station->m_minstrelTable[i].adjustedRetryCount);
+      NS_LOG_DEBUG (i << " (" << GetSupported (station, i) << "): "  << station->m_minstrelTable.perfectTxTime[i] << ", retryCount = " << station->m_minstrelTable.retryCount[i] << ", adjustedRetryCount = " << station->m_minstrelTable.adjustedRetryCount[i]);
     }
 }
 
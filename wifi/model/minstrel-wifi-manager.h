@@ -31,36 +31,79 @@ namespace ns3 {
 struct MinstrelWifiRemoteStation;
 
 /**
- * A struct to contain all information related to a data rate
+ * Data structure for a Minstrel Rate table
+ *
+ * The information related to the data rates is kept in one array per
+ * field, indexed by the rate, rather than in one struct per rate, so
+ * that the periodic update of the statistics of all the rates of a
+ * station runs over contiguous arrays of integers, which the compiler
+ * can vectorize. The table does not depend on the kind of rates it
+ * holds, and can also hold the rates of one group of MCSs.
  */
-struct RateInfo
+struct MinstrelRate
 {
+  /**
+   * Resize the table, the statistics of all the rates being reset.
+   *
+   * \param nRates the number of rates of the table
+   */
+  void Resize (uint32_t nRates);
+  /**
+   * \return the number of rates of the table
+   */
+  uint32_t GetNRates (void) const;
+  /**
+   * Set the perfect transmission time of a rate, and precompute the
+   * factor which converts its probability of success into a throughput.
+   *
+   * \param rate the index of the rate
+   * \param txTime the perfect transmission time of the rate
+   */
+  void SetPerfectTxTime (uint32_t rate, Time txTime);
+  /**
+   * Update the EWMA probability of success and the throughput of the
+   * rates attempted since the last update, reset the number of attempts
+   * and successes of all the rates, and adjust their retry counts.
+   *
+   * \param ewmaLevel the EWMA level, in percents
+   */
+  void UpdateStats (double ewmaLevel);
+  /**
+   * Find the rates with the highest and second highest throughputs, and
+   * the rate with the highest probability of success.
+   *
+   * \param maxTp the rate with the highest throughput
+   * \param maxTp2 the rate with the second highest throughput
+   * \param maxProb the rate with the highest probability of success
+   */
+  void FindBestRates (uint32_t *maxTp, uint32_t *maxTp2, uint32_t *maxProb) const;
+
   /**
    * Perfect transmission time calculation, or frame calculation
    * Given a bit rate and a packet length n bytes
    */
-  Time perfectTxTime;
+  std::vector<Time> perfectTxTime;
+  /**
+   * 1000000 divided by the perfect transmission time in microseconds
+   * (one second if unknown), to convert a probability into a throughput
+   */
+  std::vector<uint32_t> throughputFactor;
 
-  uint32_t retryCount;          ///< retry limit
-  uint32_t adjustedRetryCount;  ///< adjust the retry limit for this rate
-  uint32_t numRateAttempt;      ///< how many number of attempts so far
-  uint32_t numRateSuccess;      ///< number of successful pkts
-  uint32_t prob;                ///< (# pkts success )/(# total pkts)
+  std::vector<uint32_t> retryCount;          ///< retry limit
+  std::vector<uint32_t> adjustedRetryCount;  ///< adjust the retry limit for this rate
+  std::vector<uint32_t> numRateAttempt;      ///< how many number of attempts so far
+  std::vector<uint32_t> numRateSuccess;      ///< number of successful pkts
+  std::vector<uint32_t> prob;                ///< (# pkts success )/(# total pkts)
 
   /**
    * EWMA calculation
    * ewma_prob =[prob *(100 - ewma_level) + (ewma_prob_old * ewma_level)]/100
    */
-  uint32_t ewmaProb;
+  std::vector<uint32_t> ewmaProb;
 
-  uint32_t throughput;  ///< throughput of a rate
+  std::vector<uint32_t> throughput;  ///< throughput of a rate
 };
 
-/**
- * Data structure for a Minstrel Rate table
- * A vector of a struct RateInfo
- */
-typedef std::vector<struct RateInfo> MinstrelRate;
 /**
  * Data structure for a Sample Rate table
  * A vector of a vector uint32_t
@@ -173,11 +216,10 @@ private:
   void CheckInit (MinstrelWifiRemoteStation *station);  ///< check for initializations
 
   /**
-   * typedef for a vector of a pair of Time, WifiMode.
-   * (Essentially a list for WifiMode and its corresponding transmission time
-   * to transmit a reference packet.
+   * The transmission time of a reference packet for each mode, indexed
+   * by the unique identifier of the mode.
    */
-  typedef std::vector<std::pair<Time,WifiMode> > TxTime;
+  typedef std::vector<Time> TxTime;
 
   TxTime m_calcTxTime;      ///< to hold all the calculated TxTime for all modes
   Time m_updateStats;       ///< how frequent do we calculate the stats (1/10 seconds)
@@ -46,7 +46,7 @@ MpduAggregator::Deaggregate (Ptr<Packet> aggregatedPacket)
   DeaggregatedMpdus set;
 
   AmpduSubframeHeader hdr;
-  Ptr<Packet> extractedMpdu = Create<Packet> ();
+  Ptr<Packet> extractedMpdu;
   uint32_t maxSize = aggregatedPacket->GetSize ();
   uint16_t extractedLength;
   uint32_t padding;
@@ -56,16 +56,20 @@ MpduAggregator::Deaggregate (Ptr<Packet> aggregatedPacket)
     {
       deserialized += aggregatedPacket->RemoveHeader (hdr);
       extractedLength = hdr.GetLength ();
-      extractedMpdu = aggregatedPacket->CreateFragment (0, static_cast<uint32_t> (extractedLength));
-      aggregatedPacket->RemoveAtStart (extractedLength);
-      deserialized += extractedLength;
-
       padding = (4 - (extractedLength % 4 )) % 4;
 
-      if (padding > 0 && deserialized < maxSize)
+      if (deserialized + extractedLength + padding >= maxSize)
+        {
+          //last MPDU: only the padding, if any, follows it
+          aggregatedPacket->RemoveAtEnd (maxSize - deserialized - extractedLength);
+          extractedMpdu = aggregatedPacket;
+          deserialized = maxSize;
+        }
+      else
         {
-          aggregatedPacket->RemoveAtStart (padding);
-          deserialized += padding;
+          extractedMpdu = aggregatedPacket->CreateFragment (0, static_cast<uint32_t> (extractedLength));
+          aggregatedPacket->RemoveAtStart (extractedLength + padding);
+          deserialized += extractedLength + padding;
         }
 
       std::pair<Ptr<Packet>, AmpduSubframeHeader> packetHdr (extractedMpdu, hdr);
@@ -58,6 +58,18 @@ public:
    * specified how and if <i>packet</i> can be added to <i>aggregatedPacket</i>.
    */
   virtual bool Aggregate (Ptr<const Packet> packet, Ptr<Packet> aggregatedPacket) = 0;
+  /**
+   * \param packetSize size of the MPDU we have to insert into <i>aggregatedPacket</i>.
+   * \param aggregatedPacket Packet that will grow by the size of the A-MPDU subframe of the MPDU,
+   *        if aggregation is possible.
+   *
+   * \return true if an MPDU of size <i>packetSize</i> can be aggregated to <i>aggregatedPacket</i>, false otherwise.
+   *
+   * Works as Aggregate, but only adds as many zeros as the A-MPDU subframe, padding included,
+   * would add to <i>aggregatedPacket</i>. This is used to keep track of the size of an A-MPDU
+   * whose MPDUs are kept apart until they are sent, without copying them.
+   */
+  virtual bool AggregateSize (uint32_t packetSize, Ptr<Packet> aggregatedPacket) = 0;
   /**
   * This method performs a VHT single MPDU aggregation.
   */
@@ -85,6 +97,8 @@ public:
   virtual uint32_t CalculatePadding (Ptr<const Packet> packet) = 0;
   /**
    * Deaggregates an A-MPDU by removing the A-MPDU subframe header and padding.
+   * The last MPDU is not copied: it is <i>aggregatedPacket</i> itself, once the
+   * MPDUs before it and the headers and padding are removed.
    *
    * \return list of deaggragted packets and their A-MPDU subframe headers
    */
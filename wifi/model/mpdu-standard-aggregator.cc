@@ -66,8 +66,7 @@ MpduStandardAggregator::Aggregate (Ptr<const Packet> packet, Ptr<Packet> aggrega
     {
       if (padding)
         {
-          Ptr<Packet> pad = Create<Packet> (padding);
-          aggregatedPacket->AddAtEnd (pad);
+          aggregatedPacket->AddPaddingAtEnd (padding);
         }
       currentHdr.SetCrc (1);
       currentHdr.SetSig ();
@@ -81,6 +80,21 @@ MpduStandardAggregator::Aggregate (Ptr<const Packet> packet, Ptr<Packet> aggrega
   return false;
 }
 
+bool
+MpduStandardAggregator::AggregateSize (uint32_t packetSize, Ptr<Packet> aggregatedPacket)
+{
+  NS_LOG_FUNCTION (this << packetSize);
+  uint32_t padding = CalculatePadding (aggregatedPacket);
+  uint32_t actualSize = aggregatedPacket->GetSize ();
+
+  if ((4 + packetSize + actualSize + padding) <= m_maxAmpduLength)
+    {
+      aggregatedPacket->AddPaddingAtEnd (padding + 4 + packetSize);
+      return true;
+    }
+  return false;
+}
+
 void
 MpduStandardAggregator::AggregateVhtSingleMpdu (Ptr<const Packet> packet, Ptr<Packet> aggregatedPacket)
 {
@@ -91,8 +105,7 @@ MpduStandardAggregator::AggregateVhtSingleMpdu (Ptr<const Packet> packet, Ptr<Pa
   uint32_t padding = CalculatePadding (aggregatedPacket);
   if (padding)
     {
-      Ptr<Packet> pad = Create<Packet> (padding);
-      aggregatedPacket->AddAtEnd (pad);
+      aggregatedPacket->AddPaddingAtEnd (padding);
     }
 
   currentHdr.SetEof (1);
@@ -126,8 +139,7 @@ MpduStandardAggregator::AddHeaderAndPad (Ptr<Packet> packet, bool last, bool vht
 
   if (padding && !last)
     {
-      Ptr<Packet> pad = Create<Packet> (padding);
-      packet->AddAtEnd (pad);
+      packet->AddPaddingAtEnd (padding);
     }
 }
 
@@ -47,6 +47,15 @@ public:
    * Returns true if <i>packet</i> can be aggregated to <i>aggregatedPacket</i>, false otherwise.
    */
   virtual bool Aggregate (Ptr<const Packet> packet, Ptr<Packet> aggregatedPacket);
+  /**
+   * \param packetSize size of the MPDU we have to insert into <i>aggregatedPacket</i>.
+   * \param aggregatedPacket packet that will grow by the size of the A-MPDU subframe of the MPDU,
+   *        if aggregation is possible.
+   *
+   * \return true if an MPDU of size <i>packetSize</i> can be aggregated to <i>aggregatedPacket</i>,
+   *         false otherwise.
+   */
+  virtual bool AggregateSize (uint32_t packetSize, Ptr<Packet> aggregatedPacket);
   /**
   * This method performs a VHT single MPDU aggregation.
   */
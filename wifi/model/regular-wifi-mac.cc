@@ -196,6 +196,18 @@ RegularWifiMac::GetBKQueue () const
   return m_edca.find (AC_BK)->second;
 }
 
+uint64_t
+RegularWifiMac::GetScheduledAccessTimeouts (void) const
+{
+  return m_dcfManager->GetScheduledAccessTimeouts ();
+}
+
+uint64_t
+RegularWifiMac::GetUsefulAccessTimeouts (void) const
+{
+  return m_dcfManager->GetUsefulAccessTimeouts ();
+}
+
 void
 RegularWifiMac::SetWifiPhy (Ptr<WifiPhy> phy)
 {
@@ -708,6 +720,20 @@ RegularWifiMac::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&RegularWifiMac::GetBKQueue),
                    MakePointerChecker<EdcaTxopN> ())
+    .AddAttribute ("ScheduledAccessTimeouts",
+                   "The number of access timeouts scheduled so far to grant "
+                   "the access to the medium at the end of a backoff.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&RegularWifiMac::GetScheduledAccessTimeouts),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("UsefulAccessTimeouts",
+                   "The number of access timeouts which granted the access "
+                   "to the medium so far.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&RegularWifiMac::GetUsefulAccessTimeouts),
+                   MakeUintegerChecker<uint64_t> ())
     .AddTraceSource ("TxOkHeader",
                      "The header of successfully transmitted packet",
                      MakeTraceSourceAccessor (&RegularWifiMac::m_txOkCallback),
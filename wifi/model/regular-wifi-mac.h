@@ -299,6 +299,15 @@ protected:
    * \return a smart pointer to EdcaTxopN
    */
   Ptr<EdcaTxopN> GetBKQueue (void) const;
+  /**
+   * \return the number of access timeouts scheduled by the DcfManager
+   */
+  uint64_t GetScheduledAccessTimeouts (void) const;
+  /**
+   * \return the number of access timeouts of the DcfManager which
+   *         granted the access to the medium
+   */
+  uint64_t GetUsefulAccessTimeouts (void) const;
 
   /**
    * \param standard the phy standard to be used
@@ -0,0 +1,165 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cmath>
+#include "tabulated-error-rate-model.h"
+#include "ns3/double.h"
+#include "ns3/pointer.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TabulatedErrorRateModel");
+
+NS_OBJECT_ENSURE_REGISTERED (TabulatedErrorRateModel);
+
+/* The value stored in the tables for a per-bit error probability of
+ * zero: exp (-745) is the smallest positive double.
+ */
+static const double LOG_BER_MIN = -745.0;
+
+TypeId
+TabulatedErrorRateModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TabulatedErrorRateModel")
+    .SetParent<ErrorRateModel> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<TabulatedErrorRateModel> ()
+    .AddAttribute ("Model",
+                   "The error rate model which is tabulated.",
+                   PointerValue (),
+                   MakePointerAccessor (&TabulatedErrorRateModel::SetModel,
+                                        &TabulatedErrorRateModel::GetModel),
+                   MakePointerChecker<ErrorRateModel> ())
+    .AddAttribute ("MinSnr",
+                   "The lowest SNR (dB) of the table.",
+                   DoubleValue (-10.0),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_minSnrDb),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("MaxSnr",
+                   "The highest SNR (dB) of the table.",
+                   DoubleValue (60.0),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_maxSnrDb),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("SnrStep",
+                   "The spacing (dB) between two SNR points of the table.",
+                   DoubleValue (0.02),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_snrStepDb),
+                   MakeDoubleChecker<double> (1e-6))
+  ;
+  return tid;
+}
+
+TabulatedErrorRateModel::TabulatedErrorRateModel ()
+  : m_model (0)
+{
+}
+
+TabulatedErrorRateModel::~TabulatedErrorRateModel ()
+{
+}
+
+void
+TabulatedErrorRateModel::DoDispose (void)
+{
+  m_tables.clear ();
+  m_model = 0;
+  ErrorRateModel::DoDispose ();
+}
+
+void
+TabulatedErrorRateModel::SetModel (Ptr<ErrorRateModel> model)
+{
+  m_model = model;
+  m_tables.clear ();
+}
+
+Ptr<ErrorRateModel>
+TabulatedErrorRateModel::GetModel (void) const
+{
+  return m_model;
+}
+
+void
+TabulatedErrorRateModel::Flush (void)
+{
+  m_tables.clear ();
+}
+
+const TabulatedErrorRateModel::Table &
+TabulatedErrorRateModel::GetTable (WifiMode mode, WifiTxVector txVector) const
+{
+  uint64_t key = (static_cast<uint64_t> (mode.GetUid ()) << 32)
+    | (static_cast<uint64_t> (txVector.GetChannelWidth ()) << 1)
+    | (txVector.IsShortGuardInterval () ? 1 : 0);
+  Tables::iterator it = m_tables.find (key);
+  if (it != m_tables.end ())
+    {
+      return it->second;
+    }
+  NS_LOG_DEBUG ("building table for mode=" << mode << " width=" << txVector.GetChannelWidth ()
+                << " sgi=" << txVector.IsShortGuardInterval ());
+  NS_ASSERT (m_maxSnrDb > m_minSnrDb);
+  uint32_t size = static_cast<uint32_t> ((m_maxSnrDb - m_minSnrDb) / m_snrStepDb) + 2;
+  Table table (size);
+  for (uint32_t i = 0; i < size; i++)
+    {
+      double snr = std::pow (10.0, (m_minSnrDb + i * m_snrStepDb) / 10.0);
+      double ber = 1 - m_model->GetChunkSuccessRate (mode, txVector, snr, 1);
+      double value = LOG_BER_MIN;
+      if (ber > 0)
+        {
+          value = std::max (std::log (ber), LOG_BER_MIN);
+        }
+      table[i] = value;
+    }
+  return m_tables.insert (std::make_pair (key, table)).first->second;
+}
+
+double
+TabulatedErrorRateModel::GetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint32_t nbits) const
+{
+  NS_ASSERT_MSG (m_model != 0, "TabulatedErrorRateModel needs a model to tabulate");
+  if (nbits == 0)
+    {
+      return 1.0;
+    }
+  double snrDb = 10.0 * std::log10 (snr);
+  // The last point of the table is beyond MaxSnr: position + 1 always exists
+  if (!(snrDb >= m_minSnrDb && snrDb < m_maxSnrDb))
+    {
+      return m_model->GetChunkSuccessRate (mode, txVector, snr, nbits);
+    }
+  const Table &table = GetTable (mode, txVector);
+  double position = (snrDb - m_minSnrDb) / m_snrStepDb;
+  uint32_t index = static_cast<uint32_t> (position);
+  double fraction = position - index;
+  if ((table[index] >= 0) != (table[index + 1] >= 0))
+    {
+      /* The wrapped models clamp p to 1 at low SNR: the kink would not
+       * be interpolated accurately, so defer to the exact value.
+       */
+      return m_model->GetChunkSuccessRate (mode, txVector, snr, nbits);
+    }
+  double value = table[index] + fraction * (table[index + 1] - table[index]);
+  if (value <= LOG_BER_MIN)
+    {
+      return 1.0;
+    }
+  return std::pow (1 - std::exp (value), static_cast<double> (nbits));
+}
+
+} //namespace ns3
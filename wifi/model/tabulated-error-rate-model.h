@@ -0,0 +1,101 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TABULATED_ERROR_RATE_MODEL_H
+#define TABULATED_ERROR_RATE_MODEL_H
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+#include "error-rate-model.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * \brief A table-driven front-end to another error rate model.
+ *
+ * The NIST and YANS error rate models compute the success rate of a
+ * chunk as (1 - p)^nbits, where the per-bit error probability p only
+ * depends on the SNR, the mode, the channel width and the guard
+ * interval.  This model evaluates p with the wrapped model once per
+ * point of a regular SNR grid (in dB) for each such combination, the
+ * first time it is used, and stores log (p).  Later queries interpolate
+ * linearly in that logarithmic domain, which is smooth over the many
+ * orders of magnitude spanned by p, and raise 1 - p to the chunk length
+ * in bits.
+ *
+ * SNRs outside of [MinSnr, MaxSnr] are forwarded to the wrapped model,
+ * which must be set through the Model attribute.
+ */
+class TabulatedErrorRateModel : public ErrorRateModel
+{
+public:
+  static TypeId GetTypeId (void);
+
+  TabulatedErrorRateModel ();
+  virtual ~TabulatedErrorRateModel ();
+
+  /**
+   * \param model the error rate model to tabulate
+   */
+  void SetModel (Ptr<ErrorRateModel> model);
+  /**
+   * \return the error rate model which is tabulated
+   */
+  Ptr<ErrorRateModel> GetModel (void) const;
+  /**
+   * Forget all the tables built so far.  They are built again on
+   * demand, e.g. after the SNR grid has been changed.
+   */
+  void Flush (void);
+
+  virtual double GetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint32_t nbits) const;
+
+
+private:
+  virtual void DoDispose (void);
+
+  /**
+   * typedef for a table of log (p) over the SNR grid
+   */
+  typedef std::vector<double> Table;
+  /**
+   * typedef for the tables, keyed by mode, channel width and guard interval
+   */
+  typedef std::map<uint64_t, Table> Tables;
+
+  /**
+   * Return the table for the given mode and TXVECTOR, building it if needed.
+   *
+   * \param mode the Wi-Fi mode
+   * \param txVector the TXVECTOR
+   *
+   * \return the table
+   */
+  const Table & GetTable (WifiMode mode, WifiTxVector txVector) const;
+
+  Ptr<ErrorRateModel> m_model; //!< the tabulated model
+  double m_minSnrDb; //!< lowest SNR (dB) of the grid
+  double m_maxSnrDb; //!< highest SNR (dB) of the grid
+  double m_snrStepDb; //!< spacing (dB) of the grid
+  mutable Tables m_tables; //!< tables built so far
+};
+
+} //namespace ns3
+
+#endif /* TABULATED_ERROR_RATE_MODEL_H */
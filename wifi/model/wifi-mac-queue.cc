@@ -30,12 +30,18 @@ namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED (WifiMacQueue);
 
+/// Key of the sub-queue of the packets which are not QoS data
+static const uint64_t NON_QOS_KEY = 0xffffffffffffffffULL;
+
 WifiMacQueue::Item::Item (Ptr<const Packet> packet,
                           const WifiMacHeader &hdr,
                           Time tstamp)
   : packet (packet),
     hdr (hdr),
-    tstamp (tstamp)
+    tstamp (tstamp),
+    position (0),
+    arrival (0),
+    key (NON_QOS_KEY)
 {
 }
 
@@ -59,7 +65,10 @@ WifiMacQueue::GetTypeId (void)
 }
 
 WifiMacQueue::WifiMacQueue ()
-  : m_size (0)
+  : m_front (-1),
+    m_back (0),
+    m_nArrivals (0),
+    m_size (0)
 {
 }
 
@@ -100,34 +109,82 @@ WifiMacQueue::Enqueue (Ptr<const Packet> packet, const WifiMacHeader &hdr)
     {
       return;
     }
-  Time now = Simulator::Now ();
-  m_queue.push_back (Item (packet, hdr, now));
-  m_size++;
+  Insert (packet, hdr, m_back++, m_queue.end ());
 }
 
 void
-WifiMacQueue::Cleanup (void)
+WifiMacQueue::Insert (Ptr<const Packet> packet, const WifiMacHeader &hdr, int64_t position, PacketQueueI it)
 {
-  if (m_queue.empty ())
+  it = m_queue.insert (it, Item (packet, hdr, Simulator::Now ()));
+  it->position = position;
+  it->arrival = m_nArrivals++;
+  if (hdr.IsQosData ())
     {
-      return;
+      it->key = GetMac48AddressKey (hdr.GetAddr1 (), hdr.GetQosTid ());
     }
+  SubQueue &subQueue = m_subQueues[it->key];
+  if (!subQueue.empty () && subQueue.begin ()->first > position)
+    {
+      m_heads.erase (std::make_pair (subQueue.begin ()->first, it->key));
+    }
+  subQueue.insert (std::make_pair (position, it));
+  if (subQueue.begin ()->first == position)
+    {
+      m_heads.insert (std::make_pair (position, it->key));
+    }
+  m_arrivals.insert (std::make_pair (it->arrival, it));
+  m_packets.insert (std::make_pair (PeekPointer (packet), it));
+  m_size++;
+}
 
-  Time now = Simulator::Now ();
-  uint32_t n = 0;
-  for (PacketQueueI i = m_queue.begin (); i != m_queue.end (); )
+void
+WifiMacQueue::Erase (PacketQueueI it)
+{
+  SubQueues::iterator subQueue = m_subQueues.find (it->key);
+  NS_ASSERT (subQueue != m_subQueues.end ());
+  if (subQueue->second.begin ()->first == it->position)
     {
-      if (i->tstamp + m_maxDelay > now)
+      m_heads.erase (std::make_pair (it->position, it->key));
+      subQueue->second.erase (subQueue->second.begin ());
+      if (subQueue->second.empty ())
         {
-          i++;
+          m_subQueues.erase (subQueue);
         }
       else
         {
-          i = m_queue.erase (i);
-          n++;
+          m_heads.insert (std::make_pair (subQueue->second.begin ()->first, it->key));
+        }
+    }
+  else
+    {
+      subQueue->second.erase (it->position);
+    }
+  m_arrivals.erase (it->arrival);
+  std::pair<std::multimap<const Packet *, PacketQueueI>::iterator,
+            std::multimap<const Packet *, PacketQueueI>::iterator> range;
+  range = m_packets.equal_range (PeekPointer (it->packet));
+  for (std::multimap<const Packet *, PacketQueueI>::iterator i = range.first; i != range.second; i++)
+    {
+      if (i->second == it)
+        {
+          m_packets.erase (i);
+          break;
         }
     }
-  m_size -= n;
+  m_queue.erase (it);
+  m_size--;
+}
+
+void
+WifiMacQueue::Cleanup (void)
+{
+  // The packets arrive in the order of their timestamps
+  Time now = Simulator::Now ();
+  while (!m_arrivals.empty ()
+         && m_arrivals.begin ()->second->tstamp + m_maxDelay <= now)
+    {
+      Erase (m_arrivals.begin ()->second);
+    }
 }
 
 Ptr<const Packet>
@@ -137,8 +194,7 @@ WifiMacQueue::Dequeue (WifiMacHeader *hdr)
   if (!m_queue.empty ())
     {
       Item i = m_queue.front ();
-      m_queue.pop_front ();
-      m_size--;
+      Erase (m_queue.begin ());
       *hdr = i.hdr;
       return i.packet;
     }
@@ -158,31 +214,44 @@ WifiMacQueue::Peek (WifiMacHeader *hdr)
   return 0;
 }
 
+WifiMacQueue::PacketQueueI
+WifiMacQueue::FindByTidAndAddress (uint8_t tid, WifiMacHeader::AddressType type, Mac48Address dest)
+{
+  if (type == WifiMacHeader::ADDR1)
+    {
+      SubQueues::const_iterator subQueue = m_subQueues.find (GetMac48AddressKey (dest, tid));
+      if (subQueue == m_subQueues.end ())
+        {
+          return m_queue.end ();
+        }
+      return subQueue->second.begin ()->second;
+    }
+  PacketQueueI it;
+  for (it = m_queue.begin (); it != m_queue.end (); ++it)
+    {
+      if (it->hdr.IsQosData ()
+          && GetAddressForPacket (type, it) == dest
+          && it->hdr.GetQosTid () == tid)
+        {
+          break;
+        }
+    }
+  return it;
+}
+
 Ptr<const Packet>
 WifiMacQueue::DequeueByTidAndAddress (WifiMacHeader *hdr, uint8_t tid,
                                       WifiMacHeader::AddressType type, Mac48Address dest)
 {
   Cleanup ();
-  Ptr<const Packet> packet = 0;
-  if (!m_queue.empty ())
+  PacketQueueI it = FindByTidAndAddress (tid, type, dest);
+  if (it == m_queue.end ())
     {
-      PacketQueueI it;
-      for (it = m_queue.begin (); it != m_queue.end (); ++it)
-        {
-          if (it->hdr.IsQosData ())
-            {
-              if (GetAddressForPacket (type, it) == dest
-                  && it->hdr.GetQosTid () == tid)
-                {
-                  packet = it->packet;
-                  *hdr = it->hdr;
-                  m_queue.erase (it);
-                  m_size--;
-                  break;
-                }
-            }
-        }
+      return 0;
     }
+  Ptr<const Packet> packet = it->packet;
+  *hdr = it->hdr;
+  Erase (it);
   return packet;
 }
 
@@ -191,24 +260,14 @@ WifiMacQueue::PeekByTidAndAddress (WifiMacHeader *hdr, uint8_t tid,
                                    WifiMacHeader::AddressType type, Mac48Address dest, Time *timestamp)
 {
   Cleanup ();
-  if (!m_queue.empty ())
+  PacketQueueI it = FindByTidAndAddress (tid, type, dest);
+  if (it == m_queue.end ())
     {
-      PacketQueueI it;
-      for (it = m_queue.begin (); it != m_queue.end (); ++it)
-        {
-          if (it->hdr.IsQosData ())
-            {
-              if (GetAddressForPacket (type, it) == dest
-                  && it->hdr.GetQosTid () == tid)
-                {
-                  *hdr = it->hdr;
-                  *timestamp = it->tstamp;
-                  return it->packet;
-                }
-            }
-        }
+      return 0;
     }
-  return 0;
+  *hdr = it->hdr;
+  *timestamp = it->tstamp;
+  return it->packet;
 }
 
 bool
@@ -228,6 +287,10 @@ void
 WifiMacQueue::Flush (void)
 {
   m_queue.erase (m_queue.begin (), m_queue.end ());
+  m_subQueues.clear ();
+  m_heads.clear ();
+  m_arrivals.clear ();
+  m_packets.clear ();
   m_size = 0;
 }
 
@@ -252,17 +315,24 @@ WifiMacQueue::GetAddressForPacket (enum WifiMacHeader::AddressType type, PacketQ
 bool
 WifiMacQueue::Remove (Ptr<const Packet> packet)
 {
-  PacketQueueI it = m_queue.begin ();
-  for (; it != m_queue.end (); it++)
+  // The same packet may be queued twice: remove the first one
+  std::pair<std::multimap<const Packet *, PacketQueueI>::iterator,
+            std::multimap<const Packet *, PacketQueueI>::iterator> range;
+  range = m_packets.equal_range (PeekPointer (packet));
+  if (range.first == range.second)
+    {
+      return false;
+    }
+  PacketQueueI first = range.first->second;
+  for (std::multimap<const Packet *, PacketQueueI>::iterator i = range.first; i != range.second; i++)
     {
-      if (it->packet == packet)
+      if (i->second->position < first->position)
         {
-          m_queue.erase (it);
-          m_size--;
-          return true;
+          first = i->second;
         }
     }
-  return false;
+  Erase (first);
+  return true;
 }
 
 void
@@ -273,9 +343,7 @@ WifiMacQueue::PushFront (Ptr<const Packet> packet, const WifiMacHeader &hdr)
     {
       return;
     }
-  Time now = Simulator::Now ();
-  m_queue.push_front (Item (packet, hdr, now));
-  m_size++;
+  Insert (packet, hdr, m_front--, m_queue.begin ());
 }
 
 uint32_t
@@ -283,43 +351,55 @@ WifiMacQueue::GetNPacketsByTidAndAddress (uint8_t tid, WifiMacHeader::AddressTyp
                                           Mac48Address addr)
 {
   Cleanup ();
+  if (type == WifiMacHeader::ADDR1)
+    {
+      SubQueues::const_iterator subQueue = m_subQueues.find (GetMac48AddressKey (addr, tid));
+      return subQueue == m_subQueues.end () ? 0 : subQueue->second.size ();
+    }
   uint32_t nPackets = 0;
-  if (!m_queue.empty ())
+  for (PacketQueueI it = m_queue.begin (); it != m_queue.end (); it++)
     {
-      PacketQueueI it;
-      for (it = m_queue.begin (); it != m_queue.end (); it++)
+      if (GetAddressForPacket (type, it) == addr)
         {
-          if (GetAddressForPacket (type, it) == addr)
+          if (it->hdr.IsQosData () && it->hdr.GetQosTid () == tid)
             {
-              if (it->hdr.IsQosData () && it->hdr.GetQosTid () == tid)
-                {
-                  nPackets++;
-                }
+              nPackets++;
             }
         }
     }
   return nPackets;
 }
 
-Ptr<const Packet>
-WifiMacQueue::DequeueFirstAvailable (WifiMacHeader *hdr, Time &timestamp,
-                                     const QosBlockedDestinations *blockedPackets)
+WifiMacQueue::PacketQueueI
+WifiMacQueue::FindFirstAvailable (const QosBlockedDestinations *blockedPackets)
 {
-  Cleanup ();
-  Ptr<const Packet> packet = 0;
-  for (PacketQueueI it = m_queue.begin (); it != m_queue.end (); it++)
+  // Only the first packet of each sub-queue may be the first available
+  for (Heads::const_iterator i = m_heads.begin (); i != m_heads.end (); i++)
     {
+      PacketQueueI it = m_subQueues.find (i->second)->second.begin ()->second;
       if (!it->hdr.IsQosData ()
           || !blockedPackets->IsBlocked (it->hdr.GetAddr1 (), it->hdr.GetQosTid ()))
         {
-          *hdr = it->hdr;
-          timestamp = it->tstamp;
-          packet = it->packet;
-          m_queue.erase (it);
-          m_size--;
-          return packet;
+          return it;
         }
     }
+  return m_queue.end ();
+}
+
+Ptr<const Packet>
+WifiMacQueue::DequeueFirstAvailable (WifiMacHeader *hdr, Time &timestamp,
+                                     const QosBlockedDestinations *blockedPackets)
+{
+  Cleanup ();
+  PacketQueueI it = FindFirstAvailable (blockedPackets);
+  if (it == m_queue.end ())
+    {
+      return 0;
+    }
+  Ptr<const Packet> packet = it->packet;
+  *hdr = it->hdr;
+  timestamp = it->tstamp;
+  Erase (it);
   return packet;
 }
 
@@ -328,17 +408,14 @@ WifiMacQueue::PeekFirstAvailable (WifiMacHeader *hdr, Time &timestamp,
                                   const QosBlockedDestinations *blockedPackets)
 {
   Cleanup ();
-  for (PacketQueueI it = m_queue.begin (); it != m_queue.end (); it++)
+  PacketQueueI it = FindFirstAvailable (blockedPackets);
+  if (it == m_queue.end ())
     {
-      if (!it->hdr.IsQosData ()
-          || !blockedPackets->IsBlocked (it->hdr.GetAddr1 (), it->hdr.GetQosTid ()))
-        {
-          *hdr = it->hdr;
-          timestamp = it->tstamp;
-          return it->packet;
-        }
+      return 0;
     }
-  return 0;
+  *hdr = it->hdr;
+  timestamp = it->tstamp;
+  return it->packet;
 }
 
 } //namespace ns3
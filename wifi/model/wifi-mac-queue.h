@@ -24,8 +24,12 @@
 #define WIFI_MAC_QUEUE_H
 
 #include <list>
+#include <map>
+#include <set>
 #include <utility>
 #include "ns3/packet.h"
+#include "ns3/sgi-hashmap.h"
+#include "mac48-address-key.h"
 #include "ns3/nstime.h"
 #include "ns3/object.h"
 #include "wifi-mac-header.h"
@@ -47,6 +51,15 @@ class QosBlockedDestinations;
  * to verify whether or not it should be dropped. If
  * dot11EDCATableMSDULifetime has elapsed, it is dropped.
  * Otherwise, it is returned to the caller.
+ *
+ * The packets are kept in a single FIFO, and are also threaded on a
+ * sub-queue per receiver (Address1) and TID for the QoS data, so that
+ * the lookups of the aggregation and of the block ack agreements for
+ * one receiver and TID do not walk the packets of the others. The first
+ * packet of each sub-queue is indexed by its position in the FIFO, to
+ * skip the blocked receivers quickly, and the packets are indexed by
+ * their arrival time, so that the cleanup only looks at the expired
+ * ones.
  */
 class WifiMacQueue : public Object
 {
@@ -151,7 +164,7 @@ public:
   /**
    * If exists, removes <i>packet</i> from queue and returns true. Otherwise it
    * takes no effects and return false. Deletion of the packet is
-   * performed in linear time (O(n)).
+   * performed in logarithmic time (O(log n)).
    *
    * \param packet the packet to be removed
    *
@@ -243,6 +256,9 @@ protected:
     Ptr<const Packet> packet; //!< Actual packet
     WifiMacHeader hdr;        //!< Wifi MAC header associated with the packet
     Time tstamp;              //!< timestamp when the packet arrived at the queue
+    int64_t position;         //!< position of the packet in the queue
+    uint64_t arrival;         //!< rank of the packet in the order of arrival
+    uint64_t key;             //!< key of the sub-queue of the packet
   };
 
   /**
@@ -267,7 +283,61 @@ protected:
    */
   Mac48Address GetAddressForPacket (enum WifiMacHeader::AddressType type, PacketQueueI it);
 
+  /**
+   * Add a packet to the queue and to its indexes.
+   *
+   * \param packet the packet
+   * \param hdr the header of the packet
+   * \param position the position of the packet in the queue
+   * \param it the element of the queue before which the packet is inserted
+   */
+  void Insert (Ptr<const Packet> packet, const WifiMacHeader &hdr, int64_t position, PacketQueueI it);
+  /**
+   * Remove a packet from the queue and from its indexes.
+   *
+   * \param it the packet
+   */
+  void Erase (PacketQueueI it);
+  /**
+   * Return the first packet of the QoS data for a receiver and TID.
+   *
+   * \param tid the TID
+   * \param type the address type
+   * \param addr the receiver address
+   *
+   * \return the packet, or the end of the queue if there is none
+   */
+  PacketQueueI FindByTidAndAddress (uint8_t tid, WifiMacHeader::AddressType type, Mac48Address addr);
+  /**
+   * Return the first packet which is not blocked.
+   *
+   * \param blockedPackets the receivers and TIDs waiting for a block ack agreement
+   *
+   * \return the packet, or the end of the queue if there is none
+   */
+  PacketQueueI FindFirstAvailable (const QosBlockedDestinations *blockedPackets);
+
+  /**
+   * The packets of a sub-queue, by position
+   */
+  typedef std::map<int64_t, PacketQueueI> SubQueue;
+  /**
+   * The sub-queues, by key
+   */
+  typedef sgi::hash_map<uint64_t, SubQueue, Mac48AddressKeyHash> SubQueues;
+  /**
+   * The first packet of each sub-queue: position and key
+   */
+  typedef std::set<std::pair<int64_t, uint64_t> > Heads;
+
   PacketQueue m_queue; //!< Packet (struct Item) queue
+  SubQueues m_subQueues; //!< Packets by receiver and TID
+  Heads m_heads;       //!< First packet of each sub-queue, in the order of the queue
+  std::map<uint64_t, PacketQueueI> m_arrivals; //!< Packets in their order of arrival
+  std::multimap<const Packet *, PacketQueueI> m_packets; //!< Packets by address
+  int64_t m_front;     //!< Position before the first packet
+  int64_t m_back;      //!< Position after the last packet
+  uint64_t m_nArrivals; //!< Number of packets added so far
   uint32_t m_size;     //!< Current queue size
   uint32_t m_maxSize;  //!< Queue capacity
   Time m_maxDelay;     //!< Time to live for packets in the queue
@@ -24,6 +24,8 @@
 #include <vector>
 #include <utility>
 #include "ns3/mac48-address.h"
+#include "ns3/sgi-hashmap.h"
+#include "mac48-address-key.h"
 #include "ns3/traced-callback.h"
 #include "ns3/packet.h"
 #include "ns3/object.h"
@@ -83,6 +85,11 @@ private:
  * \ingroup wifi
  * \brief hold a list of per-remote-station state.
  *
+ * The states are indexed by address, and the stations by address and
+ * TID, in hash tables, so that finding the station of a frame does not
+ * depend on the number of stations known. The states and stations are
+ * created on their first lookup and are not moved afterwards.
+ *
  * \sa ns3::WifiRemoteStation.
  */
 class WifiRemoteStationManager : public Object
@@ -285,7 +292,6 @@ public:
    */
   WifiMode GetNonUnicastMode (void) const;
 
-
   /**
    * Invoked in an AP upon disassociation of a
    * specific STA.
@@ -313,6 +319,13 @@ public:
    * \param address the address of the station being recorded
    */
   void AddAllSupportedModes (Mac48Address address);
+  /**
+   * Invoked in a STA or AP to store all of the MCS supported
+   * by a destination which is also supported locally.
+   *
+   * \param address the address of the station being recorded
+   */
+  void AddAllSupportedMcs (Mac48Address address);
 
   /**
    * Return whether the station state is brand new.
@@ -1012,6 +1025,15 @@ private:
    */
   typedef std::vector <WifiRemoteStationState *> StationStates;
 
+  /**
+   * The states of the stations, by address
+   */
+  typedef sgi::hash_map<uint64_t, WifiRemoteStationState *, Mac48AddressKeyHash> StationStateIndex;
+  /**
+   * The stations, by address and TID
+   */
+  typedef sgi::hash_map<uint64_t, WifiRemoteStation *, Mac48AddressKeyHash> StationIndex;
+
   /**
    * This is a pointer to the WifiPhy associated with this
    * WifiRemoteStationManager that is set on call to
@@ -1043,6 +1065,8 @@ private:
 
   StationStates m_states;  //!< States of known stations
   Stations m_stations;     //!< Information for each known stations
+  StationStateIndex m_stateIndex; //!< States of known stations, by address
+  StationIndex m_stationIndex;    //!< Information for each known stations, by address and TID
 
   WifiMode m_defaultTxMode; //!< The default transmission mode
   WifiMode m_defaultTxMcs;   //!< The default transmission modulation-coding scheme (MCS)
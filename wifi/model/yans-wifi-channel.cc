@@ -25,10 +25,14 @@
 #include "ns3/node.h"
 #include "ns3/log.h"
 #include "ns3/pointer.h"
+#include "ns3/boolean.h"
 #include "ns3/object-factory.h"
 #include "yans-wifi-channel.h"
 #include "ns3/propagation-loss-model.h"
 #include "ns3/propagation-delay-model.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 
 namespace ns3 {
 
@@ -51,11 +55,18 @@ YansWifiChannel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&YansWifiChannel::m_delay),
                    MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("AdjacentChannelInterference",
+                   "Whether the transmissions are seen as interference by the PHYs on the "
+                   "other channels whose band overlaps the transmit spectral mask.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&YansWifiChannel::m_adjacentChannelInterference),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
 
 YansWifiChannel::YansWifiChannel ()
+  : m_adjacentChannelInterference (false)
 {
 }
 
@@ -63,6 +74,7 @@ YansWifiChannel::~YansWifiChannel ()
 {
   NS_LOG_FUNCTION_NOARGS ();
   m_phyList.clear ();
+  m_channelPhyLists.clear ();
 }
 
 void
@@ -83,45 +95,99 @@ YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
 {
   Ptr<MobilityModel> senderMobility = sender->GetMobility ()->GetObject<MobilityModel> ();
   NS_ASSERT (senderMobility != 0);
-  uint32_t j = 0;
-  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++, j++)
+  // Gather the receivers first so that the loss and delay models can
+  // process all of them in a single pass.
+  m_receivers.Clear ();
+  m_rxIndex.clear ();
+  m_rxRejectionDb.clear ();
+  uint16_t channelNumber = sender->GetChannelNumber ();
+  ChannelPhyLists::const_iterator channel = m_channelPhyLists.find (channelNumber);
+  if (channel != m_channelPhyLists.end ())
     {
-      if (sender != (*i))
+      for (PhyIndexList::const_iterator i = channel->second.begin (); i != channel->second.end (); i++)
         {
-          //For now don't account for inter channel interference
-          if ((*i)->GetChannelNumber () != sender->GetChannelNumber ())
+          if (sender != m_phyList[*i])
             {
-              continue;
+              m_receivers.Add (m_phyList[*i]->GetMobility ()->GetObject<MobilityModel> ());
+              m_rxIndex.push_back (*i);
             }
-
-          Ptr<MobilityModel> receiverMobility = (*i)->GetMobility ()->GetObject<MobilityModel> ();
-          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
-          double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
-          NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
-                        "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
-          Ptr<Packet> copy = packet->Copy ();
-          Ptr<Object> dstNetDevice = m_phyList[j]->GetDevice ();
-          uint32_t dstNode;
-          if (dstNetDevice == 0)
+        }
+    }
+  uint32_t nCoChannel = m_receivers.GetN ();
+  if (m_adjacentChannelInterference)
+    {
+      int32_t txFrequency = static_cast<int32_t> (sender->GetChannelFrequencyMhz ());
+      uint32_t txWidth = sender->GetChannelWidth ();
+      for (channel = m_channelPhyLists.begin (); channel != m_channelPhyLists.end (); channel++)
+        {
+          if (channel->first == channelNumber)
             {
-              dstNode = 0xffffffff;
+              continue;
             }
-          else
+          for (PhyIndexList::const_iterator i = channel->second.begin (); i != channel->second.end (); i++)
             {
-              dstNode = dstNetDevice->GetObject<NetDevice> ()->GetNode ()->GetId ();
+              Ptr<YansWifiPhy> phy = m_phyList[*i];
+              double rejectionDb;
+              if (GetAdjacentChannelRejection (static_cast<int32_t> (phy->GetChannelFrequencyMhz ()) - txFrequency,
+                                               txWidth, phy->GetChannelWidth (), &rejectionDb))
+                {
+                  m_receivers.Add (phy->GetMobility ()->GetObject<MobilityModel> ());
+                  m_rxIndex.push_back (*i);
+                  m_rxRejectionDb.push_back (rejectionDb);
+                }
             }
+        }
+    }
+  uint32_t n = m_receivers.GetN ();
+  if (n == 0)
+    {
+      return;
+    }
+  m_rxPowerDbm.resize (n);
+  m_rxDelay.resize (n);
+  m_loss->CalcRxPowerBatch (txPowerDbm, senderMobility, m_receivers, &m_rxPowerDbm[0]);
+  m_delay->GetDelayBatch (senderMobility, m_receivers, &m_rxDelay[0]);
 
-          struct Parameters parameters;
-          parameters.rxPowerDbm = rxPowerDbm;
-          parameters.aMpdu = aMpdu;
-          parameters.duration = duration;
-          parameters.txVector = txVector;
-          parameters.preamble = preamble;
+  uint32_t j;
+  for (uint32_t k = 0; k < n; k++)
+    {
+      j = m_rxIndex[k];
+      double rxPowerDbm = m_rxPowerDbm[k];
+      Time delay = m_rxDelay[k];
+      NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
+                    "distance=" << senderMobility->GetDistanceFrom (m_receivers.Get (k)) << "m, delay=" << delay);
+      Ptr<Object> dstNetDevice = m_phyList[j]->GetDevice ();
+      uint32_t dstNode;
+      if (dstNetDevice == 0)
+        {
+          dstNode = 0xffffffff;
+        }
+      else
+        {
+          dstNode = dstNetDevice->GetObject<NetDevice> ()->GetNode ()->GetId ();
+        }
 
+      if (k >= nCoChannel)
+        {
+          rxPowerDbm += m_rxRejectionDb[k - nCoChannel];
+          NS_LOG_DEBUG ("adjacent channel: rxPower=" << rxPowerDbm << "dbm");
           Simulator::ScheduleWithContext (dstNode,
-                                          delay, &YansWifiChannel::Receive, this,
-                                          j, copy, parameters);
+                                          delay, &YansWifiChannel::ReceiveInterference, this,
+                                          j, rxPowerDbm, duration);
+          continue;
         }
+
+      Ptr<Packet> copy = packet->Copy ();
+      struct Parameters parameters;
+      parameters.rxPowerDbm = rxPowerDbm;
+      parameters.aMpdu = aMpdu;
+      parameters.duration = duration;
+      parameters.txVector = txVector;
+      parameters.preamble = preamble;
+
+      Simulator::ScheduleWithContext (dstNode,
+                                      delay, &YansWifiChannel::Receive, this,
+                                      j, copy, parameters);
     }
 }
 
@@ -131,6 +197,59 @@ YansWifiChannel::Receive (uint32_t i, Ptr<Packet> packet, struct Parameters para
   m_phyList[i]->StartReceivePreambleAndHeader (packet, parameters.rxPowerDbm, parameters.txVector, parameters.preamble, parameters.aMpdu, parameters.duration);
 }
 
+void
+YansWifiChannel::ReceiveInterference (uint32_t i, double rxPowerDbm, Time duration) const
+{
+  m_phyList[i]->StartReceiveInterference (rxPowerDbm, duration);
+}
+
+bool
+YansWifiChannel::GetAdjacentChannelRejection (int32_t deltaMhz, uint32_t txWidth, uint32_t rxWidth,
+                                              double *rejectionDb) const
+{
+  //the transmit spectral mask is symmetric
+  uint32_t delta = std::abs (deltaMhz);
+  uint64_t key = (static_cast<uint64_t> (delta) << 32) | (txWidth << 16) | rxWidth;
+  std::map<uint64_t, double>::const_iterator it = m_rejections.find (key);
+  if (it == m_rejections.end ())
+    {
+      //Transmit spectral mask of 802.11 OFDM (e.g. 18.3.9.3 in IEEE
+      //802.11-2012), in dB relative to the maximum spectral density, as a
+      //function of the distance to the center frequency: 0 dBr up to
+      //W/2 - 1 MHz, -20 dBr at W/2 + 1 MHz, -28 dBr at W and -40 dBr at
+      //3W/2, W being the channel width, and nothing beyond. The rejection
+      //is the share of the transmitted power which falls in the band of
+      //the receiver; a positive value means that there is none.
+      double width = txWidth;
+      double maskFrequency[5] = {0, width / 2 - 1, width / 2 + 1, width, 3 * width / 2};
+      double maskDbr[5] = {0, 0, -20, -28, -40};
+      double step = 0.25;
+      double total = 0;
+      double received = 0;
+      for (double f = -3 * width / 2 + step / 2; f < 3 * width / 2; f += step)
+        {
+          double distance = std::abs (f);
+          uint32_t s = 1;
+          while (maskFrequency[s] < distance)
+            {
+              s++;
+            }
+          double dbr = maskDbr[s - 1] + (maskDbr[s] - maskDbr[s - 1])
+            * (distance - maskFrequency[s - 1]) / (maskFrequency[s] - maskFrequency[s - 1]);
+          double density = std::pow (10.0, dbr / 10.0);
+          total += density;
+          if (std::abs (f - delta) < rxWidth / 2.0)
+            {
+              received += density;
+            }
+        }
+      double rejection = received > 0 ? 10 * std::log10 (received / total) : 1;
+      it = m_rejections.insert (std::make_pair (key, rejection)).first;
+    }
+  *rejectionDb = it->second;
+  return it->second <= 0;
+}
+
 uint32_t
 YansWifiChannel::GetNDevices (void) const
 {
@@ -146,9 +265,31 @@ YansWifiChannel::GetDevice (uint32_t i) const
 void
 YansWifiChannel::Add (Ptr<YansWifiPhy> phy)
 {
+  m_channelPhyLists[phy->GetChannelNumber ()].push_back (m_phyList.size ());
   m_phyList.push_back (phy);
 }
 
+void
+YansWifiChannel::UpdateChannelNumber (Ptr<YansWifiPhy> phy, uint16_t previous)
+{
+  PhyIndexList &previousList = m_channelPhyLists[previous];
+  for (PhyIndexList::iterator i = previousList.begin (); i != previousList.end (); i++)
+    {
+      if (m_phyList[*i] == phy)
+        {
+          uint32_t index = *i;
+          previousList.erase (i);
+          if (previousList.empty ())
+            {
+              m_channelPhyLists.erase (previous);
+            }
+          PhyIndexList &list = m_channelPhyLists[phy->GetChannelNumber ()];
+          list.insert (std::lower_bound (list.begin (), list.end (), index), index);
+          return;
+        }
+    }
+}
+
 int64_t
 YansWifiChannel::AssignStreams (int64_t stream)
 {
@@ -22,6 +22,7 @@
 #define YANS_WIFI_CHANNEL_H
 
 #include <vector>
+#include <map>
 #include <stdint.h>
 #include "ns3/packet.h"
 #include "wifi-channel.h"
@@ -30,6 +31,7 @@
 #include "wifi-tx-vector.h"
 #include "yans-wifi-phy.h"
 #include "ns3/nstime.h"
+#include "ns3/propagation-batch.h"
 
 namespace ns3 {
 
@@ -57,6 +59,14 @@ struct Parameters
  * class and contains a ns3::PropagationLossModel and a ns3::PropagationDelayModel.
  * By default, no propagation models are set so, it is the caller's responsability
  * to set them before using the channel.
+ *
+ * The PHYs are also kept in one list per channel number, so that a
+ * transmission only visits the PHYs on the channel of the sender. When
+ * the AdjacentChannelInterference attribute is set, the transmission
+ * also reaches the PHYs on the other channels whose band overlaps the
+ * transmit spectral mask of 802.11 OFDM, as interference only: their
+ * receive power is reduced by the share of the transmitted power which
+ * falls in their band.
  */
 class YansWifiChannel : public WifiChannel
 {
@@ -76,6 +86,14 @@ public:
    * \param phy the YansWifiPhy to be added to the PHY list
    */
   void Add (Ptr<YansWifiPhy> phy);
+  /**
+   * Move the given YansWifiPhy to the list of its new channel number.
+   * This is invoked by YansWifiPhy::SetChannelNumber.
+   *
+   * \param phy the YansWifiPhy whose channel number changed
+   * \param previous the previous channel number of the YansWifiPhy
+   */
+  void UpdateChannelNumber (Ptr<YansWifiPhy> phy, uint16_t previous);
 
   /**
    * \param loss the new propagation loss model.
@@ -99,7 +117,8 @@ public:
    * This method should not be invoked by normal users. It is
    * currently invoked only from WifiPhy::Send. YansWifiChannel
    * delivers packets only between PHYs with the same m_channelNumber,
-   * e.g. PHYs that are operating on the same channel.
+   * e.g. PHYs that are operating on the same channel; the PHYs on
+   * adjacent channels only see them as interference, if enabled.
    */
   void Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double txPowerDbm,
              WifiTxVector txVector, WifiPreamble preamble, struct mpduInfo aMpdu, Time duration) const;
@@ -134,10 +153,52 @@ private:
    * \param preamble the type of preamble being used to send the packet
    */
   void Receive (uint32_t i, Ptr<Packet> packet, struct Parameters parameters) const;
+  /**
+   * This method is scheduled by Send for each YansWifiPhy on an adjacent
+   * channel, which only sees the transmission as interference.
+   *
+   * \param i index of the corresponding YansWifiPhy in the PHY list
+   * \param rxPowerDbm the received power in dBm, adjacent channel rejection included
+   * \param duration the transmission duration
+   */
+  void ReceiveInterference (uint32_t i, double rxPowerDbm, Time duration) const;
+  /**
+   * \param deltaMhz the distance between the center frequencies of the
+   *        transmitter and of the receiver, in MHz
+   * \param txWidth the channel width of the transmitter, in MHz
+   * \param rxWidth the channel width of the receiver, in MHz
+   * \param rejectionDb the share of the transmitted power received in the
+   *        band of the receiver, in dB
+   *
+   * \return false if the band of the receiver is out of the transmit
+   *         spectral mask, true otherwise
+   */
+  bool GetAdjacentChannelRejection (int32_t deltaMhz, uint32_t txWidth, uint32_t rxWidth,
+                                    double *rejectionDb) const;
+
+  /**
+   * The indexes in the PHY list of the PHYs on a channel, in increasing order.
+   */
+  typedef std::vector<uint32_t> PhyIndexList;
+  /**
+   * The PHYs of each channel number.
+   */
+  typedef std::map<uint16_t, PhyIndexList> ChannelPhyLists;
 
   PhyList m_phyList;                   //!< List of YansWifiPhys connected to this YansWifiChannel
+  ChannelPhyLists m_channelPhyLists;   //!< The PHY list indexes of the YansWifiPhys of each channel
   Ptr<PropagationLossModel> m_loss;    //!< Propagation loss model
   Ptr<PropagationDelayModel> m_delay;  //!< Propagation delay model
+  bool m_adjacentChannelInterference;  //!< Whether the PHYs on adjacent channels see the transmissions
+
+  /// adjacent channel rejections, keyed on frequency distance and channel widths
+  mutable std::map<uint64_t, double> m_rejections;
+
+  mutable PropagationBatch m_receivers;      //!< receivers of the current transmission
+  mutable std::vector<uint32_t> m_rxIndex;   //!< PHY list index of each receiver
+  mutable std::vector<double> m_rxPowerDbm;  //!< rx power at each receiver
+  mutable std::vector<Time> m_rxDelay;       //!< propagation delay to each receiver
+  mutable std::vector<double> m_rxRejectionDb;  //!< adjacent channel rejection of each receiver
 };
 
 } //namespace ns3
@@ -424,7 +424,12 @@ YansWifiPhy::SetChannelNumber (uint16_t nch)
     {
       //this is not channel switch, this is initialization
       NS_LOG_DEBUG ("start at channel " << nch);
+      uint16_t previous = m_channelNumber;
       m_channelNumber = nch;
+      if (m_channel != 0)
+        {
+          m_channel->UpdateChannelNumber (this, previous);
+        }
       return;
     }
 
@@ -467,7 +472,12 @@ switchChannel:
    * state are added to the event list and are employed later to figure
    * out the state of the medium after the switching.
    */
+  uint16_t previous = m_channelNumber;
   m_channelNumber = nch;
+  if (m_channel != 0)
+    {
+      m_channel->UpdateChannelNumber (this, previous);
+    }
 }
 
 uint16_t
@@ -717,6 +727,36 @@ maybeCcaBusy:
     }
 }
 
+void
+YansWifiPhy::StartReceiveInterference (double rxPowerDbm, Time rxDuration)
+{
+  NS_LOG_FUNCTION (this << rxPowerDbm << rxDuration);
+  rxPowerDbm += m_rxGainDb;
+  m_interference.AddForeignSignal (rxDuration, DbmToW (rxPowerDbm));
+  switch (m_state->GetState ())
+    {
+    case YansWifiPhy::SLEEP:
+      return;
+    case YansWifiPhy::SWITCHING:
+    case YansWifiPhy::RX:
+    case YansWifiPhy::TX:
+      if (rxDuration <= m_state->GetDelayUntilIdle ())
+        {
+          //the signal ends before the current state, and is never sensed
+          return;
+        }
+      break;
+    case YansWifiPhy::CCA_BUSY:
+    case YansWifiPhy::IDLE:
+      break;
+    }
+  Time delayUntilCcaEnd = m_interference.GetEnergyDuration (m_ccaMode1ThresholdW);
+  if (!delayUntilCcaEnd.IsZero ())
+    {
+      m_state->SwitchMaybeToCcaBusy (delayUntilCcaEnd);
+    }
+}
+
 void
 YansWifiPhy::StartReceivePacket (Ptr<Packet> packet,
                                  WifiTxVector txVector,
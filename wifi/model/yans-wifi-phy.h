@@ -117,6 +117,16 @@ public:
                                       WifiPreamble preamble,
                                       struct mpduInfo aMpdu,
                                       Time rxDuration);
+  /**
+   * The first bit of a transmission on an adjacent channel has arrived.
+   * It cannot be received, and only adds to the interference and to the
+   * energy sensed on the medium. During a transmission, a reception or a
+   * channel switching, it is reported as CCA busy only if it outlasts them.
+   *
+   * \param rxPowerDbm the receive power in dBm, adjacent channel rejection included
+   * \param rxDuration the duration of the transmission
+   */
+  void StartReceiveInterference (double rxPowerDbm, Time rxDuration);
   /**
    * Starting receiving the payload of a packet (i.e. the first bit of the packet has arrived).
    *
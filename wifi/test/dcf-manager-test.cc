@@ -99,6 +99,11 @@ private:
   void AddCcaBusyEvt (uint64_t at, uint64_t duration);
   void AddSwitchingEvt (uint64_t at, uint64_t duration);
   void AddRxStartEvt (uint64_t at, uint64_t duration);
+  ///\param at time to check the number of access timeouts
+  ///\param scheduled the number of access timeouts scheduled expected
+  ///\param useful the number of access timeouts which granted the access expected
+  void ExpectAccessTimeouts (uint64_t at, uint64_t scheduled, uint64_t useful);
+  void DoCheckAccessTimeouts (uint64_t scheduled, uint64_t useful);
 
   typedef std::vector<DcfStateTest *> DcfStates;
 
@@ -377,6 +382,21 @@ DcfManagerTest::AddRxStartEvt (uint64_t at, uint64_t duration)
                        MicroSeconds (duration));
 }
 
+void
+DcfManagerTest::ExpectAccessTimeouts (uint64_t at, uint64_t scheduled, uint64_t useful)
+{
+  Simulator::Schedule (MicroSeconds (at) - Now (),
+                       &DcfManagerTest::DoCheckAccessTimeouts, this,
+                       scheduled, useful);
+}
+
+void
+DcfManagerTest::DoCheckAccessTimeouts (uint64_t scheduled, uint64_t useful)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_dcfManager->GetScheduledAccessTimeouts (), scheduled, "Unexpected number of access timeouts scheduled");
+  NS_TEST_EXPECT_MSG_EQ (m_dcfManager->GetUsefulAccessTimeouts (), useful, "Unexpected number of useful access timeouts");
+}
+
 void
 DcfManagerTest::DoRun (void)
 {
@@ -690,6 +710,47 @@ DcfManagerTest::DoRun (void)
   AddSwitchingEvt (80,20);
   AddAccessRequest (101, 2, 110, 0);
   EndTest ();
+
+  // Check that the access timeout is not rescheduled while a frame is
+  // received, but only once the end of the reception, and so the EIFS,
+  // is known. The access timeout scheduled at 30 for 86 expires during
+  // the second reception and a single access timeout is scheduled at
+  // 100 for 134, which grants the access.
+  //
+  //  20          60     66      70        74        78  80   100    106    122     126      130      134
+  //   |    rx     | sifs | aifsn | bslot0  | bslot1  |   | rx  | sifs | eifs  | aifsn | bslot2 | bslot3 | tx |
+  //        |                                                   error
+  //       30 request access. backoff slots: 4
+  //
+  StartTest (4, 6, 10);
+  AddDcfState (1);
+  AddRxOkEvt (20, 40);
+  AddRxErrorEvt (80, 20);
+  AddAccessRequest (30, 2, 134, 0);
+  ExpectCollision (30, 4, 0); //backoff: 4 slots
+  ExpectAccessTimeouts (135, 2, 1);
+  EndTest ();
+
+  // Check that the access timeout is not rescheduled when the end of
+  // backoff moves later, but only when it moves earlier. The access
+  // timeout scheduled at 60 for 86 is kept when the NAV starts, and
+  // moves itself to 126 when it expires. The NAV reset at 90 moves it
+  // to 116, which grants the access.
+  //
+  //  20          60     66      70   86 90     96      100       104       108       112       116
+  //   |    rx     |  nav                 | sifs | aifsn | bslot0  | bslot1  | bslot2  | bslot3  | tx |
+  //        |
+  //       30 request access. backoff slots: 4
+  //
+  StartTest (4, 6, 10);
+  AddDcfState (1);
+  AddRxOkEvt (20, 40);
+  AddNavStart (60, 40);
+  AddNavReset (90, 0);
+  AddAccessRequest (30, 2, 116, 0);
+  ExpectCollision (30, 4, 0); //backoff: 4 slots
+  ExpectAccessTimeouts (117, 3, 1);
+  EndTest ();
 }
 
 
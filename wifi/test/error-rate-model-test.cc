@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/pointer.h"
+#include "ns3/object-factory.h"
+#include "ns3/wifi-phy.h"
+#include "ns3/tabulated-error-rate-model.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("ErrorRateModelTest");
+
+/**
+ * Compare the chunk success rates returned by TabulatedErrorRateModel
+ * with the ones of the model it tabulates, over a range of SNRs, modes
+ * and chunk lengths.
+ */
+class TabulatedErrorRateModelTest : public TestCase
+{
+public:
+  /**
+   * \param model the TypeId name of the exact error rate model
+   */
+  TabulatedErrorRateModelTest (std::string model);
+  virtual void DoRun (void);
+
+
+private:
+  /**
+   * Check all the chunk lengths and SNRs for one mode.
+   *
+   * \param mode the Wi-Fi mode
+   * \param channelWidth the channel width (MHz)
+   */
+  void CheckMode (WifiMode mode, uint32_t channelWidth);
+
+  ObjectFactory m_factory;
+  Ptr<ErrorRateModel> m_exact;
+  Ptr<TabulatedErrorRateModel> m_tabulated;
+};
+
+TabulatedErrorRateModelTest::TabulatedErrorRateModelTest (std::string model)
+  : TestCase ("Check TabulatedErrorRateModel against " + model)
+{
+  m_factory.SetTypeId (model);
+}
+
+void
+TabulatedErrorRateModelTest::CheckMode (WifiMode mode, uint32_t channelWidth)
+{
+  static const uint32_t nbits[] = { 1, 24, 224, 1500 * 8, 65535 * 8 };
+  WifiTxVector txVector;
+  txVector.SetMode (mode);
+  txVector.SetChannelWidth (channelWidth);
+  for (uint32_t i = 0; i < sizeof (nbits) / sizeof (nbits[0]); i++)
+    {
+      for (double snrDb = -15.0; snrDb < 65.0; snrDb += 0.137)
+        {
+          double snr = std::pow (10.0, snrDb / 10.0);
+          double exact = m_exact->GetChunkSuccessRate (mode, txVector, snr, nbits[i]);
+          double tabulated = m_tabulated->GetChunkSuccessRate (mode, txVector, snr, nbits[i]);
+          NS_TEST_EXPECT_MSG_EQ_TOL (tabulated, exact, 1e-4, "mode=" << mode << " snr=" << snrDb << "dB nbits=" << nbits[i]);
+        }
+    }
+}
+
+void
+TabulatedErrorRateModelTest::DoRun (void)
+{
+  m_exact = m_factory.Create<ErrorRateModel> ();
+  m_tabulated = CreateObject<TabulatedErrorRateModel> ();
+  m_tabulated->SetAttribute ("Model", PointerValue (m_exact));
+
+  CheckMode (WifiPhy::GetDsssRate1Mbps (), 22);
+  CheckMode (WifiPhy::GetDsssRate11Mbps (), 22);
+  CheckMode (WifiPhy::GetOfdmRate6Mbps (), 20);
+  CheckMode (WifiPhy::GetOfdmRate12Mbps (), 20);
+  CheckMode (WifiPhy::GetOfdmRate24Mbps (), 20);
+  CheckMode (WifiPhy::GetOfdmRate36Mbps (), 20);
+  CheckMode (WifiPhy::GetOfdmRate54Mbps (), 20);
+  CheckMode (WifiPhy::GetOfdmRate6MbpsBW10MHz (), 10);
+  CheckMode (WifiPhy::GetHtMcs7 (), 40);
+  CheckMode (WifiPhy::GetVhtMcs8 (), 80);
+
+  m_tabulated->Dispose ();
+  m_tabulated = 0;
+  m_exact = 0;
+}
+
+class ErrorRateModelTestSuite : public TestSuite
+{
+public:
+  ErrorRateModelTestSuite ();
+};
+
+ErrorRateModelTestSuite::ErrorRateModelTestSuite ()
+  : TestSuite ("wifi-error-rate-models", UNIT)
+{
+  AddTestCase (new TabulatedErrorRateModelTest ("ns3::NistErrorRateModel"), TestCase::QUICK);
+  AddTestCase (new TabulatedErrorRateModelTest ("ns3::YansErrorRateModel"), TestCase::QUICK);
+}
+
+static ErrorRateModelTestSuite g_errorRateModelTestSuite;
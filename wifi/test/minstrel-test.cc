@@ -0,0 +1,276 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/packet.h"
+#include "ns3/yans-wifi-phy.h"
+#include "ns3/adhoc-wifi-mac.h"
+#include "ns3/minstrel-wifi-manager.h"
+#include "ns3/minstrel-ht-wifi-manager.h"
+
+using namespace ns3;
+
+//-----------------------------------------------------------------------------
+// Update of the statistics of a Minstrel rate table
+//-----------------------------------------------------------------------------
+class MinstrelRateTest : public TestCase
+{
+public:
+  MinstrelRateTest ();
+  virtual void DoRun (void);
+};
+
+MinstrelRateTest::MinstrelRateTest ()
+  : TestCase ("Check the update of the statistics of a Minstrel rate table")
+{
+}
+
+void
+MinstrelRateTest::DoRun (void)
+{
+  MinstrelRate table;
+  table.Resize (4);
+  NS_TEST_ASSERT_MSG_EQ (table.GetNRates (), 4, "Bad number of rates");
+  table.SetPerfectTxTime (0, MicroSeconds (2000));
+  table.SetPerfectTxTime (1, MicroSeconds (1000));
+  table.SetPerfectTxTime (2, MicroSeconds (500));
+  table.SetPerfectTxTime (3, MicroSeconds (0));
+  NS_TEST_ASSERT_MSG_EQ (table.throughputFactor[0], 500, "Bad throughput factor");
+  NS_TEST_ASSERT_MSG_EQ (table.throughputFactor[3], 1, "Bad throughput factor of an unknown tx time");
+  uint32_t retries[] = { 5, 5, 5, 0 };
+  uint32_t attempts[] = { 10, 10, 10, 0 };
+  uint32_t successes[] = { 10, 8, 1, 0 };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      table.retryCount[i] = retries[i];
+      table.numRateAttempt[i] = attempts[i];
+      table.numRateSuccess[i] = successes[i];
+    }
+
+  table.UpdateStats (75);
+  uint32_t probs[] = { 18000, 14400, 1800, 0 };
+  uint32_t ewmaProbs[] = { 4500, 3600, 450, 0 };
+  uint32_t throughputs[] = { 2250000, 3600000, 900000, 0 };
+  // rarely successful rates are retried at most twice, and all the rates at least once
+  uint32_t adjustedRetries[] = { 5, 5, 2, 1 };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (table.prob[i], probs[i], "Bad probability of rate " << i);
+      NS_TEST_EXPECT_MSG_EQ (table.ewmaProb[i], ewmaProbs[i], "Bad EWMA probability of rate " << i);
+      NS_TEST_EXPECT_MSG_EQ (table.throughput[i], throughputs[i], "Bad throughput of rate " << i);
+      NS_TEST_EXPECT_MSG_EQ (table.adjustedRetryCount[i], adjustedRetries[i], "Bad adjusted retry count of rate " << i);
+      NS_TEST_EXPECT_MSG_EQ (table.numRateAttempt[i], 0, "Attempts not reset for rate " << i);
+      NS_TEST_EXPECT_MSG_EQ (table.numRateSuccess[i], 0, "Successes not reset for rate " << i);
+    }
+  uint32_t maxTp, maxTp2, maxProb;
+  table.FindBestRates (&maxTp, &maxTp2, &maxProb);
+  NS_TEST_EXPECT_MSG_EQ (maxTp, 1, "Bad maximum throughput rate");
+  NS_TEST_EXPECT_MSG_EQ (maxTp2, 0, "Bad second maximum throughput rate");
+  NS_TEST_EXPECT_MSG_EQ (maxProb, 0, "Bad maximum probability rate");
+
+  // the statistics of the rates not attempted since the last update are kept
+  table.numRateAttempt[1] = 10;
+  table.numRateSuccess[1] = 0;
+  table.UpdateStats (75);
+  NS_TEST_EXPECT_MSG_EQ (table.ewmaProb[0], 4500, "EWMA probability of a rate not attempted changed");
+  NS_TEST_EXPECT_MSG_EQ (table.ewmaProb[1], 2700, "Bad EWMA probability");
+  NS_TEST_EXPECT_MSG_EQ (table.throughput[1], 2700000, "Bad throughput");
+  table.FindBestRates (&maxTp, &maxTp2, &maxProb);
+  NS_TEST_EXPECT_MSG_EQ (maxTp, 1, "Bad maximum throughput rate");
+  NS_TEST_EXPECT_MSG_EQ (maxTp2, 0, "Bad second maximum throughput rate");
+}
+
+//-----------------------------------------------------------------------------
+// Convergence of Minstrel-HT on a link where only the lowest rates work
+//-----------------------------------------------------------------------------
+class MinstrelHtTest : public TestCase
+{
+public:
+  MinstrelHtTest ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Send frames to a station every millisecond, as A-MPDUs whose MPDUs
+   * are reported one by one, or as single frames retried until they
+   * are acknowledged or dropped, and check the rate chosen once Minstrel-HT
+   * converged.
+   *
+   * \param ht whether the station supports HT
+   * \param nMpdus the number of MPDUs of the A-MPDUs, or 0 for single frames
+   * \param expected the mode expected
+   */
+  void RunScenario (bool ht, uint32_t nMpdus, WifiMode expected);
+  /// Send a frame or an A-MPDU
+  void Send (uint32_t nMpdus);
+  /**
+   * \param txVector the TXVECTOR of a MPDU
+   * \returns whether the MPDU is received
+   */
+  bool IsReceived (WifiTxVector txVector) const;
+
+  Ptr<WifiRemoteStationManager> m_manager; //!< the manager tested
+  Mac48Address m_address; //!< the address of the station
+  uint32_t m_nTx; //!< the number of transmissions after the convergence
+  uint32_t m_nExpected; //!< the number of those at the expected rate
+  WifiTxVector m_last; //!< the TXVECTOR of the last transmission
+  WifiMode m_expected; //!< the mode expected
+};
+
+MinstrelHtTest::MinstrelHtTest ()
+  : TestCase ("Check that Minstrel-HT finds the best rate of HT and legacy stations")
+{
+}
+
+bool
+MinstrelHtTest::IsReceived (WifiTxVector txVector) const
+{
+  //the MCSs up to 4, or the legacy rates up to 24 Mbit/s, work whatever
+  //the channel width and the guard interval
+  if (txVector.GetMode ().GetModulationClass () == WIFI_MOD_CLASS_HT)
+    {
+      return txVector.GetMode ().GetMcsValue () <= 4;
+    }
+  return txVector.GetMode ().GetDataRate (20, false, 1) <= 24000000;
+}
+
+void
+MinstrelHtTest::Send (uint32_t nMpdus)
+{
+  WifiMacHeader header;
+  header.SetType (WIFI_MAC_QOSDATA);
+  header.SetQosTid (0);
+  header.SetAddr1 (m_address);
+  Ptr<Packet> packet = Create<Packet> (1000);
+  uint32_t size = packet->GetSize () + header.GetSize () + 4;
+  WifiMode ackMode = WifiPhy::GetOfdmRate6Mbps ();
+  bool count = Simulator::Now () > Seconds (2);
+  while (true)
+    {
+      m_last = m_manager->GetDataTxVector (m_address, &header, packet, size);
+      if (count)
+        {
+          m_nTx++;
+          m_nExpected += (m_last.GetMode () == m_expected);
+        }
+      bool received = IsReceived (m_last);
+      if (nMpdus > 0)
+        {
+          //the block ack reports the MPDUs one by one
+          for (uint32_t i = 0; i < nMpdus; i++)
+            {
+              if (received)
+                {
+                  m_manager->ReportDataOk (m_address, &header, 20, ackMode, 20);
+                }
+              else
+                {
+                  m_manager->ReportDataFailed (m_address, &header);
+                }
+            }
+          return;
+        }
+      if (received)
+        {
+          m_manager->ReportDataOk (m_address, &header, 20, ackMode, 20);
+          return;
+        }
+      m_manager->ReportDataFailed (m_address, &header);
+      if (!m_manager->NeedDataRetransmission (m_address, &header, packet))
+        {
+          m_manager->ReportFinalDataFailed (m_address, &header);
+          return;
+        }
+    }
+}
+
+void
+MinstrelHtTest::RunScenario (bool ht, uint32_t nMpdus, WifiMode expected)
+{
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  phy->ConfigureStandard (WIFI_PHY_STANDARD_80211n_5GHZ);
+  phy->SetAttribute ("ChannelWidth", UintegerValue (40));
+  phy->SetAttribute ("ShortGuardEnabled", BooleanValue (true));
+  Ptr<AdhocWifiMac> mac = CreateObject<AdhocWifiMac> ();
+  mac->SetAttribute ("HtSupported", BooleanValue (true));
+  mac->SetWifiPhy (phy);
+  mac->ConfigureStandard (WIFI_PHY_STANDARD_80211n_5GHZ);
+  Ptr<MinstrelHtWifiManager> manager = CreateObject<MinstrelHtWifiManager> ();
+  manager->AssignStreams (1);
+  m_manager = manager;
+  m_manager->SetupPhy (phy);
+  m_manager->SetupMac (mac);
+  mac->SetWifiRemoteStationManager (m_manager);
+
+  m_address = Mac48Address::Allocate ();
+  m_manager->AddAllSupportedModes (m_address);
+  if (ht)
+    {
+      m_manager->AddAllSupportedMcs (m_address);
+    }
+  m_nTx = 0;
+  m_nExpected = 0;
+  m_expected = expected;
+  for (uint32_t i = 0; i < 3000; i++)
+    {
+      Simulator::Schedule (MilliSeconds (i), &MinstrelHtTest::Send, this, nMpdus);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_last.GetMode (), expected, "Bad rate after the convergence");
+  if (ht)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_last.GetChannelWidth (), 40, "Bad channel width");
+      NS_TEST_EXPECT_MSG_EQ (m_last.IsShortGuardInterval (), true, "Bad guard interval");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_last.GetChannelWidth (), 20, "Bad channel width of a legacy rate");
+    }
+  //the other rates are only used for sampling and retries
+  NS_TEST_EXPECT_MSG_GT (m_nExpected, m_nTx * 85 / 100, "Best rate not used enough");
+  mac->Dispose ();
+  m_manager->Dispose ();
+  m_manager = 0;
+}
+
+void
+MinstrelHtTest::DoRun (void)
+{
+  RunScenario (true, 8, WifiPhy::GetHtMcs4 ());
+  RunScenario (true, 0, WifiPhy::GetHtMcs4 ());
+  RunScenario (false, 0, WifiPhy::GetOfdmRate24Mbps ());
+}
+
+//-----------------------------------------------------------------------------
+class MinstrelTestSuite : public TestSuite
+{
+public:
+  MinstrelTestSuite ();
+};
+
+MinstrelTestSuite::MinstrelTestSuite ()
+  : TestSuite ("wifi-minstrel", UNIT)
+{
+  AddTestCase (new MinstrelRateTest, TestCase::QUICK);
+  AddTestCase (new MinstrelHtTest, TestCase::QUICK);
+}
+
+static MinstrelTestSuite g_minstrelTestSuite;
@@ -26,6 +26,7 @@
 #include "ns3/mac-low.h"
 #include "ns3/edca-txop-n.h"
 #include "ns3/yans-wifi-phy.h"
+#include "ns3/mpdu-standard-aggregator.h"
 
 using namespace ns3;
 
@@ -175,6 +176,69 @@ TwoLevelAggregationTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+//-----------------------------------------------------------------------------
+class AmpduSubframesTest : public TestCase
+{
+public:
+  AmpduSubframesTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AmpduSubframesTest::AmpduSubframesTest ()
+  : TestCase ("Check the size of A-MPDUs and the deaggregation of their subframes")
+{
+}
+
+void
+AmpduSubframesTest::DoRun (void)
+{
+  Ptr<MpduStandardAggregator> aggregator = CreateObject<MpduStandardAggregator> ();
+  aggregator->SetAttribute ("MaxAmpduSize", UintegerValue (1000));
+  uint32_t sizes[3] = {101, 200, 55};
+
+  /*
+   * The size reserved by AggregateSize is the size of the A-MPDU built by Aggregate.
+   */
+  Ptr<Packet> ampdu = Create<Packet> ();
+  Ptr<Packet> ampduSize = Create<Packet> ();
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      bool result = aggregator->Aggregate (Create<Packet> (sizes[i]), ampdu);
+      NS_TEST_EXPECT_MSG_EQ (result, true, "aggregation failed");
+      result = aggregator->AggregateSize (sizes[i], ampduSize);
+      NS_TEST_EXPECT_MSG_EQ (result, true, "aggregation of the size failed");
+      NS_TEST_EXPECT_MSG_EQ (ampduSize->GetSize (), ampdu->GetSize (), "wrong A-MPDU size");
+    }
+  NS_TEST_EXPECT_MSG_EQ (ampdu->GetSize (), 4 + 101 + 3 + 4 + 200 + 4 + 55, "wrong A-MPDU size");
+  bool result = aggregator->AggregateSize (1000 - ampduSize->GetSize () - 4, ampduSize);
+  NS_TEST_EXPECT_MSG_EQ (result, false, "maximum A-MPDU size check failed");
+  NS_TEST_EXPECT_MSG_EQ (ampduSize->GetSize (), ampdu->GetSize (), "size changed by a failed aggregation");
+
+  /*
+   * Deaggregation returns the MPDUs, the last one being the A-MPDU packet itself.
+   */
+  MpduAggregator::DeaggregatedMpdus mpdus = MpduAggregator::Deaggregate (ampdu);
+  NS_TEST_ASSERT_MSG_EQ (mpdus.size (), 3, "wrong number of MPDUs");
+  uint32_t i = 0;
+  for (MpduAggregator::DeaggregatedMpdusCI it = mpdus.begin (); it != mpdus.end (); it++, i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (it->first->GetSize (), sizes[i], "wrong MPDU size");
+      NS_TEST_EXPECT_MSG_EQ (it->second.GetLength (), sizes[i], "wrong subframe length");
+    }
+  NS_TEST_EXPECT_MSG_EQ (mpdus.back ().first, ampdu, "last MPDU copied");
+
+  /*
+   * A subframe sent alone, padding included, gives back its MPDU.
+   */
+  Ptr<Packet> subframe = Create<Packet> (101);
+  aggregator->AddHeaderAndPad (subframe, false, false);
+  NS_TEST_EXPECT_MSG_EQ (subframe->GetSize (), 4 + 101 + 3, "wrong subframe size");
+  mpdus = MpduAggregator::Deaggregate (subframe);
+  NS_TEST_ASSERT_MSG_EQ (mpdus.size (), 1, "wrong number of MPDUs");
+  NS_TEST_EXPECT_MSG_EQ (mpdus.front ().first->GetSize (), 101, "wrong MPDU size");
+}
 
 //-----------------------------------------------------------------------------
 class WifiAggregationTestSuite : public TestSuite
@@ -187,6 +251,7 @@ WifiAggregationTestSuite::WifiAggregationTestSuite ()
   : TestSuite ("aggregation-wifi", UNIT)
 {
   AddTestCase (new TwoLevelAggregationTest, TestCase::QUICK);
+  AddTestCase (new AmpduSubframesTest, TestCase::QUICK);
 }
 
 static WifiAggregationTestSuite g_wifiAggregationTestSuite;
@@ -0,0 +1,311 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/packet.h"
+#include "ns3/wifi-mac-queue.h"
+#include "ns3/qos-blocked-destinations.h"
+#include <list>
+#include <vector>
+
+using namespace ns3;
+
+//-----------------------------------------------------------------------------
+// The queue with its sub-queues behaves as a single list of packets
+//-----------------------------------------------------------------------------
+class WifiMacQueueTest : public TestCase
+{
+public:
+  WifiMacQueueTest ();
+  virtual void DoRun (void);
+
+private:
+  /// A packet of the reference queue
+  struct Item
+  {
+    Ptr<const Packet> packet; //!< the packet
+    WifiMacHeader hdr; //!< its header
+    Time tstamp; //!< its arrival time
+  };
+  /// The reference queue
+  typedef std::list<Item> Items;
+
+  /// Do a random operation on both queues and compare their results
+  void Step (uint32_t step);
+  /// Remove the expired packets from the reference queue
+  void Cleanup (void);
+  /**
+   * \param type the address type
+   * \param tid the TID
+   * \param addr the address
+   * \returns the first packet of the reference queue with this TID and address
+   */
+  Items::iterator Find (WifiMacHeader::AddressType type, uint8_t tid, Mac48Address addr);
+  /// \returns the first packet of the reference queue which is not blocked
+  Items::iterator FindFirstAvailable (void);
+
+  Ptr<WifiMacQueue> m_queue; //!< the queue tested
+  Items m_items; //!< the reference queue
+  QosBlockedDestinations m_blocked; //!< the blocked receivers and TIDs
+  std::vector<Mac48Address> m_addresses; //!< the addresses of the packets
+  Ptr<UniformRandomVariable> m_random; //!< random operations
+};
+
+/// Maximum number of packets in the queue
+static const uint32_t MAX_SIZE = 60;
+/// Lifetime of the packets in the queue
+static const Time MAX_DELAY = MilliSeconds (40);
+
+WifiMacQueueTest::WifiMacQueueTest ()
+  : TestCase ("Check the WifiMacQueue against a list of packets")
+{
+}
+
+void
+WifiMacQueueTest::Cleanup (void)
+{
+  for (Items::iterator i = m_items.begin (); i != m_items.end (); )
+    {
+      if (i->tstamp + MAX_DELAY > Simulator::Now ())
+        {
+          i++;
+        }
+      else
+        {
+          i = m_items.erase (i);
+        }
+    }
+}
+
+WifiMacQueueTest::Items::iterator
+WifiMacQueueTest::Find (WifiMacHeader::AddressType type, uint8_t tid, Mac48Address addr)
+{
+  Items::iterator i;
+  for (i = m_items.begin (); i != m_items.end (); i++)
+    {
+      Mac48Address address = type == WifiMacHeader::ADDR1 ? i->hdr.GetAddr1 () : i->hdr.GetAddr2 ();
+      if (i->hdr.IsQosData () && i->hdr.GetQosTid () == tid && address == addr)
+        {
+          break;
+        }
+    }
+  return i;
+}
+
+WifiMacQueueTest::Items::iterator
+WifiMacQueueTest::FindFirstAvailable (void)
+{
+  Items::iterator i;
+  for (i = m_items.begin (); i != m_items.end (); i++)
+    {
+      if (!i->hdr.IsQosData () || !m_blocked.IsBlocked (i->hdr.GetAddr1 (), i->hdr.GetQosTid ()))
+        {
+          break;
+        }
+    }
+  return i;
+}
+
+void
+WifiMacQueueTest::Step (uint32_t step)
+{
+  Mac48Address addr = m_addresses[m_random->GetInteger (0, m_addresses.size () - 1)];
+  uint8_t tid = m_random->GetInteger (0, 3);
+  WifiMacHeader::AddressType type = m_random->GetInteger (0, 3) > 0 ? WifiMacHeader::ADDR1 : WifiMacHeader::ADDR2;
+  WifiMacHeader hdr;
+  Ptr<const Packet> packet;
+  Items::iterator expected;
+  Time tstamp;
+  switch (m_random->GetInteger (0, 8))
+    {
+    case 0:
+    case 1:
+    case 2:
+      {
+        Item item;
+        item.packet = Create<Packet> (m_random->GetInteger (1, 1000));
+        item.hdr.SetType (m_random->GetInteger (0, 4) > 0 ? WIFI_MAC_QOSDATA : WIFI_MAC_DATA);
+        if (item.hdr.IsQosData ())
+          {
+            item.hdr.SetQosTid (tid);
+          }
+        item.hdr.SetAddr1 (addr);
+        item.hdr.SetAddr2 (m_addresses[m_random->GetInteger (0, m_addresses.size () - 1)]);
+        item.tstamp = Simulator::Now ();
+        bool front = m_random->GetInteger (0, 3) == 0;
+        Cleanup ();
+        if (m_items.size () < MAX_SIZE)
+          {
+            if (front)
+              {
+                m_items.push_front (item);
+              }
+            else
+              {
+                m_items.push_back (item);
+              }
+          }
+        if (front)
+          {
+            m_queue->PushFront (item.packet, item.hdr);
+          }
+        else
+          {
+            m_queue->Enqueue (item.packet, item.hdr);
+          }
+        break;
+      }
+    case 3:
+      Cleanup ();
+      packet = m_queue->Dequeue (&hdr);
+      NS_TEST_ASSERT_MSG_EQ (packet, (m_items.empty () ? 0 : m_items.front ().packet),
+                             "Bad dequeued packet at step " << step);
+      if (!m_items.empty ())
+        {
+          m_items.pop_front ();
+        }
+      break;
+    case 4:
+      Cleanup ();
+      expected = Find (type, tid, addr);
+      packet = m_queue->DequeueByTidAndAddress (&hdr, tid, type, addr);
+      NS_TEST_ASSERT_MSG_EQ (packet, (expected == m_items.end () ? 0 : expected->packet),
+                             "Bad packet dequeued by TID and address at step " << step);
+      if (expected != m_items.end ())
+        {
+          m_items.erase (expected);
+        }
+      break;
+    case 5:
+      // peek a packet and remove it, as done for the aggregation
+      Cleanup ();
+      expected = Find (type, tid, addr);
+      packet = m_queue->PeekByTidAndAddress (&hdr, tid, type, addr, &tstamp);
+      NS_TEST_ASSERT_MSG_EQ (packet, (expected == m_items.end () ? 0 : expected->packet),
+                             "Bad packet peeked by TID and address at step " << step);
+      if (expected != m_items.end ())
+        {
+          NS_TEST_ASSERT_MSG_EQ (tstamp, expected->tstamp, "Bad timestamp at step " << step);
+          NS_TEST_ASSERT_MSG_EQ (m_queue->Remove (packet), true, "Packet not removed at step " << step);
+          m_items.erase (expected);
+        }
+      break;
+    case 6:
+      {
+        Cleanup ();
+        uint32_t n = 0;
+        for (Items::iterator i = m_items.begin (); i != m_items.end (); i++)
+          {
+            Mac48Address address = type == WifiMacHeader::ADDR1 ? i->hdr.GetAddr1 () : i->hdr.GetAddr2 ();
+            n += i->hdr.IsQosData () && i->hdr.GetQosTid () == tid && address == addr;
+          }
+        NS_TEST_ASSERT_MSG_EQ (m_queue->GetNPacketsByTidAndAddress (tid, type, addr), n,
+                               "Bad number of packets at step " << step);
+        NS_TEST_ASSERT_MSG_EQ (m_queue->GetSize (), m_items.size (), "Bad size at step " << step);
+        break;
+      }
+    case 7:
+      {
+        if (m_random->GetInteger (0, 1))
+          {
+            m_blocked.Block (addr, tid);
+          }
+        else
+          {
+            m_blocked.Unblock (addr, tid);
+          }
+        bool dequeue = m_random->GetInteger (0, 1);
+        Cleanup ();
+        expected = FindFirstAvailable ();
+        packet = dequeue ? m_queue->DequeueFirstAvailable (&hdr, tstamp, &m_blocked)
+          : m_queue->PeekFirstAvailable (&hdr, tstamp, &m_blocked);
+        NS_TEST_ASSERT_MSG_EQ (packet, (expected == m_items.end () ? 0 : expected->packet),
+                               "Bad first available packet at step " << step);
+        if (dequeue && expected != m_items.end ())
+          {
+            m_items.erase (expected);
+          }
+        break;
+      }
+    case 8:
+      {
+        // remove a packet anywhere in the queue, or one not queued
+        if (m_items.empty () || m_random->GetInteger (0, 3) == 0)
+          {
+            NS_TEST_ASSERT_MSG_EQ (m_queue->Remove (Create<Packet> ()), false,
+                                   "Packet not queued removed at step " << step);
+            break;
+          }
+        Items::iterator i = m_items.begin ();
+        std::advance (i, m_random->GetInteger (0, m_items.size () - 1));
+        NS_TEST_ASSERT_MSG_EQ (m_queue->Remove (i->packet), true, "Packet not removed at step " << step);
+        m_items.erase (i);
+        break;
+      }
+    }
+  if (m_items.empty ())
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_queue->IsEmpty (), true, "Queue not empty at step " << step);
+    }
+  Cleanup ();
+  NS_TEST_ASSERT_MSG_EQ (m_queue->IsEmpty (), m_items.empty (), "Bad emptiness at step " << step);
+  NS_TEST_ASSERT_MSG_EQ (m_queue->GetSize (), m_items.size (), "Bad size at step " << step);
+  if (!m_items.empty ())
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_queue->Peek (&hdr), m_items.front ().packet, "Bad first packet at step " << step);
+    }
+}
+
+void
+WifiMacQueueTest::DoRun (void)
+{
+  m_random = CreateObject<UniformRandomVariable> ();
+  m_random->SetStream (1);
+  m_queue = CreateObject<WifiMacQueue> ();
+  m_queue->SetMaxSize (MAX_SIZE);
+  m_queue->SetMaxDelay (MAX_DELAY);
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      m_addresses.push_back (Mac48Address::Allocate ());
+    }
+  // several operations at the same time, then a bit later, so that the
+  // packets expire in batches
+  for (uint32_t step = 0; step < 20000; step++)
+    {
+      Simulator::Schedule (MicroSeconds (step / 4 * 1000), &WifiMacQueueTest::Step, this, step);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+  m_queue->Flush ();
+  NS_TEST_EXPECT_MSG_EQ (m_queue->IsEmpty (), true, "Queue not empty after a flush");
+}
+
+//-----------------------------------------------------------------------------
+class WifiMacQueueTestSuite : public TestSuite
+{
+public:
+  WifiMacQueueTestSuite ();
+};
+
+WifiMacQueueTestSuite::WifiMacQueueTestSuite ()
+  : TestSuite ("wifi-mac-queue", UNIT)
+{
+  AddTestCase (new WifiMacQueueTest, TestCase::QUICK);
+}
+
+static WifiMacQueueTestSuite g_wifiMacQueueTestSuite;
@@ -33,6 +33,8 @@
 #include "ns3/propagation-delay-model.h"
 #include "ns3/propagation-loss-model.h"
 #include "ns3/yans-error-rate-model.h"
+#include "ns3/nist-error-rate-model.h"
+#include "ns3/interference-helper.h"
 #include "ns3/constant-position-mobility-model.h"
 #include "ns3/test.h"
 #include "ns3/pointer.h"
@@ -40,6 +42,14 @@
 #include "ns3/config.h"
 #include "ns3/boolean.h"
 #include "ns3/string.h"
+#include "ns3/mac-rx-middle.h"
+#include "ns3/wifi-mac-header.h"
+#include "ns3/constant-rate-wifi-manager.h"
+#include "ns3/mac-low.h"
+#include "ns3/wifi-mac-trailer.h"
+#include "ns3/dcf-manager.h"
+#include "ns3/basic-energy-source.h"
+#include "ns3/wifi-radio-energy-model.h"
 
 using namespace ns3;
 
@@ -214,6 +224,356 @@ public:
 };
 
 
+//-----------------------------------------------------------------------------
+/**
+ * Check that MacRxMiddle detects the duplicates of each originator
+ * separately, and of each Traffic ID separately for the QoS data.
+ */
+class MacRxMiddleTest : public TestCase
+{
+public:
+  MacRxMiddleTest () : TestCase ("MacRxMiddle duplicate detection")
+  {
+  }
+  virtual void DoRun (void);
+
+private:
+  void Forward (Ptr<Packet> packet, const WifiMacHeader *hdr);
+  /**
+   * \returns true if the frame is forwarded up
+   */
+  bool Receive (Mac48Address from, bool qos, uint8_t tid, uint16_t seq, bool retry);
+
+  MacRxMiddle m_rxMiddle;
+  uint32_t m_forwarded;
+};
+
+void
+MacRxMiddleTest::Forward (Ptr<Packet> packet, const WifiMacHeader *hdr)
+{
+  m_forwarded++;
+}
+
+bool
+MacRxMiddleTest::Receive (Mac48Address from, bool qos, uint8_t tid, uint16_t seq, bool retry)
+{
+  WifiMacHeader hdr;
+  if (qos)
+    {
+      hdr.SetType (WIFI_MAC_QOSDATA);
+      hdr.SetQosTid (tid);
+    }
+  else
+    {
+      hdr.SetType (WIFI_MAC_DATA);
+    }
+  hdr.SetAddr1 (Mac48Address ("00:00:00:00:00:01"));
+  hdr.SetAddr2 (from);
+  hdr.SetSequenceNumber (seq);
+  hdr.SetFragmentNumber (0);
+  hdr.SetNoMoreFragments ();
+  if (retry)
+    {
+      hdr.SetRetry ();
+    }
+  else
+    {
+      hdr.SetNoRetry ();
+    }
+  uint32_t forwarded = m_forwarded;
+  m_rxMiddle.Receive (Create<Packet> (100), &hdr);
+  return m_forwarded > forwarded;
+}
+
+void
+MacRxMiddleTest::DoRun (void)
+{
+  m_forwarded = 0;
+  m_rxMiddle.SetForwardCallback (MakeCallback (&MacRxMiddleTest::Forward, this));
+  Mac48Address a ("00:00:00:00:00:02");
+  Mac48Address b ("00:00:00:00:00:03");
+
+  NS_TEST_EXPECT_MSG_EQ (Receive (a, true, 0, 5, false), true, "first frame is forwarded");
+  NS_TEST_EXPECT_MSG_EQ (Receive (a, true, 0, 5, true), false, "retransmission is a duplicate");
+  NS_TEST_EXPECT_MSG_EQ (Receive (a, true, 3, 5, true), true, "other TID is not a duplicate");
+  NS_TEST_EXPECT_MSG_EQ (Receive (a, true, 3, 5, true), false, "retransmission for other TID is a duplicate");
+  NS_TEST_EXPECT_MSG_EQ (Receive (b, true, 0, 5, true), true, "other originator is not a duplicate");
+  NS_TEST_EXPECT_MSG_EQ (Receive (a, false, 0, 5, true), true, "non-QoS data is not a duplicate of QoS data");
+  NS_TEST_EXPECT_MSG_EQ (Receive (a, false, 0, 5, true), false, "non-QoS retransmission is a duplicate");
+  NS_TEST_EXPECT_MSG_EQ (Receive (a, true, 0, 6, true), true, "next sequence number is forwarded");
+  NS_TEST_EXPECT_MSG_EQ (Receive (a, true, 0, 5, true), true, "only the last sequence number is a duplicate");
+  NS_TEST_EXPECT_MSG_EQ (m_forwarded, 6, "number of forwarded frames");
+}
+
+
+//-----------------------------------------------------------------------------
+/**
+ * Check that MacLow writes the RTS, CTS and ACK frames from a template
+ * per type and station whose Duration/ID field is patched for each frame,
+ * and that the templates are dropped when there are too many of them.
+ */
+class MacLowControlFrameTest : public TestCase
+{
+public:
+  MacLowControlFrameTest ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Return a control frame header.
+   *
+   * \param type the type of the frame
+   * \param to the receiver
+   * \param duration the duration of the frame
+   *
+   * 
+eturn the header
+   */
+  WifiMacHeader MakeHeader (enum WifiMacType type, Mac48Address to, Time duration);
+  /**
+   * Check a control frame.
+   *
+   * \param packet the frame
+   * \param expected the header it must hold
+   */
+  void CheckFrame (Ptr<const Packet> packet, const WifiMacHeader &expected);
+
+  Mac48Address m_self; //!< the address of the MacLow
+};
+
+MacLowControlFrameTest::MacLowControlFrameTest ()
+  : TestCase ("Check the control frames written from templates by MacLow"),
+    m_self (Mac48Address ("00:00:00:00:00:01"))
+{
+}
+
+WifiMacHeader
+MacLowControlFrameTest::MakeHeader (enum WifiMacType type, Mac48Address to, Time duration)
+{
+  WifiMacHeader hdr;
+  hdr.SetType (type);
+  hdr.SetDsNotFrom ();
+  hdr.SetDsNotTo ();
+  hdr.SetNoRetry ();
+  hdr.SetNoMoreFragments ();
+  hdr.SetAddr1 (to);
+  if (type == WIFI_MAC_CTL_RTS)
+    {
+      hdr.SetAddr2 (m_self);
+    }
+  hdr.SetDuration (duration);
+  return hdr;
+}
+
+void
+MacLowControlFrameTest::CheckFrame (Ptr<const Packet> packet, const WifiMacHeader &expected)
+{
+  Ptr<Packet> copy = packet->Copy ();
+  WifiMacHeader hdr;
+  WifiMacTrailer fcs;
+  NS_TEST_EXPECT_MSG_EQ (copy->GetSize (), expected.GetSerializedSize () + fcs.GetSerializedSize (), "wrong frame size");
+  copy->RemoveHeader (hdr);
+  copy->RemoveTrailer (fcs);
+  NS_TEST_EXPECT_MSG_EQ (copy->GetSize (), 0, "the frame has a payload");
+  NS_TEST_EXPECT_MSG_EQ (hdr.GetType (), expected.GetType (), "wrong frame type");
+  NS_TEST_EXPECT_MSG_EQ (hdr.GetAddr1 (), expected.GetAddr1 (), "wrong receiver");
+  if (expected.IsRts ())
+    {
+      NS_TEST_EXPECT_MSG_EQ (hdr.GetAddr2 (), expected.GetAddr2 (), "wrong transmitter");
+    }
+  NS_TEST_EXPECT_MSG_EQ (hdr.GetDuration (), expected.GetDuration (), "wrong duration");
+}
+
+void
+MacLowControlFrameTest::DoRun (void)
+{
+  Ptr<MacLow> low = CreateObject<MacLow> ();
+  low->SetAddress (m_self);
+  Mac48Address a ("00:00:00:00:00:02");
+  Mac48Address b ("00:00:00:00:00:03");
+
+  /*
+   * The next frames of a type to a station are written from the template
+   * of the first one, with their own duration, and do not change the
+   * frames written before them.
+   */
+  WifiMacHeader ack1 = MakeHeader (WIFI_MAC_CTL_ACK, a, MicroSeconds (10));
+  Ptr<Packet> frame1 = low->GetControlFrame (ack1);
+  WifiMacHeader ack2 = MakeHeader (WIFI_MAC_CTL_ACK, a, MicroSeconds (44));
+  Ptr<Packet> frame2 = low->GetControlFrame (ack2);
+  NS_TEST_EXPECT_MSG_EQ (low->m_controlFrames.size (), 1, "one template per type and station");
+  NS_TEST_EXPECT_MSG_NE (frame1->GetUid (), frame2->GetUid (), "frames share a uid");
+  CheckFrame (frame1, ack1);
+  CheckFrame (frame2, ack2);
+
+  /*
+   * Other types and stations have their own templates.
+   */
+  WifiMacHeader cts = MakeHeader (WIFI_MAC_CTL_CTS, b, MicroSeconds (7));
+  CheckFrame (low->GetControlFrame (cts), cts);
+  WifiMacHeader rts = MakeHeader (WIFI_MAC_CTL_RTS, a, MicroSeconds (100));
+  CheckFrame (low->GetControlFrame (rts), rts);
+  WifiMacHeader ack3 = MakeHeader (WIFI_MAC_CTL_ACK, b, MicroSeconds (3));
+  CheckFrame (low->GetControlFrame (ack3), ack3);
+  NS_TEST_EXPECT_MSG_EQ (low->m_controlFrames.size (), 4, "one template per type and station");
+  rts.SetDuration (MicroSeconds (200));
+  CheckFrame (low->GetControlFrame (rts), rts);
+  CheckFrame (low->GetControlFrame (ack2), ack2);
+
+  /*
+   * The templates are bounded.
+   */
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      WifiMacHeader ack = MakeHeader (WIFI_MAC_CTL_ACK, Mac48Address::Allocate (), MicroSeconds (i));
+      CheckFrame (low->GetControlFrame (ack), ack);
+    }
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (low->m_controlFrames.size (), 256, "too many templates");
+
+  low->Dispose ();
+  Simulator::Destroy ();
+}
+
+
+//-----------------------------------------------------------------------------
+/**
+ * A ConstantRateWifiManager which counts the stations it creates and
+ * records the station handed to DoNeedRts.
+ */
+class LookupTestWifiManager : public ConstantRateWifiManager
+{
+public:
+  LookupTestWifiManager ()
+    : m_created (0),
+      m_lastStation (0)
+  {
+  }
+
+  /// the number of stations created
+  mutable uint32_t m_created;
+  /// the station of the last call to NeedRts
+  WifiRemoteStation *m_lastStation;
+
+private:
+  virtual WifiRemoteStation* DoCreateStation (void) const
+  {
+    m_created++;
+    return new WifiRemoteStation ();
+  }
+  virtual bool DoNeedRts (WifiRemoteStation *station,
+                          Ptr<const Packet> packet, bool normally)
+  {
+    m_lastStation = station;
+    return normally;
+  }
+};
+
+/**
+ * Check that WifiRemoteStationManager creates a station the first time
+ * an address and TID are looked up, that the stations and their states
+ * stay at the same address while other ones are created, that the
+ * stations of the TIDs of an address share its state, and that Reset
+ * drops the stations but keeps the states.
+ */
+class WifiRemoteStationLookupTest : public TestCase
+{
+public:
+  WifiRemoteStationLookupTest () : TestCase ("WifiRemoteStationManager station lookup")
+  {
+  }
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \returns the station looked up for a data frame to this address
+   */
+  WifiRemoteStation * Lookup (Mac48Address address, bool qos, uint8_t tid);
+
+  Ptr<LookupTestWifiManager> m_manager;
+};
+
+WifiRemoteStation *
+WifiRemoteStationLookupTest::Lookup (Mac48Address address, bool qos, uint8_t tid)
+{
+  WifiMacHeader hdr;
+  if (qos)
+    {
+      hdr.SetType (WIFI_MAC_QOSDATA);
+      hdr.SetQosTid (tid);
+    }
+  else
+    {
+      hdr.SetType (WIFI_MAC_DATA);
+    }
+  hdr.SetAddr1 (address);
+  m_manager->m_lastStation = 0;
+  m_manager->NeedRts (address, &hdr, Create<Packet> (100));
+  return m_manager->m_lastStation;
+}
+
+void
+WifiRemoteStationLookupTest::DoRun (void)
+{
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  phy->SetErrorRateModel (CreateObject<NistErrorRateModel> ());
+  phy->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+  m_manager = CreateObject<LookupTestWifiManager> ();
+  m_manager->SetupPhy (phy);
+
+  Mac48Address a ("00:00:00:00:00:02");
+  Mac48Address b ("00:00:00:00:00:03");
+
+  NS_TEST_ASSERT_MSG_EQ (m_manager->IsBrandNew (a), true, "unknown address is brand new");
+  WifiRemoteStation *a0 = Lookup (a, false, 0);
+  NS_TEST_ASSERT_MSG_NE (a0, 0, "no station for the first lookup");
+  NS_TEST_EXPECT_MSG_EQ (m_manager->m_created, 1, "first lookup creates the station");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)a0->m_tid, 0, "non-QoS data uses TID 0");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (a, false, 0), a0, "second lookup returns the same station");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (a, true, 0), a0, "QoS data of TID 0 shares the station of non-QoS data");
+  NS_TEST_EXPECT_MSG_EQ (m_manager->m_created, 1, "lookups of a known station create nothing");
+
+  WifiRemoteStation *a5 = Lookup (a, true, 5);
+  NS_TEST_EXPECT_MSG_NE (a5, a0, "other TID has its own station");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)a5->m_tid, 5, "station of the TID");
+  NS_TEST_EXPECT_MSG_EQ (a5->m_state, a0->m_state, "stations of an address share its state");
+  NS_TEST_EXPECT_MSG_EQ (m_manager->m_created, 2, "other TID creates a station");
+
+  WifiRemoteStation *b0 = Lookup (b, false, 0);
+  NS_TEST_EXPECT_MSG_NE (b0, a0, "other address has its own station");
+  NS_TEST_EXPECT_MSG_NE (b0->m_state, a0->m_state, "other address has its own state");
+
+  // look up enough other stations to grow the tables several times
+  WifiRemoteStationState *aState = a0->m_state;
+  m_manager->RecordWaitAssocTxOk (a);
+  m_manager->RecordGotAssocTxOk (a);
+  for (uint32_t t = 0; t < 1000; t++)
+    {
+      uint8_t buffer[6] = { 0x02, 0, 0, 0, (uint8_t)(t >> 8), (uint8_t)t };
+      Mac48Address other;
+      other.CopyFrom (buffer);
+      Lookup (other, true, t % 8);
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_manager->m_created, 1003, "one station for each new address");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (a, false, 0), a0, "station moved while the tables grew");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (a, true, 5), a5, "station moved while the tables grew");
+  NS_TEST_EXPECT_MSG_EQ (a0->m_state, aState, "state moved while the tables grew");
+  NS_TEST_EXPECT_MSG_EQ (m_manager->IsAssociated (a), true, "state lost while the tables grew");
+
+  m_manager->Reset ();
+  uint32_t created = m_manager->m_created;
+  WifiRemoteStation *reset = Lookup (a, true, 5);
+  NS_TEST_EXPECT_MSG_EQ (m_manager->m_created, created + 1, "lookup after Reset creates the station again");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)reset->m_tid, 5, "station of the TID after Reset");
+  NS_TEST_EXPECT_MSG_EQ (reset->m_state, aState, "Reset keeps the state of the address");
+  NS_TEST_EXPECT_MSG_EQ (m_manager->IsAssociated (a), true, "Reset keeps the association");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (a, true, 5), reset, "second lookup after Reset returns the same station");
+  NS_TEST_EXPECT_MSG_EQ (m_manager->m_created, created + 1, "lookups of a known station create nothing");
+
+  m_manager->Dispose ();
+  m_manager = 0;
+}
+
+
 //-----------------------------------------------------------------------------
 /**
  * See \bugid{991}
@@ -327,6 +687,372 @@ InterferenceHelperSequenceTest::DoRun (void)
 }
 
 
+//-----------------------------------------------------------------------------
+/**
+ * Check the noise and interference bookkeeping of InterferenceHelper:
+ * energy durations seen by CCA, the SNR at the start of a reception
+ * once older changes have been pruned, and the payload PER of a frame
+ * overlapped by a long train of interferers.
+ */
+class InterferenceHelperNiChangesTest : public TestCase
+{
+public:
+  InterferenceHelperNiChangesTest ();
+
+  virtual void DoRun (void);
+
+
+private:
+  Ptr<InterferenceHelper::Event> Add (Time duration, double rxPowerW);
+  void StartRx (Time duration, double rxPowerW);
+  void CheckEnergyDuration (double energyW, Time expected);
+  void CheckHeaderSnr (double expected);
+  void CheckPayloadPer (double expected);
+  void EndRx (void);
+
+  InterferenceHelper m_interference;
+  WifiTxVector m_txVector;
+  Ptr<InterferenceHelper::Event> m_rxEvent;
+};
+
+InterferenceHelperNiChangesTest::InterferenceHelperNiChangesTest ()
+  : TestCase ("InterferenceHelperNiChanges")
+{
+}
+
+Ptr<InterferenceHelper::Event>
+InterferenceHelperNiChangesTest::Add (Time duration, double rxPowerW)
+{
+  return m_interference.Add (1000, m_txVector, WIFI_PREAMBLE_LONG, duration, rxPowerW);
+}
+
+void
+InterferenceHelperNiChangesTest::StartRx (Time duration, double rxPowerW)
+{
+  m_rxEvent = Add (duration, rxPowerW);
+  m_interference.NotifyRxStart ();
+}
+
+void
+InterferenceHelperNiChangesTest::CheckEnergyDuration (double energyW, Time expected)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_interference.GetEnergyDuration (energyW), expected, "Unexpected energy duration at " << Simulator::Now ());
+}
+
+void
+InterferenceHelperNiChangesTest::CheckHeaderSnr (double expected)
+{
+  struct InterferenceHelper::SnrPer snrPer = m_interference.CalculatePlcpHeaderSnrPer (m_rxEvent);
+  NS_TEST_EXPECT_MSG_EQ_TOL (snrPer.snr, expected, expected * 1e-9, "Unexpected SNR at the start of the reception");
+}
+
+void
+InterferenceHelperNiChangesTest::CheckPayloadPer (double expected)
+{
+  struct InterferenceHelper::SnrPer snrPer = m_interference.CalculatePlcpPayloadSnrPer (m_rxEvent);
+  NS_TEST_EXPECT_MSG_EQ_TOL (snrPer.per, expected, 1e-9, "Unexpected payload PER");
+}
+
+void
+InterferenceHelperNiChangesTest::EndRx (void)
+{
+  m_interference.NotifyRxEnd ();
+  m_rxEvent = 0;
+}
+
+void
+InterferenceHelperNiChangesTest::DoRun (void)
+{
+  m_interference.SetNoiseFigure (1.0);
+  m_interference.SetErrorRateModel (CreateObject<NistErrorRateModel> ());
+  m_txVector.SetMode (WifiPhy::GetOfdmRate6Mbps ());
+  m_txVector.SetChannelWidth (20);
+  double noiseFloorW = 1.3803e-23 * 290.0 * 20e6;
+
+  //A (1 nW) is received, B (0.4 nW) overlaps its end.
+  Simulator::Schedule (Seconds (1.0), &InterferenceHelperNiChangesTest::StartRx, this,
+                       MicroSeconds (1000), 1e-9);
+  Simulator::Schedule (Seconds (1.0) + MicroSeconds (100), &InterferenceHelperNiChangesTest::Add, this,
+                       MicroSeconds (2000), 4e-10);
+  Simulator::Schedule (Seconds (1.0) + MicroSeconds (200), &InterferenceHelperNiChangesTest::CheckEnergyDuration, this,
+                       1.2e-9, MicroSeconds (800));
+  Simulator::Schedule (Seconds (1.0) + MicroSeconds (200), &InterferenceHelperNiChangesTest::CheckEnergyDuration, this,
+                       3e-10, MicroSeconds (1900));
+  Simulator::Schedule (Seconds (1.0) + MicroSeconds (200), &InterferenceHelperNiChangesTest::CheckHeaderSnr, this,
+                       1e-9 / noiseFloorW);
+  Simulator::Schedule (Seconds (1.0) + MicroSeconds (1000), &InterferenceHelperNiChangesTest::EndRx, this);
+  //Once A is over, only B is left on the medium
+  Simulator::Schedule (Seconds (1.0) + MicroSeconds (1500), &InterferenceHelperNiChangesTest::CheckEnergyDuration, this,
+                       3e-10, MicroSeconds (600));
+
+  //C (1 pW) starts while B is still on the medium and is received:
+  //B must be accounted for in the SNR even though its start is pruned.
+  Simulator::Schedule (Seconds (1.0) + MicroSeconds (1600), &InterferenceHelperNiChangesTest::StartRx, this,
+                       MicroSeconds (300), 1e-12);
+  Simulator::Schedule (Seconds (1.0) + MicroSeconds (1700), &InterferenceHelperNiChangesTest::CheckHeaderSnr, this,
+                       1e-12 / (noiseFloorW + 4e-10));
+  Simulator::Schedule (Seconds (1.0) + MicroSeconds (1900), &InterferenceHelperNiChangesTest::CheckPayloadPer, this,
+                       1.0);
+  Simulator::Schedule (Seconds (1.0) + MicroSeconds (1900), &InterferenceHelperNiChangesTest::EndRx, this);
+
+  //D (1 nW) is received while 200 weak interferers come and go: the
+  //payload stays decodable whatever the number of changes.
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      Simulator::Schedule (Seconds (2.0) + MicroSeconds (50 + 5 * i), &InterferenceHelperNiChangesTest::Add, this,
+                           MicroSeconds (20), 1e-15);
+    }
+  Simulator::Schedule (Seconds (2.0), &InterferenceHelperNiChangesTest::StartRx, this,
+                       MicroSeconds (2000), 1e-9);
+  Simulator::Schedule (Seconds (2.0) + MicroSeconds (2000), &InterferenceHelperNiChangesTest::CheckPayloadPer, this,
+                       0.0);
+  Simulator::Schedule (Seconds (2.0) + MicroSeconds (2000), &InterferenceHelperNiChangesTest::EndRx, this);
+  Simulator::Schedule (Seconds (2.0) + MicroSeconds (2000), &InterferenceHelperNiChangesTest::CheckEnergyDuration, this,
+                       1e-16, MicroSeconds (0));
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+
+//-----------------------------------------------------------------------------
+class YansWifiChannelListsTest : public TestCase
+{
+public:
+  YansWifiChannelListsTest ();
+
+  virtual void DoRun (void);
+
+
+private:
+  Ptr<YansWifiPhy> CreatePhy (Ptr<YansWifiChannel> channel, uint16_t channelNumber, double x);
+  void Send (void);
+  void RxBegin (std::string context, Ptr<const Packet> p);
+  void CheckRx (uint32_t expected1, uint32_t expected2, bool ccaBusy2);
+
+  std::vector<Ptr<YansWifiPhy> > m_phys;
+  uint32_t m_rx[3];
+};
+
+YansWifiChannelListsTest::YansWifiChannelListsTest ()
+  : TestCase ("YansWifiChannel channel lists and adjacent channel interference")
+{
+}
+
+Ptr<YansWifiPhy>
+YansWifiChannelListsTest::CreatePhy (Ptr<YansWifiChannel> channel, uint16_t channelNumber, double x)
+{
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+  mobility->SetPosition (Vector (x, 0, 0));
+  phy->SetMobility (mobility);
+  phy->SetErrorRateModel (CreateObject<NistErrorRateModel> ());
+  phy->ConfigureStandard (WIFI_PHY_STANDARD_80211g);
+  phy->SetChannelNumber (channelNumber);
+  phy->SetChannel (channel);
+  std::ostringstream context;
+  context << m_phys.size ();
+  phy->TraceConnect ("PhyRxBegin", context.str (), MakeCallback (&YansWifiChannelListsTest::RxBegin, this));
+  m_phys.push_back (phy);
+  return phy;
+}
+
+void
+YansWifiChannelListsTest::Send (void)
+{
+  WifiTxVector txVector;
+  txVector.SetMode (WifiPhy::GetErpOfdmRate6Mbps ());
+  txVector.SetTxPowerLevel (0);
+  txVector.SetChannelWidth (20);
+  txVector.SetNss (1);
+  m_phys[0]->SendPacket (Create<Packet> (1000), txVector, WIFI_PREAMBLE_LONG, 0, 0);
+}
+
+void
+YansWifiChannelListsTest::RxBegin (std::string context, Ptr<const Packet> p)
+{
+  m_rx[atoi (context.c_str ())]++;
+}
+
+void
+YansWifiChannelListsTest::CheckRx (uint32_t expected1, uint32_t expected2, bool ccaBusy2)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_rx[0], 0, "the sender received its own frame at " << Simulator::Now ());
+  NS_TEST_EXPECT_MSG_EQ (m_rx[1], expected1, "wrong number of frames received on channel 1 at " << Simulator::Now ());
+  NS_TEST_EXPECT_MSG_EQ (m_rx[2], expected2, "wrong number of frames received by the third PHY at " << Simulator::Now ());
+  NS_TEST_EXPECT_MSG_EQ (m_phys[2]->IsStateCcaBusy (), ccaBusy2, "wrong CCA state of the third PHY at " << Simulator::Now ());
+}
+
+void
+YansWifiChannelListsTest::DoRun (void)
+{
+  m_rx[0] = m_rx[1] = m_rx[2] = 0;
+  Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel> ();
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  channel->SetPropagationLossModel (CreateObject<LogDistancePropagationLossModel> ());
+  CreatePhy (channel, 1, 0);
+  CreatePhy (channel, 1, 5);
+  Ptr<YansWifiPhy> phy = CreatePhy (channel, 6, 10);
+
+  //The PHY on channel 6 does not see the frames on channel 1
+  Simulator::Schedule (Seconds (1.0), &YansWifiChannelListsTest::Send, this);
+  Simulator::Schedule (Seconds (1.0) + MicroSeconds (100), &YansWifiChannelListsTest::CheckRx, this, 1, 0, false);
+  //unless adjacent channel interference is enabled: it then senses the medium busy
+  Simulator::Schedule (Seconds (1.5), &YansWifiChannel::SetAttribute, channel,
+                       "AdjacentChannelInterference", BooleanValue (true));
+  Simulator::Schedule (Seconds (2.0), &YansWifiChannelListsTest::Send, this);
+  Simulator::Schedule (Seconds (2.0) + MicroSeconds (100), &YansWifiChannelListsTest::CheckRx, this, 2, 0, true);
+  //Once switched to channel 1, it receives them
+  Simulator::Schedule (Seconds (2.5), &YansWifiPhy::SetChannelNumber, phy, 1);
+  Simulator::Schedule (Seconds (3.0), &YansWifiChannelListsTest::Send, this);
+  Simulator::Schedule (Seconds (3.0) + MicroSeconds (100), &YansWifiChannelListsTest::CheckRx, this, 3, 1, false);
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+  m_phys.clear ();
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * A DcfState which records when it is granted the access and which
+ * restarts without backoff slots after a collision.
+ */
+class InterferenceDuringTxDcfState : public DcfState
+{
+public:
+  InterferenceDuringTxDcfState ()
+    : m_granted (Seconds (0))
+  {
+  }
+
+  /// the time of the last access grant
+  Time m_granted;
+
+private:
+  virtual void DoNotifyAccessGranted (void)
+  {
+    m_granted = Simulator::Now ();
+  }
+  virtual void DoNotifyInternalCollision (void)
+  {
+  }
+  virtual void DoNotifyCollision (void)
+  {
+    StartBackoffNow (0);
+  }
+  virtual void DoNotifyChannelSwitching (void)
+  {
+  }
+  virtual void DoNotifySleep (void)
+  {
+  }
+  virtual void DoNotifyWakeUp (void)
+  {
+  }
+};
+
+/**
+ * Check that an adjacent channel signal which ends during a transmission
+ * is not reported as a CCA busy period: the energy model stays in TX and
+ * DcfManager keeps the end of the busy period sensed before the
+ * transmission.
+ */
+class YansWifiPhyInterferenceDuringTxTest : public TestCase
+{
+public:
+  YansWifiPhyInterferenceDuringTxTest ();
+
+private:
+  virtual void DoRun (void);
+  /// Send a 1000 bytes frame at 6 Mbps
+  void Send (void);
+  /**
+   * Check the state of the PHY and of the energy model.
+   *
+   * \param state the expected state
+   */
+  void CheckState (WifiPhy::State state);
+
+  Ptr<YansWifiPhy> m_phy;               //!< the PHY
+  Ptr<WifiRadioEnergyModel> m_energy;   //!< the energy model of the PHY
+};
+
+YansWifiPhyInterferenceDuringTxTest::YansWifiPhyInterferenceDuringTxTest ()
+  : TestCase ("Adjacent channel interference during a transmission")
+{
+}
+
+void
+YansWifiPhyInterferenceDuringTxTest::Send (void)
+{
+  WifiTxVector txVector;
+  txVector.SetMode (WifiPhy::GetOfdmRate6Mbps ());
+  txVector.SetTxPowerLevel (0);
+  txVector.SetChannelWidth (20);
+  txVector.SetNss (1);
+  m_phy->SendPacket (Create<Packet> (1000), txVector, WIFI_PREAMBLE_LONG, 0, 0);
+}
+
+void
+YansWifiPhyInterferenceDuringTxTest::CheckState (WifiPhy::State state)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_phy->IsStateTx (), (state == WifiPhy::TX), "wrong PHY state at " << Simulator::Now ());
+  NS_TEST_EXPECT_MSG_EQ (m_phy->IsStateCcaBusy (), (state == WifiPhy::CCA_BUSY), "wrong PHY state at " << Simulator::Now ());
+  NS_TEST_EXPECT_MSG_EQ (m_energy->GetCurrentState (), state, "wrong energy model state at " << Simulator::Now ());
+}
+
+void
+YansWifiPhyInterferenceDuringTxTest::DoRun (void)
+{
+  Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel> ();
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  channel->SetPropagationLossModel (CreateObject<LogDistancePropagationLossModel> ());
+  m_phy = CreateObject<YansWifiPhy> ();
+  m_phy->SetMobility (CreateObject<ConstantPositionMobilityModel> ());
+  m_phy->SetErrorRateModel (CreateObject<NistErrorRateModel> ());
+  m_phy->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+  m_phy->SetChannel (channel);
+
+  Ptr<BasicEnergySource> source = CreateObject<BasicEnergySource> ();
+  m_energy = CreateObject<WifiRadioEnergyModel> ();
+  m_energy->SetEnergySource (source);
+  source->AppendDeviceEnergyModel (m_energy);
+  m_phy->RegisterListener (m_energy->GetPhyListener ());
+
+  DcfManager *dcf = new DcfManager ();
+  dcf->SetSlot (MicroSeconds (9));
+  dcf->SetSifs (MicroSeconds (16));
+  dcf->SetEifsNoDifs (MicroSeconds (60));
+  dcf->SetupPhyListener (m_phy);
+  InterferenceDuringTxDcfState state;
+  state.SetAifsn (2);
+  dcf->Add (&state);
+
+  //The medium is busy for 3 ms, and a frame is sent meanwhile, which
+  //lasts about 1.4 ms
+  Time start = Seconds (1.0);
+  Simulator::Schedule (start, &YansWifiPhy::StartReceiveInterference, m_phy, -50.0, MicroSeconds (3000));
+  Simulator::Schedule (start + MicroSeconds (5), &YansWifiPhyInterferenceDuringTxTest::CheckState, this, WifiPhy::CCA_BUSY);
+  Simulator::Schedule (start + MicroSeconds (10), &YansWifiPhyInterferenceDuringTxTest::Send, this);
+  //A signal which ends before the frame neither changes the state of the
+  //PHY nor the end of the busy period sensed by DcfManager
+  Simulator::Schedule (start + MicroSeconds (100), &YansWifiPhy::StartReceiveInterference, m_phy, -50.0, MicroSeconds (200));
+  Simulator::Schedule (start + MicroSeconds (150), &YansWifiPhyInterferenceDuringTxTest::CheckState, this, WifiPhy::TX);
+  Simulator::Schedule (start + MicroSeconds (200), &DcfManager::RequestAccess, dcf, &state);
+  Simulator::Schedule (start + MicroSeconds (350), &YansWifiPhyInterferenceDuringTxTest::CheckState, this, WifiPhy::TX);
+
+  Simulator::Run ();
+  //access is granted a DIFS after the end of the first signal
+  NS_TEST_EXPECT_MSG_EQ (state.m_granted, start + MicroSeconds (3000 + 16 + 2 * 9), "wrong access grant time");
+
+  dcf->RemovePhyListener (m_phy);
+  delete dcf;
+  Simulator::Destroy ();
+  m_phy = 0;
+  m_energy = 0;
+}
+
+
 //-----------------------------------------------------------------------------
 /**
  * Make sure that when multiple broadcast packets are queued on the same
@@ -634,7 +1360,13 @@ WifiTestSuite::WifiTestSuite ()
 {
   AddTestCase (new WifiTest, TestCase::QUICK);
   AddTestCase (new QosUtilsIsOldPacketTest, TestCase::QUICK);
+  AddTestCase (new MacRxMiddleTest, TestCase::QUICK);
+  AddTestCase (new WifiRemoteStationLookupTest, TestCase::QUICK);
+  AddTestCase (new MacLowControlFrameTest, TestCase::QUICK);
   AddTestCase (new InterferenceHelperSequenceTest, TestCase::QUICK); //Bug 991
+  AddTestCase (new InterferenceHelperNiChangesTest, TestCase::QUICK);
+  AddTestCase (new YansWifiChannelListsTest, TestCase::QUICK);
+  AddTestCase (new YansWifiPhyInterferenceDuringTxTest, TestCase::QUICK);
   AddTestCase (new Bug555TestCase, TestCase::QUICK); //Bug 555
   AddTestCase (new Bug730TestCase, TestCase::QUICK); //Bug 730
 }